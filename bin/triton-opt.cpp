@@ -15,6 +15,7 @@ namespace test {
 void registerTestAliasPass();
 void registerTestAlignmentPass();
 void registerTestAllocationPass();
+void registerTestBankConflictsPass();
 void registerTestMembarPass();
 } // namespace test
 } // namespace mlir
@@ -26,9 +27,11 @@ int main(int argc, char **argv) {
   mlir::test::registerTestAliasPass();
   mlir::test::registerTestAlignmentPass();
   mlir::test::registerTestAllocationPass();
+  mlir::test::registerTestBankConflictsPass();
   mlir::test::registerTestMembarPass();
   mlir::triton::registerConvertTritonToTritonGPUPass();
   mlir::triton::registerConvertTritonGPUToLLVMPass();
+  mlir::triton::registerConvertTritonGPUToCPUPass();
 
   // TODO: register Triton & TritonGPU passes
   mlir::DialectRegistry registry;
@@ -5,19 +5,29 @@
 #include "triton/Target/HSACO/HSACOTranslation.h"
 #include "mlir/IR/AsmState.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/InitAllPasses.h"
 #include "mlir/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassRegistry.h"
 #include "mlir/Support/FileUtilities.h"
 #include "mlir/Support/LogicalResult.h"
+#include "mlir/Support/Timing.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 #include "mlir/Target/LLVMIR/Export.h"
-#include "triton/Conversion/TritonGPUToLLVM/TritonGPUToLLVMPass.h"
-#include "triton/Conversion/TritonToTritonGPU/TritonToTritonGPUPass.h"
+#include "triton/Conversion/Passes.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include <atomic>
+#include <mutex>
 
 namespace mlir {
 namespace triton {
@@ -63,15 +73,147 @@ OwningOpRef<ModuleOp> loadMLIRModule(llvm::StringRef inputFilename,
   return module;
 }
 
+struct TranslateOptions {
+  std::string targetKind;
+  int SMArch;
+  int ptxVersion;
+  std::string GCNArch;
+  std::string passPipeline;
+};
+
+// The translations to PTX and HSACO set global LLVM options and initialize the
+// LLVM targets, so the files of a directory run them, and the translation to
+// LLVM IR before them, one at a time
+static std::mutex llvmTranslationMutex;
+
+// Translates the module of `inputFilename` into `outputFilename`, after
+// running the pass pipeline of the options on it
+LogicalResult translateFile(llvm::StringRef inputFilename,
+                            llvm::StringRef outputFilename,
+                            const TranslateOptions &options,
+                            TimingScope &timing) {
+  mlir::MLIRContext context;
+  // batches are parallel across files rather than within them
+  context.disableMultithreading();
+  OwningOpRef<ModuleOp> module;
+  {
+    TimingScope parseTimer = timing.nest("parse");
+    module = loadMLIRModule(inputFilename, context);
+  }
+  if (!module)
+    return failure();
+
+  if (!options.passPipeline.empty()) {
+    PassManager pm(&context);
+    applyPassManagerCLOptions(pm);
+    TimingScope pipelineTimer = timing.nest("pass pipeline");
+    pm.enableTiming(pipelineTimer);
+    if (failed(parsePassPipeline(options.passPipeline, pm, llvm::errs())) ||
+        failed(pm.run(*module))) {
+      llvm::errs() << inputFilename << ": pass pipeline failed\n";
+      return failure();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(llvmTranslationMutex);
+  llvm::LLVMContext llvmContext;
+  std::unique_ptr<llvm::Module> llvmir;
+  {
+    TimingScope llvmTimer = timing.nest("translate to LLVM IR");
+    llvmir = translateTritonGPUToLLVMIR(
+        &llvmContext, *module, options.SMArch, /*fastMath=*/false,
+        ::triton::getEmittedPTXVersion(options.ptxVersion));
+  }
+  if (!llvmir) {
+    llvm::errs() << inputFilename << ": translate to LLVM IR failed\n";
+    return failure();
+  }
+
+  std::string errorMessage;
+  auto output = openOutputFile(outputFilename, &errorMessage);
+  if (!output) {
+    llvm::errs() << errorMessage << "\n";
+    return failure();
+  }
+
+  if (options.targetKind == "llvmir") {
+    output->os() << *llvmir << '\n';
+  } else if (options.targetKind == "ptx") {
+    TimingScope ptxTimer = timing.nest("translate to PTX");
+    output->os() << ::triton::translateLLVMIRToPTX(*llvmir, options.SMArch,
+                                                   options.ptxVersion);
+  } else if (options.targetKind == "hsaco") {
+    TimingScope hsacoTimer = timing.nest("translate to HSACO");
+    auto [amdgcn, hsaco] =
+        ::triton::translateLLVMIRToHSACO(*llvmir, options.GCNArch);
+    output->os() << hsaco;
+  } else {
+    llvm::errs() << "Error: Unknown target specified: " << options.targetKind
+                 << "\n";
+    return failure();
+  }
+  output->keep();
+  return success();
+}
+
+// Translates the .ttgir and .mlir files of `inputDir` into `outputDir`
+// concurrently, each file with its own contexts. Only the parsing and the
+// pass pipeline run in parallel.
+LogicalResult translateDirectory(llvm::StringRef inputDir,
+                                 llvm::StringRef outputDir,
+                                 const TranslateOptions &options,
+                                 unsigned numThreads, TimingScope &timing) {
+  llvm::StringRef extension = options.targetKind == "ptx"     ? ".ptx"
+                              : options.targetKind == "hsaco" ? ".hsaco"
+                                                              : ".ll";
+  SmallVector<std::pair<std::string, std::string>> files;
+  std::error_code ec;
+  for (llvm::sys::fs::directory_iterator it(inputDir, ec), end;
+       it != end && !ec; it.increment(ec)) {
+    llvm::StringRef path = it->path();
+    llvm::StringRef ext = llvm::sys::path::extension(path);
+    if (ext != ".ttgir" && ext != ".mlir")
+      continue;
+    llvm::SmallString<128> output(outputDir);
+    llvm::sys::path::append(output, llvm::sys::path::stem(path) + extension);
+    files.emplace_back(path.str(), output.str().str());
+  }
+  if (ec) {
+    llvm::errs() << inputDir << ": " << ec.message() << "\n";
+    return failure();
+  }
+  if ((ec = llvm::sys::fs::create_directories(outputDir))) {
+    llvm::errs() << outputDir << ": " << ec.message() << "\n";
+    return failure();
+  }
+  llvm::sort(files);
+
+  std::atomic<unsigned> numFailed{0};
+  llvm::ThreadPool pool(llvm::hardware_concurrency(numThreads));
+  for (auto &file : files)
+    pool.async([&] {
+      if (failed(translateFile(file.first, file.second, options, timing)))
+        ++numFailed;
+    });
+  pool.wait();
+  if (numFailed) {
+    llvm::errs() << numFailed.load() << " of " << files.size()
+                 << " files failed to translate\n";
+    return failure();
+  }
+  return success();
+}
+
 LogicalResult tritonTranslateMain(int argc, char **argv,
                                   llvm::StringRef toolName) {
   static llvm::cl::opt<std::string> inputFilename(
-      llvm::cl::Positional, llvm::cl::desc("<input file>"),
+      llvm::cl::Positional,
+      llvm::cl::desc("<input file, or directory of files to translate>"),
       llvm::cl::init("-"));
 
   static llvm::cl::opt<std::string> outputFilename(
-      "o", llvm::cl::desc("Output filename"), llvm::cl::value_desc("filename"),
-      llvm::cl::init("-"));
+      "o", llvm::cl::desc("Output filename, or directory in batch mode"),
+      llvm::cl::value_desc("filename"), llvm::cl::init("-"));
 
   static llvm::cl::opt<std::string> targetKind(
       "target", llvm::cl::desc("<translation target, options: llvmir/ptx/hsaco>"),
@@ -87,47 +229,45 @@ LogicalResult tritonTranslateMain(int argc, char **argv,
       "gfx", llvm::cl::desc("AMDGCN target. e.g. '90a'"),
       llvm::cl::value_desc("architecture"), llvm::cl::init("90a"));
 
+  static llvm::cl::opt<std::string> passPipeline(
+      "pass-pipeline",
+      llvm::cl::desc("Textual pass pipeline run on the modules before their "
+                     "translation"),
+      llvm::cl::init(""));
+
+  static llvm::cl::opt<unsigned> numThreads(
+      "j",
+      llvm::cl::desc("Files translated concurrently in batch mode, all the "
+                     "hardware threads by default"),
+      llvm::cl::init(0));
+
   llvm::InitLLVM y(argc, argv);
 
+  mlir::registerAllPasses();
+  mlir::registerTritonPasses();
+  mlir::registerTritonGPUPasses();
+  mlir::triton::registerConvertTritonToTritonGPUPass();
+  mlir::triton::registerConvertTritonGPUToLLVMPass();
   registerAsmPrinterCLOptions();
   registerMLIRContextCLOptions();
+  registerPassManagerCLOptions();
+  registerDefaultTimingManagerCLOptions();
   llvm::cl::ParseCommandLineOptions(argc, argv, toolName);
 
-  mlir::MLIRContext context;
-  auto module = loadMLIRModule(inputFilename, context);
-  if (!module) {
-    return failure();
-  }
-
-  std::string errorMessage;
-  auto output = openOutputFile(outputFilename, &errorMessage);
-  if (!output) {
-    llvm::errs() << errorMessage << "\n";
-    return failure();
-  }
+  DefaultTimingManager tm;
+  applyDefaultTimingManagerCLOptions(tm);
+  TimingScope timing = tm.getRootScope();
 
-  llvm::LLVMContext llvmContext;
-  auto llvmir =
-      translateTritonGPUToLLVMIR(&llvmContext, *module, SMArch.getValue());
-  if (!llvmir) {
-    llvm::errs() << "Translate to LLVM IR failed";
+  TranslateOptions options{targetKind, SMArch, ptxVersion, GCNArch,
+                           passPipeline};
+  if (llvm::sys::fs::is_directory(inputFilename.getValue())) {
+    llvm::StringRef outputDir = outputFilename == "-"
+                                    ? llvm::StringRef(inputFilename)
+                                    : llvm::StringRef(outputFilename);
+    return translateDirectory(inputFilename, outputDir, options, numThreads,
+                              timing);
   }
-
-  if (targetKind == "llvmir")
-    llvm::outs() << *llvmir << '\n';
-  else if (targetKind == "ptx")
-    llvm::outs() << ::triton::translateLLVMIRToPTX(*llvmir, SMArch.getValue(),
-                                                   ptxVersion.getValue());
-  else if (targetKind == "hsaco") {
-    auto [module, hsaco] =
-        ::triton::translateLLVMIRToHSACO(*llvmir, GCNArch.getValue());
-    llvm::outs() << hsaco;
-  } else {
-    llvm::errs() << "Error: Unknown target specified: " << targetKind << "\n";
-    return failure();
-  }
-
-  return success();
+  return translateFile(inputFilename, outputFilename, options, timing);
 }
 
 } // namespace triton
@@ -16,6 +16,16 @@ namespace mlir {
 namespace triton {
 class AllocationAnalysis;
 
+// Distributed layout conversions whose whole tensor fits in a scratch buffer
+// of this size are done in a single round trip through shared memory
+constexpr unsigned kMaxSingleRepCvtScratchBytes = 16 * 1024;
+
+// Alignment, in bytes, of the buffers of tt.scratch ops
+constexpr unsigned kScratchBufferAlignment = 16;
+
+SmallVector<unsigned>
+getRepShapeForCvtLayout(triton::gpu::ConvertLayoutOp op);
+
 SmallVector<unsigned>
 getScratchConfigForCvtLayout(triton::gpu::ConvertLayoutOp op, unsigned &inVec,
                              unsigned &outVec);
@@ -59,7 +69,9 @@ public:
       std::numeric_limits<BufferId>::max();
 
   /// Creates a new Allocation analysis that computes the shared memory
-  /// information for all associated shared memory values.
+  /// information for all associated shared memory values. Passes may get it
+  /// from the analysis manager with getAnalysis<Allocation>() to share it
+  /// while the IR does not change.
   Allocation(Operation *operation) : operation(operation) { run(); }
 
   /// Returns the operation this analysis was constructed from.
@@ -109,9 +121,19 @@ public:
     }
   }
 
+  /// Returns the buffer ids of the tt.scratch ops the given pointer, or
+  /// tensor of pointers, to shared memory may point into. Pointers whose
+  /// origin is unknown, e.g. loop-carried ones, may point into any of them.
+  BufferIdSetT getScratchPointerBufferIds(Value ptr) const;
+
   /// Returns the size of total shared memory allocated
   size_t getSharedMemorySize() const { return sharedMemorySize; }
 
+  /// Returns the largest total size of the buffers that are live at the same
+  /// time. The difference with getSharedMemorySize() is lost to
+  /// fragmentation.
+  size_t getPeakLiveSize() const { return peakLiveSize; }
+
   bool isIntersected(BufferId lhsId, BufferId rhsId) const {
     if (lhsId == InvalidBufferId || rhsId == InvalidBufferId)
       return false;
@@ -132,6 +154,8 @@ private:
     BufferId id;
     size_t size;
     size_t offset;
+    /// The offset is a multiple of it
+    size_t alignment = 1;
 
     bool operator==(const BufferT &other) const { return id == other.id; }
     bool operator<(const BufferT &other) const { return id < other.id; }
@@ -184,6 +208,7 @@ private:
   AliasBufferMapT aliasBuffer;
   BufferSetT bufferSet;
   size_t sharedMemorySize = 0;
+  size_t peakLiveSize = 0;
 
   friend class triton::AllocationAnalysis;
 };
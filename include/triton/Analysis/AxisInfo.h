@@ -257,6 +257,23 @@ public:
   unsigned getPtrAlignment(Value ptr);
 
   unsigned getMaskAlignment(Value mask);
+
+  /// Whether all the elements of the tensor \param value are known to be
+  /// equal, e.g., for strides, offsets computed from the program id, and
+  /// splatted scalars. Such values are uniform across the CTA.
+  bool isUniform(Value value);
+};
+
+/// AxisInfoAnalysis of an operation, constructible by the analysis manager so
+/// that passes share it through getAnalysis<CachedAxisInfoAnalysis>() until
+/// the IR changes. Passes leaving the IR unchanged should preserve it with
+/// markAllAnalysesPreserved().
+class CachedAxisInfoAnalysis : public AxisInfoAnalysis {
+public:
+  explicit CachedAxisInfoAnalysis(Operation *op)
+      : AxisInfoAnalysis(op->getContext()) {
+    run(op);
+  }
 };
 
 } // namespace mlir
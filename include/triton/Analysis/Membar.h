@@ -26,6 +26,21 @@ public:
   /// a shared memory read. If the temporary storage is written but not read,
   /// it is considered as the problem of the operation itself but not the membar
   /// analysis.
+  /// Loads, stores and atomics through pointers to tt.scratch buffers are
+  /// shared memory reads, writes and atomics. Atomics only conflict with
+  /// reads and writes, not with each other.
+  /// If the only conflicts are with previous accesses to a warp-local scratch
+  /// buffer of the same operation, e.g. a ConvertLayoutOp in a loop, a warp
+  /// barrier is inserted instead of a CTA-wide barrier.
+  /// Barriers starting every region of an scf.if are merged into one barrier
+  /// before the scf.if.
+  /// The parts of the buffers shared by the CTAs of a thread block cluster
+  /// (clusterSize > 1) written by a CTA are read by its peers, through
+  /// cluster_gather: as all the CTAs run the same code, a CTA's own writes
+  /// and gathers stand for its peers'. Conflicts between them insert a
+  /// cluster barrier, which also syncs the CTA, and a cluster barrier is
+  /// inserted before returning while the peers may still read the shared
+  /// memory of the CTA.
   /// The following circumstances are not considered yet:
   /// - Double buffers
   /// - N buffers
@@ -41,6 +56,9 @@ private:
 
     BufferIdSetT syncReadBuffers;
     BufferIdSetT syncWriteBuffers;
+    BufferIdSetT syncAtomicBuffers;
+    BufferIdSetT clusterReadBuffers;
+    BufferIdSetT clusterWriteBuffers;
 
     RegionInfo() = default;
     RegionInfo(const BufferIdSetT &syncReadBuffers,
@@ -54,32 +72,72 @@ private:
                              other.syncReadBuffers.end());
       syncWriteBuffers.insert(other.syncWriteBuffers.begin(),
                               other.syncWriteBuffers.end());
+      syncAtomicBuffers.insert(other.syncAtomicBuffers.begin(),
+                               other.syncAtomicBuffers.end());
+      clusterReadBuffers.insert(other.clusterReadBuffers.begin(),
+                                other.clusterReadBuffers.end());
+      clusterWriteBuffers.insert(other.clusterWriteBuffers.begin(),
+                                 other.clusterWriteBuffers.end());
     }
 
     /// Returns true if buffers in two RegionInfo objects are intersected.
-    bool isIntersected(const RegionInfo &other, Allocation *allocation) const {
+    /// A buffer in warpLocalBuffers is not considered intersected with itself.
+    bool isIntersected(const RegionInfo &other, Allocation *allocation,
+                       const BufferIdSetT &warpLocalBuffers = {}) const {
       return /*RAW*/ isIntersected(syncWriteBuffers, other.syncReadBuffers,
-                                   allocation) ||
+                                   allocation, warpLocalBuffers) ||
              /*WAR*/
-             isIntersected(syncReadBuffers, other.syncWriteBuffers,
-                           allocation) ||
+             isIntersected(syncReadBuffers, other.syncWriteBuffers, allocation,
+                           warpLocalBuffers) ||
              /*WAW*/
              isIntersected(syncWriteBuffers, other.syncWriteBuffers,
-                           allocation);
+                           allocation, warpLocalBuffers) ||
+             /*atomics after reads or writes*/
+             isIntersected(syncReadBuffers, other.syncAtomicBuffers,
+                           allocation, warpLocalBuffers) ||
+             isIntersected(syncWriteBuffers, other.syncAtomicBuffers,
+                           allocation, warpLocalBuffers) ||
+             /*reads or writes after atomics*/
+             isIntersected(syncAtomicBuffers, other.syncReadBuffers,
+                           allocation, warpLocalBuffers) ||
+             isIntersected(syncAtomicBuffers, other.syncWriteBuffers,
+                           allocation, warpLocalBuffers);
+    }
+
+    /// Returns true if the accesses of the cluster in two RegionInfo objects
+    /// conflict.
+    bool isClusterIntersected(const RegionInfo &other,
+                              Allocation *allocation) const {
+      return /*RAW*/ isIntersected(clusterWriteBuffers,
+                                   other.clusterReadBuffers, allocation, {}) ||
+             /*WAR*/
+             isIntersected(clusterReadBuffers, other.clusterWriteBuffers,
+                           allocation, {});
     }
 
     /// Clears the buffers because a barrier is inserted.
     void sync() {
       syncReadBuffers.clear();
       syncWriteBuffers.clear();
+      syncAtomicBuffers.clear();
+    }
+
+    /// Clears the buffers because a cluster barrier is inserted.
+    void syncCluster() {
+      sync();
+      clusterReadBuffers.clear();
+      clusterWriteBuffers.clear();
     }
 
   private:
     /// Returns true if buffers in two sets are intersected.
     bool isIntersected(const BufferIdSetT &lhs, const BufferIdSetT &rhs,
-                       Allocation *allocation) const {
+                       Allocation *allocation,
+                       const BufferIdSetT &warpLocalBuffers) const {
       return std::any_of(lhs.begin(), lhs.end(), [&](auto lhsId) {
         return std::any_of(rhs.begin(), rhs.end(), [&](auto rhsId) {
+          if (lhsId == rhsId && warpLocalBuffers.count(lhsId))
+            return false;
           return allocation->isIntersected(lhsId, rhsId);
         });
       });
@@ -110,6 +168,10 @@ private:
   void transfer(Operation *operation, RegionInfo *blockInfo,
                 OpBuilder *builder);
 
+  /// Merges the barriers at the beginning of both regions of an scf.if into a
+  /// single barrier before it, and removes redundant back-to-back barriers.
+  void mergeBarriers(Operation *operation);
+
 private:
   Allocation *allocation;
 };
@@ -2,6 +2,7 @@
 #define TRITON_ANALYSIS_UTILITY_H
 
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "llvm/ADT/BitVector.h"
 #include <algorithm>
 #include <numeric>
 #include <string>
@@ -10,31 +11,95 @@ namespace mlir {
 
 class ReduceOpHelper {
 public:
-  explicit ReduceOpHelper(triton::ReduceOp op) : op(op) {
-    srcTy = op.operand().getType().cast<RankedTensorType>();
-  }
+  explicit ReduceOpHelper(triton::ReduceOp op);
+
+  // All operands of a generic reduction share their shape and layout, so the
+  // first one drives the thread bookkeeping
+  explicit ReduceOpHelper(triton::GenericReduceOp op);
+
+  // Scans go through the same steps along their axis, without dropping it
+  explicit ReduceOpHelper(triton::ScanOp op);
+
+  // Sorts exchange the elements along their axis with the same partners as
+  // butterfly reductions, and may keep only the first ones of it
+  explicit ReduceOpHelper(triton::SortOp op);
 
   ArrayRef<int64_t> getSrcShape() { return srcTy.getShape(); }
 
   Attribute getSrcLayout() { return srcTy.getEncoding(); }
 
-  bool isFastReduction();
+  // Reductions are done first within threads, then across the lanes of a
+  // warp with butterfly shuffles, and finally across the warps holding
+  // different rows of the reduction axis through shared memory. Sliced
+  // layouts are handled through their (non-sliced) parent.
+  bool isSupportedLayout();
 
-  unsigned getInterWarpSize();
+  // The non-sliced layout that assigns the elements to threads, with the
+  // shape and reduction axis of the source tensor in it
+  Attribute getThreadLayout();
+
+  SmallVector<int64_t> getThreadShape();
+
+  unsigned getThreadAxis();
+
+  // Number of lanes of a warp, 64 for the wavefronts of MFMA layouts
+  unsigned getWarpSize();
+
+  // Lanes (resp. warps) of the thread layout along each dimension, with the
+  // order lane (resp. warp) ids are split in
+  SmallVector<unsigned> getThreadsPerWarp();
+
+  SmallVector<unsigned> getLaneOrder();
+
+  SmallVector<unsigned> getWarpsPerCTA();
+
+  SmallVector<unsigned> getWarpOrder();
 
+  // Distance, in lane ids, between two lanes holding consecutive rows of the
+  // reduction axis
+  unsigned getIntraWarpStride();
+
+  // Number of lanes (resp. warps) holding different rows of the reduction
+  // axis
   unsigned getIntraWarpSize();
 
-  unsigned getThreadsReductionAxis();
+  unsigned getInterWarpSize();
 
-  SmallVector<unsigned> getScratchConfigBasic();
+  // Shape of the buffer in which every warp stores its partial result, empty
+  // if a single warp covers the reduction axis
+  SmallVector<unsigned> getScratchConfig();
 
-  SmallVector<SmallVector<unsigned>> getScratchConfigsFast();
+  // Sizes of the elements of the values (e.g. the value and its index for
+  // arg-reductions) exchanged between warps, one region of the buffer each
+  ArrayRef<unsigned> getScratchElementBytes() { return scratchElementBytes; }
 
   unsigned getScratchSizeInBytes();
 
+  // Number of times the layout is repeated along the axis in a thread
+  unsigned getAxisRepetitions();
+
+  // Scans store the total of every warp for every repetition along the axis,
+  // empty if a single warp covers it
+  SmallVector<unsigned> getScanScratchConfig();
+
+  unsigned getScanScratchSizeInBytes();
+
+  // Sorts store the whole tensor when their network crosses warps, or when a
+  // top-k gathers the first elements of the axis into the layout of its
+  // result, empty otherwise
+  SmallVector<unsigned> getSortScratchConfig();
+
+  unsigned getSortScratchSizeInBytes();
+
 private:
-  triton::ReduceOp op;
+  SmallVector<unsigned> getShapePerWarp();
+
+  unsigned getScratchSizeInBytes(ArrayRef<unsigned> smemShape);
+
   RankedTensorType srcTy{};
+  unsigned axis;
+  SmallVector<unsigned> scratchElementBytes;
+  bool isTopK = false;
 };
 
 bool isSharedEncoding(Value value);
@@ -47,6 +112,14 @@ bool supportMMA(triton::DotOp op, int version);
 
 bool supportMMA(Value value, int version);
 
+// Tell whether a SparseDotOp can be lowered to mma.sp.m16n8k32: f16 or bf16
+// operands, an f32 accumulator, and k32 steps along k.
+bool supportSparseMMA(triton::SparseDotOp op);
+
+// Tell whether a DotOp can be lowered to the 32x32 MFMA instructions of AMD
+// CDNA GPUs.
+bool supportMFMA(triton::DotOp op);
+
 Type getElementType(Value value);
 
 std::string getValueOperandName(Value value, AsmState &state);
@@ -89,6 +162,103 @@ bool isSingleValue(Value value);
 bool isMmaToDotShortcut(triton::gpu::MmaEncodingAttr &mmaLayout,
                         triton::gpu::DotOperandEncodingAttr &dotOperandLayout);
 
+// Tell whether every warp of a ConvertLayoutOp reads back from the scratch
+// buffer only the elements it wrote itself, so that a warp-level barrier is
+// enough to order its shared memory accesses.
+bool isWarpLocal(triton::gpu::ConvertLayoutOp op);
+
+// Returns, for each element of the result of a ConvertLayoutOp, the element
+// of the source that holds it in the threads of the same warp, if it is the
+// same one in all the threads. The conversion is then a warp shuffle per
+// element. Returns an empty vector otherwise. Only blocked layouts of
+// power-of-two sizes are considered, whose ids select bits of the element
+// coordinates, so the check doesn't depend on the number of elements.
+SmallVector<unsigned>
+getWarpShuffleSrcElems(triton::gpu::ConvertLayoutOp op);
+
+SmallVector<unsigned> getWarpShuffleSrcElems(RankedTensorType srcTy,
+                                             RankedTensorType dstTy);
+
+bool isWarpShuffleCvt(triton::gpu::ConvertLayoutOp op);
+
+// Estimated ways of the bank conflicts of the accesses of a warp to a tensor
+// in shared memory (`sharedTy`), holding its elements in `layout`: the
+// largest number of distinct 4-byte words a bank of the `numBanks` banks
+// serves in one request, 1 being conflict-free. Only the first access of
+// every lane is modelled. Returns 0 for layouts that are not modelled: only
+// blocked layouts and the operands of mfma layouts are.
+unsigned getBankConflictWays(RankedTensorType sharedTy, Attribute layout,
+                             unsigned numBanks);
+
+// Words of 32 bits taken by a value of type `type` in a trace record: two,
+// low word first, for the values wider than 32 bits and the pointers
+unsigned getTraceValueWords(Type type);
+
+// Words of 32 bits of the records of `op`, in the ring buffer of the trace:
+// the format id + 1, the program id and the thread id, then the value of each
+// scalar argument and, for each tensor argument, the linear index and the
+// value of every element of the thread
+unsigned getTraceRecordWords(triton::TraceOp op);
+
+// Indices of the arguments of its function that the pointer (or tensor of
+// pointers) `ptr` may be derived from, through side-effect free ops and the
+// values carried by scf.for and scf.if ops. None if it may be derived from
+// anything else, e.g. from an integer or from a pointer loaded from memory.
+Optional<SmallVector<unsigned>> getPointerRoots(Value ptr);
+
+// Whether `op` may write to the memory its pointer operands point to, or let
+// them escape into values that are not pointers, e.g. by tt.ptr_to_int. The
+// ops nested in its regions are not considered.
+bool mayWriteThroughPointers(Operation *op);
+
+// Whether `value` is a pointer (or tensor of pointers) to global memory
+bool isGlobalPointer(Value value);
+
+// The pointer arguments of `funcOp` which are never written through: no op
+// that may write to memory is given a global pointer derived from them, and
+// no such pointer escapes into a non-pointer value.
+llvm::BitVector getReadOnlyArguments(FuncOp funcOp);
+
+// Which values of `funcOp` are the same in all the CTAs of its thread block
+// clusters, of numCTAs CTAs consecutive along the x axis of the grid: the
+// program ids along x of a cluster are numCTAs * q + r, r being the rank of
+// the CTA in the cluster, and e.g. their quotient by a multiple of numCTAs is
+// uniform. The loads of uniform pointers are assumed to read the same values.
+class ClusterUniformity {
+public:
+  ClusterUniformity(FuncOp funcOp, unsigned numCTAs);
+
+  bool isUniform(Value value) const { return getKind(value) == Uniform; }
+
+  // Whether all the CTAs of a cluster run `op` as many times, i.e. the
+  // conditions and bounds of its enclosing scf ops are uniform
+  bool isUniformControlFlow(Operation *op) const;
+
+private:
+  // Unknown until the fixpoint is reached; Strided values are numCTAs * q + r
+  // for a uniform q
+  enum Kind { Unknown, Uniform, Strided, Varying };
+
+  Kind getKind(Value value) const { return kinds.lookup(value); }
+
+  // Uniform if all the values are, Unknown if some aren't known yet
+  Kind getAllUniform(ValueRange values) const;
+
+  // Whether `value` is a multiple of numCTAs, as per its constants and the
+  // tt.divisibility of the arguments of the function
+  bool isMultipleOfNumCTAs(Value value) const;
+
+  // Joins `kind` into the kind of `value`, returns true on change
+  bool update(Value value, Kind kind);
+
+  bool visit(Operation *op);
+
+  Kind visitArithOp(Operation *op) const;
+
+  DenseMap<Value, Kind> kinds;
+  unsigned numCTAs;
+};
+
 /// Multi-root DAG topological sort.
 /// Performs a topological sort of the Operation in the `toSort` SetVector.
 /// Returns a topologically sorted SetVector.
@@ -0,0 +1,19 @@
+#ifndef TRITON_CONVERSION_TRITONGPU_TO_CPU_PASS_H
+#define TRITON_CONVERSION_TRITONGPU_TO_CPU_PASS_H
+
+#include <memory>
+
+namespace mlir {
+
+class ModuleOp;
+template <typename T> class OperationPass;
+
+namespace triton {
+
+std::unique_ptr<OperationPass<ModuleOp>> createConvertTritonGPUToCPUPass();
+
+} // namespace triton
+
+} // namespace mlir
+
+#endif
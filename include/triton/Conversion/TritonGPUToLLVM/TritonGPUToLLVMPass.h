@@ -13,7 +13,8 @@ template <typename T> class OperationPass;
 namespace triton {
 
 std::unique_ptr<OperationPass<ModuleOp>>
-createConvertTritonGPUToLLVMPass(int computeCapability = 80);
+createConvertTritonGPUToLLVMPass(int computeCapability = 80,
+                                 bool fastMath = false, int ptxVersion = 80);
 
 } // namespace triton
 
@@ -11,13 +11,24 @@ template <typename T> class OperationPass;
 namespace triton {
 
 constexpr static char AttrNumWarpsName[] = "triton_gpu.num-warps";
+constexpr static char AttrThreadsPerWarpName[] = "triton_gpu.threads-per-warp";
+constexpr static char AttrSharedBanksName[] = "triton_gpu.shared-banks";
+constexpr static char AttrMinBlocksPerSMName[] = "triton_gpu.min-blocks-per-sm";
+constexpr static char AttrMaxRegistersName[] = "triton_gpu.max-registers";
+constexpr static char AttrWavesPerEUName[] = "triton_gpu.waves-per-eu";
+constexpr static char AttrNumCTAsName[] = "triton_gpu.num-ctas";
 
 // Create the pass with numWarps passed from cl::opt.
 std::unique_ptr<OperationPass<ModuleOp>> createConvertTritonToTritonGPUPass();
 
-// Create the pass with numWarps set explicitly.
+// Create the pass with numWarps, threadsPerWarp, sharedBanks, the launch
+// bounds of the kernel (unset if 0) and the number of CTAs of its thread
+// block clusters set explicitly.
 std::unique_ptr<OperationPass<ModuleOp>>
-createConvertTritonToTritonGPUPass(int numWarps);
+createConvertTritonToTritonGPUPass(int numWarps, int threadsPerWarp = 32,
+                                   int sharedBanks = 32, int minBlocksPerSM = 0,
+                                   int maxRegisters = 0, int wavesPerEU = 0,
+                                   int numCTAs = 1);
 
 } // namespace triton
 } // namespace mlir
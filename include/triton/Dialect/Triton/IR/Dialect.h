@@ -38,6 +38,16 @@ public:
                             Attribute &resultEncoding,
                             Optional<Location> location) const = 0;
 
+  // The encoding of the result of tt.join, with a new trailing dimension
+  virtual LogicalResult
+  inferJoinOpEncoding(Attribute operandEncoding, Attribute &resultEncoding,
+                      Optional<Location> location) const = 0;
+
+  // The encoding of the results of tt.split, without the trailing dimension
+  virtual LogicalResult
+  inferSplitOpEncoding(Attribute operandEncoding, Attribute &resultEncoding,
+                       Optional<Location> location) const = 0;
+
   // Note: this function only verify operand encoding but doesn't infer result
   // encoding
   virtual LogicalResult
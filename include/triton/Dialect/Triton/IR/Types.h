@@ -7,4 +7,16 @@
 #define GET_TYPEDEF_CLASSES
 #include "triton/Dialect/Triton/IR/Types.h.inc"
 
+namespace mlir {
+namespace triton {
+
+// Whether \param type is one of the 8-bit floating-point types, which are all
+// stored as i8
+inline bool isFloat8(Type type) {
+  return type.isa<Float8Type, Float8E4M3Type, Float8E5M2Type>();
+}
+
+} // namespace triton
+} // namespace mlir
+
 #endif // TRITON_IR_TYPES_H_
@@ -8,6 +8,19 @@ namespace triton {
 
 std::unique_ptr<Pass> createCombineOpsPass();
 
+std::unique_ptr<Pass> createRewriteTensorPointerPass();
+
+std::unique_ptr<Pass> createCanonicalizePointersPass();
+
+std::unique_ptr<Pass> createCanonicalizePointersPass(bool int32Indexing);
+
+std::unique_ptr<Pass> createVersionAlignmentPass();
+
+std::unique_ptr<Pass> createRemapProgramIdsPass();
+
+std::unique_ptr<Pass> createRemapProgramIdsPass(StringRef order,
+                                                int groupSize);
+
 } // namespace triton
 
 #define GEN_PASS_REGISTRATION
@@ -41,6 +41,10 @@ getShapePerCTA(const Attribute &layout,
 
 SmallVector<unsigned> getOrder(const Attribute &layout);
 
+// Number of elements of an access of `inVec` contiguous elements that stay
+// contiguous in the swizzled shared memory `layout`
+unsigned getSharedAccessVec(SharedEncodingAttr layout, unsigned inVec);
+
 bool isaDistributedLayout(const Attribute &layout);
 
 } // namespace gpu
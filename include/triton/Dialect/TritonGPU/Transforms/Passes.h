@@ -6,18 +6,30 @@
 namespace mlir {
 std::unique_ptr<Pass> createTritonGPUPipelinePass(int numStages = 2);
 
+std::unique_ptr<Pass> createTritonGPUPeelLoopsPass();
+
+std::unique_ptr<Pass> createTritonGPULoopUnrollPass();
+
+std::unique_ptr<Pass> createTritonGPUHoistInvariantLoadsPass();
+
+std::unique_ptr<Pass> createTritonGPUWarpSpecializePass();
+
 // TODO(Keren): prefetch pass not working yet
-std::unique_ptr<Pass> createTritonGPUPrefetchPass();
+std::unique_ptr<Pass> createTritonGPUPrefetchPass(int prefetchWidth = 0);
 
 std::unique_ptr<Pass> createTritonGPUCanonicalizeLoopsPass();
 
-std::unique_ptr<Pass> createTritonGPUCoalescePass();
+std::unique_ptr<Pass>
+createTritonGPUCoalescePass(bool reportSectorEfficiency = false);
 
 std::unique_ptr<Pass> createTritonGPUReorderInstructionsPass();
 
+std::unique_ptr<Pass> createTritonGPUListSchedulePass(int registerBudget = 255);
+
 std::unique_ptr<Pass> createTritonGPUDecomposeConversionsPass();
 
-std::unique_ptr<Pass> createTritonGPUCombineOpsPass(int computeCapability = 80);
+std::unique_ptr<Pass> createTritonGPUCombineOpsPass(int computeCapability = 80,
+                                                    double rematWeight = 1.0);
 
 std::unique_ptr<Pass> createTritonGPUVerifier();
 
@@ -0,0 +1,31 @@
+#ifndef TRITON_TARGET_CPUTRANSLATION_H
+#define TRITON_TARGET_CPUTRANSLATION_H
+
+#include <memory>
+#include <string>
+
+namespace llvm {
+class Module;
+class LLVMContext;
+} // namespace llvm
+
+namespace mlir {
+class ModuleOp;
+} // namespace mlir
+
+namespace triton {
+
+// Translate TritonGPU IR to LLVM IR for the host, return null if failed.
+std::unique_ptr<llvm::Module>
+translateTritonGPUToCPULLVMIR(llvm::LLVMContext *llvmContext,
+                              mlir::ModuleOp module);
+
+// Translate LLVM IR to an object file for the CPU of the host.
+std::string translateLLVMIRToCPUObject(llvm::Module &module);
+
+// The name of the CPU of the host, as known to LLVM.
+std::string getHostCPUName();
+
+} // namespace triton
+
+#endif
@@ -11,7 +11,8 @@ class Module;
 
 namespace triton {
 
-// Translate TritonGPU IR to HSACO code.
+// Translate TritonGPU IR to AMDGCN assembly and an HSACO code object. The
+// code object is empty if it could not be linked.
 std::tuple<std::string, std::string> translateLLVMIRToHSACO(llvm::Module& module,
                                                             std::string cc);
 
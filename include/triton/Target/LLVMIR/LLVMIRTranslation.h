@@ -22,10 +22,12 @@ void addExternalLibs(mlir::ModuleOp &module,
                      const std::vector<std::string> &names,
                      const std::vector<std::string> &paths);
 
-// Translate TritonGPU dialect to LLVMIR, return null if failed.
+// Translate TritonGPU dialect to LLVMIR, return null if failed. ptxVersion is
+// the PTX ISA version the LLVMIR is then translated to.
 std::unique_ptr<llvm::Module>
 translateTritonGPUToLLVMIR(llvm::LLVMContext *llvmContext,
-                           mlir::ModuleOp module, int computeCapability);
+                           mlir::ModuleOp module, int computeCapability,
+                           bool fastMath = false, int ptxVersion = 80);
 
 // Translate mlir LLVM dialect to LLVMIR, return null if failed.
 std::unique_ptr<llvm::Module>
@@ -12,6 +12,10 @@ namespace triton {
 // Translate TritonGPU IR to PTX code.
 std::string translateLLVMIRToPTX(llvm::Module &module, int cc, int version);
 
+// The PTX ISA version translateLLVMIRToPTX emits when asked for \p version:
+// it is capped by what the LLVM in use supports.
+int getEmittedPTXVersion(int version);
+
 } // namespace triton
 
 #endif
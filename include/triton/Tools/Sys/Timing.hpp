@@ -0,0 +1,119 @@
+#ifndef TRITON_TOOLS_SYS_TIMING_HPP
+#define TRITON_TOOLS_SYS_TIMING_HPP
+
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassInstrumentation.h"
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace triton {
+
+namespace tools {
+
+// Wall time of the phases of the compilations of this process, e.g. MLIR
+// passes, LLVM optimization or external tools, recorded while enabled.
+// Phases are named "<kind>/<name>".
+class CompileTimer {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Records = std::vector<std::pair<std::string, double>>;
+
+  static CompileTimer &get() {
+    static CompileTimer timer;
+    return timer;
+  }
+
+  void enable() {
+    std::lock_guard<std::mutex> lock(mutex);
+    enabled = true;
+    records.clear();
+  }
+
+  Records disable() {
+    std::lock_guard<std::mutex> lock(mutex);
+    enabled = false;
+    return std::move(records);
+  }
+
+  bool isEnabled() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return enabled;
+  }
+
+  void record(const std::string &phase, double seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (enabled)
+      records.emplace_back(phase, seconds);
+  }
+
+  // Records the lifetime of the scope as a phase
+  class Scope {
+    std::string phase;
+    Clock::time_point start;
+
+  public:
+    explicit Scope(std::string phase)
+        : phase(std::move(phase)), start(Clock::now()) {}
+    ~Scope() {
+      std::chrono::duration<double> elapsed = Clock::now() - start;
+      CompileTimer::get().record(phase, elapsed.count());
+    }
+  };
+
+private:
+  std::mutex mutex;
+  bool enabled = false;
+  Records records;
+};
+
+// Records the run time of each pass of a pass manager as a "pass/<name>"
+// phase. Passes nested in an op-agnostic adaptor may run concurrently.
+class PassTimingInstrumentation : public mlir::PassInstrumentation {
+public:
+  void runBeforePass(mlir::Pass *pass, mlir::Operation *op) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    starts[{pass, op}] = CompileTimer::Clock::now();
+  }
+
+  void runAfterPass(mlir::Pass *pass, mlir::Operation *op) override {
+    finish(pass, op);
+  }
+
+  void runAfterPassFailed(mlir::Pass *pass, mlir::Operation *op) override {
+    finish(pass, op);
+  }
+
+private:
+  void finish(mlir::Pass *pass, mlir::Operation *op) {
+    std::chrono::duration<double> elapsed;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = starts.find({pass, op});
+      if (it == starts.end())
+        return;
+      elapsed = CompileTimer::Clock::now() - it->second;
+      starts.erase(it);
+    }
+    // Adaptors running nested pass managers have no argument, and their time
+    // is already accounted for by the nested passes
+    if (!pass->getArgument().empty())
+      CompileTimer::get().record("pass/" + pass->getName().str(),
+                                 elapsed.count());
+  }
+
+  std::mutex mutex;
+  std::map<std::pair<mlir::Pass *, mlir::Operation *>,
+           CompileTimer::Clock::time_point>
+      starts;
+};
+
+} // namespace tools
+
+} // namespace triton
+
+#endif
@@ -26,9 +26,11 @@ ChangeResult SharedMemoryAliasAnalysis::visitOperation(
     // These ops may allocate a new shared memory buffer.
     auto result = op->getResult(0);
     // XXX(Keren): the following ops are always aliasing for now
-    if (isa<tensor::ExtractSliceOp, triton::TransOp>(op)) {
+    if (isa<tensor::ExtractSliceOp, triton::TransOp,
+            triton::gpu::ClusterGatherOp>(op)) {
       // extract_slice %src
       // trans %src
+      // cluster_gather %src, %index
       aliasInfo = AliasInfo(operands[0]->getValue());
       pessimistic = false;
     } else if (isa<tensor::InsertSliceOp, triton::gpu::InsertSliceAsyncOp>(
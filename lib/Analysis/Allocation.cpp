@@ -1,15 +1,19 @@
 #include "triton/Analysis/Allocation.h"
 #include "mlir/Analysis/Liveness.h"
 #include "mlir/Analysis/SliceAnalysis.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/TypeUtilities.h"
 #include "triton/Analysis/Alias.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
 
 #include <algorithm>
 #include <limits>
 #include <numeric>
+#include <optional>
 
 using ::mlir::triton::gpu::BlockedEncodingAttr;
 using ::mlir::triton::gpu::DotOperandEncodingAttr;
@@ -17,6 +21,7 @@ using ::mlir::triton::gpu::getContigPerThread;
 using ::mlir::triton::gpu::getOrder;
 using ::mlir::triton::gpu::getShapePerCTA;
 using ::mlir::triton::gpu::getSizePerThread;
+using ::mlir::triton::gpu::MfmaEncodingAttr;
 using ::mlir::triton::gpu::MmaEncodingAttr;
 using ::mlir::triton::gpu::SharedEncodingAttr;
 using ::mlir::triton::gpu::SliceEncodingAttr;
@@ -34,15 +39,17 @@ constexpr int kPtrBitWidth = 64;
 static std::pair<SmallVector<unsigned>, SmallVector<unsigned>>
 getCvtOrder(const Attribute &srcLayout, const Attribute &dstLayout) {
   auto srcBlockedLayout = srcLayout.dyn_cast<BlockedEncodingAttr>();
-  auto srcMmaLayout = srcLayout.dyn_cast<MmaEncodingAttr>();
+  bool srcMmaLayout = srcLayout.isa<MmaEncodingAttr>() ||
+                      srcLayout.isa<MfmaEncodingAttr>();
   auto srcDotLayout = srcLayout.dyn_cast<DotOperandEncodingAttr>();
   auto dstBlockedLayout = dstLayout.dyn_cast<BlockedEncodingAttr>();
-  auto dstMmaLayout = dstLayout.dyn_cast<MmaEncodingAttr>();
+  bool dstMmaLayout = dstLayout.isa<MmaEncodingAttr>() ||
+                      dstLayout.isa<MfmaEncodingAttr>();
   auto dstDotLayout = dstLayout.dyn_cast<DotOperandEncodingAttr>();
   assert(!(srcMmaLayout && dstMmaLayout) &&
          "Unexpected mma -> mma layout conversion");
-  // mma or dot layout does not have an order, so the order depends on the
-  // layout of the other operand.
+  // mma/mfma or dot layout does not have an order, so the order depends on
+  // the layout of the other operand.
   auto inOrd = (srcMmaLayout || srcDotLayout) ? getOrder(dstLayout)
                                               : getOrder(srcLayout);
   auto outOrd = (dstMmaLayout || dstDotLayout) ? getOrder(srcLayout)
@@ -51,6 +58,75 @@ getCvtOrder(const Attribute &srcLayout, const Attribute &dstLayout) {
   return {inOrd, outOrd};
 }
 
+// Whether some dot reads $b from shared memory through wgmma
+static bool hasWGMMA(Operation *operation) {
+  auto result = operation->walk([](triton::DotOp dotOp) {
+    auto mmaLayout = dotOp.getType()
+                         .cast<RankedTensorType>()
+                         .getEncoding()
+                         .dyn_cast<MmaEncodingAttr>();
+    if (mmaLayout && mmaLayout.isHopper())
+      return WalkResult::interrupt();
+    return WalkResult::advance();
+  });
+  return result.wasInterrupted();
+}
+
+// wgmma applies the swizzling to the shared memory addresses, which matches
+// the swizzling of the layout only if the buffer starts on a multiple of its
+// period: perPhase * maxPhase rows, at most 1024 bytes
+static size_t getSwizzleAlignment(RankedTensorType type) {
+  auto layout = type.getEncoding().cast<SharedEncodingAttr>();
+  if (layout.getMaxPhase() == 1)
+    return 1;
+  size_t rowBytes = type.getShape()[layout.getOrder()[0]] *
+                    type.getElementTypeBitWidth() / 8;
+  size_t period = layout.getPerPhase() * layout.getMaxPhase() * rowBytes;
+  return std::min<size_t>(llvm::PowerOf2Ceil(period), 1024);
+}
+
+static bool isMmaV1Layout(Attribute layout) {
+  if (auto sliceLayout = layout.dyn_cast<SliceEncodingAttr>())
+    layout = sliceLayout.getParent();
+  auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>();
+  return mmaLayout && mmaLayout.isVolta();
+}
+
+SmallVector<unsigned>
+getRepShapeForCvtLayout(triton::gpu::ConvertLayoutOp op) {
+  auto srcTy = op.src().getType().cast<RankedTensorType>();
+  auto dstTy = op.result().getType().cast<RankedTensorType>();
+  Attribute srcLayout = srcTy.getEncoding();
+  Attribute dstLayout = dstTy.getEncoding();
+  auto srcShapePerCTA = getShapePerCTA(srcLayout, srcTy.getShape());
+  auto dstShapePerCTA = getShapePerCTA(dstLayout, dstTy.getShape());
+
+  unsigned rank = dstTy.getRank();
+  SmallVector<unsigned> repShape(rank);
+  for (unsigned d = 0; d < rank; ++d) {
+    repShape[d] =
+        std::max(std::min<unsigned>(srcTy.getShape()[d], srcShapePerCTA[d]),
+                 std::min<unsigned>(dstTy.getShape()[d], dstShapePerCTA[d]));
+  }
+
+  // Replicas are converted one after the other with a barrier in between,
+  // unless the whole tensor fits in the scratch buffer. MMAv1 conversions
+  // always go one CTA tile at a time.
+  if (!triton::gpu::isaDistributedLayout(srcLayout) ||
+      !triton::gpu::isaDistributedLayout(dstLayout) ||
+      isMmaV1Layout(srcLayout) || isMmaV1Layout(dstLayout))
+    return repShape;
+  unsigned elemBytes =
+      srcTy.getElementType().isa<triton::PointerType>()
+          ? kPtrBitWidth / 8
+          : std::max<int>(8, srcTy.getElementTypeBitWidth()) / 8;
+  unsigned bytes = elemBytes * product<int64_t>(dstTy.getShape());
+  if (bytes <= kMaxSingleRepCvtScratchBytes)
+    for (unsigned d = 0; d < rank; ++d)
+      repShape[d] = dstTy.getShape()[d];
+  return repShape;
+}
+
 SmallVector<unsigned>
 getScratchConfigForCvtLayout(triton::gpu::ConvertLayoutOp op, unsigned &inVec,
                              unsigned &outVec) {
@@ -75,19 +151,9 @@ getScratchConfigForCvtLayout(triton::gpu::ConvertLayoutOp op, unsigned &inVec,
   inVec = outOrd[0] == 0 ? 1 : inOrd[0] == 0 ? 1 : srcContigPerThread;
   outVec = outOrd[0] == 0 ? 1 : dstContigPerThread;
 
-  auto srcShape = srcTy.getShape();
-  auto dstShape = dstTy.getShape();
-  auto srcShapePerCTA = getShapePerCTA(srcLayout, srcShape);
-  auto dstShapePerCTA = getShapePerCTA(dstLayout, dstShape);
-
   unsigned rank = dstTy.getRank();
-  SmallVector<unsigned> paddedRepShape(rank);
+  SmallVector<unsigned> paddedRepShape = getRepShapeForCvtLayout(op);
   unsigned pad = std::max(inVec, outVec);
-  for (unsigned d = 0; d < rank; ++d) {
-    paddedRepShape[d] =
-        std::max(std::min<unsigned>(srcTy.getShape()[d], srcShapePerCTA[d]),
-                 std::min<unsigned>(dstTy.getShape()[d], dstShapePerCTA[d]));
-  }
   if (rank == 1)
     return paddedRepShape;
   unsigned paddedDim = 1;
@@ -133,6 +199,7 @@ private:
   using GraphT = DenseMap<BufferT *, DenseSet<BufferT *>>;
 
   void run() {
+    alignSwizzledBuffers = hasWGMMA(operation);
     getValuesAndSizes();
     resolveLiveness();
     computeOffsets();
@@ -157,15 +224,49 @@ private:
         auto bytes = tensorType.getNumElements() *
                      tensorType.getElementTypeBitWidth() / 8;
         allocation->addBuffer<BufferT::BufferKind::Explicit>(result, bytes);
+        if (alignSwizzledBuffers)
+          allocation->valueBuffer[result]->alignment =
+              getSwizzleAlignment(tensorType);
       }
     }
   }
 
   /// Initializes temporary shared memory for a given operation.
   void getScratchValueSize(Operation *op) {
-    if (auto reduceOp = dyn_cast<triton::ReduceOp>(op)) {
+    if (auto scratchOp = dyn_cast<triton::ScratchOp>(op)) {
+      auto elemTy =
+          scratchOp.getType().cast<triton::PointerType>().getPointeeType();
+      unsigned elemBytes =
+          elemTy.isa<triton::PointerType>()
+              ? kPtrBitWidth / 8
+              : std::max<unsigned>(elemTy.getIntOrFloatBitWidth() / 8, 1);
+      allocation->addBuffer<BufferT::BufferKind::Scratch>(
+          op, scratchOp.size() * elemBytes);
+      allocation->opScratch[op]->alignment = kScratchBufferAlignment;
+    } else if (auto reduceOp = dyn_cast<triton::ReduceOp>(op)) {
+      ReduceOpHelper helper(reduceOp);
+      unsigned bytes = helper.getScratchSizeInBytes();
+      // Reductions within warps don't need scratch memory
+      if (bytes == 0)
+        return;
+      allocation->addBuffer<BufferT::BufferKind::Scratch>(op, bytes);
+    } else if (auto reduceOp = dyn_cast<triton::GenericReduceOp>(op)) {
       ReduceOpHelper helper(reduceOp);
       unsigned bytes = helper.getScratchSizeInBytes();
+      if (bytes == 0)
+        return;
+      allocation->addBuffer<BufferT::BufferKind::Scratch>(op, bytes);
+    } else if (auto scanOp = dyn_cast<triton::ScanOp>(op)) {
+      ReduceOpHelper helper(scanOp);
+      unsigned bytes = helper.getScanScratchSizeInBytes();
+      if (bytes == 0)
+        return;
+      allocation->addBuffer<BufferT::BufferKind::Scratch>(op, bytes);
+    } else if (auto sortOp = dyn_cast<triton::SortOp>(op)) {
+      ReduceOpHelper helper(sortOp);
+      unsigned bytes = helper.getSortScratchSizeInBytes();
+      if (bytes == 0)
+        return;
       allocation->addBuffer<BufferT::BufferKind::Scratch>(op, bytes);
     } else if (auto cvtLayout = dyn_cast<triton::gpu::ConvertLayoutOp>(op)) {
       auto srcTy = cvtLayout.src().getType().cast<RankedTensorType>();
@@ -177,10 +278,10 @@ private:
         // Conversions from/to shared memory do not need scratch memory.
         return;
       }
+      // Conversions within warps are done with warp shuffles
+      if (isWarpShuffleCvt(cvtLayout))
+        return;
       // ConvertLayoutOp with both input/output non-shared_layout
-      // TODO: Besides of implementing ConvertLayoutOp via shared memory, it's
-      //       also possible to realize it with other approaches in restricted
-      //       conditions, such as warp-shuffle
       unsigned inVec = 0;
       unsigned outVec = 0;
       auto smemShape = getScratchConfigForCvtLayout(cvtLayout, inVec, outVec);
@@ -300,6 +401,12 @@ private:
       // range.
       auto *op = opScratchIter.first;
       auto *buffer = opScratchIter.second;
+      // except for tt.scratch buffers, which are accessed through pointers
+      // until the end of the kernel
+      if (isa<triton::ScratchOp>(op)) {
+        bufferRange.insert({buffer, Interval<size_t>(0, operationId.size())});
+        continue;
+      }
       bufferRange.insert({buffer, Interval(operationId.lookup(op),
                                            operationId.lookup(op) + 1)});
     }
@@ -326,6 +433,21 @@ private:
     DenseMap<Operation *, size_t> operationId;
     operation->walk<WalkOrder::PostOrder>(
         [&](Operation *op) { operationId[op] = operationId.size(); });
+    // Both regions of a warp-specialized scf.if run concurrently, so they
+    // share the same range of IDs and thus never share memory.
+    operation->walk([&](scf::IfOp ifOp) {
+      if (!ifOp->hasAttr(
+              triton::gpu::TritonGPUDialect::getWarpSpecializedAttrName()))
+        return;
+      auto getStartId = [&](Block *block) {
+        auto minId = std::numeric_limits<size_t>::max();
+        block->walk(
+            [&](Operation *op) { minId = std::min(minId, operationId[op]); });
+        return minId;
+      };
+      auto shift = getStartId(ifOp.elseBlock()) - getStartId(ifOp.thenBlock());
+      ifOp.elseBlock()->walk([&](Operation *op) { operationId[op] -= shift; });
+    });
 
     // Analyze liveness of explicit buffers
     Liveness liveness(operation);
@@ -366,6 +488,10 @@ private:
     buildInterferenceGraph(buffers, bufferStart, interference);
 
     allocate(buffers, bufferStart, interference);
+
+    placeBestFit(buffers);
+
+    computePeakLiveSize(buffers);
   }
 
   /// Computes the initial shared memory offsets.
@@ -482,18 +608,120 @@ private:
         adj = std::max(adj, bufferStart.lookup(y) + y->size);
       }
       x->offset = bufferStart.lookup(x) + colors.lookup(x) * adj;
+    }
+  }
+
+  /// Revisits the offsets found by the graph coloring in increasing order.
+  /// A buffer is moved to the best-fit gap, i.e., the smallest gap that is
+  /// large enough, left by the visited buffers whose liveness ranges
+  /// intersect with its own range. It is moved only if the gap is below its
+  /// current offset or if it overlaps with one of these buffers: the
+  /// coloring stacks colors based on the initial starts rather than on the
+  /// final offsets, so it may both waste memory and place interfering buffers
+  /// on top of each other.
+  void placeBestFit(SmallVector<BufferT *> buffers) {
+    llvm::stable_sort(buffers, [](BufferT *lhs, BufferT *rhs) {
+      return lhs->offset < rhs->offset;
+    });
+    SmallVector<BufferT *> placed;
+    for (auto *x : buffers) {
+      auto xOpRange = bufferRange.lookup(x);
+      SmallVector<Interval<size_t>> occupied;
+      for (auto *y : placed) {
+        if (y->size > 0 && xOpRange.intersects(bufferRange.lookup(y)))
+          occupied.push_back({y->offset, y->offset + y->size});
+      }
+      llvm::sort(occupied);
+      Interval<size_t> xSizeRange = {x->offset, x->offset + x->size};
+      // a misaligned buffer is moved as an overlapping one
+      bool overlapped =
+          x->offset % x->alignment != 0 ||
+          llvm::any_of(occupied, [&](const Interval<size_t> &range) {
+            return range.intersects(xSizeRange);
+          });
+      std::optional<Interval<size_t>> bestGap;
+      auto tryGap = [&](size_t start, size_t end) {
+        start = llvm::alignTo(start, x->alignment);
+        if ((!overlapped && start >= x->offset) || start >= end ||
+            end - start < x->size)
+          return;
+        if (!bestGap || end - start < bestGap->size())
+          bestGap = Interval<size_t>(start, end);
+      };
+      size_t gapStart = 0;
+      for (auto range : occupied) {
+        if (range.start() > gapStart)
+          tryGap(gapStart, range.start());
+        gapStart = std::max(gapStart, range.end());
+      }
+      tryGap(gapStart, std::numeric_limits<size_t>::max());
+      if (bestGap)
+        x->offset = bestGap->start();
+      placed.push_back(x);
       allocation->sharedMemorySize =
           std::max(allocation->sharedMemorySize, x->offset + x->size);
     }
   }
 
+  /// Computes the largest total size of the buffers that are live at the
+  /// same time, which is a lower bound of the shared memory size.
+  void computePeakLiveSize(const SmallVector<BufferT *> &buffers) {
+    for (auto x : buffers) {
+      auto point = bufferRange.lookup(x).start();
+      size_t liveSize = 0;
+      for (auto y : buffers) {
+        if (bufferRange.lookup(y).contains(point))
+          liveSize += y->size;
+      }
+      allocation->peakLiveSize = std::max(allocation->peakLiveSize, liveSize);
+    }
+  }
+
 private:
   Operation *operation;
   Allocation *allocation;
+  bool alignSwizzledBuffers = false;
   BufferRangeMapT bufferRange;
 };
 } // namespace triton
 
 void Allocation::run() { triton::AllocationAnalysis(getOperation(), this); }
 
+Allocation::BufferIdSetT
+Allocation::getScratchPointerBufferIds(Value ptr) const {
+  BufferIdSetT bufferIds;
+  auto ptrTy =
+      getElementTypeOrSelf(ptr.getType()).dyn_cast<triton::PointerType>();
+  if (!ptrTy || ptrTy.getAddressSpace() !=
+                    gpu::GPUDialect::getWorkgroupAddressSpace())
+    return bufferIds;
+  SmallVector<Value> worklist{ptr};
+  DenseSet<Value> visited;
+  while (!worklist.empty()) {
+    Value value = worklist.pop_back_val();
+    if (!visited.insert(value).second)
+      continue;
+    Operation *defOp = value.getDefiningOp();
+    if (auto scratchOp = dyn_cast_or_null<triton::ScratchOp>(defOp)) {
+      bufferIds.insert(getBufferId(defOp));
+    } else if (auto addPtrOp = dyn_cast_or_null<triton::AddPtrOp>(defOp)) {
+      worklist.push_back(addPtrOp.ptr());
+    } else if (isa_and_nonnull<triton::SplatOp, triton::BroadcastOp,
+                               triton::ExpandDimsOp, triton::ViewOp,
+                               triton::BitcastOp,
+                               triton::gpu::ConvertLayoutOp>(defOp)) {
+      worklist.push_back(defOp->getOperand(0));
+    } else if (isa_and_nonnull<SelectOp, triton::gpu::SelectOp>(defOp)) {
+      worklist.push_back(defOp->getOperand(1));
+      worklist.push_back(defOp->getOperand(2));
+    } else {
+      for (auto opScratchIter : opScratch)
+        if (isa<triton::ScratchOp>(opScratchIter.first))
+          bufferIds.insert(opScratchIter.second->id);
+      break;
+    }
+  }
+  return bufferIds;
+}
+
 } // namespace mlir
@@ -2,6 +2,7 @@
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include "triton/Analysis/Allocation.h"
 #include "triton/Analysis/AxisInfo.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
@@ -42,48 +43,73 @@ static constexpr int log2Int(int64_t num) {
 // AxisInfo
 //===----------------------------------------------------------------------===//
 
+// Derive the divisibility of a scalar integer value from the ops that define
+// it. The dataflow framework marks the induction variable of an scf.for
+// pessimistic without visiting its bounds, so this follows the lower bound and
+// the step through the integer ops that typically compute them (e.g.
+// `pid * BLOCK_K` for split-K loops, or `lb + (numStages - 1) * step` in
+// pipelined loops).
+static int64_t getStaticDivisibility(Value value, unsigned depth = 0) {
+  constexpr unsigned maxDepth = 8;
+  const int64_t maxDivisibility = highestPowOf2Divisor<int64_t>(0);
+  if (depth > maxDepth)
+    return 1;
+  if (auto blockArg = value.dyn_cast<BlockArgument>()) {
+    if (!blockArg.getOwner()->isEntryBlock())
+      return 1;
+    Operation *op = blockArg.getOwner()->getParentOp();
+    Attribute attr;
+    if (auto fun = dyn_cast<FuncOp>(op))
+      attr = fun.getArgAttr(blockArg.getArgNumber(), "tt.divisibility");
+    else if (auto fun = dyn_cast<LLVM::LLVMFuncOp>(op))
+      attr = fun.getArgAttr(blockArg.getArgNumber(), "tt.divisibility");
+    else if (auto forOp = dyn_cast<scf::ForOp>(op))
+      if (blockArg == forOp.getInductionVar())
+        return gcd(getStaticDivisibility(forOp.getLowerBound(), depth + 1),
+                   getStaticDivisibility(forOp.getStep(), depth + 1));
+    if (attr)
+      return attr.cast<IntegerAttr>().getValue().getZExtValue();
+    return 1;
+  }
+  Operation *op = value.getDefiningOp();
+  if (!op || op->getNumResults() != 1)
+    return 1;
+  if (auto constOp = dyn_cast<arith::ConstantOp>(op)) {
+    if (auto intAttr = constOp.getValue().dyn_cast<IntegerAttr>())
+      return highestPowOf2Divisor(intAttr.getValue().getZExtValue());
+    return 1;
+  }
+  if (isa<arith::IndexCastOp, arith::ExtSIOp, arith::ExtUIOp>(op))
+    return getStaticDivisibility(op->getOperand(0), depth + 1);
+  if (isa<arith::AddIOp, arith::SubIOp>(op))
+    return gcd(getStaticDivisibility(op->getOperand(0), depth + 1),
+               getStaticDivisibility(op->getOperand(1), depth + 1));
+  if (isa<arith::MulIOp>(op)) {
+    int64_t lhs = getStaticDivisibility(op->getOperand(0), depth + 1);
+    int64_t rhs = getStaticDivisibility(op->getOperand(1), depth + 1);
+    return lhs > maxDivisibility / rhs ? maxDivisibility : lhs * rhs;
+  }
+  return 1;
+}
+
 AxisInfo AxisInfo::getPessimisticValueState(Value value) {
   auto rank = 1;
   if (TensorType ty = value.getType().dyn_cast<TensorType>())
     rank = ty.getRank();
   auto contiHint = 1;
-  auto divHint = 1;
+  int64_t divHint = 1;
   auto constHint = 1;
   BlockArgument blockArg = value.dyn_cast<BlockArgument>();
   if (blockArg && blockArg.getOwner()->isEntryBlock()) {
     Operation *op = blockArg.getOwner()->getParentOp();
-    if (FuncOp fun = dyn_cast<FuncOp>(op)) {
-      Attribute attr =
-          fun.getArgAttr(blockArg.getArgNumber(), "tt.divisibility");
-      if (attr)
-        divHint = attr.cast<IntegerAttr>().getValue().getZExtValue();
-    } else if (auto fun = dyn_cast<LLVM::LLVMFuncOp>(op)) {
-      Attribute attr =
-          fun.getArgAttr(blockArg.getArgNumber(), "tt.divisibility");
-      if (attr)
-        divHint = attr.cast<IntegerAttr>().getValue().getZExtValue();
-    } else {
-      // Derive the divisibility of the induction variable only when
-      // the step and the lower bound are both constants
-      if (auto forOp = dyn_cast<scf::ForOp>(op)) {
-        if (blockArg == forOp.getInductionVar()) {
-          if (auto lowerBound =
-                  forOp.getLowerBound().getDefiningOp<arith::ConstantOp>()) {
-            if (auto step =
-                    forOp.getStep().getDefiningOp<arith::ConstantOp>()) {
-              auto lowerBoundVal = lowerBound.getValue()
-                                       .cast<IntegerAttr>()
-                                       .getValue()
-                                       .getZExtValue();
-              auto stepVal =
-                  step.getValue().cast<IntegerAttr>().getValue().getZExtValue();
-              auto k = gcd(lowerBoundVal, stepVal);
-              if (k != 0)
-                divHint = k;
-            }
-          }
-        }
-      }
+    if (isa<FuncOp, LLVM::LLVMFuncOp>(op)) {
+      divHint = getStaticDivisibility(blockArg);
+    } else if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+      // Derive the divisibility of the induction variable from the
+      // divisibility of the lower bound and the step. The loop-carried
+      // values are joined across iterations by the dataflow solver.
+      if (blockArg == forOp.getInductionVar())
+        divHint = getStaticDivisibility(blockArg);
     }
   }
 
@@ -140,6 +166,20 @@ public:
   }
 };
 
+class ScratchOpAxisInfoVisitor final
+    : public AxisInfoVisitorImpl<triton::ScratchOp> {
+public:
+  using AxisInfoVisitorImpl<triton::ScratchOp>::AxisInfoVisitorImpl;
+
+  AxisInfo getAxisInfo(triton::ScratchOp op,
+                       ArrayRef<LatticeElement<AxisInfo> *> operands) override {
+    // the allocation aligns the buffer
+    return AxisInfo(/*contiguity=*/{1},
+                    /*divisibility=*/{triton::kScratchBufferAlignment},
+                    /*constancy=*/{1});
+  }
+};
+
 class ConstantOpAxisInfoVisitor final
     : public AxisInfoVisitorImpl<arith::ConstantOp> {
 public:
@@ -783,6 +823,7 @@ AxisInfoAnalysis::AxisInfoAnalysis(MLIRContext *context)
                   CastOpAxisInfoVisitor<triton::BitcastOp>>();
   visitors.append<MakeRangeOpAxisInfoVisitor>();
   visitors.append<ConstantOpAxisInfoVisitor>();
+  visitors.append<ScratchOpAxisInfoVisitor>();
   visitors.append<AddSubOpAxisInfoVisitor<triton::AddPtrOp>,
                   AddSubOpAxisInfoVisitor<arith::AddIOp>,
                   AddSubOpAxisInfoVisitor<arith::SubIOp>>();
@@ -809,13 +850,43 @@ AxisInfoAnalysis::AxisInfoAnalysis(MLIRContext *context)
                   MaxMinOpAxisInfoVisitor<arith::MinUIOp>>();
 }
 
+// Override \p dims with the `tt.divisibility` / `tt.contiguity` hint \p attr,
+// which is either a single integer or one integer per dimension.
+static void applyHint(AxisInfo::DimVectorT &dims, Attribute attr) {
+  if (auto intAttr = attr.dyn_cast<IntegerAttr>()) {
+    std::fill(dims.begin(), dims.end(), intAttr.getValue().getZExtValue());
+  } else if (auto denseAttr = attr.dyn_cast<DenseIntElementsAttr>()) {
+    if (denseAttr.getNumElements() != static_cast<int64_t>(dims.size()))
+      return;
+    for (auto it : llvm::enumerate(denseAttr.getValues<APInt>()))
+      dims[it.index()] = it.value().getZExtValue();
+  }
+}
+
 ChangeResult AxisInfoAnalysis::visitOperation(
     Operation *op, ArrayRef<LatticeElement<AxisInfo> *> operands) {
   AxisInfo curr = visitors.apply(op, operands);
+  Attribute divisibilityHint = op->getAttr("tt.divisibility");
+  Attribute contiguityHint = op->getAttr("tt.contiguity");
+  if (curr.getRank() == 0 && op->getNumResults() == 1 &&
+      (divisibilityHint || contiguityHint))
+    curr = AxisInfo::getPessimisticValueState(op->getResult(0));
   if (curr.getRank() == 0) {
     return markAllPessimisticFixpoint(op->getResults());
   }
 
+  // override with hints, e.g. from tl.multiple_of / tl.max_contiguous
+  if (divisibilityHint || contiguityHint) {
+    AxisInfo::DimVectorT contiguity = curr.getContiguity();
+    AxisInfo::DimVectorT divisibility = curr.getDivisibility();
+    if (divisibilityHint)
+      applyHint(divisibility, divisibilityHint);
+    if (contiguityHint)
+      applyHint(contiguity, contiguityHint);
+    curr = AxisInfo(contiguity, divisibility, curr.getConstancy(),
+                    curr.getConstantValue());
+  }
+
   // join all lattice elements
   ChangeResult result = ChangeResult::NoChange;
   for (Value value : op->getResults()) {
@@ -866,4 +937,21 @@ unsigned AxisInfoAnalysis::getMaskAlignment(Value mask) {
   return alignment;
 }
 
+bool AxisInfoAnalysis::isUniform(Value value) {
+  auto tensorTy = value.getType().dyn_cast<RankedTensorType>();
+  if (!tensorTy)
+    return true;
+  auto *lattice = lookupLatticeElement(value);
+  if (!lattice)
+    return false;
+  auto info = lattice->getValue();
+  auto shape = tensorTy.getShape();
+  if (info.getRank() != static_cast<int>(shape.size()))
+    return false;
+  for (int d = 0; d < info.getRank(); ++d)
+    if (!AxisInfoVisitor::isConstantDim(info, shape, d))
+      return false;
+  return true;
+}
+
 } // namespace mlir
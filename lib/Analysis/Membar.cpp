@@ -1,5 +1,6 @@
 #include "triton/Analysis/Membar.h"
 #include "triton/Analysis/Alias.h"
+#include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 
 #include "mlir/Dialect/GPU/GPUDialect.h"
@@ -7,11 +8,22 @@
 
 namespace mlir {
 
+// Whether the shared memory buffer is shared by the CTAs of a cluster
+static bool isClusterShared(Value value) {
+  auto tensorType = value.getType().dyn_cast<RankedTensorType>();
+  if (!tensorType)
+    return false;
+  auto sharedEnc = tensorType.getEncoding()
+                       .dyn_cast_or_null<triton::gpu::SharedEncodingAttr>();
+  return sharedEnc && sharedEnc.getClusterSize() > 1;
+}
+
 void MembarAnalysis::run() {
   auto *operation = allocation->getOperation();
   RegionInfo regionInfo;
   OpBuilder builder(operation);
   dfsOperation(operation, &regionInfo, &builder);
+  mergeBarriers(operation);
 }
 
 void MembarAnalysis::dfsOperation(Operation *operation,
@@ -67,10 +79,11 @@ void MembarAnalysis::dfsOperation(Operation *operation,
 void MembarAnalysis::transfer(Operation *op, RegionInfo *regionInfo,
                               OpBuilder *builder) {
   if (isa<scf::ForOp>(op) || isa<scf::IfOp>(op) || isa<scf::YieldOp>(op) ||
-      isa<tensor::ExtractSliceOp>(op) || isa<triton::gpu::AllocTensorOp>(op)) {
+      isa<tensor::ExtractSliceOp>(op) || isa<triton::gpu::AllocTensorOp>(op) ||
+      isa<triton::ScratchOp>(op)) {
     // Do not insert barriers before control flow operations and
     // alloc/extract/insert
-    // alloc is an allocation op without memory write.
+    // alloc and scratch are allocation ops without memory write.
     // FIXME(Keren): extract_slice is always alias for now
     return;
   }
@@ -81,6 +94,26 @@ void MembarAnalysis::transfer(Operation *op, RegionInfo *regionInfo,
     return;
   }
 
+  if (isa<triton::gpu::ClusterBarrierOp>(op)) {
+    regionInfo->syncCluster();
+    return;
+  }
+
+  if (isa<ReturnOp>(op) && !regionInfo->clusterReadBuffers.empty()) {
+    // The peers may still read the shared memory of the CTA
+    OpBuilder::InsertionGuard g(*builder);
+    builder->setInsertionPoint(op);
+    builder->create<triton::gpu::ClusterBarrierOp>(op->getLoc());
+    regionInfo->syncCluster();
+    return;
+  }
+
+  if (isa<triton::gpu::WarpBarrierOp>(op)) {
+    // A warp barrier only orders warp-local accesses, which are accounted for
+    // by the op that follows it
+    return;
+  }
+
   if (isa<triton::gpu::AsyncWaitOp>(op) &&
       !isa<gpu::BarrierOp>(op->getNextNode())) {
     // If the current op is an async wait and the next op is not a barrier we
@@ -102,6 +135,13 @@ void MembarAnalysis::transfer(Operation *op, RegionInfo *regionInfo,
           // FIXME(Keren): insert_slice and insert_slice_async are always alias
           // for now
           curRegionInfo.syncWriteBuffers.insert(bufferId);
+          // the part of the CTA is read by its peers
+          if (isClusterShared(op->getOperand(1)))
+            curRegionInfo.clusterWriteBuffers.insert(bufferId);
+        } else if (isa<triton::gpu::ClusterGatherOp>(op)) {
+          // cluster_gather reads the parts of the peers into the buffer
+          curRegionInfo.syncWriteBuffers.insert(bufferId);
+          curRegionInfo.clusterReadBuffers.insert(bufferId);
         } else {
           // ConvertLayoutOp: shared memory -> registers
           curRegionInfo.syncReadBuffers.insert(bufferId);
@@ -123,15 +163,90 @@ void MembarAnalysis::transfer(Operation *op, RegionInfo *regionInfo,
     curRegionInfo.syncReadBuffers.insert(bufferId);
   }
 
+  // Accesses through pointers to tt.scratch buffers
+  if (auto loadOp = dyn_cast<triton::LoadOp>(op)) {
+    auto bufferIds = allocation->getScratchPointerBufferIds(loadOp.ptr());
+    curRegionInfo.syncReadBuffers.insert(bufferIds.begin(), bufferIds.end());
+  } else if (auto storeOp = dyn_cast<triton::StoreOp>(op)) {
+    auto bufferIds = allocation->getScratchPointerBufferIds(storeOp.ptr());
+    curRegionInfo.syncWriteBuffers.insert(bufferIds.begin(), bufferIds.end());
+  } else if (isa<triton::AtomicRMWOp, triton::AtomicCASOp>(op)) {
+    auto bufferIds = allocation->getScratchPointerBufferIds(op->getOperand(0));
+    curRegionInfo.syncAtomicBuffers.insert(bufferIds.begin(), bufferIds.end());
+  }
+
+  // Every warp of a warp-local op only touches its own part of the scratch
+  // buffer, so conflicts with previous accesses of the same op only involve
+  // the warp itself
+  Allocation::BufferIdSetT warpLocalBuffers;
+  if (auto cvtLayout = dyn_cast<triton::gpu::ConvertLayoutOp>(op))
+    if (bufferId != Allocation::InvalidBufferId && isWarpLocal(cvtLayout))
+      warpLocalBuffers.insert(bufferId);
+
+  if (regionInfo->isClusterIntersected(curRegionInfo, allocation)) {
+    OpBuilder::InsertionGuard g(*builder);
+    builder->setInsertionPoint(op);
+    builder->create<triton::gpu::ClusterBarrierOp>(op->getLoc());
+    regionInfo->syncCluster();
+  }
   if (regionInfo->isIntersected(curRegionInfo, allocation)) {
     OpBuilder::InsertionGuard g(*builder);
     builder->setInsertionPoint(op);
-    builder->create<gpu::BarrierOp>(op->getLoc());
-    regionInfo->sync();
+    if (regionInfo->isIntersected(curRegionInfo, allocation,
+                                  warpLocalBuffers)) {
+      builder->create<gpu::BarrierOp>(op->getLoc());
+      regionInfo->sync();
+    } else if (!isa_and_nonnull<triton::gpu::WarpBarrierOp>(
+                   op->getPrevNode())) {
+      // Other warps may still access other buffers, so nothing is synced
+      builder->create<triton::gpu::WarpBarrierOp>(op->getLoc());
+    }
   }
   // Update the region info, even if barrier is inserted, we have to maintain
   // the current op's read/write buffers.
   regionInfo->join(curRegionInfo);
 }
 
+void MembarAnalysis::mergeBarriers(Operation *operation) {
+  // Post-order walk, so that barriers hoisted out of a nested scf.if can be
+  // merged again by the enclosing one
+  operation->walk([&](scf::IfOp ifOp) {
+    if (ifOp.elseRegion().empty())
+      return;
+    Operation *thenFront = &ifOp.thenBlock()->front();
+    Operation *elseFront = &ifOp.elseBlock()->front();
+    if (!isa<gpu::BarrierOp>(thenFront) || !isa<gpu::BarrierOp>(elseFront))
+      return;
+    thenFront->erase();
+    elseFront->erase();
+    if (!isa_and_nonnull<gpu::BarrierOp>(ifOp->getPrevNode())) {
+      OpBuilder builder(ifOp);
+      builder.create<gpu::BarrierOp>(ifOp.getLoc());
+    }
+  });
+
+  operation->walk([&](Operation *op) {
+    if (!isa<gpu::BarrierOp, triton::gpu::WarpBarrierOp,
+             triton::gpu::ClusterBarrierOp>(op))
+      return;
+    Operation *prevOp = op->getPrevNode();
+    if (!prevOp)
+      return;
+    if (isa<triton::gpu::ClusterBarrierOp>(op)) {
+      // A cluster barrier covers any barrier before it
+      if (isa<triton::gpu::ClusterBarrierOp>(prevOp))
+        op->erase();
+      else if (isa<gpu::BarrierOp, triton::gpu::WarpBarrierOp>(prevOp))
+        prevOp->erase();
+    } else if (isa<gpu::BarrierOp, triton::gpu::ClusterBarrierOp>(prevOp) ||
+               (isa<triton::gpu::WarpBarrierOp>(prevOp) &&
+                isa<triton::gpu::WarpBarrierOp>(op)))
+      // The previous barrier already covers this one
+      op->erase();
+    else if (isa<triton::gpu::WarpBarrierOp>(prevOp))
+      // A CTA-wide barrier covers the warp barrier before it
+      prevOp->erase();
+  });
+}
+
 } // namespace mlir
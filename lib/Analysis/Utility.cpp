@@ -1,90 +1,203 @@
 #include "triton/Analysis/Utility.h"
+#include "mlir/Dialect/SCF/SCF.h"
 #include "mlir/IR/Dialect.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include <deque>
+#include <optional>
 
 namespace mlir {
 
-bool ReduceOpHelper::isFastReduction() {
-  auto srcLayout = srcTy.getEncoding();
-  auto axis = op.axis();
-  return axis == triton::gpu::getOrder(srcLayout)[0];
+ReduceOpHelper::ReduceOpHelper(triton::ReduceOp op) : axis(op.axis()) {
+  srcTy = op.operand().getType().cast<RankedTensorType>();
+  scratchElementBytes.push_back(srcTy.getElementTypeBitWidth() / 8);
+  if (triton::ReduceOp::withIndex(op.redOp()))
+    scratchElementBytes.push_back(sizeof(int32_t));
 }
 
-unsigned ReduceOpHelper::getInterWarpSize() {
-  auto srcLayout = srcTy.getEncoding();
-  auto srcShape = srcTy.getShape();
-  auto axis = op.axis();
-  auto srcReduceDimSize = static_cast<unsigned>(srcShape[axis]);
-  unsigned sizeIntraWarps = getIntraWarpSize();
-  return std::min(srcReduceDimSize / sizeIntraWarps,
-                  triton::gpu::getWarpsPerCTA(srcLayout)[axis]);
+ReduceOpHelper::ReduceOpHelper(triton::GenericReduceOp op) : axis(op.axis()) {
+  srcTy = op.operands().front().getType().cast<RankedTensorType>();
+  for (Value operand : op.operands()) {
+    auto tensorTy = operand.getType().cast<RankedTensorType>();
+    scratchElementBytes.push_back(
+        std::max<unsigned>(tensorTy.getElementTypeBitWidth() / 8, 1));
+  }
 }
 
-unsigned ReduceOpHelper::getIntraWarpSize() {
-  auto srcLayout = srcTy.getEncoding();
-  auto srcShape = srcTy.getShape();
-  auto axis = op.axis();
-  auto srcReduceDimSize = static_cast<unsigned>(srcShape[axis]);
-  return std::min(srcReduceDimSize,
-                  triton::gpu::getThreadsPerWarp(srcLayout)[axis]);
+ReduceOpHelper::ReduceOpHelper(triton::ScanOp op) : axis(op.axis()) {
+  srcTy = op.operands().front().getType().cast<RankedTensorType>();
+  for (Value operand : op.operands()) {
+    auto tensorTy = operand.getType().cast<RankedTensorType>();
+    scratchElementBytes.push_back(
+        std::max<unsigned>(tensorTy.getElementTypeBitWidth() / 8, 1));
+  }
 }
 
-unsigned ReduceOpHelper::getThreadsReductionAxis() {
-  auto srcLayout = srcTy.getEncoding();
-  auto axis = op.axis();
-  return triton::gpu::getThreadsPerWarp(srcLayout)[axis] *
-         triton::gpu::getWarpsPerCTA(srcLayout)[axis];
+ReduceOpHelper::ReduceOpHelper(triton::SortOp op) : axis(op.axis()) {
+  srcTy = op.operands().front().getType().cast<RankedTensorType>();
+  for (Value operand : op.operands()) {
+    auto tensorTy = operand.getType().cast<RankedTensorType>();
+    scratchElementBytes.push_back(
+        std::max<unsigned>(tensorTy.getElementTypeBitWidth() / 8, 1));
+  }
+  isTopK = op.k() && *op.k() < srcTy.getShape()[axis];
 }
 
-SmallVector<unsigned> ReduceOpHelper::getScratchConfigBasic() {
-  auto axis = op.axis();
-  auto smemShape = convertType<unsigned>(getSrcShape());
-  smemShape[axis] = std::min(smemShape[axis], getThreadsReductionAxis());
-  return smemShape;
+bool ReduceOpHelper::isSupportedLayout() {
+  auto layout = getThreadLayout();
+  if (layout.isa<triton::gpu::BlockedEncodingAttr>())
+    return true;
+  if (auto mmaLayout = layout.dyn_cast<triton::gpu::MmaEncodingAttr>())
+    return mmaLayout.isAmpere() || mmaLayout.isHopper();
+  if (auto mfmaLayout = layout.dyn_cast<triton::gpu::MfmaEncodingAttr>())
+    return mfmaLayout.getNonKDim() == 32;
+  return false;
+}
+
+Attribute ReduceOpHelper::getThreadLayout() {
+  auto layout = srcTy.getEncoding();
+  while (auto sliceLayout = layout.dyn_cast<triton::gpu::SliceEncodingAttr>())
+    layout = sliceLayout.getParent();
+  return layout;
 }
 
-SmallVector<SmallVector<unsigned>> ReduceOpHelper::getScratchConfigsFast() {
-  auto axis = op.axis();
-  SmallVector<SmallVector<unsigned>> smemShapes(3);
+SmallVector<int64_t> ReduceOpHelper::getThreadShape() {
+  auto layout = srcTy.getEncoding();
+  auto shape = llvm::to_vector(srcTy.getShape());
+  while (auto sliceLayout = layout.dyn_cast<triton::gpu::SliceEncodingAttr>()) {
+    shape = sliceLayout.paddedShape<int64_t>(shape);
+    layout = sliceLayout.getParent();
+  }
+  return shape;
+}
 
-  auto argLayout = srcTy.getEncoding();
-  auto argLayoutMma = argLayout.dyn_cast<triton::gpu::MmaEncodingAttr>();
-  if (argLayoutMma && argLayoutMma.getVersionMajor() == 2 &&
-      triton::gpu::getWarpsPerCTA(argLayout)[axis] == 1)
-    return {{1, 1}, {1, 1}};
+unsigned ReduceOpHelper::getThreadAxis() {
+  auto layout = srcTy.getEncoding();
+  unsigned axis = this->axis;
+  while (auto sliceLayout = layout.dyn_cast<triton::gpu::SliceEncodingAttr>()) {
+    if (axis >= sliceLayout.getDim())
+      ++axis;
+    layout = sliceLayout.getParent();
+  }
+  return axis;
+}
 
-  /// shared memory block0
-  smemShapes[0] = convertType<unsigned>(getSrcShape());
-  smemShapes[0][axis] = getInterWarpSize();
+unsigned ReduceOpHelper::getWarpSize() {
+  return product<unsigned>(getThreadsPerWarp());
+}
 
-  /// FIXME(Qingyi): This size is actually larger than required.
-  /// shared memory block1:
-  auto mod = op.getOperation()->getParentOfType<ModuleOp>();
-  unsigned numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
-  smemShapes[1].push_back(numWarps * 32);
+SmallVector<unsigned> ReduceOpHelper::getThreadsPerWarp() {
+  return triton::gpu::getThreadsPerWarp(getThreadLayout());
+}
 
-  return smemShapes;
+SmallVector<unsigned> ReduceOpHelper::getLaneOrder() {
+  return triton::gpu::getOrder(getThreadLayout());
 }
 
-unsigned ReduceOpHelper::getScratchSizeInBytes() {
-  unsigned elems = 0;
-  if (isFastReduction()) {
-    auto smemShapes = getScratchConfigsFast();
-    for (const auto &smemShape : smemShapes)
-      elems = std::max(elems, product<unsigned>(smemShape));
-  } else {
-    auto smemShape = getScratchConfigBasic();
-    elems = product<unsigned>(smemShape);
+SmallVector<unsigned> ReduceOpHelper::getWarpsPerCTA() {
+  return triton::gpu::getWarpsPerCTA(getThreadLayout());
+}
+
+SmallVector<unsigned> ReduceOpHelper::getWarpOrder() {
+  // mma and mfma warps are numbered along the rows first
+  auto layout = getThreadLayout();
+  if (layout.isa<triton::gpu::MmaEncodingAttr, triton::gpu::MfmaEncodingAttr>())
+    return {0, 1};
+  return triton::gpu::getOrder(layout);
+}
+
+SmallVector<unsigned> ReduceOpHelper::getShapePerWarp() {
+  auto layout = getThreadLayout();
+  if (layout.isa<triton::gpu::MmaEncodingAttr>())
+    return {16, 8};
+  if (auto mfmaLayout = layout.dyn_cast<triton::gpu::MfmaEncodingAttr>())
+    return {mfmaLayout.getNonKDim(), mfmaLayout.getNonKDim()};
+  auto sizePerThread = triton::gpu::getSizePerThread(layout);
+  auto threadsPerWarp = getThreadsPerWarp();
+  SmallVector<unsigned> shapePerWarp(sizePerThread.size());
+  for (unsigned d = 0; d < shapePerWarp.size(); ++d)
+    shapePerWarp[d] = sizePerThread[d] * threadsPerWarp[d];
+  return shapePerWarp;
+}
+
+unsigned ReduceOpHelper::getIntraWarpStride() {
+  auto threadsPerWarp = getThreadsPerWarp();
+  unsigned axis = getThreadAxis();
+  unsigned stride = 1;
+  for (unsigned d : getLaneOrder()) {
+    if (d == axis)
+      break;
+    stride *= threadsPerWarp[d];
   }
+  return stride;
+}
 
-  auto tensorType = op.operand().getType().cast<RankedTensorType>();
-  unsigned bytes = elems * tensorType.getElementTypeBitWidth() / 8;
+unsigned ReduceOpHelper::getIntraWarpSize() {
+  unsigned axis = getThreadAxis();
+  unsigned threads = getThreadsPerWarp()[axis];
+  unsigned rowsPerThread = getShapePerWarp()[axis] / threads;
+  return std::min(threads, ceil<unsigned>(getThreadShape()[axis],
+                                          rowsPerThread));
+}
 
-  if (triton::ReduceOp::withIndex(op.redOp()))
-    bytes += elems * sizeof(int32_t);
+unsigned ReduceOpHelper::getInterWarpSize() {
+  unsigned axis = getThreadAxis();
+  return std::min(
+      getWarpsPerCTA()[axis],
+      ceil<unsigned>(getThreadShape()[axis], getShapePerWarp()[axis]));
+}
 
+SmallVector<unsigned> ReduceOpHelper::getScratchConfig() {
+  unsigned sizeInterWarps = getInterWarpSize();
+  if (sizeInterWarps == 1)
+    return {};
+  auto smemShape = convertType<unsigned>(getSrcShape());
+  smemShape[axis] = sizeInterWarps;
+  return smemShape;
+}
+
+unsigned ReduceOpHelper::getScratchSizeInBytes() {
+  return getScratchSizeInBytes(getScratchConfig());
+}
+
+unsigned ReduceOpHelper::getAxisRepetitions() {
+  unsigned axis = getThreadAxis();
+  unsigned shapePerCTA = getShapePerWarp()[axis] * getWarpsPerCTA()[axis];
+  return ceil<unsigned>(getThreadShape()[axis], shapePerCTA);
+}
+
+SmallVector<unsigned> ReduceOpHelper::getScanScratchConfig() {
+  unsigned sizeInterWarps = getInterWarpSize();
+  if (sizeInterWarps == 1)
+    return {};
+  auto smemShape = convertType<unsigned>(getSrcShape());
+  smemShape[axis] = sizeInterWarps * getAxisRepetitions();
+  return smemShape;
+}
+
+unsigned ReduceOpHelper::getScanScratchSizeInBytes() {
+  return getScratchSizeInBytes(getScanScratchConfig());
+}
+
+SmallVector<unsigned> ReduceOpHelper::getSortScratchConfig() {
+  if (getInterWarpSize() == 1 && !isTopK)
+    return {};
+  return convertType<unsigned>(getSrcShape());
+}
+
+unsigned ReduceOpHelper::getSortScratchSizeInBytes() {
+  return getScratchSizeInBytes(getSortScratchConfig());
+}
+
+unsigned ReduceOpHelper::getScratchSizeInBytes(ArrayRef<unsigned> smemShape) {
+  if (smemShape.empty())
+    return 0;
+  unsigned elems = product<unsigned>(smemShape);
+  unsigned bytes = 0;
+  for (unsigned elementBytes : scratchElementBytes)
+    bytes += elems * elementBytes;
   return bytes;
 }
 
@@ -114,18 +227,33 @@ bool maybeSharedAllocationOp(Operation *op) {
 bool maybeAliasOp(Operation *op) {
   return isa<tensor::ExtractSliceOp>(op) || isa<triton::TransOp>(op) ||
          isa<triton::gpu::InsertSliceAsyncOp>(op) ||
-         isa<tensor::InsertSliceOp>(op);
+         isa<tensor::InsertSliceOp>(op) ||
+         isa<triton::gpu::ClusterGatherOp>(op);
 }
 
 bool supportMMA(triton::DotOp op, int version) {
   // Refer to mma section for the data type supported by Volta and Hopper
   // Tensor Core in
   // https://docs.nvidia.com/cuda/parallel-thread-execution/index.html#warp-level-matrix-fragment-mma-884-f16
-  auto aElemTy = op.a().getType().cast<RankedTensorType>().getElementType();
+  auto aTy = op.a().getType().cast<RankedTensorType>();
+  auto aElemTy = aTy.getElementType();
   auto bElemTy = op.b().getType().cast<RankedTensorType>().getElementType();
+  // wgmma.m64nNk16 with $a in registers: f16 or bf16 operands, f32
+  // accumulator, and N a multiple of 8 up to 256 per instruction
+  if (version == 3) {
+    auto dTy = op.getType().cast<RankedTensorType>();
+    auto bShape = op.b().getType().cast<RankedTensorType>().getShape();
+    return aElemTy == bElemTy && (aElemTy.isF16() || aElemTy.isBF16()) &&
+           dTy.getElementType().isF32() && !op.aFp8Format() &&
+           !op.bFp8Format() && bShape[0] % 16 == 0 && bShape[1] % 8 == 0;
+  }
   if (aElemTy.isF32() && bElemTy.isF32()) {
     return op.allowTF32() && version >= 2;
   }
+  // The 8-bit mma (int8, and fp8 as i8) is m16n8k32: smaller K fall back to
+  // FMA
+  if (aElemTy.isInteger(8) && aTy.getShape()[1] < 32)
+    return false;
   return supportMMA(op.a(), version) && supportMMA(op.b(), version);
 }
 
@@ -133,14 +261,56 @@ bool supportMMA(Value value, int version) {
   // Tell whether a DotOp support HMMA by the operand type(either $a or $b).
   // We cannot get both the operand types(in TypeConverter), here we assume the
   // types of both the operands are identical here.
-  assert((version == 1 || version == 2) &&
+  assert((version == 1 || version == 2 || version == 3) &&
          "Unexpected MMA layout version found");
   auto elemTy = value.getType().cast<RankedTensorType>().getElementType();
+  if (version == 3)
+    return elemTy.isF16() || elemTy.isBF16();
   return elemTy.isF16() || elemTy.isBF16() ||
          (elemTy.isF32() && version >= 2) ||
          (elemTy.isInteger(8) && version >= 2);
 }
 
+bool supportSparseMMA(triton::SparseDotOp op) {
+  auto aTy = op.a().getType().cast<RankedTensorType>();
+  auto metaTy = op.aMeta().getType().cast<RankedTensorType>();
+  auto bTy = op.b().getType().cast<RankedTensorType>();
+  auto dTy = op.getType().cast<RankedTensorType>();
+  auto aElemTy = aTy.getElementType();
+  if (aElemTy != bTy.getElementType() ||
+      !(aElemTy.isF16() || aElemTy.isBF16()) ||
+      !dTy.getElementType().isF32() || !metaTy.getElementType().isInteger(16))
+    return false;
+  return aTy.getShape()[0] >= 16 && aTy.getShape()[1] % 16 == 0 &&
+         bTy.getShape()[0] == 2 * aTy.getShape()[1] &&
+         bTy.getShape()[1] >= 16 &&
+         metaTy.getShape()[1] * 16 == bTy.getShape()[0];
+}
+
+bool supportMFMA(triton::DotOp op) {
+  auto aTy = op.a().getType().cast<RankedTensorType>();
+  auto bTy = op.b().getType().cast<RankedTensorType>();
+  auto aElemTy = aTy.getElementType();
+  auto bElemTy = bTy.getElementType();
+  if (aElemTy != bElemTy)
+    return false;
+  // Each wavefront computes a 32x32 tile of $d per instruction.
+  if (aTy.getShape()[0] < 32 || bTy.getShape()[1] < 32)
+    return false;
+  // K of v_mfma_f32_32x32x{8f16, 4bf16, 2f32} and v_mfma_i32_32x32x8i8:
+  // smaller K fall back to FMA
+  unsigned instrK;
+  if (aElemTy.isF16() || aElemTy.isInteger(8))
+    instrK = 8;
+  else if (aElemTy.isBF16())
+    instrK = 4;
+  else if (aElemTy.isF32())
+    instrK = 2;
+  else
+    return false;
+  return aTy.getShape()[1] >= instrK;
+}
+
 Type getElementType(Value value) {
   auto type = value.getType();
   if (auto tensorType = type.dyn_cast<RankedTensorType>())
@@ -158,13 +328,580 @@ std::string getValueOperandName(Value value, AsmState &state) {
 bool isMmaToDotShortcut(triton::gpu::MmaEncodingAttr &mmaLayout,
                         triton::gpu::DotOperandEncodingAttr &dotOperandLayout) {
   // dot_op<opIdx=0, parent=#mma> = #mma
-  // when #mma = MmaEncoding<version=2, warpsPerCTA=[..., 1]>
-  return mmaLayout.getVersionMajor() == 2 &&
+  // when #mma = MmaEncoding<version=2|3, warpsPerCTA=[..., 1]>
+  return (mmaLayout.isAmpere() || mmaLayout.isHopper()) &&
          mmaLayout.getWarpsPerCTA()[1] == 1 &&
          dotOperandLayout.getOpIdx() == 0 &&
          dotOperandLayout.getParent() == mmaLayout;
 }
 
+bool isWarpLocal(triton::gpu::ConvertLayoutOp op) {
+  auto srcTy = op.src().getType().cast<RankedTensorType>();
+  auto dstTy = op.result().getType().cast<RankedTensorType>();
+  auto srcLayout =
+      srcTy.getEncoding().dyn_cast<triton::gpu::BlockedEncodingAttr>();
+  auto dstLayout =
+      dstTy.getEncoding().dyn_cast<triton::gpu::BlockedEncodingAttr>();
+  if (!srcLayout || !dstLayout)
+    return false;
+  // Warps are numbered the same way in both layouts
+  if (srcLayout.getWarpsPerCTA() != dstLayout.getWarpsPerCTA() ||
+      srcLayout.getOrder() != dstLayout.getOrder())
+    return false;
+  // Each warp covers the same sub-tile in both layouts, and no element is
+  // replicated across warps
+  auto shape = srcTy.getShape();
+  for (unsigned d = 0; d < shape.size(); ++d) {
+    unsigned srcShapePerWarp =
+        srcLayout.getSizePerThread()[d] * srcLayout.getThreadsPerWarp()[d];
+    unsigned dstShapePerWarp =
+        dstLayout.getSizePerThread()[d] * dstLayout.getThreadsPerWarp()[d];
+    if (srcShapePerWarp != dstShapePerWarp ||
+        srcShapePerWarp * srcLayout.getWarpsPerCTA()[d] > shape[d])
+      return false;
+  }
+  return true;
+}
+
+namespace {
+
+// Multi-dimensional index of `linear` in `shape`, order[0] being the fastest
+// varying dimension
+SmallVector<unsigned> delinearize(unsigned linear, ArrayRef<unsigned> shape,
+                                  ArrayRef<unsigned> order) {
+  SmallVector<unsigned> multiDim(shape.size());
+  for (unsigned d : order) {
+    multiDim[d] = linear % shape[d];
+    linear /= shape[d];
+  }
+  return multiDim;
+}
+
+// Coordinates of element `elem` of lane `lane` of warp `warp` in a blocked
+// layout, as emitted by emitIndices
+SmallVector<unsigned>
+getBlockedCoords(triton::gpu::BlockedEncodingAttr layout,
+                 ArrayRef<int64_t> shape, unsigned warp, unsigned lane,
+                 unsigned elem) {
+  auto sizePerThread = layout.getSizePerThread();
+  auto threadsPerWarp = layout.getThreadsPerWarp();
+  auto warpsPerCTA = layout.getWarpsPerCTA();
+  auto order = layout.getOrder();
+  auto shapePerCTA = triton::gpu::getShapePerCTA(layout);
+  unsigned rank = shape.size();
+  SmallVector<unsigned> tilesPerDim(rank);
+  for (unsigned d = 0; d < rank; ++d)
+    tilesPerDim[d] = ceil<unsigned>(shape[d], shapePerCTA[d]);
+  unsigned elemsPerTile = product<unsigned>(sizePerThread);
+  auto tileId = delinearize(elem / elemsPerTile, tilesPerDim, order);
+  auto elemId = delinearize(elem % elemsPerTile, sizePerThread, order);
+  auto warpId = delinearize(warp, warpsPerCTA, order);
+  auto laneId = delinearize(lane, threadsPerWarp, order);
+  SmallVector<unsigned> coords(rank);
+  for (unsigned d = 0; d < rank; ++d) {
+    // Threads wrap around when the tensor is smaller than the CTA tile
+    unsigned maxWarps =
+        ceil<unsigned>(shape[d], sizePerThread[d] * threadsPerWarp[d]);
+    unsigned maxThreads = ceil<unsigned>(shape[d], sizePerThread[d]);
+    coords[d] = tileId[d] * shapePerCTA[d] +
+                ((warpId[d] % maxWarps) * threadsPerWarp[d] +
+                 laneId[d] % maxThreads) *
+                    sizePerThread[d] +
+                elemId[d];
+  }
+  return coords;
+}
+
+// The bits of the register, lane and warp ids of a blocked layout, each
+// mapped to the bit of the flattened element coordinates it selects (the bits
+// of dim d following those of the dims before it), or -1 if it only selects
+// replicas, as emitted by emitIndices. None unless all the sizes are powers of
+// two and the tensor covers the elements of a thread.
+struct BlockedBits {
+  SmallVector<int> reg, lane, warp;
+};
+
+Optional<BlockedBits> getBlockedBits(triton::gpu::BlockedEncodingAttr layout,
+                                     ArrayRef<int64_t> shape) {
+  auto sizePerThread = layout.getSizePerThread();
+  auto threadsPerWarp = layout.getThreadsPerWarp();
+  auto warpsPerCTA = layout.getWarpsPerCTA();
+  auto order = layout.getOrder();
+  unsigned rank = shape.size();
+  SmallVector<unsigned> coordBase(rank), coordBits(rank);
+  unsigned numCoordBits = 0;
+  for (unsigned d = 0; d < rank; ++d) {
+    if (!llvm::isPowerOf2_64(shape[d]) ||
+        !llvm::isPowerOf2_32(sizePerThread[d]) ||
+        !llvm::isPowerOf2_32(threadsPerWarp[d]) ||
+        !llvm::isPowerOf2_32(warpsPerCTA[d]) || shape[d] < sizePerThread[d])
+      return llvm::None;
+    coordBase[d] = numCoordBits;
+    coordBits[d] = llvm::Log2_64(shape[d]);
+    numCoordBits += coordBits[d];
+  }
+  // Ids are linearized along `order`, and threads wrap around when the
+  // tensor is smaller than the CTA tile
+  auto append = [&](SmallVector<int> &bits, unsigned d, unsigned firstBit,
+                    unsigned size) {
+    for (unsigned k = 0; k < llvm::Log2_32(size); ++k) {
+      unsigned bit = firstBit + k;
+      bits.push_back(bit < coordBits[d] ? coordBase[d] + bit : -1);
+    }
+  };
+  BlockedBits bits;
+  for (unsigned d : order)
+    append(bits.reg, d, 0, sizePerThread[d]);
+  for (unsigned d : order) {
+    unsigned shapePerCTA =
+        sizePerThread[d] * threadsPerWarp[d] * warpsPerCTA[d];
+    append(bits.reg, d, llvm::Log2_32(shapePerCTA),
+           ceil<unsigned>(shape[d], shapePerCTA));
+  }
+  for (unsigned d : order)
+    append(bits.lane, d, llvm::Log2_32(sizePerThread[d]), threadsPerWarp[d]);
+  for (unsigned d : order)
+    append(bits.warp, d,
+           llvm::Log2_32(sizePerThread[d] * threadsPerWarp[d]),
+           warpsPerCTA[d]);
+  return bits;
+}
+
+} // namespace
+
+SmallVector<unsigned>
+getWarpShuffleSrcElems(triton::gpu::ConvertLayoutOp op) {
+  return getWarpShuffleSrcElems(op.src().getType().cast<RankedTensorType>(),
+                                op.result().getType().cast<RankedTensorType>());
+}
+
+SmallVector<unsigned> getWarpShuffleSrcElems(RankedTensorType srcTy,
+                                             RankedTensorType dstTy) {
+  auto srcLayout =
+      srcTy.getEncoding().dyn_cast<triton::gpu::BlockedEncodingAttr>();
+  auto dstLayout =
+      dstTy.getEncoding().dyn_cast<triton::gpu::BlockedEncodingAttr>();
+  if (!srcLayout || !dstLayout || srcLayout == dstLayout)
+    return {};
+  unsigned numWarps = product<unsigned>(dstLayout.getWarpsPerCTA());
+  unsigned warpSize = product<unsigned>(dstLayout.getThreadsPerWarp());
+  if (numWarps != product<unsigned>(srcLayout.getWarpsPerCTA()) ||
+      warpSize != product<unsigned>(srcLayout.getThreadsPerWarp()))
+    return {};
+
+  auto srcBits = getBlockedBits(srcLayout, srcTy.getShape());
+  auto dstBits = getBlockedBits(dstLayout, dstTy.getShape());
+  if (!srcBits || !dstBits)
+    return {};
+
+  // The dst bit selecting each coordinate bit. Every coordinate bit is
+  // selected by exactly one bit of a blocked layout.
+  enum Kind { Reg, Lane, Warp };
+  DenseMap<int, std::pair<Kind, unsigned>> dstBitOf;
+  for (auto [kind, bits] : {std::make_pair(Reg, &dstBits->reg),
+                            std::make_pair(Lane, &dstBits->lane),
+                            std::make_pair(Warp, &dstBits->warp)})
+    for (unsigned i = 0; i < bits->size(); ++i)
+      if ((*bits)[i] >= 0)
+        dstBitOf[(*bits)[i]] = {kind, i};
+
+  // The holder of an element is in the same warp if the src and dst warp ids
+  // are the same bits of the coordinates. Replicas across warps are
+  // attributed to the first one, i.e. they are not.
+  for (unsigned i = 0; i < srcBits->warp.size(); ++i) {
+    int coordBit = srcBits->warp[i];
+    if (coordBit < 0 || dstBitOf.lookup(coordBit) != std::make_pair(Warp, i))
+      return {};
+  }
+  // Its register is the same in all the lanes if the src register bits are
+  // selected by dst register bits
+  SmallVector<std::pair<unsigned, unsigned>> regBits;
+  for (unsigned i = 0; i < srcBits->reg.size(); ++i) {
+    int coordBit = srcBits->reg[i];
+    if (coordBit < 0)
+      continue;
+    auto [kind, dstBit] = dstBitOf.lookup(coordBit);
+    if (kind != Reg)
+      return {};
+    regBits.push_back({i, dstBit});
+  }
+
+  unsigned numElems = 1u << dstBits->reg.size();
+  SmallVector<unsigned> srcElems(numElems);
+  for (unsigned elem = 0; elem < numElems; ++elem)
+    for (auto [srcBit, dstBit] : regBits)
+      srcElems[elem] |= (elem >> dstBit & 1) << srcBit;
+  return srcElems;
+}
+
+bool isWarpShuffleCvt(triton::gpu::ConvertLayoutOp op) {
+  return !getWarpShuffleSrcElems(op).empty();
+}
+
+unsigned getTraceValueWords(Type type) {
+  if (type.isa<triton::PointerType>())
+    return 2;
+  return type.getIntOrFloatBitWidth() > 32 ? 2 : 1;
+}
+
+unsigned getTraceRecordWords(triton::TraceOp op) {
+  unsigned words = 3;
+  for (Value arg : op.args()) {
+    auto tensorTy = arg.getType().dyn_cast<RankedTensorType>();
+    if (!tensorTy) {
+      words += getTraceValueWords(arg.getType());
+      continue;
+    }
+    unsigned elems = triton::gpu::getElemsPerThread(tensorTy);
+    words += elems * (1 + getTraceValueWords(tensorTy.getElementType()));
+  }
+  return words;
+}
+
+// Pointers into shared memory, e.g. into tt.scratch buffers, never alias the
+// arguments of the kernel
+bool isGlobalPointer(Value value) {
+  auto ptrTy = getElementTypeOrSelf(value.getType())
+                   .dyn_cast<triton::PointerType>();
+  return ptrTy && ptrTy.getAddressSpace() !=
+                      gpu::GPUDialect::getWorkgroupAddressSpace();
+}
+
+Optional<SmallVector<unsigned>> getPointerRoots(Value ptr) {
+  SmallVector<unsigned> roots;
+  SmallVector<Value> worklist{ptr};
+  DenseSet<Value> visited;
+  // the value carried by the `i`-th iter arg of a loop
+  auto pushLoopCarried = [&](scf::ForOp forOp, unsigned i) {
+    worklist.push_back(forOp.getIterOperands()[i]);
+    worklist.push_back(forOp.getBody()->getTerminator()->getOperand(i));
+  };
+  while (!worklist.empty()) {
+    Value value = worklist.pop_back_val();
+    if (!visited.insert(value).second)
+      continue;
+    if (auto arg = value.dyn_cast<BlockArgument>()) {
+      Operation *parentOp = arg.getOwner()->getParentOp();
+      if (isa<FuncOp>(parentOp) && arg.getOwner()->isEntryBlock()) {
+        roots.push_back(arg.getArgNumber());
+        continue;
+      }
+      auto forOp = dyn_cast<scf::ForOp>(parentOp);
+      if (!forOp || arg.getArgNumber() < forOp.getNumInductionVars())
+        return llvm::None;
+      pushLoopCarried(forOp, arg.getArgNumber() - forOp.getNumInductionVars());
+      continue;
+    }
+    Operation *op = value.getDefiningOp();
+    unsigned resultIdx = value.cast<OpResult>().getResultNumber();
+    if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+      pushLoopCarried(forOp, resultIdx);
+      continue;
+    }
+    if (auto ifOp = dyn_cast<scf::IfOp>(op)) {
+      worklist.push_back(ifOp.thenYield().getOperand(resultIdx));
+      worklist.push_back(ifOp.elseYield().getOperand(resultIdx));
+      continue;
+    }
+    // pointers computed from other pointers, e.g. by tt.addptr or tt.splat
+    bool derived = false;
+    if (MemoryEffectOpInterface::hasNoEffect(op))
+      for (Value operand : op->getOperands())
+        if (getElementTypeOrSelf(operand.getType())
+                .isa<triton::PointerType>()) {
+          worklist.push_back(operand);
+          derived = true;
+        }
+    if (!derived)
+      return llvm::None;
+  }
+  return roots;
+}
+
+bool mayWriteThroughPointers(Operation *op) {
+  // the ops nested in regions are visited on their own
+  if (op->hasTrait<OpTrait::IsTerminator>() ||
+      op->hasTrait<OpTrait::HasRecursiveSideEffects>())
+    return false;
+  auto memoryEffects = dyn_cast<MemoryEffectOpInterface>(op);
+  if (!memoryEffects)
+    return true;
+  // pointers escape into the results of side-effect free ops that are not
+  // pointers
+  if (memoryEffects.hasNoEffect())
+    return llvm::none_of(op->getResultTypes(), [](Type type) {
+      return getElementTypeOrSelf(type).isa<triton::PointerType>();
+    });
+  return memoryEffects.hasEffect<MemoryEffects::Write>() ||
+         memoryEffects.hasEffect<MemoryEffects::Free>();
+}
+
+llvm::BitVector getReadOnlyArguments(FuncOp funcOp) {
+  llvm::BitVector readOnly(funcOp.getNumArguments());
+  for (BlockArgument arg : funcOp.getArguments())
+    if (arg.getType().isa<triton::PointerType>())
+      readOnly.set(arg.getArgNumber());
+  funcOp.walk([&](Operation *op) {
+    if (readOnly.none() || !mayWriteThroughPointers(op))
+      return;
+    for (Value operand : op->getOperands()) {
+      if (!isGlobalPointer(operand))
+        continue;
+      auto roots = getPointerRoots(operand);
+      if (!roots) {
+        readOnly.reset();
+        return;
+      }
+      for (unsigned root : *roots)
+        readOnly.reset(root);
+    }
+  });
+  return readOnly;
+}
+
+ClusterUniformity::ClusterUniformity(FuncOp funcOp, unsigned numCTAs)
+    : numCTAs(numCTAs) {
+  for (Value arg : funcOp.getArguments())
+    kinds[arg] = Uniform;
+  // Optimistic fixpoint, as the values carried by loops depend on themselves
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    funcOp.walk<WalkOrder::PreOrder>(
+        [&](Operation *op) { changed |= visit(op); });
+  }
+}
+
+bool ClusterUniformity::isUniformControlFlow(Operation *op) const {
+  for (Operation *parentOp = op->getParentOp(); !isa<FuncOp>(parentOp);
+       parentOp = parentOp->getParentOp()) {
+    if (auto forOp = dyn_cast<scf::ForOp>(parentOp)) {
+      if (getAllUniform({forOp.getLowerBound(), forOp.getUpperBound(),
+                         forOp.getStep()}) != Uniform)
+        return false;
+    } else if (auto ifOp = dyn_cast<scf::IfOp>(parentOp)) {
+      if (!isUniform(ifOp.getCondition()))
+        return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+ClusterUniformity::Kind
+ClusterUniformity::getAllUniform(ValueRange values) const {
+  Kind kind = Uniform;
+  for (Value value : values) {
+    Kind valueKind = getKind(value);
+    if (valueKind == Strided || valueKind == Varying)
+      return Varying;
+    if (valueKind == Unknown)
+      kind = Unknown;
+  }
+  return kind;
+}
+
+bool ClusterUniformity::isMultipleOfNumCTAs(Value value) const {
+  APInt intValue;
+  if (matchPattern(value, m_ConstantInt(&intValue)))
+    return intValue.getSExtValue() % numCTAs == 0;
+  if (auto arg = value.dyn_cast<BlockArgument>()) {
+    auto funcOp = dyn_cast<FuncOp>(arg.getOwner()->getParentOp());
+    if (!funcOp || !arg.getOwner()->isEntryBlock())
+      return false;
+    auto divisibility = funcOp.getArgAttrOfType<IntegerAttr>(
+        arg.getArgNumber(), "tt.divisibility");
+    return divisibility && divisibility.getInt() % numCTAs == 0;
+  }
+  Operation *op = value.getDefiningOp();
+  if (isa<arith::MulIOp>(op))
+    return isMultipleOfNumCTAs(op->getOperand(0)) ||
+           isMultipleOfNumCTAs(op->getOperand(1));
+  if (isa<arith::AddIOp, arith::SubIOp>(op))
+    return isMultipleOfNumCTAs(op->getOperand(0)) &&
+           isMultipleOfNumCTAs(op->getOperand(1));
+  return false;
+}
+
+bool ClusterUniformity::update(Value value, Kind kind) {
+  Kind &current = kinds[value];
+  Kind joined = kind;
+  if (current != Unknown && kind != Unknown && current != kind)
+    joined = Varying;
+  else if (kind == Unknown)
+    joined = current;
+  if (joined == current)
+    return false;
+  current = joined;
+  return true;
+}
+
+ClusterUniformity::Kind
+ClusterUniformity::visitArithOp(Operation *op) const {
+  Kind lhs = getKind(op->getOperand(0));
+  Kind rhs = getKind(op->getOperand(1));
+  if (lhs == Unknown || rhs == Unknown)
+    return Unknown;
+  // numCTAs * q + r +- numCTAs * k
+  if (isa<arith::AddIOp>(op) && lhs == Uniform && rhs == Strided &&
+      isMultipleOfNumCTAs(op->getOperand(0)))
+    return Strided;
+  bool uniformMultiple =
+      rhs == Uniform && isMultipleOfNumCTAs(op->getOperand(1));
+  if (lhs == Strided && uniformMultiple) {
+    if (isa<arith::AddIOp, arith::SubIOp>(op))
+      return Strided;
+    // (numCTAs * q + r) / (numCTAs * k) == q / k
+    if (isa<arith::DivSIOp, arith::DivUIOp>(op))
+      return Uniform;
+    // (numCTAs * q + r) % (numCTAs * k) == numCTAs * (q % k) + r
+    if (isa<arith::RemSIOp, arith::RemUIOp>(op))
+      return Strided;
+  }
+  return getAllUniform(op->getOperands());
+}
+
+bool ClusterUniformity::visit(Operation *op) {
+  bool changed = false;
+  if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+    Kind bounds = getAllUniform(
+        {forOp.getLowerBound(), forOp.getUpperBound(), forOp.getStep()});
+    changed |= update(forOp.getInductionVar(), bounds);
+    // the values carried by the loop, from the init values and the previous
+    // iterations
+    Operation *yieldOp = forOp.getBody()->getTerminator();
+    for (unsigned i = 0; i < forOp.getNumIterOperands(); ++i) {
+      for (Value value :
+           {forOp.getIterOperands()[i], yieldOp->getOperand(i)}) {
+        Kind kind = bounds == Varying ? Varying : getKind(value);
+        changed |= update(forOp.getRegionIterArgs()[i], kind);
+        changed |= update(forOp.getResult(i), kind);
+      }
+    }
+    return changed;
+  }
+  if (auto ifOp = dyn_cast<scf::IfOp>(op)) {
+    bool uniformCond = getAllUniform(ifOp.getCondition()) != Varying;
+    for (unsigned i = 0; i < ifOp.getNumResults(); ++i) {
+      Value result = ifOp.getResult(i);
+      if (!uniformCond) {
+        changed |= update(result, Varying);
+        continue;
+      }
+      changed |= update(result, getKind(ifOp.thenYield().getOperand(i)));
+      changed |= update(result, getKind(ifOp.elseYield().getOperand(i)));
+    }
+    return changed;
+  }
+  if (op->getNumResults() == 0)
+    return false;
+
+  Kind kind = Varying;
+  if (auto pidOp = dyn_cast<triton::GetProgramIdOp>(op))
+    kind = pidOp.axis() == 0 && numCTAs > 1 ? Strided : Uniform;
+  else if (isa<arith::AddIOp, arith::SubIOp, arith::DivSIOp, arith::DivUIOp,
+               arith::RemSIOp, arith::RemUIOp>(op))
+    kind = visitArithOp(op);
+  else if (isa<triton::LoadOp>(op) ||
+           MemoryEffectOpInterface::hasNoEffect(op))
+    kind = getAllUniform(op->getOperands());
+  for (Value result : op->getResults())
+    changed |= update(result, kind);
+  return changed;
+}
+
+namespace {
+
+// Offset, in elements, of `coords` in a 2D tile of a shared layout, swizzled
+// as by the lowering
+int64_t getSwizzledOffset(triton::gpu::SharedEncodingAttr layout,
+                          ArrayRef<int64_t> tileShape,
+                          ArrayRef<unsigned> coords) {
+  auto order = layout.getOrder();
+  int64_t inner = coords[order[0]] % tileShape[order[0]];
+  int64_t outer = coords[order[1]] % tileShape[order[1]];
+  if (layout.getMaxPhase() > 1) {
+    unsigned vec = layout.getVec();
+    int64_t phase = outer / layout.getPerPhase() % layout.getMaxPhase();
+    inner = ((inner / vec) ^ phase) * vec + inner % vec;
+  }
+  return outer * tileShape[order[0]] + inner;
+}
+
+} // namespace
+
+unsigned getBankConflictWays(RankedTensorType sharedTy, Attribute layout,
+                             unsigned numBanks) {
+  auto sharedLayout =
+      sharedTy.getEncoding().dyn_cast<triton::gpu::SharedEncodingAttr>();
+  if (!sharedLayout || sharedLayout.getOrder().size() != 2)
+    return 0;
+  auto order = sharedLayout.getOrder();
+  auto tileShape = sharedTy.getShape().take_back(2);
+  Type eltTy = sharedTy.getElementType();
+  unsigned eltBytes = std::max<unsigned>(eltTy.getIntOrFloatBitWidth() / 8, 1);
+
+  // First element accessed by every lane, and number of contiguous elements
+  // of the access
+  SmallVector<SmallVector<unsigned>> laneCoords;
+  unsigned vec = 1;
+  if (auto blockedLayout = layout.dyn_cast<triton::gpu::BlockedEncodingAttr>()) {
+    if (blockedLayout.getOrder().size() != 2)
+      return 0;
+    auto sizePerThread = blockedLayout.getSizePerThread();
+    unsigned inVec = blockedLayout.getOrder()[0] == order[0]
+                         ? sizePerThread[order[0]]
+                         : 1;
+    vec = triton::gpu::getSharedAccessVec(sharedLayout, inVec);
+    unsigned warpSize = product<unsigned>(blockedLayout.getThreadsPerWarp());
+    for (unsigned lane = 0; lane < warpSize; ++lane)
+      laneCoords.push_back(
+          getBlockedCoords(blockedLayout, tileShape, 0, lane, 0));
+  } else if (auto dotOpLayout =
+                 layout.dyn_cast<triton::gpu::DotOperandEncodingAttr>()) {
+    // Lanes l and l + 32 of a wavefront read kPerLane elements along k of
+    // row (resp. column) l % 32, as loaded by MFMAConversionHelper
+    if (!dotOpLayout.getParent().isa<triton::gpu::MfmaEncodingAttr>())
+      return 0;
+    unsigned kDim = dotOpLayout.getOpIdx() == 0 ? 1 : 0;
+    unsigned kPerLane = eltBytes == 4 ? 1 : (eltTy.isBF16() ? 2 : 4);
+    if (order[0] == kDim && (sharedLayout.getMaxPhase() == 1 ||
+                             sharedLayout.getVec() % kPerLane == 0))
+      vec = kPerLane;
+    for (unsigned lane = 0; lane < 64; ++lane) {
+      SmallVector<unsigned> coords(2);
+      coords[kDim] = lane / 32 * kPerLane;
+      coords[1 - kDim] = lane % 32;
+      laneCoords.push_back(coords);
+    }
+  } else {
+    return 0;
+  }
+
+  // A request serves as many lanes as the banks take accesses of accessBytes
+  unsigned accessBytes = std::max(vec * eltBytes, 4u);
+  unsigned lanesPerRequest = std::min<unsigned>(
+      std::max(4 * numBanks / accessBytes, 1u), laneCoords.size());
+  unsigned ways = 1;
+  for (unsigned first = 0; first < laneCoords.size();
+       first += lanesPerRequest) {
+    // distinct 4-byte words served by every bank
+    DenseMap<unsigned, DenseSet<int64_t>> bankWords;
+    for (unsigned lane = first; lane < first + lanesPerRequest; ++lane) {
+      int64_t begin =
+          getSwizzledOffset(sharedLayout, tileShape, laneCoords[lane]) *
+          eltBytes;
+      for (int64_t word = begin / 4; word <= (begin + accessBytes - 1) / 4;
+           ++word)
+        bankWords[word % numBanks].insert(word);
+    }
+    for (auto &it : bankWords)
+      ways = std::max<unsigned>(ways, it.second.size());
+  }
+  return ways;
+}
+
 bool isSingleValue(Value value) {
   // Don't consider load as expensive if it is loading a scalar.
   if (auto tensorTy = value.getType().dyn_cast<RankedTensorType>())
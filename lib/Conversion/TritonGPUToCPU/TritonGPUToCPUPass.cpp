@@ -0,0 +1,1188 @@
+#include "triton/Conversion/TritonGPUToCPU/TritonGPUToCPUPass.h"
+
+#include "mlir/Conversion/ArithmeticToLLVM/ArithmeticToLLVM.h"
+#include "mlir/Conversion/LLVMCommon/Pattern.h"
+#include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Conversion/MathToLLVM/MathToLLVM.h"
+#include "mlir/Conversion/SCFToStandard/SCFToStandard.h"
+#include "mlir/Conversion/StandardToLLVM/ConvertStandardToLLVM.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/DialectConversion.h"
+#include "triton/Analysis/AxisInfo.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "llvm/Support/MathExtras.h"
+#include <numeric>
+
+using namespace mlir;
+using namespace mlir::triton;
+
+#define GEN_PASS_CLASSES
+#include "triton/Conversion/Passes.h.inc"
+
+namespace {
+
+// Tensors are flattened in row-major order to LLVM vectors, whatever their
+// layout: the backend splits them into the SIMD registers of the host.
+// Pointers are in the address space of the host.
+class TritonGPUToCPUTypeConverter : public LLVMTypeConverter {
+public:
+  using TypeConverter::convertType;
+
+  TritonGPUToCPUTypeConverter(MLIRContext *ctx, LowerToLLVMOptions &option)
+      : LLVMTypeConverter(ctx, option) {
+    addConversion([&](triton::PointerType type) -> llvm::Optional<Type> {
+      return LLVM::LLVMPointerType::get(convertType(type.getPointeeType()));
+    });
+    addConversion([&](RankedTensorType type) -> llvm::Optional<Type> {
+      return LLVM::getFixedVectorType(convertType(type.getElementType()),
+                                      type.getNumElements());
+    });
+    // Internally store float8 as int8
+    addConversion([&](triton::Float8Type type) -> llvm::Optional<Type> {
+      return IntegerType::get(type.getContext(), 8);
+    });
+    addConversion([&](triton::Float8E4M3Type type) -> llvm::Optional<Type> {
+      return IntegerType::get(type.getContext(), 8);
+    });
+    addConversion([&](triton::Float8E5M2Type type) -> llvm::Optional<Type> {
+      return IntegerType::get(type.getContext(), 8);
+    });
+  }
+};
+
+class TritonCPUConversionTarget : public ConversionTarget {
+public:
+  explicit TritonCPUConversionTarget(MLIRContext &ctx)
+      : ConversionTarget(ctx) {
+    addLegalDialect<LLVM::LLVMDialect>();
+    addIllegalDialect<triton::TritonDialect>();
+    addIllegalDialect<triton::gpu::TritonGPUDialect>();
+    addIllegalDialect<mlir::gpu::GPUDialect>();
+    addIllegalDialect<mlir::StandardOpsDialect>();
+    addIllegalDialect<arith::ArithmeticDialect>();
+    addIllegalDialect<math::MathDialect>();
+    addLegalOp<mlir::UnrealizedConversionCastOp>();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Helpers
+//===----------------------------------------------------------------------===//
+
+int64_t getNumElements(Type type) {
+  if (auto tensorTy = type.dyn_cast<RankedTensorType>())
+    return tensorTy.getNumElements();
+  return 1;
+}
+
+SmallVector<int64_t> delinearize(int64_t index, ArrayRef<int64_t> shape) {
+  SmallVector<int64_t> coords(shape.size());
+  for (int d = shape.size() - 1; d >= 0; --d) {
+    coords[d] = index % shape[d];
+    index /= shape[d];
+  }
+  return coords;
+}
+
+int64_t linearize(ArrayRef<int64_t> coords, ArrayRef<int64_t> shape) {
+  int64_t index = 0;
+  for (size_t d = 0; d < shape.size(); ++d)
+    index = index * shape[d] + coords[d];
+  return index;
+}
+
+Value i32Val(OpBuilder &b, Location loc, int32_t value) {
+  return b.create<LLVM::ConstantOp>(loc, b.getI32Type(),
+                                    b.getI32IntegerAttr(value));
+}
+
+// The scalar or vector constant of \p type whose elements are \p value
+Value constant(OpBuilder &b, Location loc, Type type, int64_t value) {
+  Type elemTy = LLVM::isCompatibleVectorType(type)
+                    ? LLVM::getVectorElementType(type)
+                    : type;
+  Attribute attr = elemTy.isa<FloatType>()
+                       ? b.getFloatAttr(elemTy, value).cast<Attribute>()
+                       : b.getIntegerAttr(elemTy, value).cast<Attribute>();
+  if (auto vecTy = type.dyn_cast<VectorType>())
+    attr = DenseElementsAttr::get(vecTy, llvm::makeArrayRef(attr));
+  return b.create<LLVM::ConstantOp>(loc, type, attr);
+}
+
+Value extractElement(OpBuilder &b, Location loc, Value vec, int64_t i) {
+  Type elemTy = LLVM::getVectorElementType(vec.getType());
+  return b.create<LLVM::ExtractElementOp>(loc, elemTy, vec, i32Val(b, loc, i));
+}
+
+Value insertElement(OpBuilder &b, Location loc, Value vec, Value elem,
+                    int64_t i) {
+  return b.create<LLVM::InsertElementOp>(loc, vec.getType(), vec, elem,
+                                         i32Val(b, loc, i));
+}
+
+// The elements of \p lhs followed by those of \p rhs, picked by \p mask
+Value shuffle(OpBuilder &b, Location loc, Value lhs, Value rhs,
+              ArrayRef<int32_t> mask) {
+  return b.create<LLVM::ShuffleVectorOp>(loc, lhs, rhs,
+                                         b.getI32ArrayAttr(mask));
+}
+
+Value shuffle(OpBuilder &b, Location loc, Value vec, ArrayRef<int32_t> mask) {
+  return shuffle(b, loc, vec, vec, mask);
+}
+
+Value splat(OpBuilder &b, Location loc, Value scalar, int64_t n) {
+  Type vecTy = LLVM::getFixedVectorType(scalar.getType(), n);
+  Value vec = b.create<LLVM::UndefOp>(loc, vecTy);
+  vec = insertElement(b, loc, vec, scalar, 0);
+  return shuffle(b, loc, vec, SmallVector<int32_t>(n, 0));
+}
+
+// The \p n elements of \p vec from \p start
+Value slice(OpBuilder &b, Location loc, Value vec, int64_t start, int64_t n) {
+  SmallVector<int32_t> mask(n);
+  std::iota(mask.begin(), mask.end(), start);
+  return shuffle(b, loc, vec, mask);
+}
+
+// The concatenation of a power of 2 of vectors of the same type
+Value concat(OpBuilder &b, Location loc, SmallVector<Value> parts) {
+  while (parts.size() > 1) {
+    int64_t n = LLVM::getVectorNumElements(parts[0].getType()).getFixedValue();
+    SmallVector<int32_t> mask(2 * n);
+    std::iota(mask.begin(), mask.end(), 0);
+    SmallVector<Value> merged;
+    for (size_t i = 0; i < parts.size(); i += 2)
+      merged.push_back(shuffle(b, loc, parts[i], parts[i + 1], mask));
+    parts = std::move(merged);
+  }
+  return parts[0];
+}
+
+// A stack buffer of \p type, allocated in the entry block of the function so
+// that the loops around \p op don't grow the stack
+Value allocaAtEntry(ConversionPatternRewriter &rewriter, Operation *op,
+                    Type type) {
+  OpBuilder::InsertionGuard guard(rewriter);
+  auto funcOp = op->getParentOfType<LLVM::LLVMFuncOp>();
+  rewriter.setInsertionPointToStart(&funcOp.getBody().front());
+  Location loc = op->getLoc();
+  return rewriter.create<LLVM::AllocaOp>(loc, LLVM::LLVMPointerType::get(type),
+                                         i32Val(rewriter, loc, 1),
+                                         /*alignment=*/64);
+}
+
+// Emits the value built by \p build when \p pred is true, and undef
+// otherwise, in a block of its own if \p pred is set
+Value emitPredicated(ConversionPatternRewriter &rewriter, Location loc,
+                     Value pred, Type type, function_ref<Value()> build) {
+  if (!pred)
+    return build();
+  auto *curBlock = rewriter.getInsertionBlock();
+  auto *endBlock = curBlock->splitBlock(rewriter.getInsertionPoint());
+  auto *thenBlock = rewriter.createBlock(endBlock);
+  endBlock->addArgument(type, loc);
+
+  rewriter.setInsertionPointToEnd(curBlock);
+  Value undef = rewriter.create<LLVM::UndefOp>(loc, type);
+  rewriter.create<LLVM::CondBrOp>(loc, pred, thenBlock, ValueRange{},
+                                  endBlock, ValueRange{undef});
+
+  rewriter.setInsertionPointToEnd(thenBlock);
+  rewriter.create<LLVM::BrOp>(loc, ValueRange{build()}, endBlock);
+
+  rewriter.setInsertionPointToStart(endBlock);
+  return endBlock->getArgument(0);
+}
+
+unsigned getElemBytes(Type type) {
+  if (type.isIntOrFloat())
+    return std::max<unsigned>(1, type.getIntOrFloatBitWidth() / 8);
+  return 8;
+}
+
+//===----------------------------------------------------------------------===//
+// Shape manipulation
+//===----------------------------------------------------------------------===//
+
+struct MakeRangeOpConversion
+    : public ConvertOpToLLVMPattern<triton::MakeRangeOp> {
+  using ConvertOpToLLVMPattern<triton::MakeRangeOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::MakeRangeOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto vecTy =
+        getTypeConverter()->convertType(op.getType()).cast<VectorType>();
+    SmallVector<int32_t> values(vecTy.getNumElements());
+    std::iota(values.begin(), values.end(), op.start());
+    rewriter.replaceOpWithNewOp<LLVM::ConstantOp>(
+        op, vecTy, DenseElementsAttr::get(vecTy, llvm::makeArrayRef(values)));
+    return success();
+  }
+};
+
+// Dense tensor constants are reshaped to their vectors, which the
+// ArithmeticToLLVM patterns only do for splats
+struct ConstantOpConversion : public ConvertOpToLLVMPattern<arith::ConstantOp> {
+  using ConvertOpToLLVMPattern<arith::ConstantOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(arith::ConstantOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto value = op.getValue().dyn_cast<DenseElementsAttr>();
+    if (!value || !op.getType().isa<RankedTensorType>())
+      return failure();
+    auto vecTy = getTypeConverter()->convertType(op.getType());
+    if (!vecTy.isa<VectorType>() ||
+        vecTy.cast<VectorType>().getElementType() != value.getElementType())
+      return failure();
+    rewriter.replaceOpWithNewOp<LLVM::ConstantOp>(
+        op, vecTy, value.reshape(vecTy.cast<ShapedType>()));
+    return success();
+  }
+};
+
+struct SplatOpConversion : public ConvertOpToLLVMPattern<triton::SplatOp> {
+  using ConvertOpToLLVMPattern<triton::SplatOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::SplatOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOp(op, splat(rewriter, op.getLoc(), adaptor.src(),
+                                 getNumElements(op.getType())));
+    return success();
+  }
+};
+
+// Ops that keep the elements of their operand in row-major order
+template <typename SourceOp>
+struct IdentityOpConversion : public ConvertOpToLLVMPattern<SourceOp> {
+  using ConvertOpToLLVMPattern<SourceOp>::ConvertOpToLLVMPattern;
+  using OpAdaptor = typename SourceOp::Adaptor;
+
+  LogicalResult
+  matchAndRewrite(SourceOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOp(op, adaptor.getOperands()[0]);
+    return success();
+  }
+};
+
+struct BroadcastOpConversion
+    : public ConvertOpToLLVMPattern<triton::BroadcastOp> {
+  using ConvertOpToLLVMPattern<triton::BroadcastOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::BroadcastOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto dstTy = op.getType().cast<RankedTensorType>();
+    auto srcTy = op.src().getType().dyn_cast<RankedTensorType>();
+    if (!srcTy) {
+      rewriter.replaceOp(
+          op, splat(rewriter, loc, adaptor.src(), dstTy.getNumElements()));
+      return success();
+    }
+    auto srcShape = srcTy.getShape();
+    SmallVector<int32_t> mask(dstTy.getNumElements());
+    for (int64_t i = 0; i < dstTy.getNumElements(); ++i) {
+      auto coords = delinearize(i, dstTy.getShape());
+      for (size_t d = 0; d < coords.size(); ++d)
+        if (srcShape[d] == 1)
+          coords[d] = 0;
+      mask[i] = linearize(coords, srcShape);
+    }
+    rewriter.replaceOp(op, shuffle(rewriter, loc, adaptor.src(), mask));
+    return success();
+  }
+};
+
+struct TransOpConversion : public ConvertOpToLLVMPattern<triton::TransOp> {
+  using ConvertOpToLLVMPattern<triton::TransOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::TransOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto srcShape = op.src().getType().cast<RankedTensorType>().getShape();
+    auto dstShape = op.getType().cast<RankedTensorType>().getShape();
+    SmallVector<int32_t> mask(op.getType().cast<RankedTensorType>()
+                                  .getNumElements());
+    for (size_t i = 0; i < mask.size(); ++i) {
+      auto coords = delinearize(i, dstShape);
+      std::reverse(coords.begin(), coords.end());
+      mask[i] = linearize(coords, srcShape);
+    }
+    rewriter.replaceOp(op, shuffle(rewriter, op.getLoc(), adaptor.src(),
+                                   mask));
+    return success();
+  }
+};
+
+struct CatOpConversion : public ConvertOpToLLVMPattern<triton::CatOp> {
+  using ConvertOpToLLVMPattern<triton::CatOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::CatOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (adaptor.lhs().getType() != adaptor.rhs().getType())
+      return failure();
+    auto srcShape = op.lhs().getType().cast<RankedTensorType>().getShape();
+    auto dstShape = op.getType().cast<RankedTensorType>().getShape();
+    int64_t n = getNumElements(op.lhs().getType());
+    SmallVector<int32_t> mask(2 * n);
+    std::iota(mask.begin(), mask.end(), 0);
+    // along an axis, the elements of rhs follow those of lhs in each of the
+    // slices across it
+    if (auto axis = op.axis()) {
+      for (int64_t i = 0; i < 2 * n; ++i) {
+        auto coords = delinearize(i, dstShape);
+        bool isRhs = coords[*axis] >= srcShape[*axis];
+        if (isRhs)
+          coords[*axis] -= srcShape[*axis];
+        mask[i] = linearize(coords, srcShape) + (isRhs ? n : 0);
+      }
+    }
+    rewriter.replaceOp(op, shuffle(rewriter, op.getLoc(), adaptor.lhs(),
+                                   adaptor.rhs(), mask));
+    return success();
+  }
+};
+
+struct JoinOpConversion : public ConvertOpToLLVMPattern<triton::JoinOp> {
+  using ConvertOpToLLVMPattern<triton::JoinOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::JoinOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    int64_t n = getNumElements(op.lhs().getType());
+    SmallVector<int32_t> mask(2 * n);
+    for (int64_t i = 0; i < n; ++i) {
+      mask[2 * i] = i;
+      mask[2 * i + 1] = n + i;
+    }
+    rewriter.replaceOp(op, shuffle(rewriter, op.getLoc(), adaptor.lhs(),
+                                   adaptor.rhs(), mask));
+    return success();
+  }
+};
+
+struct SplitOpConversion : public ConvertOpToLLVMPattern<triton::SplitOp> {
+  using ConvertOpToLLVMPattern<triton::SplitOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::SplitOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    int64_t n = getNumElements(op.outLHS().getType());
+    SmallVector<int32_t> lhsMask(n), rhsMask(n);
+    for (int64_t i = 0; i < n; ++i) {
+      lhsMask[i] = 2 * i;
+      rhsMask[i] = 2 * i + 1;
+    }
+    rewriter.replaceOp(op, {shuffle(rewriter, loc, adaptor.src(), lhsMask),
+                            shuffle(rewriter, loc, adaptor.src(), rhsMask)});
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Elementwise
+//===----------------------------------------------------------------------===//
+
+// Ops with an LLVM counterpart taking the same operands
+template <typename SourceOp, typename DestOp>
+struct ElementwiseOpConversion : public ConvertOpToLLVMPattern<SourceOp> {
+  using ConvertOpToLLVMPattern<SourceOp>::ConvertOpToLLVMPattern;
+  using OpAdaptor = typename SourceOp::Adaptor;
+
+  LogicalResult
+  matchAndRewrite(SourceOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Type resTy = this->getTypeConverter()->convertType(op.getType());
+    rewriter.replaceOpWithNewOp<DestOp>(op, resTy, adaptor.getOperands());
+    return success();
+  }
+};
+
+struct AddPtrOpConversion : public ConvertOpToLLVMPattern<triton::AddPtrOp> {
+  using ConvertOpToLLVMPattern<triton::AddPtrOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::AddPtrOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Type resTy = getTypeConverter()->convertType(op.getType());
+    rewriter.replaceOpWithNewOp<LLVM::GEPOp>(op, resTy, adaptor.ptr(),
+                                             ValueRange{adaptor.offset()});
+    return success();
+  }
+};
+
+// The arith and LLVM predicates are in the same order
+struct CmpIOpConversion
+    : public ConvertOpToLLVMPattern<triton::gpu::CmpIOp> {
+  using ConvertOpToLLVMPattern<triton::gpu::CmpIOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::gpu::CmpIOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOpWithNewOp<LLVM::ICmpOp>(
+        op, getTypeConverter()->convertType(op.getType()),
+        static_cast<LLVM::ICmpPredicate>(op.predicate()), adaptor.lhs(),
+        adaptor.rhs());
+    return success();
+  }
+};
+
+struct CmpFOpConversion
+    : public ConvertOpToLLVMPattern<triton::gpu::CmpFOp> {
+  using ConvertOpToLLVMPattern<triton::gpu::CmpFOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::gpu::CmpFOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOpWithNewOp<LLVM::FCmpOp>(
+        op, getTypeConverter()->convertType(op.getType()),
+        static_cast<LLVM::FCmpPredicate>(op.predicate()), adaptor.lhs(),
+        adaptor.rhs());
+    return success();
+  }
+};
+
+// The rounds of `philox_impl` in random.py, on the vectors of counters
+struct PhiloxOpConversion : public ConvertOpToLLVMPattern<triton::PhiloxOp> {
+  using ConvertOpToLLVMPattern<triton::PhiloxOp>::ConvertOpToLLVMPattern;
+
+  static constexpr uint32_t kKeyA = 0x9E3779B9;
+  static constexpr uint32_t kKeyB = 0xBB67AE85;
+  static constexpr uint32_t kRoundA = 0xD2511F53;
+  static constexpr uint32_t kRoundB = 0xCD9E8D57;
+
+  LogicalResult
+  matchAndRewrite(triton::PhiloxOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    Type ty = adaptor.c0().getType();
+    Type wideTy = rewriter.getI64Type();
+    if (LLVM::isCompatibleVectorType(ty))
+      wideTy = LLVM::getFixedVectorType(
+          wideTy, LLVM::getVectorNumElements(ty).getFixedValue());
+    // The high and low halves of the 64 bit product of a and b
+    auto mulWide = [&](uint32_t a, Value b) -> std::pair<Value, Value> {
+      Value prod = rewriter.create<LLVM::MulOp>(
+          loc, wideTy, constant(rewriter, loc, wideTy, a),
+          rewriter.create<LLVM::ZExtOp>(loc, wideTy, b));
+      Value hi = rewriter.create<LLVM::LShrOp>(
+          loc, wideTy, prod, constant(rewriter, loc, wideTy, 32));
+      return {rewriter.create<LLVM::TruncOp>(loc, ty, hi),
+              rewriter.create<LLVM::TruncOp>(loc, ty, prod)};
+    };
+    auto xor_ = [&](Value a, Value b) -> Value {
+      return rewriter.create<LLVM::XOrOp>(loc, a, b);
+    };
+    SmallVector<Value, 4> c = {adaptor.c0(), adaptor.c1(), adaptor.c2(),
+                               adaptor.c3()};
+    Value k0 = adaptor.k0(), k1 = adaptor.k1();
+    unsigned nRounds = op.n_rounds();
+    for (unsigned round = 0; round < nRounds; ++round) {
+      auto [hiB, loB] = mulWide(kRoundB, c[2]);
+      auto [hiA, loA] = mulWide(kRoundA, c[0]);
+      c = {xor_(xor_(hiB, c[1]), k0), loB, xor_(xor_(hiA, c[3]), k1), loA};
+      if (round + 1 < nRounds) {
+        k0 = rewriter.create<LLVM::AddOp>(
+            loc, k0, constant(rewriter, loc, ty, kKeyA));
+        k1 = rewriter.create<LLVM::AddOp>(
+            loc, k1, constant(rewriter, loc, ty, kKeyB));
+      }
+    }
+    rewriter.replaceOp(op, c);
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Memory
+//===----------------------------------------------------------------------===//
+
+// Loads and stores are split into masked accesses of the runs of consecutive
+// elements along the last dimension, which AxisInfoAnalysis proves contiguous,
+// and are gathered or scattered otherwise
+struct MemAccessConversionBase {
+  explicit MemAccessConversionBase(AxisInfoAnalysis &axisInfoAnalysis)
+      : axisInfoAnalysis(axisInfoAnalysis) {}
+
+  // The number of consecutive elements of the runs of \p ptr
+  unsigned getVectorWidth(Value ptr) const {
+    auto tensorTy = ptr.getType().dyn_cast<RankedTensorType>();
+    if (!tensorTy)
+      return 1;
+    auto *lattice = axisInfoAnalysis.lookupLatticeElement(ptr);
+    if (!lattice || lattice->getValue().getRank() != tensorTy.getRank())
+      return 1;
+    int last = tensorTy.getRank() - 1;
+    int64_t contiguity = lattice->getValue().getContiguity(last);
+    // the runs of a power of 2 of elements tile those of the analysis
+    int64_t vec = std::min<int64_t>(contiguity & -contiguity,
+                                    tensorTy.getShape()[last]);
+    int64_t numRuns = tensorTy.getNumElements() / vec;
+    if (vec <= 1 || tensorTy.getNumElements() % vec ||
+        !llvm::isPowerOf2_64(numRuns))
+      return 1;
+    return vec;
+  }
+
+  // The alignment in bytes of the runs of \p vec elements of \p ptr
+  unsigned getAlignment(Value ptr, unsigned vec) const {
+    Type elemTy = getElementTypeOrSelf(ptr.getType())
+                      .cast<triton::PointerType>()
+                      .getPointeeType();
+    unsigned elemBytes = getElemBytes(elemTy);
+    auto tensorTy = ptr.getType().dyn_cast<RankedTensorType>();
+    if (vec == 1 || !tensorTy)
+      return elemBytes;
+    const AxisInfo &info =
+        axisInfoAnalysis.lookupLatticeElement(ptr)->getValue();
+    int64_t divisibility = info.getDivisibility(tensorTy.getRank() - 1);
+    int64_t alignment = std::min<int64_t>(divisibility & -divisibility,
+                                          vec * elemBytes);
+    return std::max<int64_t>(alignment, elemBytes);
+  }
+
+  static Value allTrue(OpBuilder &b, Location loc, int64_t n) {
+    return constant(b, loc, LLVM::getFixedVectorType(b.getI1Type(), n), 1);
+  }
+
+  // The pointer to the run of \p vec elements of \p ptrs from \p i
+  static Value getRunPtr(OpBuilder &b, Location loc, Value ptrs, int64_t i,
+                         unsigned vec) {
+    Value ptr = extractElement(b, loc, ptrs, i);
+    auto elemTy = ptr.getType().cast<LLVM::LLVMPointerType>().getElementType();
+    Type runTy = LLVM::getFixedVectorType(elemTy, vec);
+    return b.create<LLVM::BitcastOp>(loc, LLVM::LLVMPointerType::get(runTy),
+                                     ptr);
+  }
+
+  AxisInfoAnalysis &axisInfoAnalysis;
+};
+
+struct LoadOpConversion : public ConvertOpToLLVMPattern<triton::LoadOp>,
+                          public MemAccessConversionBase {
+  LoadOpConversion(LLVMTypeConverter &converter,
+                   AxisInfoAnalysis &axisInfoAnalysis, PatternBenefit benefit)
+      : ConvertOpToLLVMPattern<triton::LoadOp>(converter, benefit),
+        MemAccessConversionBase(axisInfoAnalysis) {}
+
+  LogicalResult
+  matchAndRewrite(triton::LoadOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    bool isTensor = op.getType().isa<RankedTensorType>();
+    Value ptrs = adaptor.ptr();
+    Value mask = adaptor.mask();
+    Value other = adaptor.other();
+    if (!isTensor && !mask) {
+      rewriter.replaceOpWithNewOp<LLVM::LoadOp>(op, ptrs);
+      return success();
+    }
+    // scalars are accessed as vectors of 1 element
+    int64_t n = getNumElements(op.getType());
+    Type elemTy = getTypeConverter()->convertType(
+        getElementTypeOrSelf(op.getType()));
+    Type vecTy = LLVM::getFixedVectorType(elemTy, n);
+    if (!isTensor) {
+      ptrs = splat(rewriter, loc, ptrs, 1);
+      mask = splat(rewriter, loc, mask, 1);
+      if (other)
+        other = splat(rewriter, loc, other, 1);
+    }
+    if (!mask)
+      mask = allTrue(rewriter, loc, n);
+    if (!other)
+      other = rewriter.create<LLVM::UndefOp>(loc, vecTy);
+
+    unsigned vec = getVectorWidth(op.ptr());
+    IntegerAttr alignment =
+        rewriter.getI32IntegerAttr(getAlignment(op.ptr(), vec));
+    Value result;
+    if (vec == 1) {
+      result = rewriter.create<LLVM::masked_gather>(
+          loc, vecTy, ptrs, mask, ValueRange{other}, alignment);
+    } else {
+      Type runTy = LLVM::getFixedVectorType(elemTy, vec);
+      SmallVector<Value> runs;
+      for (int64_t i = 0; i < n; i += vec)
+        runs.push_back(rewriter.create<LLVM::MaskedLoadOp>(
+            loc, runTy, getRunPtr(rewriter, loc, ptrs, i, vec),
+            slice(rewriter, loc, mask, i, vec),
+            ValueRange{slice(rewriter, loc, other, i, vec)}, alignment));
+      result = concat(rewriter, loc, runs);
+    }
+    if (!isTensor)
+      result = extractElement(rewriter, loc, result, 0);
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+};
+
+struct StoreOpConversion : public ConvertOpToLLVMPattern<triton::StoreOp>,
+                           public MemAccessConversionBase {
+  StoreOpConversion(LLVMTypeConverter &converter,
+                    AxisInfoAnalysis &axisInfoAnalysis,
+                    PatternBenefit benefit)
+      : ConvertOpToLLVMPattern<triton::StoreOp>(converter, benefit),
+        MemAccessConversionBase(axisInfoAnalysis) {}
+
+  LogicalResult
+  matchAndRewrite(triton::StoreOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    bool isTensor = op.value().getType().isa<RankedTensorType>();
+    Value ptrs = adaptor.ptr();
+    Value value = adaptor.value();
+    Value mask = adaptor.mask();
+    if (!isTensor && !mask) {
+      rewriter.replaceOpWithNewOp<LLVM::StoreOp>(op, value, ptrs);
+      return success();
+    }
+    int64_t n = getNumElements(op.value().getType());
+    if (!isTensor) {
+      ptrs = splat(rewriter, loc, ptrs, 1);
+      value = splat(rewriter, loc, value, 1);
+      mask = splat(rewriter, loc, mask, 1);
+    }
+    if (!mask)
+      mask = allTrue(rewriter, loc, n);
+
+    unsigned vec = getVectorWidth(op.ptr());
+    IntegerAttr alignment =
+        rewriter.getI32IntegerAttr(getAlignment(op.ptr(), vec));
+    if (vec == 1) {
+      rewriter.create<LLVM::masked_scatter>(loc, value, ptrs, mask,
+                                            alignment);
+    } else {
+      for (int64_t i = 0; i < n; i += vec)
+        rewriter.create<LLVM::MaskedStoreOp>(
+            loc, slice(rewriter, loc, value, i, vec),
+            getRunPtr(rewriter, loc, ptrs, i, vec),
+            slice(rewriter, loc, mask, i, vec), alignment);
+    }
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+LLVM::AtomicOrdering getAtomicOrdering(Optional<MemSemantic> sem,
+                                       LLVM::AtomicOrdering defaultOrdering) {
+  if (!sem)
+    return defaultOrdering;
+  switch (*sem) {
+  case MemSemantic::RELAXED:
+    return LLVM::AtomicOrdering::monotonic;
+  case MemSemantic::ACQUIRE:
+    return LLVM::AtomicOrdering::acquire;
+  case MemSemantic::RELEASE:
+    return LLVM::AtomicOrdering::release;
+  case MemSemantic::ACQUIRE_RELEASE:
+    return LLVM::AtomicOrdering::acq_rel;
+  }
+  llvm_unreachable("Invalid MemSemantic");
+}
+
+Optional<LLVM::AtomicBinOp> matchAtomicOp(RMWOp atomicOp) {
+  switch (atomicOp) {
+  case RMWOp::AND:
+    return LLVM::AtomicBinOp::_and;
+  case RMWOp::OR:
+    return LLVM::AtomicBinOp::_or;
+  case RMWOp::XOR:
+    return LLVM::AtomicBinOp::_xor;
+  case RMWOp::ADD:
+    return LLVM::AtomicBinOp::add;
+  case RMWOp::FADD:
+    return LLVM::AtomicBinOp::fadd;
+  case RMWOp::MAX:
+    return LLVM::AtomicBinOp::max;
+  case RMWOp::MIN:
+    return LLVM::AtomicBinOp::min;
+  case RMWOp::UMAX:
+    return LLVM::AtomicBinOp::umax;
+  case RMWOp::UMIN:
+    return LLVM::AtomicBinOp::umin;
+  case RMWOp::XCHG:
+    return LLVM::AtomicBinOp::xchg;
+  }
+  return llvm::None;
+}
+
+// Atomics are issued one element at a time, those of masked off elements
+// being skipped
+struct AtomicRMWOpConversion
+    : public ConvertOpToLLVMPattern<triton::AtomicRMWOp> {
+  using ConvertOpToLLVMPattern<triton::AtomicRMWOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::AtomicRMWOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto binOp = matchAtomicOp(op.atomic_rmw_op());
+    if (!binOp)
+      return failure();
+    auto ordering =
+        getAtomicOrdering(op.sem(), LLVM::AtomicOrdering::monotonic);
+    bool isTensor = op.getType().isa<RankedTensorType>();
+    Type resTy = getTypeConverter()->convertType(op.getType());
+    Type elemTy = getTypeConverter()->convertType(
+        getElementTypeOrSelf(op.getType()));
+    Value result = isTensor ? rewriter.create<LLVM::UndefOp>(loc, resTy)
+                            : Value();
+    for (int64_t i = 0; i < getNumElements(op.getType()); ++i) {
+      auto elementOf = [&](Value value) -> Value {
+        if (!value || !isTensor)
+          return value;
+        return extractElement(rewriter, loc, value, i);
+      };
+      Value ptr = elementOf(adaptor.ptr());
+      Value val = elementOf(adaptor.val());
+      Value old = emitPredicated(
+          rewriter, loc, elementOf(adaptor.mask()), elemTy, [&]() -> Value {
+            return rewriter.create<LLVM::AtomicRMWOp>(loc, elemTy, *binOp,
+                                                      ptr, val, ordering);
+          });
+      result = isTensor ? insertElement(rewriter, loc, result, old, i) : old;
+    }
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+};
+
+struct AtomicCASOpConversion
+    : public ConvertOpToLLVMPattern<triton::AtomicCASOp> {
+  using ConvertOpToLLVMPattern<triton::AtomicCASOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::AtomicCASOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto successOrdering =
+        getAtomicOrdering(op.sem(), LLVM::AtomicOrdering::acq_rel);
+    // a failed cmpxchg does not store, so it can only acquire
+    auto failureOrdering = LLVM::AtomicOrdering::monotonic;
+    if (op.sem() == MemSemantic::ACQUIRE ||
+        op.sem() == MemSemantic::ACQUIRE_RELEASE || !op.sem())
+      failureOrdering = LLVM::AtomicOrdering::acquire;
+    bool isTensor = op.getType().isa<RankedTensorType>();
+    Type resTy = getTypeConverter()->convertType(op.getType());
+    Type elemTy = getTypeConverter()->convertType(
+        getElementTypeOrSelf(op.getType()));
+    auto pairTy = LLVM::LLVMStructType::getLiteral(
+        rewriter.getContext(), {elemTy, rewriter.getI1Type()});
+    Value result = isTensor ? rewriter.create<LLVM::UndefOp>(loc, resTy)
+                            : Value();
+    for (int64_t i = 0; i < getNumElements(op.getType()); ++i) {
+      auto elementOf = [&](Value value) -> Value {
+        return isTensor ? extractElement(rewriter, loc, value, i) : value;
+      };
+      auto cmpxchg = rewriter.create<LLVM::AtomicCmpXchgOp>(
+          loc, pairTy, elementOf(adaptor.ptr()), elementOf(adaptor.cmp()),
+          elementOf(adaptor.val()), successOrdering, failureOrdering);
+      Value old = rewriter.create<LLVM::ExtractValueOp>(
+          loc, elemTy, cmpxchg, rewriter.getI64ArrayAttr({0}));
+      result = isTensor ? insertElement(rewriter, loc, result, old, i) : old;
+    }
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+};
+
+// Scratch buffers are private to the program, i.e. to its thread
+struct ScratchOpConversion : public ConvertOpToLLVMPattern<triton::ScratchOp> {
+  using ConvertOpToLLVMPattern<triton::ScratchOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::ScratchOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto ptrTy = getTypeConverter()
+                     ->convertType(op.getType())
+                     .cast<LLVM::LLVMPointerType>();
+    Value buffer = allocaAtEntry(
+        rewriter, op,
+        LLVM::LLVMArrayType::get(ptrTy.getElementType(), op.size()));
+    rewriter.replaceOpWithNewOp<LLVM::BitcastOp>(op, ptrTy, buffer);
+    return success();
+  }
+};
+
+// The threads of the programs are independent, and a program only has one
+struct BarrierOpConversion : public ConvertOpToLLVMPattern<gpu::BarrierOp> {
+  using ConvertOpToLLVMPattern<gpu::BarrierOp>::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(gpu::BarrierOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Dot and reductions
+//===----------------------------------------------------------------------===//
+
+// The product of a MxK and a KxN matrix is accumulated by a loop over k of
+// outer products: the column k of a times the row k of b, broadcast to MxN
+// vectors and fused into the accumulator. The columns of a, i.e. the rows of
+// its transpose, and the rows of b are loaded from stack buffers one at a
+// time, which keeps the body of the loop small.
+struct DotOpConversion : public ConvertOpToLLVMPattern<triton::DotOp> {
+  using ConvertOpToLLVMPattern<triton::DotOp>::ConvertOpToLLVMPattern;
+
+  // The elements of \p vec converted to the element type of the accumulator
+  static Value extend(ConversionPatternRewriter &rewriter, Location loc,
+                      Value vec, Type elemTy) {
+    Type srcElemTy = LLVM::getVectorElementType(vec.getType());
+    if (srcElemTy == elemTy)
+      return vec;
+    Type vecTy = LLVM::getFixedVectorType(
+        elemTy, LLVM::getVectorNumElements(vec.getType()).getFixedValue());
+    if (elemTy.isa<FloatType>())
+      return rewriter.create<LLVM::FPExtOp>(loc, vecTy, vec);
+    return rewriter.create<LLVM::SExtOp>(loc, vecTy, vec);
+  }
+
+  LogicalResult
+  matchAndRewrite(triton::DotOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto aTy = op.a().getType().cast<RankedTensorType>();
+    auto bTy = op.b().getType().cast<RankedTensorType>();
+    if (aTy.getRank() != 2 || op.aFp8Format() || op.bFp8Format())
+      return failure();
+    int64_t M = aTy.getShape()[0], K = aTy.getShape()[1];
+    int64_t N = bTy.getShape()[1];
+    Type accTy = getTypeConverter()->convertType(op.getType());
+    Type elemTy = LLVM::getVectorElementType(accTy);
+    Value a = extend(rewriter, loc, adaptor.a(), elemTy);
+    Value b = extend(rewriter, loc, adaptor.b(), elemTy);
+
+    SmallVector<int32_t> transMask(M * K);
+    for (int64_t k = 0; k < K; ++k)
+      for (int64_t m = 0; m < M; ++m)
+        transMask[k * M + m] = m * K + k;
+    Value aTrans = shuffle(rewriter, loc, a, transMask);
+    Value aBuffer = allocaAtEntry(rewriter, op, aTrans.getType());
+    Value bBuffer = allocaAtEntry(rewriter, op, b.getType());
+    rewriter.create<LLVM::StoreOp>(loc, aTrans, aBuffer);
+    rewriter.create<LLVM::StoreOp>(loc, b, bBuffer);
+    auto colPtrTy =
+        LLVM::LLVMPointerType::get(LLVM::getFixedVectorType(elemTy, M));
+    auto rowPtrTy =
+        LLVM::LLVMPointerType::get(LLVM::getFixedVectorType(elemTy, N));
+    Value cols = rewriter.create<LLVM::BitcastOp>(loc, colPtrTy, aBuffer);
+    Value rows = rewriter.create<LLVM::BitcastOp>(loc, rowPtrTy, bBuffer);
+
+    auto *curBlock = rewriter.getInsertionBlock();
+    auto *endBlock = curBlock->splitBlock(rewriter.getInsertionPoint());
+    auto *bodyBlock = rewriter.createBlock(
+        endBlock, {rewriter.getI32Type(), accTy}, {loc, loc});
+    endBlock->addArgument(accTy, loc);
+
+    rewriter.setInsertionPointToEnd(curBlock);
+    rewriter.create<LLVM::BrOp>(
+        loc, ValueRange{i32Val(rewriter, loc, 0), adaptor.c()}, bodyBlock);
+
+    rewriter.setInsertionPointToEnd(bodyBlock);
+    Value k = bodyBlock->getArgument(0);
+    Value acc = bodyBlock->getArgument(1);
+    Value col = rewriter.create<LLVM::LoadOp>(
+        loc, rewriter.create<LLVM::GEPOp>(loc, colPtrTy, cols, ValueRange{k}));
+    Value row = rewriter.create<LLVM::LoadOp>(
+        loc, rewriter.create<LLVM::GEPOp>(loc, rowPtrTy, rows, ValueRange{k}));
+    SmallVector<int32_t> colMask(M * N), rowMask(M * N);
+    for (int64_t m = 0; m < M; ++m)
+      for (int64_t n = 0; n < N; ++n) {
+        colMask[m * N + n] = m;
+        rowMask[m * N + n] = n;
+      }
+    Value lhs = shuffle(rewriter, loc, col, colMask);
+    Value rhs = shuffle(rewriter, loc, row, rowMask);
+    Value next;
+    if (elemTy.isa<FloatType>())
+      next = rewriter.create<LLVM::FMulAddOp>(loc, accTy, lhs, rhs, acc);
+    else
+      next = rewriter.create<LLVM::AddOp>(
+          loc, rewriter.create<LLVM::MulOp>(loc, lhs, rhs), acc);
+    Value nextK =
+        rewriter.create<LLVM::AddOp>(loc, k, i32Val(rewriter, loc, 1));
+    Value done = rewriter.create<LLVM::ICmpOp>(
+        loc, LLVM::ICmpPredicate::eq, nextK, i32Val(rewriter, loc, K));
+    rewriter.create<LLVM::CondBrOp>(loc, done, endBlock, ValueRange{next},
+                                    bodyBlock, ValueRange{nextK, next});
+
+    rewriter.setInsertionPointToStart(endBlock);
+    rewriter.replaceOp(op, endBlock->getArgument(0));
+    return success();
+  }
+};
+
+// Reductions combine the slices across their axis pairwise, as vectors of
+// the elements of the result
+struct ReduceOpConversion : public ConvertOpToLLVMPattern<triton::ReduceOp> {
+  using ConvertOpToLLVMPattern<triton::ReduceOp>::ConvertOpToLLVMPattern;
+
+  static Value combine(ConversionPatternRewriter &rewriter, Location loc,
+                       RedOp redOp, Value lhs, Value rhs) {
+    switch (redOp) {
+    case RedOp::ADD:
+      return rewriter.create<LLVM::AddOp>(loc, lhs, rhs);
+    case RedOp::FADD:
+      return rewriter.create<LLVM::FAddOp>(loc, lhs, rhs);
+    case RedOp::MIN:
+      return rewriter.create<LLVM::SMinOp>(loc, lhs, rhs);
+    case RedOp::MAX:
+      return rewriter.create<LLVM::SMaxOp>(loc, lhs, rhs);
+    case RedOp::UMIN:
+      return rewriter.create<LLVM::UMinOp>(loc, lhs, rhs);
+    case RedOp::UMAX:
+      return rewriter.create<LLVM::UMaxOp>(loc, lhs, rhs);
+    case RedOp::FMIN:
+      return rewriter.create<LLVM::MinNumOp>(loc, lhs, rhs);
+    case RedOp::FMAX:
+      return rewriter.create<LLVM::MaxNumOp>(loc, lhs, rhs);
+    case RedOp::XOR:
+      return rewriter.create<LLVM::XOrOp>(loc, lhs, rhs);
+    default:
+      llvm_unreachable("Unexpected reduction with index");
+    }
+  }
+
+  // Whether the values of rhs are picked over those of lhs
+  static Value isBetter(ConversionPatternRewriter &rewriter, Location loc,
+                        RedOp redOp, Value lhs, Value rhs) {
+    switch (redOp) {
+    case RedOp::ARGMIN:
+      return rewriter.create<LLVM::ICmpOp>(loc, LLVM::ICmpPredicate::slt,
+                                           rhs, lhs);
+    case RedOp::ARGMAX:
+      return rewriter.create<LLVM::ICmpOp>(loc, LLVM::ICmpPredicate::sgt,
+                                           rhs, lhs);
+    case RedOp::ARGUMIN:
+      return rewriter.create<LLVM::ICmpOp>(loc, LLVM::ICmpPredicate::ult,
+                                           rhs, lhs);
+    case RedOp::ARGUMAX:
+      return rewriter.create<LLVM::ICmpOp>(loc, LLVM::ICmpPredicate::ugt,
+                                           rhs, lhs);
+    case RedOp::ARGFMIN:
+      return rewriter.create<LLVM::FCmpOp>(loc, LLVM::FCmpPredicate::olt,
+                                           rhs, lhs);
+    case RedOp::ARGFMAX:
+      return rewriter.create<LLVM::FCmpOp>(loc, LLVM::FCmpPredicate::ogt,
+                                           rhs, lhs);
+    default:
+      llvm_unreachable("Unexpected reduction without index");
+    }
+  }
+
+  static Value isEqual(ConversionPatternRewriter &rewriter, Location loc,
+                       Value lhs, Value rhs) {
+    if (LLVM::getVectorElementType(lhs.getType()).isa<FloatType>())
+      return rewriter.create<LLVM::FCmpOp>(loc, LLVM::FCmpPredicate::oeq,
+                                           lhs, rhs);
+    return rewriter.create<LLVM::ICmpOp>(loc, LLVM::ICmpPredicate::eq, lhs,
+                                         rhs);
+  }
+
+  LogicalResult
+  matchAndRewrite(triton::ReduceOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    RedOp redOp = op.redOp();
+    bool withIndex = triton::ReduceOp::withIndex(redOp);
+    auto srcShape = op.operand().getType().cast<RankedTensorType>().getShape();
+    unsigned axis = op.axis();
+    int64_t outer = std::accumulate(srcShape.begin(), srcShape.begin() + axis,
+                                    1, std::multiplies<int64_t>());
+    int64_t inner =
+        std::accumulate(srcShape.begin() + axis + 1, srcShape.end(), 1,
+                        std::multiplies<int64_t>());
+    int64_t size = srcShape[axis];
+
+    // the slice k holds the elements at k along the axis
+    SmallVector<Value> values, indices;
+    for (int64_t k = 0; k < size; ++k) {
+      SmallVector<int32_t> mask(outer * inner);
+      for (int64_t j = 0; j < outer * inner; ++j)
+        mask[j] = ((j / inner) * size + k) * inner + j % inner;
+      values.push_back(shuffle(rewriter, loc, adaptor.operand(), mask));
+      if (withIndex)
+        indices.push_back(constant(
+            rewriter, loc,
+            LLVM::getFixedVectorType(rewriter.getI32Type(), outer * inner),
+            k));
+    }
+    while (values.size() > 1) {
+      size_t half = (values.size() + 1) / 2;
+      for (size_t k = 0; k + half < values.size(); ++k) {
+        Value lhs = values[k], rhs = values[k + half];
+        if (!withIndex) {
+          values[k] = combine(rewriter, loc, redOp, lhs, rhs);
+          continue;
+        }
+        // ties are broken by the lowest index
+        Value lhsIndex = indices[k], rhsIndex = indices[k + half];
+        Value takeRhs = rewriter.create<LLVM::OrOp>(
+            loc, isBetter(rewriter, loc, redOp, lhs, rhs),
+            rewriter.create<LLVM::AndOp>(
+                loc, isEqual(rewriter, loc, lhs, rhs),
+                rewriter.create<LLVM::ICmpOp>(loc, LLVM::ICmpPredicate::slt,
+                                              rhsIndex, lhsIndex)));
+        values[k] = rewriter.create<LLVM::SelectOp>(loc, takeRhs, rhs, lhs);
+        indices[k] = rewriter.create<LLVM::SelectOp>(loc, takeRhs, rhsIndex,
+                                                     lhsIndex);
+      }
+      values.resize(half);
+      if (withIndex)
+        indices.resize(half);
+    }
+    Value result = withIndex ? indices[0] : values[0];
+    if (!op.getType().isa<RankedTensorType>())
+      result = extractElement(rewriter, loc, result, 0);
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+};
+
+void populateTritonGPUToCPUPatterns(TritonGPUToCPUTypeConverter &converter,
+                                    RewritePatternSet &patterns,
+                                    AxisInfoAnalysis &axisInfoAnalysis,
+                                    PatternBenefit benefit) {
+  patterns.add<MakeRangeOpConversion, ConstantOpConversion, SplatOpConversion,
+               BroadcastOpConversion, TransOpConversion, CatOpConversion,
+               JoinOpConversion, SplitOpConversion, AddPtrOpConversion,
+               CmpIOpConversion, CmpFOpConversion, PhiloxOpConversion,
+               AtomicRMWOpConversion, AtomicCASOpConversion,
+               ScratchOpConversion, BarrierOpConversion, DotOpConversion,
+               ReduceOpConversion>(
+      converter, benefit);
+  patterns.add<IdentityOpConversion<triton::ExpandDimsOp>,
+               IdentityOpConversion<triton::ViewOp>,
+               IdentityOpConversion<triton::gpu::ConvertLayoutOp>>(converter,
+                                                                  benefit);
+  patterns.add<ElementwiseOpConversion<triton::IntToPtrOp, LLVM::IntToPtrOp>,
+               ElementwiseOpConversion<triton::PtrToIntOp, LLVM::PtrToIntOp>,
+               ElementwiseOpConversion<triton::BitcastOp, LLVM::BitcastOp>,
+               ElementwiseOpConversion<triton::gpu::SelectOp,
+                                       LLVM::SelectOp>>(converter, benefit);
+  patterns.add<LoadOpConversion, StoreOpConversion>(converter,
+                                                    axisInfoAnalysis, benefit);
+}
+
+class ConvertTritonGPUToCPU
+    : public ConvertTritonGPUToCPUBase<ConvertTritonGPUToCPU> {
+public:
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    ModuleOp mod = getOperation();
+
+    mlir::LowerToLLVMOptions option(context);
+    TritonGPUToCPUTypeConverter typeConverter(context, option);
+
+    // Step 1: Pass the program ids and the size of the grid as arguments
+    // Step 2: Convert SCF to CFG
+    // Step 3: Convert FuncOp to LLVMFuncOp via partial conversion
+    // Step 4: Get axis info
+    // Step 5: Convert the rest of ops via partial conversion
+    //
+    // As in the conversion to LLVM for GPUs, step 4 runs on the module with
+    // its final functions, and before step 5 rewrites the ops it looks at.
+
+    // Step 1
+    addProgramIdArguments(mod);
+
+    // Step 2
+    RewritePatternSet scf_patterns(context);
+    mlir::populateLoopToStdConversionPatterns(scf_patterns);
+    mlir::ConversionTarget scf_target(*context);
+    scf_target.addIllegalOp<scf::ForOp, scf::IfOp, scf::ParallelOp,
+                            scf::WhileOp, scf::ExecuteRegionOp>();
+    scf_target.markUnknownOpDynamicallyLegal([](Operation *) { return true; });
+    if (failed(
+            applyPartialConversion(mod, scf_target, std::move(scf_patterns))))
+      return signalPassFailure();
+
+    // Step 3
+    RewritePatternSet func_patterns(context);
+    mlir::populateStdToLLVMFuncOpConversionPattern(typeConverter,
+                                                   func_patterns);
+    mlir::ConversionTarget func_target(*context);
+    func_target.addLegalDialect<LLVM::LLVMDialect>();
+    func_target.addIllegalOp<mlir::FuncOp>();
+    func_target.addLegalOp<mlir::UnrealizedConversionCastOp>();
+    if (failed(
+            applyPartialConversion(mod, func_target, std::move(func_patterns))))
+      return signalPassFailure();
+
+    // Step 4
+    AxisInfoAnalysis axisInfoAnalysis(mod.getContext());
+    axisInfoAnalysis.run(mod);
+
+    // Step 5
+    // Triton's patterns have a higher benefit than the arith ones, which
+    // lower tensor constants for splats only
+    RewritePatternSet patterns(context);
+    populateTritonGPUToCPUPatterns(typeConverter, patterns, axisInfoAnalysis,
+                                   /*benefit=*/10);
+    mlir::arith::populateArithmeticToLLVMConversionPatterns(typeConverter,
+                                                            patterns);
+    mlir::populateMathToLLVMConversionPatterns(typeConverter, patterns);
+    mlir::populateStdToLLVMConversionPatterns(typeConverter, patterns);
+    TritonCPUConversionTarget target(*context);
+    if (failed(applyPartialConversion(mod, target, std::move(patterns))))
+      return signalPassFailure();
+  }
+
+private:
+  // The launcher passes the program ids along the 3 axes of the grid, then
+  // its size, as trailing arguments of the kernels
+  void addProgramIdArguments(ModuleOp mod) {
+    OpBuilder b(mod.getContext());
+    for (auto funcOp : mod.getOps<FuncOp>()) {
+      if (funcOp.isExternal() || funcOp.isPrivate())
+        continue;
+      unsigned numArgs = funcOp.getNumArguments();
+      SmallVector<unsigned> indices(6, numArgs);
+      SmallVector<Type> types(6, b.getI32Type());
+      SmallVector<DictionaryAttr> attrs(6, DictionaryAttr());
+      SmallVector<Location> locs(6, funcOp.getLoc());
+      funcOp.insertArguments(indices, types, attrs, locs);
+      SmallVector<Operation *> gridOps;
+      funcOp.walk([&](Operation *op) {
+        unsigned argIdx;
+        if (auto pidOp = dyn_cast<triton::GetProgramIdOp>(op))
+          argIdx = numArgs + pidOp.axis();
+        else if (auto numOp = dyn_cast<triton::GetNumProgramsOp>(op))
+          argIdx = numArgs + 3 + numOp.axis();
+        else
+          return;
+        op->getResult(0).replaceAllUsesWith(funcOp.getArgument(argIdx));
+        gridOps.push_back(op);
+      });
+      for (Operation *op : gridOps)
+        op->erase();
+    }
+  }
+};
+
+} // namespace
+
+namespace mlir {
+namespace triton {
+
+std::unique_ptr<OperationPass<ModuleOp>> createConvertTritonGPUToCPUPass() {
+  return std::make_unique<::ConvertTritonGPUToCPU>();
+}
+
+} // namespace triton
+} // namespace mlir
@@ -8,7 +8,10 @@ using ::mlir::LLVM::getElementsFromStruct;
 using ::mlir::LLVM::getSharedMemoryObjectFromStruct;
 using ::mlir::LLVM::getStridesFromShapeAndOrder;
 using ::mlir::LLVM::getStructFromElements;
+using ::mlir::LLVM::MFMAConversionHelper;
 using ::mlir::LLVM::MMA16816ConversionHelper;
+using ::mlir::LLVM::shflIdxSync;
+using ::mlir::LLVM::warpBarrier;
 using ::mlir::triton::gpu::DotOperandEncodingAttr;
 using ::mlir::triton::gpu::getContigPerThread;
 using ::mlir::triton::gpu::getElemsPerThread;
@@ -17,6 +20,7 @@ using ::mlir::triton::gpu::getShapePerCTA;
 using ::mlir::triton::gpu::getSizePerThread;
 using ::mlir::triton::gpu::isaDistributedLayout;
 using ::mlir::triton::gpu::SharedEncodingAttr;
+using ::mlir::triton::gpu::SparseDotMetaEncodingAttr;
 
 struct ConvertLayoutOpConversion
     : public ConvertTritonGPUOpToLLVMPattern<triton::gpu::ConvertLayoutOp> {
@@ -41,7 +45,15 @@ public:
         dstLayout.isa<DotOperandEncodingAttr>()) {
       return lowerSharedToDotOperand(op, adaptor, rewriter);
     }
+    if (srcLayout.isa<SharedEncodingAttr>() &&
+        dstLayout.isa<SparseDotMetaEncodingAttr>()) {
+      return lowerSharedToSparseDotMeta(op, adaptor, rewriter);
+    }
     if (isaDistributedLayout(srcLayout) && isaDistributedLayout(dstLayout)) {
+      auto srcElems = getWarpShuffleSrcElems(op);
+      if (!srcElems.empty())
+        return lowerDistributedWithWarpShuffle(op, adaptor, rewriter,
+                                               srcElems);
       return lowerDistributedToDistributed(op, adaptor, rewriter);
     }
     if (srcLayout.isa<MmaEncodingAttr>() &&
@@ -105,7 +117,7 @@ private:
       Value _4 = idx_val(4);
       Value _8 = idx_val(8);
       Value _16 = idx_val(16);
-      if (mmaLayout.isAmpere()) {
+      if (mmaLayout.isAmpere() || mmaLayout.isHopper()) {
         multiDimWarpId[0] = urem(multiDimWarpId[0], idx_val(shape[0] / 16));
         multiDimWarpId[1] = urem(multiDimWarpId[1], idx_val(shape[1] / 8));
         Value mmaGrpId = udiv(laneId, _4);
@@ -127,7 +139,7 @@ private:
 
       assert(rank == 2);
       SmallVector<Value> multiDimOffset(rank);
-      if (mmaLayout.isAmpere()) {
+      if (mmaLayout.isAmpere() || mmaLayout.isHopper()) {
         multiDimOffset[0] = elemId < 2 ? mmaRowIdx[0] : mmaRowIdx[1];
         multiDimOffset[1] = elemId % 2 == 0 ? mmaColIdx[0] : mmaColIdx[1];
         multiDimOffset[0] = add(
@@ -146,6 +158,21 @@ private:
       }
       return multiDimOffset;
     }
+    if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>()) {
+      // elemId in [0, 16) indexes the values a lane holds in one 32x32 tile:
+      // row 8 * (elemId / 4) + 4 * (lane / 32) + elemId % 4, col lane % 32.
+      assert(rank == 2);
+      auto multiDimBase = emitBaseIndexForLayout(loc, rewriter, mfmaLayout,
+                                                 shape);
+      SmallVector<Value> multiDimOffset(rank);
+      multiDimOffset[0] =
+          add(multiDimBase[0],
+              idx_val(multiDimCTAInRepId[0] * shapePerCTA[0] +
+                      8 * (elemId / 4) + elemId % 4));
+      multiDimOffset[1] = add(multiDimBase[1],
+                              idx_val(multiDimCTAInRepId[1] * shapePerCTA[1]));
+      return multiDimOffset;
+    }
     llvm_unreachable("unexpected layout in getMultiDimOffset");
   }
 
@@ -165,6 +192,10 @@ private:
     auto rank = type.getRank();
     auto sizePerThread = getSizePerThread(layout);
     auto accumSizePerThread = product<unsigned>(sizePerThread);
+    // A lane holds 4 non-contiguous groups of sizePerThread rows of each mfma
+    // tile, see getMultiDimOffset.
+    if (layout.isa<MfmaEncodingAttr>())
+      accumSizePerThread = 16;
     SmallVector<unsigned> numCTAs(rank);
     auto shapePerCTA = getShapePerCTA(layout, type.getShape());
     auto order = getOrder(layout);
@@ -338,6 +369,57 @@ private:
     }
   }
 
+  // blocked -> blocked within warps.
+  // Element i of the result is read from element srcElems[i] of the lane
+  // that holds it, without going through shared memory.
+  LogicalResult
+  lowerDistributedWithWarpShuffle(triton::gpu::ConvertLayoutOp op,
+                                  OpAdaptor adaptor,
+                                  ConversionPatternRewriter &rewriter,
+                                  ArrayRef<unsigned> srcElems) const {
+    auto loc = op.getLoc();
+    auto srcTy = op.src().getType().cast<RankedTensorType>();
+    auto dstTy = op.result().getType().cast<RankedTensorType>();
+    auto srcLayout = srcTy.getEncoding().cast<BlockedEncodingAttr>();
+    auto sizePerThread = srcLayout.getSizePerThread();
+    auto threadsPerWarp = srcLayout.getThreadsPerWarp();
+    auto shapePerCTA = getShapePerCTA(srcLayout);
+    unsigned rank = dstTy.getRank();
+
+    auto vals = getElementsFromStruct(loc, adaptor.src(), rewriter);
+    auto dstIndices = emitIndices(loc, rewriter, dstTy.getEncoding(),
+                                  dstTy.getShape());
+#ifdef USE_ROCM
+    // Two 32-lane warps share a wavefront
+    bool halfWave = product<unsigned>(threadsPerWarp) == 32;
+    Value laneBase = and_(getThreadId(rewriter, loc), i32_val(32));
+#endif
+    SmallVector<Value> outVals(srcElems.size());
+    for (unsigned i = 0; i < srcElems.size(); ++i) {
+      SmallVector<Value> multiDimLane(rank);
+      for (unsigned d = 0; d < rank; ++d) {
+        Value offset = urem(dstIndices[i][d], i32_val(shapePerCTA[d]));
+        multiDimLane[d] = urem(udiv(offset, i32_val(sizePerThread[d])),
+                               i32_val(threadsPerWarp[d]));
+      }
+      Value srcLane = linearize(rewriter, loc, multiDimLane, threadsPerWarp,
+                                srcLayout.getOrder());
+#ifdef USE_ROCM
+      if (halfWave)
+        srcLane = add(srcLane, laneBase);
+#endif
+      outVals[i] = shflIdxSync(loc, rewriter, vals[srcElems[i]], srcLane);
+    }
+
+    auto llvmElemTy = getTypeConverter()->convertType(dstTy.getElementType());
+    SmallVector<Type> types(outVals.size(), llvmElemTy);
+    auto *ctx = llvmElemTy.getContext();
+    Type structTy = struct_ty(types);
+    Value result = getStructFromElements(loc, outVals, rewriter, structTy);
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+
   // blocked/mma -> blocked/mma.
   // Data padding in shared memory to avoid bank conflict.
   LogicalResult
@@ -382,10 +464,12 @@ private:
                    sliceLayout.getParent().cast<MmaEncodingAttr>().isVolta();
     }
 
+    // A replica covers the whole tensor when it fits in the scratch buffer
+    auto repShape = getRepShapeForCvtLayout(op);
     for (unsigned d = 0; d < rank; ++d) {
       unsigned inPerCTA = std::min<unsigned>(shape[d], srcShapePerCTA[d]);
       unsigned outPerCTA = std::min<unsigned>(shape[d], dstShapePerCTA[d]);
-      unsigned maxPerCTA = std::max(inPerCTA, outPerCTA);
+      unsigned maxPerCTA = repShape[d];
       numReplicates[d] = ceil<unsigned>(shape[d], maxPerCTA);
       inNumCTAsEachRep[d] = maxPerCTA / inPerCTA;
       outNumCTAsEachRep[d] = maxPerCTA / outPerCTA;
@@ -405,14 +489,24 @@ private:
     auto outOrd = getOrder(dstLayout);
     SmallVector<Value> outVals(outElems);
 
+    // Warps of a warp-local conversion never read each other's elements
+    bool warpLocal = isWarpLocal(op);
+    auto sync = [&]() {
+      if (warpLocal)
+        warpBarrier(loc, rewriter);
+      else
+        barrier();
+    };
+
     for (unsigned repId = 0; repId < accumNumReplicates; ++repId) {
       auto multiDimRepId =
           getMultiDimIndex<unsigned>(repId, numReplicates, outOrd);
       if (repId != 0)
-        barrier();
+        sync();
       if (srcLayout.isa<BlockedEncodingAttr>() ||
           srcLayout.isa<SliceEncodingAttr>() ||
-          srcLayout.isa<MmaEncodingAttr>()) {
+          srcLayout.isa<MmaEncodingAttr>() ||
+          srcLayout.isa<MfmaEncodingAttr>()) {
         if (isSrcMmaV1)
           processReplicaForMMAV1(loc, rewriter, /*stNotRd*/ true, srcTy,
                                  multiDimRepId, inVec, paddedRepShape, outOrd,
@@ -426,10 +520,11 @@ private:
         return failure();
       }
 
-      barrier();
+      sync();
       if (dstLayout.isa<BlockedEncodingAttr>() ||
           dstLayout.isa<SliceEncodingAttr>() ||
-          dstLayout.isa<MmaEncodingAttr>()) {
+          dstLayout.isa<MmaEncodingAttr>() ||
+          dstLayout.isa<MfmaEncodingAttr>()) {
         if (isDstMmaV1)
           processReplicaForMMAV1(loc, rewriter, /*stNotRd*/ false, dstTy,
                                  multiDimRepId, outVec, paddedRepShape, outOrd,
@@ -466,7 +561,7 @@ private:
     auto srcShape = srcTy.getShape();
     auto dstTy = dst.getType().cast<RankedTensorType>();
     auto dstShape = dstTy.getShape();
-    assert(srcShape.size() == 2 &&
+    assert((srcShape.size() == 2 || srcShape.size() == 3) &&
            "Unexpected rank of ConvertLayout(blocked->shared)");
     auto srcLayout = srcTy.getEncoding();
     auto dstSharedLayout = dstTy.getEncoding().cast<SharedEncodingAttr>();
@@ -515,6 +610,10 @@ private:
             dotOperandLayout.getParent().dyn_cast_or_null<MmaEncodingAttr>()) {
       res = lowerSharedToDotOperandMMA(op, adaptor, rewriter, mmaLayout,
                                        dotOperandLayout, isOuter);
+    } else if (auto mfmaLayout = dotOperandLayout.getParent()
+                                     .dyn_cast_or_null<MfmaEncodingAttr>()) {
+      res = lowerSharedToDotOperandMFMA(op, adaptor, rewriter, mfmaLayout,
+                                        dotOperandLayout);
     } else if (auto blockedLayout =
                    dotOperandLayout.getParent()
                        .dyn_cast_or_null<BlockedEncodingAttr>()) {
@@ -593,6 +692,44 @@ private:
     return failure();
   }
 
+  // shared -> sparse_dot_meta
+  LogicalResult
+  lowerSharedToSparseDotMeta(triton::gpu::ConvertLayoutOp op,
+                             OpAdaptor adaptor,
+                             ConversionPatternRewriter &rewriter) const {
+    auto loc = op.getLoc();
+    Value src = op.src();
+    auto dstTy = op.result().getType().cast<RankedTensorType>();
+    auto mmaLayout = dstTy.getEncoding()
+                         .cast<SparseDotMetaEncodingAttr>()
+                         .getParent()
+                         .cast<MmaEncodingAttr>();
+    auto smemObj =
+        getSharedMemoryObjectFromStruct(loc, adaptor.src(), rewriter);
+    MMA16816ConversionHelper mmaHelper(src.getType(), mmaLayout,
+                                       getThreadId(rewriter, loc), rewriter,
+                                       getTypeConverter(), loc);
+    rewriter.replaceOp(op, mmaHelper.loadSparseMeta(src, smemObj));
+    return success();
+  }
+
+  // shared -> dot_operand if the result layout is mfma
+  Value lowerSharedToDotOperandMFMA(
+      triton::gpu::ConvertLayoutOp op, OpAdaptor adaptor,
+      ConversionPatternRewriter &rewriter, const MfmaEncodingAttr &mfmaLayout,
+      const DotOperandEncodingAttr &dotOperandLayout) const {
+    auto loc = op.getLoc();
+    Value src = op.src();
+    auto smemObj =
+        getSharedMemoryObjectFromStruct(loc, adaptor.src(), rewriter);
+    MFMAConversionHelper mfmaHelper(mfmaLayout, getThreadId(rewriter, loc),
+                                    rewriter, getTypeConverter(), loc);
+    if (dotOperandLayout.getOpIdx() == 0) // operand $a
+      return mfmaHelper.loadA(src, smemObj);
+    assert(dotOperandLayout.getOpIdx() == 1); // operand $b
+    return mfmaHelper.loadB(src, smemObj);
+  }
+
   // shared -> dot_operand if the result layout is mma
   Value lowerSharedToDotOperandMMA(
       triton::gpu::ConvertLayoutOp op, OpAdaptor adaptor,
@@ -607,7 +744,12 @@ private:
         getSharedMemoryObjectFromStruct(loc, adaptor.src(), rewriter);
     Value res;
 
-    if (!isOuter && mmaLayout.isAmpere() && isHMMA) { // tensor core v2
+    if (!isOuter && mmaLayout.isHopper() && isHMMA &&
+        dotOperandLayout.getOpIdx() == 1) { // tensor core v3
+      // wgmma reads $b from shared memory through a descriptor
+      res = adaptor.src();
+    } else if (!isOuter && (mmaLayout.isAmpere() || mmaLayout.isHopper()) &&
+               isHMMA) { // tensor core v2, and $a of v3
       MMA16816ConversionHelper mmaHelper(src.getType(), mmaLayout,
                                          getThreadId(rewriter, loc), rewriter,
                                          getTypeConverter(), op.getLoc());
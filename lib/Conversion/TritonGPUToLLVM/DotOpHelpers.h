@@ -13,6 +13,7 @@
 #include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/GPU/GPUDialect.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/LLVMIR/ROCDLDialect.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/TypeUtilities.h"
@@ -33,6 +34,7 @@ namespace LLVM {
 using namespace mlir::triton;
 using ::mlir::triton::gpu::BlockedEncodingAttr;
 using ::mlir::triton::gpu::DotOperandEncodingAttr;
+using ::mlir::triton::gpu::MfmaEncodingAttr;
 using ::mlir::triton::gpu::MmaEncodingAttr;
 using ::mlir::triton::gpu::SharedEncodingAttr;
 
@@ -620,10 +622,11 @@ struct DotOpMmaV2ConversionHelper {
     FP32_FP16_FP16_FP32 = 0, // default
     FP32_BF16_BF16_FP32,
     FP32_TF32_TF32_FP32,
+    FP32_FP8_FP8_FP32, // $a and $b hold the bits of fp8 values as i8
     // integer tensor core instr
     INT32_INT1_INT1_INT32, // Not implemented
     INT32_INT4_INT4_INT32, // Not implemented
-    INT32_INT8_INT8_INT32, // Not implemented
+    INT32_INT8_INT8_INT32,
     //
     NOT_APPLICABLE,
   };
@@ -668,6 +671,7 @@ struct DotOpMmaV2ConversionHelper {
       return ptr_ty(type::i16Ty(ctx), 3);
     case TensorCoreType::FP32_TF32_TF32_FP32:
       return ptr_ty(type::f32Ty(ctx), 3);
+    case TensorCoreType::FP32_FP8_FP8_FP32:
     case TensorCoreType::INT32_INT8_INT8_INT32:
       return ptr_ty(type::i8Ty(ctx), 3);
     default:
@@ -701,6 +705,7 @@ struct DotOpMmaV2ConversionHelper {
       return bf16x2Pack4Ty;
     case TensorCoreType::FP32_TF32_TF32_FP32:
       return fp32Pack4Ty;
+    case TensorCoreType::FP32_FP8_FP8_FP32:
     case TensorCoreType::INT32_INT8_INT8_INT32:
       return i8x4Pack4Ty;
     default:
@@ -718,6 +723,7 @@ struct DotOpMmaV2ConversionHelper {
       return vec_ty(type::bf16Ty(ctx), 2);
     case TensorCoreType::FP32_TF32_TF32_FP32:
       return type::f32Ty(ctx);
+    case TensorCoreType::FP32_FP8_FP8_FP32:
     case TensorCoreType::INT32_INT8_INT8_INT32:
       return type::i32Ty(ctx);
     default:
@@ -741,6 +747,8 @@ struct DotOpMmaV2ConversionHelper {
       return fp32x4Ty;
     case TensorCoreType::FP32_TF32_TF32_FP32:
       return fp32x4Ty;
+    case TensorCoreType::FP32_FP8_FP8_FP32:
+      return fp32x4Ty;
     case TensorCoreType::INT32_INT8_INT8_INT32:
       return i32x4Ty;
     default:
@@ -795,6 +803,14 @@ struct DotOpMmaV2ConversionHelper {
     return mmaInstrPtx.at(mmaType);
   }
 
+  // The mma instruction of sm_89 that takes fp8 operands of the given formats.
+  static std::string getFp8MmaInstr(Fp8Format aFormat, Fp8Format bFormat) {
+    return ("mma.sync.aligned.m16n8k32.row.col.f32." +
+            stringifyFp8Format(aFormat) + "." + stringifyFp8Format(bFormat) +
+            ".f32")
+        .str();
+  }
+
   static TensorCoreType getMmaType(triton::DotOp op) {
     Value A = op.a();
     Value B = op.b();
@@ -804,6 +820,8 @@ struct DotOpMmaV2ConversionHelper {
     auto dTy = op.d().getType().cast<RankedTensorType>();
 
     if (dTy.getElementType().isF32()) {
+      if (op.aFp8Format() && op.bFp8Format())
+        return TensorCoreType::FP32_FP8_FP8_FP32;
       if (aTy.getElementType().isF16() && bTy.getElementType().isF16())
         return TensorCoreType::FP32_FP16_FP16_FP32;
       if (aTy.getElementType().isBF16() && bTy.getElementType().isBF16())
@@ -832,6 +850,7 @@ private:
           {TensorCoreType::FP32_FP16_FP16_FP32, {16, 8, 16}},
           {TensorCoreType::FP32_BF16_BF16_FP32, {16, 8, 16}},
           {TensorCoreType::FP32_TF32_TF32_FP32, {16, 8, 8}},
+          {TensorCoreType::FP32_FP8_FP8_FP32, {16, 8, 32}},
 
           {TensorCoreType::INT32_INT1_INT1_INT32, {16, 8, 256}},
           {TensorCoreType::INT32_INT4_INT4_INT32, {16, 8, 64}},
@@ -847,6 +866,7 @@ private:
           {TensorCoreType::FP32_FP16_FP16_FP32, {8, 8, 8}},
           {TensorCoreType::FP32_BF16_BF16_FP32, {8, 8, 8}},
           {TensorCoreType::FP32_TF32_TF32_FP32, {8, 8, 4}},
+          {TensorCoreType::FP32_FP8_FP8_FP32, {8, 8, 16}},
 
           {TensorCoreType::INT32_INT1_INT1_INT32, {8, 8, 64}},
           {TensorCoreType::INT32_INT4_INT4_INT32, {8, 8, 32}},
@@ -864,6 +884,8 @@ private:
        "mma.sync.aligned.m16n8k16.row.col.f32.bf16.bf16.f32"},
       {TensorCoreType::FP32_TF32_TF32_FP32,
        "mma.sync.aligned.m16n8k8.row.col.f32.tf32.tf32.f32"},
+      {TensorCoreType::FP32_FP8_FP8_FP32,
+       "mma.sync.aligned.m16n8k32.row.col.f32.e4m3.e4m3.f32"},
 
       {TensorCoreType::INT32_INT1_INT1_INT32,
        "mma.sync.aligned.m16n8k256.row.col.s32.b1.b1.s32.xor.popc"},
@@ -878,6 +900,7 @@ private:
       {TensorCoreType::FP32_FP16_FP16_FP32, 8},
       {TensorCoreType::FP32_BF16_BF16_FP32, 8},
       {TensorCoreType::FP32_TF32_TF32_FP32, 4},
+      {TensorCoreType::FP32_FP8_FP8_FP32, 16},
 
       {TensorCoreType::INT32_INT1_INT1_INT32, 128},
       {TensorCoreType::INT32_INT4_INT4_INT32, 32},
@@ -1413,6 +1436,14 @@ struct MMA16816ConversionHelper {
     return 4 * std::max(repN / 2, 1) * repK;
   }
 
+  // Get number of elements per thread for the metadata $aMeta of a sparse
+  // dot: one register per mma.sp.m16n8k32 of the warp.
+  static size_t getSparseMetaNumElemsPerThread(RankedTensorType operand,
+                                               int wpt) {
+    auto shape = operand.getShape();
+    return std::max<int>(shape[0] / (wpt * 16), 1) * (shape[1] / 2);
+  }
+
   // Loading $a from smem to registers, returns a LLVM::Struct.
   Value loadA(Value tensor, const SharedMemoryObject &smemObj) const {
     auto aTensorTy = tensor.getType().cast<RankedTensorType>();
@@ -1493,6 +1524,42 @@ struct MMA16816ConversionHelper {
     return result;
   }
 
+  // Loading the metadata $aMeta of a sparse dot from smem to registers,
+  // returns a LLVM::Struct. For the k-th k32 step of each 16-row tile of its
+  // warp, lane l packs the i16 at (l / 4, 2 * k + l % 2) and
+  // (l / 4 + 8, 2 * k + l % 2) into one register.
+  Value loadSparseMeta(Value tensor, const SharedMemoryObject &smemObj) const {
+    auto tensorTy = tensor.getType().cast<RankedTensorType>();
+    auto shape = tensorTy.getShape();
+    int numRepM = std::max<int>(shape[0] / (wpt[0] * 16), 1);
+    int numRepK = shape[1] / 2;
+
+    Value warpM = urem(urem(warp, i32_val(wpt[0])),
+                       i32_val(std::max<int>(shape[0] / 16, 1)));
+    Value row = add(mul(warpM, i32_val(16)), udiv(lane, i32_val(4)));
+    Value col = urem(lane, i32_val(2));
+    Value stride0 = smemObj.strides[0];
+    Value stride1 = smemObj.strides[1];
+    Type ptrTy = ptr_ty(i16_ty, 3);
+    Value base = bitcast(smemObj.base, ptrTy);
+
+    SmallVector<Value> elems;
+    for (int m = 0; m < numRepM; ++m)
+      for (int k = 0; k < numRepK; ++k) {
+        Value r = add(row, i32_val(m * wpt[0] * 16));
+        Value c = add(col, i32_val(2 * k));
+        Value off = add(mul(r, stride0), mul(c, stride1));
+        Value lo = load(gep(ptrTy, base, off));
+        Value hi = load(gep(ptrTy, base, add(off, mul(i32_val(8), stride0))));
+        elems.push_back(
+            or_(zext(i32_ty, lo), shl(zext(i32_ty, hi), i32_val(16))));
+      }
+
+    Type structTy = LLVM::LLVMStructType::getLiteral(
+        ctx, SmallVector<Type>(elems.size(), i32_ty));
+    return getStructFromElements(loc, elems, rewriter, structTy);
+  }
+
   // Loading $c to registers, returns a Value.
   Value loadC(Value tensor, Value llTensor) const {
     auto tensorTy = tensor.getType().cast<RankedTensorType>();
@@ -1516,7 +1583,7 @@ struct MMA16816ConversionHelper {
   // loading.
   LogicalResult convertDot(Value a, Value b, Value c, Value d, Value loadedA,
                            Value loadedB, Value loadedC, DotOp op,
-                           DotOpAdaptor adaptor) const {
+                           DotOpAdaptor adaptor, bool hasFp8MMA) const {
     helper.deduceMmaType(op);
 
     auto aTensorTy = a.getType().cast<RankedTensorType>();
@@ -1538,21 +1605,20 @@ struct MMA16816ConversionHelper {
         loadedB, std::max(numRepN / 2, 1), numRepK);
     auto fc = getElementsFromStruct(loc, loadedC, rewriter);
 
-    auto callMma = [&](unsigned m, unsigned n, unsigned k) {
-      unsigned colsPerThread = numRepN * 2;
+    // using =r for float32 works but leads to less readable ptx.
+    bool isIntMMA = dTensorTy.getElementType().isInteger(32);
+    unsigned colsPerThread = numRepN * 2;
+    auto emitMma = [&](StringRef instr, ArrayRef<Value> aRegs,
+                       ArrayRef<Value> bRegs, unsigned m, unsigned n) {
       PTXBuilder builder;
-      auto &mma = *builder.create(helper.getMmaInstr().str());
-      // using =r for float32 works but leads to less readable ptx.
-      bool isIntMMA = dTensorTy.getElementType().isInteger(32);
+      auto &mma = *builder.create(instr.str());
       auto retArgs = builder.newListOperand(4, isIntMMA ? "=r" : "=f");
-      auto aArgs = builder.newListOperand({
-          {ha[{m, k}], "r"},
-          {ha[{m + 1, k}], "r"},
-          {ha[{m, k + 1}], "r"},
-          {ha[{m + 1, k + 1}], "r"},
-      });
-      auto bArgs =
-          builder.newListOperand({{hb[{n, k}], "r"}, {hb[{n, k + 1}], "r"}});
+      auto aArgs = builder.newListOperand();
+      for (Value aReg : aRegs)
+        aArgs->listAppend(builder.newOperand(aReg, "r"));
+      auto bArgs = builder.newListOperand();
+      for (Value bReg : bRegs)
+        bArgs->listAppend(builder.newOperand(bReg, "r"));
       auto cArgs = builder.newListOperand();
       for (int i = 0; i < 4; ++i) {
         cArgs->listAppend(builder.newOperand(fc[m * colsPerThread + 4 * n + i],
@@ -1569,6 +1635,69 @@ struct MMA16816ConversionHelper {
             extract_val(elemTy, mmaOut, i32_arr_attr(i));
     };
 
+    bool isFp8MMA = op.aFp8Format() && op.bFp8Format();
+    bool isTF32x3 =
+        helper.getMmaType(op) ==
+            DotOpMmaV2ConversionHelper::TensorCoreType::FP32_TF32_TF32_FP32 &&
+        op.precision() == triton::DotPrecision::TF32x3;
+    // x = big + small, big being x truncated to tf32 and small the remainder,
+    // itself truncated to tf32 by the tensor cores
+    auto splitTF32 = [&](ArrayRef<Value> regs) {
+      SmallVector<Value> big, small;
+      for (Value reg : regs) {
+        Value bigReg = bitcast(and_(bitcast(reg, i32_ty), i32_val(0xffffe000)),
+                               f32_ty);
+        big.push_back(bigReg);
+        small.push_back(fsub(reg, bigReg));
+      }
+      return std::make_pair(big, small);
+    };
+    auto callMma = [&](unsigned m, unsigned n, unsigned k) {
+      SmallVector<Value> aRegs{ha[{m, k}], ha[{m + 1, k}], ha[{m, k + 1}],
+                               ha[{m + 1, k + 1}]};
+      SmallVector<Value> bRegs{hb[{n, k}], hb[{n, k + 1}]};
+      if (isTF32x3) {
+        // a*b ~= small_a*big_b + big_a*small_b + big_a*big_b, the small
+        // products accumulated first; small_a*small_b is below f32 precision
+        auto [aBig, aSmall] = splitTF32(aRegs);
+        auto [bBig, bSmall] = splitTF32(bRegs);
+        emitMma(helper.getMmaInstr(), aSmall, bBig, m, n);
+        emitMma(helper.getMmaInstr(), aBig, bSmall, m, n);
+        emitMma(helper.getMmaInstr(), aBig, bBig, m, n);
+        return;
+      }
+      if (!isFp8MMA) {
+        emitMma(helper.getMmaInstr(), aRegs, bRegs, m, n);
+        return;
+      }
+      if (hasFp8MMA) {
+        emitMma(DotOpMmaV2ConversionHelper::getFp8MmaInstr(*op.aFp8Format(),
+                                                           *op.bFp8Format()),
+                aRegs, bRegs, m, n);
+        return;
+      }
+      // Without fp8 tensor cores, the k32 fragments are unpacked into two k16
+      // fragments of fp16. The registers of a thread hold the same k in $a
+      // and $b, so the k are permuted consistently and the sum is unchanged.
+      auto unpack = [&](ArrayRef<Value> regs, Fp8Format format) {
+        SmallVector<Value> lo, hi;
+        for (Value reg : regs) {
+          auto [bytes01, bytes23] =
+              LLVM::convertFp8x4ToFp16x4(loc, rewriter, reg, format);
+          lo.push_back(bytes01);
+          hi.push_back(bytes23);
+        }
+        return std::make_pair(lo, hi);
+      };
+      auto [aLo, aHi] = unpack(aRegs, *op.aFp8Format());
+      auto [bLo, bHi] = unpack(bRegs, *op.bFp8Format());
+      StringRef f16Instr = "mma.sync.aligned.m16n8k16.row.col.f32.f16.f16.f32";
+      emitMma(f16Instr, {aLo[0], aLo[1], aHi[0], aHi[1]}, {bLo[0], bHi[0]}, m,
+              n);
+      emitMma(f16Instr, {aLo[2], aLo[3], aHi[2], aHi[3]}, {bLo[1], bHi[1]}, m,
+              n);
+    };
+
     for (int k = 0; k < numRepK; ++k)
       for (int m = 0; m < numRepM; ++m)
         for (int n = 0; n < numRepN; ++n)
@@ -1589,6 +1718,197 @@ struct MMA16816ConversionHelper {
     return success();
   }
 
+  // Conduct the SparseDot conversion to mma.sp.m16n8k32. Each 16x16 tile of
+  // the compressed $a is held as the $a of mma.m16n8k16 and each 32x8 tile of
+  // $b as two k16 tiles of the $b of mma.m16n8k16.
+  LogicalResult convertSparseDot(Value a, Value d, Value loadedA,
+                                 Value loadedMeta, Value loadedB,
+                                 Value loadedC, SparseDotOp op) const {
+    auto aTensorTy = a.getType().cast<RankedTensorType>();
+    auto dTensorTy = d.getType().cast<RankedTensorType>();
+    auto aShape = aTensorTy.getShape();
+    auto dShape = dTensorTy.getShape();
+
+    // a k16 step of the compressed $a is a k32 step of $b
+    int numRepM = getNumRepM(aTensorTy, dShape[0]);
+    int numRepN = getNumRepN(aTensorTy, dShape[1]);
+    int numRepK = getNumRepK(aTensorTy, aShape[1]);
+
+    ValueTable ha =
+        getValuesFromDotOperandLayoutStruct(loadedA, numRepM, numRepK);
+    ValueTable hb = getValuesFromDotOperandLayoutStruct(
+        loadedB, std::max(numRepN / 2, 1), 2 * numRepK);
+    auto meta = getElementsFromStruct(loc, loadedMeta, rewriter);
+    auto fc = getElementsFromStruct(loc, loadedC, rewriter);
+
+    std::string elemTy = aTensorTy.getElementType().isBF16() ? "bf16" : "f16";
+    std::string instr = "mma.sp.sync.aligned.m16n8k32.row.col.f32." + elemTy +
+                        "." + elemTy + ".f32";
+    Type retTy =
+        LLVM::LLVMStructType::getLiteral(ctx, SmallVector<Type>(4, f32_ty));
+    unsigned colsPerThread = numRepN * 2;
+    auto callMma = [&](unsigned m, unsigned n, unsigned k) {
+      PTXBuilder builder;
+      auto &mma = *builder.create(instr);
+      auto retArgs = builder.newListOperand(4, "=f");
+      auto aArgs = builder.newListOperand({{ha[{m, k}], "r"},
+                                           {ha[{m + 1, k}], "r"},
+                                           {ha[{m, k + 1}], "r"},
+                                           {ha[{m + 1, k + 1}], "r"}});
+      auto bArgs = builder.newListOperand({{hb[{n, 2 * k}], "r"},
+                                           {hb[{n, 2 * k + 1}], "r"},
+                                           {hb[{n, 2 * k + 2}], "r"},
+                                           {hb[{n, 2 * k + 3}], "r"}});
+      auto cArgs = builder.newListOperand();
+      for (int i = 0; i < 4; ++i)
+        cArgs->listAppend(builder.newOperand(fc[m * colsPerThread + 4 * n + i],
+                                             std::to_string(i)));
+      auto eArg = builder.newOperand(meta[m / 2 * numRepK + k / 2], "r");
+      // the metadata is held by the lanes 0 and 1 of each group of 4
+      auto selector = builder.newConstantOperand(0);
+
+      mma(retArgs, aArgs, bArgs, cArgs, eArg, selector);
+      Value mmaOut = builder.launch(rewriter, loc, retTy);
+      for (int i = 0; i < 4; ++i)
+        fc[m * colsPerThread + 4 * n + i] =
+            extract_val(f32_ty, mmaOut, i32_arr_attr(i));
+    };
+
+    for (int k = 0; k < numRepK; ++k)
+      for (int m = 0; m < numRepM; ++m)
+        for (int n = 0; n < numRepN; ++n)
+          callMma(2 * m, n, 2 * k);
+
+    Type structTy = LLVM::LLVMStructType::getLiteral(
+        ctx, SmallVector<Type>(fc.size(), f32_ty));
+    Value res = getStructFromElements(loc, fc, rewriter, structTy);
+    rewriter.replaceOp(op, res);
+
+    return success();
+  }
+
+  // Conduct the Dot conversion to wgmma.mma_async.m64nNk16. The 4 warps of a
+  // warpgroup issue each instruction together, each with the mma.m16n8k16
+  // fragments of its 16 rows of $a, and get the mma.m16n8k16 accumulators of
+  // the same rows. $b is read from shared memory through a descriptor.
+  // \param bSharedTy is the shared memory type $b is converted from.
+  LogicalResult convertWGMMA(Value a, Value d, RankedTensorType bSharedTy,
+                             Value loadedA, const SharedMemoryObject &bSmemObj,
+                             Value loadedC, DotOp op) const {
+    helper.deduceMmaType(op);
+
+    auto aTensorTy = a.getType().cast<RankedTensorType>();
+    auto dTensorTy = d.getType().cast<RankedTensorType>();
+    auto aShape = aTensorTy.getShape();
+    auto dShape = dTensorTy.getShape();
+
+    // All the warps are along M: numRepN n8 tiles make the whole N
+    int numRepM = getNumRepM(aTensorTy, dShape[0]);
+    int numRepN = getNumRepN(aTensorTy, dShape[1]);
+    int numRepK = getNumRepK(aTensorTy, aShape[1]);
+
+    // The rows of 32, 64 or 128 bytes swizzled as for ldmatrix are the
+    // canonical layouts of wgmma, 8 rows being the period of the swizzling
+    auto bLayout = bSharedTy.getEncoding().cast<SharedEncodingAttr>();
+    bool isNMajor = bLayout.getOrder()[0] == 1;
+    int64_t elemBytes = bSharedTy.getElementTypeBitWidth() / 8;
+    int64_t rowBytes = bSharedTy.getShape()[bLayout.getOrder()[0]] * elemBytes;
+    int swizzleMode = rowBytes == 128 ? 1 : rowBytes == 64 ? 2 : 3;
+    if ((rowBytes != 32 && rowBytes != 64 && rowBytes != 128) ||
+        bLayout.getVec() * elemBytes != 16 ||
+        bLayout.getPerPhase() * rowBytes != 128 ||
+        bLayout.getPerPhase() * bLayout.getMaxPhase() != 8)
+      llvm::report_fatal_error("wgmma reads $b from rows of 32, 64 or 128 "
+                               "bytes with the swizzling of ldmatrix");
+
+    // The descriptor holds the address, the leading and the stride byte
+    // offsets in units of 16 bytes, and the swizzling mode. The groups of 8
+    // rows are 8 * rowBytes apart; the leading offset is unused, a row
+    // holding the whole K (K-major) or N (N-major) of an instruction.
+    uint64_t sbo = 8 * rowBytes;
+    uint64_t descBits = (uint64_t(1) << 16) | ((sbo >> 4) << 32) |
+                        (uint64_t(swizzleMode) << 62);
+    Value addr = ptrtoint(i32_ty, bSmemObj.base);
+    Value desc = or_(zext(i64_ty, lshr(and_(addr, i32_val(0x3ffff)),
+                                       i32_val(4))),
+                     int_val(64, descBits));
+    auto getDesc = [&](int64_t offsetBytes) -> Value {
+      if (offsetBytes == 0)
+        return desc;
+      return add(desc, int_val(64, offsetBytes >> 4));
+    };
+
+    auto fc = getElementsFromStruct(loc, loadedC, rewriter);
+    ValueTable ha =
+        getValuesFromDotOperandLayoutStruct(loadedA, numRepM, numRepK);
+
+    auto emit = [&](StringRef instr) {
+      PTXBuilder builder;
+      builder.create<>(instr.str())->operator()();
+      builder.launch(rewriter, loc, void_ty(ctx));
+    };
+    // the shared memory written by the generic proxy is visible to wgmma
+    emit("fence.proxy.async.shared::cta");
+    emit("wgmma.fence.sync.aligned");
+
+    StringRef typeStr =
+        aTensorTy.getElementType().isBF16() ? "bf16.bf16" : "f16.f16";
+    int tnspB = isNMajor ? 1 : 0;
+    // An instruction spans at most 256 columns, the rows of an N-major $b
+    // being no longer than 64 of them
+    int N = numRepN * 8;
+    for (int k = 0; k < numRepK; ++k) {
+      int64_t kOffset = isNMajor ? 16 * rowBytes : 16 * elemBytes;
+      for (int m = 0; m < numRepM; ++m)
+        for (int n0 = 0; n0 < N; n0 += 256) {
+          int instrN = std::min(N - n0, 256);
+          int64_t offset = k * kOffset + (isNMajor ? 0 : n0 * rowBytes);
+          PTXBuilder builder;
+          auto &wgmma = *builder.create(
+              "wgmma.mma_async.sync.aligned.m64n" + std::to_string(instrN) +
+              "k16.f32." + typeStr.str());
+          int numRegs = instrN / 2;
+          int base = m * 4 * numRepN + 4 * (n0 / 8);
+          auto dArgs = builder.newListOperand(numRegs, "=f");
+          auto aArgs = builder.newListOperand();
+          for (Value aReg : {ha[{2 * m, 2 * k}], ha[{2 * m + 1, 2 * k}],
+                             ha[{2 * m, 2 * k + 1}],
+                             ha[{2 * m + 1, 2 * k + 1}]})
+            aArgs->listAppend(builder.newOperand(aReg, "r"));
+          auto descArg = builder.newOperand(getDesc(offset), "l");
+          // the accumulators are read from the output registers
+          for (int i = 0; i < numRegs; ++i)
+            builder.newOperand(fc[base + i], std::to_string(i));
+          wgmma(dArgs, aArgs, descArg, builder.newConstantOperand(1),
+                builder.newConstantOperand(1), builder.newConstantOperand(1),
+                builder.newConstantOperand(tnspB));
+
+          auto retTy = struct_ty(SmallVector<Type>(numRegs, f32_ty));
+          Value res = builder.launch(rewriter, loc, retTy);
+          for (int i = 0; i < numRegs; ++i)
+            fc[base + i] = extract_val(f32_ty, res, i32_arr_attr(i));
+        }
+    }
+
+    emit("wgmma.commit_group.sync.aligned");
+    {
+      PTXBuilder builder;
+      builder.create<>("wgmma.wait_group.sync.aligned")
+          ->operator()(builder.newConstantOperand(0));
+      builder.launch(rewriter, loc, void_ty(ctx));
+    }
+
+    Type resElemTy = dTensorTy.getElementType();
+    for (auto &elem : fc)
+      elem = bitcast(elem, resElemTy);
+    Type structTy = LLVM::LLVMStructType::getLiteral(
+        ctx, SmallVector<Type>(fc.size(), resElemTy));
+    Value res = getStructFromElements(loc, fc, rewriter, structTy);
+    rewriter.replaceOp(op, res);
+
+    return success();
+  }
+
 private:
   std::function<void(int, int)>
   getLoadMatrixFn(Value tensor, const SharedMemoryObject &smemObj,
@@ -1702,172 +2022,490 @@ private:
   }
 };
 
-// Helper for conversion of FMA DotOp.
-struct DotOpFMAConversionHelper {
-  Attribute layout;
+// Helper for conversion of DotOp to the MFMA instructions of AMD CDNA GPUs.
+// Only the single-block v_mfma_*_32x32x* variants are used: each 64-lane
+// wavefront computes a 32x32 tile of $d per instruction. Lane l of the
+// wavefront supplies row l % 32 of the 32 x K tile of $a (resp. column l % 32
+// of the K x 32 tile of $b) for the k-range selected by l / 32, and receives
+// column l % 32 of rows {8 * i + 4 * (l / 32) + j | i, j in [0, 4)} of $d.
+struct MFMAConversionHelper {
+  enum class MatrixCoreType : uint8_t {
+    // D = A * B + C
+    FP32_FP16_FP16_FP32 = 0, // default
+    FP32_BF16_BF16_FP32,
+    FP32_FP32_FP32_FP32,
+    INT32_INT8_INT8_INT32,
+    NOT_APPLICABLE,
+  };
+
+  MfmaEncodingAttr mfmaLayout;
+  ArrayRef<unsigned int> wpt;
+
+  Value thread, lane, wave;
+
+  ConversionPatternRewriter &rewriter;
+  TypeConverter *typeConverter;
+  Location loc;
   MLIRContext *ctx{};
 
-  using ValueTable = std::map<std::pair<int, int>, Value>;
+  using ValueTable = std::map<std::pair<unsigned, unsigned>, Value>;
 
-  explicit DotOpFMAConversionHelper(Attribute layout)
-      : layout(layout), ctx(layout.getContext()) {}
+  MFMAConversionHelper(MfmaEncodingAttr mfmaLayout, Value thread,
+                       ConversionPatternRewriter &rewriter,
+                       TypeConverter *typeConverter, Location loc)
+      : mfmaLayout(mfmaLayout), wpt(mfmaLayout.getWarpsPerCTA()),
+        thread(thread), rewriter(rewriter), typeConverter(typeConverter),
+        loc(loc), ctx(mfmaLayout.getContext()) {
+    assert(mfmaLayout.getNonKDim() == 32 && "Only 32x32 mfma is supported");
+    Value _64 = i32_val(64);
+    lane = urem(thread, _64);
+    wave = udiv(thread, _64);
+  }
+
+  // \param operandTy is either $a or $b's type.
+  static MatrixCoreType getMatrixCoreTypeFromOperand(Type operandTy) {
+    auto elemTy = operandTy.cast<RankedTensorType>().getElementType();
+    if (elemTy.isF16())
+      return MatrixCoreType::FP32_FP16_FP16_FP32;
+    if (elemTy.isBF16())
+      return MatrixCoreType::FP32_BF16_BF16_FP32;
+    if (elemTy.isF32())
+      return MatrixCoreType::FP32_FP32_FP32_FP32;
+    if (elemTy.isInteger(8))
+      return MatrixCoreType::INT32_INT8_INT8_INT32;
+    return MatrixCoreType::NOT_APPLICABLE;
+  }
+
+  // Get the K of a single mfma instruction.
+  static int getMfmaInstrK(MatrixCoreType coreType) {
+    switch (coreType) {
+    case MatrixCoreType::FP32_FP16_FP16_FP32:
+      return 8; // v_mfma_f32_32x32x8f16
+    case MatrixCoreType::FP32_BF16_BF16_FP32:
+      return 4; // v_mfma_f32_32x32x4bf16
+    case MatrixCoreType::FP32_FP32_FP32_FP32:
+      return 2; // v_mfma_f32_32x32x2f32
+    case MatrixCoreType::INT32_INT8_INT8_INT32:
+      return 8; // v_mfma_i32_32x32x8i8
+    default:
+      llvm::report_fatal_error("Unsupported mfma operand type");
+    }
+  }
 
-  SmallVector<Value>
-  getThreadIds(Value threadId, ArrayRef<unsigned> shapePerCTA,
-               ArrayRef<unsigned> sizePerThread, ArrayRef<unsigned> order,
-               ConversionPatternRewriter &rewriter, Location loc) const {
-    int dim = order.size();
-    SmallVector<Value> threadIds(dim);
-    for (unsigned k = 0; k < dim - 1; k++) {
-      Value dimK = i32_val(shapePerCTA[order[k]] / sizePerThread[order[k]]);
-      Value rem = urem(threadId, dimK);
-      threadId = udiv(threadId, dimK);
-      threadIds[order[k]] = rem;
+  // Get the type that carries the k elements of one lane into an mfma.
+  static Type getMfmaOperandTy(MatrixCoreType coreType, MLIRContext *ctx) {
+    Type fp16Ty = type::f16Ty(ctx);
+    Type i16Ty = type::i16Ty(ctx);
+    switch (coreType) {
+    case MatrixCoreType::FP32_FP16_FP16_FP32:
+      return vec_ty(fp16Ty, 4);
+    case MatrixCoreType::FP32_BF16_BF16_FP32:
+      return vec_ty(i16Ty, 2);
+    case MatrixCoreType::FP32_FP32_FP32_FP32:
+      return type::f32Ty(ctx);
+    case MatrixCoreType::INT32_INT8_INT8_INT32:
+      // <4xi8> is passed as an i32, as required by the intrinsic.
+      return type::i32Ty(ctx);
+    default:
+      llvm::report_fatal_error("Unsupported mfma operand type");
     }
-    Value dimK = i32_val(shapePerCTA[order[dim - 1]]);
-    threadIds[order[dim - 1]] = urem(threadId, dimK);
-    return threadIds;
   }
 
-  Value loadA(Value A, Value llA, BlockedEncodingAttr dLayout, Value thread,
-              Location loc, ConversionPatternRewriter &rewriter) const {
-    auto aTensorTy = A.getType().cast<RankedTensorType>();
-    auto aLayout = aTensorTy.getEncoding().cast<SharedEncodingAttr>();
+  static int getNumRepM(Type operand, int M, int wpt) {
+    return std::max<int>(M / (wpt * 32), 1);
+  }
+
+  static int getNumRepN(Type operand, int N, int wpt) {
+    return std::max<int>(N / (wpt * 32), 1);
+  }
+
+  static int getNumRepK(Type operand, int K) {
+    int instrK = getMfmaInstrK(getMatrixCoreTypeFromOperand(operand));
+    return std::max<int>(K / instrK, 1);
+  }
+
+  // Get number of elements per thread for $a operand.
+  static size_t getANumElemsPerThread(RankedTensorType operand, int wpt) {
+    auto shape = operand.getShape();
+    return getNumRepM(operand, shape[0], wpt) * getNumRepK(operand, shape[1]);
+  }
+
+  // Get number of elements per thread for $b operand.
+  static size_t getBNumElemsPerThread(RankedTensorType operand, int wpt) {
+    auto shape = operand.getShape();
+    return getNumRepN(operand, shape[1], wpt) * getNumRepK(operand, shape[0]);
+  }
+
+  // Loading $a from smem to registers, returns a LLVM::Struct.
+  Value loadA(Value tensor, const SharedMemoryObject &smemObj) const {
+    auto aTensorTy = tensor.getType().cast<RankedTensorType>();
+    auto shape = aTensorTy.getShape();
+    assert(aTensorTy.getEncoding().isa<SharedEncodingAttr>() &&
+           "A's layout is not supported.");
+
+    int numRepM = getNumRepM(aTensorTy, shape[0], wpt[0]);
+    int numRepK = getNumRepK(aTensorTy, shape[1]);
+    int instrK = getMfmaInstrK(getMatrixCoreTypeFromOperand(aTensorTy));
+
+    // Wrap around the wavefront id in case the tile is smaller than the
+    // wavefronts along M.
+    Value waveM = urem(urem(wave, i32_val(wpt[0])),
+                       i32_val(std::max<int>(shape[0] / 32, 1)));
+    Value rowBase = add(mul(waveM, i32_val(32)), urem(lane, i32_val(32)));
+    Value kBase = mul(udiv(lane, i32_val(32)), i32_val(instrK / 2));
+
+    ValueTable ha;
+    for (int m = 0; m < numRepM; ++m)
+      for (int k = 0; k < numRepK; ++k) {
+        Value row = add(rowBase, i32_val(m * 32 * wpt[0]));
+        Value col = add(kBase, i32_val(k * instrK));
+        ha[{m, k}] = loadOperand(aTensorTy, smemObj, row, col, 1 /*kDim*/);
+      }
+
+    return composeValuesToDotOperandLayoutStruct(ha, numRepM, numRepK);
+  }
+
+  // Loading $b from smem to registers, returns a LLVM::Struct.
+  Value loadB(Value tensor, const SharedMemoryObject &smemObj) const {
+    auto bTensorTy = tensor.getType().cast<RankedTensorType>();
+    auto shape = bTensorTy.getShape();
+    assert(bTensorTy.getEncoding().isa<SharedEncodingAttr>() &&
+           "B's layout is not supported.");
+
+    int numRepK = getNumRepK(bTensorTy, shape[0]);
+    int numRepN = getNumRepN(bTensorTy, shape[1], wpt[1]);
+    int instrK = getMfmaInstrK(getMatrixCoreTypeFromOperand(bTensorTy));
+
+    Value waveN = urem(urem(udiv(wave, i32_val(wpt[0])), i32_val(wpt[1])),
+                       i32_val(std::max<int>(shape[1] / 32, 1)));
+    Value colBase = add(mul(waveN, i32_val(32)), urem(lane, i32_val(32)));
+    Value kBase = mul(udiv(lane, i32_val(32)), i32_val(instrK / 2));
+
+    ValueTable hb;
+    for (int n = 0; n < numRepN; ++n)
+      for (int k = 0; k < numRepK; ++k) {
+        Value row = add(kBase, i32_val(k * instrK));
+        Value col = add(colBase, i32_val(n * 32 * wpt[1]));
+        hb[{n, k}] = loadOperand(bTensorTy, smemObj, row, col, 0 /*kDim*/);
+      }
+
+    return composeValuesToDotOperandLayoutStruct(hb, numRepN, numRepK);
+  }
+
+  // Loading $c to registers, returns a Value.
+  Value loadC(Value tensor, Value llTensor) const {
+    auto tensorTy = tensor.getType().cast<RankedTensorType>();
+    assert(tensorTy.getEncoding().isa<MfmaEncodingAttr>() &&
+           "Currently, we only support $c with a mfma layout.");
+    size_t fcSize = triton::gpu::getElemsPerThread(tensorTy);
+    auto structTy = llTensor.getType().cast<LLVM::LLVMStructType>();
+    assert(structTy.getBody().size() == fcSize &&
+           "DotOp's $c operand should pass the same number of values as $d in "
+           "mfma layout.");
+    return llTensor;
+  }
+
+  // Conduct the Dot conversion.
+  // \param a, \param b, \param c and \param d are DotOp operands.
+  // \param loadedA, \param loadedB, \param loadedC, all of them are result of
+  // loading.
+  LogicalResult convertDot(Value a, Value b, Value c, Value d, Value loadedA,
+                           Value loadedB, Value loadedC, DotOp op,
+                           DotOpAdaptor adaptor) const {
+    auto aTensorTy = a.getType().cast<RankedTensorType>();
+    auto dTensorTy = d.getType().cast<RankedTensorType>();
+    auto coreType = getMatrixCoreTypeFromOperand(aTensorTy);
+    if (coreType == MatrixCoreType::NOT_APPLICABLE)
+      return failure();
+
     auto aShape = aTensorTy.getShape();
+    auto dShape = dTensorTy.getShape();
 
-    auto aOrder = aLayout.getOrder();
-    auto order = dLayout.getOrder();
+    int numRepM = getNumRepM(aTensorTy, dShape[0], wpt[0]);
+    int numRepN = getNumRepN(aTensorTy, dShape[1], wpt[1]);
+    int numRepK = getNumRepK(aTensorTy, aShape[1]);
 
-    bool isARow = aOrder[0] == 1;
+    ValueTable ha =
+        getValuesFromDotOperandLayoutStruct(loadedA, numRepM, numRepK);
+    ValueTable hb =
+        getValuesFromDotOperandLayoutStruct(loadedB, numRepN, numRepK);
+    auto fc = getElementsFromStruct(loc, loadedC, rewriter);
 
-    auto aSmem = getSharedMemoryObjectFromStruct(loc, llA, rewriter);
-    Value strideAM = aSmem.strides[0];
-    Value strideAK = aSmem.strides[1];
-    Value strideA0 = isARow ? strideAK : strideAM;
-    Value strideA1 = isARow ? strideAM : strideAK;
-    int aNumPtr = 8;
-    int K = aShape[1];
-    int M = aShape[0];
+    // CDNA has no fp8 mfma: fp8 operands go through shared memory as i8, and
+    // the four k of a lane are unpacked to fp16 for v_mfma_f32_32x32x8f16,
+    // which has the same k per lane.
+    if (op.aFp8Format() && op.bFp8Format()) {
+      coreType = MatrixCoreType::FP32_FP16_FP16_FP32;
+      for (auto &it : ha)
+        it.second = unpackFp8x4(it.second, *op.aFp8Format());
+      for (auto &it : hb)
+        it.second = unpackFp8x4(it.second, *op.bFp8Format());
+    }
 
-    auto shapePerCTA = getShapePerCTA(dLayout);
-    auto sizePerThread = getSizePerThread(dLayout);
+    Type dstElemTy = typeConverter->convertType(dTensorTy.getElementType());
+    Type accTy = vec_ty(dstElemTy, 16);
+    Value zero = i32_val(0);
 
-    Value _0 = i32_val(0);
+    for (int m = 0; m < numRepM; ++m)
+      for (int n = 0; n < numRepN; ++n) {
+        unsigned accBase = 16 * (m * numRepN + n);
+        Value acc = undef(accTy);
+        for (unsigned e = 0; e < 16; ++e)
+          acc = insert_element(accTy, acc, fc[accBase + e], i32_val(e));
+        for (int k = 0; k < numRepK; ++k)
+          acc = generateMFMAOp(coreType, accTy, ha[{m, k}], hb[{n, k}], acc,
+                               zero);
+        for (unsigned e = 0; e < 16; ++e)
+          fc[accBase + e] = extract_element(dstElemTy, acc, i32_val(e));
+      }
 
-    Value mContig = i32_val(sizePerThread[order[1]]);
+    // replace with new packed result
+    Type structTy = LLVM::LLVMStructType::getLiteral(
+        ctx, SmallVector<Type>(fc.size(), dstElemTy));
+    Value res = getStructFromElements(loc, fc, rewriter, structTy);
+    rewriter.replaceOp(op, res);
 
-    // threadId in blocked layout
-    auto threadIds =
-        getThreadIds(thread, shapePerCTA, sizePerThread, order, rewriter, loc);
-    Value threadIdM = threadIds[0];
+    return success();
+  }
 
-    Value offA0 = isARow ? _0 : mul(threadIdM, mContig);
-    Value offA1 = isARow ? mul(threadIdM, mContig) : _0;
-    SmallVector<Value> aOff(aNumPtr);
-    for (int i = 0; i < aNumPtr; ++i) {
-      aOff[i] = add(mul(offA0, strideA0), mul(offA1, strideA1));
+private:
+  // Unpack the four fp8 values of \param v, an i32, to a <4 x f16>.
+  Value unpackFp8x4(Value v, Fp8Format format) const {
+    auto [lo, hi] = LLVM::convertFp8x4ToFp16x4(loc, rewriter, v, format);
+    Type i32x2Ty = vec_ty(type::i32Ty(ctx), 2);
+    Value packed = undef(i32x2Ty);
+    packed = insert_element(i32x2Ty, packed, lo, i32_val(0));
+    packed = insert_element(i32x2Ty, packed, hi, i32_val(1));
+    return bitcast(packed, vec_ty(type::f16Ty(ctx), 4));
+  }
+
+  Value generateMFMAOp(MatrixCoreType coreType, Type accTy, Value valA,
+                       Value valB, Value valC, Value zero) const {
+    // cbsz, abid and blgp are all zero: no broadcast between blocks/lanes.
+    SmallVector<Value> args{valA, valB, valC, zero, zero, zero};
+    switch (coreType) {
+    case MatrixCoreType::FP32_FP16_FP16_FP32:
+      return rewriter.create<ROCDL::mfma_f32_32x32x8f16>(loc, accTy, args);
+    case MatrixCoreType::FP32_BF16_BF16_FP32:
+      return rewriter.create<ROCDL::mfma_f32_32x32x4bf16>(loc, accTy, args);
+    case MatrixCoreType::FP32_FP32_FP32_FP32:
+      return rewriter.create<ROCDL::mfma_f32_32x32x2f32>(loc, accTy, args);
+    case MatrixCoreType::INT32_INT8_INT8_INT32:
+      return rewriter.create<ROCDL::mfma_i32_32x32x8i8>(loc, accTy, args);
+    default:
+      llvm::report_fatal_error("Unsupported mfma operand type");
     }
-    auto elemTy = A.getType().cast<RankedTensorType>().getElementType();
+  }
 
-    Type ptrTy = ptr_ty(elemTy);
-    SmallVector<Value> aPtrs(aNumPtr);
-    for (int i = 0; i < aNumPtr; ++i)
-      aPtrs[i] = gep(ptrTy, aSmem.base, aOff[i]);
-
-    SmallVector<Value> vas;
-
-    int mShapePerCTA = getShapePerCTAForMN(dLayout, true /*isM*/);
-    int mSizePerThread = getSizePerThreadForMN(dLayout, true /*isM*/);
-
-    for (unsigned k = 0; k < K; ++k)
-      for (unsigned m = 0; m < M; m += mShapePerCTA)
-        for (unsigned mm = 0; mm < mSizePerThread; ++mm) {
-          Value offset =
-              add(mul(i32_val(m + mm), strideAM), mul(i32_val(k), strideAK));
-          Value pa = gep(ptrTy, aPtrs[0], offset);
-          Value va = load(pa);
-          vas.emplace_back(va);
-        }
+  // Get the offset of element (\param i0, \param i1) of a shared memory tile,
+  // taking the swizzling of \param sharedLayout into account. The returned
+  // offset is relative to \param base.
+  Value getSwizzledOffset(const SharedMemoryObject &smemObj,
+                          SharedEncodingAttr sharedLayout, Value i0, Value i1,
+                          Value &base) const {
+    auto order = sharedLayout.getOrder();
+    SmallVector<Value> idx = {i0, i1};
+    Value outer = idx[order[1]];
+    Value inner = idx[order[0]];
+    base = smemObj.base;
+    int maxPhase = sharedLayout.getMaxPhase();
+    if (maxPhase > 1) {
+      int perPhase = sharedLayout.getPerPhase();
+      int vec = sharedLayout.getVec();
+      // The swizzling pattern is relative to the originally allocated tile.
+      inner = add(inner, smemObj.getCSwizzleOffset(order[0]));
+      base = smemObj.getBaseBeforeSwizzle(order[0], loc, rewriter);
+      Value phase = urem(udiv(outer, i32_val(perPhase)), i32_val(maxPhase));
+      Value vecId = udiv(inner, i32_val(vec));
+      inner = add(mul(xor_(vecId, phase), i32_val(vec)),
+                  urem(inner, i32_val(vec)));
+    }
+    return add(mul(outer, smemObj.strides[order[1]]),
+               mul(inner, smemObj.strides[order[0]]));
+  }
 
-    return getStructFromValueTable(vas, rewriter, loc, elemTy);
+  // Load the k elements that one lane contributes to a single mfma, starting
+  // at element (\param row, \param col) and running along \param kDim.
+  Value loadOperand(RankedTensorType tensorTy,
+                    const SharedMemoryObject &smemObj, Value row, Value col,
+                    unsigned kDim) const {
+    auto sharedLayout = tensorTy.getEncoding().cast<SharedEncodingAttr>();
+    auto coreType = getMatrixCoreTypeFromOperand(tensorTy);
+    int kPerLane = getMfmaInstrK(coreType) / 2;
+    Type elemTy = typeConverter->convertType(tensorTy.getElementType());
+    Type elemPtrTy = ptr_ty(elemTy, 3);
+    Type operandTy = getMfmaOperandTy(coreType, ctx);
+
+    if (kPerLane == 1) {
+      Value base;
+      Value offset = getSwizzledOffset(smemObj, sharedLayout, row, col, base);
+      return load(gep(elemPtrTy, base, offset));
+    }
+
+    Type vecTy = vec_ty(elemTy, kPerLane);
+    Value vec;
+    // k is contiguous in shared memory and the run of kPerLane elements does
+    // not cross a swizzling vector: use a single vectorized load.
+    bool kContig = sharedLayout.getOrder()[0] == kDim;
+    if (kContig && (sharedLayout.getMaxPhase() == 1 ||
+                    sharedLayout.getVec() % kPerLane == 0)) {
+      Value base;
+      Value offset = getSwizzledOffset(smemObj, sharedLayout, row, col, base);
+      Value ptr = bitcast(gep(elemPtrTy, base, offset), ptr_ty(vecTy, 3));
+      vec = load(ptr);
+    } else {
+      vec = undef(vecTy);
+      for (int e = 0; e < kPerLane; ++e) {
+        Value r = kDim == 0 ? add(row, i32_val(e)) : row;
+        Value c = kDim == 1 ? add(col, i32_val(e)) : col;
+        Value base;
+        Value offset = getSwizzledOffset(smemObj, sharedLayout, r, c, base);
+        Value val = load(gep(elemPtrTy, base, offset));
+        vec = insert_element(vecTy, vec, val, i32_val(e));
+      }
+    }
+    if (vecTy != operandTy)
+      vec = bitcast(vec, operandTy);
+    return vec;
   }
 
-  Value loadB(Value B, Value llB, BlockedEncodingAttr dLayout, Value thread,
-              Location loc, ConversionPatternRewriter &rewriter) const {
-    auto bTensorTy = B.getType().cast<RankedTensorType>();
-    auto bLayout = bTensorTy.getEncoding().cast<SharedEncodingAttr>();
-    auto bShape = bTensorTy.getShape();
+  // Compose a map of Values to a LLVM::Struct, with the (mn, k) coordinates
+  // in row-major order.
+  Value composeValuesToDotOperandLayoutStruct(const ValueTable &vals, int n0,
+                                              int n1) const {
+    std::vector<Value> elems;
+    for (int i = 0; i < n0; ++i)
+      for (int j = 0; j < n1; ++j)
+        elems.push_back(vals.at({i, j}));
 
-    auto bOrder = bLayout.getOrder();
-    auto order = dLayout.getOrder();
+    assert(!elems.empty());
 
-    bool isBRow = bOrder[0] == 1;
+    Type elemTy = elems[0].getType();
+    Type structTy = LLVM::LLVMStructType::getLiteral(
+        ctx, SmallVector<Type>(elems.size(), elemTy));
+    return getStructFromElements(loc, elems, rewriter, structTy);
+  }
 
-    auto bSmem = getSharedMemoryObjectFromStruct(loc, llB, rewriter);
-    Value strideBN = bSmem.strides[1];
-    Value strideBK = bSmem.strides[0];
-    Value strideB0 = isBRow ? strideBN : strideBK;
-    Value strideB1 = isBRow ? strideBK : strideBN;
-    int bNumPtr = 8;
-    int K = bShape[0];
-    int N = bShape[1];
+  ValueTable getValuesFromDotOperandLayoutStruct(Value value, int n0,
+                                                 int n1) const {
+    auto elems = getElementsFromStruct(loc, value, rewriter);
 
-    auto shapePerCTA = getShapePerCTA(dLayout);
-    auto sizePerThread = getSizePerThread(dLayout);
+    int offset{};
+    ValueTable vals;
+    for (int i = 0; i < n0; ++i)
+      for (int j = 0; j < n1; ++j)
+        vals[{i, j}] = elems[offset++];
+    return vals;
+  }
+};
 
-    Value _0 = i32_val(0);
+// Helper for conversion of FMA DotOp.
+//
+// The operands and the result have rank 2, or rank 3 with a leading batch
+// dimension. Each thread holds the elements of its batches one batch after
+// the other, so that a batched dot is a 2D dot per batch.
+struct DotOpFMAConversionHelper {
+  Attribute layout;
+  MLIRContext *ctx{};
 
-    Value nContig = i32_val(sizePerThread[order[0]]);
+  using ValueTable = std::map<std::pair<int, int>, Value>;
 
-    // threadId in blocked layout
-    auto threadIds =
-        getThreadIds(thread, shapePerCTA, sizePerThread, order, rewriter, loc);
-    Value threadIdN = threadIds[1];
+  explicit DotOpFMAConversionHelper(Attribute layout)
+      : layout(layout), ctx(layout.getContext()) {}
 
-    Value offB0 = isBRow ? mul(threadIdN, nContig) : _0;
-    Value offB1 = isBRow ? _0 : mul(threadIdN, nContig);
-    SmallVector<Value> bOff(bNumPtr);
-    for (int i = 0; i < bNumPtr; ++i) {
-      bOff[i] = add(mul(offB0, strideB0), mul(offB1, strideB1));
+  // The coordinates of the thread in units of sizePerThread, from its lane
+  // and warp ids
+  SmallVector<Value> getThreadIds(Value threadId, BlockedEncodingAttr layout,
+                                  ConversionPatternRewriter &rewriter,
+                                  Location loc) const {
+    auto threadsPerWarp = layout.getThreadsPerWarp();
+    auto warpsPerCTA = layout.getWarpsPerCTA();
+    Value warpSize = i32_val(product<unsigned>(threadsPerWarp));
+    Value laneId = urem(threadId, warpSize);
+    Value warpId = udiv(threadId, warpSize);
+    SmallVector<Value> threadIds(threadsPerWarp.size());
+    for (unsigned d : layout.getOrder()) {
+      Value lane = urem(laneId, i32_val(threadsPerWarp[d]));
+      laneId = udiv(laneId, i32_val(threadsPerWarp[d]));
+      Value warp = urem(warpId, i32_val(warpsPerCTA[d]));
+      warpId = udiv(warpId, i32_val(warpsPerCTA[d]));
+      threadIds[d] = add(mul(warp, i32_val(threadsPerWarp[d])), lane);
     }
-    auto elemTy = B.getType().cast<RankedTensorType>().getElementType();
+    return threadIds;
+  }
 
-    Type ptrTy = ptr_ty(elemTy);
-    SmallVector<Value> bPtrs(bNumPtr);
-    for (int i = 0; i < bNumPtr; ++i)
-      bPtrs[i] = gep(ptrTy, bSmem.base, bOff[i]);
-
-    SmallVector<Value> vbs;
-
-    int nShapePerCTA = getShapePerCTAForMN(dLayout, false /*isM*/);
-    int nSizePerThread = getSizePerThreadForMN(dLayout, false /*isM*/);
-
-    for (unsigned k = 0; k < K; ++k)
-      for (unsigned n = 0; n < N; n += nShapePerCTA)
-        for (unsigned nn = 0; nn < nSizePerThread; ++nn) {
-          Value offset =
-              add(mul(i32_val(n + nn), strideBN), mul(i32_val(k), strideBK));
-          Value pb = gep(ptrTy, bPtrs[0], offset);
-          Value vb = load(pb);
-          vbs.emplace_back(vb);
-        }
+  Value loadA(Value A, Value llA, BlockedEncodingAttr dLayout, Value thread,
+              Location loc, ConversionPatternRewriter &rewriter) const {
+    return loadOperand(A, llA, dLayout, thread, /*isA=*/true, loc, rewriter);
+  }
 
-    return getStructFromValueTable(vbs, rewriter, loc, elemTy);
+  Value loadB(Value B, Value llB, BlockedEncodingAttr dLayout, Value thread,
+              Location loc, ConversionPatternRewriter &rewriter) const {
+    return loadOperand(B, llB, dLayout, thread, /*isA=*/false, loc, rewriter);
   }
 
-  ValueTable getValueTableFromStruct(Value val, int K, int n0, int shapePerCTA,
-                                     int sizePerThread,
-                                     ConversionPatternRewriter &rewriter,
-                                     Location loc) const {
-    ValueTable res;
+  // Loads the elements of $a (m, k) or $b (k, n) the thread multiplies, for
+  // each batch, k, and m (resp. n)
+  Value loadOperand(Value T, Value llT, BlockedEncodingAttr dLayout,
+                    Value thread, bool isA, Location loc,
+                    ConversionPatternRewriter &rewriter) const {
+    auto tensorTy = T.getType().cast<RankedTensorType>();
+    auto shape = tensorTy.getShape();
+    unsigned rank = shape.size();
+    unsigned kDim = isA ? rank - 1 : rank - 2;
+    // the dimension of m (resp. n), in the operand and in the result
+    unsigned nonKDim = isA ? rank - 2 : rank - 1;
+    int K = shape[kDim];
+    int nonK = shape[nonKDim];
+
+    auto smem = getSharedMemoryObjectFromStruct(loc, llT, rewriter);
+    Value strideK = smem.strides[kDim];
+    Value strideNonK = smem.strides[nonKDim];
+
+    auto sizePerThread = getSizePerThread(dLayout);
+    auto threadIds = getThreadIds(thread, dLayout, rewriter, loc);
+    Value offset = mul(mul(threadIds[nonKDim], i32_val(sizePerThread[nonKDim])),
+                       strideNonK);
+    if (rank == 3)
+      offset = add(offset, mul(mul(threadIds[0], i32_val(sizePerThread[0])),
+                               smem.strides[0]));
+    auto elemTy = tensorTy.getElementType();
+    Type ptrTy = ptr_ty(elemTy);
+    Value ptr = gep(ptrTy, smem.base, offset);
+
+    int shapePerCTA = getShapePerCTAForMN(dLayout, isA);
+    int sizePerThreadNonK = getSizePerThreadForMN(dLayout, isA);
+    SmallVector<Value> vals;
+    for (int b : getBatchOffsets(dLayout, shape))
+      for (unsigned k = 0; k < K; ++k)
+        for (unsigned m = 0; m < nonK; m += shapePerCTA)
+          for (unsigned mm = 0; mm < sizePerThreadNonK; ++mm) {
+            Value elemOffset = add(mul(i32_val(m + mm), strideNonK),
+                                   mul(i32_val(k), strideK));
+            if (rank == 3)
+              elemOffset = add(elemOffset, mul(i32_val(b), smem.strides[0]));
+            vals.push_back(load(gep(ptrTy, ptr, elemOffset)));
+          }
+
+    return getStructFromValueTable(vals, rewriter, loc, elemTy);
+  }
+
+  // The tables of (m, k) -> value of each batch of the thread
+  SmallVector<ValueTable>
+  getValueTableFromStruct(Value val, int numBatches, int K, int n0,
+                          int shapePerCTA, int sizePerThread,
+                          ConversionPatternRewriter &rewriter,
+                          Location loc) const {
+    SmallVector<ValueTable> res(numBatches);
     auto elems = getElementsFromStruct(loc, val, rewriter);
     int index = 0;
-    for (unsigned k = 0; k < K; ++k) {
-      for (unsigned m = 0; m < n0; m += shapePerCTA)
-        for (unsigned mm = 0; mm < sizePerThread; ++mm) {
-          res[{m + mm, k}] = elems[index++];
-        }
-    }
+    for (ValueTable &table : res)
+      for (unsigned k = 0; k < K; ++k) {
+        for (unsigned m = 0; m < n0; m += shapePerCTA)
+          for (unsigned mm = 0; mm < sizePerThread; ++mm) {
+            table[{m + mm, k}] = elems[index++];
+          }
+      }
     return res;
   }
 
@@ -1885,46 +2523,50 @@ struct DotOpFMAConversionHelper {
     return getStructFromElements(loc, elems, rewriter, structTy);
   }
 
+  // The offsets along the batch dimension of the batches of a thread,
+  // relative to its first one. A single batch if the dot is not batched.
+  static SmallVector<int> getBatchOffsets(BlockedEncodingAttr layout,
+                                          ArrayRef<int64_t> shape) {
+    if (shape.size() != 3)
+      return {0};
+    int shapePerCTA = getShapePerCTA(layout)[0];
+    int sizePerThread = getSizePerThread(layout)[0];
+    SmallVector<int> offsets;
+    for (int b = 0; b < shape[0]; b += shapePerCTA)
+      for (int bb = 0; bb < sizePerThread; ++bb)
+        offsets.push_back(b + bb);
+    return offsets;
+  }
+
   // get number of elements per thread for $a or $b.
   static int getNumElemsPerThread(ArrayRef<int64_t> shape,
                                   DotOperandEncodingAttr dotOpLayout) {
     auto blockedLayout = dotOpLayout.getParent().cast<BlockedEncodingAttr>();
-    auto shapePerCTA = getShapePerCTA(blockedLayout);
-    auto sizePerThread = getSizePerThread(blockedLayout);
-
-    // TODO[Superjomn]: we assume the k aixs is fixed for $a and $b here, fix it
-    // if not.
-    int K = dotOpLayout.getOpIdx() == 0 ? shape[1] : shape[0];
-    int otherDim = dotOpLayout.getOpIdx() == 1 ? shape[1] : shape[0];
+    unsigned rank = shape.size();
 
     bool isM = dotOpLayout.getOpIdx() == 0;
+    int K = isM ? shape[rank - 1] : shape[rank - 2];
+    int otherDim = isM ? shape[rank - 2] : shape[rank - 1];
+
     int shapePerCTAMN = getShapePerCTAForMN(blockedLayout, isM);
     int sizePerThreadMN = getSizePerThreadForMN(blockedLayout, isM);
-    return K * std::max<int>(otherDim / shapePerCTAMN, 1) * sizePerThreadMN;
+    int numBatches = getBatchOffsets(blockedLayout, shape).size();
+    return numBatches * K * std::max<int>(otherDim / shapePerCTAMN, 1) *
+           sizePerThreadMN;
   }
 
-  // Get shapePerCTA for M or N axis.
+  // Get shapePerCTA for M or N axis, the last two of the result.
   static int getShapePerCTAForMN(BlockedEncodingAttr layout, bool isM) {
-    auto order = layout.getOrder();
     auto shapePerCTA = getShapePerCTA(layout);
-
-    int mShapePerCTA =
-        order[0] == 1 ? shapePerCTA[order[1]] : shapePerCTA[order[0]];
-    int nShapePerCTA =
-        order[0] == 0 ? shapePerCTA[order[1]] : shapePerCTA[order[0]];
-    return isM ? mShapePerCTA : nShapePerCTA;
+    unsigned rank = shapePerCTA.size();
+    return isM ? shapePerCTA[rank - 2] : shapePerCTA[rank - 1];
   }
 
-  // Get sizePerThread for M or N axis.
+  // Get sizePerThread for M or N axis, the last two of the result.
   static int getSizePerThreadForMN(BlockedEncodingAttr layout, bool isM) {
-    auto order = layout.getOrder();
     auto sizePerThread = getSizePerThread(layout);
-
-    int mSizePerThread =
-        order[0] == 1 ? sizePerThread[order[1]] : sizePerThread[order[0]];
-    int nSizePerThread =
-        order[0] == 0 ? sizePerThread[order[1]] : sizePerThread[order[0]];
-    return isM ? mSizePerThread : nSizePerThread;
+    unsigned rank = sizePerThread.size();
+    return isM ? sizePerThread[rank - 2] : sizePerThread[rank - 1];
   }
 };
 
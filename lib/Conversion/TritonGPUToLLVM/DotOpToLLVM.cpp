@@ -8,14 +8,58 @@ using namespace mlir::triton;
 using ::mlir::LLVM::DotOpFMAConversionHelper;
 using ::mlir::LLVM::DotOpMmaV1ConversionHelper;
 using ::mlir::LLVM::getElementsFromStruct;
+using ::mlir::LLVM::getSharedMemoryObjectFromStruct;
 using ::mlir::LLVM::getStructFromElements;
+using ::mlir::LLVM::MFMAConversionHelper;
 using ::mlir::LLVM::MMA16816ConversionHelper;
 using ::mlir::triton::gpu::DotOperandEncodingAttr;
+using ::mlir::triton::gpu::MfmaEncodingAttr;
 using ::mlir::triton::gpu::MmaEncodingAttr;
 
+#ifdef USE_ROCM
+// c + a[0] * b[0] + a[1] * b[1] for vectors of 2 f16, by v_dot2_f32_f16
+static Value emitFDot2(Location loc, ConversionPatternRewriter &rewriter,
+                       Value a, Value b, Value c) {
+  StringRef funcName = "llvm.amdgcn.fdot2";
+  auto moduleOp =
+      rewriter.getBlock()->getParent()->getParentOfType<ModuleOp>();
+  auto funcOp = moduleOp.lookupSymbol<LLVM::LLVMFuncOp>(funcName);
+  if (!funcOp) {
+    OpBuilder builder(moduleOp.getBodyRegion());
+    Type vecTy = vec_ty(f16_ty, 2);
+    funcOp = builder.create<LLVM::LLVMFuncOp>(
+        loc, funcName,
+        LLVM::LLVMFunctionType::get(
+            f32_ty, {vecTy, vecTy, f32_ty, rewriter.getI1Type()}));
+  }
+  Value clamp = int_val(1, 0);
+  return rewriter.create<LLVM::CallOp>(loc, funcOp, ValueRange{a, b, c, clamp})
+      .getResult(0);
+}
+#else
+// c + the dot product of the 4 i8 packed in each of a and b, by dp4a
+static Value emitDp4a(Location loc, ConversionPatternRewriter &rewriter,
+                      Value a, Value b, Value c) {
+  PTXBuilder builder;
+  auto &dp4a = *builder.create("dp4a.s32.s32");
+  auto *dOpr = builder.newOperand("=r");
+  auto *aOpr = builder.newOperand(a, "r");
+  auto *bOpr = builder.newOperand(b, "r");
+  auto *cOpr = builder.newOperand(c, "r");
+  dp4a(dOpr, aOpr, bOpr, cOpr);
+  return builder.launch(rewriter, loc, i32_ty, false);
+}
+#endif
+
 struct DotOpConversion : public ConvertTritonGPUOpToLLVMPattern<triton::DotOp> {
-  using ConvertTritonGPUOpToLLVMPattern<
-      triton::DotOp>::ConvertTritonGPUOpToLLVMPattern;
+  DotOpConversion(LLVMTypeConverter &typeConverter,
+                  const Allocation *allocation, Value smem,
+                  int computeCapability, int ptxVersion,
+                  PatternBenefit benefit = 1)
+      : ConvertTritonGPUOpToLLVMPattern<triton::DotOp>(typeConverter,
+                                                       allocation, smem,
+                                                       benefit),
+        computeCapability(computeCapability), ptxVersion(ptxVersion) {}
 
   LogicalResult
   matchAndRewrite(triton::DotOp op, OpAdaptor adaptor,
@@ -26,8 +70,7 @@ struct DotOpConversion : public ConvertTritonGPUOpToLLVMPattern<triton::DotOp> {
 
     // Here we assume the DotOp's operands always comes from shared memory.
     auto AShape = A.getType().cast<RankedTensorType>().getShape();
-    size_t reduceAxis = 1;
-    unsigned K = AShape[reduceAxis];
+    unsigned K = AShape.back();
     bool isOuter = K == 1;
 
     MmaEncodingAttr mmaLayout = D.getType()
@@ -39,11 +82,20 @@ struct DotOpConversion : public ConvertTritonGPUOpToLLVMPattern<triton::DotOp> {
         return convertMMA884(op, adaptor, rewriter);
       if (mmaLayout.isAmpere())
         return convertMMA16816(op, adaptor, rewriter);
+      if (mmaLayout.isHopper())
+        return convertWGMMA(op, adaptor, rewriter);
 
       llvm::report_fatal_error(
           "Unsupported MMA kind found when converting DotOp to LLVM.");
     }
 
+    MfmaEncodingAttr mfmaLayout = D.getType()
+                                      .cast<RankedTensorType>()
+                                      .getEncoding()
+                                      .dyn_cast<MfmaEncodingAttr>();
+    if (!isOuter && mfmaLayout && supportMFMA(op))
+      return convertMFMA(op, adaptor, rewriter);
+
     if (D.getType()
             .cast<RankedTensorType>()
             .getEncoding()
@@ -55,6 +107,39 @@ struct DotOpConversion : public ConvertTritonGPUOpToLLVMPattern<triton::DotOp> {
   }
 
 private:
+  // Convert to v_mfma_*_32x32x*
+  LogicalResult convertMFMA(triton::DotOp op, OpAdaptor adaptor,
+                            ConversionPatternRewriter &rewriter) const {
+    auto loc = op.getLoc();
+    auto mfmaLayout = op.getResult()
+                          .getType()
+                          .cast<RankedTensorType>()
+                          .getEncoding()
+                          .cast<MfmaEncodingAttr>();
+
+    Value A = op.a();
+    Value B = op.b();
+    Value C = op.c();
+
+    MFMAConversionHelper mfmaHelper(mfmaLayout, getThreadId(rewriter, loc),
+                                    rewriter, getTypeConverter(), loc);
+
+    auto ATensorTy = A.getType().cast<RankedTensorType>();
+    auto BTensorTy = B.getType().cast<RankedTensorType>();
+
+    assert(ATensorTy.getEncoding().isa<DotOperandEncodingAttr>() &&
+           BTensorTy.getEncoding().isa<DotOperandEncodingAttr>() &&
+           "Both $a and %b should be DotOperand layout.");
+
+    Value loadedA, loadedB, loadedC;
+    loadedA = adaptor.a();
+    loadedB = adaptor.b();
+    loadedC = mfmaHelper.loadC(op.c(), adaptor.c());
+
+    return mfmaHelper.convertDot(A, B, C, op.d(), loadedA, loadedB, loadedC,
+                                 op, adaptor);
+  }
+
   // Convert to mma.m16n8k16
   LogicalResult convertMMA16816(triton::DotOp op, OpAdaptor adaptor,
                                 ConversionPatternRewriter &rewriter) const {
@@ -85,9 +170,40 @@ private:
     loadedB = adaptor.b();
     loadedC = mmaHelper.loadC(op.c(), adaptor.c());
 
+    // fp8 mma instructions were introduced with sm_89 and PTX ISA 8.4
+    bool hasFp8MMA = computeCapability >= 89 && ptxVersion >= 84;
     return mmaHelper.convertDot(A, B, C, op.d(), loadedA, loadedB, loadedC, op,
-                                adaptor);
+                                adaptor, hasFp8MMA);
   }
+
+  // Convert to wgmma.mma_async.m64nNk16
+  LogicalResult convertWGMMA(triton::DotOp op, OpAdaptor adaptor,
+                             ConversionPatternRewriter &rewriter) const {
+    auto loc = op.getLoc();
+    auto mmaLayout = op.getResult()
+                         .getType()
+                         .cast<RankedTensorType>()
+                         .getEncoding()
+                         .cast<MmaEncodingAttr>();
+
+    Value A = op.a();
+    Value C = op.c();
+
+    // $b is the shared memory object of the convert_layout making it
+    auto cvtOp = op.b().getDefiningOp<triton::gpu::ConvertLayoutOp>();
+    if (!cvtOp || !isSharedEncoding(cvtOp.src()))
+      llvm::report_fatal_error("wgmma expects $b converted from shared memory");
+    auto BSharedTy = cvtOp.src().getType().cast<RankedTensorType>();
+    auto smemObjB = getSharedMemoryObjectFromStruct(loc, adaptor.b(), rewriter);
+
+    MMA16816ConversionHelper mmaHelper(A.getType(), mmaLayout,
+                                       getThreadId(rewriter, loc), rewriter,
+                                       getTypeConverter(), loc);
+    Value loadedC = mmaHelper.loadC(C, adaptor.c());
+    return mmaHelper.convertWGMMA(A, op.d(), BSharedTy, adaptor.a(), smemObjB,
+                                  loadedC, op);
+  }
+
   /// Convert to mma.m8n8k4
   LogicalResult convertMMA884(triton::DotOp op, OpAdaptor adaptor,
                               ConversionPatternRewriter &rewriter) const {
@@ -243,47 +359,138 @@ private:
     auto cc = getElementsFromStruct(loc, adaptor.c(), rewriter);
 
     DotOpFMAConversionHelper helper(dLayout);
+    using ValueTable = DotOpFMAConversionHelper::ValueTable;
     Value llA = adaptor.a();
     Value llB = adaptor.b();
 
-    auto sizePerThread = getSizePerThread(dLayout);
-    auto shapePerCTA = getShapePerCTA(dLayout);
-
-    int K = aShape[1];
-    int M = aShape[0];
-    int N = bShape[1];
-
-    int mShapePerCTA =
-        order[0] == 1 ? shapePerCTA[order[1]] : shapePerCTA[order[0]];
-    int mSizePerThread =
-        order[0] == 1 ? sizePerThread[order[1]] : sizePerThread[order[0]];
-    int nShapePerCTA =
-        order[0] == 0 ? shapePerCTA[order[1]] : shapePerCTA[order[0]];
-    int nSizePerThread =
-        order[0] == 0 ? sizePerThread[order[1]] : sizePerThread[order[0]];
-
-    auto has = helper.getValueTableFromStruct(llA, K, M, mShapePerCTA,
-                                              mSizePerThread, rewriter, loc);
-    auto hbs = helper.getValueTableFromStruct(llB, K, N, nShapePerCTA,
-                                              nSizePerThread, rewriter, loc);
+    // a batched dot is a dot per batch, the batch dimension being the slowest
+    // varying one of the result
+    unsigned rank = aShape.size();
+    assert((rank == 2 || order[rank - 1] == 0) &&
+           "Unexpected order of a batched dot");
+    int K = aShape[rank - 1];
+    int M = aShape[rank - 2];
+    int N = bShape[rank - 1];
+
+    int mShapePerCTA = helper.getShapePerCTAForMN(dLayout, true /*isM*/);
+    int mSizePerThread = helper.getSizePerThreadForMN(dLayout, true /*isM*/);
+    int nShapePerCTA = helper.getShapePerCTAForMN(dLayout, false /*isM*/);
+    int nSizePerThread = helper.getSizePerThreadForMN(dLayout, false /*isM*/);
+    int numBatches =
+        helper.getBatchOffsets(dLayout, dTensorTy.getShape()).size();
+
+    auto has = helper.getValueTableFromStruct(
+        llA, numBatches, K, M, mShapePerCTA, mSizePerThread, rewriter, loc);
+    auto hbs = helper.getValueTableFromStruct(
+        llB, numBatches, K, N, nShapePerCTA, nSizePerThread, rewriter, loc);
+    // fp8 operands are stored as i8
+    auto decodeFp8 = [&](SmallVector<ValueTable> &tables,
+                         Optional<Fp8Format> format) {
+      if (!format)
+        return;
+      for (ValueTable &vals : tables)
+        for (auto &it : vals) {
+          Value bits = LLVM::convertFp8ToFp16Bits(
+              loc, rewriter, zext(i16_ty, it.second), *format);
+          it.second = rewriter.create<LLVM::FPExtOp>(loc, f32_ty,
+                                                     bitcast(bits, f16_ty));
+        }
+    };
+    decodeFp8(has, op.aFp8Format());
+    decodeFp8(hbs, op.bFp8Format());
+
+    // Groups of kWidth consecutive k are reduced by one packed dot product
+    // where the target has one for the operand types: dp4a for int8 on NVIDIA
+    // GPUs, v_dot2_f32_f16 for f16 on AMD GPUs. Other operands are widened to
+    // the type of the accumulator.
+    bool isIntDot = dTensorTy.getElementType().isInteger(32);
+    Type aElemTy = has[0].begin()->second.getType();
+    Type bElemTy = hbs[0].begin()->second.getType();
+    int kWidth = 1;
+#ifdef USE_ROCM
+    if (aElemTy.isF16() && bElemTy.isF16() && K % 2 == 0)
+      kWidth = 2;
+#else
+    if (isIntDot && aElemTy.isInteger(8) && bElemTy.isInteger(8) && K % 4 == 0)
+      kWidth = 4;
+#endif
+    auto widen = [&](ValueTable &vals) {
+      for (auto &it : vals) {
+        Type ty = it.second.getType();
+        if (isIntDot) {
+          if (ty != i32_ty)
+            it.second = sext(i32_ty, it.second);
+          continue;
+        }
+        // bf16 is stored as i16
+        if (ty.isInteger(16))
+          it.second = bitcast(it.second, bf16_ty);
+        if (!ty.isF32())
+          it.second = rewriter.create<LLVM::FPExtOp>(loc, f32_ty, it.second);
+      }
+    };
+    // The packed operands are built once per thread, and reused across the
+    // other dimension of the result
+    auto pack = [&](ValueTable &vals, int n0, int shapePerCTA,
+                    int sizePerThread) {
+      ValueTable packed;
+      Type elemTy = vals.begin()->second.getType();
+      Type vecTy = vec_ty(elemTy, kWidth);
+      for (int k = 0; k < K; k += kWidth)
+        for (int m = 0; m < n0; m += shapePerCTA)
+          for (int mm = 0; mm < sizePerThread; ++mm) {
+            Value vec = undef(vecTy);
+            for (int i = 0; i < kWidth; ++i)
+              vec = insert_element(vecTy, vec, vals[{m + mm, k + i}],
+                                   i32_val(i));
+            if (elemTy.isInteger(8))
+              vec = bitcast(vec, i32_ty);
+            packed[{m + mm, k / kWidth}] = vec;
+          }
+      vals = std::move(packed);
+    };
+    for (int batch = 0; batch < numBatches; ++batch) {
+      if (kWidth == 1) {
+        widen(has[batch]);
+        widen(hbs[batch]);
+      } else {
+        pack(has[batch], M, mShapePerCTA, mSizePerThread);
+        pack(hbs[batch], N, nShapePerCTA, nSizePerThread);
+      }
+    }
+    auto dot = [&](Value a, Value b, Value c) -> Value {
+      if (kWidth == 1 && isIntDot)
+        return add(mul(a, b), c);
+      if (kWidth == 1)
+        return rewriter.create<LLVM::FMulAddOp>(loc, a, b, c);
+#ifdef USE_ROCM
+      return emitFDot2(loc, rewriter, a, b, c);
+#else
+      return emitDp4a(loc, rewriter, a, b, c);
+#endif
+    };
 
     SmallVector<Value> ret = cc;
-    bool isCRow = order[0] == 1;
-
-    for (unsigned k = 0; k < K; k++) {
-      for (unsigned m = 0; m < M; m += mShapePerCTA)
-        for (unsigned n = 0; n < N; n += nShapePerCTA)
-          for (unsigned mm = 0; mm < mSizePerThread; ++mm)
-            for (unsigned nn = 0; nn < nSizePerThread; ++nn) {
-              int mIdx = m / mShapePerCTA * mSizePerThread + mm;
-              int nIdx = n / nShapePerCTA * nSizePerThread + nn;
-
-              int z = isCRow ? mIdx * N / nShapePerCTA * mSizePerThread + nIdx
-                             : nIdx * M / mShapePerCTA * nSizePerThread + mIdx;
-              ret[z] = rewriter.create<LLVM::FMulAddOp>(
-                  loc, has[{m + mm, k}], hbs[{n + nn, k}], ret[z]);
-            }
-    }
+    bool isCRow = order[0] == rank - 1;
+    int elemsPerBatch = ret.size() / numBatches;
+
+    for (int batch = 0; batch < numBatches; ++batch)
+      for (unsigned k = 0; k < K / kWidth; k++) {
+        for (unsigned m = 0; m < M; m += mShapePerCTA)
+          for (unsigned n = 0; n < N; n += nShapePerCTA)
+            for (unsigned mm = 0; mm < mSizePerThread; ++mm)
+              for (unsigned nn = 0; nn < nSizePerThread; ++nn) {
+                int mIdx = m / mShapePerCTA * mSizePerThread + mm;
+                int nIdx = n / nShapePerCTA * nSizePerThread + nn;
+
+                int z = isCRow
+                            ? mIdx * N / nShapePerCTA * mSizePerThread + nIdx
+                            : nIdx * M / mShapePerCTA * nSizePerThread + mIdx;
+                z += batch * elemsPerBatch;
+                ret[z] = dot(has[batch][{m + mm, k}], hbs[batch][{n + nn, k}],
+                             ret[z]);
+              }
+      }
 
     auto res = getStructFromElements(
         loc, ret, rewriter,
@@ -292,12 +499,48 @@ private:
 
     return success();
   }
+
+  int computeCapability;
+  int ptxVersion;
+};
+
+struct SparseDotOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::SparseDotOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::SparseDotOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  // Convert to mma.sp.m16n8k32
+  LogicalResult
+  matchAndRewrite(triton::SparseDotOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto loc = op.getLoc();
+    Value A = op.a();
+    MmaEncodingAttr mmaLayout = op.getResult()
+                                    .getType()
+                                    .cast<RankedTensorType>()
+                                    .getEncoding()
+                                    .dyn_cast<MmaEncodingAttr>();
+    if (!mmaLayout || !mmaLayout.isAmpere())
+      llvm::report_fatal_error(
+          "SparseDotOp is only supported on the mma.sp of sm_80 and later.");
+
+    MMA16816ConversionHelper mmaHelper(A.getType(), mmaLayout,
+                                       getThreadId(rewriter, loc), rewriter,
+                                       getTypeConverter(), loc);
+    Value loadedC = mmaHelper.loadC(op.c(), adaptor.c());
+    return mmaHelper.convertSparseDot(A, op.d(), adaptor.a(), adaptor.aMeta(),
+                                      adaptor.b(), loadedC, op);
+  }
 };
 
 void populateDotOpToLLVMPatterns(mlir::LLVMTypeConverter &typeConverter,
                                  RewritePatternSet &patterns, int numWarps,
                                  AxisInfoAnalysis &axisInfoAnalysis,
                                  const Allocation *allocation, Value smem,
+                                 int computeCapability, int ptxVersion,
                                  PatternBenefit benefit) {
-  patterns.add<DotOpConversion>(typeConverter, allocation, smem, benefit);
+  patterns.add<DotOpConversion>(typeConverter, allocation, smem,
+                                computeCapability, ptxVersion, benefit);
+  patterns.add<SparseDotOpConversion>(typeConverter, allocation, smem,
+                                      benefit);
 }
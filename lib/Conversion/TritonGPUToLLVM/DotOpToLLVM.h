@@ -10,6 +10,7 @@ void populateDotOpToLLVMPatterns(mlir::LLVMTypeConverter &typeConverter,
                                  RewritePatternSet &patterns, int numWarps,
                                  AxisInfoAnalysis &axisInfoAnalysis,
                                  const Allocation *allocation, Value smem,
+                                 int computeCapability, int ptxVersion,
                                  PatternBenefit benefit);
 
 #endif
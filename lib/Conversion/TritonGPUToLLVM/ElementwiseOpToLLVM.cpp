@@ -1,3 +1,6 @@
+#include "mlir/IR/Matchers.h"
+#include "llvm/ADT/StringSwitch.h"
+
 #include "ElementwiseOpToLLVM.h"
 
 using namespace mlir;
@@ -9,8 +12,12 @@ using ::mlir::triton::gpu::getElemsPerThread;
 
 struct FpToFpOpConversion
     : public ConvertTritonGPUOpToLLVMPattern<triton::FpToFpOp> {
-  using ConvertTritonGPUOpToLLVMPattern<
-      triton::FpToFpOp>::ConvertTritonGPUOpToLLVMPattern;
+  explicit FpToFpOpConversion(LLVMTypeConverter &typeConverter,
+                              int computeCapability,
+                              PatternBenefit benefit = 1)
+      : ConvertTritonGPUOpToLLVMPattern<triton::FpToFpOp>(typeConverter,
+                                                          benefit),
+        computeCapability(computeCapability) {}
 
   static SmallVector<Value>
   convertFp8x4ToFp16x4(Location loc, ConversionPatternRewriter &rewriter,
@@ -454,6 +461,84 @@ struct FpToFpOpConversion
 #endif
   }
 
+  static Optional<Fp8Format> getFp8Format(Type type) {
+    if (type.isa<triton::Float8E4M3Type>())
+      return Fp8Format::E4M3;
+    if (type.isa<triton::Float8E5M2Type>())
+      return Fp8Format::E5M2;
+    return llvm::None;
+  }
+
+  // The OCP formats use the cvt instructions of sm_89 when available
+  bool hasFp8Cvt() const {
+#ifdef USE_ROCM
+    return false;
+#else
+    return computeCapability >= 89;
+#endif
+  }
+
+  Value convertFp8ToFp16(Location loc, ConversionPatternRewriter &rewriter,
+                         Value v, Fp8Format format) const {
+    if (hasFp8Cvt()) {
+      PTXBuilder builder;
+      auto &cvt = *builder.create("cvt.rn.f16x2." +
+                                  stringifyFp8Format(format).str() + "x2");
+      auto res = builder.newOperand("=r");
+      auto operand = builder.newOperand(zext(i16_ty, v), "h");
+      cvt(res, operand);
+      Value f16x2 = builder.launch(rewriter, loc, i32_ty, false);
+      return bitcast(trunc(i16_ty, f16x2), f16_ty);
+    }
+    Value bits =
+        LLVM::convertFp8ToFp16Bits(loc, rewriter, zext(i16_ty, v), format);
+    return bitcast(bits, f16_ty);
+  }
+
+  Value convertFp32ToFp8(Location loc, ConversionPatternRewriter &rewriter,
+                         Value v, Fp8Format format) const {
+    if (hasFp8Cvt()) {
+      // The first source operand goes to the upper byte
+      PTXBuilder builder;
+      auto &cvt = *builder.create("cvt.rn.satfinite." +
+                                  stringifyFp8Format(format).str() + "x2.f32");
+      auto res = builder.newOperand("=h");
+      auto hi = builder.newOperand(f32_val(0), "f");
+      auto lo = builder.newOperand(v, "f");
+      cvt(res, hi, lo);
+      return trunc(i8_ty, builder.launch(rewriter, loc, i16_ty, false));
+    }
+    return LLVM::convertFp32ToFp8(loc, rewriter, v, format);
+  }
+
+  // Conversions from E4M3 and E5M2 are exact, and conversions to them go
+  // through f32
+  Value convertOCPFp8(Location loc, ConversionPatternRewriter &rewriter,
+                      Value v, Type srcEltType, Type dstEltType) const {
+    if (auto srcFormat = getFp8Format(srcEltType)) {
+      Value f16 = convertFp8ToFp16(loc, rewriter, v, *srcFormat);
+      if (dstEltType.isF16())
+        return f16;
+      Value f32 = rewriter.create<LLVM::FPExtOp>(loc, f32_ty, f16);
+      if (dstEltType.isF32())
+        return f32;
+      if (dstEltType.isBF16())
+        return convertFp32ToBf16(loc, rewriter, f32);
+      if (auto dstFormat = getFp8Format(dstEltType))
+        return convertFp32ToFp8(loc, rewriter, f32, *dstFormat);
+      assert(dstEltType.isF64() && "unsupported fp8 casting");
+      return rewriter.create<LLVM::FPExtOp>(loc, f64_ty, f32);
+    }
+    Value f32 = v;
+    if (srcEltType.isF16())
+      f32 = rewriter.create<LLVM::FPExtOp>(loc, f32_ty, v);
+    else if (srcEltType.isBF16())
+      f32 = convertBf16ToFp32(loc, rewriter, v);
+    else if (srcEltType.isF64())
+      f32 = rewriter.create<LLVM::FPTruncOp>(loc, f32_ty, v);
+    return convertFp32ToFp8(loc, rewriter, f32, *getFp8Format(dstEltType));
+  }
+
   LogicalResult
   matchAndRewrite(triton::FpToFpOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
@@ -466,8 +551,13 @@ struct FpToFpOpConversion
     SmallVector<Value> resultVals;
 
     // Select convertor
-    if (srcEltType.isa<triton::Float8Type>() ||
-        dstEltType.isa<triton::Float8Type>()) {
+    if (getFp8Format(srcEltType) || getFp8Format(dstEltType)) {
+      auto elements = getElementsFromStruct(loc, adaptor.from(), rewriter);
+      for (Value element : elements)
+        resultVals.push_back(
+            convertOCPFp8(loc, rewriter, element, srcEltType, dstEltType));
+    } else if (srcEltType.isa<triton::Float8Type>() ||
+               dstEltType.isa<triton::Float8Type>()) {
       std::function<SmallVector<Value>(Location, ConversionPatternRewriter &,
                                        const Value &, const Value &,
                                        const Value &, const Value &)>
@@ -517,6 +607,9 @@ struct FpToFpOpConversion
     rewriter.replaceOp(op, result);
     return success();
   }
+
+private:
+  int computeCapability;
 };
 
 template <typename OP>
@@ -553,8 +646,35 @@ public:
 
     auto *concreteThis = static_cast<const ConcreteT *>(this);
     auto operands = getOperands(rewriter, adaptor, elems, loc);
+    // Uniform operands, e.g., splatted scalars, strides or offsets computed
+    // from the program id, have the same value in all the elements of the
+    // thread: the result is computed once and replicated
+    if (elems > 1 && isUniform(operands)) {
+      Value resultVal = concreteThis->createDestOp(op, adaptor, rewriter,
+                                                   elemTy, operands[0], loc);
+      if (!bool(resultVal))
+        return failure();
+      SmallVector<Value> resultVals(elems, resultVal);
+      Value view = getStructFromElements(loc, resultVals, rewriter, structTy);
+      rewriter.replaceOp(op, view);
+      return success();
+    }
     SmallVector<Value> resultVals(elems);
     for (unsigned i = 0; i < elems; ++i) {
+      // Pairs of elements are lowered to a single packed instruction if the
+      // op supports it for their type
+      if constexpr (ConcreteT::isPackable) {
+        if (i + 1 < elems) {
+          auto packed = concreteThis->createPackedDestOp(
+              op, rewriter, elemTy, operands[i], operands[i + 1], loc);
+          if (!packed.empty()) {
+            resultVals[i] = packed[0];
+            resultVals[i + 1] = packed[1];
+            ++i;
+            continue;
+          }
+        }
+      }
       resultVals[i] = concreteThis->createDestOp(op, adaptor, rewriter, elemTy,
                                                  operands[i], loc);
       if (!bool(resultVals[i]))
@@ -566,6 +686,8 @@ public:
     return success();
   }
 
+  static constexpr bool isPackable = false;
+
 protected:
   SmallVector<SmallVector<Value>>
   getOperands(ConversionPatternRewriter &rewriter, OpAdaptor adaptor,
@@ -579,6 +701,14 @@ protected:
     }
     return operands;
   }
+
+  // Whether each operand has the same value in all the elements
+  static bool isUniform(ArrayRef<SmallVector<Value>> operands) {
+    for (unsigned i = 1; i < operands.size(); ++i)
+      if (operands[i] != operands[0])
+        return false;
+    return true;
+  }
 };
 
 template <typename SourceOp, typename DestOp>
@@ -741,6 +871,45 @@ private:
   }
 };
 
+// Lowers a binary op on two f16 or bf16 elements to a single packed
+// instruction: the <2 x half> LLVM op for f16, i.e. {add,sub,mul}.f16x2 or
+// v_pk_{add,mul}_f16, and the bf16x2 form of the bf16 PTX of the scalar
+// lowering. Returns no values for other types.
+template <typename DestOp>
+static SmallVector<Value>
+emitPackedBinaryOp(Location loc, ConversionPatternRewriter &rewriter,
+                   Type srcElemTy, Type elemTy, ValueRange operands0,
+                   ValueRange operands1, const char *bf16x2Asm) {
+  auto vecTy = vec_ty(elemTy, 2);
+  auto pack = [&](unsigned idx) -> Value {
+    Value vec = undef(vecTy);
+    vec = insert_element(vecTy, vec, operands0[idx], i32_val(0));
+    vec = insert_element(vecTy, vec, operands1[idx], i32_val(1));
+    return vec;
+  };
+  Value res;
+  if (srcElemTy.isF16()) {
+    res = rewriter.create<DestOp>(loc, vecTy, pack(0), pack(1));
+  } else if (srcElemTy.isBF16()) {
+#ifdef USE_ROCM
+    // No packed bf16 arithmetic
+    return {};
+#else
+    PTXBuilder builder;
+    auto &instr = *builder.create<PTXInstr>(bf16x2Asm);
+    auto out = builder.newOperand("=r");
+    auto lhs = builder.newOperand(bitcast(pack(0), i32_ty), "r");
+    auto rhs = builder.newOperand(bitcast(pack(1), i32_ty), "r");
+    instr({out, lhs, rhs}, /*onlyAttachMLIRArgs=*/true);
+    res = bitcast(builder.launch(rewriter, loc, i32_ty, false), vecTy);
+#endif
+  } else {
+    return {};
+  }
+  return {extract_element(elemTy, res, i32_val(0)),
+          extract_element(elemTy, res, i32_val(1))};
+}
+
 struct FDivOpConversion
     : ElementwiseOpConversionBase<mlir::arith::DivFOp, FDivOpConversion> {
   using Base =
@@ -784,6 +953,21 @@ struct FMulOpConversion
   using Base::Base;
   using Adaptor = typename Base::OpAdaptor;
 
+  static constexpr bool isPackable = true;
+
+  SmallVector<Value> createPackedDestOp(mlir::arith::MulFOp op,
+                                        ConversionPatternRewriter &rewriter,
+                                        Type elemTy, ValueRange operands0,
+                                        ValueRange operands1,
+                                        Location loc) const {
+    return emitPackedBinaryOp<LLVM::FMulOp>(
+        loc, rewriter, getElementType(op.getLhs()), elemTy, operands0,
+        operands1,
+        "{ .reg .b32 c;             \n"
+        "   mov.b32 c, 0x80008000U; \n" // 0.0
+        "   fma.rn.bf16x2 $0, $1, $2, c; } \n");
+  }
+
   Value createDestOp(mlir::arith::MulFOp op, OpAdaptor adaptor,
                      ConversionPatternRewriter &rewriter, Type elemTy,
                      ValueRange operands, Location loc) const {
@@ -818,6 +1002,21 @@ struct FAddOpConversion
   using Base::Base;
   using Adaptor = typename Base::OpAdaptor;
 
+  static constexpr bool isPackable = true;
+
+  SmallVector<Value> createPackedDestOp(mlir::arith::AddFOp op,
+                                        ConversionPatternRewriter &rewriter,
+                                        Type elemTy, ValueRange operands0,
+                                        ValueRange operands1,
+                                        Location loc) const {
+    return emitPackedBinaryOp<LLVM::FAddOp>(
+        loc, rewriter, getElementType(op.getLhs()), elemTy, operands0,
+        operands1,
+        "{ .reg .b32 c;             \n"
+        "   mov.b32 c, 0x3f803f80U; \n" // 1.0
+        "   fma.rn.bf16x2 $0, $1, c, $2; } \n");
+  }
+
   Value createDestOp(mlir::arith::AddFOp op, OpAdaptor adaptor,
                      ConversionPatternRewriter &rewriter, Type elemTy,
                      ValueRange operands, Location loc) const {
@@ -852,6 +1051,21 @@ struct FSubOpConversion
   using Base::Base;
   using Adaptor = typename Base::OpAdaptor;
 
+  static constexpr bool isPackable = true;
+
+  SmallVector<Value> createPackedDestOp(mlir::arith::SubFOp op,
+                                        ConversionPatternRewriter &rewriter,
+                                        Type elemTy, ValueRange operands0,
+                                        ValueRange operands1,
+                                        Location loc) const {
+    return emitPackedBinaryOp<LLVM::FSubOp>(
+        loc, rewriter, getElementType(op.getLhs()), elemTy, operands0,
+        operands1,
+        "{ .reg .b32 c;             \n"
+        "   mov.b32 c, 0xbf80bf80U; \n" // -1.0
+        "   fma.rn.bf16x2 $0, $2, c, $1; } \n");
+  }
+
   Value createDestOp(mlir::arith::SubFOp op, OpAdaptor adaptor,
                      ConversionPatternRewriter &rewriter, Type elemTy,
                      ValueRange operands, Location loc) const {
@@ -886,6 +1100,180 @@ struct SIToFPOpConversion
   using Base::Base;
   using Adaptor = typename Base::OpAdaptor;
 
+  // Part of the bytes of an i8 tensor converted to float
+  enum class BytePart { Byte, LowNibble, HighNibble };
+
+  static Optional<int64_t> getSplatInt(Value v) {
+    if (auto splatOp = v.getDefiningOp<triton::SplatOp>())
+      v = splatOp.src();
+    APInt cst;
+    if (matchPattern(v, m_ConstantInt(&cst)))
+      return cst.getSExtValue();
+    return llvm::None;
+  }
+
+  // x or extsi(x) for an i8 tensor x
+  static Value getBytes(Value v) {
+    if (auto extOp = v.getDefiningOp<arith::ExtSIOp>())
+      v = extOp.getIn();
+    return getElementTypeOrSelf(v.getType()).isInteger(8) ? v : Value();
+  }
+
+  // Matches the dequantization of packed int8 or int4 weights, i.e. the
+  // bytes of an i8 tensor x or their signed nibbles:
+  //   x, shrsi(shli(x, w - 4), w - 4), shrsi(x, 4)
+  // where x may be sign-extended to the width w of the shifts.
+  static Value getPackedSource(Value v, BytePart &part) {
+    if (Value bytes = getBytes(v)) {
+      part = BytePart::Byte;
+      return bytes;
+    }
+    auto shrOp = v.getDefiningOp<arith::ShRSIOp>();
+    if (!shrOp)
+      return Value();
+    auto shift = getSplatInt(shrOp.getRhs());
+    if (!shift)
+      return Value();
+    if (*shift == 4) {
+      if (Value bytes = getBytes(shrOp.getLhs())) {
+        part = BytePart::HighNibble;
+        return bytes;
+      }
+    }
+    int64_t width = getElementTypeOrSelf(v.getType()).getIntOrFloatBitWidth();
+    auto shlOp = shrOp.getLhs().getDefiningOp<arith::ShLIOp>();
+    if (shlOp && *shift == width - 4 && getSplatInt(shlOp.getRhs()) == shift) {
+      if (Value bytes = getBytes(shlOp.getLhs())) {
+        part = BytePart::LowNibble;
+        return bytes;
+      }
+    }
+    return Value();
+  }
+
+  // Converts 4 bytes, or the same nibble of 4 bytes, with the magic number
+  // trick: an unsigned field u placed below the exponent of 1024.0 is the half
+  // 1024 + u, and the signed fields are made unsigned by flipping their sign.
+  static SmallVector<Value>
+  convertInt8x4ToFp16x4(Location loc, ConversionPatternRewriter &rewriter,
+                        const Value &v0, const Value &v1, const Value &v2,
+                        const Value &v3, BytePart part) {
+    auto ctx = rewriter.getContext();
+#ifdef USE_ROCM
+    int64_t mask = part == BytePart::Byte ? 0xff : 0xf;
+    int64_t bias = part == BytePart::Byte ? 0x80 : 0x8;
+    Value magic = rewriter.create<LLVM::ConstantOp>(
+        loc, f16_ty, rewriter.getF16FloatAttr(1024 + bias));
+    SmallVector<Value> ret;
+    for (Value v : {v0, v1, v2, v3}) {
+      Value field = zext(i16_ty, v);
+      if (part == BytePart::HighNibble)
+        field = lshr(i16_ty, field, int_val(16, 4));
+      field = xor_(i16_ty, and_(i16_ty, field, int_val(16, mask)),
+                   int_val(16, bias));
+      Value half = bitcast(or_(i16_ty, field, int_val(16, 0x6400)), f16_ty);
+      ret.push_back(rewriter.create<LLVM::FSubOp>(loc, f16_ty, half, magic));
+    }
+    return ret;
+#else
+    auto i8x4VecTy = vec_ty(i8_ty, 4);
+    Value i8x4Vec = undef(i8x4VecTy);
+    i8x4Vec = insert_element(i8x4VecTy, i8x4Vec, v0, i32_val(0));
+    i8x4Vec = insert_element(i8x4VecTy, i8x4Vec, v1, i32_val(1));
+    i8x4Vec = insert_element(i8x4VecTy, i8x4Vec, v2, i32_val(2));
+    i8x4Vec = insert_element(i8x4VecTy, i8x4Vec, v3, i32_val(3));
+    i8x4Vec = bitcast(i8x4Vec, i32_ty);
+
+    // (1024 + u) - (1024 + 128)
+    auto *byteAsm = "{                                      \n"
+                    ".reg .b32 a<2>, c;                     \n"
+                    "xor.b32  a0, $2, 0x80808080;           \n"
+                    "prmt.b32 a1, a0, 0x64646464, 0x4342;   \n"
+                    "prmt.b32 a0, a0, 0x64646464, 0x4140;   \n"
+                    "mov.b32  c, 0x64806480;                \n"
+                    "sub.f16x2 $0, a0, c;                   \n"
+                    "sub.f16x2 $1, a1, c;                   \n"
+                    "}";
+    // (1024 + u) - (1024 + 8)
+    auto *lowNibbleAsm = "{                                           \n"
+                         ".reg .b32 a<2>, c;                          \n"
+                         "xor.b32  a0, $2, 0x88888888;                \n"
+                         "prmt.b32 a1, a0, 0, 0x4342;                 \n"
+                         "prmt.b32 a0, a0, 0, 0x4140;                 \n"
+                         "lop3.b32 a0, a0, 0x000f000f, 0x64006400, 0xea; \n"
+                         "lop3.b32 a1, a1, 0x000f000f, 0x64006400, 0xea; \n"
+                         "mov.b32  c, 0x64086408;                     \n"
+                         "sub.f16x2 $0, a0, c;                        \n"
+                         "sub.f16x2 $1, a1, c;                        \n"
+                         "}";
+    // (1024 + 16 * u) / 16 - (64 + 8)
+    auto *highNibbleAsm = "{                                           \n"
+                          ".reg .b32 a<2>, c, d;                       \n"
+                          "xor.b32  a0, $2, 0x88888888;                \n"
+                          "prmt.b32 a1, a0, 0, 0x4342;                 \n"
+                          "prmt.b32 a0, a0, 0, 0x4140;                 \n"
+                          "lop3.b32 a0, a0, 0x00f000f0, 0x64006400, 0xea; \n"
+                          "lop3.b32 a1, a1, 0x00f000f0, 0x64006400, 0xea; \n"
+                          "mov.b32  c, 0x2c002c00;                     \n"
+                          "mov.b32  d, 0xd480d480;                     \n"
+                          "fma.rn.f16x2 $0, a0, c, d;                  \n"
+                          "fma.rn.f16x2 $1, a1, c, d;                  \n"
+                          "}";
+    PTXBuilder builder;
+    auto &call = *builder.create(part == BytePart::Byte        ? byteAsm
+                                 : part == BytePart::LowNibble ? lowNibbleAsm
+                                                               : highNibbleAsm);
+
+    auto *o0 = builder.newOperand("=r");
+    auto *o1 = builder.newOperand("=r");
+    auto *i = builder.newOperand(i8x4Vec, "r");
+    call({o0, o1, i}, /*onlyAttachMLIRArgs=*/true);
+
+    auto fp16x2VecTy = vec_ty(f16_ty, 2);
+    auto fp16x2x2StructTy =
+        struct_ty(SmallVector<Type>{fp16x2VecTy, fp16x2VecTy});
+    auto fp16x2x2Struct =
+        builder.launch(rewriter, loc, fp16x2x2StructTy, false);
+    auto fp16x2Vec0 = extract_val(fp16x2VecTy, fp16x2x2Struct, i32_arr_attr(0));
+    auto fp16x2Vec1 = extract_val(fp16x2VecTy, fp16x2x2Struct, i32_arr_attr(1));
+    return {extract_element(f16_ty, fp16x2Vec0, i32_val(0)),
+            extract_element(f16_ty, fp16x2Vec0, i32_val(1)),
+            extract_element(f16_ty, fp16x2Vec1, i32_val(0)),
+            extract_element(f16_ty, fp16x2Vec1, i32_val(1))};
+#endif
+  }
+
+  LogicalResult
+  matchAndRewrite(mlir::arith::SIToFPOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // Packed conversion of int8 and int4 weights to f16, reading the unpacking
+    // shifts' source bytes directly
+    BytePart part;
+    Value bytes = getPackedSource(op.getIn(), part);
+    unsigned elems = getElemsPerThread(op.getType());
+    if (!bytes || !getElementType(op.getOut()).isF16() || elems % 4 != 0)
+      return Base::matchAndRewrite(op, adaptor, rewriter);
+    Value packedBytes = rewriter.getRemappedValue(bytes);
+    if (!packedBytes || !packedBytes.getType().isa<LLVM::LLVMStructType>())
+      return Base::matchAndRewrite(op, adaptor, rewriter);
+    Location loc = op->getLoc();
+    auto elements = getElementsFromStruct(loc, packedBytes, rewriter);
+    if (elements.size() != elems)
+      return Base::matchAndRewrite(op, adaptor, rewriter);
+
+    SmallVector<Value> resultVals;
+    for (size_t i = 0; i < elems; i += 4) {
+      auto converted =
+          convertInt8x4ToFp16x4(loc, rewriter, elements[i], elements[i + 1],
+                                elements[i + 2], elements[i + 3], part);
+      resultVals.append(converted);
+    }
+    Type structTy = getTypeConverter()->convertType(op.getType());
+    Value view = getStructFromElements(loc, resultVals, rewriter, structTy);
+    rewriter.replaceOp(op, view);
+    return success();
+  }
+
   Value createDestOp(mlir::arith::SIToFPOp op, OpAdaptor adaptor,
                      ConversionPatternRewriter &rewriter, Type elemTy,
                      ValueRange operands, Location loc) const {
@@ -988,12 +1376,374 @@ struct ExpOpConversionApprox
   }
 };
 
+// Functions lowered to approximate hardware instructions in fast-math mode,
+// instead of libdevice or ocml calls. Only f32 is supported.
+enum class FastMathFn { Exp, Exp2, Log, Log2, Sin, Cos, Rsqrt, Tanh, Sigmoid };
+
+#ifdef USE_ROCM
+// Calls the f32 overload of an AMDGPU intrinsic, e.g. llvm.amdgcn.rcp.f32
+static Value callAMDGPUIntrinsic(Location loc,
+                                 ConversionPatternRewriter &rewriter,
+                                 Operation *op, StringRef name, Value x) {
+  std::string funcName = ("llvm.amdgcn." + name + ".f32").str();
+  auto funcAttr = StringAttr::get(op->getContext(), funcName);
+  auto funcOp = dyn_cast_or_null<LLVM::LLVMFuncOp>(
+      SymbolTable::lookupNearestSymbolFrom(op, funcAttr));
+  if (!funcOp) {
+    OpBuilder b(op->getParentOfType<LLVM::LLVMFuncOp>());
+    funcOp = b.create<LLVM::LLVMFuncOp>(
+        op->getLoc(), funcName, LLVM::LLVMFunctionType::get(f32_ty, {f32_ty}));
+  }
+  return rewriter.create<LLVM::CallOp>(loc, funcOp, x).getResult(0);
+}
+#else
+// Emits the PTX instruction <name>.approx.f32
+static Value emitApproxPTX(Location loc, ConversionPatternRewriter &rewriter,
+                           StringRef name, Value x) {
+  PTXBuilder ptxBuilder;
+  auto &instr = ptxBuilder.create<PTXInstr>(name.str())->o("approx").o("f32");
+  auto output = ptxBuilder.newOperand("=f");
+  auto input = ptxBuilder.newOperand(x, "f");
+  instr(output, input);
+  return ptxBuilder.launch(rewriter, loc, f32_ty, false);
+}
+#endif
+
+static Value emitFastMath(Location loc, ConversionPatternRewriter &rewriter,
+                          Operation *op, FastMathFn fn, Value x,
+                          int computeCapability) {
+  const double log2e = 1.4426950408889634;
+  const double ln2 = 0.6931471805599453;
+#ifdef USE_ROCM
+  // v_exp_f32 and v_log_f32 are base 2, v_sin_f32 and v_cos_f32 take
+  // revolutions
+  const double inv2Pi = 0.15915494309189535;
+  auto exp2 = [&](Value v) -> Value {
+    return rewriter.create<LLVM::Exp2Op>(loc, f32_ty, v);
+  };
+  auto log2 = [&](Value v) -> Value {
+    return rewriter.create<LLVM::Log2Op>(loc, f32_ty, v);
+  };
+  auto rcp = [&](Value v) {
+    return callAMDGPUIntrinsic(loc, rewriter, op, "rcp", v);
+  };
+  bool hasTanh = false;
+#else
+  auto exp2 = [&](Value v) { return emitApproxPTX(loc, rewriter, "ex2", v); };
+  auto log2 = [&](Value v) { return emitApproxPTX(loc, rewriter, "lg2", v); };
+  auto rcp = [&](Value v) { return emitApproxPTX(loc, rewriter, "rcp", v); };
+  // tanh.approx.f32 requires sm_75
+  bool hasTanh = computeCapability >= 75;
+#endif
+  auto emitTanh = [&](Value v) -> Value {
+#ifndef USE_ROCM
+    if (hasTanh)
+      return emitApproxPTX(loc, rewriter, "tanh", v);
+#endif
+    // 1 - 2 / (e^2x + 1), which saturates to +-1
+    Value e = exp2(fmul(f32_ty, v, f32_val(2 * log2e)));
+    Value r = rcp(fadd(f32_ty, e, f32_val(1.0)));
+    return fadd(f32_ty, f32_val(1.0), fmul(f32_ty, r, f32_val(-2.0)));
+  };
+
+  switch (fn) {
+  case FastMathFn::Exp:
+    return exp2(fmul(f32_ty, x, f32_val(log2e)));
+  case FastMathFn::Exp2:
+    return exp2(x);
+  case FastMathFn::Log:
+    return fmul(f32_ty, log2(x), f32_val(ln2));
+  case FastMathFn::Log2:
+    return log2(x);
+  case FastMathFn::Sin:
+#ifdef USE_ROCM
+    return callAMDGPUIntrinsic(loc, rewriter, op, "sin",
+                               fmul(f32_ty, x, f32_val(inv2Pi)));
+#else
+    return emitApproxPTX(loc, rewriter, "sin", x);
+#endif
+  case FastMathFn::Cos:
+#ifdef USE_ROCM
+    return callAMDGPUIntrinsic(loc, rewriter, op, "cos",
+                               fmul(f32_ty, x, f32_val(inv2Pi)));
+#else
+    return emitApproxPTX(loc, rewriter, "cos", x);
+#endif
+  case FastMathFn::Rsqrt:
+#ifdef USE_ROCM
+    return callAMDGPUIntrinsic(loc, rewriter, op, "rsq", x);
+#else
+    return emitApproxPTX(loc, rewriter, "rsqrt", x);
+#endif
+  case FastMathFn::Tanh:
+    return emitTanh(x);
+  case FastMathFn::Sigmoid:
+    // 0.5 * tanh(0.5 * x) + 0.5 is a single SFU instruction, against two for
+    // 1 / (1 + 2^(-x * log2(e)))
+    if (hasTanh)
+      return fadd(f32_ty,
+                  fmul(f32_ty, emitTanh(fmul(f32_ty, x, f32_val(0.5))),
+                       f32_val(0.5)),
+                  f32_val(0.5));
+    return rcp(
+        fadd(f32_ty, exp2(fmul(f32_ty, x, f32_val(-log2e))), f32_val(1.0)));
+  }
+  llvm_unreachable("unknown fast-math function");
+}
+
+template <typename SourceOp>
+struct FastMathOpConversion
+    : ElementwiseOpConversionBase<SourceOp, FastMathOpConversion<SourceOp>> {
+  using Base =
+      ElementwiseOpConversionBase<SourceOp, FastMathOpConversion<SourceOp>>;
+  using OpAdaptor = typename Base::OpAdaptor;
+
+  explicit FastMathOpConversion(LLVMTypeConverter &typeConverter,
+                                FastMathFn fn, int computeCapability,
+                                PatternBenefit benefit = 1)
+      : Base(typeConverter, benefit), fn(fn),
+        computeCapability(computeCapability) {}
+
+  Value createDestOp(SourceOp op, OpAdaptor adaptor,
+                     ConversionPatternRewriter &rewriter, Type elemTy,
+                     ValueRange operands, Location loc) const {
+    if (!elemTy.isF32())
+      return {};
+    return emitFastMath(loc, rewriter, op, fn, operands[0], computeCapability);
+  }
+
+private:
+  FastMathFn fn;
+  int computeCapability;
+};
+
+// Lowers the libdevice functions that have a fast-math counterpart
+struct FastExtElemwiseOpConversion
+    : ElementwiseOpConversionBase<triton::ExtElemwiseOp,
+                                  FastExtElemwiseOpConversion> {
+  using Base = ElementwiseOpConversionBase<triton::ExtElemwiseOp,
+                                           FastExtElemwiseOpConversion>;
+  using Adaptor = typename Base::OpAdaptor;
+
+  explicit FastExtElemwiseOpConversion(LLVMTypeConverter &typeConverter,
+                                       int computeCapability,
+                                       PatternBenefit benefit = 1)
+      : Base(typeConverter, benefit), computeCapability(computeCapability) {}
+
+  static Optional<FastMathFn> getFastMathFn(StringRef symbol) {
+    return llvm::StringSwitch<Optional<FastMathFn>>(symbol)
+        .Cases("__nv_expf", "__nv_fast_expf", FastMathFn::Exp)
+        .Case("__nv_exp2f", FastMathFn::Exp2)
+        .Cases("__nv_logf", "__nv_fast_logf", FastMathFn::Log)
+        .Cases("__nv_log2f", "__nv_fast_log2f", FastMathFn::Log2)
+        .Cases("__nv_sinf", "__nv_fast_sinf", FastMathFn::Sin)
+        .Cases("__nv_cosf", "__nv_fast_cosf", FastMathFn::Cos)
+        .Case("__nv_rsqrtf", FastMathFn::Rsqrt)
+        .Case("__nv_tanhf", FastMathFn::Tanh)
+        .Default(llvm::None);
+  }
+
+  Value createDestOp(triton::ExtElemwiseOp op, OpAdaptor adaptor,
+                     ConversionPatternRewriter &rewriter, Type elemTy,
+                     ValueRange operands, Location loc) const {
+    auto fn = getFastMathFn(op.symbol());
+    if (!fn || !elemTy.isF32() || operands.size() != 1)
+      return {};
+    return emitFastMath(loc, rewriter, op, *fn, operands[0],
+                        computeCapability);
+  }
+
+private:
+  int computeCapability;
+};
+
+// Lowers 1 / (1 + exp(-x)), as written by tl.sigmoid, to a single sequence
+struct FastSigmoidOpConversion
+    : ElementwiseOpConversionBase<mlir::arith::DivFOp,
+                                  FastSigmoidOpConversion> {
+  using Base = ElementwiseOpConversionBase<mlir::arith::DivFOp,
+                                           FastSigmoidOpConversion>;
+  using Adaptor = typename Base::OpAdaptor;
+
+  explicit FastSigmoidOpConversion(LLVMTypeConverter &typeConverter,
+                                   int computeCapability,
+                                   PatternBenefit benefit = 1)
+      : Base(typeConverter, benefit), computeCapability(computeCapability) {}
+
+  static bool isSplatFloat(Value v, double value) {
+    if (auto splatOp = v.getDefiningOp<triton::SplatOp>())
+      v = splatOp.src();
+    Attribute attr;
+    if (!matchPattern(v, m_Constant(&attr)))
+      return false;
+    if (auto denseAttr = attr.dyn_cast<DenseFPElementsAttr>())
+      if (denseAttr.isSplat())
+        attr = denseAttr.getSplatValue<FloatAttr>();
+    auto floatAttr = attr.dyn_cast<FloatAttr>();
+    return floatAttr && floatAttr.getValueAsDouble() == value;
+  }
+
+  // Returns x if v is -x
+  static Value getNegated(Value v) {
+    if (auto negOp = v.getDefiningOp<arith::NegFOp>())
+      return negOp.getOperand();
+    if (auto subOp = v.getDefiningOp<arith::SubFOp>())
+      if (isSplatFloat(subOp.getLhs(), 0.0))
+        return subOp.getRhs();
+    return Value();
+  }
+
+  static Value getSigmoidArg(mlir::arith::DivFOp op) {
+    if (!isSplatFloat(op.getLhs(), 1.0))
+      return Value();
+    auto addOp = op.getRhs().getDefiningOp<arith::AddFOp>();
+    if (!addOp)
+      return Value();
+    Value exp = addOp.getRhs();
+    if (!isSplatFloat(addOp.getLhs(), 1.0)) {
+      if (!isSplatFloat(addOp.getRhs(), 1.0))
+        return Value();
+      exp = addOp.getLhs();
+    }
+    auto expOp = exp.getDefiningOp<math::ExpOp>();
+    return expOp ? getNegated(expOp.getOperand()) : Value();
+  }
+
+  LogicalResult
+  matchAndRewrite(mlir::arith::DivFOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Value x = getSigmoidArg(op);
+    if (!x || !getElementTypeOrSelf(op.getType()).isF32())
+      return failure();
+    Value llX = rewriter.getRemappedValue(x);
+    if (!llX || !llX.getType().isa<LLVM::LLVMStructType>())
+      return failure();
+    Location loc = op->getLoc();
+    auto elements = getElementsFromStruct(loc, llX, rewriter);
+
+    SmallVector<Value> resultVals;
+    for (Value element : elements)
+      resultVals.push_back(emitFastMath(loc, rewriter, op, FastMathFn::Sigmoid,
+                                        element, computeCapability));
+    Type structTy = getTypeConverter()->convertType(op.getType());
+    Value view = getStructFromElements(loc, resultVals, rewriter, structTy);
+    rewriter.replaceOp(op, view);
+    return success();
+  }
+
+private:
+  int computeCapability;
+};
+
+// Lowers the rounds of Philox4x32 of `philox_impl` in random.py. Each round
+// keeps both halves of the 64 bit products of two of the counters by the
+// round constants, which are single mul.wide.u32 instructions on NVIDIA GPUs
+// and v_mul_hi_u32/v_mul_lo_u32 pairs on AMD GPUs.
+struct PhiloxOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::PhiloxOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::PhiloxOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  static constexpr uint32_t kKeyA = 0x9E3779B9;
+  static constexpr uint32_t kKeyB = 0xBB67AE85;
+  static constexpr uint32_t kRoundA = 0xD2511F53;
+  static constexpr uint32_t kRoundB = 0xCD9E8D57;
+
+  // The high and low halves of the product of the u32 a and b
+  static std::pair<Value, Value> mulWide(Location loc,
+                                         ConversionPatternRewriter &rewriter,
+                                         uint32_t a, Value b) {
+#ifdef USE_ROCM
+    // trunc(zext(a) * zext(b) >> 32) is selected as v_mul_hi_u32
+    Value prod = mul(i64_ty, int_val(64, a), zext(i64_ty, b));
+    Value hi = trunc(i32_ty, lshr(i64_ty, prod, int_val(64, 32)));
+    Value lo = mul(i32_ty, i32_val(static_cast<int32_t>(a)), b);
+    return {hi, lo};
+#else
+    PTXBuilder builder;
+    auto &mulWide = *builder.create<PTXInstr>("mul.wide.u32");
+    auto res = builder.newOperand("=l");
+    auto lhs = builder.newOperand(b, "r");
+    auto rhs = builder.newConstantOperand(a);
+    mulWide(res, lhs, rhs);
+    Value prod = builder.launch(rewriter, loc, i64_ty, false);
+    return {trunc(i32_ty, lshr(i64_ty, prod, int_val(64, 32))),
+            trunc(i32_ty, prod)};
+#endif
+  }
+
+  static SmallVector<Value, 4> emitRounds(Location loc,
+                                          ConversionPatternRewriter &rewriter,
+                                          ArrayRef<Value> args,
+                                          unsigned nRounds) {
+    SmallVector<Value, 4> c(args.begin(), args.begin() + 4);
+    Value k0 = args[4], k1 = args[5];
+    for (unsigned round = 0; round < nRounds; ++round) {
+      auto [hiB, loB] = mulWide(loc, rewriter, kRoundB, c[2]);
+      auto [hiA, loA] = mulWide(loc, rewriter, kRoundA, c[0]);
+      c = {xor_(xor_(hiB, c[1]), k0), loB, xor_(xor_(hiA, c[3]), k1), loA};
+      if (round + 1 < nRounds) {
+        k0 = add(k0, i32_val(static_cast<int32_t>(kKeyA)));
+        k1 = add(k1, i32_val(static_cast<int32_t>(kKeyB)));
+      }
+    }
+    return c;
+  }
+
+  LogicalResult
+  matchAndRewrite(triton::PhiloxOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    unsigned nRounds = op.n_rounds();
+    auto tensorTy = op.out0().getType().dyn_cast<RankedTensorType>();
+    if (!tensorTy) {
+      auto args = llvm::to_vector<6>(adaptor.getOperands());
+      rewriter.replaceOp(op, emitRounds(loc, rewriter, args, nRounds));
+      return success();
+    }
+
+    SmallVector<SmallVector<Value>> operands;
+    for (Value operand : adaptor.getOperands())
+      operands.push_back(getElementsFromStruct(loc, operand, rewriter));
+    unsigned elems = operands[0].size();
+    // Uniform counters and keys, e.g. those of a scalar offset, have a
+    // single set of rounds
+    bool isUniform = llvm::all_of(operands, [](ArrayRef<Value> values) {
+      return llvm::is_splat(values);
+    });
+    SmallVector<Value> resultVals[4];
+    for (unsigned i = 0; i < elems; ++i) {
+      SmallVector<Value, 4> results;
+      if (isUniform && i > 0) {
+        for (unsigned j = 0; j < 4; ++j)
+          results.push_back(resultVals[j][0]);
+      } else {
+        SmallVector<Value, 6> args;
+        for (auto &values : operands)
+          args.push_back(values[i]);
+        results = emitRounds(loc, rewriter, args, nRounds);
+      }
+      for (unsigned j = 0; j < 4; ++j)
+        resultVals[j].push_back(results[j]);
+    }
+    Type structTy = getTypeConverter()->convertType(tensorTy);
+    SmallVector<Value, 4> views;
+    for (unsigned j = 0; j < 4; ++j)
+      views.push_back(
+          getStructFromElements(loc, resultVals[j], rewriter, structTy));
+    rewriter.replaceOp(op, views);
+    return success();
+  }
+};
+
 void populateElementwiseOpToLLVMPatterns(mlir::LLVMTypeConverter &typeConverter,
                                          RewritePatternSet &patterns,
                                          int numWarps,
                                          AxisInfoAnalysis &axisInfoAnalysis,
                                          const Allocation *allocation,
-                                         Value smem, PatternBenefit benefit) {
+                                         Value smem, int computeCapability,
+                                         bool fastMath,
+                                         PatternBenefit benefit) {
 #define POPULATE_TERNARY_OP(SRC_OP, DST_OP)                                    \
   patterns.add<ElementwiseOpConversion<SRC_OP, DST_OP>>(typeConverter, benefit);
   POPULATE_TERNARY_OP(triton::gpu::SelectOp, LLVM::SelectOp)
@@ -1047,9 +1797,10 @@ void populateElementwiseOpToLLVMPatterns(mlir::LLVMTypeConverter &typeConverter,
   patterns.add<FPToSIOpConversion>(typeConverter, benefit);
   patterns.add<SIToFPOpConversion>(typeConverter, benefit);
 
-  patterns.add<FpToFpOpConversion>(typeConverter, benefit);
+  patterns.add<FpToFpOpConversion>(typeConverter, computeCapability, benefit);
 
   patterns.add<ExtElemwiseOpConversion>(typeConverter, benefit);
+  patterns.add<PhiloxOpConversion>(typeConverter, benefit);
   // ExpOpConversionApprox will try using ex2.approx if the input type is FP32.
   // For FP64 input type, ExpOpConversionApprox will return failure and
   // ElementwiseOpConversion<math::ExpOp, math::ExpOp> defined below will call
@@ -1057,4 +1808,23 @@ void populateElementwiseOpToLLVMPatterns(mlir::LLVMTypeConverter &typeConverter,
 #ifndef USE_ROCM
   patterns.add<ExpOpConversionApprox>(typeConverter, benefit);
 #endif
+
+  // In fast-math mode, approximate lowerings are tried first
+  if (fastMath) {
+    PatternBenefit fastMathBenefit(benefit.getBenefit() + 1);
+#define POPULATE_FAST_MATH_OP(SRC_OP, FN)                                      \
+  patterns.add<FastMathOpConversion<SRC_OP>>(typeConverter, FastMathFn::FN,    \
+                                             computeCapability,                \
+                                             fastMathBenefit);
+    POPULATE_FAST_MATH_OP(math::ExpOp, Exp)
+    POPULATE_FAST_MATH_OP(math::LogOp, Log)
+    POPULATE_FAST_MATH_OP(math::SinOp, Sin)
+    POPULATE_FAST_MATH_OP(math::CosOp, Cos)
+    POPULATE_FAST_MATH_OP(math::RsqrtOp, Rsqrt)
+#undef POPULATE_FAST_MATH_OP
+    patterns.add<FastExtElemwiseOpConversion>(typeConverter, computeCapability,
+                                              fastMathBenefit);
+    patterns.add<FastSigmoidOpConversion>(typeConverter, computeCapability,
+                                          fastMathBenefit);
+  }
 }
@@ -11,6 +11,8 @@ void populateElementwiseOpToLLVMPatterns(mlir::LLVMTypeConverter &typeConverter,
                                          int numWarps,
                                          AxisInfoAnalysis &axisInfoAnalysis,
                                          const Allocation *allocation,
-                                         Value smem, PatternBenefit benefit);
+                                         Value smem, int computeCapability,
+                                         bool fastMath,
+                                         PatternBenefit benefit);
 
 #endif
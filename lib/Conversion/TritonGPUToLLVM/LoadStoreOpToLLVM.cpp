@@ -1,6 +1,8 @@
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/TypeUtilities.h"
+#include "llvm/ADT/bit.h"
+#include "llvm/Support/Format.h"
 
 #include "ConvertLayoutOpToLLVM.h"
 #include "LoadStoreOpToLLVM.h"
@@ -8,10 +10,12 @@
 using namespace mlir;
 using namespace mlir::triton;
 
+using ::mlir::LLVM::getClusterCTARank;
 using ::mlir::LLVM::getElementsFromStruct;
 using ::mlir::LLVM::getSharedMemoryObjectFromStruct;
 using ::mlir::LLVM::getStructFromElements;
 using ::mlir::triton::gpu::getElemsPerThread;
+using ::mlir::triton::gpu::getSharedAccessVec;
 using ::mlir::triton::gpu::SharedEncodingAttr;
 
 // Contains some helper functions for both Load and Store conversions.
@@ -32,6 +36,21 @@ struct LoadStoreConversionBase {
     return valueVals;
   }
 
+  // Whether \param ptr points to shared memory, i.e. into a tt.scratch
+  // buffer
+  static bool isSharedPointer(Value ptr) {
+    auto ptrTy =
+        getElementTypeOrSelf(ptr.getType()).cast<triton::PointerType>();
+    return ptrTy.getAddressSpace() ==
+           mlir::gpu::GPUDialect::getWorkgroupAddressSpace();
+  }
+
+  // The inline asm constraint of the address \param ptr: shared pointers are
+  // 32-bit since PTXTranslation enables nvptx-short-ptr
+  static StringRef getAddrConstraint(Value ptr) {
+    return isSharedPointer(ptr) ? "r" : "l";
+  }
+
   unsigned getContiguity(Value ptr) const {
     auto tensorTy = ptr.getType().dyn_cast<RankedTensorType>();
     if (!tensorTy)
@@ -47,17 +66,67 @@ struct LoadStoreConversionBase {
     unsigned numElemBits = 0;
     auto ptrTy = tensorTy.getElementType().cast<triton::PointerType>();
     auto pointeeType = ptrTy.getPointeeType();
-    numElemBits = pointeeType.isa<triton::Float8Type>()
+    numElemBits = triton::isFloat8(pointeeType)
                       ? 8
                       : pointeeType.getIntOrFloatBitWidth();
     // The maximum vector size is 128 bits on NVIDIA GPUs.
     return std::min<unsigned>(128 / numElemBits, contiguity);
   }
 
+#ifdef USE_ROCM
+  // The LLVM ordering of an atomic of memory semantic \param sem, or
+  // \param defaultOrdering if it has none.
+  static LLVM::AtomicOrdering
+  getAtomicOrdering(Optional<MemSemantic> sem,
+                    LLVM::AtomicOrdering defaultOrdering) {
+    if (!sem)
+      return defaultOrdering;
+    switch (*sem) {
+    case MemSemantic::RELAXED:
+      return LLVM::AtomicOrdering::monotonic;
+    case MemSemantic::ACQUIRE:
+      return LLVM::AtomicOrdering::acquire;
+    case MemSemantic::RELEASE:
+      return LLVM::AtomicOrdering::release;
+    case MemSemantic::ACQUIRE_RELEASE:
+      return LLVM::AtomicOrdering::acq_rel;
+    }
+    llvm_unreachable("Invalid MemSemantic");
+  }
+#else
+  // The PTX scope of an atomic on global memory of scope \param scope, .gpu
+  // by default
+  static std::string getPTXScope(Optional<MemSyncScope> scope) {
+    return stringifyMemSyncScope(scope.getValueOr(MemSyncScope::GPU)).str();
+  }
+
+  // The level of the membar preceding an atomic of scope \param scope,
+  // which orders the earlier accesses of the CTA
+  static std::string getMembarLevel(Optional<MemSyncScope> scope) {
+    return scope == MemSyncScope::SYSTEM ? "sys" : "gl";
+  }
+#endif
+
   unsigned getMaskAlignment(Value mask) const {
     return axisAnalysisPass.getMaskAlignment(mask);
   }
 
+#ifdef USE_ROCM
+  // AMDGPU has no per-instruction cache operators in LLVM IR. Streaming and
+  // evict-first accesses are emitted as nontemporal (slc/nt), and accesses
+  // that must bypass the per-CU cache are emitted as volatile (glc).
+  static bool isNonTemporal(triton::CacheModifier cache,
+                            triton::EvictionPolicy evict) {
+    return cache == triton::CacheModifier::CS ||
+           evict == triton::EvictionPolicy::EVICT_FIRST;
+  }
+
+  static bool isL1Bypass(triton::CacheModifier cache) {
+    return cache == triton::CacheModifier::CG ||
+           cache == triton::CacheModifier::WT;
+  }
+#endif
+
 protected:
   AxisInfoAnalysis &axisAnalysisPass;
 };
@@ -121,13 +190,50 @@ struct LoadOpConversion
     }
     auto otherElems = getLLVMElems(other, llOther, rewriter, loc);
 
+    // A load of a uniform pointer, e.g., of a splatted scalar pointer, is done
+    // once per thread and its value replicated
+    unsigned numLoadedElems = numElems;
+    if (numElems > 1 && !op.isVolatile() && axisAnalysisPass.isUniform(ptr) &&
+        (!llMask || axisAnalysisPass.isUniform(mask)) &&
+        (!other || llvm::is_splat(otherElems))) {
+      vec = 1;
+      numLoadedElems = 1;
+    }
+
     // vectorized iteration through all the pointer/mask/other elements
     const int valueElemNbits =
         std::max(8u, valueElemTy.getIntOrFloatBitWidth());
-    const int numVecs = numElems / vec;
+    const int numVecs = numLoadedElems / vec;
+
+#ifndef USE_ROCM
+    // The L2 cache policy is created once and shared by all the vectorized
+    // loads of this op.
+    Value l2Policy;
+    auto fraction = op.l2EvictLastFraction();
+    if (fraction && !isSharedPointer(ptr)) {
+      float fractionVal = fraction->convertToFloat();
+      assert(fractionVal > 0.f && fractionVal <= 1.f &&
+             "L2 evict_last fraction must be in (0, 1]");
+      std::string fractionStr;
+      llvm::raw_string_ostream os(fractionStr);
+      os << "0f"
+         << llvm::format_hex_no_prefix(llvm::bit_cast<uint32_t>(fractionVal),
+                                       8, /*Upper=*/true);
+      os.flush();
+
+      PTXBuilder policyBuilder;
+      auto &createPolicy = policyBuilder.create<>("createpolicy")
+                               ->o("fractional")
+                               .o("L2::evict_last")
+                               .b(64);
+      createPolicy(policyBuilder.newOperand("=l"),
+                   policyBuilder.newConstantOperand(fractionStr));
+      l2Policy = policyBuilder.launch(rewriter, loc, i64_ty);
+    }
+#endif
 
     SmallVector<Value> loadedVals;
-    for (size_t vecStart = 0; vecStart < numElems; vecStart += vec) {
+    for (size_t vecStart = 0; vecStart < numLoadedElems; vecStart += vec) {
       // TODO: optimization when ptr is GEP with constant offset
       size_t in_off = 0;
 
@@ -136,17 +242,19 @@ struct LoadOpConversion
       const size_t width = std::min(totalWidth, maxWordWidth);
       const size_t nWords = std::max<size_t>(1, totalWidth / width);
       const size_t wordNElems = width / valueElemNbits;
-      assert(wordNElems * nWords * numVecs == numElems);
+      assert(wordNElems * nWords * numVecs == numLoadedElems);
 
 #ifdef USE_ROCM
       Value pred = mask ? maskElems[vecStart] : int_val(1, 1);
       Value zeroVal = bitcast(int_val(valueElemNbits, 0), valueElemTy);
+      const bool isVolatile = op.isVolatile() || isL1Bypass(op.cache());
+      const bool nonTemporal = isNonTemporal(op.cache(), op.evict());
       for (size_t wordIdx = 0; wordIdx < nWords; ++wordIdx) {
         for (size_t wordElem = 0; wordElem < wordNElems; ++wordElem) {
           size_t elemOffset = vecStart + wordIdx * wordNElems + wordElem;
           auto loaded = rewriter.create<scf::IfOp>(loc, TypeRange({valueElemTy}), pred,
                                      [&](OpBuilder &builder, Location loc){
-                                       auto loadVal = builder.create<LLVM::LoadOp>(loc, ptrElems[elemOffset]);
+                                       auto loadVal = builder.create<LLVM::LoadOp>(loc, ptrElems[elemOffset], /*alignment=*/0, isVolatile, nonTemporal);
                                        builder.create<mlir::scf::YieldOp>(loc, ValueRange({loadVal}));
                                      },
                                      [&](OpBuilder &builder, Location loc){
@@ -158,9 +266,7 @@ struct LoadOpConversion
         }
       }
 #else
-      // TODO(Superjomn) Add cache policy fields to StoreOp.
-      // TODO(Superjomn) Deal with cache policy here.
-      const bool hasL2EvictPolicy = false;
+      const bool hasL2EvictPolicy = static_cast<bool>(l2Policy);
 
       PTXBuilder ptxBuilder;
 
@@ -179,27 +285,35 @@ struct LoadOpConversion
       }
 
       auto *addrOpr =
-          ptxBuilder.newAddrOperand(ptrElems[vecStart], "l", in_off);
-
-      // Define the instruction opcode
-      auto &ld = ptxBuilder.create<>("ld")
-                     ->o("volatile", op.isVolatile())
-                     .global()
-                     .o("ca", op.cache() == triton::CacheModifier::CA)
-                     .o("cg", op.cache() == triton::CacheModifier::CG)
-                     .o("L1::evict_first",
-                        op.evict() == triton::EvictionPolicy::EVICT_FIRST)
-                     .o("L1::evict_last",
-                        op.evict() == triton::EvictionPolicy::EVICT_LAST)
-                     .o("L1::cache_hint", hasL2EvictPolicy)
-                     .v(nWords)
-                     .b(width);
+          ptxBuilder.newAddrOperand(ptrElems[vecStart], getAddrConstraint(ptr),
+                                    in_off);
+
+      // Define the instruction opcode. Shared memory has no cache operators.
+      // Memory nothing writes while the kernel runs is read through the
+      // non-coherent texture cache.
+      const bool isGlobal = !isSharedPointer(ptr);
+      auto cache = op.cache();
+      auto evict = op.evict();
+      auto &ld =
+          ptxBuilder.create<>("ld")
+              ->o("volatile", op.isVolatile())
+              .o("global", isGlobal)
+              .o("shared", !isGlobal)
+              .o("ca", isGlobal && cache == triton::CacheModifier::CA)
+              .o("cg", isGlobal && cache == triton::CacheModifier::CG)
+              .o("cs", isGlobal && cache == triton::CacheModifier::CS)
+              .o("nc", isGlobal && op->hasAttr("triton_gpu.non_coherent"))
+              .o("L1::evict_first",
+                 isGlobal && evict == triton::EvictionPolicy::EVICT_FIRST)
+              .o("L1::evict_last",
+                 isGlobal && evict == triton::EvictionPolicy::EVICT_LAST)
+              .o("L2::cache_hint", hasL2EvictPolicy)
+              .v(nWords)
+              .b(width);
 
       PTXBuilder::Operand *evictOpr{};
-
-      // Here lack a mlir::Value to bind to this operation, so disabled.
-      // if (has_l2_evict_policy)
-      //   evictOpr = ptxBuilder.newOperand(l2Evict, "l");
+      if (hasL2EvictPolicy)
+        evictOpr = ptxBuilder.newOperand(l2Policy, "l");
 
       if (!evictOpr)
         ld(dstsOpr, addrOpr).predicate(pred, "b");
@@ -241,10 +355,6 @@ struct LoadOpConversion
                        ? LLVM::LLVMStructType::getLiteral(getContext(), retTys)
                        : retTys[0];
 
-      // TODO: if (has_l2_evict_policy)
-      // auto asmDialectAttr =
-      // LLVM::AsmDialectAttr::get(rewriter.getContext(),
-      //                                                 LLVM::AsmDialect::AD_ATT);
       Value ret = ptxBuilder.launch(rewriter, loc, retTy);
 
       // Extract and store return values
@@ -270,6 +380,8 @@ struct LoadOpConversion
       }
 #endif
     } // end vec
+    Value firstVal = loadedVals[0];
+    loadedVals.resize(numElems, firstVal);
 
     Type llvmResultStructTy = getTypeConverter()->convertType(valueTy);
     Value resultStruct =
@@ -341,9 +453,6 @@ struct StoreOpConversion
       const size_t wordNElems = width / valueElemNbits;
       assert(wordNElems * nWords * numVecs == numElems);
 
-      // TODO(Superjomn) Add cache policy fields to StoreOp.
-      // TODO(Superjomn) Deal with cache policy here.
-
       Type valArgTy = IntegerType::get(ctx, width);
       auto wordTy = vec_ty(valueElemTy, wordNElems);
 
@@ -361,9 +470,11 @@ struct StoreOpConversion
           elem = bitcast(elem, valueElemTy);
 #ifdef USE_ROCM
           Value maskVal = llMask ? maskElems[vecStart] : int_val(1, 1);
+          const bool isVolatile = isL1Bypass(op.cache());
+          const bool nonTemporal = isNonTemporal(op.cache(), op.evict());
           rewriter.create<scf::IfOp>(loc, llvm::None, maskVal,
                                      [&](OpBuilder &builder, Location loc){
-                                       auto storeOp = builder.create<LLVM::StoreOp>(loc, elem, ptrElems[elemOffset]);
+                                       auto storeOp = builder.create<LLVM::StoreOp>(loc, elem, ptrElems[elemOffset], /*alignment=*/0, isVolatile, nonTemporal);
                                        builder.create<scf::YieldOp>(loc);
                                      },
                                      nullptr
@@ -387,10 +498,27 @@ struct StoreOpConversion
       Value maskVal = llMask ? maskElems[vecStart] : int_val(1, 1);
 
       auto *asmAddr =
-          ptxBuilder.newAddrOperand(ptrElems[vecStart], "l", in_off);
+          ptxBuilder.newAddrOperand(ptrElems[vecStart], getAddrConstraint(ptr),
+                                    in_off);
 
+      // Shared memory has no cache operators
+      const bool isGlobal = !isSharedPointer(ptr);
+      auto cache = op.cache();
+      auto evict = op.evict();
       auto &ptxStoreInstr =
-          ptxBuilder.create<>("st")->global().v(nWords).b(width);
+          ptxBuilder.create<>("st")
+              ->o("global", isGlobal)
+              .o("shared", !isGlobal)
+              .o("wb", isGlobal && cache == triton::CacheModifier::WB)
+              .o("cg", isGlobal && cache == triton::CacheModifier::CG)
+              .o("cs", isGlobal && cache == triton::CacheModifier::CS)
+              .o("wt", isGlobal && cache == triton::CacheModifier::WT)
+              .o("L1::evict_first",
+                 isGlobal && evict == triton::EvictionPolicy::EVICT_FIRST)
+              .o("L1::evict_last",
+                 isGlobal && evict == triton::EvictionPolicy::EVICT_LAST)
+              .v(nWords)
+              .b(width);
       ptxStoreInstr(asmAddr, asmArgList).predicate(maskVal, "b");
 
       Type boolTy = getTypeConverter()->convertType(rewriter.getIntegerType(1));
@@ -463,8 +591,13 @@ struct AtomicCASOpConversion
     // Build main block with atomic_cmpxchg.
     rewriter.setInsertionPointToEnd(atomicBlock);
 
-    auto successOrdering = LLVM::AtomicOrdering::acq_rel;
+    auto successOrdering =
+        getAtomicOrdering(op.sem(), LLVM::AtomicOrdering::acq_rel);
     auto failureOrdering = LLVM::AtomicOrdering::monotonic;
+    // a failed cmpxchg does not store, so it can only acquire
+    if (op.sem() == MemSemantic::ACQUIRE ||
+        op.sem() == MemSemantic::ACQUIRE_RELEASE)
+      failureOrdering = LLVM::AtomicOrdering::acquire;
     auto boolType = IntegerType::get(rewriter.getContext(), 1);
     auto pairType = LLVM::LLVMStructType::getLiteral(rewriter.getContext(),
                                                      {valueElemTy, boolType});
@@ -515,7 +648,8 @@ struct AtomicCASOpConversion
     auto tid = tid_val();
     Value pred = icmp_eq(tid, i32_val(0));
     PTXBuilder ptxBuilderMemfence;
-    auto memfence = ptxBuilderMemfence.create<PTXInstr>("membar")->o("gl");
+    auto memfence = ptxBuilderMemfence.create<PTXInstr>("membar")->o(
+        getMembarLevel(op.scope()));
     memfence();
     auto ASMReturnTy = void_ty(ctx);
     ptxBuilderMemfence.launch(rewriter, loc, ASMReturnTy);
@@ -529,11 +663,20 @@ struct AtomicCASOpConversion
 
     PTXBuilder ptxBuilderAtomicCAS;
     auto *dstOpr = ptxBuilderAtomicCAS.newOperand("=r");
-    auto *ptrOpr = ptxBuilderAtomicCAS.newAddrOperand(casPtr, "l");
+    auto *ptrOpr =
+        ptxBuilderAtomicCAS.newAddrOperand(casPtr, getAddrConstraint(ptr));
     auto *cmpOpr = ptxBuilderAtomicCAS.newOperand(casCmp, "r");
     auto *valOpr = ptxBuilderAtomicCAS.newOperand(casVal, "r");
     auto &atom = *ptxBuilderAtomicCAS.create<PTXInstr>("atom");
-    atom.global().o("cas").o("b32");
+    if (isSharedPointer(ptr))
+      atom.shared();
+    else
+      atom.global();
+    if (op.scope() && !isSharedPointer(ptr))
+      atom.o(getPTXScope(op.scope()));
+    if (auto sem = op.sem())
+      atom.o(stringifyMemSemantic(*sem).str());
+    atom.o("cas").o("b32");
     atom(dstOpr, ptrOpr, cmpOpr, valOpr).predicate(pred);
     auto old = ptxBuilderAtomicCAS.launch(rewriter, loc, valueElemTy);
     barrier();
@@ -569,6 +712,65 @@ struct AtomicRMWOpConversion
             converter, allocation, smem, benefit),
         LoadStoreConversionBase(axisAnalysisPass) {}
 
+  // Whether the adds of \param op are summed across the lanes of a warp with
+  // the same address first, which is requested by tt.aggregate and pointless
+  // when the addresses are all different
+  bool isAggregated(triton::AtomicRMWOp op) const {
+    auto valueTy = op.getType().dyn_cast<RankedTensorType>();
+    auto kind = op.atomic_rmw_op();
+    return valueTy && op->hasAttr("tt.aggregate") &&
+           op.getResult().use_empty() &&
+           (kind == RMWOp::ADD || kind == RMWOp::FADD) &&
+           valueTy.getElementType().getIntOrFloatBitWidth() >= 32 &&
+           getContiguity(op.ptr()) < product(valueTy.getShape());
+  }
+
+  // Sums \param val over the lanes of the warp (the wavefront on AMD GPUs)
+  // with the same \param ptr where \param pred is set, into the lowest of
+  // them. Returns the sum and whether the lane is such a leader.
+  //
+  // The peers of a lane are reduced as a tree over their ranks: in each round
+  // every peer of even rank adds the value of the next remaining peer, and
+  // those of odd rank retire.
+  std::pair<Value, Value> aggregate(Location loc,
+                                    ConversionPatternRewriter &rewriter,
+                                    Value ptr, Value val, Value pred) const {
+#ifdef USE_ROCM
+    const unsigned waveSize = 64;
+#else
+    const unsigned waveSize = 32;
+#endif
+    Type maskTy = rewriter.getIntegerType(waveSize);
+    auto toI32 = [&](Value v) {
+      return waveSize == 32 ? v : Value(trunc(i32_ty, v));
+    };
+    Value laneId = urem(tid_val(), i32_val(waveSize));
+    Value lane = waveSize == 32 ? laneId : Value(zext(maskTy, laneId));
+    Value zero = int_val(waveSize, 0);
+    Value one = int_val(waveSize, 1);
+
+    Value peers = and_(LLVM::matchAnySync(loc, rewriter, ptr),
+                       LLVM::ballotSync(loc, rewriter, pred));
+    Value lowerPeers = and_(peers, sub(shl(one, lane), one));
+    Value higherPeers = and_(peers, shl(int_val(waveSize, -2), lane));
+    Value isLeader = and_(pred, icmp_eq(lowerPeers, zero));
+    Value rank = rewriter.create<LLVM::CtPopOp>(loc, maskTy, lowerPeers);
+    bool isFloat = val.getType().isa<FloatType>();
+    for (unsigned n = 1; n < waveSize; n *= 2) {
+      Value next = rewriter.create<LLVM::CountTrailingZerosOp>(
+          loc, maskTy, higherPeers, int_val(1, 0));
+      Value other = LLVM::shflIdxSync(
+          loc, rewriter, val, and_(toI32(next), i32_val(waveSize - 1)));
+      Value sum = isFloat ? Value(fadd(val, other)) : Value(add(val, other));
+      val = select(icmp_ne(higherPeers, zero), sum, val);
+      Value isEven = icmp_eq(and_(rank, one), zero);
+      higherPeers =
+          and_(higherPeers, LLVM::ballotSync(loc, rewriter, isEven));
+      rank = lshr(rank, one);
+    }
+    return {val, isLeader};
+  }
+
 #ifdef USE_ROCM
   /// Try to match the mlir::triton::RMWOp to LLVM::AtomicBinOp.
   static Optional<LLVM::AtomicBinOp> matchAtomicOp(RMWOp atomicOp) {
@@ -599,6 +801,28 @@ struct AtomicRMWOpConversion
     llvm_unreachable("Invalid RMWOp");
   }
 
+  // Calls llvm.amdgcn.global.atomic.fadd on a pair of halves
+  static Value callPackedAtomicFAdd(Location loc,
+                                    ConversionPatternRewriter &rewriter,
+                                    Operation *op, Value ptr, Value val) {
+    MLIRContext *ctx = rewriter.getContext();
+    Type vecTy = val.getType();
+    Type vecPtrTy = ptr_ty(vecTy, 1);
+    StringRef funcName = "llvm.amdgcn.global.atomic.fadd.v2f16.p1v2f16.v2f16";
+    auto funcAttr = StringAttr::get(ctx, funcName);
+    auto funcOp = dyn_cast_or_null<LLVM::LLVMFuncOp>(
+        SymbolTable::lookupNearestSymbolFrom(op, funcAttr));
+    if (!funcOp) {
+      OpBuilder b(op->getParentOfType<LLVM::LLVMFuncOp>());
+      funcOp = b.create<LLVM::LLVMFuncOp>(
+          op->getLoc(), funcName,
+          LLVM::LLVMFunctionType::get(vecTy, {vecPtrTy, vecTy}));
+    }
+    Value vecPtr = bitcast(ptr, vecPtrTy);
+    return rewriter.create<LLVM::CallOp>(loc, funcOp, ValueRange{vecPtr, val})
+        .getResult(0);
+  }
+
   LogicalResult
   matchAndRewrite(triton::AtomicRMWOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
@@ -631,7 +855,15 @@ struct AtomicRMWOpConversion
     // tensor
     if (valueTy) {
       auto valTy = val.getType().cast<RankedTensorType>();
-      vec = std::min<unsigned>(vec, valTy.getElementType().isF16() ? 2 : 1);
+      // Only fadd has a packed (global_atomic_pk_add_f16) form, in global
+      // memory
+      bool isPackedFAdd = atomicRmwAttr == RMWOp::FADD &&
+                          valTy.getElementType().isF16() &&
+                          elemsPerThread % 2 == 0 && !isSharedPointer(ptr);
+      vec = std::min<unsigned>(vec, isPackedFAdd ? 2 : 1);
+      // a pair is only added when both of its elements are
+      if (llMask)
+        vec = std::min<unsigned>(vec, getMaskAlignment(op.mask()));
       // mask
       auto shape = valueTy.getShape();
       auto numElements = product(shape);
@@ -640,8 +872,14 @@ struct AtomicRMWOpConversion
     }
 
     auto vecTy = vec_ty(valueElemTy, vec);
+    Type rmwTy = vec == 1 ? valueElemTy : vecTy;
+    bool aggregated = isAggregated(op);
     SmallVector<Value> resultVals(elemsPerThread);
     for (size_t i = 0; i < elemsPerThread; i += vec) {
+      if (aggregated)
+        std::tie(valElements[i], maskElements[i]) =
+            aggregate(loc, rewriter, ptrElements[i], valElements[i],
+                      and_(maskElements[i], mask));
       Value rmwVal = undef(vecTy);
       for (int ii = 0; ii < vec; ++ii) {
         Value iiVal = createIndexAttrConstant(
@@ -656,26 +894,34 @@ struct AtomicRMWOpConversion
         rmwMask = and_(rmwMask, icmp_eq(tid, i32_val(0)));
       }
 
-      Value undefVal = undef(valueElemTy);
+      Value undefVal = undef(rmwTy);
       // Build blocks to bypass the atomic instruction for ~rmwMask.
       auto *curBlock = rewriter.getInsertionBlock();
       auto *endBlock = curBlock->splitBlock(rewriter.getInsertionPoint());
       auto *atomicBlock = rewriter.createBlock(
           curBlock->getParent(), std::next(Region::iterator(curBlock)));
-      endBlock->addArgument({valueElemTy}, {loc});
+      endBlock->addArgument({rmwTy}, {loc});
 
       rewriter.setInsertionPointToEnd(curBlock);
       rewriter.create<LLVM::CondBrOp>(loc, rmwMask, atomicBlock, endBlock,
                                       undefVal);
 
       rewriter.setInsertionPointToEnd(atomicBlock);
-      auto maybeKind = matchAtomicOp(atomicRmwAttr);
-      // TODO: use amdgpu.raw_buffer_atomic_fadd for MI-* series of AMD GPU
-      // since it supports memref indexes (after moving triton to use memrefs).
-      auto atom = rewriter.create<LLVM::AtomicRMWOp>(
-          loc, valueElemTy, *maybeKind, rmwPtr, valElements[i],
-          LLVM::AtomicOrdering::monotonic);
-      rewriter.create<LLVM::BrOp>(loc, atom.getResult(), endBlock);
+      Value atom;
+      if (vec == 2) {
+        // Selected as global_atomic_pk_add_f16 where the target has it, and
+        // split into two scalar atomics otherwise by the HSACO translation
+        atom = callPackedAtomicFAdd(loc, rewriter, op, rmwPtr, rmwVal);
+      } else {
+        auto maybeKind = matchAtomicOp(atomicRmwAttr);
+        // TODO: use amdgpu.raw_buffer_atomic_fadd for MI-* series of AMD GPU
+        // since it supports memref indexes (after moving triton to use
+        // memrefs).
+        atom = rewriter.create<LLVM::AtomicRMWOp>(
+            loc, valueElemTy, *maybeKind, rmwPtr, valElements[i],
+            getAtomicOrdering(op.sem(), LLVM::AtomicOrdering::monotonic));
+      }
+      rewriter.create<LLVM::BrOp>(loc, atom, endBlock);
 
       rewriter.setInsertionPointToStart(endBlock);
       Value retVal = endBlock->getArgument(0);
@@ -735,7 +981,12 @@ struct AtomicRMWOpConversion
     // tensor
     if (valueTy) {
       auto valTy = val.getType().cast<RankedTensorType>();
-      vec = std::min<unsigned>(vec, valTy.getElementType().isF16() ? 2 : 1);
+      // f16 pairs are only added together in global memory
+      bool isPackedFAdd =
+          valTy.getElementType().isF16() && !isSharedPointer(ptr);
+      vec = std::min<unsigned>(vec, isPackedFAdd ? 2 : 1);
+      if (llMask)
+        vec = std::min<unsigned>(vec, getMaskAlignment(op.mask()));
       // mask
       auto shape = valueTy.getShape();
       auto numElements = product(shape);
@@ -744,8 +995,13 @@ struct AtomicRMWOpConversion
     }
 
     auto vecTy = vec_ty(valueElemTy, vec);
+    bool aggregated = isAggregated(op);
     SmallVector<Value> resultVals(elemsPerThread);
     for (size_t i = 0; i < elemsPerThread; i += vec) {
+      if (aggregated)
+        std::tie(valElements[i], maskElements[i]) =
+            aggregate(loc, rewriter, ptrElements[i], valElements[i],
+                      and_(maskElements[i], mask));
       Value rmwVal = undef(vecTy);
       for (int ii = 0; ii < vec; ++ii) {
         Value iiVal = createIndexAttrConstant(
@@ -762,10 +1018,18 @@ struct AtomicRMWOpConversion
                              ? "l"
                              : (valueElemNbits * vec == 32 ? "r" : "h");
       auto *dstOpr = ptxBuilderAtomicRMW.newOperand("=" + tyId);
-      auto *ptrOpr = ptxBuilderAtomicRMW.newAddrOperand(rmwPtr, "l");
+      auto *ptrOpr =
+          ptxBuilderAtomicRMW.newAddrOperand(rmwPtr, getAddrConstraint(ptr));
       auto *valOpr = ptxBuilderAtomicRMW.newOperand(rmwVal, tyId);
 
-      auto &atom = ptxBuilderAtomicRMW.create<>("atom")->global().o("gpu");
+      // Atomics on tt.scratch buffers are only seen by the CTA
+      bool isShared = isSharedPointer(ptr);
+      auto &atom = ptxBuilderAtomicRMW.create<>("atom")
+                       ->o("global", !isShared)
+                       .o("shared", isShared)
+                       .o(isShared ? "cta" : getPTXScope(op.scope()));
+      if (auto sem = op.sem())
+        atom.o(stringifyMemSemantic(*sem).str());
       auto rmwOp = stringifyRMWOp(atomicRmwAttr).str();
       auto sBits = std::to_string(valueElemNbits);
       switch (atomicRmwAttr) {
@@ -818,7 +1082,8 @@ struct AtomicRMWOpConversion
         }
       } else {
         PTXBuilder ptxBuilderMemfence;
-        auto memfenc = ptxBuilderMemfence.create<PTXInstr>("membar")->o("gl");
+        auto memfenc = ptxBuilderMemfence.create<PTXInstr>("membar")->o(
+            getMembarLevel(op.scope()));
         memfenc();
         auto ASMReturnTy = void_ty(ctx);
         ptxBuilderMemfence.launch(rewriter, loc, ASMReturnTy);
@@ -944,7 +1209,7 @@ struct InsertSliceAsyncOpConversion
     auto srcBlockedLayout = srcTy.getEncoding().cast<BlockedEncodingAttr>();
     auto resSharedLayout = resTy.getEncoding().cast<SharedEncodingAttr>();
     auto srcShape = srcTy.getShape();
-    assert(srcShape.size() == 2 &&
+    assert((srcShape.size() == 2 || srcShape.size() == 3) &&
            "insert_slice_async: Unexpected rank of %src");
 
     Value llDst = adaptor.dst();
@@ -1000,7 +1265,7 @@ struct InsertSliceAsyncOpConversion
     // start of the vector and the other pointer moving to the next vector.
     unsigned inVec = getContiguity(src);
     unsigned outVec = resSharedLayout.getVec();
-    unsigned minVec = std::min(outVec, inVec);
+    unsigned minVec = getSharedAccessVec(resSharedLayout, inVec);
     unsigned numElems = getElemsPerThread(srcTy);
     unsigned perPhase = resSharedLayout.getPerPhase();
     unsigned maxPhase = resSharedLayout.getMaxPhase();
@@ -1023,7 +1288,22 @@ struct InsertSliceAsyncOpConversion
 
     auto srcIndices = emitIndices(loc, rewriter, srcBlockedLayout, srcShape);
 
+    // In a buffer shared by the CTAs of a cluster, every CTA only copies its
+    // rows, along the slowest dimension, of the tile
+    unsigned clusterSize = resSharedLayout.getClusterSize();
+    assert((clusterSize == 1 || srcShape.size() == 2) &&
+           "insert_slice_async: Unexpected rank of a cluster buffer");
+    unsigned outerDim = resSharedLayout.getOrder()[1];
+    Value clusterRank;
+    if (clusterSize > 1)
+      clusterRank = getClusterCTARank(loc, rewriter);
+
     for (unsigned elemIdx = 0; elemIdx < numElems; elemIdx += minVec) {
+      Value inPart;
+      if (clusterSize > 1)
+        inPart = icmp_eq(udiv(srcIndices[elemIdx][outerDim],
+                              i32_val(srcShape[outerDim] / clusterSize)),
+                         clusterRank);
 
       // 16 * 8 = 128bits
       auto maxBitWidth =
@@ -1061,7 +1341,10 @@ struct InsertSliceAsyncOpConversion
                                  i32_val(byteWidth), i32_val(0));
           srcSize = ptxBuilder.newOperand(selectOp, "r");
         }
-        copyAsyncOp(dstOperand, srcOperand, copySize, srcSize);
+        auto &copyAsync =
+            copyAsyncOp(dstOperand, srcOperand, copySize, srcSize);
+        if (inPart)
+          copyAsync.predicate(inPart, "b");
         ptxBuilder.launch(rewriter, loc, void_ty(getContext()));
       }
     }
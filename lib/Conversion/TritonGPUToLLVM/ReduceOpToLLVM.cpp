@@ -1,36 +1,316 @@
 #include "ReduceOpToLLVM.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 
 using namespace mlir;
 using namespace mlir::triton;
 
 using ::mlir::LLVM::getElementsFromStruct;
 using ::mlir::LLVM::getStructFromElements;
+using ::mlir::LLVM::shflIdxSync;
 using ::mlir::LLVM::shflSync;
 using ::mlir::LLVM::storeShared;
 using ::mlir::triton::gpu::getElemsPerThread;
 using ::mlir::triton::gpu::getOrder;
 
-struct ReduceOpConversion
-    : public ConvertTritonGPUOpToLLVMPattern<triton::ReduceOp> {
+// Reduces first within threads, then within warps with butterfly shuffles,
+// then across the warps along the reduction axis with a single exchange of
+// one partial result per warp through shared memory.
+//
+// Every element carries the values of all the reduced tensors (e.g. a value
+// and its index for arg-reductions); ConcreteT provides them, along with the
+// function combining two sets of them and the construction of the results.
+template <typename SourceOp, typename ConcreteT>
+class ReduceOpConversionBase
+    : public ConvertTritonGPUOpToLLVMPattern<SourceOp> {
 public:
-  using ConvertTritonGPUOpToLLVMPattern<
-      triton::ReduceOp>::ConvertTritonGPUOpToLLVMPattern;
+  using OpAdaptor = typename SourceOp::Adaptor;
+
+  explicit ReduceOpConversionBase(
+      LLVMTypeConverter &typeConverter, const Allocation *allocation,
+      Value smem,
+      ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo indexCacheInfo,
+      PatternBenefit benefit)
+      : ConvertTritonGPUOpToLLVMPattern<SourceOp>(typeConverter, allocation,
+                                                  smem, indexCacheInfo,
+                                                  benefit) {}
 
   LogicalResult
-  matchAndRewrite(triton::ReduceOp op, OpAdaptor adaptor,
+  matchAndRewrite(SourceOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
-    if (ReduceOpHelper(op).isFastReduction())
-      return matchAndRewriteFast(op, adaptor, rewriter);
-    return matchAndRewriteBasic(op, adaptor, rewriter);
+    ReduceOpHelper helper(op);
+    if (!helper.isSupportedLayout())
+      return op.emitError("unsupported layout for reduction");
+
+    auto *concreteThis = static_cast<const ConcreteT *>(this);
+    Location loc = op->getLoc();
+    unsigned axis = op.axis();
+
+    auto srcLayout = helper.getSrcLayout();
+    auto srcShape = helper.getSrcShape();
+    SmallVector<Type> elemTys = concreteThis->getElementTypes(op);
+    unsigned numValues = elemTys.size();
+
+    auto srcIndices = this->emitIndices(loc, rewriter, srcLayout, srcShape);
+    SmallVector<SmallVector<Value>> srcValues =
+        concreteThis->getSrcValues(op, adaptor, srcIndices, rewriter);
+
+    SmallVector<SmallVector<unsigned>> offset =
+        this->emitOffsetForLayout(srcLayout, srcShape);
+
+    std::map<SmallVector<unsigned>, SmallVector<Value>> accs;
+    std::map<SmallVector<unsigned>, SmallVector<Value>> indices;
+
+    // reduce within threads
+    for (unsigned i = 0; i < srcValues.size(); ++i) {
+      SmallVector<unsigned> key = offset[i];
+      key[axis] = 0;
+      auto it = accs.find(key);
+      if (it == accs.end()) {
+        accs[key] = srcValues[i];
+        indices[key] = srcIndices[i];
+        continue;
+      }
+      concreteThis->accumulate(op, rewriter, it->second, srcValues[i]);
+    }
+
+    Value threadId = this->getThreadId(rewriter, loc);
+    Value warpSize = i32_val(helper.getWarpSize());
+    Value warpId = udiv(threadId, warpSize);
+    Value laneId = urem(threadId, warpSize);
+
+    // Reduce within warps. After the butterfly every lane along the axis
+    // holds the reduction of the whole warp.
+    unsigned sizeIntraWarps = helper.getIntraWarpSize();
+    unsigned intraWarpStride = helper.getIntraWarpStride();
+    for (auto &it : accs)
+      for (unsigned N = sizeIntraWarps / 2; N > 0; N >>= 1)
+        shuffleAccumulate(op, rewriter, laneId, N * intraWarpStride,
+                          it.second);
+
+    unsigned sizeInterWarps = helper.getInterWarpSize();
+    if (sizeInterWarps == 1) {
+      // A single warp covers the axis: the values of the result are already
+      // in the threads that own them
+      SmallVector<int64_t> resultShape(srcShape.begin(), srcShape.end());
+      resultShape[axis] = 1;
+      SmallVector<SmallVector<Value>> resultVals;
+      for (SmallVector<unsigned> key :
+           this->emitOffsetForLayout(srcLayout, resultShape)) {
+        key[axis] = 0;
+        resultVals.push_back(accs[key]);
+      }
+      concreteThis->replaceWithResults(op, resultVals, rewriter);
+      return success();
+    }
+
+    // Each of the reduced values has its own region of the buffer
+    auto smemShape = helper.getScratchConfig();
+    unsigned elems = product<unsigned>(smemShape);
+    Value smemBase =
+        this->getSharedMemoryBase(loc, rewriter, op.getOperation());
+    SmallVector<Type> elemPtrTys;
+    SmallVector<Value> smemBases;
+    for (unsigned k = 0; k < numValues; ++k) {
+      elemPtrTys.push_back(LLVM::LLVMPointerType::get(elemTys[k], 3));
+      if (k > 0)
+        smemBase = gep(elemPtrTys[k - 1], smemBases[k - 1], i32_val(elems));
+      smemBases.push_back(bitcast(smemBase, elemPtrTys[k]));
+    }
+
+    // The partial results of the warps are stored with the axis as the
+    // fastest varying dimension, so that the ones to combine are held by
+    // consecutive lanes in the second round
+    SmallVector<unsigned> smemOrder{axis};
+    for (unsigned d : getOrder(srcLayout))
+      if (d != axis)
+        smemOrder.push_back(d);
+
+    unsigned threadAxis = helper.getThreadAxis();
+    auto threadsPerWarp = helper.getThreadsPerWarp();
+    auto warpsPerCTA = helper.getWarpsPerCTA();
+    SmallVector<Value> multiDimLaneId = delinearize(
+        rewriter, loc, laneId, threadsPerWarp, helper.getLaneOrder());
+    SmallVector<Value> multiDimWarpId =
+        delinearize(rewriter, loc, warpId, warpsPerCTA, helper.getWarpOrder());
+    Value zero = i32_val(0);
+    Value laneZero = icmp_eq(multiDimLaneId[threadAxis], zero);
+    // Warps beyond the extent of the axis hold copies
+    Value warpIdAxis =
+        urem(multiDimWarpId[threadAxis], i32_val(sizeInterWarps));
+
+    for (auto &it : accs) {
+      const SmallVector<unsigned> &key = it.first;
+      SmallVector<Value> writeIdx = indices[key];
+      writeIdx[axis] = warpIdAxis;
+      Value writeOffset =
+          linearize(rewriter, loc, writeIdx, smemShape, smemOrder);
+      for (unsigned k = 0; k < numValues; ++k) {
+        Value writePtr = gep(elemPtrTys[k], smemBases[k], writeOffset);
+        storeShared(rewriter, loc, writePtr, it.second[k], laneZero);
+      }
+    }
+
+    barrier();
+
+    // The second round of shuffle reduction
+    //   now the problem size: sizeInterWarps, s1, s2, .. , sn
+    //   where sizeInterWarps is 2^m
+    //
+    // Each thread needs to process:
+    //   elemsPerThread = sizeInterWarps * s1 * s2 .. Sn / numThreads
+    auto mod = op->template getParentOfType<ModuleOp>();
+    unsigned numThreads = triton::gpu::TritonGPUDialect::getNumWarps(mod) *
+                          triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+    unsigned elemsPerThread = ceil<unsigned>(elems, numThreads);
+    Value isLeader = icmp_eq(urem(threadId, i32_val(sizeInterWarps)), zero);
+    for (unsigned round = 0; round < elemsPerThread; ++round) {
+      Value readOffset = add(threadId, i32_val(round * numThreads));
+      // Threads past the end of the buffer work on a copy of the first
+      // element, and don't write it back
+      Value threadIsNeeded = icmp_slt(readOffset, i32_val(elems));
+      readOffset = select(threadIsNeeded, readOffset, zero);
+      SmallVector<Value> readPtrs;
+      SmallVector<Value> acc;
+      for (unsigned k = 0; k < numValues; ++k) {
+        readPtrs.push_back(gep(elemPtrTys[k], smemBases[k], readOffset));
+        acc.push_back(load(readPtrs[k]));
+      }
+
+      for (unsigned N = sizeInterWarps / 2; N > 0; N >>= 1)
+        shuffleAccumulate(op, rewriter, laneId, N, acc);
+
+      // only the first thread in each sizeInterWarps is writing
+      Value pred = and_(threadIsNeeded, isLeader);
+      for (unsigned k = 0; k < numValues; ++k)
+        storeShared(rewriter, loc, readPtrs[k], acc[k], pred);
+    }
+
+    barrier();
+
+    // set output values
+    SmallVector<SmallVector<Value>> resultVals;
+    auto loadResult = [&](Value readOffset) {
+      SmallVector<Value> vals;
+      for (unsigned k = 0; k < numValues; ++k)
+        vals.push_back(load(gep(elemPtrTys[k], smemBases[k], readOffset)));
+      resultVals.push_back(vals);
+    };
+    if (auto resultTy =
+            op->getResult(0).getType().template dyn_cast<RankedTensorType>()) {
+      // nd-tensor where n >= 1
+      auto resultIndices = this->emitIndices(
+          loc, rewriter, resultTy.getEncoding(), resultTy.getShape());
+      assert(resultIndices.size() == getElemsPerThread(resultTy));
+      for (SmallVector<Value> readIdx : resultIndices) {
+        readIdx.insert(readIdx.begin() + axis, zero);
+        loadResult(linearize(rewriter, loc, readIdx, smemShape, smemOrder));
+      }
+    } else {
+      // 0d-tensor -> scalar
+      loadResult(zero);
+    }
+    concreteThis->replaceWithResults(op, resultVals, rewriter);
+    return success();
+  }
+
+protected:
+  // Builds the result of the reduction of every tensor from the values of
+  // its elements owned by the thread
+  SmallVector<Value> packResults(SourceOp op,
+                                 ArrayRef<SmallVector<Value>> resultVals,
+                                 ConversionPatternRewriter &rewriter) const {
+    Location loc = op->getLoc();
+    SmallVector<Value> results;
+    for (unsigned k = 0; k < resultVals.front().size(); ++k) {
+      SmallVector<Value> vals;
+      for (const SmallVector<Value> &elemVals : resultVals)
+        vals.push_back(elemVals[k]);
+      if (!op->getResult(0).getType().template isa<RankedTensorType>()) {
+        // 0d-tensor -> scalar
+        results.push_back(vals.front());
+        continue;
+      }
+      SmallVector<Type> resultTypes(vals.size(), vals.front().getType());
+      Type structTy =
+          LLVM::LLVMStructType::getLiteral(this->getContext(), resultTypes);
+      results.push_back(getStructFromElements(loc, vals, rewriter, structTy));
+    }
+    return results;
   }
 
 private:
-  void accumulate(ConversionPatternRewriter &rewriter, Location loc,
-                  RedOp redOp, Value &acc, Value cur, bool isFirst) const {
-    if (isFirst) {
-      acc = cur;
-      return;
+  // One step of a butterfly reduction: combines the accumulators of the
+  // lanes whose ids differ by `mask`
+  void shuffleAccumulate(SourceOp op, ConversionPatternRewriter &rewriter,
+                         Value laneId, unsigned mask,
+                         SmallVector<Value> &acc) const {
+    Location loc = op->getLoc();
+    SmallVector<Value> cur;
+    for (Value val : acc) {
+      // Butterfly shuffles stay within groups of 32 lanes; the two halves of
+      // 64-lane wavefronts exchange values through an indexed shuffle
+      if (mask < 32)
+        cur.push_back(shflSync(loc, rewriter, val, mask));
+      else
+        cur.push_back(
+            shflIdxSync(loc, rewriter, val, xor_(laneId, i32_val(mask))));
     }
+    static_cast<const ConcreteT *>(this)->accumulate(op, rewriter, acc, cur);
+  }
+};
+
+struct ReduceOpConversion
+    : public ReduceOpConversionBase<triton::ReduceOp, ReduceOpConversion> {
+public:
+  using ReduceOpConversionBase<triton::ReduceOp,
+                               ReduceOpConversion>::ReduceOpConversionBase;
+
+  // The reduced value, followed by its index for arg-reductions
+  SmallVector<Type> getElementTypes(triton::ReduceOp op) const {
+    auto srcTy = op.operand().getType().cast<RankedTensorType>();
+    SmallVector<Type> elemTys{
+        getTypeConverter()->convertType(srcTy.getElementType())};
+    if (triton::ReduceOp::withIndex(op.redOp()))
+      elemTys.push_back(getTypeConverter()->getIndexType());
+    return elemTys;
+  }
+
+  SmallVector<SmallVector<Value>>
+  getSrcValues(triton::ReduceOp op, OpAdaptor adaptor,
+               ArrayRef<SmallVector<Value>> srcIndices,
+               ConversionPatternRewriter &rewriter) const {
+    bool withIndex = triton::ReduceOp::withIndex(op.redOp());
+    auto values = getElementsFromStruct(op->getLoc(), adaptor.operand(),
+                                        rewriter);
+    SmallVector<SmallVector<Value>> srcValues;
+    for (unsigned i = 0; i < values.size(); ++i) {
+      srcValues.push_back({values[i]});
+      if (withIndex)
+        srcValues.back().push_back(srcIndices[i][op.axis()]);
+    }
+    return srcValues;
+  }
+
+  void accumulate(triton::ReduceOp op, ConversionPatternRewriter &rewriter,
+                  SmallVector<Value> &acc, ValueRange cur) const {
+    if (triton::ReduceOp::withIndex(op.redOp()))
+      accumulateWithIndex(rewriter, op->getLoc(), op.redOp(), acc[0], acc[1],
+                          cur[0], cur[1]);
+    else
+      accumulate(rewriter, op->getLoc(), op.redOp(), acc[0], cur[0]);
+  }
+
+  void replaceWithResults(triton::ReduceOp op,
+                          ArrayRef<SmallVector<Value>> resultVals,
+                          ConversionPatternRewriter &rewriter) const {
+    // Arg-reductions only return the index
+    auto results = packResults(op, resultVals, rewriter);
+    rewriter.replaceOp(op, results.back());
+  }
+
+private:
+  void accumulate(ConversionPatternRewriter &rewriter, Location loc,
+                  RedOp redOp, Value &acc, Value cur) const {
     switch (redOp) {
     case RedOp::ADD:
       acc = add(acc, cur);
@@ -74,12 +354,7 @@ private:
 
   void accumulateWithIndex(ConversionPatternRewriter &rewriter, Location loc,
                            RedOp redOp, Value &acc, Value &accIndex, Value cur,
-                           Value curIndex, bool isFirst) const {
-    if (isFirst) {
-      acc = cur;
-      accIndex = curIndex;
-      return;
-    }
+                           Value curIndex) const {
     switch (redOp) {
     case RedOp::ARGMIN:
       accIndex = select(
@@ -133,349 +408,61 @@ private:
     }
   }
 
-  // Use shared memory for reduction within warps and across warps
-  LogicalResult
-  matchAndRewriteBasic(triton::ReduceOp op, OpAdaptor adaptor,
-                       ConversionPatternRewriter &rewriter) const {
-    Location loc = op->getLoc();
-    unsigned axis = op.axis();
-    bool withIndex = triton::ReduceOp::withIndex(op.redOp());
-
-    auto srcTy = op.operand().getType().cast<RankedTensorType>();
-    auto srcLayout = srcTy.getEncoding().cast<BlockedEncodingAttr>();
-    auto srcOrd = srcLayout.getOrder();
-    auto srcShape = srcTy.getShape();
-
-    auto llvmElemTy = getTypeConverter()->convertType(srcTy.getElementType());
-    auto llvmIndexTy = getTypeConverter()->getIndexType();
-    auto elemPtrTy = LLVM::LLVMPointerType::get(llvmElemTy, 3);
-    auto indexPtrTy = LLVM::LLVMPointerType::get(llvmIndexTy, 3);
-    Value smemBase = getSharedMemoryBase(loc, rewriter, op.getOperation());
-    smemBase = bitcast(smemBase, elemPtrTy);
-
-    ReduceOpHelper helper(op);
-    auto smemShape = helper.getScratchConfigBasic();
-    unsigned elems = product<unsigned>(smemShape);
-    Value indexSmemBase = gep(elemPtrTy, smemBase, i32_val(elems));
-    indexSmemBase = bitcast(indexSmemBase, indexPtrTy);
-
-    unsigned srcElems = getElemsPerThread(srcTy);
-    auto srcIndices = emitIndices(loc, rewriter, srcLayout, srcShape);
-    auto srcValues = getElementsFromStruct(loc, adaptor.operand(), rewriter);
-
-    SmallVector<SmallVector<unsigned>> offset =
-        emitOffsetForLayout(srcLayout, srcShape);
-
-    std::map<SmallVector<unsigned>, Value> accs;
-    std::map<SmallVector<unsigned>, Value> accIndices;
-    std::map<SmallVector<unsigned>, SmallVector<Value>> indices;
-
-    // reduce within threads
-    for (unsigned i = 0; i < srcElems; ++i) {
-      SmallVector<unsigned> key = offset[i];
-      key[axis] = 0;
-      bool isFirst = accs.find(key) == accs.end();
-      if (!withIndex) {
-        accumulate(rewriter, loc, op.redOp(), accs[key], srcValues[i], isFirst);
-      } else {
-        Value curIndex = srcIndices[i][axis];
-        accumulateWithIndex(rewriter, loc, op.redOp(), accs[key],
-                            accIndices[key], srcValues[i], curIndex, isFirst);
-      }
-      if (isFirst)
-        indices[key] = srcIndices[i];
-    }
-
-    // cached int32 constants
-    std::map<int, Value> ints;
-    ints[0] = i32_val(0);
-    for (int N = smemShape[axis] / 2; N > 0; N >>= 1)
-      ints[N] = i32_val(N);
-    Value sizePerThread = i32_val(srcLayout.getSizePerThread()[axis]);
-
-    // reduce across threads
-    for (auto it : accs) {
-      const SmallVector<unsigned> &key = it.first;
-      Value acc = it.second;
-      Value accIndex;
-      if (withIndex)
-        accIndex = accIndices[key];
-      SmallVector<Value> writeIdx = indices[key];
-
-      writeIdx[axis] = udiv(writeIdx[axis], sizePerThread);
-      Value writeOffset = linearize(rewriter, loc, writeIdx, smemShape, srcOrd);
-      Value writePtr = gep(elemPtrTy, smemBase, writeOffset);
-      Value indexWritePtr = gep(indexPtrTy, indexSmemBase, writeOffset);
-      store(acc, writePtr);
-      if (withIndex)
-        store(accIndex, indexWritePtr);
-
-      SmallVector<Value> readIdx(writeIdx.size(), ints[0]);
-      for (int N = smemShape[axis] / 2; N > 0; N >>= 1) {
-        readIdx[axis] = ints[N];
-        Value readMask = icmp_slt(writeIdx[axis], ints[N]);
-        Value readOffset = select(
-            readMask, linearize(rewriter, loc, readIdx, smemShape, srcOrd),
-            ints[0]);
-        Value readPtr = gep(elemPtrTy, writePtr, readOffset);
-        barrier();
-        if (!withIndex) {
-          Value cur = load(readPtr);
-          accumulate(rewriter, loc, op.redOp(), acc, cur, false);
-          barrier();
-          store(acc, writePtr);
-        } else {
-          Value cur = load(readPtr);
-          Value indexReadPtr = gep(indexPtrTy, indexWritePtr, readOffset);
-          Value curIndex = load(indexReadPtr);
-          accumulateWithIndex(rewriter, loc, op.redOp(), acc, accIndex, cur,
-                              curIndex, false);
-          barrier();
-          store(acc, writePtr);
-          store(accIndex, indexWritePtr);
-        }
-      }
-    }
-
-    barrier();
-
-    // set output values
-    if (auto resultTy = op.getType().dyn_cast<RankedTensorType>()) {
-      // nd-tensor where n >= 1
-      auto resultLayout = resultTy.getEncoding();
-      auto resultShape = resultTy.getShape();
-
-      unsigned resultElems = getElemsPerThread(resultTy);
-      auto resultIndices =
-          emitIndices(loc, rewriter, resultLayout, resultShape);
-      assert(resultIndices.size() == resultElems);
-
-      SmallVector<Value> resultVals(resultElems);
-      for (unsigned i = 0; i < resultElems; ++i) {
-        SmallVector<Value> readIdx = resultIndices[i];
-        readIdx.insert(readIdx.begin() + axis, ints[0]);
-        Value readOffset = linearize(rewriter, loc, readIdx, smemShape, srcOrd);
-        Value readPtr = gep(elemPtrTy, smemBase, readOffset);
-        Value indexReadPtr = gep(indexPtrTy, indexSmemBase, readOffset);
-        resultVals[i] = withIndex ? load(indexReadPtr) : load(readPtr);
-      }
+};
 
-      SmallVector<Type> resultTypes(resultElems,
-                                    withIndex ? llvmIndexTy : llvmElemTy);
-      Type structTy =
-          LLVM::LLVMStructType::getLiteral(this->getContext(), resultTypes);
-      Value ret = getStructFromElements(loc, resultVals, rewriter, structTy);
-      rewriter.replaceOp(op, ret);
-    } else {
-      // 0d-tensor -> scalar
-      Value resultVal = withIndex ? load(indexSmemBase) : load(smemBase);
-      rewriter.replaceOp(op, resultVal);
+struct GenericReduceOpConversion
+    : public ReduceOpConversionBase<triton::GenericReduceOp,
+                                    GenericReduceOpConversion> {
+public:
+  using ReduceOpConversionBase<
+      triton::GenericReduceOp,
+      GenericReduceOpConversion>::ReduceOpConversionBase;
+
+  SmallVector<Type> getElementTypes(triton::GenericReduceOp op) const {
+    SmallVector<Type> elemTys;
+    for (Value operand : op.operands()) {
+      auto srcTy = operand.getType().cast<RankedTensorType>();
+      elemTys.push_back(
+          getTypeConverter()->convertType(srcTy.getElementType()));
     }
-
-    return success();
+    return elemTys;
   }
 
-  // Use warp shuffle for reduction within warps and shared memory for data
-  // exchange across warps
-  LogicalResult matchAndRewriteFast(triton::ReduceOp op, OpAdaptor adaptor,
-                                    ConversionPatternRewriter &rewriter) const {
-    Location loc = op->getLoc();
-    unsigned axis = adaptor.axis();
-    bool withIndex = triton::ReduceOp::withIndex(op.redOp());
-
-    auto srcTy = op.operand().getType().cast<RankedTensorType>();
-    auto srcLayout = srcTy.getEncoding();
-    auto srcShape = srcTy.getShape();
-    auto srcRank = srcTy.getRank();
-    auto order = getOrder(srcLayout);
-
-    auto threadsPerWarp = triton::gpu::getThreadsPerWarp(srcLayout);
-    auto warpsPerCTA = triton::gpu::getWarpsPerCTA(srcLayout);
-
-    auto llvmElemTy = getTypeConverter()->convertType(srcTy.getElementType());
-    auto llvmIndexTy = getTypeConverter()->getIndexType();
-    auto elemPtrTy = LLVM::LLVMPointerType::get(llvmElemTy, 3);
-    auto indexPtrTy = LLVM::LLVMPointerType::get(llvmIndexTy, 3);
-    Value smemBase = getSharedMemoryBase(loc, rewriter, op.getOperation());
-    smemBase = bitcast(smemBase, elemPtrTy);
-
-    ReduceOpHelper helper(op);
-    auto smemShapes = helper.getScratchConfigsFast();
-    unsigned elems = product<unsigned>(smemShapes[0]);
-    unsigned maxElems = std::max(elems, product<unsigned>(smemShapes[1]));
-    Value indexSmemBase = gep(elemPtrTy, smemBase, i32_val(maxElems));
-    indexSmemBase = bitcast(indexSmemBase, indexPtrTy);
-
-    unsigned sizeIntraWarps = helper.getIntraWarpSize();
-    unsigned sizeInterWarps = helper.getInterWarpSize();
-
-    unsigned srcElems = getElemsPerThread(srcTy);
-    auto srcIndices = emitIndices(loc, rewriter, srcLayout, srcShape);
-    auto srcValues = getElementsFromStruct(loc, adaptor.operand(), rewriter);
-
-    SmallVector<SmallVector<unsigned>> offset =
-        emitOffsetForLayout(srcLayout, srcShape);
-
-    std::map<SmallVector<unsigned>, Value> accs;
-    std::map<SmallVector<unsigned>, Value> accIndices;
-    std::map<SmallVector<unsigned>, SmallVector<Value>> indices;
-
-    // reduce within threads
-    for (unsigned i = 0; i < srcElems; ++i) {
-      SmallVector<unsigned> key = offset[i];
-      key[axis] = 0;
-      bool isFirst = accs.find(key) == accs.end();
-      if (!withIndex) {
-        accumulate(rewriter, loc, op.redOp(), accs[key], srcValues[i], isFirst);
-      } else {
-        Value curIndex = srcIndices[i][axis];
-        accumulateWithIndex(rewriter, loc, op.redOp(), accs[key],
-                            accIndices[key], srcValues[i], curIndex, isFirst);
-      }
-      if (isFirst)
-        indices[key] = srcIndices[i];
-    }
-
-    Value threadId = getThreadId(rewriter, loc);
-    Value warpSize = i32_val(32);
-    Value warpId = udiv(threadId, warpSize);
-    Value laneId = urem(threadId, warpSize);
-
-    SmallVector<Value> multiDimLaneId =
-        delinearize(rewriter, loc, laneId, threadsPerWarp, order);
-    SmallVector<Value> multiDimWarpId =
-        delinearize(rewriter, loc, warpId, warpsPerCTA, order);
-
-    Value laneIdAxis = multiDimLaneId[axis];
-    Value warpIdAxis = multiDimWarpId[axis];
-
-    Value zero = i32_val(0);
-    Value laneZero = icmp_eq(laneIdAxis, zero);
-    Value warpZero = icmp_eq(warpIdAxis, zero);
-
-    for (auto it : accs) {
-      const SmallVector<unsigned> &key = it.first;
-      Value acc = it.second;
-      Value accIndex;
-      if (withIndex)
-        accIndex = accIndices[key];
-
-      // Reduce within warps
-      for (unsigned N = sizeIntraWarps / 2; N > 0; N >>= 1) {
-        Value shfl = shflSync(loc, rewriter, acc, N);
-        if (!withIndex) {
-          accumulate(rewriter, loc, op.redOp(), acc, shfl, false);
-        } else {
-          Value shflIndex = shflSync(loc, rewriter, accIndex, N);
-          accumulateWithIndex(rewriter, loc, op.redOp(), acc, accIndex, shfl,
-                              shflIndex, false);
-        }
-      }
-
-      SmallVector<Value> writeIdx = indices[key];
-      writeIdx[axis] = (sizeInterWarps == 1) ? zero : warpIdAxis;
-      Value writeOffset =
-          linearize(rewriter, loc, writeIdx, smemShapes[0], order);
-      Value writePtr = gep(elemPtrTy, smemBase, writeOffset);
-      storeShared(rewriter, loc, writePtr, acc, laneZero);
-      if (withIndex) {
-        Value indexWritePtr = gep(indexPtrTy, indexSmemBase, writeOffset);
-        storeShared(rewriter, loc, indexWritePtr, accIndex, laneZero);
-      }
-    }
-
-    barrier();
-
-    // The second round of shuffle reduction
-    //   now the problem size: sizeInterWarps, s1, s2, .. , sn
-    //   where sizeInterWarps is 2^m
-    //
-    // Each thread needs to process:
-    //   elemsPerThread = sizeInterWarps * s1 * s2 .. Sn / numThreads
-    unsigned numThreads =
-        product<unsigned>(triton::gpu::getWarpsPerCTA(srcLayout)) * 32;
-    unsigned elemsPerThread = std::max<unsigned>(elems / numThreads, 1);
-    Value readOffset = threadId;
-    for (unsigned round = 0; round < elemsPerThread; ++round) {
-      Value readPtr = gep(elemPtrTy, smemBase, readOffset);
-      // FIXME(Qingyi): need predicate icmp_slt(threadId,
-      // i32_val(sizeInerWarps))
-      Value acc = load(readPtr);
-      Value accIndex;
-      if (withIndex) {
-        Value readIndexPtr = gep(indexPtrTy, indexSmemBase, readOffset);
-        accIndex = load(readIndexPtr);
-      }
-
-      for (unsigned N = sizeInterWarps / 2; N > 0; N >>= 1) {
-        Value shfl = shflSync(loc, rewriter, acc, N);
-        if (!withIndex) {
-          accumulate(rewriter, loc, op.redOp(), acc, shfl, false);
-        } else {
-          Value shflIndex = shflSync(loc, rewriter, accIndex, N);
-          accumulateWithIndex(rewriter, loc, op.redOp(), acc, accIndex, shfl,
-                              shflIndex, false);
-        }
-      }
-
-      // only the first thread in each sizeInterWarps is writing
-      Value writeOffset = readOffset;
-      Value writePtr = gep(elemPtrTy, smemBase, writeOffset);
-      Value threadIsNeeded = icmp_slt(threadId, i32_val(elems));
-      Value laneIdModSizeInterWarps = urem(laneId, i32_val(sizeInterWarps));
-      Value laneIdModSizeInterWarpsIsZero =
-          icmp_eq(laneIdModSizeInterWarps, zero);
-      Value pred = and_(threadIsNeeded, laneIdModSizeInterWarpsIsZero);
-      storeShared(rewriter, loc, writePtr, acc, pred);
-      if (withIndex) {
-        Value writeIndexPtr = gep(indexPtrTy, indexSmemBase, writeOffset);
-        storeShared(rewriter, loc, writeIndexPtr, accIndex, pred);
-      }
-
-      if (round != elemsPerThread - 1) {
-        readOffset = add(readOffset, i32_val(numThreads));
-      }
+  SmallVector<SmallVector<Value>>
+  getSrcValues(triton::GenericReduceOp op, OpAdaptor adaptor,
+               ArrayRef<SmallVector<Value>> srcIndices,
+               ConversionPatternRewriter &rewriter) const {
+    SmallVector<SmallVector<Value>> srcValues(srcIndices.size());
+    for (Value operand : adaptor.operands()) {
+      auto values = getElementsFromStruct(op->getLoc(), operand, rewriter);
+      for (unsigned i = 0; i < values.size(); ++i)
+        srcValues[i].push_back(values[i]);
     }
+    return srcValues;
+  }
 
-    // We could avoid this barrier in some of the layouts, however this is not
-    // the general case.
-    // TODO: optimize the barrier incase the layouts are accepted.
-    barrier();
-
-    // set output values
-    if (auto resultTy = op.getType().dyn_cast<RankedTensorType>()) {
-      // nd-tensor where n >= 1
-      auto resultLayout = resultTy.getEncoding().cast<SliceEncodingAttr>();
-      auto resultShape = resultTy.getShape();
-      unsigned resultElems = getElemsPerThread(resultTy);
-      auto resultIndices =
-          emitIndices(loc, rewriter, resultLayout, resultShape);
-      assert(resultIndices.size() == resultElems);
-
-      SmallVector<Value> resultVals(resultElems);
-      for (size_t i = 0; i < resultElems; ++i) {
-        SmallVector<Value> readIdx = resultIndices[i];
-        readIdx.insert(readIdx.begin() + axis, i32_val(0));
-        Value readOffset =
-            linearize(rewriter, loc, readIdx, smemShapes[0], order);
-        Value readPtr = gep(elemPtrTy, smemBase, readOffset);
-        Value indexReadPtr = gep(indexPtrTy, indexSmemBase, readOffset);
-        resultVals[i] = withIndex ? load(indexReadPtr) : load(readPtr);
-      }
-
-      SmallVector<Type> resultTypes(resultElems,
-                                    withIndex ? llvmIndexTy : llvmElemTy);
-      Type structTy =
-          LLVM::LLVMStructType::getLiteral(this->getContext(), resultTypes);
-      Value ret = getStructFromElements(loc, resultVals, rewriter, structTy);
-      rewriter.replaceOp(op, ret);
-    } else {
-      // 0d-tensor -> scalar
-      Value resultVal = withIndex ? load(indexSmemBase) : load(smemBase);
-      rewriter.replaceOp(op, resultVal);
+  // Inlines a copy of the combine function
+  void accumulate(triton::GenericReduceOp op,
+                  ConversionPatternRewriter &rewriter, SmallVector<Value> &acc,
+                  ValueRange cur) const {
+    Block &combineBlock = op.combineOp().front();
+    BlockAndValueMapping mapping;
+    for (unsigned k = 0; k < acc.size(); ++k) {
+      mapping.map(combineBlock.getArgument(k), acc[k]);
+      mapping.map(combineBlock.getArgument(acc.size() + k), cur[k]);
     }
+    for (Operation &combineOp : combineBlock.without_terminator())
+      rewriter.clone(combineOp, mapping);
+    auto terminator =
+        cast<triton::GenericReduceReturnOp>(combineBlock.getTerminator());
+    for (unsigned k = 0; k < acc.size(); ++k)
+      acc[k] = mapping.lookupOrDefault(terminator.result()[k]);
+  }
 
-    return success();
+  void replaceWithResults(triton::GenericReduceOp op,
+                          ArrayRef<SmallVector<Value>> resultVals,
+                          ConversionPatternRewriter &rewriter) const {
+    rewriter.replaceOp(op, packResults(op, resultVals, rewriter));
   }
 };
 
@@ -485,6 +472,6 @@ void populateReduceOpToLLVMPatterns(
     const Allocation *allocation, Value smem,
     ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo &indexCacheInfo,
     PatternBenefit benefit) {
-  patterns.add<ReduceOpConversion>(typeConverter, allocation, smem,
-                                   indexCacheInfo, benefit);
+  patterns.add<ReduceOpConversion, GenericReduceOpConversion>(
+      typeConverter, allocation, smem, indexCacheInfo, benefit);
 }
@@ -0,0 +1,331 @@
+#include "ScanOpToLLVM.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+
+using namespace mlir;
+using namespace mlir::triton;
+
+using ::mlir::LLVM::getElementsFromStruct;
+using ::mlir::LLVM::getStructFromElements;
+using ::mlir::LLVM::shflIdxSync;
+using ::mlir::LLVM::storeShared;
+using ::mlir::triton::gpu::getOrder;
+using ::mlir::triton::gpu::getSizePerThread;
+
+// Scans first sequentially within threads, then across the lanes of a warp
+// with Kogge-Stone shuffles, and finally combines every element with the
+// totals of the warps and of the repetitions of the layout that precede it
+// along the axis, exchanging the totals of the warps through shared memory
+// once.
+struct ScanOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::ScanOp> {
+public:
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::ScanOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::ScanOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    ReduceOpHelper helper(op);
+    auto srcLayout = helper.getSrcLayout();
+    if (!srcLayout.isa<triton::gpu::BlockedEncodingAttr>())
+      return op.emitError("unsupported layout for tt.scan");
+
+    Location loc = op->getLoc();
+    unsigned axis = op.axis();
+    bool reverse = op.reverse();
+    auto srcShape = helper.getSrcShape();
+
+    // values[i] holds element i of every operand
+    SmallVector<SmallVector<Value>> values;
+    for (Value operand : adaptor.operands()) {
+      auto elems = getElementsFromStruct(loc, operand, rewriter);
+      values.resize(elems.size());
+      for (unsigned i = 0; i < elems.size(); ++i)
+        values[i].push_back(elems[i]);
+    }
+
+    // Group the elements of the thread by their position across the axis,
+    // then by repetition of the layout along the axis, in scan order
+    auto sizePerThread = getSizePerThread(srcLayout);
+    auto threadsPerWarp = helper.getThreadsPerWarp();
+    auto warpsPerCTA = helper.getWarpsPerCTA();
+    unsigned shapePerCTA =
+        sizePerThread[axis] * threadsPerWarp[axis] * warpsPerCTA[axis];
+    unsigned numReps = helper.getAxisRepetitions();
+    SmallVector<SmallVector<unsigned>> offset =
+        emitOffsetForLayout(srcLayout, srcShape);
+    std::map<SmallVector<unsigned>, SmallVector<SmallVector<unsigned>>> chunks;
+    for (unsigned i = 0; i < values.size(); ++i) {
+      SmallVector<unsigned> key = offset[i];
+      key[axis] = 0;
+      auto &repChunks = chunks[key];
+      repChunks.resize(numReps);
+      repChunks[offset[i][axis] / shapePerCTA].push_back(i);
+    }
+    SmallVector<unsigned> repOrder;
+    for (unsigned rep = 0; rep < numReps; ++rep)
+      repOrder.push_back(reverse ? numReps - 1 - rep : rep);
+    for (auto &it : chunks) {
+      for (SmallVector<unsigned> &chunk : it.second) {
+        llvm::sort(chunk, [&](unsigned a, unsigned b) {
+          return offset[a][axis] < offset[b][axis];
+        });
+        if (reverse)
+          std::reverse(chunk.begin(), chunk.end());
+      }
+    }
+
+    // scan within threads
+    for (auto &it : chunks)
+      for (SmallVector<unsigned> &chunk : it.second)
+        for (unsigned t = 1; t < chunk.size(); ++t)
+          values[chunk[t]] =
+              combine(op, rewriter, values[chunk[t - 1]], values[chunk[t]]);
+
+    Value threadId = getThreadId(rewriter, loc);
+    Value warpSize = i32_val(helper.getWarpSize());
+    Value warpId = udiv(threadId, warpSize);
+    Value laneId = urem(threadId, warpSize);
+    SmallVector<Value> multiDimLaneId = delinearize(
+        rewriter, loc, laneId, threadsPerWarp, helper.getLaneOrder());
+    SmallVector<Value> multiDimWarpId =
+        delinearize(rewriter, loc, warpId, warpsPerCTA, helper.getWarpOrder());
+
+    // Lanes (resp. warps) beyond the extent of the axis hold copies. Ranks
+    // number the lanes (resp. warps) along the axis in scan order.
+    unsigned sizeIntraWarps = helper.getIntraWarpSize();
+    unsigned sizeInterWarps = helper.getInterWarpSize();
+    unsigned laneStride = helper.getIntraWarpStride();
+    Value laneAxis = urem(multiDimLaneId[axis], i32_val(sizeIntraWarps));
+    Value warpAxis = urem(multiDimWarpId[axis], i32_val(sizeInterWarps));
+    Value laneRank =
+        reverse ? sub(i32_val(sizeIntraWarps - 1), laneAxis) : laneAxis;
+    Value warpRank =
+        reverse ? sub(i32_val(sizeInterWarps - 1), warpAxis) : warpAxis;
+    Value zero = i32_val(0);
+
+    // Scan across the lanes. The last element of each chunk, scanned across
+    // the lanes, is the carry of the chunks of the next lanes.
+    std::map<SmallVector<unsigned>, SmallVector<SmallVector<Value>>> laneScans;
+    for (auto &it : chunks) {
+      for (unsigned rep = 0; rep < numReps; ++rep) {
+        const SmallVector<unsigned> &chunk = it.second[rep];
+        SmallVector<Value> acc = values[chunk.back()];
+        for (unsigned N = 1; N < sizeIntraWarps; N <<= 1) {
+          SmallVector<Value> prev = shuffleUp(loc, rewriter, acc, laneId,
+                                              N * laneStride, reverse);
+          acc = selectValues(loc, rewriter, icmp_uge(laneRank, i32_val(N)),
+                             combine(op, rewriter, prev, acc), acc);
+        }
+        if (sizeIntraWarps > 1) {
+          SmallVector<Value> carry =
+              shuffleUp(loc, rewriter, acc, laneId, laneStride, reverse);
+          Value hasCarry = icmp_ne(laneRank, zero);
+          for (unsigned i : chunk)
+            values[i] =
+                selectValues(loc, rewriter, hasCarry,
+                             combine(op, rewriter, carry, values[i]), values[i]);
+        }
+        laneScans[it.first].push_back(acc);
+      }
+    }
+
+    // Totals of each repetition of the layout along the axis, for the carries
+    // of the next ones
+    std::map<SmallVector<unsigned>, SmallVector<SmallVector<Value>>> repTotals;
+    if (sizeInterWarps == 1) {
+      if (numReps > 1) {
+        // Held by the last lane in scan order
+        Value lastLane =
+            add(laneId, mul(sub(i32_val(reverse ? 0 : sizeIntraWarps - 1),
+                                laneAxis),
+                            i32_val(laneStride)));
+        for (auto &it : laneScans)
+          for (const SmallVector<Value> &acc : it.second) {
+            SmallVector<Value> total;
+            for (Value val : acc)
+              total.push_back(shflIdxSync(loc, rewriter, val, lastLane));
+            repTotals[it.first].push_back(total);
+          }
+      }
+    } else {
+      emitWarpCarries(op, helper, rewriter, chunks, laneScans, laneRank,
+                      warpAxis, warpRank, values, repTotals);
+    }
+
+    // Carries of the repetitions along the axis
+    if (numReps > 1) {
+      for (auto &it : chunks) {
+        SmallVector<Value> carry;
+        for (unsigned rep : repOrder) {
+          const SmallVector<Value> &total = repTotals[it.first][rep];
+          if (carry.empty()) {
+            carry = total;
+            continue;
+          }
+          for (unsigned i : it.second[rep])
+            values[i] = combine(op, rewriter, carry, values[i]);
+          carry = combine(op, rewriter, carry, total);
+        }
+      }
+    }
+
+    SmallVector<Value> results;
+    for (unsigned k = 0; k < op.getNumResults(); ++k) {
+      SmallVector<Value> resultVals;
+      for (const SmallVector<Value> &elemVals : values)
+        resultVals.push_back(elemVals[k]);
+      Type structTy =
+          getTypeConverter()->convertType(op.getResult(k).getType());
+      results.push_back(
+          getStructFromElements(loc, resultVals, rewriter, structTy));
+    }
+    rewriter.replaceOp(op, results);
+    return success();
+  }
+
+private:
+  // Stores the total of every warp for every repetition along the axis, then
+  // combines the elements with the totals of the preceding warps
+  void emitWarpCarries(
+      triton::ScanOp op, ReduceOpHelper &helper,
+      ConversionPatternRewriter &rewriter,
+      std::map<SmallVector<unsigned>, SmallVector<SmallVector<unsigned>>>
+          &chunks,
+      std::map<SmallVector<unsigned>, SmallVector<SmallVector<Value>>>
+          &laneScans,
+      Value laneRank, Value warpAxis, Value warpRank,
+      SmallVector<SmallVector<Value>> &values,
+      std::map<SmallVector<unsigned>, SmallVector<SmallVector<Value>>>
+          &repTotals) const {
+    Location loc = op->getLoc();
+    unsigned axis = op.axis();
+    bool reverse = op.reverse();
+    auto srcLayout = helper.getSrcLayout();
+    unsigned sizeIntraWarps = helper.getIntraWarpSize();
+    unsigned sizeInterWarps = helper.getInterWarpSize();
+
+    // Each operand has its own region of the buffer
+    auto smemShape = helper.getScanScratchConfig();
+    auto smemOrder = getOrder(srcLayout);
+    unsigned elems = product<unsigned>(smemShape);
+    Value smemBase = getSharedMemoryBase(loc, rewriter, op.getOperation());
+    SmallVector<Type> elemPtrTys;
+    SmallVector<Value> smemBases;
+    for (unsigned k = 0; k < op.getNumResults(); ++k) {
+      auto resultTy = op.getResult(k).getType().cast<RankedTensorType>();
+      Type elemTy = getTypeConverter()->convertType(resultTy.getElementType());
+      elemPtrTys.push_back(LLVM::LLVMPointerType::get(elemTy, 3));
+      if (k > 0)
+        smemBase = gep(elemPtrTys[k - 1], smemBases[k - 1], i32_val(elems));
+      smemBases.push_back(bitcast(smemBase, elemPtrTys[k]));
+    }
+
+    auto srcIndices =
+        emitIndices(loc, rewriter, srcLayout, helper.getSrcShape());
+    auto getSmemOffset = [&](unsigned elem, unsigned rep, Value warp) {
+      SmallVector<Value> idx = srcIndices[elem];
+      idx[axis] = add(i32_val(rep * sizeInterWarps), warp);
+      return linearize(rewriter, loc, idx, smemShape, smemOrder);
+    };
+
+    // The last lane in scan order holds the total of the warp
+    Value isLastLane = icmp_eq(laneRank, i32_val(sizeIntraWarps - 1));
+    for (auto &it : chunks) {
+      for (unsigned rep = 0; rep < it.second.size(); ++rep) {
+        Value writeOffset = getSmemOffset(it.second[rep].front(), rep, warpAxis);
+        for (unsigned k = 0; k < smemBases.size(); ++k) {
+          Value writePtr = gep(elemPtrTys[k], smemBases[k], writeOffset);
+          storeShared(rewriter, loc, writePtr, laneScans[it.first][rep][k],
+                      isLastLane);
+        }
+      }
+    }
+
+    barrier();
+
+    Value zero = i32_val(0);
+    Value hasCarry = icmp_ne(warpRank, zero);
+    for (auto &it : chunks) {
+      for (unsigned rep = 0; rep < it.second.size(); ++rep) {
+        const SmallVector<unsigned> &chunk = it.second[rep];
+        // Scan the totals of the warps in scan order, and pick the one of the
+        // preceding warp
+        SmallVector<Value> scan;
+        SmallVector<Value> carry;
+        for (unsigned w = 0; w < sizeInterWarps; ++w) {
+          unsigned warp = reverse ? sizeInterWarps - 1 - w : w;
+          Value readOffset = getSmemOffset(chunk.front(), rep, i32_val(warp));
+          SmallVector<Value> total;
+          for (unsigned k = 0; k < smemBases.size(); ++k)
+            total.push_back(load(gep(elemPtrTys[k], smemBases[k], readOffset)));
+          scan = scan.empty() ? total : combine(op, rewriter, scan, total);
+          if (w == 0)
+            carry = scan;
+          else if (w + 1 < sizeInterWarps)
+            carry = selectValues(loc, rewriter,
+                                 icmp_eq(warpRank, i32_val(w + 1)), scan,
+                                 carry);
+        }
+        for (unsigned i : chunk)
+          values[i] =
+              selectValues(loc, rewriter, hasCarry,
+                           combine(op, rewriter, carry, values[i]), values[i]);
+        repTotals[it.first].push_back(scan);
+      }
+    }
+  }
+
+  // Reads the values of the lane `laneDelta` lane ids before in scan order
+  SmallVector<Value> shuffleUp(Location loc,
+                               ConversionPatternRewriter &rewriter,
+                               ArrayRef<Value> vals, Value laneId,
+                               unsigned laneDelta, bool reverse) const {
+    Value srcLane = reverse ? add(laneId, i32_val(laneDelta))
+                            : sub(laneId, i32_val(laneDelta));
+    SmallVector<Value> shuffled;
+    for (Value val : vals)
+      shuffled.push_back(shflIdxSync(loc, rewriter, val, srcLane));
+    return shuffled;
+  }
+
+  SmallVector<Value> selectValues(Location loc,
+                                  ConversionPatternRewriter &rewriter,
+                                  Value pred, ArrayRef<Value> trueVals,
+                                  ArrayRef<Value> falseVals) const {
+    SmallVector<Value> selected;
+    for (unsigned k = 0; k < trueVals.size(); ++k)
+      selected.push_back(select(pred, trueVals[k], falseVals[k]));
+    return selected;
+  }
+
+  // Inlines a copy of the combine function
+  SmallVector<Value> combine(triton::ScanOp op,
+                             ConversionPatternRewriter &rewriter,
+                             ArrayRef<Value> acc, ArrayRef<Value> cur) const {
+    Block &combineBlock = op.combineOp().front();
+    BlockAndValueMapping mapping;
+    for (unsigned k = 0; k < acc.size(); ++k) {
+      mapping.map(combineBlock.getArgument(k), acc[k]);
+      mapping.map(combineBlock.getArgument(acc.size() + k), cur[k]);
+    }
+    for (Operation &combineOp : combineBlock.without_terminator())
+      rewriter.clone(combineOp, mapping);
+    auto terminator =
+        cast<triton::ScanReturnOp>(combineBlock.getTerminator());
+    SmallVector<Value> results;
+    for (Value result : terminator.result())
+      results.push_back(mapping.lookupOrDefault(result));
+    return results;
+  }
+};
+
+void populateScanOpToLLVMPatterns(
+    mlir::LLVMTypeConverter &typeConverter, RewritePatternSet &patterns,
+    int numWarps, AxisInfoAnalysis &axisInfoAnalysis,
+    const Allocation *allocation, Value smem,
+    ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo &indexCacheInfo,
+    PatternBenefit benefit) {
+  patterns.add<ScanOpConversion>(typeConverter, allocation, smem,
+                                 indexCacheInfo, benefit);
+}
@@ -0,0 +1,288 @@
+#include "SortOpToLLVM.h"
+
+using namespace mlir;
+using namespace mlir::triton;
+
+using ::mlir::LLVM::getElementsFromStruct;
+using ::mlir::LLVM::getStructFromElements;
+using ::mlir::LLVM::shflIdxSync;
+using ::mlir::LLVM::storeShared;
+using ::mlir::triton::gpu::getOrder;
+using ::mlir::triton::gpu::getSizePerThread;
+
+// Sorts with a bitonic network. The bits of the position of an element along
+// the axis are split, from the lowest to the highest ones, between the
+// elements of a thread, the lanes of a warp, the warps and the repetitions of
+// the layout, so that each compare-and-swap stage pairs the elements of a
+// thread, of two lanes through a butterfly shuffle, or of two warps through
+// shared memory. A top-k then gathers the first elements along the axis into
+// the layout of its result through shared memory.
+struct SortOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::SortOp> {
+public:
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::SortOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::SortOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    ReduceOpHelper helper(op);
+    auto srcLayout = helper.getSrcLayout();
+    if (!srcLayout.isa<triton::gpu::BlockedEncodingAttr>())
+      return op.emitError("unsupported layout for tt.sort");
+
+    Location loc = op->getLoc();
+    unsigned axis = op.axis();
+    bool descending = op.descending();
+    auto srcShape = helper.getSrcShape();
+    unsigned axisSize = srcShape[axis];
+    unsigned sizePerThread = getSizePerThread(srcLayout)[axis];
+    if (sizePerThread > axisSize)
+      return op.emitError("tt.sort needs its axis to cover the layout");
+
+    // values[i] holds element i of every operand
+    SmallVector<SmallVector<Value>> values;
+    for (Value operand : adaptor.operands()) {
+      auto elems = getElementsFromStruct(loc, operand, rewriter);
+      values.resize(elems.size());
+      for (unsigned i = 0; i < elems.size(); ++i)
+        values[i].push_back(elems[i]);
+    }
+
+    // Index of the element of the thread at each position along the axis,
+    // for each position across it
+    SmallVector<SmallVector<unsigned>> offset =
+        emitOffsetForLayout(srcLayout, srcShape);
+    std::map<SmallVector<unsigned>, std::map<unsigned, unsigned>> elemAt;
+    for (unsigned i = 0; i < values.size(); ++i) {
+      SmallVector<unsigned> key = offset[i];
+      key[axis] = 0;
+      elemAt[key][offset[i][axis]] = i;
+    }
+
+    Value threadId = getThreadId(rewriter, loc);
+    Value warpSize = i32_val(helper.getWarpSize());
+    Value warpId = udiv(threadId, warpSize);
+    Value laneId = urem(threadId, warpSize);
+    SmallVector<Value> multiDimLaneId =
+        delinearize(rewriter, loc, laneId, helper.getThreadsPerWarp(),
+                    helper.getLaneOrder());
+    SmallVector<Value> multiDimWarpId =
+        delinearize(rewriter, loc, warpId, helper.getWarpsPerCTA(),
+                    helper.getWarpOrder());
+
+    // Lanes (resp. warps) beyond the extent of the axis hold copies
+    unsigned sizeIntraWarps = helper.getIntraWarpSize();
+    unsigned sizeInterWarps = helper.getInterWarpSize();
+    unsigned laneStride = helper.getIntraWarpStride();
+    Value laneAxis = urem(multiDimLaneId[axis], i32_val(sizeIntraWarps));
+    Value warpAxis = urem(multiDimWarpId[axis], i32_val(sizeInterWarps));
+    unsigned laneBits = sizePerThread;
+    unsigned warpBits = laneBits * sizeIntraWarps;
+    unsigned repBits = warpBits * sizeInterWarps;
+
+    // Whether `bit` is set in the position of element i along the axis
+    auto isBitSet = [&](unsigned i, unsigned bit) -> Value {
+      if (bit < laneBits || bit >= repBits)
+        return int_val(1, (offset[i][axis] & bit) != 0);
+      if (bit < warpBits)
+        return icmp_ne(and_(laneAxis, i32_val(bit / laneBits)), i32_val(0));
+      return icmp_ne(and_(warpAxis, i32_val(bit / warpBits)), i32_val(0));
+    };
+
+    Type keyTy = op.operands()
+                     .front()
+                     .getType()
+                     .cast<RankedTensorType>()
+                     .getElementType();
+    auto srcIndices = emitIndices(loc, rewriter, srcLayout, srcShape);
+    for (unsigned k = 2; k <= axisSize; k <<= 1) {
+      for (unsigned j = k / 2; j > 0; j >>= 1) {
+        // partners[i] holds the element whose position differs from the one
+        // of element i by j
+        SmallVector<SmallVector<Value>> partners;
+        if (j < laneBits || j >= repBits) {
+          for (unsigned i = 0; i < values.size(); ++i) {
+            SmallVector<unsigned> key = offset[i];
+            key[axis] = 0;
+            partners.push_back(values[elemAt[key][offset[i][axis] ^ j]]);
+          }
+        } else if (j < warpBits) {
+          Value srcLane = xor_(laneId, i32_val(j / laneBits * laneStride));
+          for (const SmallVector<Value> &elemVals : values) {
+            SmallVector<Value> shuffled;
+            for (Value val : elemVals)
+              shuffled.push_back(shflIdxSync(loc, rewriter, val, srcLane));
+            partners.push_back(shuffled);
+          }
+        } else {
+          partners = exchangeAcrossWarps(op, helper, rewriter, srcIndices,
+                                         values, j);
+        }
+
+        // Element i keeps the smaller of the pair if it is the lower one of
+        // an ascending sequence, or the upper one of a descending sequence
+        SmallVector<SmallVector<Value>> sorted;
+        for (unsigned i = 0; i < values.size(); ++i) {
+          Value isAscending = xor_(isBitSet(i, k), int_val(1, descending));
+          Value keepMin = icmp_eq(isBitSet(i, j), isAscending);
+          Value swap = select(
+              keepMin, lessThan(loc, rewriter, keyTy, partners[i][0],
+                                values[i][0]),
+              lessThan(loc, rewriter, keyTy, values[i][0], partners[i][0]));
+          SmallVector<Value> elemVals;
+          for (unsigned o = 0; o < values[i].size(); ++o)
+            elemVals.push_back(select(swap, partners[i][o], values[i][o]));
+          sorted.push_back(elemVals);
+        }
+        values = std::move(sorted);
+      }
+    }
+
+    SmallVector<SmallVector<Value>> resultVals = values;
+    if (op.k() && *op.k() < axisSize)
+      resultVals = gatherTopK(op, helper, rewriter, srcIndices, values);
+
+    SmallVector<Value> results;
+    for (unsigned o = 0; o < op.getNumResults(); ++o) {
+      SmallVector<Value> elems;
+      for (const SmallVector<Value> &elemVals : resultVals)
+        elems.push_back(elemVals[o]);
+      Type structTy =
+          getTypeConverter()->convertType(op.getResult(o).getType());
+      results.push_back(getStructFromElements(loc, elems, rewriter, structTy));
+    }
+    rewriter.replaceOp(op, results);
+    return success();
+  }
+
+private:
+  // Pointers to the region of the buffer of each operand, holding `elems`
+  // elements each
+  SmallVector<Value> getSmemBases(triton::SortOp op,
+                                  ConversionPatternRewriter &rewriter,
+                                  unsigned elems) const {
+    Location loc = op->getLoc();
+    Value smemBase = getSharedMemoryBase(loc, rewriter, op.getOperation());
+    SmallVector<Value> smemBases;
+    for (unsigned o = 0; o < op.getNumOperands(); ++o) {
+      auto operandTy = op.getOperand(o).getType().cast<RankedTensorType>();
+      Type elemTy = getTypeConverter()->convertType(operandTy.getElementType());
+      Type elemPtrTy = LLVM::LLVMPointerType::get(elemTy, 3);
+      if (o > 0)
+        smemBase = gep(smemBases[o - 1].getType(), smemBases[o - 1],
+                       i32_val(elems));
+      smemBases.push_back(bitcast(smemBase, elemPtrTy));
+    }
+    return smemBases;
+  }
+
+  // Reads the elements whose positions along the axis differ by j, held by
+  // other warps, through shared memory
+  SmallVector<SmallVector<Value>>
+  exchangeAcrossWarps(triton::SortOp op, ReduceOpHelper &helper,
+                      ConversionPatternRewriter &rewriter,
+                      ArrayRef<SmallVector<Value>> srcIndices,
+                      ArrayRef<SmallVector<Value>> values, unsigned j) const {
+    Location loc = op->getLoc();
+    unsigned axis = op.axis();
+    auto smemShape = helper.getSortScratchConfig();
+    auto smemOrder = getOrder(helper.getSrcLayout());
+    SmallVector<Value> smemBases =
+        getSmemBases(op, rewriter, product<unsigned>(smemShape));
+
+    // The buffer may still be read by the previous stage
+    barrier();
+    for (unsigned i = 0; i < values.size(); ++i) {
+      Value offset =
+          linearize(rewriter, loc, srcIndices[i], smemShape, smemOrder);
+      for (unsigned o = 0; o < smemBases.size(); ++o)
+        store(values[i][o], gep(smemBases[o].getType(), smemBases[o], offset));
+    }
+    barrier();
+
+    SmallVector<SmallVector<Value>> partners;
+    for (unsigned i = 0; i < values.size(); ++i) {
+      SmallVector<Value> idx = srcIndices[i];
+      idx[axis] = xor_(idx[axis], i32_val(j));
+      Value offset = linearize(rewriter, loc, idx, smemShape, smemOrder);
+      SmallVector<Value> elemVals;
+      for (unsigned o = 0; o < smemBases.size(); ++o)
+        elemVals.push_back(
+            load(gep(smemBases[o].getType(), smemBases[o], offset)));
+      partners.push_back(elemVals);
+    }
+    return partners;
+  }
+
+  // Returns the elements of the result, the first k ones along the axis, in
+  // its layout
+  SmallVector<SmallVector<Value>>
+  gatherTopK(triton::SortOp op, ReduceOpHelper &helper,
+             ConversionPatternRewriter &rewriter,
+             ArrayRef<SmallVector<Value>> srcIndices,
+             ArrayRef<SmallVector<Value>> values) const {
+    Location loc = op->getLoc();
+    unsigned axis = op.axis();
+    auto resultTy = op.getResult(0).getType().cast<RankedTensorType>();
+    auto smemShape = convertType<unsigned>(resultTy.getShape());
+    auto smemOrder = getOrder(helper.getSrcLayout());
+    SmallVector<Value> smemBases =
+        getSmemBases(op, rewriter, product<unsigned>(smemShape));
+
+    barrier();
+    Value k = i32_val(*op.k());
+    for (unsigned i = 0; i < values.size(); ++i) {
+      Value offset =
+          linearize(rewriter, loc, srcIndices[i], smemShape, smemOrder);
+      Value isKept = icmp_ult(srcIndices[i][axis], k);
+      for (unsigned o = 0; o < smemBases.size(); ++o) {
+        Value ptr = gep(smemBases[o].getType(), smemBases[o], offset);
+        storeShared(rewriter, loc, ptr, values[i][o], isKept);
+      }
+    }
+    barrier();
+
+    auto dstIndices = emitIndices(loc, rewriter, resultTy.getEncoding(),
+                                  resultTy.getShape());
+    SmallVector<SmallVector<Value>> resultVals;
+    for (const SmallVector<Value> &idx : dstIndices) {
+      Value offset = linearize(rewriter, loc, idx, smemShape, smemOrder);
+      SmallVector<Value> elemVals;
+      for (unsigned o = 0; o < smemBases.size(); ++o)
+        elemVals.push_back(
+            load(gep(smemBases[o].getType(), smemBases[o], offset)));
+      resultVals.push_back(elemVals);
+    }
+    return resultVals;
+  }
+
+  // Signed comparison of integers, ordered comparison of floats. Floats
+  // stored as integers (bf16, fp8) are sign-magnitude: flipping the magnitude
+  // of the negative ones makes them compare as signed integers.
+  Value lessThan(Location loc, ConversionPatternRewriter &rewriter,
+                 Type keyTy, Value lhs, Value rhs) const {
+    if (lhs.getType().isa<FloatType>())
+      return fcmp_olt(lhs, rhs);
+    if (keyTy.isa<FloatType>()) {
+      unsigned width = lhs.getType().getIntOrFloatBitWidth();
+      auto toSigned = [&](Value val) -> Value {
+        Value sign = ashr(val, int_val(width, width - 1));
+        return xor_(val, lshr(sign, int_val(width, 1)));
+      };
+      lhs = toSigned(lhs);
+      rhs = toSigned(rhs);
+    }
+    return icmp_slt(lhs, rhs);
+  }
+};
+
+void populateSortOpToLLVMPatterns(
+    mlir::LLVMTypeConverter &typeConverter, RewritePatternSet &patterns,
+    int numWarps, AxisInfoAnalysis &axisInfoAnalysis,
+    const Allocation *allocation, Value smem,
+    ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo &indexCacheInfo,
+    PatternBenefit benefit) {
+  patterns.add<SortOpConversion>(typeConverter, allocation, smem,
+                                 indexCacheInfo, benefit);
+}
@@ -5,9 +5,13 @@
 using namespace mlir;
 using namespace mlir::triton;
 
+using ::mlir::LLVM::copyClusterShared;
+using ::mlir::LLVM::getClusterCTARank;
 using ::mlir::LLVM::getElementsFromStruct;
 using ::mlir::LLVM::getSharedMemoryObjectFromStruct;
 using ::mlir::LLVM::getStructFromElements;
+using ::mlir::LLVM::mapClusterShared;
+using ::mlir::LLVM::warpBarrier;
 using ::mlir::triton::gpu::getElemsPerThread;
 using ::mlir::triton::gpu::SharedEncodingAttr;
 
@@ -391,6 +395,349 @@ struct GetNumProgramsOpConversion
                                                   mlir::gpu::Dimension::z};
 };
 
+// The programs of a cooperative launch are all resident, and synchronize on
+// a counter in global memory: the first thread of the first program adds
+// 2^31 - (n - 1) to it and those of the n - 1 others add 1, so that bit 31
+// flips once all have arrived and the low bits are back to their previous
+// value, ready for the next barrier.
+struct GridBarrierOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::GridBarrierOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::GridBarrierOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::GridBarrierOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto moduleOp = op->getParentOfType<ModuleOp>();
+    StringRef counterName = "grid_barrier_counter";
+    auto counter = moduleOp.lookupSymbol<LLVM::GlobalOp>(counterName);
+    if (!counter) {
+      ConversionPatternRewriter::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(moduleOp.getBody());
+      counter = rewriter.create<LLVM::GlobalOp>(
+          loc, i32_ty, /*isConstant=*/false, LLVM::Linkage::Internal,
+          counterName, rewriter.getI32IntegerAttr(0), /*alignment=*/4,
+          /*addrSpace=*/1);
+    }
+#ifdef USE_ROCM
+    StringRef syncScope = "agent";
+#else
+    StringRef syncScope = "";
+#endif
+
+    auto toI32 = [&](Value v) {
+      return rewriter
+          .create<UnrealizedConversionCastOp>(
+              loc, TypeRange{getTypeConverter()->getIndexType()},
+              ValueRange{v})
+          .getResult(0);
+    };
+    Value isFirst = int_val(1, 1);
+    Value numPrograms = i32_val(1);
+    for (auto dim : {mlir::gpu::Dimension::x, mlir::gpu::Dimension::y,
+                     mlir::gpu::Dimension::z}) {
+      Value blockId = toI32(rewriter.create<::mlir::gpu::BlockIdOp>(
+          loc, rewriter.getIndexType(), dim));
+      Value gridDim = toI32(rewriter.create<::mlir::gpu::GridDimOp>(
+          loc, rewriter.getIndexType(), dim));
+      isFirst = and_(isFirst, icmp_eq(blockId, i32_val(0)));
+      numPrograms = mul(numPrograms, gridDim);
+    }
+    Value arrival =
+        select(isFirst, sub(i32_val(0x80000001), numPrograms), i32_val(1));
+    Value counterPtr = address_of(counter);
+
+    barrier();
+    auto *curBlock = rewriter.getInsertionBlock();
+    auto *endBlock = curBlock->splitBlock(rewriter.getInsertionPoint());
+    auto *arriveBlock = rewriter.createBlock(endBlock);
+    auto *waitBlock = rewriter.createBlock(endBlock);
+
+    rewriter.setInsertionPointToEnd(curBlock);
+    rewriter.create<LLVM::CondBrOp>(loc, icmp_eq(tid_val(), i32_val(0)),
+                                    arriveBlock, endBlock);
+
+    // Release the writes of the program before arriving
+    rewriter.setInsertionPointToEnd(arriveBlock);
+    rewriter.create<LLVM::FenceOp>(loc, LLVM::AtomicOrdering::release,
+                                   syncScope);
+    Value old = rewriter.create<LLVM::AtomicRMWOp>(
+        loc, i32_ty, LLVM::AtomicBinOp::add, counterPtr, arrival,
+        LLVM::AtomicOrdering::monotonic);
+    rewriter.create<LLVM::BrOp>(loc, ValueRange{}, waitBlock);
+
+    rewriter.setInsertionPointToEnd(waitBlock);
+    Value current = rewriter.create<LLVM::LoadOp>(
+        loc, counterPtr, /*alignment=*/4, /*isVolatile=*/true);
+    Value flipped = icmp_ne(and_(xor_(old, current), i32_val(0x80000000)),
+                            i32_val(0));
+    rewriter.create<LLVM::CondBrOp>(loc, flipped, endBlock, waitBlock);
+
+    // Acquire those of the other programs
+    rewriter.setInsertionPointToStart(endBlock);
+    rewriter.create<LLVM::FenceOp>(loc, LLVM::AtomicOrdering::acquire,
+                                   syncScope);
+    barrier();
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+// The id of the program in the launch grid, x-major, as an i32 (`indexTy`)
+static Value getLinearProgramId(Location loc,
+                                ConversionPatternRewriter &rewriter,
+                                Type indexTy) {
+  auto toI32 = [&](Value v) {
+    return rewriter
+        .create<UnrealizedConversionCastOp>(loc, TypeRange{indexTy},
+                                            ValueRange{v})
+        .getResult(0);
+  };
+  Value programId = i32_val(0);
+  Value stride = i32_val(1);
+  for (auto dim : {mlir::gpu::Dimension::x, mlir::gpu::Dimension::y,
+                   mlir::gpu::Dimension::z}) {
+    Value blockId = toI32(rewriter.create<::mlir::gpu::BlockIdOp>(
+        loc, rewriter.getIndexType(), dim));
+    Value gridDim = toI32(rewriter.create<::mlir::gpu::GridDimOp>(
+        loc, rewriter.getIndexType(), dim));
+    programId = add(programId, mul(blockId, stride));
+    stride = mul(stride, gridDim);
+  }
+  return programId;
+}
+
+// The first thread of each program accumulates the cycles spent in each
+// region in the buffer whose address the launcher stores in
+// triton_profile_buffer. Each program has a row of numRegions + 2 counters:
+// the time of its last boundary, its current region, then the cycles of each
+// region. The boundaries are numbered by the conversion pass: 0 at the entry
+// of the kernel, -1 before its returns, and 1 + the index of the name of the
+// region they enter otherwise.
+struct ProfileRegionOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::ProfileRegionOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::ProfileRegionOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::ProfileRegionOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto moduleOp = op->getParentOfType<ModuleOp>();
+    auto regionAttr = op->getAttrOfType<IntegerAttr>("triton_gpu.region");
+    auto numRegionsAttr =
+        moduleOp->getAttrOfType<IntegerAttr>("triton_gpu.profile-regions");
+    if (!regionAttr || !numRegionsAttr)
+      return rewriter.notifyMatchFailure(op, "profile regions not numbered");
+    int region = regionAttr.getInt();
+    int rowSize = numRegionsAttr.getInt() + 2;
+
+    StringRef bufferName = "triton_profile_buffer";
+    auto buffer = moduleOp.lookupSymbol<LLVM::GlobalOp>(bufferName);
+    if (!buffer) {
+      ConversionPatternRewriter::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(moduleOp.getBody());
+      buffer = rewriter.create<LLVM::GlobalOp>(
+          loc, i64_ty, /*isConstant=*/false, LLVM::Linkage::External,
+          bufferName, rewriter.getI64IntegerAttr(0), /*alignment=*/8,
+          /*addrSpace=*/1);
+    }
+
+    auto toI32 = [&](Value v) {
+      return rewriter
+          .create<UnrealizedConversionCastOp>(
+              loc, TypeRange{getTypeConverter()->getIndexType()},
+              ValueRange{v})
+          .getResult(0);
+    };
+    Value programId = getLinearProgramId(loc, rewriter,
+                                         getTypeConverter()->getIndexType());
+    // Thread 0 of the first warp group, in warp-specialized kernels too
+    Value threadId = toI32(rewriter.create<::mlir::gpu::ThreadIdOp>(
+        loc, rewriter.getIndexType(), mlir::gpu::Dimension::x));
+
+    auto *curBlock = rewriter.getInsertionBlock();
+    auto *endBlock = curBlock->splitBlock(rewriter.getInsertionPoint());
+    auto *recordBlock = rewriter.createBlock(endBlock);
+    rewriter.setInsertionPointToEnd(curBlock);
+    rewriter.create<LLVM::CondBrOp>(loc, icmp_eq(threadId, i32_val(0)),
+                                    recordBlock, endBlock);
+
+    rewriter.setInsertionPointToEnd(recordBlock);
+    auto ptrTy = ptr_ty(i64_ty, 1);
+    Value base = inttoptr(ptrTy, load(address_of(buffer)));
+    Value row = gep(ptrTy, base, mul(programId, i32_val(rowSize)));
+    Value lastPtr = gep(ptrTy, row, i32_val(0));
+    Value currentPtr = gep(ptrTy, row, i32_val(1));
+#ifdef USE_ROCM
+    StringRef clockAsm = "s_memtime $0\n\ts_waitcnt lgkmcnt(0)";
+    StringRef clockConstraints = "=s";
+#else
+    StringRef clockAsm = "mov.u64 $0, %clock64;";
+    StringRef clockConstraints = "=l";
+#endif
+    Value now =
+        rewriter
+            .create<LLVM::InlineAsmOp>(
+                loc, i64_ty, ValueRange{}, clockAsm, clockConstraints,
+                /*has_side_effects=*/true, /*is_align_stack=*/false,
+                LLVM::AsmDialectAttr::get(getContext(),
+                                          LLVM::AsmDialect::AD_ATT),
+                ArrayAttr::get(getContext(), {}))
+            .getResult(0);
+    if (region != 0) {
+      Value current = load(currentPtr);
+      Value cyclesPtr = gep(ptrTy, gep(ptrTy, row, i32_val(2)), current);
+      store(add(load(cyclesPtr), sub(now, load(lastPtr))), cyclesPtr);
+    }
+    if (region >= 0) {
+      store(now, lastPtr);
+      store(rewriter.create<LLVM::ConstantOp>(
+                loc, i64_ty, rewriter.getI64IntegerAttr(region)),
+            currentPtr);
+    }
+    rewriter.create<LLVM::BrOp>(loc, ValueRange{}, endBlock);
+
+    rewriter.setInsertionPointToStart(endBlock);
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+// Writes the record of a trace call (see getTraceRecordWords) into a slot of
+// the ring buffer whose address the launcher stores in triton_trace_buffer.
+// The buffer starts with the number of records written and the number of its
+// slots, the slots starting at word 4. Every thread writes its elements of the
+// tensor arguments, and the first thread of each program the scalar ones when
+// there are no tensor arguments.
+struct TraceOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::TraceOp> {
+
+  TraceOpConversion(
+      LLVMTypeConverter &converter,
+      ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo &indexCacheInfo,
+      PatternBenefit benefit)
+      : ConvertTritonGPUOpToLLVMPattern<triton::TraceOp>(
+            converter, /*Allocation*/ nullptr, Value{}, indexCacheInfo,
+            benefit) {}
+
+  LogicalResult
+  matchAndRewrite(triton::TraceOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto moduleOp = op->getParentOfType<ModuleOp>();
+    auto formatAttr =
+        op->getAttrOfType<IntegerAttr>("triton_gpu.trace-format");
+    auto slotWordsAttr =
+        moduleOp->getAttrOfType<IntegerAttr>("triton_gpu.trace-slot-words");
+    if (!formatAttr || !slotWordsAttr)
+      return rewriter.notifyMatchFailure(op, "trace formats not numbered");
+    bool hasTensor = false;
+    for (Value arg : op.args()) {
+      auto tensorTy = arg.getType().dyn_cast<RankedTensorType>();
+      if (!tensorTy)
+        continue;
+      if (!tensorTy.getEncoding()
+               .isa<BlockedEncodingAttr, MmaEncodingAttr, MfmaEncodingAttr,
+                    SliceEncodingAttr>())
+        return rewriter.notifyMatchFailure(op, "unsupported layout");
+      hasTensor = true;
+    }
+
+    // The thread ids of all the warp groups, in warp-specialized kernels
+    Type indexTy = getTypeConverter()->getIndexType();
+    Value threadIdx = rewriter.create<::mlir::gpu::ThreadIdOp>(
+        loc, rewriter.getIndexType(), mlir::gpu::Dimension::x);
+    Value threadId =
+        rewriter
+            .create<UnrealizedConversionCastOp>(loc, TypeRange{indexTy},
+                                                ValueRange{threadIdx})
+            .getResult(0);
+    SmallVector<Value> words{i32_val(formatAttr.getInt() + 1),
+                             getLinearProgramId(loc, rewriter, indexTy),
+                             threadId};
+    for (auto it : llvm::zip(op.args(), adaptor.args())) {
+      auto tensorTy = std::get<0>(it).getType().dyn_cast<RankedTensorType>();
+      if (!tensorTy) {
+        appendWords(loc, rewriter, std::get<1>(it), words);
+        continue;
+      }
+      auto shape = tensorTy.getShape();
+      auto vals = getElementsFromStruct(loc, std::get<1>(it), rewriter);
+      auto indices = emitIndices(loc, rewriter, tensorTy.getEncoding(), shape);
+      if (indices.size() != vals.size())
+        return rewriter.notifyMatchFailure(op, "unsupported layout");
+      for (unsigned i = 0; i < vals.size(); ++i) {
+        Value linear = i32_val(0);
+        for (unsigned d = 0; d < shape.size(); ++d)
+          linear = add(mul(linear, i32_val(shape[d])), indices[i][d]);
+        words.push_back(linear);
+        appendWords(loc, rewriter, vals[i], words);
+      }
+    }
+
+    StringRef bufferName = "triton_trace_buffer";
+    auto buffer = moduleOp.lookupSymbol<LLVM::GlobalOp>(bufferName);
+    if (!buffer) {
+      ConversionPatternRewriter::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(moduleOp.getBody());
+      buffer = rewriter.create<LLVM::GlobalOp>(
+          loc, i64_ty, /*isConstant=*/false, LLVM::Linkage::External,
+          bufferName, rewriter.getI64IntegerAttr(0), /*alignment=*/8,
+          /*addrSpace=*/1);
+    }
+
+    Block *endBlock = nullptr;
+    if (!hasTensor) {
+      auto *curBlock = rewriter.getInsertionBlock();
+      endBlock = curBlock->splitBlock(rewriter.getInsertionPoint());
+      auto *recordBlock = rewriter.createBlock(endBlock);
+      rewriter.setInsertionPointToEnd(curBlock);
+      rewriter.create<LLVM::CondBrOp>(loc, icmp_eq(threadId, i32_val(0)),
+                                      recordBlock, endBlock);
+      rewriter.setInsertionPointToEnd(recordBlock);
+    }
+    auto ptrTy = ptr_ty(i32_ty, 1);
+    Value base = inttoptr(ptrTy, load(address_of(buffer)));
+    Value count = rewriter.create<LLVM::AtomicRMWOp>(
+        loc, i32_ty, LLVM::AtomicBinOp::add, base, i32_val(1),
+        LLVM::AtomicOrdering::monotonic);
+    Value slot = urem(count, load(gep(ptrTy, base, i32_val(1))));
+    Value slotWords = i32_val(slotWordsAttr.getInt());
+    Value record = gep(ptrTy, base, add(i32_val(4), mul(slot, slotWords)));
+    for (auto it : llvm::enumerate(words))
+      store(it.value(), gep(ptrTy, record, i32_val(it.index())));
+    if (endBlock) {
+      rewriter.create<LLVM::BrOp>(loc, ValueRange{}, endBlock);
+      rewriter.setInsertionPointToStart(endBlock);
+    }
+    rewriter.eraseOp(op);
+    return success();
+  }
+
+  // Appends the words of `value`: the bits of floats, integers zero-extended,
+  // and values of 64 bits low word first
+  void appendWords(Location loc, ConversionPatternRewriter &rewriter,
+                   Value value, SmallVectorImpl<Value> &words) const {
+    Type type = value.getType();
+    if (type.isa<LLVM::LLVMPointerType>())
+      value = ptrtoint(i64_ty, value);
+    else if (!type.isa<IntegerType>())
+      value = bitcast(value, rewriter.getIntegerType(
+                                 type.getIntOrFloatBitWidth()));
+    unsigned bitwidth = value.getType().getIntOrFloatBitWidth();
+    if (bitwidth < 32)
+      value = zext(i32_ty, value);
+    if (bitwidth <= 32) {
+      words.push_back(value);
+      return;
+    }
+    words.push_back(trunc(i32_ty, value));
+    words.push_back(trunc(i32_ty, lshr(value, int_val(64, 32))));
+  }
+};
+
 struct AddPtrOpConversion
     : public ConvertTritonGPUOpToLLVMPattern<triton::AddPtrOp> {
   using ConvertTritonGPUOpToLLVMPattern<
@@ -442,14 +789,16 @@ struct AllocTensorOpConversion
     auto elemPtrTy = ptr_ty(llvmElemTy, 3);
     smemBase = bitcast(smemBase, elemPtrTy);
     auto order = resultTy.getEncoding().cast<SharedEncodingAttr>().getOrder();
-    // Workaround for 3D tensors
+    // Workaround for the buffers of the pipeline, whose leading dimension
+    // holds the stages
     // TODO: we need to modify the pipeline pass to give a proper shared
-    // encoding to 3D tensors
-    SmallVector<unsigned> newOrder;
-    if (resultTy.getShape().size() == 3)
-      newOrder = {1 + order[0], 1 + order[1], 0};
-    else
-      newOrder = SmallVector<unsigned>(order.begin(), order.end());
+    // encoding to these buffers
+    SmallVector<unsigned> newOrder(order.begin(), order.end());
+    if (resultTy.getRank() == order.size() + 1) {
+      for (unsigned &d : newOrder)
+        ++d;
+      newOrder.push_back(0);
+    }
 
     auto smemObj = SharedMemoryObject(smemBase, resultTy.getShape(), newOrder,
                                       loc, rewriter);
@@ -459,6 +808,22 @@ struct AllocTensorOpConversion
   }
 };
 
+struct ScratchOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::ScratchOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::ScratchOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::ScratchOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    Value smemBase = getSharedMemoryBase(loc, rewriter, op.getOperation());
+    auto ptrTy = getTypeConverter()->convertType(op.getType());
+    rewriter.replaceOp(op, bitcast(smemBase, ptrTy));
+    return success();
+  }
+};
+
 struct ExtractSliceOpConversion
     : public ConvertTritonGPUOpToLLVMPattern<tensor::ExtractSliceOp> {
   using ConvertTritonGPUOpToLLVMPattern<
@@ -556,6 +921,198 @@ struct AsyncCommitGroupOpConversion
   }
 };
 
+struct ClusterBarrierOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::gpu::ClusterBarrierOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::gpu::ClusterBarrierOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::gpu::ClusterBarrierOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // The arrive releases, and the wait acquires, the accesses of the threads
+    // to the shared memory of the cluster
+    PTXBuilder ptxBuilder;
+    ptxBuilder.create<>("barrier.cluster.arrive")->operator()();
+    ptxBuilder.create<>("barrier.cluster.wait")->operator()();
+    ptxBuilder.launch(rewriter, op.getLoc(), void_ty(op.getContext()));
+    // Safe to remove the op since it doesn't have any return value.
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+struct ClusterGatherOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::gpu::ClusterGatherOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::gpu::ClusterGatherOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::gpu::ClusterGatherOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // cluster_gather %src, %index
+    Location loc = op->getLoc();
+    auto srcTy = op.src().getType().cast<RankedTensorType>();
+    auto srcLayout = srcTy.getEncoding().cast<SharedEncodingAttr>();
+    unsigned clusterSize = srcLayout.getClusterSize();
+    auto mod = op->getParentOfType<ModuleOp>();
+    unsigned numThreads = triton::gpu::TritonGPUDialect::getNumWarps(mod) *
+                          triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+
+    // base of the slice %index along %axis
+    auto smemObj =
+        getSharedMemoryObjectFromStruct(loc, adaptor.src(), rewriter);
+    unsigned axis = op.axis();
+    SmallVector<Value, 4> offsetVals;
+    int64_t sliceElems = 1;
+    for (unsigned i = 0; i < srcTy.getRank(); ++i) {
+      offsetVals.emplace_back(i == axis ? adaptor.index() : i32_val(0));
+      if (i != axis)
+        sliceElems *= srcTy.getShape()[i];
+    }
+    auto llvmElemTy = getTypeConverter()->convertType(srcTy.getElementType());
+    Value sliceBase = gep(ptr_ty(llvmElemTy, 3), smemObj.base,
+                          dot(rewriter, loc, offsetVals, smemObj.strides));
+    sliceBase = bitcast(sliceBase, ptr_ty(i8_ty, 3));
+
+    // The rows of the slice are contiguous, swizzled in place: the part of
+    // every CTA is a contiguous range of the slice, copied in 16 bytes chunks
+    unsigned eltBytes =
+        std::max<unsigned>(srcTy.getElementTypeBitWidth() / 8, 1);
+    unsigned partBytes = sliceElems * eltBytes / clusterSize;
+    assert(partBytes % 16 == 0 && "cluster_gather: unaligned parts");
+    unsigned numChunks = partBytes / 16;
+    Value threadId = getThreadId(rewriter, loc);
+    Value rank = getClusterCTARank(loc, rewriter);
+    // the peers are visited from the next one, so that the CTAs of the
+    // cluster don't all read from the same one at once
+    for (unsigned k = 1; k < clusterSize; ++k) {
+      Value peer = urem(add(rank, i32_val(k)), i32_val(clusterSize));
+      Value partBase =
+          gep(ptr_ty(i8_ty, 3), sliceBase, mul(peer, i32_val(partBytes)));
+      Value clusterBase = mapClusterShared(loc, rewriter, partBase, peer);
+      for (unsigned first = 0; first < numChunks; first += numThreads) {
+        Value chunk = add(threadId, i32_val(first));
+        Value pred = int_val(1, 1);
+        if (first + numThreads > numChunks)
+          pred = icmp_ult(chunk, i32_val(numChunks));
+        Value offset = mul(chunk, i32_val(16));
+        Value ptr = gep(ptr_ty(i8_ty, 3), partBase, offset);
+        copyClusterShared(loc, rewriter, ptr, add(clusterBase, offset), pred);
+      }
+    }
+
+    rewriter.replaceOp(op, adaptor.src());
+    return success();
+  }
+};
+
+struct WarpBarrierOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::gpu::WarpBarrierOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::gpu::WarpBarrierOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::gpu::WarpBarrierOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    warpBarrier(op.getLoc(), rewriter);
+    // Safe to remove the op since it doesn't have any return value.
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+struct WarpGroupIdOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::gpu::WarpGroupIdOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::gpu::WarpGroupIdOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::gpu::WarpGroupIdOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto mod = op->getParentOfType<ModuleOp>();
+    int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+    // getThreadId() returns the thread id within the warp group
+    auto llvmIndexTy = getTypeConverter()->getIndexType();
+    auto cast = rewriter.create<UnrealizedConversionCastOp>(
+        loc, TypeRange{llvmIndexTy},
+        ValueRange{rewriter.create<::mlir::gpu::ThreadIdOp>(
+            loc, rewriter.getIndexType(), ::mlir::gpu::Dimension::x)});
+    Value threadId = cast.getResult(0);
+    int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+    rewriter.replaceOp(op, udiv(threadId, i32_val(threadsPerWarp * numWarps)));
+    return success();
+  }
+};
+
+template <typename SourceOp>
+struct NamedBarrierOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<SourceOp> {
+  using OpAdaptor = typename SourceOp::Adaptor;
+
+  NamedBarrierOpConversion(LLVMTypeConverter &converter, StringRef opcode,
+                           PatternBenefit benefit)
+      : ConvertTritonGPUOpToLLVMPattern<SourceOp>(converter, benefit),
+        opcode(opcode) {}
+
+  LogicalResult
+  matchAndRewrite(SourceOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+#ifdef USE_ROCM
+    // s_barrier always synchronizes the whole workgroup
+    return op->emitError("named barriers are not supported on AMD GPUs");
+#else
+    PTXBuilder ptxBuilder;
+    auto &barOp = *ptxBuilder.create<>(opcode);
+    barOp(ptxBuilder.newOperand(adaptor.bar(), "r"),
+          ptxBuilder.newConstantOperand(op.numThreads()));
+    ptxBuilder.launch(rewriter, op.getLoc(), void_ty(op.getContext()));
+    // Safe to remove the op since it doesn't have any return value.
+    rewriter.eraseOp(op);
+    return success();
+#endif
+  }
+
+private:
+  std::string opcode;
+};
+
+// Named barriers 14 and 15 synchronize the threads of warp groups 0 and 1
+// respectively in a warp-specialized module. Other modules use the default
+// gpu.barrier lowering.
+struct GPUBarrierOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<mlir::gpu::BarrierOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      mlir::gpu::BarrierOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(mlir::gpu::BarrierOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto mod = op->getParentOfType<ModuleOp>();
+    if (triton::gpu::TritonGPUDialect::getNumWarpGroups(mod) == 1)
+      return failure();
+#ifdef USE_ROCM
+    return op->emitError("warp specialization is not supported on AMD GPUs");
+#else
+    Location loc = op->getLoc();
+    int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+    Value threadId = rewriter.create<UnrealizedConversionCastOp>(
+        loc, TypeRange{getTypeConverter()->getIndexType()},
+        ValueRange{rewriter.create<::mlir::gpu::ThreadIdOp>(
+            loc, rewriter.getIndexType(), ::mlir::gpu::Dimension::x)})
+        .getResult(0);
+    Value bar = add(udiv(threadId, i32_val(32 * numWarps)), i32_val(14));
+    PTXBuilder ptxBuilder;
+    auto &barSync = *ptxBuilder.create<>("bar.sync");
+    barSync(ptxBuilder.newOperand(bar, "r"),
+            ptxBuilder.newConstantOperand(32 * numWarps));
+    ptxBuilder.launch(rewriter, loc, void_ty(op.getContext()));
+    rewriter.eraseOp(op);
+    return success();
+#endif
+  }
+};
+
 namespace mlir {
 namespace LLVM {
 
@@ -590,13 +1147,27 @@ void populateTritonGPUToLLVMPatterns(
                                         benefit);
   patterns.add<AsyncCommitGroupOpConversion>(typeConverter, benefit);
   patterns.add<AsyncWaitOpConversion>(typeConverter, benefit);
+  patterns.add<ClusterBarrierOpConversion>(typeConverter, benefit);
+  patterns.add<ClusterGatherOpConversion>(typeConverter, benefit);
+  patterns.add<WarpBarrierOpConversion>(typeConverter, benefit);
+  patterns.add<WarpGroupIdOpConversion>(typeConverter, benefit);
+  patterns.add<NamedBarrierOpConversion<triton::gpu::NamedBarrierArriveOp>>(
+      typeConverter, "bar.arrive", benefit);
+  patterns.add<NamedBarrierOpConversion<triton::gpu::NamedBarrierWaitOp>>(
+      typeConverter, "bar.sync", benefit);
+  patterns.add<GPUBarrierOpConversion>(typeConverter, benefit);
   patterns.add<BroadcastOpConversion>(typeConverter, benefit);
 
   patterns.add<ExtractSliceOpConversion>(typeConverter, allocation, smem,
                                          benefit);
   patterns.add<GetProgramIdOpConversion>(typeConverter, benefit);
   patterns.add<GetNumProgramsOpConversion>(typeConverter, benefit);
+  patterns.add<GridBarrierOpConversion>(typeConverter, benefit);
   patterns.add<MakeRangeOpConversion>(typeConverter, indexCacheInfo, benefit);
+  patterns.add<ProfileRegionOpConversion>(typeConverter, benefit);
   patterns.add<ReturnOpConversion>(typeConverter, benefit);
+  patterns.add<ScratchOpConversion>(typeConverter, allocation, smem,
+                                    benefit);
   patterns.add<PrintfOpConversion>(typeConverter, benefit);
+  patterns.add<TraceOpConversion>(typeConverter, indexCacheInfo, benefit);
 }
@@ -16,6 +16,7 @@ using namespace mlir::triton;
 
 using ::mlir::LLVM::SharedMemoryObject;
 using ::mlir::triton::gpu::BlockedEncodingAttr;
+using ::mlir::triton::gpu::MfmaEncodingAttr;
 using ::mlir::triton::gpu::MmaEncodingAttr;
 using ::mlir::triton::gpu::SliceEncodingAttr;
 
@@ -214,6 +215,13 @@ public:
             loc, rewriter.getIndexType(), ::mlir::gpu::Dimension::x)});
     Value threadId = cast.getResult(0);
 
+    // Each warp group of a warp-specialized module has its own thread ids
+    auto mod = rewriter.getBlock()->getParent()->getParentOfType<ModuleOp>();
+    if (triton::gpu::TritonGPUDialect::getNumWarpGroups(mod) > 1) {
+      int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+      int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+      threadId = urem(threadId, i32_val(threadsPerWarp * numWarps));
+    }
     return threadId;
   }
 
@@ -287,7 +295,7 @@ public:
     DenseMap<unsigned, Value> ret;
     // cache for non-immediate offsets
     DenseMap<unsigned, Value> cacheCol, cacheRow;
-    unsigned minVec = std::min(outVec, inVec);
+    unsigned minVec = triton::gpu::getSharedAccessVec(resSharedLayout, inVec);
     for (unsigned elemIdx = 0; elemIdx < numElems; elemIdx += minVec) {
       // extract multi dimensional index for current element
       auto idx = srcIndices[elemIdx];
@@ -335,6 +343,9 @@ public:
       Value colOff = add(colOffSwizzled, colOffOrdered);
       // compute non-immediate offset
       Value offset = add(rowOff, mul(colOff, strideCol));
+      // the leading dimensions of a batch of matrices are not swizzled
+      for (unsigned d : llvm::drop_begin(inOrder, 2))
+        offset = add(offset, mul(idx[d], srcStrides[d]));
       Value currPtr = gep(dstPtrTy, dstPtrBase, offset);
       // compute immediate offset
       Value immedateOff =
@@ -353,7 +364,7 @@ public:
                                 ConversionPatternRewriter &rewriter) const {
     auto srcTy = src.getType().cast<RankedTensorType>();
     auto srcShape = srcTy.getShape();
-    assert(srcShape.size() == 2 &&
+    assert((srcShape.size() == 2 || srcShape.size() == 3) &&
            "Unexpected rank of storeDistributedToShared");
     auto dstTy = dst.getType().cast<RankedTensorType>();
     auto srcDistributedLayout = srcTy.getEncoding();
@@ -371,7 +382,7 @@ public:
             ? triton::gpu::getContigPerThread(srcDistributedLayout)[inOrd[0]]
             : 1;
     unsigned outVec = dstSharedLayout.getVec();
-    unsigned minVec = std::min(outVec, inVec);
+    unsigned minVec = triton::gpu::getSharedAccessVec(dstSharedLayout, inVec);
     unsigned perPhase = dstSharedLayout.getPerPhase();
     unsigned maxPhase = dstSharedLayout.getMaxPhase();
     unsigned numElems = triton::gpu::getElemsPerThread(srcTy);
@@ -383,8 +394,8 @@ public:
     Value minVecVal = i32_val(minVec);
     Value word;
 
-    SmallVector<Value> srcStrides = {dstStrides[0], dstStrides[1]};
-    SmallVector<Value> offsetVals = {i32_val(0), i32_val(0)};
+    SmallVector<Value> srcStrides(dstStrides.begin(), dstStrides.end());
+    SmallVector<Value> offsetVals(srcShape.size(), i32_val(0));
     SharedMemoryObject smemObj(smemBase, srcStrides, offsetVals);
 
     DenseMap<unsigned, Value> sharedPtrs =
@@ -518,8 +529,10 @@ public:
       } else if (auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>()) {
         if (mmaLayout.isVolta())
           result = emitBaseIndexForMmaLayoutV1(loc, rewriter, mmaLayout, shape);
-        if (mmaLayout.isAmpere())
+        if (mmaLayout.isAmpere() || mmaLayout.isHopper())
           result = emitBaseIndexForMmaLayoutV2(loc, rewriter, mmaLayout, shape);
+      } else if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>()) {
+        result = emitBaseIndexForMfmaLayout(loc, rewriter, mfmaLayout, shape);
       } else {
         llvm_unreachable("unsupported emitBaseIndexForLayout");
       }
@@ -536,9 +549,13 @@ public:
     if (auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>()) {
       if (mmaLayout.isVolta())
         return emitOffsetForMmaLayoutV1(mmaLayout, shape);
-      if (mmaLayout.isAmpere())
+      if (mmaLayout.isAmpere() || mmaLayout.isHopper())
         return emitOffsetForMmaLayoutV2(mmaLayout, shape);
     }
+    if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>())
+      return emitOffsetForMfmaLayout(mfmaLayout, shape);
+    if (auto sliceLayout = layout.dyn_cast<SliceEncodingAttr>())
+      return emitOffsetForSliceLayout(sliceLayout, shape);
     llvm_unreachable("unsupported emitOffsetForLayout");
   }
 
@@ -563,6 +580,8 @@ public:
         result = emitIndicesForDistributedLayout(loc, b, blocked, shape);
       } else if (auto mma = layout.dyn_cast<MmaEncodingAttr>()) {
         result = emitIndicesForDistributedLayout(loc, b, mma, shape);
+      } else if (auto mfma = layout.dyn_cast<MfmaEncodingAttr>()) {
+        result = emitIndicesForDistributedLayout(loc, b, mfma, shape);
       } else if (auto slice = layout.dyn_cast<SliceEncodingAttr>()) {
         result = emitIndicesForSliceLayout(loc, b, slice, shape);
       } else {
@@ -599,11 +618,11 @@ private:
                                 const BlockedEncodingAttr &blocked_layout,
                                 ArrayRef<int64_t> shape) const {
     Value threadId = getThreadId(rewriter, loc);
-    Value warpSize = idx_val(32);
-    Value laneId = urem(threadId, warpSize);
-    Value warpId = udiv(threadId, warpSize);
     auto sizePerThread = blocked_layout.getSizePerThread();
     auto threadsPerWarp = blocked_layout.getThreadsPerWarp();
+    Value warpSize = idx_val(product<unsigned>(threadsPerWarp));
+    Value laneId = urem(threadId, warpSize);
+    Value warpId = udiv(threadId, warpSize);
     auto warpsPerCTA = blocked_layout.getWarpsPerCTA();
     auto order = blocked_layout.getOrder();
     unsigned rank = shape.size();
@@ -760,6 +779,57 @@ private:
     return ret;
   }
 
+  // -----------------------------------------------------------------------
+  // Mfma layout indices
+  // -----------------------------------------------------------------------
+
+  // A wavefront has 64 lanes: lane l owns column l % 32 and the rows
+  // {8 * i + 4 * (l / 32) + j | i, j in [0, 4)} of each 32x32 tile.
+  SmallVector<Value>
+  emitBaseIndexForMfmaLayout(Location loc, ConversionPatternRewriter &rewriter,
+                             const MfmaEncodingAttr &mfmaLayout,
+                             ArrayRef<int64_t> shape) const {
+    auto _warpsPerCTA = mfmaLayout.getWarpsPerCTA();
+    assert(_warpsPerCTA.size() == 2);
+    unsigned nonKDim = mfmaLayout.getNonKDim();
+    assert(nonKDim == 32 && "Only 32x32 mfma is supported");
+    SmallVector<Value> warpsPerCTA = {idx_val(_warpsPerCTA[0]),
+                                      idx_val(_warpsPerCTA[1])};
+    Value threadId = getThreadId(rewriter, loc);
+    Value waveSize = idx_val(64);
+    Value laneId = urem(threadId, waveSize);
+    Value waveId = udiv(threadId, waveSize);
+    Value waveId0 = urem(waveId, warpsPerCTA[0]);
+    Value waveId1 = urem(udiv(waveId, warpsPerCTA[0]), warpsPerCTA[1]);
+    // Wrap around the wavefront id in case the tensor is smaller than the
+    // tile covered by all wavefronts.
+    waveId0 = urem(waveId0, idx_val(std::max<int64_t>(shape[0] / nonKDim, 1)));
+    waveId1 = urem(waveId1, idx_val(std::max<int64_t>(shape[1] / nonKDim, 1)));
+    Value offWave0 = mul(waveId0, idx_val(nonKDim));
+    Value offWave1 = mul(waveId1, idx_val(nonKDim));
+
+    SmallVector<Value> multiDimBase(2);
+    multiDimBase[0] = add(mul(udiv(laneId, idx_val(32)), idx_val(4)), offWave0);
+    multiDimBase[1] = add(urem(laneId, idx_val(32)), offWave1);
+    return multiDimBase;
+  }
+
+  SmallVector<SmallVector<unsigned>>
+  emitOffsetForMfmaLayout(const MfmaEncodingAttr &mfmaLayout,
+                          ArrayRef<int64_t> shape) const {
+    SmallVector<SmallVector<unsigned>> ret;
+    auto shapePerCTA = getShapePerCTA(mfmaLayout);
+
+    for (unsigned i = 0; i < shape[0]; i += shapePerCTA[0]) {
+      for (unsigned j = 0; j < shape[1]; j += shapePerCTA[1]) {
+        for (unsigned k = 0; k < 4; ++k)
+          for (unsigned e = 0; e < 4; ++e)
+            ret.push_back({i + 8 * k + e, j});
+      }
+    }
+    return ret;
+  }
+
   // Emit indices calculation within each ConversionPattern, and returns a
   // [elemsPerThread X rank] index matrix.
 
@@ -790,6 +860,20 @@ private:
     return multiDimIdx;
   }
 
+  SmallVector<SmallVector<unsigned>>
+  emitOffsetForSliceLayout(const SliceEncodingAttr &sliceLayout,
+                           ArrayRef<int64_t> shape) const {
+    unsigned dim = sliceLayout.getDim();
+    auto parentOffsets = emitOffsetForLayout(sliceLayout.getParent(),
+                                             sliceLayout.paddedShape(shape));
+    SmallVector<SmallVector<unsigned>> resultOffsets;
+    for (SmallVector<unsigned> offsets : parentOffsets) {
+      offsets.erase(offsets.begin() + dim);
+      resultOffsets.push_back(offsets);
+    }
+    return resultOffsets;
+  }
+
   SmallVector<SmallVector<Value>>
   emitIndicesForSliceLayout(Location loc, ConversionPatternRewriter &rewriter,
                             const SliceEncodingAttr &sliceLayout,
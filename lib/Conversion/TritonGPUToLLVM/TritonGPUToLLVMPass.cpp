@@ -13,14 +13,18 @@
 #include "triton/Analysis/Allocation.h"
 #include "triton/Analysis/AxisInfo.h"
 #include "triton/Analysis/Membar.h"
+#include "triton/Analysis/Utility.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Tools/Sys/GetEnv.hpp"
 
 #include "ConvertLayoutOpToLLVM.h"
 #include "DotOpToLLVM.h"
 #include "ElementwiseOpToLLVM.h"
 #include "LoadStoreOpToLLVM.h"
 #include "ReduceOpToLLVM.h"
+#include "ScanOpToLLVM.h"
+#include "SortOpToLLVM.h"
 #include "TritonGPUToLLVM.h"
 #include "TypeConverter.h"
 #include "ViewOpToLLVM.h"
@@ -75,9 +79,9 @@ namespace {
 /// MemRef descriptors (LLVM struct data types) containing all the MemRef type
 /// information.
 struct FuncOpConversion : public FuncOpConversionBase {
-  FuncOpConversion(LLVMTypeConverter &converter, int numWarps,
+  FuncOpConversion(LLVMTypeConverter &converter, int numThreads,
                    PatternBenefit benefit)
-      : FuncOpConversionBase(converter, benefit), numWarps(numWarps) {}
+      : FuncOpConversionBase(converter, benefit), numThreads(numThreads) {}
 
   LogicalResult
   matchAndRewrite(FuncOp funcOp, OpAdaptor adaptor,
@@ -88,30 +92,66 @@ struct FuncOpConversion : public FuncOpConversionBase {
 
     auto ctx = funcOp->getContext();
 
+    // Pointer arguments aliasing no other argument, as asserted by the
+    // frontend, and those the kernel never writes through
+    for (unsigned i = 0; i < funcOp.getNumArguments(); ++i) {
+      if (funcOp.getArgAttr(i, "tt.noalias"))
+        newFuncOp.setArgAttr(i, LLVM::LLVMDialect::getNoAliasAttrName(),
+                             rewriter.getUnitAttr());
+      if (funcOp.getArgAttr(i, "tt.readonly"))
+        newFuncOp.setArgAttr(i, "llvm.readonly", rewriter.getUnitAttr());
+    }
+
     // Set an attribute to indicate this function is a kernel entry.
     newFuncOp->setAttr("nvvm.kernel",
                        rewriter.getIntegerAttr(type::u1Ty(ctx), 1));
-#ifndef USE_ROCM
     // Set an attribute for maxntidx, it could be used in latter LLVM codegen
-    // for `nvvm.annotation` metadata.
+    // for `nvvm.annotation` metadata, or the flat work group size of AMD GPUs.
     newFuncOp->setAttr("nvvm.maxntid",
-                       rewriter.getIntegerAttr(i32_ty, 32 * numWarps));
+                       rewriter.getIntegerAttr(i32_ty, numThreads));
+    // Launch bounds trading registers for occupancy: maxnreg caps the
+    // registers per thread, minctasm the programs per multiprocessor. AMD
+    // GPUs take the occupancy in waves per SIMD, 4 SIMDs sharing the programs
+    // of a compute unit.
+    auto mod = funcOp->getParentOfType<ModuleOp>();
+    int maxRegisters = triton::gpu::TritonGPUDialect::getMaxRegisters(mod);
+    int minBlocks = triton::gpu::TritonGPUDialect::getMinBlocksPerSM(mod);
+    int wavesPerEU = triton::gpu::TritonGPUDialect::getWavesPerEU(mod);
+#ifdef USE_ROCM
+    if (!wavesPerEU && minBlocks) {
+      int wavesPerBlock = ceil<int>(
+          numThreads, triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod));
+      wavesPerEU = ceil<int>(minBlocks * wavesPerBlock, 4);
+    }
 #endif
+    if (maxRegisters)
+      newFuncOp->setAttr("nvvm.maxnreg",
+                         rewriter.getIntegerAttr(i32_ty, maxRegisters));
+    if (minBlocks)
+      newFuncOp->setAttr("nvvm.minctasm",
+                         rewriter.getIntegerAttr(i32_ty, minBlocks));
+    if (wavesPerEU)
+      newFuncOp->setAttr("rocdl.waves_per_eu",
+                         rewriter.getIntegerAttr(i32_ty, wavesPerEU));
 
     rewriter.eraseOp(funcOp);
     return success();
   }
 
 private:
-  int numWarps{0};
+  int numThreads{0};
 };
 
 class ConvertTritonGPUToLLVM
     : public ConvertTritonGPUToLLVMBase<ConvertTritonGPUToLLVM> {
 
 public:
-  explicit ConvertTritonGPUToLLVM(int computeCapability)
-      : computeCapability(computeCapability) {}
+  explicit ConvertTritonGPUToLLVM(int computeCapability, bool fastMath,
+                                  int ptxVersion)
+      : computeCapability(computeCapability) {
+    this->fastMath = fastMath;
+    this->ptxVersion = ptxVersion;
+  }
 
   void runOnOperation() override {
     MLIRContext *context = &getContext();
@@ -140,18 +180,43 @@ public:
     // Conversion, thus we need to make sure the smem is not revised during the
     // conversion of step 7.
 
+    // Number the profiled regions, and time the kernel from its entry to its
+    // returns when it has any. Number the formats of the trace calls.
+    numberProfileRegions(mod);
+    numberTraceFormats(mod);
+
+    // The analyses of the module are reused from the previous passes when
+    // they are still valid. Step 1 only adds layout conversions of dot
+    // operands, which are never pointers of insert_slice_async ops.
+    AxisInfoAnalysis &ttgirAxisInfo = getAnalysis<CachedAxisInfoAnalysis>();
+
     // Step 1
-    decomposeMmaToDotOperand(mod, numWarps);
-    decomposeBlockedToDotOperand(mod);
+    bool changed = decomposeMmaToDotOperand(mod, numWarps);
+    changed |= decomposeBlockedToDotOperand(mod);
 
     // Step 2
-    decomposeInsertSliceAsyncOp(mod);
+    changed |= decomposeInsertSliceAsyncOp(mod, ttgirAxisInfo);
 
     // Step 3
-    Allocation allocation(mod);
+    Optional<Allocation> newAllocation;
+    if (changed)
+      newAllocation.emplace(mod);
+    Allocation &allocation =
+        changed ? *newAllocation : getAnalysis<Allocation>();
+    if (::triton::tools::getBoolEnv("SHARED_MEMORY_ENABLE_DUMP")) {
+      size_t size = allocation.getSharedMemorySize();
+      size_t peak = allocation.getPeakLiveSize();
+      llvm::errs() << "shared memory: size = " << size
+                   << ", peak live size = " << peak << ", fragmentation = "
+                   << (size ? 100 * (size - peak) / size : 0) << "%\n";
+    }
     MembarAnalysis membarPass(&allocation);
     membarPass.run();
 
+    // The pointers are traced back to the arguments of the kernel through
+    // the structured control flow
+    annotatePointerArguments(mod);
+
     // Step 4
     RewritePatternSet scf_patterns(context);
     mlir::populateLoopToStdConversionPatterns(scf_patterns);
@@ -165,7 +230,11 @@ public:
 
     // Step 5
     RewritePatternSet func_patterns(context);
-    func_patterns.add<FuncOpConversion>(typeConverter, numWarps, /*benefit=*/1);
+    int numWarpGroups = triton::gpu::TritonGPUDialect::getNumWarpGroups(mod);
+    int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+    func_patterns.add<FuncOpConversion>(
+        typeConverter, numWarps * numWarpGroups * threadsPerWarp,
+        /*benefit=*/1);
     if (failed(
             applyPartialConversion(mod, funcTarget, std::move(func_patterns))))
       return signalPassFailure();
@@ -199,10 +268,12 @@ public:
     // DotOp
     populateDotOpToLLVMPatterns(typeConverter, patterns, numWarps,
                                 axisInfoAnalysis, &allocation, smem,
+                                computeCapability, ptxVersion,
                                 /*benefit=*/10);
     // ElementwiseOp
     populateElementwiseOpToLLVMPatterns(typeConverter, patterns, numWarps,
                                         axisInfoAnalysis, &allocation, smem,
+                                        computeCapability, fastMath,
                                         /*benefit=*/10);
     // LoadStoreOp
     populateLoadStoreOpToLLVMPatterns(typeConverter, patterns, numWarps,
@@ -212,10 +283,18 @@ public:
     populateReduceOpToLLVMPatterns(typeConverter, patterns, numWarps,
                                    axisInfoAnalysis, &allocation, smem,
                                    indexCacheInfo, /*benefit=*/10);
+    // ScanOp
+    populateScanOpToLLVMPatterns(typeConverter, patterns, numWarps,
+                                 axisInfoAnalysis, &allocation, smem,
+                                 indexCacheInfo, /*benefit=*/10);
+    // SortOp
+    populateSortOpToLLVMPatterns(typeConverter, patterns, numWarps,
+                                 axisInfoAnalysis, &allocation, smem,
+                                 indexCacheInfo, /*benefit=*/10);
     // ViewOp
     populateViewOpToLLVMPatterns(typeConverter, patterns, numWarps,
                                  axisInfoAnalysis, &allocation, smem,
-                                 /*benefit=*/10);
+                                 indexCacheInfo, /*benefit=*/10);
 
     // Add arith/math's patterns to help convert scalar expression to LLVM.
     mlir::arith::populateArithmeticToLLVMConversionPatterns(typeConverter,
@@ -258,6 +337,77 @@ private:
 
   int computeCapability{};
 
+  // Each trace call site has its format, and the slots of the ring buffer
+  // hold the largest of their records
+  void numberTraceFormats(ModuleOp mod) {
+    OpBuilder b(mod.getContext());
+    int numFormats = 0;
+    unsigned slotWords = 0;
+    mod.walk([&](triton::TraceOp op) {
+      op->setAttr("triton_gpu.trace-format",
+                  b.getI32IntegerAttr(numFormats++));
+      slotWords = std::max(slotWords, getTraceRecordWords(op));
+    });
+    if (numFormats)
+      mod->setAttr("triton_gpu.trace-slot-words",
+                   b.getI32IntegerAttr(slotWords));
+  }
+
+  void numberProfileRegions(ModuleOp mod) {
+    SmallVector<triton::ProfileRegionOp> boundaries;
+    llvm::StringMap<int> regions;
+    mod.walk([&](triton::ProfileRegionOp op) {
+      boundaries.push_back(op);
+      regions.try_emplace(op.name(), regions.size() + 1);
+    });
+    if (boundaries.empty())
+      return;
+    OpBuilder b(mod.getContext());
+    for (triton::ProfileRegionOp op : boundaries)
+      op->setAttr("triton_gpu.region",
+                  b.getI32IntegerAttr(regions.lookup(op.name())));
+    // Region 0 runs from the entry of the kernel to its first boundary
+    mod->setAttr("triton_gpu.profile-regions",
+                 b.getI32IntegerAttr(regions.size() + 1));
+    for (auto funcOp : mod.getOps<FuncOp>()) {
+      if (funcOp.isExternal())
+        continue;
+      b.setInsertionPointToStart(&funcOp.getBody().front());
+      b.create<triton::ProfileRegionOp>(funcOp.getLoc(), "")
+          ->setAttr("triton_gpu.region", b.getI32IntegerAttr(0));
+      funcOp.walk([&](ReturnOp returnOp) {
+        b.setInsertionPoint(returnOp);
+        b.create<triton::ProfileRegionOp>(returnOp.getLoc(), "")
+            ->setAttr("triton_gpu.region", b.getI32IntegerAttr(-1));
+      });
+    }
+  }
+
+  // Marks the pointer arguments never written through as read-only, and
+  // the loads through read-only arguments aliasing no other argument as
+  // non-coherent: nothing writes their memory while the kernel runs.
+  void annotatePointerArguments(ModuleOp mod) {
+    OpBuilder b(mod.getContext());
+    for (auto funcOp : mod.getOps<FuncOp>()) {
+      if (funcOp.isExternal())
+        continue;
+      llvm::BitVector readOnly = getReadOnlyArguments(funcOp);
+      for (unsigned i : readOnly.set_bits())
+        funcOp.setArgAttr(i, "tt.readonly", b.getUnitAttr());
+      funcOp.walk([&](triton::LoadOp op) {
+        if (op.isVolatile())
+          return;
+        auto roots = getPointerRoots(op.ptr());
+        if (!roots || roots->empty())
+          return;
+        if (llvm::all_of(*roots, [&](unsigned i) {
+              return readOnly.test(i) && funcOp.getArgAttr(i, "tt.noalias");
+            }))
+          op->setAttr("triton_gpu.non_coherent", b.getUnitAttr());
+      });
+    }
+  }
+
   void initSharedMemory(size_t size,
                         TritonGPUToLLVMTypeConverter &typeConverter) {
     ModuleOp mod = getOperation();
@@ -267,9 +417,12 @@ private:
     // Set array size 0 and external linkage indicates that we use dynamic
     // shared allocation to allow a larger shared memory size for each kernel.
     auto arrayTy = LLVM::LLVMArrayType::get(elemTy, 0);
+    // The swizzled buffers read by wgmma are aligned to their swizzling
+    // period, at most 1024 bytes, relatively to the base of shared memory
+    unsigned alignment = computeCapability >= 90 ? 1024 : 0;
     auto global = b.create<LLVM::GlobalOp>(
         loc, arrayTy, /*isConstant=*/false, LLVM::Linkage::External,
-        "global_smem", /*value=*/Attribute(), /*alignment=*/0,
+        "global_smem", /*value=*/Attribute(), alignment,
         mlir::gpu::GPUDialect::getWorkgroupAddressSpace());
     SmallVector<LLVM::LLVMFuncOp> funcs;
     mod.walk([&](LLVM::LLVMFuncOp func) { funcs.push_back(func); });
@@ -282,9 +435,11 @@ private:
     smem = b.create<LLVM::BitcastOp>(loc, ptrTy, smem);
   }
 
-  void decomposeMmaToDotOperand(ModuleOp mod, int numWarps) const {
+  // The decompositions return whether they changed the module
+  bool decomposeMmaToDotOperand(ModuleOp mod, int numWarps) const {
     // Replace `mma -> dot_op` with `mma -> blocked -> dot_op`
     // unless certain conditions are met
+    bool changed = false;
     mod.walk([&](triton::gpu::ConvertLayoutOp cvtOp) -> void {
       OpBuilder builder(cvtOp);
       auto srcType = cvtOp.getOperand().getType().cast<RankedTensorType>();
@@ -298,20 +453,25 @@ private:
             dstType.getShape(), dstType.getElementType(),
             triton::gpu::BlockedEncodingAttr::get(
                 mod.getContext(), srcType.getShape(), getSizePerThread(srcMma),
-                getOrder(srcMma), numWarps));
+                getOrder(srcMma), numWarps,
+                triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod)));
         auto tmp = builder.create<triton::gpu::ConvertLayoutOp>(
             cvtOp.getLoc(), tmpType, cvtOp.getOperand());
         auto newConvert = builder.create<triton::gpu::ConvertLayoutOp>(
             cvtOp.getLoc(), dstType, tmp);
         cvtOp.replaceAllUsesWith(newConvert.getResult());
         cvtOp.erase();
+        changed = true;
       }
     });
+    return changed;
   }
 
-  void decomposeBlockedToDotOperand(ModuleOp mod) const {
+  bool decomposeBlockedToDotOperand(ModuleOp mod) const {
     // Replace `blocked -> dot_op` with `blocked -> shared -> dot_op`
-    // because the codegen doesn't handle `blocked -> dot_op` directly
+    // because the codegen doesn't handle `blocked -> dot_op` directly, and
+    // the same for `blocked -> sparse_dot_meta`
+    bool changed = false;
     mod.walk([&](triton::gpu::ConvertLayoutOp cvtOp) -> void {
       OpBuilder builder(cvtOp);
       auto srcType = cvtOp.getOperand().getType().cast<RankedTensorType>();
@@ -320,25 +480,33 @@ private:
           srcType.getEncoding().dyn_cast<triton::gpu::BlockedEncodingAttr>();
       auto dstDotOp =
           dstType.getEncoding().dyn_cast<triton::gpu::DotOperandEncodingAttr>();
-      if (srcBlocked && dstDotOp) {
+      // the metadata of sparse dots is read unswizzled, two i16 at a time
+      bool dstSparseMeta =
+          dstType.getEncoding().isa<triton::gpu::SparseDotMetaEncodingAttr>();
+      if (srcBlocked && (dstDotOp || dstSparseMeta)) {
+        auto sharedEnc =
+            dstDotOp ? triton::gpu::SharedEncodingAttr::get(
+                           mod.getContext(), dstDotOp, srcType.getShape(),
+                           getOrder(srcBlocked), srcType.getElementType(),
+                           triton::gpu::TritonGPUDialect::getSharedBanks(mod))
+                     : triton::gpu::SharedEncodingAttr::get(
+                           mod.getContext(), 1, 1, 1, getOrder(srcBlocked));
         auto tmpType = RankedTensorType::get(
-            dstType.getShape(), dstType.getElementType(),
-            triton::gpu::SharedEncodingAttr::get(
-                mod.getContext(), dstDotOp, srcType.getShape(),
-                getOrder(srcBlocked), srcType.getElementType()));
+            dstType.getShape(), dstType.getElementType(), sharedEnc);
         auto tmp = builder.create<triton::gpu::ConvertLayoutOp>(
             cvtOp.getLoc(), tmpType, cvtOp.getOperand());
         auto newConvert = builder.create<triton::gpu::ConvertLayoutOp>(
             cvtOp.getLoc(), dstType, tmp);
         cvtOp.replaceAllUsesWith(newConvert.getResult());
         cvtOp.erase();
+        changed = true;
       }
     });
+    return changed;
   }
 
-  void decomposeInsertSliceAsyncOp(ModuleOp mod) const {
-    AxisInfoAnalysis axisInfoAnalysis(mod.getContext());
-    axisInfoAnalysis.run(mod);
+  bool decomposeInsertSliceAsyncOp(ModuleOp mod,
+                                   AxisInfoAnalysis &axisInfoAnalysis) const {
     // TODO(Keren): This is a hacky knob that may cause performance regression
     // when decomposition has been performed. We should remove this knob once we
     // have thorough analysis on async wait. Currently, we decompose
@@ -373,8 +541,8 @@ private:
           dstTy.getEncoding().dyn_cast<triton::gpu::SharedEncodingAttr>();
       auto resElemTy = dstTy.getElementType();
       unsigned inVec = axisInfoAnalysis.getPtrContiguity(src);
-      unsigned outVec = resSharedLayout.getVec();
-      unsigned minVec = std::min(outVec, inVec);
+      unsigned minVec =
+          triton::gpu::getSharedAccessVec(resSharedLayout, inVec);
       auto maxBitWidth =
           std::max<unsigned>(128, resElemTy.getIntOrFloatBitWidth());
       auto vecBitWidth = resElemTy.getIntOrFloatBitWidth() * minVec;
@@ -382,11 +550,14 @@ private:
       auto byteWidth = bitWidth / 8;
 
       // If the load byte width is not eligible or the current compute
-      // capability does not support async copy, then we do decompose
+      // capability does not support async copy, then we do decompose.
+      // AMD GPUs have no async copy, so we always decompose there.
+#ifndef USE_ROCM
       if (triton::gpu::InsertSliceAsyncOp::getEligibleLoadByteWidth(
               computeCapability)
               .contains(byteWidth))
         return;
+#endif
 
       // load
       auto tmpTy =
@@ -418,15 +589,25 @@ private:
       decomposed = true;
     });
 
+#ifdef USE_ROCM
+    bool asyncCopySupported = false;
+#else
+    bool asyncCopySupported =
+        triton::gpu::AsyncWaitOp::isSupported(computeCapability);
+#endif
+    bool changed = decomposed;
     mod.walk([&](triton::gpu::AsyncCommitGroupOp asyncCommitGroupOp) -> void {
-      if (!triton::gpu::AsyncCommitGroupOp::isSupported(computeCapability))
+      if (!asyncCopySupported) {
         asyncCommitGroupOp.erase();
+        changed = true;
+      }
     });
 
     mod.walk([&](triton::gpu::AsyncWaitOp asyncWaitOp) -> void {
-      if (!triton::gpu::AsyncWaitOp::isSupported(computeCapability)) {
+      if (!asyncCopySupported) {
         // async wait is supported in Ampere and later
         asyncWaitOp.erase();
+        changed = true;
       } else if (decomposed) {
         // Wait for all previous async ops
         OpBuilder builder(asyncWaitOp);
@@ -435,6 +616,7 @@ private:
         asyncWaitOp.erase();
       }
     });
+    return changed;
   }
 };
 
@@ -444,8 +626,10 @@ namespace mlir {
 namespace triton {
 
 std::unique_ptr<OperationPass<ModuleOp>>
-createConvertTritonGPUToLLVMPass(int computeCapability) {
-  return std::make_unique<::ConvertTritonGPUToLLVM>(computeCapability);
+createConvertTritonGPUToLLVMPass(int computeCapability, bool fastMath,
+                                 int ptxVersion) {
+  return std::make_unique<::ConvertTritonGPUToLLVM>(computeCapability,
+                                                    fastMath, ptxVersion);
 }
 
 } // namespace triton
@@ -12,13 +12,16 @@ using namespace mlir::triton;
 
 using ::mlir::LLVM::DotOpFMAConversionHelper;
 using ::mlir::LLVM::DotOpMmaV1ConversionHelper;
+using ::mlir::LLVM::MFMAConversionHelper;
 using ::mlir::LLVM::MMA16816ConversionHelper;
 using ::mlir::triton::gpu::BlockedEncodingAttr;
 using ::mlir::triton::gpu::DotOperandEncodingAttr;
 using ::mlir::triton::gpu::getElemsPerThread;
+using ::mlir::triton::gpu::MfmaEncodingAttr;
 using ::mlir::triton::gpu::MmaEncodingAttr;
 using ::mlir::triton::gpu::SharedEncodingAttr;
 using ::mlir::triton::gpu::SliceEncodingAttr;
+using ::mlir::triton::gpu::SparseDotMetaEncodingAttr;
 
 class TritonGPUToLLVMTypeConverter : public LLVMTypeConverter {
 public:
@@ -37,6 +40,12 @@ public:
     addConversion([&](triton::Float8Type type) -> llvm::Optional<Type> {
       return IntegerType::get(type.getContext(), 8);
     });
+    addConversion([&](triton::Float8E4M3Type type) -> llvm::Optional<Type> {
+      return IntegerType::get(type.getContext(), 8);
+    });
+    addConversion([&](triton::Float8E5M2Type type) -> llvm::Optional<Type> {
+      return IntegerType::get(type.getContext(), 8);
+    });
     // Internally store bfloat16 as int16
     addConversion([&](BFloat16Type type) -> llvm::Optional<Type> {
       return IntegerType::get(type.getContext(), 16);
@@ -56,7 +65,7 @@ public:
 
     if (layout &&
         (layout.isa<BlockedEncodingAttr>() || layout.isa<SliceEncodingAttr>() ||
-         layout.isa<MmaEncodingAttr>())) {
+         layout.isa<MmaEncodingAttr>() || layout.isa<MfmaEncodingAttr>())) {
       unsigned numElementsPerThread = getElemsPerThread(type);
       SmallVector<Type, 4> types(numElementsPerThread,
                                  convertType(type.getElementType()));
@@ -83,12 +92,39 @@ public:
             DotOpFMAConversionHelper::getNumElemsPerThread(shape, dotOpLayout);
 
         return LLVM::LLVMStructType::getLiteral(
-            ctx, SmallVector<Type>(numElemsPerThread, type::f32Ty(ctx)));
+            ctx, SmallVector<Type>(numElemsPerThread,
+                                   convertType(type.getElementType())));
+      } else if (auto mfmaLayout = dotOpLayout.getParent()
+                                       .dyn_cast<MfmaEncodingAttr>()) {
+        // Each element carries the k values a lane feeds into one mfma.
+        // Note: this needs to be synced with MFMAConversionHelper::loadA/B
+        auto wpt = mfmaLayout.getWarpsPerCTA();
+        auto coreType =
+            MFMAConversionHelper::getMatrixCoreTypeFromOperand(type);
+        Type targetTy = MFMAConversionHelper::getMfmaOperandTy(coreType, ctx);
+        if (dotOpLayout.getOpIdx() == 0) { // $a
+          auto elems =
+              MFMAConversionHelper::getANumElemsPerThread(type, wpt[0]);
+          return struct_ty(SmallVector<Type>(elems, targetTy));
+        }
+        if (dotOpLayout.getOpIdx() == 1) { // $b
+          auto elems =
+              MFMAConversionHelper::getBNumElemsPerThread(type, wpt[1]);
+          return struct_ty(SmallVector<Type>(elems, targetTy));
+        }
       } else { // for parent is MMA layout
         auto mmaLayout = dotOpLayout.getParent().cast<MmaEncodingAttr>();
         auto wpt = mmaLayout.getWarpsPerCTA();
         Type elemTy = convertType(type.getElementType());
-        if (mmaLayout.isAmpere()) {
+        // wgmma reads $b from shared memory: it stays the shared memory
+        // object it is converted from
+        if (mmaLayout.isHopper() && dotOpLayout.getOpIdx() == 1) {
+          SmallVector<Type> types(1 + 2 * type.getRank(),
+                                  IntegerType::get(ctx, 32));
+          types[0] = LLVM::LLVMPointerType::get(elemTy, 3);
+          return struct_ty(types);
+        }
+        if (mmaLayout.isAmpere() || mmaLayout.isHopper()) {
           const llvm::DenseMap<int, Type> targetTyMap = {
               {32, vec_ty(elemTy, 1)},
               {16, vec_ty(elemTy, 2)},
@@ -145,6 +181,14 @@ public:
       llvm::errs() << "Unexpected dot operand layout detected in "
                       "TritonToLLVMTypeConverter";
       return llvm::None;
+    } else if (auto metaLayout =
+                   layout.dyn_cast_or_null<SparseDotMetaEncodingAttr>()) {
+      // Note: this needs to be synced with
+      //       MMA16816ConversionHelper::loadSparseMeta
+      auto mmaLayout = metaLayout.getParent().cast<MmaEncodingAttr>();
+      auto elems = MMA16816ConversionHelper::getSparseMetaNumElemsPerThread(
+          type, mmaLayout.getWarpsPerCTA()[0]);
+      return struct_ty(SmallVector<Type>(elems, IntegerType::get(ctx, 32)));
     }
 
     return llvm::None;
@@ -1,5 +1,7 @@
 #include "Utility.h"
 
+#include <cmath>
+
 namespace mlir {
 
 namespace LLVM {
@@ -154,5 +156,329 @@ Value shflSync(Location loc, ConversionPatternRewriter &rewriter, Value val,
   return builder.launch(rewriter, loc, val.getType(), false);
 }
 
+// Reads `val` from lane `srcLane` of the warp. On AMD GPUs `srcLane` is the
+// lane in the wavefront.
+Value shflIdxSync(Location loc, ConversionPatternRewriter &rewriter, Value val,
+                  Value srcLane) {
+  Type type = val.getType();
+  if (type.isa<LLVM::LLVMPointerType>()) {
+    Value intVal = ptrtoint(rewriter.getIntegerType(64), val);
+    return inttoptr(type, shflIdxSync(loc, rewriter, intVal, srcLane));
+  }
+
+  unsigned bits = type.getIntOrFloatBitWidth();
+  if (bits == 64) {
+    Type vecTy = vec_ty(f32_ty, 2);
+    Value vec = bitcast(val, vecTy);
+    Value val0 = extract_element(f32_ty, vec, i32_val(0));
+    Value val1 = extract_element(f32_ty, vec, i32_val(1));
+    val0 = shflIdxSync(loc, rewriter, val0, srcLane);
+    val1 = shflIdxSync(loc, rewriter, val1, srcLane);
+    vec = undef(vecTy);
+    vec = insert_element(vecTy, vec, val0, i32_val(0));
+    vec = insert_element(vecTy, vec, val1, i32_val(1));
+    return bitcast(vec, type);
+  }
+  if (bits < 32) {
+    Type intTy = rewriter.getIntegerType(bits);
+    Value intVal = type.isInteger(bits) ? val : bitcast(val, intTy);
+    Value shfl = shflIdxSync(loc, rewriter, zext(i32_ty, intVal), srcLane);
+    shfl = trunc(intTy, shfl);
+    return type.isInteger(bits) ? shfl : bitcast(shfl, type);
+  }
+
+#ifdef USE_ROCM
+  // ds_bpermute addresses the source lane in bytes
+  GCNBuilder builder;
+  auto bpermute = builder.create("ds_bpermute_b32");
+  auto dOpr = builder.newOperand("=v");
+  auto addrOpr = builder.newOperand(shl(srcLane, i32_val(2)), "v");
+  auto aOpr = builder.newOperand(val, "v");
+  (*bpermute)(dOpr, addrOpr, aOpr);
+  auto swait = builder.create("s_waitcnt lgkmcnt(0)");
+  (*swait)();
+#else
+  PTXBuilder builder;
+  auto &shfl = builder.create("shfl.sync")->o("idx").o("b32");
+  auto *dOpr = builder.newOperand("=r");
+  auto *aOpr = builder.newOperand(val, "r");
+  auto *bOpr = builder.newOperand(srcLane, "r");
+  auto *cOpr = builder.newConstantOperand("0x1f");
+  auto *maskOpr = builder.newConstantOperand("0xffffffff");
+  shfl(dOpr, aOpr, bOpr, cOpr, maskOpr);
+#endif
+  return builder.launch(rewriter, loc, type, false);
+}
+
+Value readFirstLane(Location loc, ConversionPatternRewriter &rewriter,
+                    Value val) {
+#ifdef USE_ROCM
+  Type type = val.getType();
+  if (type.isa<LLVM::LLVMPointerType>()) {
+    Value intVal = ptrtoint(rewriter.getIntegerType(64), val);
+    return inttoptr(type, readFirstLane(loc, rewriter, intVal));
+  }
+  if (!type.isIntOrFloat())
+    return val;
+
+  unsigned bits = type.getIntOrFloatBitWidth();
+  if (bits == 64) {
+    Type vecTy = vec_ty(i32_ty, 2);
+    Value vec = bitcast(val, vecTy);
+    Value val0 = extract_element(i32_ty, vec, i32_val(0));
+    Value val1 = extract_element(i32_ty, vec, i32_val(1));
+    val0 = readFirstLane(loc, rewriter, val0);
+    val1 = readFirstLane(loc, rewriter, val1);
+    vec = undef(vecTy);
+    vec = insert_element(vecTy, vec, val0, i32_val(0));
+    vec = insert_element(vecTy, vec, val1, i32_val(1));
+    return bitcast(vec, type);
+  }
+  if (bits > 64)
+    return val;
+  if (bits < 32) {
+    Type intTy = rewriter.getIntegerType(bits);
+    Value intVal = type.isInteger(bits) ? val : bitcast(val, intTy);
+    Value read = readFirstLane(loc, rewriter, zext(i32_ty, intVal));
+    read = trunc(intTy, read);
+    return type.isInteger(bits) ? read : bitcast(read, type);
+  }
+  if (!type.isInteger(32))
+    return bitcast(readFirstLane(loc, rewriter, bitcast(val, i32_ty)), type);
+
+  StringRef funcName = "llvm.amdgcn.readfirstlane";
+  auto moduleOp =
+      rewriter.getBlock()->getParent()->getParentOfType<ModuleOp>();
+  auto funcOp = moduleOp.lookupSymbol<LLVM::LLVMFuncOp>(funcName);
+  if (!funcOp) {
+    OpBuilder b(moduleOp.getBodyRegion());
+    funcOp = b.create<LLVM::LLVMFuncOp>(
+        loc, funcName, LLVM::LLVMFunctionType::get(i32_ty, {i32_ty}));
+  }
+  return rewriter.create<LLVM::CallOp>(loc, funcOp, val).getResult(0);
+#else
+  // ptxas places the values it proves warp-uniform in uniform registers
+  return val;
+#endif
+}
+
+void warpBarrier(Location loc, ConversionPatternRewriter &rewriter) {
+#ifdef USE_ROCM
+  // The warps of a wavefront run in lockstep and its LDS accesses complete in
+  // order, so only the compiler has to be kept from reordering them.
+  rewriter.create<LLVM::FenceOp>(loc, LLVM::AtomicOrdering::acq_rel,
+                                 "wavefront");
+#else
+  PTXBuilder builder;
+  auto &barSync = *builder.create<>("bar.warp.sync");
+  barSync(builder.newConstantOperand("0xffffffff"));
+  builder.launch(rewriter, loc, void_ty(rewriter.getContext()));
+#endif
+}
+
+Value getClusterCTARank(Location loc, ConversionPatternRewriter &rewriter) {
+  PTXBuilder builder;
+  auto &mov = *builder.create<>("mov.u32");
+  mov(builder.newOperand("=r"), builder.newConstantOperand("%cluster_ctarank"));
+  return builder.launch(rewriter, loc, i32_ty, /*hasSideEffect*/ false);
+}
+
+Value mapClusterShared(Location loc, ConversionPatternRewriter &rewriter,
+                       Value ptr, Value rank) {
+  PTXBuilder builder;
+  auto &mapa = *builder.create<>("mapa.shared::cluster.u32");
+  mapa(builder.newOperand("=r"), builder.newOperand(ptrtoint(i32_ty, ptr), "r"),
+       builder.newOperand(rank, "r"));
+  return builder.launch(rewriter, loc, i32_ty, /*hasSideEffect*/ false);
+}
+
+void copyClusterShared(Location loc, ConversionPatternRewriter &rewriter,
+                       Value ptr, Value clusterAddr, Value pred) {
+  MLIRContext *ctx = rewriter.getContext();
+  PTXBuilder ldBuilder;
+  auto *dstsOpr = ldBuilder.newListOperand(4, "=r");
+  auto &ld = ldBuilder.create<>("ld")->o("shared::cluster").v(4).b(32);
+  ld(dstsOpr, ldBuilder.newAddrOperand(clusterAddr, "r")).predicate(pred, "b");
+  Type retTy = LLVM::LLVMStructType::getLiteral(
+      ctx, SmallVector<Type>(4, i32_ty));
+  Value words = ldBuilder.launch(rewriter, loc, retTy);
+
+  PTXBuilder stBuilder;
+  auto *srcsOpr = stBuilder.newListOperand();
+  for (unsigned i = 0; i < 4; ++i)
+    srcsOpr->listAppend(
+        stBuilder.newOperand(extract_val(i32_ty, words, i64_arr_attr(i)), "r"));
+  auto &st = stBuilder.create<>("st")->shared().v(4).b(32);
+  st(stBuilder.newAddrOperand(ptr, "r"), srcsOpr).predicate(pred, "b");
+  stBuilder.launch(rewriter, loc, void_ty(ctx));
+}
+
+Value ballotSync(Location loc, ConversionPatternRewriter &rewriter,
+                 Value pred) {
+#ifdef USE_ROCM
+  StringRef funcName = "llvm.amdgcn.ballot.i64";
+  auto moduleOp =
+      rewriter.getBlock()->getParent()->getParentOfType<ModuleOp>();
+  auto funcOp = moduleOp.lookupSymbol<LLVM::LLVMFuncOp>(funcName);
+  if (!funcOp) {
+    OpBuilder b(moduleOp.getBodyRegion());
+    funcOp = b.create<LLVM::LLVMFuncOp>(
+        loc, funcName,
+        LLVM::LLVMFunctionType::get(i64_ty, {rewriter.getI1Type()}));
+  }
+  return rewriter.create<LLVM::CallOp>(loc, funcOp, pred).getResult(0);
+#else
+  PTXBuilder builder;
+  auto &vote = builder.create<>("vote")->o("sync").o("ballot").o("b32");
+  auto *dOpr = builder.newOperand("=r");
+  auto *pOpr = builder.newOperand(pred, "b");
+  auto *maskOpr = builder.newConstantOperand("0xffffffff");
+  vote(dOpr, pOpr, maskOpr);
+  return builder.launch(rewriter, loc, i32_ty, false);
+#endif
+}
+
+Value matchAnySync(Location loc, ConversionPatternRewriter &rewriter,
+                   Value key) {
+  if (key.getType().isa<LLVM::LLVMPointerType>())
+    key = ptrtoint(i64_ty, key);
+#ifdef USE_ROCM
+  // Peel off the lanes with the key of the lowest remaining lane until none
+  // is left; the loop is uniform as its state comes from ballots
+  Type maskTy = i64_ty;
+  Value zero = int_val(64, 0);
+  auto *curBlock = rewriter.getInsertionBlock();
+  auto *exitBlock = curBlock->splitBlock(rewriter.getInsertionPoint());
+  auto *headerBlock = rewriter.createBlock(exitBlock, {maskTy, maskTy},
+                                           {loc, loc});
+  auto *bodyBlock = rewriter.createBlock(exitBlock);
+  exitBlock->addArgument(maskTy, loc);
+
+  rewriter.setInsertionPointToEnd(curBlock);
+  Value active = ballotSync(loc, rewriter, int_val(1, 1));
+  rewriter.create<LLVM::BrOp>(loc, ValueRange{active, zero}, headerBlock);
+
+  rewriter.setInsertionPointToEnd(headerBlock);
+  Value remaining = headerBlock->getArgument(0);
+  Value peers = headerBlock->getArgument(1);
+  rewriter.create<LLVM::CondBrOp>(loc, icmp_ne(remaining, zero), bodyBlock,
+                                  ValueRange{}, exitBlock, ValueRange{peers});
+
+  rewriter.setInsertionPointToEnd(bodyBlock);
+  Value firstLane = trunc(
+      i32_ty, rewriter.create<LLVM::CountTrailingZerosOp>(
+                  loc, maskTy, remaining, int_val(1, 0)));
+  Value isPeer = icmp_eq(key, shflIdxSync(loc, rewriter, key, firstLane));
+  Value group = ballotSync(loc, rewriter, isPeer);
+  Value allOnes = int_val(64, -1);
+  rewriter.create<LLVM::BrOp>(
+      loc,
+      ValueRange{and_(remaining, xor_(group, allOnes)),
+                 select(isPeer, group, peers)},
+      headerBlock);
+
+  rewriter.setInsertionPointToStart(exitBlock);
+  return exitBlock->getArgument(0);
+#else
+  PTXBuilder builder;
+  auto &match = builder.create<>("match")->o("any").o("sync").o("b64");
+  auto *dOpr = builder.newOperand("=r");
+  auto *keyOpr = builder.newOperand(key, "l");
+  auto *maskOpr = builder.newConstantOperand("0xffffffff");
+  match(dOpr, keyOpr, maskOpr);
+  return builder.launch(rewriter, loc, i32_ty, false);
+#endif
+}
+
+static Value createSplatConstant(Location loc,
+                                 ConversionPatternRewriter &rewriter, Type type,
+                                 Attribute value) {
+  if (auto vecTy = type.dyn_cast<VectorType>())
+    return rewriter.create<LLVM::ConstantOp>(
+        loc, vecTy, DenseElementsAttr::get(vecTy, ArrayRef<Attribute>(value)));
+  return rewriter.create<LLVM::ConstantOp>(loc, type, value);
+}
+
+Value convertFp8ToFp16Bits(Location loc, ConversionPatternRewriter &rewriter,
+                           Value v, triton::Fp8Format format) {
+  Type type = v.getType();
+  auto i16Val = [&](int16_t c) {
+    return createSplatConstant(loc, rewriter, type,
+                               rewriter.getI16IntegerAttr(c));
+  };
+  // E5M2 is fp16 without the 8 low bits of the mantissa
+  if (format == triton::Fp8Format::E5M2)
+    return shl(type, v, i16Val(8));
+
+  // The magnitude bits of E4M3 shifted to the exponent of fp16 encode the
+  // value divided by 2^(15 - 7), subnormals included
+  Type halfTy = f16_ty;
+  if (auto vecTy = type.dyn_cast<VectorType>())
+    halfTy = vec_ty(f16_ty, vecTy.getNumElements());
+  Value mag = and_(type, v, i16Val(0x7F));
+  Value half = bitcast(shl(type, mag, i16Val(7)), halfTy);
+  half = fmul(halfTy, half,
+              createSplatConstant(loc, rewriter, halfTy,
+                                  rewriter.getF16FloatAttr(256.0)));
+  Value bits = bitcast(half, type);
+  // E4M3 has no infinities, and S.1111.111 is NaN
+  bits = select(icmp_eq(mag, i16Val(0x7F)), i16Val(0x7E00), bits);
+  Value sign = shl(type, and_(type, v, i16Val(0x80)), i16Val(8));
+  return or_(type, bits, sign);
+}
+
+std::pair<Value, Value>
+convertFp8x4ToFp16x4(Location loc, ConversionPatternRewriter &rewriter,
+                     Value v, triton::Fp8Format format) {
+  // Spread the bytes over the low bytes of the 16-bit halves
+  Value lo = or_(i32_ty, and_(i32_ty, v, i32_val(0xFF)),
+                 shl(i32_ty, and_(i32_ty, v, i32_val(0xFF00)), i32_val(8)));
+  Value hi =
+      or_(i32_ty, and_(i32_ty, lshr(i32_ty, v, i32_val(16)), i32_val(0xFF)),
+          and_(i32_ty, lshr(i32_ty, v, i32_val(8)), i32_val(0xFF0000)));
+  Type i16x2Ty = vec_ty(i16_ty, 2);
+  auto convert = [&](Value pair) -> Value {
+    Value bits =
+        convertFp8ToFp16Bits(loc, rewriter, bitcast(pair, i16x2Ty), format);
+    return bitcast(bits, i32_ty);
+  };
+  return {convert(lo), convert(hi)};
+}
+
+Value convertFp32ToFp8(Location loc, ConversionPatternRewriter &rewriter,
+                       Value v, triton::Fp8Format format) {
+  bool isE4M3 = format == triton::Fp8Format::E4M3;
+  int mantissaBits = isE4M3 ? 3 : 2;
+  int bias = isE4M3 ? 7 : 15;
+  int maxFinite = isE4M3 ? 0x7E : 0x7B;
+  int nan = isE4M3 ? 0x7F : 0x7E;
+
+  Value bits = bitcast(v, i32_ty);
+  Value sign = and_(i32_ty, lshr(i32_ty, bits, i32_val(24)), i32_val(0x80));
+  Value abs = and_(i32_ty, bits, i32_val(0x7FFFFFFF));
+
+  // Normal values: round the mantissa to nearest even and rebias the exponent
+  int shift = 23 - mantissaBits;
+  Value odd = and_(i32_ty, lshr(i32_ty, abs, i32_val(shift)), i32_val(1));
+  Value rounded =
+      add(i32_ty, abs, add(i32_ty, odd, i32_val((1 << (shift - 1)) - 1)));
+  Value normal = sub(i32_ty, lshr(i32_ty, rounded, i32_val(shift)),
+                     i32_val((127 - bias) << mantissaBits));
+
+  // Subnormal values: scale to units of the smallest subnormal, and round to
+  // nearest even by adding 2^23
+  float subnormalScale = std::ldexp(1.0f, bias - 1 + mantissaBits);
+  Value scaled = fmul(f32_ty, bitcast(abs, f32_ty), f32_val(subnormalScale));
+  Value subnormal =
+      sub(i32_ty, bitcast(fadd(f32_ty, scaled, f32_val(8388608.0f)), i32_ty),
+          i32_val(0x4B000000));
+
+  Value isSubnormal = icmp_ult(abs, i32_val((127 + 1 - bias) << 23));
+  Value res = select(isSubnormal, subnormal, normal);
+  res = umin(i32_ty, res, i32_val(maxFinite));
+  res = select(icmp_ugt(abs, i32_val(0x7F800000)), i32_val(nan), res);
+  return trunc(i8_ty, or_(i32_ty, res, sign));
+}
+
 } // namespace LLVM
 } // namespace mlir
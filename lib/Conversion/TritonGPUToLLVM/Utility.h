@@ -13,12 +13,14 @@
 #define inttoptr(...) rewriter.create<LLVM::IntToPtrOp>(loc, __VA_ARGS__)
 #define ptrtoint(...) rewriter.create<LLVM::PtrToIntOp>(loc, __VA_ARGS__)
 #define zext(...) rewriter.create<LLVM::ZExtOp>(loc, __VA_ARGS__)
+#define sext(...) rewriter.create<LLVM::SExtOp>(loc, __VA_ARGS__)
 #define trunc(...) rewriter.create<LLVM::TruncOp>(loc, __VA_ARGS__)
 #define udiv(...) rewriter.create<LLVM::UDivOp>(loc, __VA_ARGS__)
 #define urem(...) rewriter.create<LLVM::URemOp>(loc, __VA_ARGS__)
 #define add(...) rewriter.create<LLVM::AddOp>(loc, __VA_ARGS__)
 #define sub(...) rewriter.create<LLVM::SubOp>(loc, __VA_ARGS__)
 #define fadd(...) rewriter.create<LLVM::FAddOp>(loc, __VA_ARGS__)
+#define fsub(...) rewriter.create<LLVM::FSubOp>(loc, __VA_ARGS__)
 #define mul(...) rewriter.create<LLVM::MulOp>(loc, __VA_ARGS__)
 #define fmul(...) rewriter.create<LLVM::FMulOp>(loc, __VA_ARGS__)
 #define shl(...) rewriter.create<LLVM::ShlOp>(loc, __VA_ARGS__)
@@ -78,6 +80,7 @@
 
 // Types
 #define i32_ty rewriter.getIntegerType(32)
+#define i64_ty rewriter.getIntegerType(64)
 #define i16_ty rewriter.getIntegerType(16)
 #define ui32_ty rewriter.getIntegerType(32, false)
 #define f16_ty rewriter.getF16Type()
@@ -272,6 +275,58 @@ Value storeShared(ConversionPatternRewriter &rewriter, Location loc, Value ptr,
 Value shflSync(Location loc, ConversionPatternRewriter &rewriter, Value val,
                int i);
 
+Value shflIdxSync(Location loc, ConversionPatternRewriter &rewriter, Value val,
+                  Value srcLane);
+
+void warpBarrier(Location loc, ConversionPatternRewriter &rewriter);
+
+/// Returns the rank of the CTA in its thread block cluster, an i32. Requires
+/// sm_90, as the following helpers of the distributed shared memory.
+Value getClusterCTARank(Location loc, ConversionPatternRewriter &rewriter);
+
+/// Returns the 32-bit address, in the shared memory of the cluster, of
+/// \param ptr in the shared memory of the CTA of rank \param rank.
+Value mapClusterShared(Location loc, ConversionPatternRewriter &rewriter,
+                       Value ptr, Value rank);
+
+/// Copies the 16 bytes at \param clusterAddr, as returned by
+/// mapClusterShared, to \param ptr in the shared memory of the CTA, if
+/// \param pred is set.
+void copyClusterShared(Location loc, ConversionPatternRewriter &rewriter,
+                       Value ptr, Value clusterAddr, Value pred);
+
+/// Returns \param val, uniform across the warp, as read from its first active
+/// lane. On AMD GPUs this places it in a scalar register (SGPR) even when the
+/// backend cannot prove it uniform; elsewhere \param val is returned as is.
+Value readFirstLane(Location loc, ConversionPatternRewriter &rewriter,
+                    Value val);
+
+/// Returns the mask of the lanes of the warp, or of the wavefront on AMD GPUs,
+/// where \param pred is set; an i32, or an i64 on AMD GPUs.
+Value ballotSync(Location loc, ConversionPatternRewriter &rewriter,
+                 Value pred);
+
+/// Returns the mask, as in ballotSync, of the lanes with the same \param key,
+/// an integer of up to 64 bits or a pointer. Requires sm_70.
+Value matchAnySync(Location loc, ConversionPatternRewriter &rewriter,
+                   Value key);
+
+/// Convert the fp8 values of \param format in the low bytes of \param v, an
+/// i16 or a vector of i16, to the bits of fp16 values.
+Value convertFp8ToFp16Bits(Location loc, ConversionPatternRewriter &rewriter,
+                           Value v, triton::Fp8Format format);
+
+/// Convert the four fp8 values of \param format packed in \param v, an i32,
+/// to two i32 holding the f16x2 of bytes {0, 1} and {2, 3}.
+std::pair<Value, Value>
+convertFp8x4ToFp16x4(Location loc, ConversionPatternRewriter &rewriter,
+                     Value v, triton::Fp8Format format);
+
+/// Convert the f32 \param v to an fp8 value of \param format, stored as i8.
+/// Rounds to nearest even and saturates to the largest finite value.
+Value convertFp32ToFp8(Location loc, ConversionPatternRewriter &rewriter,
+                       Value v, triton::Fp8Format format);
+
 } // namespace LLVM
 } // namespace mlir
 
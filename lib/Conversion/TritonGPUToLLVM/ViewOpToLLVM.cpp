@@ -10,6 +10,7 @@ using ::mlir::LLVM::DotOpMmaV2ConversionHelper;
 using ::mlir::LLVM::getElementsFromStruct;
 using ::mlir::LLVM::getSharedMemoryObjectFromStruct;
 using ::mlir::LLVM::getStructFromElements;
+using ::mlir::LLVM::MFMAConversionHelper;
 using ::mlir::LLVM::MMA16816ConversionHelper;
 using ::mlir::triton::gpu::getElemsPerThread;
 
@@ -30,7 +31,8 @@ struct SplatOpConversion
                                   Location loc) {
     auto tensorTy = resType.cast<RankedTensorType>();
     if (tensorTy.getEncoding().isa<BlockedEncodingAttr>() ||
-        tensorTy.getEncoding().isa<SliceEncodingAttr>()) {
+        tensorTy.getEncoding().isa<SliceEncodingAttr>() ||
+        tensorTy.getEncoding().isa<MfmaEncodingAttr>()) {
       auto srcType = typeConverter->convertType(elemType);
       auto llSrc = bitcast(constVal, srcType);
       size_t elemsPerThread = getElemsPerThread(tensorTy);
@@ -69,7 +71,9 @@ struct SplatOpConversion
     int numElems{};
     if (auto mmaLayout = parent.dyn_cast<MmaEncodingAttr>()) {
       Type matTy;
-      if (mmaLayout.isAmpere()) {
+      if (mmaLayout.isAmpere() || mmaLayout.isHopper()) {
+        assert(!(mmaLayout.isHopper() && layout.getOpIdx() == 1) &&
+               "$b of wgmma is read from shared memory");
         numElems = layout.getOpIdx() == 0
                        ? MMA16816ConversionHelper::getANumElemsPerThread(
                              tensorTy, mmaLayout.getWarpsPerCTA()[0])
@@ -105,6 +109,29 @@ struct SplatOpConversion
         retVal = insert_element(retTy, retVal, constVal, i32_val(i));
       }
 
+    } else if (auto mfmaLayout = parent.dyn_cast<MfmaEncodingAttr>()) {
+      auto wpt = mfmaLayout.getWarpsPerCTA();
+      numElems = layout.getOpIdx() == 0
+                     ? MFMAConversionHelper::getANumElemsPerThread(tensorTy,
+                                                                   wpt[0])
+                     : MFMAConversionHelper::getBNumElemsPerThread(tensorTy,
+                                                                   wpt[1]);
+      auto coreType =
+          MFMAConversionHelper::getMatrixCoreTypeFromOperand(tensorTy);
+      int kPerLane = MFMAConversionHelper::getMfmaInstrK(coreType) / 2;
+      Type llElemTy = typeConverter->convertType(elemType);
+      Value llVal = bitcast(constVal, llElemTy);
+      retTy = MFMAConversionHelper::getMfmaOperandTy(coreType,
+                                                     rewriter.getContext());
+      retVal = llVal;
+      if (kPerLane > 1) {
+        Type vecTy = vec_ty(llElemTy, kPerLane);
+        retVal = undef(vecTy);
+        for (auto i = 0; i < kPerLane; ++i)
+          retVal = insert_element(vecTy, retVal, llVal, i32_val(i));
+        if (vecTy != retTy)
+          retVal = bitcast(retVal, retTy);
+      }
     } else if (auto blockedLayout = parent.dyn_cast<BlockedEncodingAttr>()) {
       numElems = DotOpFMAConversionHelper::getNumElemsPerThread(shape, layout);
     } else {
@@ -123,7 +150,7 @@ struct SplatOpConversion
       ConversionPatternRewriter &rewriter, Location loc) {
     auto tensorTy = resType.cast<RankedTensorType>();
     auto shape = tensorTy.getShape();
-    if (layout.isAmpere()) {
+    if (layout.isAmpere() || layout.isHopper()) {
       auto [repM, repN] = DotOpMmaV2ConversionHelper::getRepMN(tensorTy);
       size_t fcSize = 4 * repM * repN;
 
@@ -153,6 +180,10 @@ struct SplatOpConversion
                                 ConversionPatternRewriter &rewriter) const {
     auto loc = op->getLoc();
     auto src = adaptor.src();
+    // The source is uniform, and is kept in a scalar register on AMD GPUs so
+    // that the computations on the splat are done once per wavefront
+    if (!src.getDefiningOp<LLVM::ConstantOp>())
+      src = LLVM::readFirstLane(loc, rewriter, src);
     auto llStruct = convertSplatLikeOp(src.getType(), op.getType(), src,
                                        getTypeConverter(), rewriter, loc);
     rewriter.replaceOp(op, {llStruct});
@@ -205,8 +236,11 @@ struct CatOpConversion : public ConvertTritonGPUOpToLLVMPattern<CatOp> {
   using OpAdaptor = typename CatOp::Adaptor;
 
   explicit CatOpConversion(LLVMTypeConverter &typeConverter,
+                           const Allocation *allocation, Value smem,
+                           IndexCacheInfo indexCacheInfo,
                            PatternBenefit benefit = 1)
-      : ConvertTritonGPUOpToLLVMPattern<CatOp>(typeConverter, benefit) {}
+      : ConvertTritonGPUOpToLLVMPattern<CatOp>(typeConverter, allocation, smem,
+                                               indexCacheInfo, benefit) {}
 
   LogicalResult
   matchAndRewrite(CatOp op, OpAdaptor adaptor,
@@ -220,18 +254,139 @@ struct CatOpConversion : public ConvertTritonGPUOpToLLVMPattern<CatOp> {
     // unpack input values
     auto lhsVals = getElementsFromStruct(loc, adaptor.lhs(), rewriter);
     auto rhsVals = getElementsFromStruct(loc, adaptor.rhs(), rewriter);
-    // concatenate (and potentially reorder) values
     SmallVector<Value> retVals;
-    for (Value v : lhsVals)
-      retVals.push_back(v);
-    for (Value v : rhsVals)
-      retVals.push_back(v);
+    if (auto axis = op.axis()) {
+      if (failed(concatAlongAxis(op, *axis, lhsVals, rhsVals, retVals,
+                                 rewriter)))
+        return failure();
+    } else {
+      // concatenate (and potentially reorder) values
+      for (Value v : lhsVals)
+        retVals.push_back(v);
+      for (Value v : rhsVals)
+        retVals.push_back(v);
+    }
     // pack and replace
     Type structTy = LLVM::LLVMStructType::getLiteral(this->getContext(), types);
     Value ret = getStructFromElements(loc, retVals, rewriter, structTy);
     rewriter.replaceOp(op, ret);
     return success();
   }
+
+private:
+  // The operands and the result of an ordered cat share their layout. If the
+  // layout tiles the operands along `axis`, each thread holds the elements of
+  // both operands at the same place in the two halves of the result, and
+  // they are only renamed. Otherwise the layout wraps around the operands and
+  // the result alike: every thread holds as many elements of each, and the
+  // threads of the upper half of the result take those of $rhs.
+  LogicalResult concatAlongAxis(CatOp op, unsigned axis,
+                                ArrayRef<Value> lhsVals,
+                                ArrayRef<Value> rhsVals,
+                                SmallVector<Value> &retVals,
+                                ConversionPatternRewriter &rewriter) const {
+    Location loc = op->getLoc();
+    auto srcTy = op.lhs().getType().cast<RankedTensorType>();
+    auto resultTy = op.getType().cast<RankedTensorType>();
+    auto layout = srcTy.getEncoding().dyn_cast<BlockedEncodingAttr>();
+    if (!layout)
+      return op.emitError("ordered cat is only supported in blocked layouts");
+    unsigned half = srcTy.getShape()[axis];
+    if (layout.getSizePerThread()[axis] > half)
+      return op.emitError("ordered cat operands smaller than the elements of "
+                          "a thread along the axis");
+    auto srcOffsets = emitOffsetForLayout(layout, srcTy.getShape());
+    auto resultOffsets = emitOffsetForLayout(layout, resultTy.getShape());
+    if (triton::gpu::getShapePerCTA(layout)[axis] <= half) {
+      DenseMap<SmallVector<unsigned>, unsigned, SmallVectorKeyInfo> srcIdx;
+      for (unsigned i = 0; i < srcOffsets.size(); ++i)
+        srcIdx[srcOffsets[i]] = i;
+      for (auto offset : resultOffsets) {
+        bool isRhs = offset[axis] >= half;
+        if (isRhs)
+          offset[axis] -= half;
+        unsigned i = srcIdx.lookup(offset);
+        retVals.push_back(isRhs ? rhsVals[i] : lhsVals[i]);
+      }
+      return success();
+    }
+    assert(srcOffsets == resultOffsets);
+    Value base = emitBaseIndexForLayout(loc, rewriter, layout,
+                                        resultTy.getShape())[axis];
+    Value isRhs = icmp_uge(base, idx_val(half));
+    for (unsigned i = 0; i < lhsVals.size(); ++i)
+      retVals.push_back(select(isRhs, rhsVals[i], lhsVals[i]));
+    return success();
+  }
+};
+
+// The joined dimension is held in the registers of each thread (see
+// inferJoinOpEncoding): joining and splitting only rename values.
+struct JoinOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::JoinOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::JoinOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::JoinOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto srcTy = op.lhs().getType().cast<RankedTensorType>();
+    auto resultTy = op.getType().cast<RankedTensorType>();
+    auto srcOffsets =
+        emitOffsetForLayout(srcTy.getEncoding(), srcTy.getShape());
+    auto resultOffsets =
+        emitOffsetForLayout(resultTy.getEncoding(), resultTy.getShape());
+    DenseMap<SmallVector<unsigned>, unsigned, SmallVectorKeyInfo> srcIdx;
+    for (unsigned i = 0; i < srcOffsets.size(); ++i)
+      srcIdx[srcOffsets[i]] = i;
+    auto lhsVals = getElementsFromStruct(loc, adaptor.lhs(), rewriter);
+    auto rhsVals = getElementsFromStruct(loc, adaptor.rhs(), rewriter);
+    SmallVector<Value> retVals;
+    for (auto offset : resultOffsets) {
+      unsigned idx = offset.pop_back_val();
+      unsigned i = srcIdx.lookup(offset);
+      retVals.push_back(idx ? rhsVals[i] : lhsVals[i]);
+    }
+    Type structTy = getTypeConverter()->convertType(resultTy);
+    Value ret = getStructFromElements(loc, retVals, rewriter, structTy);
+    rewriter.replaceOp(op, ret);
+    return success();
+  }
+};
+
+struct SplitOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::SplitOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::SplitOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::SplitOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op->getLoc();
+    auto srcTy = op.src().getType().cast<RankedTensorType>();
+    auto resultTy = op.outLHS().getType().cast<RankedTensorType>();
+    auto srcOffsets =
+        emitOffsetForLayout(srcTy.getEncoding(), srcTy.getShape());
+    auto resultOffsets =
+        emitOffsetForLayout(resultTy.getEncoding(), resultTy.getShape());
+    DenseMap<SmallVector<unsigned>, unsigned, SmallVectorKeyInfo> resultIdx;
+    for (unsigned i = 0; i < resultOffsets.size(); ++i)
+      resultIdx[resultOffsets[i]] = i;
+    auto srcVals = getElementsFromStruct(loc, adaptor.src(), rewriter);
+    SmallVector<Value> outVals[2] = {SmallVector<Value>(resultOffsets.size()),
+                                     SmallVector<Value>(resultOffsets.size())};
+    for (unsigned i = 0; i < srcOffsets.size(); ++i) {
+      SmallVector<unsigned> offset = srcOffsets[i];
+      unsigned idx = offset.pop_back_val();
+      outVals[idx][resultIdx.lookup(offset)] = srcVals[i];
+    }
+    Type structTy = getTypeConverter()->convertType(resultTy);
+    Value lhs = getStructFromElements(loc, outVals[0], rewriter, structTy);
+    Value rhs = getStructFromElements(loc, outVals[1], rewriter, structTy);
+    rewriter.replaceOp(op, {lhs, rhs});
+    return success();
+  }
 };
 
 template <typename SourceOp>
@@ -283,16 +438,20 @@ struct TransOpConversion
   }
 };
 
-void populateViewOpToLLVMPatterns(mlir::LLVMTypeConverter &typeConverter,
-                                  RewritePatternSet &patterns, int numWarps,
-                                  AxisInfoAnalysis &axisInfoAnalysis,
-                                  const Allocation *allocation, Value smem,
-                                  PatternBenefit benefit) {
+void populateViewOpToLLVMPatterns(
+    mlir::LLVMTypeConverter &typeConverter, RewritePatternSet &patterns,
+    int numWarps, AxisInfoAnalysis &axisInfoAnalysis,
+    const Allocation *allocation, Value smem,
+    ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo &indexCacheInfo,
+    PatternBenefit benefit) {
   patterns.add<ViewLikeOpConversion<triton::ViewOp>>(typeConverter, benefit);
   patterns.add<ViewLikeOpConversion<triton::ExpandDimsOp>>(typeConverter,
                                                            benefit);
   patterns.add<SplatOpConversion>(typeConverter, benefit);
   patterns.add<ArithConstantSplatOpConversion>(typeConverter, benefit);
-  patterns.add<CatOpConversion>(typeConverter, benefit);
+  patterns.add<CatOpConversion>(typeConverter, allocation, smem,
+                                indexCacheInfo, benefit);
+  patterns.add<JoinOpConversion>(typeConverter, benefit);
+  patterns.add<SplitOpConversion>(typeConverter, benefit);
   patterns.add<TransOpConversion>(typeConverter, benefit);
 }
@@ -224,6 +224,22 @@ struct TritonExpandDimsPattern
   }
 };
 
+// The blocked layout of the result of a dot of the given shape distributed
+// over numWarps warps
+static triton::gpu::BlockedEncodingAttr
+getDotMatEncoding(MLIRContext *context, ArrayRef<int64_t> matShape,
+                  int numWarps, int threadsPerWarp) {
+  int numThreads = numWarps * threadsPerWarp;
+  SmallVector<unsigned> retSizePerThread = {1, 1};
+  if (matShape[0] * matShape[1] / numThreads >= 4)
+    retSizePerThread = {2, 2};
+  if (matShape[0] * matShape[1] / numThreads >= 16)
+    retSizePerThread = {4, 4};
+  SmallVector<unsigned> retOrder = {1, 0};
+  return triton::gpu::BlockedEncodingAttr::get(
+      context, matShape, retSizePerThread, retOrder, numWarps, threadsPerWarp);
+}
+
 struct TritonDotPattern : public OpConversionPattern<triton::DotOp> {
   using OpConversionPattern<triton::DotOp>::OpConversionPattern;
 
@@ -234,15 +250,26 @@ struct TritonDotPattern : public OpConversionPattern<triton::DotOp> {
     auto origShape = origType.getShape();
     auto typeConverter = getTypeConverter<TritonGPUTypeConverter>();
     int numWarps = typeConverter->getNumWarps();
-
-    SmallVector<unsigned> retSizePerThread = {1, 1};
-    if (origShape[0] * origShape[1] / (numWarps * 32) >= 4)
-      retSizePerThread = {2, 2};
-    if (origShape[0] * origShape[1] / (numWarps * 32) >= 16)
-      retSizePerThread = {4, 4};
-    SmallVector<unsigned> retOrder = {1, 0};
-    Attribute dEncoding = triton::gpu::BlockedEncodingAttr::get(
-        getContext(), origShape, retSizePerThread, retOrder, numWarps);
+    int threadsPerWarp = typeConverter->getThreadsPerWarp();
+    // The batches of a batched dot are distributed over the warps first, and
+    // each matrix over the remaining warps
+    bool isBatched = origShape.size() == 3;
+    int batchWarps = isBatched ? std::min<int>(origShape[0], numWarps) : 1;
+    ArrayRef<int64_t> matShape = origShape.take_back(2);
+    auto matEncoding = getDotMatEncoding(getContext(), matShape,
+                                         numWarps / batchWarps, threadsPerWarp);
+    Attribute dEncoding = matEncoding;
+    if (isBatched) {
+      auto prepend = [](unsigned batch, ArrayRef<unsigned> mat) {
+        SmallVector<unsigned> res{batch};
+        res.append(mat.begin(), mat.end());
+        return res;
+      };
+      dEncoding = triton::gpu::BlockedEncodingAttr::get(
+          getContext(), prepend(1, matEncoding.getSizePerThread()),
+          prepend(1, matEncoding.getThreadsPerWarp()),
+          prepend(batchWarps, matEncoding.getWarpsPerCTA()), {2, 1, 0});
+    }
     RankedTensorType retType =
         RankedTensorType::get(origShape, origType.getElementType(), dEncoding);
     // a & b must be of smem layout
@@ -272,7 +299,47 @@ struct TritonDotPattern : public OpConversionPattern<triton::DotOp> {
     c = rewriter.create<triton::gpu::ConvertLayoutOp>(c.getLoc(), retType, c);
 
     rewriter.replaceOpWithNewOp<triton::DotOp>(op, retType, a, b, c,
-                                               adaptor.allowTF32());
+                                               op.allowTF32Attr(),
+                                               op.aFp8FormatAttr(),
+                                               op.bFp8FormatAttr(),
+                                               op.precisionAttr());
+    return success();
+  }
+};
+
+struct TritonSparseDotPattern
+    : public OpConversionPattern<triton::SparseDotOp> {
+  using OpConversionPattern<triton::SparseDotOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::SparseDotOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    RankedTensorType origType = op.getType().cast<RankedTensorType>();
+    auto typeConverter = getTypeConverter<TritonGPUTypeConverter>();
+    Attribute dEncoding = getDotMatEncoding(
+        getContext(), origType.getShape(), typeConverter->getNumWarps(),
+        typeConverter->getThreadsPerWarp());
+    RankedTensorType retType = RankedTensorType::get(
+        origType.getShape(), origType.getElementType(), dEncoding);
+    // a & b are dot operands, aMeta keeps its layout until the dot gets an
+    // mma layout
+    auto convert = [&](Value operand, unsigned opIdx) -> Value {
+      auto type = operand.getType().cast<RankedTensorType>();
+      if (type.getEncoding().isa<triton::gpu::DotOperandEncodingAttr>())
+        return operand;
+      Attribute encoding = triton::gpu::DotOperandEncodingAttr::get(
+          getContext(), opIdx, dEncoding);
+      auto dstType = RankedTensorType::get(type.getShape(),
+                                           type.getElementType(), encoding);
+      return rewriter.create<triton::gpu::ConvertLayoutOp>(operand.getLoc(),
+                                                           dstType, operand);
+    };
+    Value a = convert(adaptor.a(), 0);
+    Value b = convert(adaptor.b(), 1);
+    Value c = rewriter.create<triton::gpu::ConvertLayoutOp>(
+        op.getLoc(), retType, adaptor.c());
+    rewriter.replaceOpWithNewOp<triton::SparseDotOp>(op, retType, a,
+                                                     adaptor.aMeta(), b, c);
     return success();
   }
 };
@@ -284,11 +351,74 @@ struct TritonCatPattern : public OpConversionPattern<triton::CatOp> {
   LogicalResult
   matchAndRewrite(triton::CatOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
-    // For now, this behaves like generic, but this will evolve when
-    // we add support for `can_reorder=False`
-    Type retType = this->getTypeConverter()->convertType(op.getType());
-    rewriter.replaceOpWithNewOp<triton::CatOp>(op, retType,
-                                               adaptor.getOperands());
+    if (!op.axis()) {
+      Type retType = this->getTypeConverter()->convertType(op.getType());
+      rewriter.replaceOpWithNewOp<triton::CatOp>(op, retType, adaptor.lhs(),
+                                                 adaptor.rhs(), op.axisAttr());
+      return success();
+    }
+    // An ordered cat keeps the layout of its operands, so that the halves of
+    // the result are held by the threads holding the operands
+    Value lhs = adaptor.lhs();
+    Value rhs = adaptor.rhs();
+    auto lhsType = lhs.getType().cast<RankedTensorType>();
+    if (rhs.getType() != lhsType)
+      rhs = rewriter.create<triton::gpu::ConvertLayoutOp>(rhs.getLoc(),
+                                                          lhsType, rhs);
+    auto retType = RankedTensorType::get(
+        op.getType().cast<RankedTensorType>().getShape(),
+        lhsType.getElementType(), lhsType.getEncoding());
+    rewriter.replaceOpWithNewOp<triton::CatOp>(op, retType, lhs, rhs,
+                                               op.axisAttr());
+    return success();
+  }
+};
+
+struct TritonJoinPattern : public OpConversionPattern<triton::JoinOp> {
+
+  using OpConversionPattern<triton::JoinOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::JoinOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // the result layout is inferred from the layout of the operands
+    Value lhs = adaptor.lhs();
+    Value rhs = adaptor.rhs();
+    if (rhs.getType() != lhs.getType())
+      rhs = rewriter.create<triton::gpu::ConvertLayoutOp>(rhs.getLoc(),
+                                                          lhs.getType(), rhs);
+    rewriter.replaceOpWithNewOp<triton::JoinOp>(op, lhs, rhs);
+    return success();
+  }
+};
+
+struct TritonSplitPattern : public OpConversionPattern<triton::SplitOp> {
+
+  using OpConversionPattern<triton::SplitOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::SplitOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // the operand is given the layout the results would be joined in
+    auto retType = this->getTypeConverter()
+                       ->convertType(op.outLHS().getType())
+                       .cast<RankedTensorType>();
+    auto argType = adaptor.src().getType().cast<RankedTensorType>();
+    Attribute argEncoding;
+    auto &dialect = retType.getEncoding().getDialect();
+    if (cast<triton::DialectInferLayoutInterface>(&dialect)
+            ->inferJoinOpEncoding(retType.getEncoding(), argEncoding,
+                                  op.getLoc())
+            .failed())
+      return failure();
+    Value src = adaptor.src();
+    if (argType.getEncoding() != argEncoding)
+      src = rewriter.create<triton::gpu::ConvertLayoutOp>(
+          op.getLoc(),
+          RankedTensorType::get(argType.getShape(), argType.getElementType(),
+                                argEncoding),
+          src);
+    rewriter.replaceOpWithNewOp<triton::SplitOp>(op, src);
     return success();
   }
 };
@@ -334,7 +464,7 @@ struct TritonLoadPattern : public OpConversionPattern<triton::LoadOp> {
     rewriter.replaceOpWithNewOp<triton::LoadOp>(
         op, typeConverter->convertType(op.getType()), adaptor.ptr(),
         adaptor.mask(), adaptor.other(), adaptor.cache(), adaptor.evict(),
-        adaptor.isVolatile());
+        adaptor.isVolatile(), op.l2EvictLastFractionAttr());
     return success();
   }
 };
@@ -346,7 +476,8 @@ struct TritonStorePattern : public OpConversionPattern<triton::StoreOp> {
   matchAndRewrite(triton::StoreOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
     rewriter.replaceOpWithNewOp<triton::StoreOp>(
-        op, adaptor.ptr(), adaptor.value(), adaptor.mask());
+        op, adaptor.ptr(), adaptor.value(), adaptor.mask(), adaptor.cache(),
+        adaptor.evict());
     return success();
   }
 };
@@ -359,8 +490,8 @@ struct TritonAtomicCASPattern
   matchAndRewrite(triton::AtomicCASOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
     rewriter.replaceOpWithNewOp<triton::AtomicCASOp>(
-        op, typeConverter->convertType(op.getType()), adaptor.ptr(),
-        adaptor.cmp(), adaptor.val());
+        op, typeConverter->convertType(op.getType()), adaptor.getOperands(),
+        op->getAttrs());
     return success();
   }
 };
@@ -373,8 +504,8 @@ struct TritonAtomicRMWPattern
   matchAndRewrite(triton::AtomicRMWOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
     rewriter.replaceOpWithNewOp<triton::AtomicRMWOp>(
-        op, typeConverter->convertType(op.getType()), adaptor.atomic_rmw_op(),
-        adaptor.ptr(), adaptor.val(), adaptor.mask());
+        op, typeConverter->convertType(op.getType()), adaptor.getOperands(),
+        op->getAttrs());
     return success();
   }
 };
@@ -393,6 +524,27 @@ struct TritonExtElemwisePattern
   }
 };
 
+struct TritonPhiloxPattern : public OpConversionPattern<triton::PhiloxOp> {
+  using OpConversionPattern<triton::PhiloxOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::PhiloxOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // the counters, the keys and the results all have the same layout
+    Type retType = getTypeConverter()->convertType(op.out0().getType());
+    SmallVector<Value> operands;
+    for (Value operand : adaptor.getOperands()) {
+      if (operand.getType() != retType)
+        operand = rewriter.create<triton::gpu::ConvertLayoutOp>(
+            operand.getLoc(), retType, operand);
+      operands.push_back(operand);
+    }
+    rewriter.replaceOpWithNewOp<triton::PhiloxOp>(
+        op, SmallVector<Type>(4, retType), operands, op->getAttrs());
+    return success();
+  }
+};
+
 template <class Op>
 struct TritonGenericPattern : public OpConversionPattern<Op> {
   using OpConversionPattern<Op>::OpConversionPattern;
@@ -401,7 +553,8 @@ struct TritonGenericPattern : public OpConversionPattern<Op> {
   matchAndRewrite(Op op, typename Op::Adaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
     Type retType = this->getTypeConverter()->convertType(op.getType());
-    rewriter.replaceOpWithNewOp<Op>(op, retType, adaptor.getOperands());
+    rewriter.replaceOpWithNewOp<Op>(op, retType, adaptor.getOperands(),
+                                    op->getAttrs());
     return success();
   }
 };
@@ -440,6 +593,53 @@ struct TritonReducePattern : public OpConversionPattern<triton::ReduceOp> {
   }
 };
 
+struct TritonGenericReducePattern
+    : public OpConversionPattern<triton::GenericReduceOp> {
+  using OpConversionPattern<triton::GenericReduceOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::GenericReduceOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // The combine function works on scalars and is moved over as is
+    auto newReduce = rewriter.create<triton::GenericReduceOp>(
+        op.getLoc(), adaptor.operands(), adaptor.axis());
+    rewriter.inlineRegionBefore(op.combineOp(), newReduce.combineOp(),
+                                newReduce.combineOp().end());
+    rewriter.replaceOp(op, newReduce.getResults());
+    return success();
+  }
+};
+
+struct TritonScanPattern : public OpConversionPattern<triton::ScanOp> {
+  using OpConversionPattern<triton::ScanOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::ScanOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto newScan = rewriter.create<triton::ScanOp>(
+        op.getLoc(), adaptor.operands(), adaptor.axis(), adaptor.reverse());
+    rewriter.inlineRegionBefore(op.combineOp(), newScan.combineOp(),
+                                newScan.combineOp().end());
+    rewriter.replaceOp(op, newScan.getResults());
+    return success();
+  }
+};
+
+struct TritonSortPattern : public OpConversionPattern<triton::SortOp> {
+  using OpConversionPattern<triton::SortOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::SortOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // the results take the layout of the operands
+    auto newSort = rewriter.create<triton::SortOp>(
+        op.getLoc(), adaptor.operands(), op.axisAttr(), op.descendingAttr(),
+        op.kAttr());
+    rewriter.replaceOp(op, newSort.getResults());
+    return success();
+  }
+};
+
 struct TritonPrintfPattern : public OpConversionPattern<triton::PrintfOp> {
   using OpConversionPattern<PrintfOp>::OpConversionPattern;
 
@@ -452,6 +652,18 @@ struct TritonPrintfPattern : public OpConversionPattern<triton::PrintfOp> {
   }
 };
 
+struct TritonTracePattern : public OpConversionPattern<triton::TraceOp> {
+  using OpConversionPattern<TraceOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(TraceOp op, typename TraceOp::Adaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOpWithNewOp<triton::TraceOp>(op, op.prefixAttr(),
+                                                 adaptor.getOperands());
+    return success();
+  }
+};
+
 void populateTritonPatterns(TritonGPUTypeConverter &typeConverter,
                             RewritePatternSet &patterns) {
   MLIRContext *context = patterns.getContext();
@@ -463,9 +675,12 @@ void populateTritonPatterns(TritonGPUTypeConverter &typeConverter,
       TritonGenericPattern<triton::PtrToIntOp>,
       TritonGenericPattern<triton::SplatOp>, TritonBroadcastPattern,
       TritonGenericPattern<triton::AddPtrOp>, TritonCatPattern,
-      TritonReducePattern, TritonTransPattern, TritonExpandDimsPattern,
-      TritonMakeRangePattern, TritonDotPattern, TritonLoadPattern,
-      TritonStorePattern, TritonExtElemwisePattern, TritonPrintfPattern,
+      TritonJoinPattern, TritonSplitPattern, TritonReducePattern,
+      TritonGenericReducePattern, TritonScanPattern, TritonSortPattern,
+      TritonTransPattern, TritonExpandDimsPattern, TritonMakeRangePattern,
+      TritonDotPattern, TritonSparseDotPattern, TritonLoadPattern,
+      TritonStorePattern, TritonExtElemwisePattern, TritonPhiloxPattern,
+      TritonPrintfPattern, TritonTracePattern,
       TritonAtomicRMWPattern>(typeConverter, context);
 }
 
@@ -672,13 +887,23 @@ class ConvertTritonToTritonGPU
 public:
   ConvertTritonToTritonGPU() = default;
   // constructor with some parameters set explicitly.
-  ConvertTritonToTritonGPU(int numWarps) { this->numWarps = numWarps; }
+  ConvertTritonToTritonGPU(int numWarps, int threadsPerWarp, int sharedBanks,
+                           int minBlocksPerSM, int maxRegisters,
+                           int wavesPerEU, int numCTAs) {
+    this->numWarps = numWarps;
+    this->threadsPerWarp = threadsPerWarp;
+    this->sharedBanks = sharedBanks;
+    this->minBlocksPerSM = minBlocksPerSM;
+    this->maxRegisters = maxRegisters;
+    this->wavesPerEU = wavesPerEU;
+    this->numCTAs = numCTAs;
+  }
 
   void runOnOperation() override {
     MLIRContext *context = &getContext();
     ModuleOp mod = getOperation();
     // type converter
-    TritonGPUTypeConverter typeConverter(context, numWarps);
+    TritonGPUTypeConverter typeConverter(context, numWarps, threadsPerWarp);
     TritonGPUConversionTarget target(*context, typeConverter);
     // rewrite patterns
     RewritePatternSet patterns(context);
@@ -701,6 +926,25 @@ public:
     mod->setAttr(
         AttrNumWarpsName,
         IntegerAttr::get(i32_ty, llvm::APInt(32, numWarps.getValue())));
+    mod->setAttr(
+        AttrThreadsPerWarpName,
+        IntegerAttr::get(i32_ty, llvm::APInt(32, threadsPerWarp.getValue())));
+    mod->setAttr(
+        AttrSharedBanksName,
+        IntegerAttr::get(i32_ty, llvm::APInt(32, sharedBanks.getValue())));
+    // launch bounds, lowered to annotations of the kernel function
+    auto setLaunchBound = [&](StringRef name, int value) {
+      if (value > 0)
+        mod->setAttr(name, IntegerAttr::get(i32_ty, llvm::APInt(32, value)));
+    };
+    setLaunchBound(AttrMinBlocksPerSMName, minBlocksPerSM.getValue());
+    setLaunchBound(AttrMaxRegistersName, maxRegisters.getValue());
+    setLaunchBound(AttrWavesPerEUName, wavesPerEU.getValue());
+    // thread block clusters, whose CTAs may share the tiles they load
+    if (numCTAs.getValue() > 1)
+      mod->setAttr(
+          AttrNumCTAsName,
+          IntegerAttr::get(i32_ty, llvm::APInt(32, numCTAs.getValue())));
 
     // update layouts
     //  broadcast src => multicast, dst => broadcasted
@@ -712,8 +956,16 @@ public:
 } // namespace
 
 std::unique_ptr<OperationPass<ModuleOp>>
-mlir::triton::createConvertTritonToTritonGPUPass(int numWarps) {
-  return std::make_unique<::ConvertTritonToTritonGPU>(numWarps);
+mlir::triton::createConvertTritonToTritonGPUPass(int numWarps,
+                                                 int threadsPerWarp,
+                                                 int sharedBanks,
+                                                 int minBlocksPerSM,
+                                                 int maxRegisters,
+                                                 int wavesPerEU,
+                                                 int numCTAs) {
+  return std::make_unique<::ConvertTritonToTritonGPU>(
+      numWarps, threadsPerWarp, sharedBanks, minBlocksPerSM, maxRegisters,
+      wavesPerEU, numCTAs);
 }
 
 std::unique_ptr<OperationPass<ModuleOp>>
@@ -5,6 +5,7 @@
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/TypeUtilities.h"
 
 namespace mlir {
 namespace triton {
@@ -107,7 +108,13 @@ ParseResult parseStoreOp(OpAsmParser &parser, OperationState &result) {
 void printStoreOp(OpAsmPrinter &printer, StoreOp storeOp) {
   printer << " ";
   printer << storeOp.getOperation()->getOperands();
-  printer.printOptionalAttrDict(storeOp->getAttrs(), /*elidedAttrs=*/{});
+  // Default cache/eviction hints are not printed.
+  SmallVector<StringRef, 2> elidedAttrs;
+  if (storeOp.cache() == CacheModifier::NONE)
+    elidedAttrs.push_back(storeOp.cacheAttrName());
+  if (storeOp.evict() == EvictionPolicy::NORMAL)
+    elidedAttrs.push_back(storeOp.evictAttrName());
+  printer.printOptionalAttrDict(storeOp->getAttrs(), elidedAttrs);
   printer << " : ";
   printer.printStrippedAttrOrType(storeOp.value().getType());
 }
@@ -139,9 +146,9 @@ bool FpToFpOp::areCastCompatible(::mlir::TypeRange inputs,
   }
   // Check whether fp8 <=> fp16, bf16, f32, f64
   // Make `srcEltType` always the fp8 side
-  if (dstEltType.dyn_cast<mlir::triton::Float8Type>())
+  if (mlir::triton::isFloat8(dstEltType))
     std::swap(srcEltType, dstEltType);
-  if (!srcEltType.dyn_cast<mlir::triton::Float8Type>())
+  if (!mlir::triton::isFloat8(srcEltType))
     return false;
   return dstEltType.isF16() || dstEltType.isBF16() || dstEltType.isF32() ||
          dstEltType.isF64();
@@ -153,6 +160,13 @@ void StoreOp::build(::mlir::OpBuilder &builder, ::mlir::OperationState &state,
   StoreOp::build(builder, state, ptr, value, mlir::Value());
 }
 
+void StoreOp::build(::mlir::OpBuilder &builder, ::mlir::OperationState &state,
+                    ::mlir::Value ptr, ::mlir::Value value,
+                    ::mlir::triton::CacheModifier cache,
+                    ::mlir::triton::EvictionPolicy evict) {
+  StoreOp::build(builder, state, ptr, value, mlir::Value(), cache, evict);
+}
+
 //-- LoadOp --
 static Type getLoadOpResultType(::mlir::OpBuilder &builder, Type ptrType) {
   auto ptrTensorType = ptrType.dyn_cast<RankedTensorType>();
@@ -206,6 +220,69 @@ void LoadOp::build(::mlir::OpBuilder &builder, ::mlir::OperationState &state,
   state.addTypes({resultType});
 }
 
+//-- Block pointer ops --
+// The tensor a block pointer points to a block of
+static RankedTensorType getPointeeTensorType(Value ptr) {
+  return ptr.getType()
+      .cast<PointerType>()
+      .getPointeeType()
+      .cast<RankedTensorType>();
+}
+
+static LogicalResult verifyBoundaryCheck(Operation *op, ArrayAttr boundaryCheck,
+                                         int64_t rank) {
+  for (auto dim : boundaryCheck.getAsValueRange<IntegerAttr>())
+    if (dim.getSExtValue() < 0 || dim.getSExtValue() >= rank)
+      return op->emitOpError("boundary check dimension out of range");
+  return success();
+}
+
+mlir::LogicalResult mlir::triton::MakeTensorPtrOp::verify() {
+  auto tensorType = getPointeeTensorType(result());
+  int64_t rank = tensorType.getRank();
+  if (static_cast<int64_t>(shape().size()) != rank)
+    return emitOpError("expected as many shape, strides and offsets values as "
+                       "dimensions of the block");
+  if (base().getType().cast<PointerType>().getPointeeType() !=
+      tensorType.getElementType())
+    return emitOpError("expected the base to point to the element type of the "
+                       "block");
+  SmallVector<bool> seen(rank, false);
+  if (static_cast<int64_t>(order().size()) != rank)
+    return emitOpError("expected the order to list every dimension once");
+  for (auto dim : order().getAsValueRange<IntegerAttr>()) {
+    int64_t d = dim.getSExtValue();
+    if (d < 0 || d >= rank || seen[d])
+      return emitOpError("expected the order to list every dimension once");
+    seen[d] = true;
+  }
+  return success();
+}
+
+mlir::LogicalResult mlir::triton::AdvanceOp::verify() {
+  if (static_cast<int64_t>(offsets().size()) !=
+      getPointeeTensorType(ptr()).getRank())
+    return emitOpError("expected an offset per dimension of the block");
+  return success();
+}
+
+mlir::LogicalResult mlir::triton::TensorPtrLoadOp::verify() {
+  auto tensorType = getPointeeTensorType(ptr());
+  if (result().getType() != tensorType)
+    return emitOpError("expected the result type to be the block type");
+  if (padding() == PaddingOption::PAD_NAN &&
+      !tensorType.getElementType().isa<FloatType>())
+    return emitOpError("NaN padding requires a floating-point block");
+  return verifyBoundaryCheck(*this, boundaryCheck(), tensorType.getRank());
+}
+
+mlir::LogicalResult mlir::triton::TensorPtrStoreOp::verify() {
+  auto tensorType = getPointeeTensorType(ptr());
+  if (value().getType() != tensorType)
+    return emitOpError("expected the value type to be the block type");
+  return verifyBoundaryCheck(*this, boundaryCheck(), tensorType.getRank());
+}
+
 //-- TransOp --
 mlir::LogicalResult mlir::triton::TransOp::inferReturnTypes(
     MLIRContext *context, Optional<Location> location, ValueRange operands,
@@ -258,6 +335,31 @@ mlir::LogicalResult mlir::triton::DotOp::inferReturnTypes(
   return mlir::success();
 }
 
+//-- SparseDotOp --
+mlir::LogicalResult mlir::triton::SparseDotOp::inferReturnTypes(
+    MLIRContext *context, Optional<Location> location, ValueRange operands,
+    DictionaryAttr attributes, RegionRange regions,
+    SmallVectorImpl<Type> &inferredReturnTypes) {
+  // type is the same as the accumulator
+  auto accTy = operands[3].getType().cast<RankedTensorType>();
+  inferredReturnTypes.push_back(accTy);
+
+  // verify encodings of $a and $b, $aMeta having its own
+  auto aEnc = operands[0].getType().cast<RankedTensorType>().getEncoding();
+  auto bEnc = operands[2].getType().cast<RankedTensorType>().getEncoding();
+  auto retEnc = accTy.getEncoding();
+  if (aEnc) {
+    assert(bEnc);
+    Dialect &dialect = aEnc.getDialect();
+    auto interface = dyn_cast<DialectInferLayoutInterface>(&dialect);
+    if (interface->inferDotOpEncoding(aEnc, 0, retEnc, location).failed())
+      return mlir::failure();
+    if (interface->inferDotOpEncoding(bEnc, 1, retEnc, location).failed())
+      return mlir::failure();
+  }
+  return mlir::success();
+}
+
 //-- ReduceOp --
 mlir::LogicalResult mlir::triton::ReduceOp::inferReturnTypes(
     MLIRContext *context, Optional<Location> location, ValueRange operands,
@@ -310,6 +412,153 @@ bool mlir::triton::ReduceOp::withIndex(mlir::triton::RedOp redOp) {
          redOp == mlir::triton::RedOp::ARGFMAX;
 }
 
+//-- GenericReduceOp --
+mlir::LogicalResult mlir::triton::GenericReduceOp::inferReturnTypes(
+    MLIRContext *context, Optional<Location> location, ValueRange operands,
+    DictionaryAttr attributes, RegionRange regions,
+    SmallVectorImpl<Type> &inferredReturnTypes) {
+  int axis = attributes.get("axis").cast<IntegerAttr>().getInt();
+  for (Value arg : operands) {
+    auto argTy = arg.getType().cast<RankedTensorType>();
+    auto retEltTy = argTy.getElementType();
+    auto retShape = argTy.getShape().vec();
+    retShape.erase(retShape.begin() + axis);
+    if (retShape.empty()) {
+      // 0d-tensor -> scalar
+      inferredReturnTypes.push_back(retEltTy);
+      continue;
+    }
+    // nd-tensor where n >= 1
+    Attribute argEncoding = argTy.getEncoding();
+    Attribute retEncoding;
+    if (argEncoding) {
+      Dialect &dialect = argEncoding.getDialect();
+      auto inferLayoutInterface =
+          dyn_cast<DialectInferLayoutInterface>(&dialect);
+      if (inferLayoutInterface
+              ->inferReduceOpEncoding(argEncoding, axis, retEncoding)
+              .failed()) {
+        llvm::report_fatal_error("failed to infer layout for ReduceOp");
+        return mlir::failure();
+      }
+    }
+    inferredReturnTypes.push_back(
+        RankedTensorType::get(retShape, retEltTy, retEncoding));
+  }
+  return mlir::success();
+}
+
+// The combine functions of generic reductions and scans take the accumulated
+// and the current element of every operand, and return the new accumulated
+// ones
+static mlir::LogicalResult verifyCombineRegion(Operation *op, Region &region,
+                                               ValueRange operands,
+                                               ValueRange returnValues) {
+  Block &block = region.front();
+  unsigned numOperands = operands.size();
+  if (block.getNumArguments() != 2 * numOperands)
+    return op->emitOpError("combine function must take ")
+           << 2 * numOperands << " arguments";
+  if (returnValues.size() != numOperands)
+    return op->emitOpError("combine function must return ")
+           << numOperands << " values";
+  for (unsigned i = 0; i < numOperands; ++i) {
+    Type elemTy = getElementTypeOrSelf(operands[i].getType());
+    if (block.getArgument(i).getType() != elemTy ||
+        block.getArgument(numOperands + i).getType() != elemTy ||
+        returnValues[i].getType() != elemTy)
+      return op->emitOpError("combine function of operand ")
+             << i << " must operate on " << elemTy;
+  }
+  return mlir::success();
+}
+
+mlir::LogicalResult mlir::triton::GenericReduceOp::verify() {
+  if (operands().empty())
+    return emitOpError("requires at least one operand");
+  auto rank = operands().front().getType().cast<RankedTensorType>().getRank();
+  if (axis() >= rank)
+    return emitOpError("reduction axis out of range");
+  auto terminator =
+      dyn_cast<GenericReduceReturnOp>(combineOp().front().getTerminator());
+  if (!terminator)
+    return emitOpError(
+        "combine function must be terminated by tt.generic_reduce.return");
+  return verifyCombineRegion(*this, combineOp(), operands(),
+                             terminator.result());
+}
+
+//-- ScanOp --
+mlir::LogicalResult mlir::triton::ScanOp::inferReturnTypes(
+    MLIRContext *context, Optional<Location> location, ValueRange operands,
+    DictionaryAttr attributes, RegionRange regions,
+    SmallVectorImpl<Type> &inferredReturnTypes) {
+  // types are the same as the inputs
+  for (Value arg : operands)
+    inferredReturnTypes.push_back(arg.getType());
+  return mlir::success();
+}
+
+mlir::LogicalResult mlir::triton::ScanOp::verify() {
+  if (operands().empty())
+    return emitOpError("requires at least one operand");
+  auto rank = operands().front().getType().cast<RankedTensorType>().getRank();
+  if (axis() >= rank)
+    return emitOpError("scan axis out of range");
+  auto terminator =
+      dyn_cast<ScanReturnOp>(combineOp().front().getTerminator());
+  if (!terminator)
+    return emitOpError("combine function must be terminated by tt.scan.return");
+  return verifyCombineRegion(*this, combineOp(), operands(),
+                             terminator.result());
+}
+
+//-- SortOp --
+mlir::LogicalResult mlir::triton::SortOp::inferReturnTypes(
+    MLIRContext *context, Optional<Location> location, ValueRange operands,
+    DictionaryAttr attributes, RegionRange regions,
+    SmallVectorImpl<Type> &inferredReturnTypes) {
+  // the axis is shortened to k for a top-k
+  int axis = attributes.get("axis").cast<IntegerAttr>().getInt();
+  auto k = attributes.get("k").dyn_cast_or_null<IntegerAttr>();
+  for (Value arg : operands) {
+    auto argTy = arg.getType().cast<RankedTensorType>();
+    auto retShape = argTy.getShape().vec();
+    if (k)
+      retShape[axis] = k.getInt();
+    inferredReturnTypes.push_back(RankedTensorType::get(
+        retShape, argTy.getElementType(), argTy.getEncoding()));
+  }
+  return mlir::success();
+}
+
+mlir::LogicalResult mlir::triton::SortOp::verify() {
+  if (operands().empty())
+    return emitOpError("requires at least one operand");
+  auto keyTy = operands().front().getType().cast<RankedTensorType>();
+  if (axis() >= keyTy.getRank())
+    return emitOpError("sort axis out of range");
+  int64_t size = keyTy.getShape()[axis()];
+  if (!llvm::isPowerOf2_64(size))
+    return emitOpError("the size of the sort axis must be a power of 2");
+  if (k() && (*k() == 0 || *k() > size || !llvm::isPowerOf2_32(*k())))
+    return emitOpError("k must be a power of 2 no larger than the sort axis");
+  auto keyEltTy = keyTy.getElementType();
+  if (!keyEltTy.isa<FloatType>() && !keyEltTy.isSignlessInteger())
+    return emitOpError("sort keys must be floats or integers");
+  return mlir::success();
+}
+
+//-- ScratchOp --
+mlir::LogicalResult mlir::triton::ScratchOp::verify() {
+  // shared memory is address space 3
+  if (getType().cast<PointerType>().getAddressSpace() != 3)
+    return emitOpError("scratch buffers live in shared memory");
+  if (size() == 0)
+    return emitOpError("scratch buffers can't be empty");
+  return mlir::success();
+}
+
 //-- SplatOp --
 OpFoldResult SplatOp::fold(ArrayRef<Attribute> operands) {
   auto constOperand = src().getDefiningOp<arith::ConstantOp>();
@@ -349,6 +598,56 @@ mlir::LogicalResult mlir::triton::ExpandDimsOp::inferReturnTypes(
   return mlir::success();
 }
 
+//-- JoinOp --
+mlir::LogicalResult mlir::triton::JoinOp::inferReturnTypes(
+    MLIRContext *context, Optional<Location> loc, ValueRange operands,
+    DictionaryAttr attributes, RegionRange regions,
+    SmallVectorImpl<Type> &inferredReturnTypes) {
+  auto argTy = operands[0].getType().cast<RankedTensorType>();
+  auto retShape = argTy.getShape().vec();
+  retShape.push_back(2);
+  Attribute argEncoding = argTy.getEncoding();
+  Attribute retEncoding;
+  if (argEncoding) {
+    Dialect &dialect = argEncoding.getDialect();
+    auto inferLayoutInterface = dyn_cast<DialectInferLayoutInterface>(&dialect);
+    if (inferLayoutInterface
+            ->inferJoinOpEncoding(argEncoding, retEncoding, loc)
+            .failed())
+      return emitOptionalError(loc, "failed to infer layout for JoinOp");
+  }
+  inferredReturnTypes.push_back(
+      RankedTensorType::get(retShape, argTy.getElementType(), retEncoding));
+  return mlir::success();
+}
+
+//-- SplitOp --
+mlir::LogicalResult mlir::triton::SplitOp::inferReturnTypes(
+    MLIRContext *context, Optional<Location> loc, ValueRange operands,
+    DictionaryAttr attributes, RegionRange regions,
+    SmallVectorImpl<Type> &inferredReturnTypes) {
+  auto argTy = operands[0].getType().cast<RankedTensorType>();
+  if (argTy.getShape().back() != 2)
+    return emitOptionalError(loc, "SplitOp operand must have a trailing "
+                                  "dimension of size 2");
+  auto retShape = argTy.getShape().drop_back().vec();
+  Attribute argEncoding = argTy.getEncoding();
+  Attribute retEncoding;
+  if (argEncoding) {
+    Dialect &dialect = argEncoding.getDialect();
+    auto inferLayoutInterface = dyn_cast<DialectInferLayoutInterface>(&dialect);
+    if (inferLayoutInterface
+            ->inferSplitOpEncoding(argEncoding, retEncoding, loc)
+            .failed())
+      return emitOptionalError(loc, "failed to infer layout for SplitOp");
+  }
+  auto retTy =
+      RankedTensorType::get(retShape, argTy.getElementType(), retEncoding);
+  inferredReturnTypes.push_back(retTy);
+  inferredReturnTypes.push_back(retTy);
+  return mlir::success();
+}
+
 //-- BroadcastOp --
 OpFoldResult BroadcastOp::fold(ArrayRef<Attribute> operands) {
   auto constOperand = src().getDefiningOp<arith::ConstantOp>();
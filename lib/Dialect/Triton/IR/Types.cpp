@@ -27,13 +27,21 @@ Type PointerType::parse(AsmParser &parser) {
   if (parser.parseType(pointeeType))
     return Type();
 
+  // the address space is only printed when it isn't the global one
+  int addressSpace = 1;
+  if (succeeded(parser.parseOptionalComma()) &&
+      parser.parseInteger(addressSpace))
+    return Type();
+
   if (parser.parseGreater())
     return Type();
 
-  // TODO: also print address space?
-  return PointerType::get(pointeeType, 1);
+  return PointerType::get(pointeeType, addressSpace);
 }
 
 void PointerType::print(AsmPrinter &printer) const {
-  printer << "<" << getPointeeType() << ">";
+  printer << "<" << getPointeeType();
+  if (getAddressSpace() != 1)
+    printer << ", " << getAddressSpace();
+  printer << ">";
 }
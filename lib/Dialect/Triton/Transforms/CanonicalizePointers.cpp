@@ -0,0 +1,271 @@
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Pass/Pass.h"
+
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+//
+// This file implements the canonicalization of tensors of pointers into a
+// scalar base and a tensor of i32 offsets.
+//
+// Tensors of pointers are 64 bits per element, and loops advancing them
+// (`ptrs += BLOCK_K * stride`) carry them in registers from one iteration to
+// the next. A tensor of pointers made from a scalar pointer and i32 offsets
+//
+//   ptrs = addptr(splat(base), offsets)
+//
+// is instead kept as (base, offsets), advanced as such:
+//
+//   addptr(ptrs, splat(s))  ->  (addptr(base, s), offsets)
+//   addptr(ptrs, delta)     ->  (base, offsets + delta)   [int32 indexing]
+//
+// and carried as such by loops, the tensor of pointers being rebuilt where it
+// is used. Uniform increments only move the scalar base, and are always
+// exact. Adding non-uniform i32 increments could overflow the offsets, and is
+// only done if the kernel asserts that its offsets fit in 32 bits.
+//
+// A loop advancing its pointers by uniform increments then only carries the
+// scalar bases, the offsets being loop invariant.
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+bool isPointerTensor(Type type) {
+  if (auto tensorType = type.dyn_cast<RankedTensorType>())
+    return tensorType.getElementType().isa<triton::PointerType>();
+  return false;
+}
+
+bool isI32Tensor(Value value) {
+  if (auto tensorType = value.getType().dyn_cast<RankedTensorType>())
+    return tensorType.getElementType().isInteger(32);
+  return false;
+}
+
+// The value of every element of offset, if it is a splat
+bool isUniform(Value offset) {
+  if (offset.getDefiningOp<triton::SplatOp>())
+    return true;
+  if (auto constantOp = offset.getDefiningOp<arith::ConstantOp>())
+    if (auto attr = constantOp.getValue().dyn_cast<DenseElementsAttr>())
+      return attr.isSplat();
+  return false;
+}
+
+Value getUniformValue(OpBuilder &builder, Location loc, Value offset) {
+  if (auto splatOp = offset.getDefiningOp<triton::SplatOp>())
+    return splatOp.src();
+  auto attr = offset.getDefiningOp<arith::ConstantOp>()
+                  .getValue()
+                  .cast<DenseElementsAttr>();
+  return builder.create<arith::ConstantOp>(
+      loc, attr.getElementType(), attr.getSplatValue<Attribute>());
+}
+
+struct PtrInfo {
+  Value base;
+  Value offsets;
+};
+
+class PointerCanonicalizer {
+  bool int32Indexing;
+  DenseMap<Value, PtrInfo> infos;
+
+  bool canAdvance(Value offset) {
+    return isUniform(offset) || (int32Indexing && isI32Tensor(offset));
+  }
+
+  // whether the value yielded for arg only advances it
+  bool isAdvanced(BlockArgument arg, Value yielded) {
+    while (yielded != arg) {
+      auto addPtrOp = yielded.getDefiningOp<triton::AddPtrOp>();
+      if (!addPtrOp || addPtrOp->getBlock() != arg.getOwner() ||
+          !canAdvance(addPtrOp.offset()))
+        return false;
+      yielded = addPtrOp.ptr();
+    }
+    return true;
+  }
+
+  // the tensor of pointers, recorded as info
+  Value materialize(OpBuilder &builder, Location loc, Type type,
+                    PtrInfo info) {
+    Value ptrs = builder.create<triton::AddPtrOp>(
+        loc, type, builder.create<triton::SplatOp>(loc, type, info.base),
+        info.offsets);
+    infos[ptrs] = info;
+    return ptrs;
+  }
+
+  void rewriteAddPtr(triton::AddPtrOp addPtrOp);
+  void rewriteFor(scf::ForOp forOp, ArrayRef<unsigned> carriedArgs);
+
+public:
+  explicit PointerCanonicalizer(bool int32Indexing)
+      : int32Indexing(int32Indexing) {}
+
+  void rewriteBlock(Block *block);
+};
+
+void PointerCanonicalizer::rewriteAddPtr(triton::AddPtrOp addPtrOp) {
+  Value ptr = addPtrOp.ptr();
+  Value offset = addPtrOp.offset();
+  if (!isPointerTensor(ptr.getType()))
+    return;
+  // addptr(splat(base), offsets)
+  if (!infos.count(ptr)) {
+    if (auto splatOp = ptr.getDefiningOp<triton::SplatOp>())
+      if (isI32Tensor(offset))
+        infos[addPtrOp.result()] = {splatOp.src(), offset};
+    return;
+  }
+  if (!canAdvance(offset))
+    return;
+  OpBuilder builder(addPtrOp);
+  Location loc = addPtrOp.getLoc();
+  PtrInfo info = infos.lookup(ptr);
+  if (isUniform(offset)) {
+    Value scalar = getUniformValue(builder, loc, offset);
+    info.base = builder.create<triton::AddPtrOp>(loc, info.base.getType(),
+                                                 info.base, scalar);
+  } else {
+    info.offsets = builder.create<arith::AddIOp>(loc, info.offsets, offset);
+  }
+  Value ptrs = materialize(builder, loc, addPtrOp.getType(), info);
+  addPtrOp.result().replaceAllUsesWith(ptrs);
+  addPtrOp->erase();
+}
+
+void PointerCanonicalizer::rewriteFor(scf::ForOp forOp,
+                                      ArrayRef<unsigned> carriedArgs) {
+  // the bases and offsets of the carried args in place of them
+  SmallVector<Value> initArgs;
+  for (auto it : llvm::enumerate(forOp.getIterOperands())) {
+    if (llvm::is_contained(carriedArgs, it.index())) {
+      PtrInfo info = infos.lookup(it.value());
+      initArgs.push_back(info.base);
+      initArgs.push_back(info.offsets);
+    } else {
+      initArgs.push_back(it.value());
+    }
+  }
+  OpBuilder builder(forOp);
+  auto newForOp = builder.create<scf::ForOp>(
+      forOp.getLoc(), forOp.getLowerBound(), forOp.getUpperBound(),
+      forOp.getStep(), initArgs);
+  Block *body = forOp.getBody();
+  Block *newBody = newForOp.getBody();
+  newBody->getOperations().splice(newBody->end(), body->getOperations());
+  forOp.getInductionVar().replaceAllUsesWith(newForOp.getInductionVar());
+
+  builder.setInsertionPointToStart(newBody);
+  unsigned newIdx = 0;
+  for (auto it : llvm::enumerate(forOp.getRegionIterArgs())) {
+    Value arg = it.value();
+    if (!llvm::is_contained(carriedArgs, it.index())) {
+      arg.replaceAllUsesWith(newForOp.getRegionIterArgs()[newIdx++]);
+      continue;
+    }
+    PtrInfo info = {newForOp.getRegionIterArgs()[newIdx],
+                    newForOp.getRegionIterArgs()[newIdx + 1]};
+    newIdx += 2;
+    arg.replaceAllUsesWith(
+        materialize(builder, arg.getLoc(), arg.getType(), info));
+  }
+  rewriteBlock(newBody);
+
+  // the yielded pointers only advance the carried ones, and have been
+  // rewritten into bases and offsets
+  auto yieldOp = cast<scf::YieldOp>(newBody->getTerminator());
+  SmallVector<Value> yielded;
+  for (auto it : llvm::enumerate(yieldOp.getOperands())) {
+    if (llvm::is_contained(carriedArgs, it.index())) {
+      PtrInfo info = infos.lookup(it.value());
+      yielded.push_back(info.base);
+      yielded.push_back(info.offsets);
+    } else {
+      yielded.push_back(it.value());
+    }
+  }
+  builder.setInsertionPoint(yieldOp);
+  builder.create<scf::YieldOp>(yieldOp.getLoc(), yielded);
+  yieldOp->erase();
+
+  builder.setInsertionPointAfter(newForOp);
+  newIdx = 0;
+  for (auto it : llvm::enumerate(forOp.getResults())) {
+    Value result = it.value();
+    if (!llvm::is_contained(carriedArgs, it.index())) {
+      result.replaceAllUsesWith(newForOp.getResult(newIdx++));
+      continue;
+    }
+    PtrInfo info = {newForOp.getResult(newIdx), newForOp.getResult(newIdx + 1)};
+    newIdx += 2;
+    result.replaceAllUsesWith(
+        materialize(builder, forOp.getLoc(), result.getType(), info));
+  }
+  forOp->erase();
+}
+
+void PointerCanonicalizer::rewriteBlock(Block *block) {
+  for (Operation &op : llvm::make_early_inc_range(*block)) {
+    if (auto addPtrOp = dyn_cast<triton::AddPtrOp>(op)) {
+      rewriteAddPtr(addPtrOp);
+      continue;
+    }
+    if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+      auto yieldOp = cast<scf::YieldOp>(forOp.getBody()->getTerminator());
+      SmallVector<unsigned> carriedArgs;
+      for (auto it : llvm::enumerate(forOp.getRegionIterArgs())) {
+        unsigned idx = it.index();
+        if (isPointerTensor(it.value().getType()) &&
+            infos.count(forOp.getIterOperands()[idx]) &&
+            isAdvanced(it.value(), yieldOp.getOperand(idx)))
+          carriedArgs.push_back(idx);
+      }
+      if (!carriedArgs.empty()) {
+        rewriteFor(forOp, carriedArgs);
+        continue;
+      }
+    }
+    for (Region &region : op.getRegions())
+      for (Block &nested : region)
+        rewriteBlock(&nested);
+  }
+}
+
+} // anonymous namespace
+
+class CanonicalizePointersPass
+    : public TritonCanonicalizePointersBase<CanonicalizePointersPass> {
+public:
+  CanonicalizePointersPass() = default;
+  CanonicalizePointersPass(bool int32Indexing) {
+    this->int32Indexing = int32Indexing;
+  }
+
+  void runOnOperation() override {
+    ModuleOp mod = getOperation();
+    for (auto funcOp : llvm::to_vector(mod.getOps<mlir::FuncOp>())) {
+      PointerCanonicalizer canonicalizer(int32Indexing);
+      for (Block &block : funcOp.getBody())
+        canonicalizer.rewriteBlock(&block);
+    }
+  }
+};
+
+std::unique_ptr<mlir::Pass> mlir::triton::createCanonicalizePointersPass() {
+  return std::make_unique<CanonicalizePointersPass>();
+}
+
+std::unique_ptr<mlir::Pass>
+mlir::triton::createCanonicalizePointersPass(bool int32Indexing) {
+  return std::make_unique<CanonicalizePointersPass>(int32Indexing);
+}
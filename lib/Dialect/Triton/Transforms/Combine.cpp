@@ -1,13 +1,16 @@
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/TypeUtilities.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Support/LogicalResult.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "llvm/Support/MathExtras.h"
 
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/Triton/Transforms/Passes.h"
 
+#include <limits>
 #include <memory>
 
 using namespace mlir;
@@ -69,6 +72,7 @@ public:
 
     mlir::Value trueValue = selectOp.getTrueValue();
     mlir::Value falseValue = selectOp.getFalseValue();
+    mlir::Value condition = selectOp.getCondition();
 
     auto *loadOpCandidate = trueValue.getDefiningOp();
     auto loadOp = llvm::dyn_cast_or_null<triton::LoadOp>(loadOpCandidate);
@@ -79,15 +83,353 @@ public:
     if (!mask)
       return mlir::failure();
 
-    auto *broadcastOpCandidate = mask.getDefiningOp();
-    auto broadcastOp =
-        llvm::dyn_cast_or_null<triton::BroadcastOp>(broadcastOpCandidate);
-    if (!broadcastOp)
-      return mlir::failure();
+    // The load must be masked by the condition of the select, so that the
+    // elements it doesn't load are exactly those the select replaces
+    if (mask != condition) {
+      auto *maskOp = mask.getDefiningOp();
+      if (!llvm::isa_and_nonnull<triton::BroadcastOp, triton::SplatOp>(
+              maskOp) ||
+          maskOp->getOperand(0) != condition)
+        return mlir::failure();
+    }
 
     rewriter.replaceOpWithNewOp<triton::LoadOp>(
-        op, loadOp.ptr(), loadOp.mask(), falseValue, loadOp.cache(),
-        loadOp.evict(), loadOp.isVolatile());
+        op, loadOp.getType(), loadOp.ptr(), loadOp.mask(), falseValue,
+        loadOp.cache(), loadOp.evict(), loadOp.isVolatile(),
+        loadOp.l2EvictLastFractionAttr());
+    return mlir::success();
+  }
+};
+
+// addptr(addptr(ptr, idx0), idx1) => addptr(ptr, idx0 + idx1)
+//
+// Each addptr extends its offset to 64 bits, so the offsets are added as 64
+// bit integers if either of them is. Narrower offsets are only combined if
+// they are constants whose sum doesn't overflow.
+class CombineAddPtrPattern
+    : public mlir::OpRewritePattern<triton::AddPtrOp> {
+public:
+  CombineAddPtrPattern(mlir::MLIRContext *context)
+      : OpRewritePattern<triton::AddPtrOp>(context, 1) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(triton::AddPtrOp addPtrOp,
+                  mlir::PatternRewriter &rewriter) const override {
+    auto innerOp = addPtrOp.ptr().getDefiningOp<triton::AddPtrOp>();
+    // The inner addptr is kept alive by its other users
+    if (!innerOp || !innerOp->hasOneUse())
+      return mlir::failure();
+
+    Location loc = addPtrOp.getLoc();
+    Value idx0 = innerOp.offset();
+    Value idx1 = addPtrOp.offset();
+    unsigned width0 =
+        getElementTypeOrSelf(idx0.getType()).getIntOrFloatBitWidth();
+    unsigned width1 =
+        getElementTypeOrSelf(idx1.getType()).getIntOrFloatBitWidth();
+    unsigned width = std::max(width0, width1);
+
+    Value offset;
+    if (width == 64) {
+      idx0 = extendOffset(rewriter, loc, idx0, idx1.getType(), width0, width1);
+      idx1 = extendOffset(rewriter, loc, idx1, idx0.getType(), width1, width0);
+      offset = rewriter.create<arith::AddIOp>(loc, idx0, idx1);
+    } else {
+      APInt cst0, cst1;
+      if (!matchPattern(idx0, m_ConstantInt(&cst0)) ||
+          !matchPattern(idx1, m_ConstantInt(&cst1)))
+        return mlir::failure();
+      bool overflow;
+      APInt sum = cst0.sext(width).sadd_ov(cst1.sext(width), overflow);
+      if (overflow)
+        return mlir::failure();
+      Type type = width0 >= width1 ? idx0.getType() : idx1.getType();
+      Attribute value =
+          rewriter.getIntegerAttr(getElementTypeOrSelf(type), sum);
+      if (auto tensorType = type.dyn_cast<RankedTensorType>())
+        value = DenseElementsAttr::get(tensorType, value);
+      offset = rewriter.create<arith::ConstantOp>(loc, type, value);
+    }
+    rewriter.replaceOpWithNewOp<triton::AddPtrOp>(
+        addPtrOp, addPtrOp.getType(), innerOp.ptr(), offset);
+    return mlir::success();
+  }
+
+private:
+  // idx, sign extended to the type of other if it is narrower
+  static Value extendOffset(PatternRewriter &rewriter, Location loc, Value idx,
+                            Type otherType, unsigned width,
+                            unsigned otherWidth) {
+    if (width >= otherWidth)
+      return idx;
+    return rewriter.create<arith::ExtSIOp>(loc, otherType, idx);
+  }
+};
+
+// The range [min, max] of the signed values of an integer, or None if it
+// isn't known. Only constants, ranges and their sums are followed.
+Optional<std::pair<int64_t, int64_t>> getSignedRange(Value value,
+                                                     unsigned depth = 0) {
+  Type elementType = getElementTypeOrSelf(value.getType());
+  if (depth > 8 || !elementType.isSignlessInteger() ||
+      elementType.getIntOrFloatBitWidth() > 64)
+    return llvm::None;
+  unsigned width = elementType.getIntOrFloatBitWidth();
+
+  Attribute attr;
+  if (matchPattern(value, m_Constant(&attr))) {
+    if (auto intAttr = attr.dyn_cast<IntegerAttr>()) {
+      int64_t v = intAttr.getValue().getSExtValue();
+      return std::make_pair(v, v);
+    }
+    auto denseAttr = attr.dyn_cast<DenseIntElementsAttr>();
+    if (!denseAttr || denseAttr.getNumElements() == 0)
+      return llvm::None;
+    int64_t min = std::numeric_limits<int64_t>::max();
+    int64_t max = std::numeric_limits<int64_t>::min();
+    for (const APInt &v : denseAttr.getValues<APInt>()) {
+      min = std::min(min, v.getSExtValue());
+      max = std::max(max, v.getSExtValue());
+    }
+    return std::make_pair(min, max);
+  }
+
+  Operation *op = value.getDefiningOp();
+  if (!op)
+    return llvm::None;
+  if (auto makeRangeOp = llvm::dyn_cast<triton::MakeRangeOp>(op)) {
+    int64_t start = makeRangeOp.start();
+    int64_t end = makeRangeOp.end();
+    if (end <= start)
+      return llvm::None;
+    return std::make_pair(start, end - 1);
+  }
+  if (llvm::isa<triton::SplatOp, triton::BroadcastOp, triton::ExpandDimsOp,
+                triton::ViewOp, arith::ExtSIOp>(op))
+    return getSignedRange(op->getOperand(0), depth + 1);
+  if (llvm::isa<arith::AddIOp, arith::SubIOp>(op)) {
+    auto lhs = getSignedRange(op->getOperand(0), depth + 1);
+    auto rhs = getSignedRange(op->getOperand(1), depth + 1);
+    if (!lhs || !rhs)
+      return llvm::None;
+    if (llvm::isa<arith::SubIOp>(op))
+      rhs = std::make_pair(-rhs->second, -rhs->first);
+    int64_t min, max;
+    if (llvm::AddOverflow(lhs->first, rhs->first, min) ||
+        llvm::AddOverflow(lhs->second, rhs->second, max) ||
+        min < llvm::minIntN(width) || max > llvm::maxIntN(width))
+      return llvm::None;
+    return std::make_pair(min, max);
+  }
+  return llvm::None;
+}
+
+// cmpi(lhs, rhs) => splat(true) or splat(false)
+//   if the ranges of lhs and rhs decide the comparison, e.g.
+//   make_range(0, 128) < splat(128). The masked loads and stores are then
+//   canonicalized.
+class FoldDecidedCmpIPattern : public mlir::OpRewritePattern<arith::CmpIOp> {
+public:
+  FoldDecidedCmpIPattern(mlir::MLIRContext *context)
+      : OpRewritePattern<arith::CmpIOp>(context, 1) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(arith::CmpIOp cmpOp,
+                  mlir::PatternRewriter &rewriter) const override {
+    auto lhs = getSignedRange(cmpOp.getLhs());
+    auto rhs = getSignedRange(cmpOp.getRhs());
+    if (!lhs || !rhs)
+      return mlir::failure();
+    auto decided = decide(cmpOp.getPredicate(), *lhs, *rhs);
+    if (!decided)
+      return mlir::failure();
+
+    Type type = cmpOp.getType();
+    Attribute value = rewriter.getBoolAttr(*decided);
+    if (auto tensorType = type.dyn_cast<RankedTensorType>())
+      value = DenseElementsAttr::get(tensorType, *decided);
+    rewriter.replaceOpWithNewOp<arith::ConstantOp>(cmpOp, type, value);
+    return mlir::success();
+  }
+
+private:
+  using Range = std::pair<int64_t, int64_t>;
+
+  static Optional<bool> decide(arith::CmpIPredicate predicate, Range lhs,
+                               Range rhs) {
+    // Non-negative values compare the same as signed and unsigned integers
+    bool nonNegative = lhs.first >= 0 && rhs.first >= 0;
+    switch (predicate) {
+    case arith::CmpIPredicate::eq:
+      if (lhs.first == lhs.second && lhs == rhs)
+        return true;
+      if (lhs.second < rhs.first || rhs.second < lhs.first)
+        return false;
+      return llvm::None;
+    case arith::CmpIPredicate::ne:
+      if (auto eq = decide(arith::CmpIPredicate::eq, lhs, rhs))
+        return !*eq;
+      return llvm::None;
+    case arith::CmpIPredicate::ult:
+      if (!nonNegative)
+        return llvm::None;
+      LLVM_FALLTHROUGH;
+    case arith::CmpIPredicate::slt:
+      if (lhs.second < rhs.first)
+        return true;
+      if (lhs.first >= rhs.second)
+        return false;
+      return llvm::None;
+    case arith::CmpIPredicate::ule:
+      if (!nonNegative)
+        return llvm::None;
+      LLVM_FALLTHROUGH;
+    case arith::CmpIPredicate::sle:
+      if (lhs.second <= rhs.first)
+        return true;
+      if (lhs.first > rhs.second)
+        return false;
+      return llvm::None;
+    case arith::CmpIPredicate::ugt:
+      return decide(arith::CmpIPredicate::ult, rhs, lhs);
+    case arith::CmpIPredicate::sgt:
+      return decide(arith::CmpIPredicate::slt, rhs, lhs);
+    case arith::CmpIPredicate::uge:
+      return decide(arith::CmpIPredicate::ule, rhs, lhs);
+    case arith::CmpIPredicate::sge:
+      return decide(arith::CmpIPredicate::sle, rhs, lhs);
+    }
+    return llvm::None;
+  }
+};
+
+// op(splat(a), splat(b))         => splat(op(a, b))
+// op(broadcast(a), broadcast(b)) => broadcast(op(a, b))
+//   for the elementwise arith and math ops, the other operands being splat
+//   constants. The op then runs on the smaller operands.
+class SinkElementwiseOfBroadcastPattern : public mlir::RewritePattern {
+public:
+  SinkElementwiseOfBroadcastPattern(mlir::MLIRContext *context)
+      : mlir::RewritePattern(MatchAnyOpTypeTag(), 1, context) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::Operation *op,
+                  mlir::PatternRewriter &rewriter) const override {
+    if (!llvm::isa_and_nonnull<arith::ArithmeticDialect, math::MathDialect>(
+            op->getDialect()) ||
+        !op->hasTrait<OpTrait::Elementwise>() || op->getNumResults() != 1 ||
+        op->getNumOperands() == 0 || op->getNumRegions() != 0)
+      return mlir::failure();
+    auto resultType = op->getResult(0).getType().dyn_cast<RankedTensorType>();
+    if (!resultType)
+      return mlir::failure();
+
+    // The type of the operands before their broadcast, a scalar for splats
+    Type srcType;
+    for (Value operand : op->getOperands()) {
+      Operation *defOp = operand.getDefiningOp();
+      if (!defOp || !llvm::isa<triton::SplatOp, triton::BroadcastOp>(defOp))
+        continue;
+      Type type = defOp->getOperand(0).getType();
+      if (srcType && srcType != type)
+        return mlir::failure();
+      srcType = type;
+    }
+    if (!srcType)
+      return mlir::failure();
+    auto srcTensorType = srcType.dyn_cast<RankedTensorType>();
+
+    SmallVector<Value> operands;
+    for (Value operand : op->getOperands()) {
+      Operation *defOp = operand.getDefiningOp();
+      if (defOp && llvm::isa<triton::SplatOp, triton::BroadcastOp>(defOp)) {
+        operands.push_back(defOp->getOperand(0));
+        continue;
+      }
+      DenseElementsAttr attr;
+      if (!matchPattern(operand, m_Constant(&attr)) || !attr.isSplat())
+        return mlir::failure();
+      Type elementType = attr.getType().getElementType();
+      Type type = elementType;
+      Attribute value = attr.getSplatValue<Attribute>();
+      if (srcTensorType) {
+        type = RankedTensorType::get(srcTensorType.getShape(), elementType,
+                                     srcTensorType.getEncoding());
+        value = DenseElementsAttr::get(type.cast<ShapedType>(), value);
+      }
+      operands.push_back(
+          rewriter.create<arith::ConstantOp>(op->getLoc(), type, value));
+    }
+
+    Type newType = resultType.getElementType();
+    if (srcTensorType)
+      newType = RankedTensorType::get(srcTensorType.getShape(), newType,
+                                      srcTensorType.getEncoding());
+    OperationState state(op->getLoc(), op->getName());
+    state.addOperands(operands);
+    state.addTypes(newType);
+    state.addAttributes(op->getAttrs());
+    Value newResult = rewriter.createOperation(state)->getResult(0);
+    if (srcTensorType)
+      rewriter.replaceOpWithNewOp<triton::BroadcastOp>(op, resultType,
+                                                       newResult);
+    else
+      rewriter.replaceOpWithNewOp<triton::SplatOp>(op, resultType, newResult);
+    return mlir::success();
+  }
+};
+
+// expand_dims(splat(a)) => splat(a)
+// broadcast(splat(a))   => splat(a)
+// view(splat(a))        => splat(a)
+// and the same for splat constants
+template <typename OpTy>
+class HoistSplatPattern : public mlir::OpRewritePattern<OpTy> {
+public:
+  HoistSplatPattern(mlir::MLIRContext *context)
+      : mlir::OpRewritePattern<OpTy>(context, 1) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(OpTy op, mlir::PatternRewriter &rewriter) const override {
+    auto resultType = op.getType().template cast<RankedTensorType>();
+    Value src = op->getOperand(0);
+    if (auto splatOp = src.getDefiningOp<triton::SplatOp>()) {
+      rewriter.replaceOpWithNewOp<triton::SplatOp>(op, resultType,
+                                                   splatOp.src());
+      return mlir::success();
+    }
+    DenseElementsAttr attr;
+    if (matchPattern(src, m_Constant(&attr)) && attr.isSplat()) {
+      rewriter.replaceOpWithNewOp<arith::ConstantOp>(
+          op, resultType,
+          DenseElementsAttr::get(resultType, attr.getSplatValue<Attribute>()));
+      return mlir::success();
+    }
+    return mlir::failure();
+  }
+};
+
+// broadcast(broadcast(a)) => broadcast(a)
+// broadcast(a)            => a, if a has the type of the result
+class CombineBroadcastBroadcastPattern
+    : public mlir::OpRewritePattern<triton::BroadcastOp> {
+public:
+  CombineBroadcastBroadcastPattern(mlir::MLIRContext *context)
+      : OpRewritePattern<triton::BroadcastOp>(context, 1) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(triton::BroadcastOp broadcastOp,
+                  mlir::PatternRewriter &rewriter) const override {
+    Value src = broadcastOp.src();
+    if (src.getType() == broadcastOp.getType()) {
+      rewriter.replaceOp(broadcastOp, src);
+      return mlir::success();
+    }
+    auto srcOp = src.getDefiningOp<triton::BroadcastOp>();
+    if (!srcOp)
+      return mlir::failure();
+    rewriter.replaceOpWithNewOp<triton::BroadcastOp>(
+        broadcastOp, broadcastOp.getType(), srcOp.src());
     return mlir::success();
   }
 };
@@ -119,7 +461,8 @@ struct CanonicalizeMaskedLoadPattern
       // mask = splat(1)
       rewriter.replaceOpWithNewOp<triton::LoadOp>(
           loadOp, loadOp.getType(), loadOp.ptr(), Value(), Value(),
-          loadOp.cache(), loadOp.evict(), loadOp.isVolatile());
+          loadOp.cache(), loadOp.evict(), loadOp.isVolatile(),
+          loadOp.l2EvictLastFractionAttr());
     } else {
       // mask = splat(0)
 
@@ -164,8 +507,9 @@ struct CanonicalizeMaskedStorePattern
 
     if (splatMask.getSplatValue<IntegerAttr>().getValue() == true) {
       // mask = splat(1)
-      rewriter.replaceOpWithNewOp<triton::StoreOp>(storeOp, storeOp.ptr(),
-                                                   storeOp.value());
+      rewriter.replaceOpWithNewOp<triton::StoreOp>(
+          storeOp, storeOp.ptr(), storeOp.value(), storeOp.cache(),
+          storeOp.evict());
     } else {
       // mask = splat(0)
       rewriter.eraseOp(storeOp);
@@ -196,8 +540,20 @@ public:
     patterns.add<CombineDotAddFRevPattern>(context);
     // %}
     patterns.add<CombineSelectMaskedLoadPattern>(context);
-    // patterns.add<CombineAddPtrPattern>(context);
+    patterns.add<CombineAddPtrPattern>(context);
     patterns.add<CombineBroadcastConstantPattern>(context);
+    // Masks %{
+    patterns.add<FoldDecidedCmpIPattern>(context);
+    patterns.add<CanonicalizeMaskedLoadPattern>(context);
+    patterns.add<CanonicalizeMaskedStorePattern>(context);
+    // %}
+    // Broadcasts %{
+    patterns.add<SinkElementwiseOfBroadcastPattern>(context);
+    patterns.add<HoistSplatPattern<triton::ExpandDimsOp>>(context);
+    patterns.add<HoistSplatPattern<triton::BroadcastOp>>(context);
+    patterns.add<HoistSplatPattern<triton::ViewOp>>(context);
+    patterns.add<CombineBroadcastBroadcastPattern>(context);
+    // %}
 
     if (applyPatternsAndFoldGreedily(m, std::move(patterns)).failed())
       signalPassFailure();
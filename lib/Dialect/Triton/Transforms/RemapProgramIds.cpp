@@ -0,0 +1,204 @@
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Pass/Pass.h"
+
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+//
+// This file implements the remapping of the program ids of 2D grids to a
+// cache-friendlier order.
+//
+// Programs are scheduled roughly in the order of their linear id
+// pid0 + pid1 * n0. The prologue of the kernel computes the coordinates of
+// the program of that rank in the requested traversal, and replaces the uses
+// of get_program_id(0) and get_program_id(1) by these:
+//
+//   grouped:  rows are processed by groups of G, column-major within a group
+//     width = G * n1; first = (L / width) * G; size = min(n0 - first, G)
+//     pid0 = first + (L % width) % size; pid1 = (L % width) / size
+//
+//   hilbert:  the d2xy mapping of a Hilbert curve over the n0 x n0 grid, for
+//     power of two n0 == n1, and the grouped order otherwise
+//
+// Both are permutations of the grid, so the programs are otherwise unchanged
+// and the ids are opaque scalars for the axis analysis either way.
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+// Hilbert curves of grids of up to 2^16 programs per side
+constexpr int kMaxHilbertLevels = 16;
+
+class ProgramIdRemapper {
+  OpBuilder &builder;
+  Location loc;
+
+  Value i32(int64_t value) {
+    return builder.create<arith::ConstantIntOp>(loc, value, 32);
+  }
+
+public:
+  ProgramIdRemapper(OpBuilder &builder, Location loc)
+      : builder(builder), loc(loc) {}
+
+  std::pair<Value, Value> grouped(Value linearId, Value n0, Value n1,
+                                  int groupSize);
+
+  std::pair<Value, Value> hilbert(Value linearId, Value n);
+};
+
+std::pair<Value, Value> ProgramIdRemapper::grouped(Value linearId, Value n0,
+                                                   Value n1, int groupSize) {
+  Value g = i32(groupSize);
+  Value width = builder.create<arith::MulIOp>(loc, g, n1);
+  Value group = builder.create<arith::DivUIOp>(loc, linearId, width);
+  Value first = builder.create<arith::MulIOp>(loc, group, g);
+  Value size = builder.create<arith::MinSIOp>(
+      loc, builder.create<arith::SubIOp>(loc, n0, first), g);
+  Value inGroup = builder.create<arith::RemUIOp>(loc, linearId, width);
+  Value pid0 = builder.create<arith::AddIOp>(
+      loc, first, builder.create<arith::RemUIOp>(loc, inGroup, size));
+  Value pid1 = builder.create<arith::DivUIOp>(loc, inGroup, size);
+  return {pid0, pid1};
+}
+
+std::pair<Value, Value> ProgramIdRemapper::hilbert(Value linearId, Value n) {
+  // for (s = 1; s < n; s *= 2) {
+  //   rx = (t / 2) & 1; ry = (t ^ rx) & 1;
+  //   if (!ry) { if (rx) { x = s-1-x; y = s-1-y; } swap(x, y); }
+  //   x += s * rx; y += s * ry; t /= 4;
+  // }
+  Value zero = i32(0);
+  Value one = i32(1);
+  auto lb = builder.create<arith::ConstantIndexOp>(loc, 0);
+  auto ub = builder.create<arith::ConstantIndexOp>(loc, kMaxHilbertLevels);
+  auto step = builder.create<arith::ConstantIndexOp>(loc, 1);
+  auto forOp = builder.create<scf::ForOp>(
+      loc, lb, ub, step, ValueRange{zero, zero, linearId},
+      [&](OpBuilder &b, Location loc, Value iv, ValueRange args) {
+        Value x = args[0], y = args[1], t = args[2];
+        Value level =
+            b.create<arith::IndexCastOp>(loc, iv, b.getI32Type()).getResult();
+        Value s = b.create<arith::ShLIOp>(loc, one, level);
+        Value active =
+            b.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ult, s, n);
+        Value rx = b.create<arith::AndIOp>(
+            loc, b.create<arith::ShRUIOp>(loc, t, one), one);
+        Value ry = b.create<arith::AndIOp>(
+            loc, b.create<arith::XOrIOp>(loc, t, rx), one);
+        Value rxSet =
+            b.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ne, rx, zero);
+        Value rySet =
+            b.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ne, ry, zero);
+        // Reflect then transpose the sub-square when ry == 0
+        Value sMinusOne = b.create<arith::SubIOp>(loc, s, one);
+        Value xr = b.create<mlir::SelectOp>(
+            loc, rxSet, b.create<arith::SubIOp>(loc, sMinusOne, x), x);
+        Value yr = b.create<mlir::SelectOp>(
+            loc, rxSet, b.create<arith::SubIOp>(loc, sMinusOne, y), y);
+        Value xRot = b.create<mlir::SelectOp>(loc, rySet, x, yr);
+        Value yRot = b.create<mlir::SelectOp>(loc, rySet, y, xr);
+        Value xNext = b.create<arith::AddIOp>(
+            loc, xRot, b.create<arith::MulIOp>(loc, s, rx));
+        Value yNext = b.create<arith::AddIOp>(
+            loc, yRot, b.create<arith::MulIOp>(loc, s, ry));
+        Value tNext = b.create<arith::ShRUIOp>(loc, t, i32(2));
+        b.create<scf::YieldOp>(
+            loc, ValueRange{b.create<mlir::SelectOp>(loc, active, xNext, x),
+                            b.create<mlir::SelectOp>(loc, active, yNext, y),
+                            b.create<mlir::SelectOp>(loc, active, tNext, t)});
+      });
+  return {forOp.getResult(0), forOp.getResult(1)};
+}
+
+void remapFunc(mlir::FuncOp funcOp, StringRef order, int groupSize) {
+  SmallVector<triton::GetProgramIdOp> pidOps;
+  funcOp.walk([&](triton::GetProgramIdOp op) {
+    if (op.axis() < 2)
+      pidOps.push_back(op);
+  });
+  if (pidOps.empty() || funcOp.getBody().empty())
+    return;
+
+  OpBuilder builder(&funcOp.getBody().front(),
+                    funcOp.getBody().front().begin());
+  Location loc = funcOp.getLoc();
+  Type i32Ty = builder.getI32Type();
+  Value pid0 = builder.create<triton::GetProgramIdOp>(
+      loc, i32Ty, builder.getI32IntegerAttr(0));
+  Value pid1 = builder.create<triton::GetProgramIdOp>(
+      loc, i32Ty, builder.getI32IntegerAttr(1));
+  Value n0 = builder.create<triton::GetNumProgramsOp>(
+      loc, i32Ty, builder.getI32IntegerAttr(0));
+  Value n1 = builder.create<triton::GetNumProgramsOp>(
+      loc, i32Ty, builder.getI32IntegerAttr(1));
+  Value linearId = builder.create<arith::AddIOp>(
+      loc, pid0, builder.create<arith::MulIOp>(loc, pid1, n0));
+
+  ProgramIdRemapper remapper(builder, loc);
+  auto [newPid0, newPid1] = remapper.grouped(linearId, n0, n1, groupSize);
+  if (order == "hilbert") {
+    Value zero = builder.create<arith::ConstantIntOp>(loc, 0, 32);
+    Value one = builder.create<arith::ConstantIntOp>(loc, 1, 32);
+    Value isSquare =
+        builder.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq, n0, n1);
+    Value isPow2 = builder.create<arith::CmpIOp>(
+        loc, arith::CmpIPredicate::eq,
+        builder.create<arith::AndIOp>(
+            loc, n0, builder.create<arith::SubIOp>(loc, n0, one)),
+        zero);
+    Value useHilbert = builder.create<arith::AndIOp>(loc, isSquare, isPow2);
+    auto [hilbertPid0, hilbertPid1] = remapper.hilbert(linearId, n0);
+    newPid0 =
+        builder.create<mlir::SelectOp>(loc, useHilbert, hilbertPid0, newPid0);
+    newPid1 =
+        builder.create<mlir::SelectOp>(loc, useHilbert, hilbertPid1, newPid1);
+  }
+
+  for (triton::GetProgramIdOp op : pidOps) {
+    op.getResult().replaceAllUsesWith(op.axis() == 0 ? newPid0 : newPid1);
+    op->erase();
+  }
+}
+
+} // anonymous namespace
+
+class RemapProgramIdsPass
+    : public TritonRemapProgramIdsBase<RemapProgramIdsPass> {
+public:
+  RemapProgramIdsPass() = default;
+  RemapProgramIdsPass(StringRef order, int groupSize) {
+    this->order = order.str();
+    this->groupSize = groupSize;
+  }
+
+  void runOnOperation() override {
+    if (order != "grouped" && order != "hilbert") {
+      getOperation()->emitError("unknown program id order: ") << order;
+      return signalPassFailure();
+    }
+    if (groupSize < 1) {
+      getOperation()->emitError("group size must be positive");
+      return signalPassFailure();
+    }
+    ModuleOp mod = getOperation();
+    for (auto funcOp : llvm::to_vector(mod.getOps<mlir::FuncOp>()))
+      remapFunc(funcOp, order, groupSize);
+  }
+};
+
+std::unique_ptr<mlir::Pass> mlir::triton::createRemapProgramIdsPass() {
+  return std::make_unique<RemapProgramIdsPass>();
+}
+
+std::unique_ptr<mlir::Pass>
+mlir::triton::createRemapProgramIdsPass(StringRef order, int groupSize) {
+  return std::make_unique<RemapProgramIdsPass>(order, groupSize);
+}
@@ -0,0 +1,381 @@
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Pass/Pass.h"
+
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+//
+// This file implements the lowering of block pointers to tensors of pointers.
+//
+// A block pointer is kept as its scalar fields (base, shape, strides and
+// offsets) rather than as a value:
+//
+//   tt.make_tensor_ptr  records the fields of its result
+//   tt.advance          adds the increments to the offsets
+//   scf.for / scf.if    carry the fields of the block pointers they carry
+//
+// and only tt.tensor_ptr_load and tt.tensor_ptr_store materialize them:
+//
+//   ptrs = base + sum_d (offset_d + arange(0, B_d)) * stride_d
+//   mask = and_{d in boundaryCheck} 0 <= offset_d + arange(0, B_d) < shape_d
+//
+// broadcasting each dimension to the block. Loops advancing a block pointer
+// then only carry i32 offsets, and the pointers recomputed at each access
+// from make_range are what the axis analysis recovers contiguity from.
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+bool isTensorPointerType(Type type) {
+  if (auto ptrType = type.dyn_cast<triton::PointerType>())
+    return ptrType.getPointeeType().isa<RankedTensorType>();
+  return false;
+}
+
+// The fields of a block pointer, in the order they are carried by loops and
+// branches
+struct TensorPtrInfo {
+  RankedTensorType blockType;
+  Value base;
+  SmallVector<Value> shape;
+  SmallVector<Value> strides;
+  SmallVector<Value> offsets;
+
+  static unsigned numFields(Type type) {
+    auto blockType = type.cast<triton::PointerType>()
+                         .getPointeeType()
+                         .cast<RankedTensorType>();
+    return 1 + 3 * blockType.getRank();
+  }
+
+  static TensorPtrInfo fromFields(Type type, ValueRange fields) {
+    TensorPtrInfo info;
+    info.blockType = type.cast<triton::PointerType>()
+                         .getPointeeType()
+                         .cast<RankedTensorType>();
+    unsigned rank = info.blockType.getRank();
+    info.base = fields[0];
+    info.shape.append(fields.begin() + 1, fields.begin() + 1 + rank);
+    info.strides.append(fields.begin() + 1 + rank,
+                        fields.begin() + 1 + 2 * rank);
+    info.offsets.append(fields.begin() + 1 + 2 * rank,
+                        fields.begin() + 1 + 3 * rank);
+    return info;
+  }
+
+  void appendFields(SmallVectorImpl<Value> &fields) const {
+    fields.push_back(base);
+    fields.append(shape.begin(), shape.end());
+    fields.append(strides.begin(), strides.end());
+    fields.append(offsets.begin(), offsets.end());
+  }
+};
+
+class TensorPtrRewriter {
+  DenseMap<Value, TensorPtrInfo> infos;
+  // erased once all their uses are rewritten, users first
+  SmallVector<Operation *> toErase;
+
+  // the offsets along dimension d of the elements of the block, broadcast
+  // to the block, in i64
+  Value getDimOffsets(OpBuilder &builder, Location loc,
+                      const TensorPtrInfo &info, unsigned d);
+
+  std::pair<Value, Value> materialize(OpBuilder &builder, Location loc,
+                                      const TensorPtrInfo &info,
+                                      ArrayAttr boundaryCheck);
+
+  // the fields of the block pointers among values, in place of them
+  SmallVector<Value> expand(ValueRange values);
+
+  // replaces results, whose block pointers are fields of newResults
+  void replaceResults(ValueRange results, ValueRange newResults);
+
+  LogicalResult rewriteFor(scf::ForOp forOp);
+  LogicalResult rewriteIf(scf::IfOp ifOp);
+  void rewriteYield(scf::YieldOp yieldOp);
+
+public:
+  LogicalResult rewriteBlock(Block *block);
+
+  void eraseRewritten() {
+    for (Operation *op : llvm::reverse(toErase))
+      op->erase();
+  }
+};
+
+Value TensorPtrRewriter::getDimOffsets(OpBuilder &builder, Location loc,
+                                       const TensorPtrInfo &info, unsigned d) {
+  auto shape = info.blockType.getShape();
+  auto i32Type = builder.getI32Type();
+  auto i64Type = builder.getI64Type();
+  auto rangeType = RankedTensorType::get({shape[d]}, i32Type);
+  Value range = builder.create<triton::MakeRangeOp>(loc, rangeType, 0,
+                                                    (int32_t)shape[d]);
+  Value offsets = builder.create<arith::AddIOp>(
+      loc, builder.create<triton::SplatOp>(loc, rangeType, info.offsets[d]),
+      range);
+  offsets = builder.create<arith::ExtSIOp>(
+      loc, RankedTensorType::get({shape[d]}, i64Type), offsets);
+  // expand to the rank of the block, then broadcast
+  for (unsigned axis = 0; axis < shape.size(); ++axis) {
+    if (axis == d)
+      continue;
+    auto type = offsets.getType().cast<RankedTensorType>();
+    SmallVector<int64_t> newShape(type.getShape().begin(),
+                                  type.getShape().end());
+    newShape.insert(newShape.begin() + axis, 1);
+    offsets = builder.create<triton::ExpandDimsOp>(
+        loc, RankedTensorType::get(newShape, i64Type), offsets, axis);
+  }
+  return builder.create<triton::BroadcastOp>(
+      loc, RankedTensorType::get(shape, i64Type), offsets);
+}
+
+std::pair<Value, Value>
+TensorPtrRewriter::materialize(OpBuilder &builder, Location loc,
+                               const TensorPtrInfo &info,
+                               ArrayAttr boundaryCheck) {
+  auto shape = info.blockType.getShape();
+  auto i64Type = RankedTensorType::get(shape, builder.getI64Type());
+  SmallVector<bool> checked(shape.size(), false);
+  for (auto dim : boundaryCheck.getAsValueRange<IntegerAttr>())
+    checked[dim.getSExtValue()] = true;
+
+  Value elementOffsets, mask;
+  for (unsigned d = 0; d < shape.size(); ++d) {
+    Value dimOffsets = getDimOffsets(builder, loc, info, d);
+    Value scaled = builder.create<arith::MulIOp>(
+        loc, dimOffsets,
+        builder.create<triton::SplatOp>(loc, i64Type, info.strides[d]));
+    if (elementOffsets)
+      elementOffsets =
+          builder.create<arith::AddIOp>(loc, elementOffsets, scaled);
+    else
+      elementOffsets = scaled;
+    if (!checked[d])
+      continue;
+    Value zero = builder.create<arith::ConstantOp>(
+        loc, i64Type,
+        DenseElementsAttr::get(i64Type, builder.getI64IntegerAttr(0)));
+    Value inBounds = builder.create<arith::AndIOp>(
+        loc,
+        builder.create<arith::CmpIOp>(loc, arith::CmpIPredicate::sge,
+                                      dimOffsets, zero),
+        builder.create<arith::CmpIOp>(
+            loc, arith::CmpIPredicate::slt, dimOffsets,
+            builder.create<triton::SplatOp>(loc, i64Type, info.shape[d])));
+    if (mask)
+      mask = builder.create<arith::AndIOp>(loc, mask, inBounds);
+    else
+      mask = inBounds;
+  }
+
+  auto ptrsType = RankedTensorType::get(shape, info.base.getType());
+  Value ptrs = builder.create<triton::AddPtrOp>(
+      loc, ptrsType, builder.create<triton::SplatOp>(loc, ptrsType, info.base),
+      elementOffsets);
+  return {ptrs, mask};
+}
+
+SmallVector<Value> TensorPtrRewriter::expand(ValueRange values) {
+  SmallVector<Value> expanded;
+  for (Value value : values) {
+    if (isTensorPointerType(value.getType()))
+      infos.lookup(value).appendFields(expanded);
+    else
+      expanded.push_back(value);
+  }
+  return expanded;
+}
+
+void TensorPtrRewriter::replaceResults(ValueRange results,
+                                       ValueRange newResults) {
+  unsigned idx = 0;
+  for (Value result : results) {
+    Type type = result.getType();
+    if (isTensorPointerType(type)) {
+      unsigned numFields = TensorPtrInfo::numFields(type);
+      infos[result] = TensorPtrInfo::fromFields(
+          type, newResults.slice(idx, numFields));
+      idx += numFields;
+    } else {
+      result.replaceAllUsesWith(newResults[idx++]);
+    }
+  }
+}
+
+static SmallVector<Type> getTypes(ValueRange values) {
+  return llvm::to_vector(
+      llvm::map_range(values, [](Value v) { return v.getType(); }));
+}
+
+LogicalResult TensorPtrRewriter::rewriteFor(scf::ForOp forOp) {
+  // erased after the ops of its body, which use its arguments
+  toErase.push_back(forOp);
+  OpBuilder builder(forOp);
+  auto newForOp = builder.create<scf::ForOp>(
+      forOp.getLoc(), forOp.getLowerBound(), forOp.getUpperBound(),
+      forOp.getStep(), expand(forOp.getIterOperands()));
+  // the body is moved as it is, its arguments becoming those of the new loop
+  Block *body = forOp.getBody();
+  Block *newBody = newForOp.getBody();
+  newBody->getOperations().splice(newBody->end(), body->getOperations());
+  forOp.getInductionVar().replaceAllUsesWith(newForOp.getInductionVar());
+  replaceResults(forOp.getRegionIterArgs(), newForOp.getRegionIterArgs());
+  if (failed(rewriteBlock(newBody)))
+    return failure();
+  replaceResults(forOp.getResults(), newForOp.getResults());
+  return success();
+}
+
+LogicalResult TensorPtrRewriter::rewriteIf(scf::IfOp ifOp) {
+  toErase.push_back(ifOp);
+  OpBuilder builder(ifOp);
+  SmallVector<Type> resultTypes;
+  for (Type type : ifOp.getResultTypes()) {
+    if (!isTensorPointerType(type)) {
+      resultTypes.push_back(type);
+      continue;
+    }
+    // base, shape, strides and offsets
+    auto ptrType = type.cast<triton::PointerType>();
+    auto blockType = ptrType.getPointeeType().cast<RankedTensorType>();
+    resultTypes.push_back(triton::PointerType::get(
+        blockType.getElementType(), ptrType.getAddressSpace()));
+    resultTypes.append(2 * blockType.getRank(), builder.getI64Type());
+    resultTypes.append(blockType.getRank(), builder.getI32Type());
+  }
+  auto newIfOp = builder.create<scf::IfOp>(ifOp.getLoc(), resultTypes,
+                                           ifOp.getCondition(),
+                                           /*withElseRegion=*/true);
+  newIfOp.getThenRegion().takeBody(ifOp.getThenRegion());
+  newIfOp.getElseRegion().takeBody(ifOp.getElseRegion());
+  for (Region *region : {&newIfOp.getThenRegion(), &newIfOp.getElseRegion()})
+    if (!region->empty() && failed(rewriteBlock(&region->front())))
+      return failure();
+  replaceResults(ifOp.getResults(), newIfOp.getResults());
+  return success();
+}
+
+void TensorPtrRewriter::rewriteYield(scf::YieldOp yieldOp) {
+  if (llvm::none_of(yieldOp.getOperandTypes(), isTensorPointerType))
+    return;
+  OpBuilder builder(yieldOp);
+  builder.create<scf::YieldOp>(yieldOp.getLoc(),
+                               expand(yieldOp.getOperands()));
+  yieldOp->erase();
+}
+
+LogicalResult TensorPtrRewriter::rewriteBlock(Block *block) {
+  for (Operation &op : llvm::make_early_inc_range(*block)) {
+    Location loc = op.getLoc();
+    OpBuilder builder(&op);
+    if (auto makeOp = dyn_cast<triton::MakeTensorPtrOp>(op)) {
+      TensorPtrInfo info;
+      info.blockType = makeOp.result()
+                           .getType()
+                           .cast<triton::PointerType>()
+                           .getPointeeType()
+                           .cast<RankedTensorType>();
+      info.base = makeOp.base();
+      info.shape.append(makeOp.shape().begin(), makeOp.shape().end());
+      info.strides.append(makeOp.strides().begin(), makeOp.strides().end());
+      info.offsets.append(makeOp.offsets().begin(), makeOp.offsets().end());
+      infos[makeOp.result()] = info;
+      toErase.push_back(&op);
+    } else if (auto advanceOp = dyn_cast<triton::AdvanceOp>(op)) {
+      TensorPtrInfo info = infos.lookup(advanceOp.ptr());
+      for (auto it : llvm::enumerate(advanceOp.offsets()))
+        info.offsets[it.index()] = builder.create<arith::AddIOp>(
+            loc, info.offsets[it.index()], it.value());
+      infos[advanceOp.result()] = info;
+      toErase.push_back(&op);
+    } else if (auto loadOp = dyn_cast<triton::TensorPtrLoadOp>(op)) {
+      const TensorPtrInfo &info = infos.lookup(loadOp.ptr());
+      auto [ptrs, mask] =
+          materialize(builder, loc, info, loadOp.boundaryCheck());
+      Value other;
+      if (mask && loadOp.padding()) {
+        Type elementType = info.blockType.getElementType();
+        Attribute padding;
+        if (*loadOp.padding() == triton::PaddingOption::PAD_NAN)
+          padding = builder.getFloatAttr(
+              elementType, APFloat::getNaN(elementType.cast<FloatType>()
+                                               .getFloatSemantics()));
+        else
+          padding = builder.getZeroAttr(elementType);
+        other = builder.create<arith::ConstantOp>(
+            loc, info.blockType,
+            DenseElementsAttr::get(info.blockType, padding));
+      }
+      auto newLoadOp = builder.create<triton::LoadOp>(
+          loc, ptrs, mask, other, loadOp.cache(), loadOp.evict(),
+          loadOp.isVolatile());
+      loadOp.result().replaceAllUsesWith(newLoadOp.getResult());
+      toErase.push_back(&op);
+    } else if (auto storeOp = dyn_cast<triton::TensorPtrStoreOp>(op)) {
+      const TensorPtrInfo &info = infos.lookup(storeOp.ptr());
+      auto [ptrs, mask] =
+          materialize(builder, loc, info, storeOp.boundaryCheck());
+      builder.create<triton::StoreOp>(loc, ptrs, storeOp.value(), mask,
+                                      storeOp.cache(), storeOp.evict());
+      toErase.push_back(&op);
+    } else if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+      if (llvm::any_of(getTypes(forOp.getIterOperands()), isTensorPointerType)) {
+        if (failed(rewriteFor(forOp)))
+          return failure();
+      } else {
+        if (failed(rewriteBlock(forOp.getBody())))
+          return failure();
+      }
+    } else if (auto ifOp = dyn_cast<scf::IfOp>(op)) {
+      if (llvm::any_of(ifOp.getResultTypes(), isTensorPointerType)) {
+        if (failed(rewriteIf(ifOp)))
+          return failure();
+      } else {
+        for (Region &region : ifOp->getRegions())
+          if (!region.empty() && failed(rewriteBlock(&region.front())))
+            return failure();
+      }
+    } else if (auto yieldOp = dyn_cast<scf::YieldOp>(op)) {
+      rewriteYield(yieldOp);
+    } else {
+      if (llvm::any_of(op.getOperandTypes(), isTensorPointerType) ||
+          llvm::any_of(op.getResultTypes(), isTensorPointerType))
+        return op.emitError("block pointers are not supported by this op");
+      for (Region &region : op.getRegions())
+        for (Block &nested : region)
+          if (failed(rewriteBlock(&nested)))
+            return failure();
+    }
+  }
+  return success();
+}
+
+} // anonymous namespace
+
+class RewriteTensorPointerPass
+    : public TritonRewriteTensorPointerBase<RewriteTensorPointerPass> {
+public:
+  void runOnOperation() override {
+    ModuleOp mod = getOperation();
+    for (auto funcOp : llvm::to_vector(mod.getOps<mlir::FuncOp>())) {
+      TensorPtrRewriter rewriter;
+      if (failed(rewriter.rewriteBlock(&funcOp.getBody().front())))
+        return signalPassFailure();
+      rewriter.eraseRewritten();
+    }
+  }
+};
+
+std::unique_ptr<mlir::Pass> mlir::triton::createRewriteTensorPointerPass() {
+  return std::make_unique<RewriteTensorPointerPass>();
+}
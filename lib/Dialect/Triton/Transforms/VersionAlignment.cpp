@@ -0,0 +1,113 @@
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/Pass/Pass.h"
+
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+//
+// This file implements runtime versioning of kernels on pointer alignment.
+//
+// Pointer arguments tagged with `tt.version_divisibility = d` are checked in
+// the prologue, and the body is duplicated into the two branches of an scf.if:
+//
+//   if (ptr0 % d0 == 0 && ptr1 % d1 == 0 && ...) {
+//     // ptrN is replaced by addptr(ptrN, 0) {tt.divisibility = dN}
+//     <vectorizable body>
+//   } else {
+//     <original body>
+//   }
+//
+// so that a single binary serves both aligned and unaligned calls.
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+constexpr char kVersionDivisibilityAttrName[] = "tt.version_divisibility";
+constexpr char kDivisibilityAttrName[] = "tt.divisibility";
+
+void versionFunc(mlir::FuncOp funcOp) {
+  SmallVector<std::pair<BlockArgument, int64_t>> versionedArgs;
+  for (BlockArgument arg : funcOp.getArguments()) {
+    unsigned argNo = arg.getArgNumber();
+    auto attr = funcOp.getArgAttrOfType<IntegerAttr>(
+        argNo, kVersionDivisibilityAttrName);
+    if (!attr)
+      continue;
+    funcOp.removeArgAttr(argNo, kVersionDivisibilityAttrName);
+    if (attr.getInt() > 1 && arg.getType().isa<triton::PointerType>())
+      versionedArgs.push_back({arg, attr.getInt()});
+  }
+  if (versionedArgs.empty())
+    return;
+
+  // Kernels are a single block without return values
+  if (!funcOp.getBody().hasOneBlock())
+    return;
+  Block *entry = &funcOp.getBody().front();
+  auto returnOp = dyn_cast<mlir::ReturnOp>(entry->getTerminator());
+  if (!returnOp || returnOp.getNumOperands() != 0 ||
+      entry->getOperations().size() == 1)
+    return;
+  auto firstOp = entry->begin();
+
+  OpBuilder builder(returnOp);
+  Location loc = funcOp.getLoc();
+  Value zero = builder.create<arith::ConstantIntOp>(loc, 0, 64);
+  Value isAligned;
+  for (auto &[arg, divisibility] : versionedArgs) {
+    Value addr =
+        builder.create<triton::PtrToIntOp>(loc, builder.getI64Type(), arg);
+    Value rem = builder.create<arith::RemUIOp>(
+        loc, addr, builder.create<arith::ConstantIntOp>(loc, divisibility, 64));
+    Value cond = builder.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq,
+                                               rem, zero);
+    isAligned = isAligned ? builder.create<arith::AndIOp>(loc, isAligned, cond)
+                          : cond;
+  }
+  auto ifOp = builder.create<scf::IfOp>(loc, TypeRange{}, isAligned,
+                                        /*withElseRegion=*/true);
+
+  // Move the body into the fallback, and clone it into the fast path with the
+  // alignment of the pointers asserted
+  Block *fastPath = ifOp.thenBlock();
+  Block *fallback = ifOp.elseBlock();
+  fallback->getOperations().splice(fallback->begin(), entry->getOperations(),
+                                   firstOp,
+                                   zero.getDefiningOp()->getIterator());
+  BlockAndValueMapping mapping;
+  builder.setInsertionPointToStart(fastPath);
+  Value zeroOffset = builder.create<arith::ConstantIntOp>(loc, 0, 32);
+  for (auto &[arg, divisibility] : versionedArgs) {
+    auto alignedPtr =
+        builder.create<triton::AddPtrOp>(loc, arg.getType(), arg, zeroOffset);
+    alignedPtr->setAttr(kDivisibilityAttrName,
+                        builder.getI32IntegerAttr(divisibility));
+    mapping.map(arg, alignedPtr.getResult());
+  }
+  for (Operation &op : fallback->without_terminator())
+    builder.clone(op, mapping);
+}
+
+} // anonymous namespace
+
+class VersionAlignmentPass
+    : public TritonVersionAlignmentBase<VersionAlignmentPass> {
+public:
+  void runOnOperation() override {
+    ModuleOp mod = getOperation();
+    for (auto funcOp : llvm::to_vector(mod.getOps<mlir::FuncOp>()))
+      versionFunc(funcOp);
+  }
+};
+
+std::unique_ptr<mlir::Pass> mlir::triton::createVersionAlignmentPass() {
+  return std::make_unique<VersionAlignmentPass>();
+}
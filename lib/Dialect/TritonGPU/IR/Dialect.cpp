@@ -53,10 +53,14 @@ unsigned getElemsPerThread(Attribute layout, ArrayRef<int64_t> shape) {
     return sliceLayout.getElemsPerThread(shape);
   } else if (auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>()) {
     return mmaLayout.getElemsPerThread(shape);
+  } else if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>()) {
+    return mfmaLayout.getElemsPerThread(shape);
   } else if (auto sharedLayout = layout.dyn_cast<SharedEncodingAttr>()) {
     return sharedLayout.getElemsPerThread(shape);
   } else if (auto dotLayout = layout.dyn_cast<DotOperandEncodingAttr>()) {
     return dotLayout.getElemsPerThread(shape);
+  } else if (auto metaLayout = layout.dyn_cast<SparseDotMetaEncodingAttr>()) {
+    return metaLayout.getElemsPerThread(shape);
   } else {
     assert(0 && "getElemsPerThread not implemented");
     return 0;
@@ -64,7 +68,7 @@ unsigned getElemsPerThread(Attribute layout, ArrayRef<int64_t> shape) {
 }
 
 unsigned getElemsPerThread(Type type) {
-  if (type.isIntOrIndexOrFloat() || type.isa<triton::Float8Type>() ||
+  if (type.isIntOrIndexOrFloat() || triton::isFloat8(type) ||
       type.isa<triton::PointerType>())
     return 1;
   auto tensorType = type.cast<RankedTensorType>();
@@ -79,9 +83,13 @@ SmallVector<unsigned> getThreadsPerWarp(const Attribute &layout) {
   if (auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>()) {
     if (mmaLayout.isVolta())
       return {4, 8};
-    if (mmaLayout.isAmpere())
+    if (mmaLayout.isAmpere() || mmaLayout.isHopper())
       return {8, 4};
   }
+  if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>()) {
+    // A 64-lane wavefront: two halves of 32 lanes stacked along M.
+    return {2, 32};
+  }
   assert(0 && "getThreadsPerWarp not implemented");
   return {};
 }
@@ -95,6 +103,10 @@ SmallVector<unsigned> getWarpsPerCTA(const Attribute &layout) {
     return SmallVector<unsigned>(mmaLayout.getWarpsPerCTA().begin(),
                                  mmaLayout.getWarpsPerCTA().end());
   }
+  if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>()) {
+    return SmallVector<unsigned>(mfmaLayout.getWarpsPerCTA().begin(),
+                                 mfmaLayout.getWarpsPerCTA().end());
+  }
   assert(0 && "getWarpsPerCTA not implemented");
   return {};
 }
@@ -109,18 +121,28 @@ SmallVector<unsigned> getSizePerThread(const Attribute &layout) {
     // ret.erase(ret.begin() + sliceLayout.getDim());
     return ret;
   } else if (auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>()) {
-    if (mmaLayout.isAmpere()) {
+    if (mmaLayout.isAmpere() || mmaLayout.isHopper()) {
       return {2, 2};
     } else if (mmaLayout.isVolta()) {
       return {1, 2};
     } else {
       llvm_unreachable("Unexpected mma version");
     }
+  } else if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>()) {
+    return {4, 1};
   } else if (auto dotLayout = layout.dyn_cast<DotOperandEncodingAttr>()) {
     auto parentLayout = dotLayout.getParent();
     assert(parentLayout && "DotOperandEncodingAttr must have a parent");
+    if (auto parentMfmaLayout = parentLayout.dyn_cast<MfmaEncodingAttr>()) {
+      // Each lane holds a contiguous run of k elements of one row of A
+      // (resp. one column of B); the run length depends on the element type
+      // and is not known here, so only the non-k extent is reported.
+      assert((dotLayout.getOpIdx() == 0 || dotLayout.getOpIdx() == 1) &&
+             "DotOperandEncodingAttr opIdx must be 0 or 1");
+      return {1, 1};
+    }
     if (auto parentMmaLayout = parentLayout.dyn_cast<MmaEncodingAttr>()) {
-      assert(parentMmaLayout.isAmpere() &&
+      assert((parentMmaLayout.isAmpere() || parentMmaLayout.isHopper()) &&
              "mmaLayout version = 1 is not implemented yet");
       auto parentShapePerCTA = getShapePerCTA(parentLayout);
       auto opIdx = dotLayout.getOpIdx();
@@ -145,13 +167,21 @@ SmallVector<unsigned> getSizePerThread(const Attribute &layout) {
 
 SmallVector<unsigned> getContigPerThread(const Attribute &layout) {
   if (auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>()) {
-    assert(mmaLayout.isVolta() || mmaLayout.isAmpere());
+    assert(mmaLayout.isVolta() || mmaLayout.isAmpere() ||
+           mmaLayout.isHopper());
     return {1, 2};
   } else {
     return getSizePerThread(layout);
   }
 }
 
+unsigned getSharedAccessVec(SharedEncodingAttr layout, unsigned inVec) {
+  // Without swizzling the rows are not split into groups of `vec` elements
+  if (layout.getMaxPhase() == 1)
+    return inVec;
+  return std::min(inVec, layout.getVec());
+}
+
 SmallVector<unsigned> getThreadsPerCTA(const Attribute &layout) {
   SmallVector<unsigned> threads;
   if (auto blockedLayout = layout.dyn_cast<BlockedEncodingAttr>()) {
@@ -159,11 +189,14 @@ SmallVector<unsigned> getThreadsPerCTA(const Attribute &layout) {
       threads.push_back(blockedLayout.getThreadsPerWarp()[d] *
                         blockedLayout.getWarpsPerCTA()[d]);
   } else if (auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>()) {
-    if (mmaLayout.getVersionMajor() == 2) {
+    if (mmaLayout.isAmpere() || mmaLayout.isHopper()) {
       threads = {8 * mmaLayout.getWarpsPerCTA()[0],
                  4 * mmaLayout.getWarpsPerCTA()[1]};
     } else
       assert(0 && "Unimplemented usage of MmaEncodingAttr");
+  } else if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>()) {
+    threads = {2 * mfmaLayout.getWarpsPerCTA()[0],
+               32 * mfmaLayout.getWarpsPerCTA()[1]};
   } else {
     assert(0 && "Unimplemented usage of getShapePerCTA");
   }
@@ -188,7 +221,7 @@ SmallVector<unsigned> getShapePerCTA(const Attribute &layout,
       shape.push_back(getShapePerCTA(parent, tensorShape)[d]);
     }
   } else if (auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>()) {
-    if (mmaLayout.isAmpere())
+    if (mmaLayout.isAmpere() || mmaLayout.isHopper())
       return {16 * mmaLayout.getWarpsPerCTA()[0],
               8 * mmaLayout.getWarpsPerCTA()[1]};
     if (mmaLayout.isVolta()) {
@@ -200,11 +233,26 @@ SmallVector<unsigned> getShapePerCTA(const Attribute &layout,
               static_cast<unsigned>(tensorShape[1])};
     }
     assert(0 && "Unexpected MMA layout version found");
+  } else if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>()) {
+    unsigned nonKDim = mfmaLayout.getNonKDim();
+    return {nonKDim * mfmaLayout.getWarpsPerCTA()[0],
+            nonKDim * mfmaLayout.getWarpsPerCTA()[1]};
   } else if (auto dotLayout = layout.dyn_cast<DotOperandEncodingAttr>()) {
     auto parentLayout = dotLayout.getParent();
     assert(parentLayout && "DotOperandEncodingAttr must have a parent");
+    if (auto parentMfmaLayout = parentLayout.dyn_cast<MfmaEncodingAttr>()) {
+      auto parentShapePerCTA = getShapePerCTA(parentLayout, tensorShape);
+      auto opIdx = dotLayout.getOpIdx();
+      assert((opIdx == 0 || opIdx == 1) &&
+             "DotOperandEncodingAttr opIdx must be 0 or 1");
+      // The k extent covered by one mfma depends on the element type; the
+      // lowering repeats along k as needed, so only M/N are meaningful here.
+      if (opIdx == 0)
+        return {parentShapePerCTA[0], 1};
+      return {1, parentShapePerCTA[1]};
+    }
     if (auto parentMmaLayout = parentLayout.dyn_cast<MmaEncodingAttr>()) {
-      assert(parentMmaLayout.isAmpere() &&
+      assert((parentMmaLayout.isAmpere() || parentMmaLayout.isHopper()) &&
              "mmaLayout version = 1 is not implemented yet");
       auto parentShapePerCTA = getShapePerCTA(parentLayout, tensorShape);
       auto opIdx = dotLayout.getOpIdx();
@@ -241,8 +289,12 @@ SmallVector<unsigned> getOrder(const Attribute &layout) {
                                  blockedLayout.getOrder().end());
   } else if (auto mmaLayout = layout.dyn_cast<MmaEncodingAttr>()) {
     return {1, 0};
+  } else if (auto mfmaLayout = layout.dyn_cast<MfmaEncodingAttr>()) {
+    return {1, 0};
   } else if (auto dotLayout = layout.dyn_cast<DotOperandEncodingAttr>()) {
     return {1, 0};
+  } else if (auto metaLayout = layout.dyn_cast<SparseDotMetaEncodingAttr>()) {
+    return {1, 0};
   } else if (auto sliceLayout = layout.dyn_cast<SliceEncodingAttr>()) {
     SmallVector<unsigned> parentOrder = getOrder(sliceLayout.getParent());
     unsigned dim = sliceLayout.getDim();
@@ -267,7 +319,7 @@ SmallVector<unsigned> getOrder(const Attribute &layout) {
 
 bool isaDistributedLayout(const Attribute &layout) {
   return layout.isa<BlockedEncodingAttr>() || layout.isa<MmaEncodingAttr>() ||
-         layout.isa<SliceEncodingAttr>();
+         layout.isa<MfmaEncodingAttr>() || layout.isa<SliceEncodingAttr>();
 }
 
 } // namespace gpu
@@ -384,7 +436,8 @@ unsigned SliceEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape) const {
 unsigned MmaEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape) const {
   size_t rank = shape.size();
   assert(rank == 2 && "Unexpected rank of mma layout");
-  assert((isVolta() || isAmpere()) && "Only version 1 and 2 is supported");
+  assert((isVolta() || isAmpere() || isHopper()) &&
+         "Only version 1, 2 and 3 are supported");
 
   int res = 0;
   if (isVolta()) {
@@ -393,7 +446,7 @@ unsigned MmaEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape) const {
     // Each warp-level mma884 will perform a m16xn16xk4 mma, thus get a m16xn16
     // matrix as result.
     res = mmasRow * mmasCol * (16 * 16 / 32);
-  } else if (isAmpere()) {
+  } else if (isAmpere() || isHopper()) {
     unsigned elemsCol = ceil<unsigned>(shape[0], 16 * getWarpsPerCTA()[0]) * 2;
     unsigned elemsRow = ceil<unsigned>(shape[1], 8 * getWarpsPerCTA()[1]) * 2;
     res = elemsCol * elemsRow;
@@ -404,6 +457,17 @@ unsigned MmaEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape) const {
   return res;
 }
 
+unsigned MfmaEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape) const {
+  size_t rank = shape.size();
+  assert(rank == 2 && "Unexpected rank of mfma layout");
+  assert(getNonKDim() == 32 && "Only 32x32 mfma is supported");
+
+  // Each wavefront-level mfma produces a 32x32 tile, i.e. 16 values per lane.
+  unsigned mfmasRow = ceil<unsigned>(shape[0], 32 * getWarpsPerCTA()[0]);
+  unsigned mfmasCol = ceil<unsigned>(shape[1], 32 * getWarpsPerCTA()[1]);
+  return mfmasRow * mfmasCol * (32 * 32 / 64);
+}
+
 unsigned SharedEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape) const {
   // TODO:
   assert(0 && "SharedEncodingAttr::getElemsPerThread not implemented");
@@ -415,10 +479,29 @@ DotOperandEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape) const {
   if (auto blockedLayout = getParent().dyn_cast<BlockedEncodingAttr>()) {
     return blockedLayout.getElemsPerThread(shape);
   }
+  if (auto mfmaLayout = getParent().dyn_cast<MfmaEncodingAttr>()) {
+    assert(shape.size() == 2 && "Unexpected rank of mfma dot operand");
+    // Within a wavefront the two 32-lane halves split k, so every lane holds
+    // k / 2 elements of each row (A) or column (B) it owns.
+    auto wpt = mfmaLayout.getWarpsPerCTA();
+    unsigned nonKDim = mfmaLayout.getNonKDim();
+    if (getOpIdx() == 0)
+      return ceil<unsigned>(shape[0], nonKDim * wpt[0]) * (shape[1] / 2);
+    return ceil<unsigned>(shape[1], nonKDim * wpt[1]) * (shape[0] / 2);
+  }
   assert(0 && "DotOperandEncodingAttr::getElemsPerThread not implemented");
   return 0;
 }
 
+unsigned
+SparseDotMetaEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape) const {
+  assert(shape.size() == 2 && "Unexpected rank of sparse dot metadata");
+  auto mmaLayout = getParent().cast<MmaEncodingAttr>();
+  // 2 i16 per repetition along M of each of the shape[1] / 2 k32 steps
+  unsigned wptM = mmaLayout.getWarpsPerCTA()[0];
+  return std::max<unsigned>(shape[0] / (16 * wptM), 1) * shape[1];
+}
+
 //===----------------------------------------------------------------------===//
 // Blocked Encoding
 //===----------------------------------------------------------------------===//
@@ -522,6 +605,47 @@ void MmaEncodingAttr::print(AsmPrinter &printer) const {
           << "}>";
 }
 
+//===----------------------------------------------------------------------===//
+// MFMA encoding
+//===----------------------------------------------------------------------===//
+
+Attribute MfmaEncodingAttr::parse(AsmParser &parser, Type type) {
+  if (parser.parseLess().failed())
+    return {};
+  DictionaryAttr dict;
+  if (parser.parseAttribute(dict).failed())
+    return {};
+  if (parser.parseGreater().failed())
+    return {};
+
+  unsigned nonKDim = 0;
+  SmallVector<unsigned, 2> warpsPerCTA;
+
+  for (const NamedAttribute &attr : dict) {
+    if (attr.getName() == "nonKDim") {
+      if (parseUInt(parser, attr, nonKDim, "nonKDim").failed())
+        return {};
+    } else if (attr.getName() == "warpsPerCTA") {
+      if (parseIntArrayAttr(parser, attr, warpsPerCTA, "warpsPerCTA").failed())
+        return {};
+    } else {
+      parser.emitError(parser.getNameLoc(), "unexpected key: ")
+          << attr.getName().strref();
+      return {};
+    }
+  }
+
+  return parser.getChecked<MfmaEncodingAttr>(parser.getContext(), nonKDim,
+                                             warpsPerCTA);
+}
+
+void MfmaEncodingAttr::print(AsmPrinter &printer) const {
+  printer << "<{"
+          << "nonKDim = " << getNonKDim() << ", "
+          << "warpsPerCTA = [" << getWarpsPerCTA() << "]"
+          << "}>";
+}
+
 //===----------------------------------------------------------------------===//
 // Sliced Encoding
 //===----------------------------------------------------------------------===//
@@ -563,6 +687,7 @@ Attribute SharedEncodingAttr::parse(AsmParser &parser, Type type) {
   unsigned perPhase = 0;
   unsigned maxPhase = 0;
   SmallVector<unsigned, 2> order;
+  unsigned clusterSize = 1;
 
   for (const NamedAttribute &attr : dict) {
     if (attr.getName() == "vec") {
@@ -577,6 +702,9 @@ Attribute SharedEncodingAttr::parse(AsmParser &parser, Type type) {
     } else if (attr.getName() == "order") {
       if (parseIntArrayAttr(parser, attr, order, "order").failed())
         return {};
+    } else if (attr.getName() == "cluster") {
+      if (parseUInt(parser, attr, clusterSize, "cluster").failed())
+        return {};
     } else {
       parser.emitError(parser.getNameLoc(), "unexpected key: ")
           << attr.getName().strref();
@@ -584,16 +712,18 @@ Attribute SharedEncodingAttr::parse(AsmParser &parser, Type type) {
     }
   }
 
-  return parser.getChecked<SharedEncodingAttr>(parser.getContext(), vec,
-                                               perPhase, maxPhase, order);
+  return parser.getChecked<SharedEncodingAttr>(
+      parser.getContext(), vec, perPhase, maxPhase, order, clusterSize);
 }
 
 void SharedEncodingAttr::print(AsmPrinter &printer) const {
   printer << "<{"
           << "vec = " << getVec() << ", perPhase = " << getPerPhase()
           << ", maxPhase = " << getMaxPhase() << ", order = [" << getOrder()
-          << "]"
-          << "}>";
+          << "]";
+  if (getClusterSize() > 1)
+    printer << ", cluster = " << getClusterSize();
+  printer << "}>";
 }
 
 //===----------------------------------------------------------------------===//
@@ -604,6 +734,8 @@ bool MmaEncodingAttr::isVolta() const { return getVersionMajor() == 1; }
 
 bool MmaEncodingAttr::isAmpere() const { return getVersionMajor() == 2; }
 
+bool MmaEncodingAttr::isHopper() const { return getVersionMajor() == 3; }
+
 // Get [isARow, isBRow, isAVec4, isBVec4, id] from versionMinor
 std::tuple<bool, bool, bool, bool, int>
 MmaEncodingAttr::decodeVoltaLayoutStates() const {
@@ -653,6 +785,31 @@ void DotOperandEncodingAttr::print(mlir::AsmPrinter &printer) const {
   printer << "}>";
 }
 
+//===----------------------------------------------------------------------===//
+// SparseDotMeta Encoding
+//===----------------------------------------------------------------------===//
+Attribute SparseDotMetaEncodingAttr::parse(AsmParser &parser, Type type) {
+  if (parser.parseLess().failed())
+    return {};
+  NamedAttrList attrs;
+  if (parser.parseOptionalAttrDict(attrs).failed())
+    return {};
+  if (parser.parseGreater().failed())
+    return {};
+  Attribute parent = attrs.get("parent");
+  if (!parent || !parent.isa<MmaEncodingAttr>()) {
+    parser.emitError(parser.getNameLoc(), "expected an mma parent");
+    return {};
+  }
+  return parser.getChecked<SparseDotMetaEncodingAttr>(parser.getContext(),
+                                                      parent);
+}
+
+void SparseDotMetaEncodingAttr::print(mlir::AsmPrinter &printer) const {
+  printer << "<{"
+          << "parent = " << getParent() << "}>";
+}
+
 //===----------------------------------------------------------------------===//
 // InsertSliceAsyncOp
 //===----------------------------------------------------------------------===//
@@ -724,6 +881,9 @@ public:
     if (auto mmaAttr = attr.dyn_cast<MmaEncodingAttr>()) {
       os << "mma";
       return AliasResult::FinalAlias;
+    } else if (auto mfmaAttr = attr.dyn_cast<MfmaEncodingAttr>()) {
+      os << "mfma";
+      return AliasResult::FinalAlias;
     } else if (auto sharedAttr = attr.dyn_cast<SharedEncodingAttr>()) {
       os << "shared";
       return AliasResult::FinalAlias;
@@ -761,7 +921,8 @@ struct TritonGPUInferLayoutInterface
     std::reverse(retOrder.begin(), retOrder.end());
     resultEncoding = SharedEncodingAttr::get(
         getDialect()->getContext(), sharedEncoding.getVec(),
-        sharedEncoding.getPerPhase(), sharedEncoding.getMaxPhase(), retOrder);
+        sharedEncoding.getPerPhase(), sharedEncoding.getMaxPhase(), retOrder,
+        sharedEncoding.getClusterSize());
     return mlir::success();
   }
 
@@ -780,6 +941,55 @@ struct TritonGPUInferLayoutInterface
     return success();
   }
 
+  // The two tensors joined are held by the same threads: the new dimension
+  // is the fastest-varying one, and each thread holds both of its elements
+  LogicalResult
+  inferJoinOpEncoding(Attribute operandEncoding, Attribute &resultEncoding,
+                      Optional<Location> location) const override {
+    auto blocked = operandEncoding.dyn_cast<BlockedEncodingAttr>();
+    if (!blocked)
+      return emitOptionalError(
+          location, "JoinOp operand encoding must be BlockedEncodingAttr");
+    unsigned rank = blocked.getOrder().size();
+    auto append = [](ArrayRef<unsigned> vals, unsigned val) {
+      SmallVector<unsigned> res(vals.begin(), vals.end());
+      res.push_back(val);
+      return res;
+    };
+    SmallVector<unsigned> retOrder = {rank};
+    retOrder.append(blocked.getOrder().begin(), blocked.getOrder().end());
+    resultEncoding = BlockedEncodingAttr::get(
+        getDialect()->getContext(), append(blocked.getSizePerThread(), 2),
+        append(blocked.getThreadsPerWarp(), 1),
+        append(blocked.getWarpsPerCTA(), 1), retOrder);
+    return success();
+  }
+
+  LogicalResult
+  inferSplitOpEncoding(Attribute operandEncoding, Attribute &resultEncoding,
+                       Optional<Location> location) const override {
+    auto blocked = operandEncoding.dyn_cast<BlockedEncodingAttr>();
+    if (!blocked)
+      return emitOptionalError(
+          location, "SplitOp operand encoding must be BlockedEncodingAttr");
+    unsigned rank = blocked.getOrder().size();
+    if (blocked.getSizePerThread().back() != 2 ||
+        blocked.getThreadsPerWarp().back() != 1 ||
+        blocked.getWarpsPerCTA().back() != 1)
+      return emitOptionalError(location,
+                               "SplitOp operand must hold both elements of "
+                               "its trailing dimension in each thread");
+    SmallVector<unsigned> retOrder;
+    for (unsigned d : blocked.getOrder())
+      if (d != rank - 1)
+        retOrder.push_back(d);
+    resultEncoding = BlockedEncodingAttr::get(
+        getDialect()->getContext(), blocked.getSizePerThread().drop_back(),
+        blocked.getThreadsPerWarp().drop_back(),
+        blocked.getWarpsPerCTA().drop_back(), retOrder);
+    return success();
+  }
+
   LogicalResult inferDotOpEncoding(Attribute operandEncoding, unsigned opIdx,
                                    Attribute retEncoding,
                                    Optional<Location> location) const override {
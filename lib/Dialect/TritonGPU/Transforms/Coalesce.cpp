@@ -10,49 +10,147 @@ using namespace mlir::triton;
 #define GEN_PASS_CLASSES
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
 
+namespace {
+
+// Bytes of a memory sector
+constexpr unsigned kSectorBytes = 32;
+
+unsigned getPointeeBits(RankedTensorType ptrTensorType) {
+  auto pointeeType =
+      ptrTensorType.getElementType().cast<PointerType>().getPointeeType();
+  return triton::isFloat8(pointeeType) ? 8
+                                       : pointeeType.getIntOrFloatBitWidth();
+}
+
+// Elements of the vectors each thread accesses along `axis`, as lowered: as
+// many as the thread holds, up to the contiguity, the alignment and 128 bits
+unsigned getVectorSize(const AxisInfo &info, unsigned axis,
+                       unsigned sizePerThread, unsigned numBits) {
+  int64_t alignment =
+      std::min(info.getDivisibility(axis), info.getContiguity(axis));
+  return std::max<int64_t>(
+      1, std::min<int64_t>({alignment, sizePerThread, 128 / numBits}));
+}
+
+// Fraction of the bytes of the sectors accessed by a warp instruction that
+// are requested. The lanes of a warp along the fastest axis of the layout
+// access a segment of the axis, made of runs of contiguous elements unrelated
+// to each other, each run starting as misaligned as its divisibility allows.
+// The other axes are unrelated as well, each row of the warp accessing its
+// own sectors.
+double getSectorEfficiency(const AxisInfo &info,
+                           triton::gpu::BlockedEncodingAttr layout,
+                           ArrayRef<int64_t> shape, unsigned numBits) {
+  unsigned axis = layout.getOrder()[0];
+  unsigned sizePerThread = layout.getSizePerThread()[axis];
+  unsigned vec = getVectorSize(info, axis, sizePerThread, numBits);
+  unsigned numBytes = std::max(numBits / 8, 1u);
+  int64_t segment = std::min<int64_t>(
+      shape[axis], layout.getThreadsPerWarp()[axis] * sizePerThread);
+  int64_t run = std::min<int64_t>(info.getContiguity(axis), segment);
+  // Lanes holding more elements than they access at once leave gaps
+  int64_t requested = run / sizePerThread * vec +
+                      std::min<int64_t>(run % sizePerThread, vec);
+  int64_t misalignment =
+      (std::min<int64_t>(info.getDivisibility(axis), kSectorBytes) *
+       numBytes) %
+      kSectorBytes;
+  int64_t sectors = ceil<int64_t>(misalignment + run * numBytes, kSectorBytes);
+  return double(requested * numBytes) / double(sectors * kSectorBytes);
+}
+
+} // anonymous namespace
+
 struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
-  Attribute getCoalescedEncoding(AxisInfoAnalysis &axisInfo, Value ptr,
-                                 int numWarps) {
-    auto origType = ptr.getType().cast<RankedTensorType>();
-    // Get the shape of the tensor.
+  CoalescePass() = default;
+  CoalescePass(bool reportSectorEfficiency) {
+    this->reportSectorEfficiency = reportSectorEfficiency;
+  }
+
+  // Coalesced encoding whose fastest axis is `fastest`, the other axes
+  // following in decreasing order of contiguity
+  triton::gpu::BlockedEncodingAttr
+  getCoalescedEncoding(const AxisInfo &info, RankedTensorType origType,
+                       unsigned fastest, int numWarps, int threadsPerWarp) {
     size_t rank = origType.getRank();
-    AxisInfo info = axisInfo.lookupLatticeElement(ptr)->getValue();
-    // Layout order in decreasing order of contiguity
     SmallVector<unsigned, 4> order(rank);
     std::iota(order.begin(), order.end(), 0);
     auto contiguity = info.getContiguity();
-    std::sort(order.begin(), order.end(), [&](unsigned x, unsigned y) {
+    std::stable_sort(order.begin(), order.end(), [&](unsigned x, unsigned y) {
+      if ((x == fastest) != (y == fastest))
+        return x == fastest;
       return contiguity[x] > contiguity[y];
     });
 
     int numElems = product(origType.getShape());
-    int numThreads = numWarps * 32;
+    int numThreads = numWarps * threadsPerWarp;
     int numElemsPerThread = std::max(numElems / numThreads, 1);
 
     // Thread tile size depends on memory alignment
     SmallVector<unsigned, 4> sizePerThread(rank, 1);
-    PointerType ptrType = origType.getElementType().cast<PointerType>();
-    auto pointeeType = ptrType.getPointeeType();
-    unsigned numBits = pointeeType.isa<triton::Float8Type>()
-                           ? 8
-                           : pointeeType.getIntOrFloatBitWidth();
-    unsigned maxMultiple = info.getDivisibility(order[0]);
-    unsigned maxContig = info.getContiguity(order[0]);
-    unsigned alignment = std::min(maxMultiple, maxContig);
-    unsigned perThread = std::min(alignment, 128 / numBits);
-    sizePerThread[order[0]] = std::min<int>(perThread, numElemsPerThread);
-
-    SmallVector<unsigned> dims(rank);
-    std::iota(dims.begin(), dims.end(), 0);
-    // create encoding
-    Attribute encoding = triton::gpu::BlockedEncodingAttr::get(
-        &getContext(), origType.getShape(), sizePerThread, order, numWarps);
-    return encoding;
+    unsigned numBits = getPointeeBits(origType);
+    unsigned perThread = getVectorSize(info, fastest, 128 / numBits, numBits);
+    sizePerThread[fastest] = std::min<int>(perThread, numElemsPerThread);
+
+    return triton::gpu::BlockedEncodingAttr::get(
+        &getContext(), origType.getShape(), sizePerThread, order, numWarps,
+        threadsPerWarp);
+  }
+
+  // Among the encodings whose fastest axis is one of the axes of the tensor,
+  // picks the one with the best sector efficiency, and the most contiguous
+  // axis first among those
+  Attribute getCoalescedEncoding(AxisInfoAnalysis &axisInfo, Value ptr,
+                                 int numWarps, int threadsPerWarp) {
+    auto origType = ptr.getType().cast<RankedTensorType>();
+    size_t rank = origType.getRank();
+    AxisInfo info = axisInfo.lookupLatticeElement(ptr)->getValue();
+    SmallVector<unsigned, 4> axes(rank);
+    std::iota(axes.begin(), axes.end(), 0);
+    auto contiguity = info.getContiguity();
+    std::stable_sort(axes.begin(), axes.end(), [&](unsigned x, unsigned y) {
+      return contiguity[x] > contiguity[y];
+    });
+
+    unsigned numBits = getPointeeBits(origType);
+    triton::gpu::BlockedEncodingAttr best;
+    double bestEfficiency = 0;
+    for (unsigned axis : axes) {
+      auto encoding = getCoalescedEncoding(info, origType, axis, numWarps,
+                                           threadsPerWarp);
+      double efficiency =
+          getSectorEfficiency(info, encoding, origType.getShape(), numBits);
+      if (!best || efficiency > bestEfficiency) {
+        best = encoding;
+        bestEfficiency = efficiency;
+      }
+    }
+    return best;
+  }
+
+  void report(AxisInfoAnalysis &axisInfo, Operation *op, Value ptr) {
+    auto ptrType = ptr.getType().cast<RankedTensorType>();
+    auto layout =
+        ptrType.getEncoding().dyn_cast<triton::gpu::BlockedEncodingAttr>();
+    if (!layout)
+      return;
+    AxisInfo info = axisInfo.lookupLatticeElement(ptr)->getValue();
+    unsigned numBits = getPointeeBits(ptrType);
+    unsigned axis = layout.getOrder()[0];
+    unsigned vec = getVectorSize(info, axis, layout.getSizePerThread()[axis],
+                                 numBits);
+    double efficiency =
+        getSectorEfficiency(info, layout, ptrType.getShape(), numBits);
+    op->emitRemark() << vec << "x" << numBits
+                     << "-bit accesses per thread along axis " << axis << ", "
+                     << int(efficiency * 100 + 0.5) << "% sector efficiency";
   }
 
   std::function<Type(Type)> getTypeConverter(AxisInfoAnalysis &axisInfo,
-                                             Value ptr, int numWarps) {
-    Attribute encoding = getCoalescedEncoding(axisInfo, ptr, numWarps);
+                                             Value ptr, int numWarps,
+                                             int threadsPerWarp) {
+    Attribute encoding =
+        getCoalescedEncoding(axisInfo, ptr, numWarps, threadsPerWarp);
     return [encoding](Type _type) {
       RankedTensorType type = _type.cast<RankedTensorType>();
       return RankedTensorType::get(type.getShape(), type.getElementType(),
@@ -60,17 +158,29 @@ struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
     };
   }
 
+  // Returns whether `op` was rewritten, i.e. was not already coalesced
   template <class T>
-  void coalesceOp(AxisInfoAnalysis &axisInfo, Operation *op, Value ptr,
+  bool coalesceOp(AxisInfoAnalysis &axisInfo, Operation *op, Value ptr,
                   OpBuilder builder) {
     RankedTensorType ty = ptr.getType().template dyn_cast<RankedTensorType>();
     if (!ty)
-      return;
+      return false;
     auto mod = op->getParentOfType<ModuleOp>();
     int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+    int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
 
-    AxisInfo info = axisInfo.lookupLatticeElement(ptr)->getValue();
-    auto convertType = getTypeConverter(axisInfo, ptr, numWarps);
+    auto convertType =
+        getTypeConverter(axisInfo, ptr, numWarps, threadsPerWarp);
+    bool is_async = std::is_same<T, triton::gpu::InsertSliceAsyncOp>::value;
+    auto isCoalesced = [&](Type type) {
+      auto tensorTy = type.dyn_cast<RankedTensorType>();
+      return !tensorTy ||
+             tensorTy.getEncoding().isa<triton::gpu::SharedEncodingAttr>() ||
+             convertType(type) == type;
+    };
+    if (llvm::all_of(op->getOperandTypes(), isCoalesced) &&
+        (is_async || llvm::all_of(op->getResultTypes(), isCoalesced)))
+      return false;
     // convert operands
     SmallVector<Value, 4> newArgs;
     for (auto v : op->getOperands()) {
@@ -83,10 +193,8 @@ struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
     }
     // convert output types
     SmallVector<Type, 4> newTypes;
-    for (auto t : op->getResultTypes()) {
-      bool is_async = std::is_same<T, triton::gpu::InsertSliceAsyncOp>::value;
+    for (auto t : op->getResultTypes())
       newTypes.push_back(is_async ? t : convertType(t));
-    }
     // construct new op with the new encoding
     Operation *newOp =
         builder.create<T>(op->getLoc(), newTypes, newArgs, op->getAttrs());
@@ -100,14 +208,15 @@ struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
       op->getResult(i).replaceAllUsesWith(newResult);
     }
     op->erase();
+    return true;
   }
 
   void runOnOperation() override {
     Operation *op = getOperation();
-    // Run axis info analysis
-    AxisInfoAnalysis axisInfo(&getContext());
-    axisInfo.run(op);
+    // Run axis info analysis, unless a previous pass left it valid
+    AxisInfoAnalysis &axisInfo = getAnalysis<CachedAxisInfoAnalysis>();
     OpBuilder builder(op);
+    bool changed = false;
 
     // For each memory op that has a layout L1:
     // 1. Create a coalesced memory layout L2 of the pointer operands
@@ -120,20 +229,53 @@ struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
       OpBuilder::InsertionGuard g(builder);
       builder.setInsertionPoint(curr);
       if (auto load = dyn_cast<triton::LoadOp>(curr))
-        coalesceOp<triton::LoadOp>(axisInfo, curr, load.ptr(), builder);
+        changed |=
+            coalesceOp<triton::LoadOp>(axisInfo, curr, load.ptr(), builder);
       if (auto op = dyn_cast<triton::AtomicRMWOp>(curr))
-        coalesceOp<triton::AtomicRMWOp>(axisInfo, curr, op.ptr(), builder);
+        changed |=
+            coalesceOp<triton::AtomicRMWOp>(axisInfo, curr, op.ptr(), builder);
       if (auto op = dyn_cast<triton::AtomicCASOp>(curr))
-        coalesceOp<triton::AtomicCASOp>(axisInfo, curr, op.ptr(), builder);
+        changed |=
+            coalesceOp<triton::AtomicCASOp>(axisInfo, curr, op.ptr(), builder);
       if (auto load = dyn_cast<triton::gpu::InsertSliceAsyncOp>(curr))
-        coalesceOp<triton::gpu::InsertSliceAsyncOp>(axisInfo, curr, load.src(),
-                                                    builder);
+        changed |= coalesceOp<triton::gpu::InsertSliceAsyncOp>(
+            axisInfo, curr, load.src(), builder);
       if (auto store = dyn_cast<triton::StoreOp>(curr))
-        coalesceOp<triton::StoreOp>(axisInfo, curr, store.ptr(), builder);
+        changed |=
+            coalesceOp<triton::StoreOp>(axisInfo, curr, store.ptr(), builder);
+    });
+    if (!changed)
+      markAllAnalysesPreserved();
+
+    // Report the expected efficiency of the coalesced accesses, the new ops
+    // not being known to the analysis yet
+    if (!reportSectorEfficiency)
+      return;
+    Optional<AxisInfoAnalysis> newAxisInfo;
+    if (changed) {
+      newAxisInfo.emplace(&getContext());
+      newAxisInfo->run(op);
+    }
+    AxisInfoAnalysis &finalAxisInfo = changed ? *newAxisInfo : axisInfo;
+    op->walk([&](Operation *curr) {
+      Value ptr;
+      if (auto load = dyn_cast<triton::LoadOp>(curr))
+        ptr = load.ptr();
+      else if (auto store = dyn_cast<triton::StoreOp>(curr))
+        ptr = store.ptr();
+      else if (auto atomic = dyn_cast<triton::AtomicRMWOp>(curr))
+        ptr = atomic.ptr();
+      else if (auto cas = dyn_cast<triton::AtomicCASOp>(curr))
+        ptr = cas.ptr();
+      else if (auto copy = dyn_cast<triton::gpu::InsertSliceAsyncOp>(curr))
+        ptr = copy.src();
+      if (ptr && ptr.getType().isa<RankedTensorType>())
+        report(finalAxisInfo, curr, ptr);
     });
   }
 };
 
-std::unique_ptr<Pass> mlir::createTritonGPUCoalescePass() {
-  return std::make_unique<CoalescePass>();
+std::unique_ptr<Pass>
+mlir::createTritonGPUCoalescePass(bool reportSectorEfficiency) {
+  return std::make_unique<CoalescePass>(reportSectorEfficiency);
 }
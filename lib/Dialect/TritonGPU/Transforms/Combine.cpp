@@ -100,11 +100,10 @@ public:
     if (!reduceArg)
       return mlir::failure();
     // this may generate unsupported conversions in the LLVM codegen
-    if (reduceArg.getOperand()
-            .getType()
-            .cast<RankedTensorType>()
-            .getEncoding()
-            .isa<triton::gpu::MmaEncodingAttr>())
+    auto argEncoding =
+        reduceArg.getOperand().getType().cast<RankedTensorType>().getEncoding();
+    if (argEncoding.isa<triton::gpu::MmaEncodingAttr>() ||
+        argEncoding.isa<triton::gpu::MfmaEncodingAttr>())
       return mlir::failure();
     auto newReduce = rewriter.create<triton::ReduceOp>(
         op->getLoc(), reduce.redOp(), reduceArg.getOperand(), reduce.axis());
@@ -311,22 +310,37 @@ inline bool expensiveToRemat(Operation *op, Attribute &targetEncoding) {
           triton::gpu::InsertSliceAsyncOp, triton::AtomicRMWOp,
           triton::AtomicCASOp, triton::DotOp>(op))
     return true;
+  // The results of generic reductions, scans and sorts can't be
+  // rematerialized one at a time
+  if (isa<triton::GenericReduceOp, triton::ScanOp, triton::SortOp>(op))
+    return true;
+  // Joins and splits change the rank of their operands, and ordered cats are
+  // only lowered in blocked layouts
+  if (isa<triton::JoinOp, triton::SplitOp>(op))
+    return true;
+  // Philox rounds are long, and have several results
+  if (isa<triton::PhiloxOp>(op))
+    return true;
+  if (auto catOp = dyn_cast<triton::CatOp>(op))
+    if (catOp.axis())
+      return true;
   if (isa<scf::YieldOp, scf::ForOp, scf::IfOp, scf::WhileOp, scf::ConditionOp>(
           op))
     return true;
   return false;
 }
 
+// Simulate rematerializing `initOp` and the values it depends on in
+// `targetEncoding`, and succeed if `costModel` finds the layout conversions
+// and recomputations it introduces cheaper than converting `initOp`.
 LogicalResult simulateBackwardRematerialization(
     Operation *initOp, SetVector<Operation *> &processed,
     SetVector<Attribute> &layout, llvm::MapVector<Value, Attribute> &toConvert,
-    const Attribute &targetEncoding) {
+    const Attribute &targetEncoding, const LayoutCostModel &costModel) {
   // DFS
   std::vector<std::pair<Operation *, Attribute>> queue;
   queue.emplace_back(initOp, targetEncoding);
-  // We want to see the effect of converting `initOp` to a new layout
-  // so we initialize `numCvts = 1`.
-  int numCvts = 1;
+  llvm::MapVector<Operation *, Attribute> rematLayouts;
   while (!queue.empty()) {
     Operation *currOp;
     Attribute currLayout;
@@ -336,11 +350,10 @@ LogicalResult simulateBackwardRematerialization(
     // we stop everything
     if (expensiveToRemat(currOp, currLayout))
       break;
-    // A conversion will be removed here (i.e. transferred to operands)
-    numCvts -= 1;
     // Done processing
     processed.insert(currOp);
     layout.insert(currLayout);
+    rematLayouts.insert({currOp, currLayout});
     // Add all operands to the queue
     for (Value argI : currOp->getOperands()) {
       Attribute newEncoding;
@@ -365,14 +378,50 @@ LogicalResult simulateBackwardRematerialization(
       if (isa<triton::gpu::ConvertLayoutOp, arith::ConstantOp,
               triton::MakeRangeOp, triton::SplatOp>(*opArgI))
         continue;
-      // We add one expensive conversion for the current operand
-      numCvts += 1;
       queue.emplace_back(opArgI, newEncoding);
     }
   }
-  // if rematerialization would add more conversions than it removes
+  // Nothing can be rematerialized
+  if (llvm::all_of(processed, [](Operation *op) {
+        return isa<triton::gpu::ConvertLayoutOp>(op);
+      }))
+    return mlir::failure();
+
+  // The conversion we want to get rid of
+  Value initValue = isa<triton::gpu::ConvertLayoutOp>(initOp)
+                        ? initOp->getOperand(0)
+                        : initOp->getResult(0);
+  double currCost = costModel.getConversionCost(
+      initValue.getType().cast<RankedTensorType>(), targetEncoding, initOp);
+  // Conversions of the operands the rematerialized slice starts from
+  double newCost = 0.0;
+  for (auto &item : toConvert) {
+    Value v = item.first;
+    auto tensorTy = v.getType().dyn_cast<RankedTensorType>();
+    Operation *defOp = v.getDefiningOp();
+    if (!tensorTy || (defOp && processed.contains(defOp)))
+      continue;
+    if (defOp && isa<triton::gpu::ConvertLayoutOp, arith::ConstantOp,
+                     triton::MakeRangeOp, triton::SplatOp>(defOp))
+      continue;
+    newCost += costModel.getConversionCost(tensorTy, item.second,
+                                           defOp ? defOp : initOp);
+  }
+  // Rematerialized ops that still have users in their original layout are
+  // computed twice
+  for (auto &item : rematLayouts) {
+    Operation *op = item.first;
+    if (isa<triton::gpu::ConvertLayoutOp>(op))
+      continue;
+    bool isDead = llvm::all_of(op->getUsers(), [&](Operation *user) {
+      return processed.contains(user);
+    });
+    if (!isDead)
+      newCost += costModel.getRematerializationCost(op, item.second);
+  }
+  // if rematerialization costs more than the conversion it removes
   // then we don't do it
-  if (numCvts > 0)
+  if (newCost > currCost)
     return mlir::failure();
   return mlir::success();
 }
@@ -506,9 +555,11 @@ public:
 //
 class FoldConvertAndReduce : public mlir::RewritePattern {
 public:
-  explicit FoldConvertAndReduce(mlir::MLIRContext *context)
+  explicit FoldConvertAndReduce(mlir::MLIRContext *context,
+                                const LayoutCostModel &costModel)
       : mlir::RewritePattern(triton::gpu::ConvertLayoutOp::getOperationName(),
-                             1, context) {}
+                             1, context),
+        costModel(costModel) {}
 
   mlir::LogicalResult
   matchAndRewrite(mlir::Operation *cvtOp,
@@ -548,8 +599,8 @@ public:
         SetVector<Attribute> layout;
         llvm::MapVector<Value, Attribute> toConvert;
         if (argOp && (argOp != cvt) && cvtSlices.count(argOp) == 0 &&
-            failed(simulateBackwardRematerialization(argOp, processed, layout,
-                                                     toConvert, srcEncoding))) {
+            failed(simulateBackwardRematerialization(
+                argOp, processed, layout, toConvert, srcEncoding, costModel))) {
           return failure();
         }
       }
@@ -585,6 +636,9 @@ public:
     rewriter.replaceOp(op, newCvt->getResults());
     return success();
   }
+
+private:
+  const LayoutCostModel &costModel;
 };
 
 // Layout conversions are expensive. They require going through
@@ -595,9 +649,11 @@ public:
 // are reachable from it without passing through any memory operation.
 class RematerializeBackward : public mlir::RewritePattern {
 public:
-  explicit RematerializeBackward(mlir::MLIRContext *context)
+  explicit RematerializeBackward(mlir::MLIRContext *context,
+                                 const LayoutCostModel &costModel)
       : mlir::RewritePattern(triton::gpu::ConvertLayoutOp::getOperationName(),
-                             2, context) {}
+                             2, context),
+        costModel(costModel) {}
 
   mlir::LogicalResult
   matchAndRewrite(mlir::Operation *cvt,
@@ -615,15 +671,18 @@ public:
     // we don't handle conversions to DotOperandEncodingAttr
     // this is a heuristics to accommodate fused attention
     auto targetType = cvt->getResultTypes()[0].cast<RankedTensorType>();
-    if (targetType.getEncoding().isa<triton::gpu::DotOperandEncodingAttr>())
+    if (targetType.getEncoding().isa<triton::gpu::DotOperandEncodingAttr,
+                                     triton::gpu::SparseDotMetaEncodingAttr>())
       return mlir::failure();
     // DFS
     SetVector<Operation *> processed;
     SetVector<Attribute> layout;
     llvm::MapVector<Value, Attribute> toConvert;
     std::vector<std::pair<Operation *, Attribute>> queue;
-    if (failed(simulateBackwardRematerialization(
-            cvt, processed, layout, toConvert, targetType.getEncoding())))
+    if (failed(simulateBackwardRematerialization(cvt, processed, layout,
+                                                 toConvert,
+                                                 targetType.getEncoding(),
+                                                 costModel)))
       return mlir::failure();
 
     SmallVector<Value, 4> sortedValues;
@@ -662,6 +721,9 @@ public:
     rewriter.replaceOp(cvt, mapping.lookup(cvt->getOperand(0)));
     return mlir::success();
   }
+
+private:
+  const LayoutCostModel &costModel;
 };
 
 // -----------------------------------------------------------------------------
@@ -822,6 +884,9 @@ public:
       if (!op->hasTrait<mlir::OpTrait::SameOperandsAndResultEncoding>() &&
           !op->hasTrait<mlir::OpTrait::SameOperandsAndResultType>())
         return failure();
+      if (auto catOp = dyn_cast<triton::CatOp>(op))
+        if (catOp.axis())
+          return failure();
       for (Value arg : op->getOperands()) {
         Operation *argOp = arg.getDefiningOp();
         if (argOp && (argOp != cvt) &&
@@ -857,6 +922,210 @@ public:
   }
 };
 
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+
+// Cost of providing `value` in `encoding`: nothing if its backward slice can
+// be rematerialized without loads or dots, the conversion of the values it
+// stops at otherwise
+double getOperandConversionCost(Value value, Attribute encoding,
+                                Operation *where,
+                                const LayoutCostModel &costModel,
+                                int depth = 0) {
+  auto tensorTy = value.getType().dyn_cast<RankedTensorType>();
+  if (!tensorTy)
+    return 0.0;
+  Operation *op = value.getDefiningOp();
+  if (op && isa<triton::gpu::ConvertLayoutOp, arith::ConstantOp,
+                triton::MakeRangeOp, triton::SplatOp>(op))
+    return 0.0;
+  Attribute operandEncoding;
+  if (!op || depth > 16 || op->getNumResults() != 1 ||
+      op->getBlock() != where->getBlock() ||
+      expensiveToRemat(op, encoding) ||
+      failed(invertEncoding(encoding, op, operandEncoding)))
+    return costModel.getConversionCost(tensorTy, encoding, op ? op : where);
+  double cost = costModel.getRematerializationCost(op, encoding);
+  for (Value operand : op->getOperands())
+    cost += getOperandConversionCost(operand, operandEncoding, where,
+                                     costModel, depth + 1);
+  return cost;
+}
+
+// Elementwise epilogues of dots are computed and stored in the mma layout
+// rather than converting the accumulator to a blocked layout through shared
+// memory:
+//
+//   %c = convert_layout(%acc) : #mma -> #blocked
+//   store(%ptr, truncf(%c + %bias))
+//
+// becomes
+//
+//   store(convert_layout(%ptr), truncf(%acc + convert_layout(%bias)))
+//
+// when the operands of the epilogue are cheaper to provide in the mma layout
+// than the accumulator is to convert, e.g. because like the pointers, they
+// derive from make_range and splats.
+//
+// Fragments are only a few elements wide along the rows, so values of 16 bits
+// or less are instead converted back right before their stores when the
+// blocked layout writes wider vectors: the conversion through shared memory
+// of the narrow result is cheaper than that of the accumulator, and the
+// stores stay 128-bit wide and coalesced.
+class SinkConversionIntoStore : public mlir::RewritePattern {
+public:
+  explicit SinkConversionIntoStore(mlir::MLIRContext *context,
+                                   const LayoutCostModel &costModel)
+      : mlir::RewritePattern(triton::gpu::ConvertLayoutOp::getOperationName(),
+                             2, context),
+        costModel(costModel) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::Operation *op,
+                  mlir::PatternRewriter &rewriter) const override {
+    auto cvt = cast<triton::gpu::ConvertLayoutOp>(op);
+    auto srcType = cvt.getOperand().getType().cast<RankedTensorType>();
+    auto dstType = cvt.getType().cast<RankedTensorType>();
+    Attribute srcEncoding = srcType.getEncoding();
+    // The elements of mma v1 fragments are not ordered along the columns as
+    // the store vectorization expects
+    auto mmaLayout = srcEncoding.dyn_cast<MmaEncodingAttr>();
+    if (!(mmaLayout && (mmaLayout.isAmpere() || mmaLayout.isHopper())) &&
+        !srcEncoding.isa<triton::gpu::MfmaEncodingAttr>())
+      return failure();
+    if (!dstType.getEncoding().isa<triton::gpu::BlockedEncodingAttr>())
+      return failure();
+
+    // The converted value must only flow into stores, through elementwise ops
+    // that keep its layout
+    Block *block = cvt->getBlock();
+    SetVector<Operation *> slice;
+    mlir::getForwardSlice(cvt.getResult(), &slice, [&](Operation *user) {
+      return user->getBlock() == block;
+    });
+    bool hasStore = false;
+    for (Operation *sliceOp : slice) {
+      if (auto storeOp = dyn_cast<triton::StoreOp>(sliceOp)) {
+        if (slice.contains(storeOp.ptr().getDefiningOp()) ||
+            (storeOp.mask() && slice.contains(storeOp.mask().getDefiningOp())))
+          return failure();
+        hasStore = true;
+        continue;
+      }
+      if (!sliceOp->hasTrait<mlir::OpTrait::Elementwise>() &&
+          !sliceOp->hasTrait<mlir::OpTrait::SameOperandsAndResultEncoding>())
+        return failure();
+      if (auto catOp = dyn_cast<triton::CatOp>(sliceOp))
+        if (catOp.axis())
+          return failure();
+      if (sliceOp->getNumResults() != 1 || sliceOp->getNumRegions() != 0 ||
+          !MemoryEffectOpInterface::hasNoEffect(sliceOp))
+        return failure();
+      auto resultType =
+          sliceOp->getResult(0).getType().dyn_cast<RankedTensorType>();
+      if (!resultType || resultType.getEncoding() != dstType.getEncoding())
+        return failure();
+    }
+    if (!hasStore)
+      return failure();
+    auto isInSlice = [&](Operation *user) { return slice.contains(user); };
+    if (!llvm::all_of(cvt->getUsers(), isInSlice) ||
+        !llvm::all_of(slice, [&](Operation *sliceOp) {
+          return llvm::all_of(sliceOp->getUsers(), isInSlice);
+        }))
+      return failure();
+
+    auto isStaged = [&](triton::StoreOp storeOp) {
+      Type elemTy = getElementTypeOrSelf(storeOp.value().getType());
+      if (!elemTy.isIntOrFloat() || elemTy.getIntOrFloatBitWidth() > 16)
+        return false;
+      Attribute dstEncoding = dstType.getEncoding();
+      unsigned dstVec = triton::gpu::getContigPerThread(
+          dstEncoding)[triton::gpu::getOrder(dstEncoding)[0]];
+      unsigned srcVec = triton::gpu::getContigPerThread(
+          srcEncoding)[triton::gpu::getOrder(srcEncoding)[0]];
+      return dstVec > srcVec;
+    };
+
+    // Compare the conversion of the accumulator to the conversions of the
+    // other operands of the epilogue, and of the staged values
+    double currCost =
+        costModel.getConversionCost(srcType, dstType.getEncoding(), cvt);
+    double newCost = 0.0;
+    SetVector<Value> operands;
+    for (Operation *sliceOp : slice) {
+      auto storeOp = dyn_cast<triton::StoreOp>(sliceOp);
+      if (storeOp && isStaged(storeOp)) {
+        auto valueType = storeOp.value().getType().cast<RankedTensorType>();
+        newCost += costModel.getConversionCost(
+            RankedTensorType::get(valueType.getShape(),
+                                  valueType.getElementType(), srcEncoding),
+            valueType.getEncoding(), storeOp);
+        continue;
+      }
+      for (Value operand : sliceOp->getOperands())
+        if (operand.getDefiningOp() != cvt &&
+            !slice.contains(operand.getDefiningOp()))
+          operands.insert(operand);
+    }
+    if (newCost >= currCost)
+      return failure();
+    for (Value operand : operands) {
+      newCost += getOperandConversionCost(operand, srcEncoding, cvt, costModel);
+      if (newCost >= currCost)
+        return failure();
+    }
+
+    // Rebuild the epilogue in the mma layout, in program order so that the
+    // conversions of the operands dominate all their users
+    SmallVector<Operation *> sortedSlice(slice.begin(), slice.end());
+    llvm::sort(sortedSlice, [](Operation *lhs, Operation *rhs) {
+      return lhs->isBeforeInBlock(rhs);
+    });
+    BlockAndValueMapping mapping;
+    mapping.map(cvt.getResult(), cvt.getOperand());
+    for (Operation *sliceOp : sortedSlice) {
+      rewriter.setInsertionPoint(sliceOp);
+      auto storeOp = dyn_cast<triton::StoreOp>(sliceOp);
+      if (storeOp && isStaged(storeOp)) {
+        Value value = storeOp.value();
+        BlockAndValueMapping storeMapping;
+        storeMapping.map(value,
+                         rewriter.create<triton::gpu::ConvertLayoutOp>(
+                             value.getLoc(), value.getType(),
+                             mapping.lookup(value)));
+        rewriter.clone(*storeOp, storeMapping);
+        continue;
+      }
+      for (Value operand : sliceOp->getOperands()) {
+        auto operandType = operand.getType().dyn_cast<RankedTensorType>();
+        if (mapping.contains(operand) || !operandType)
+          continue;
+        auto newType =
+            RankedTensorType::get(operandType.getShape(),
+                                  operandType.getElementType(), srcEncoding);
+        mapping.map(operand, rewriter.create<triton::gpu::ConvertLayoutOp>(
+                                 operand.getLoc(), newType, operand));
+      }
+      Operation *newOp = rewriter.clone(*sliceOp, mapping);
+      if (newOp->getNumResults() == 1) {
+        auto resultType =
+            newOp->getResult(0).getType().cast<RankedTensorType>();
+        newOp->getResult(0).setType(RankedTensorType::get(
+            resultType.getShape(), resultType.getElementType(), srcEncoding));
+      }
+    }
+    for (Operation *sliceOp : llvm::reverse(sortedSlice))
+      rewriter.eraseOp(sliceOp);
+    rewriter.eraseOp(cvt);
+    return success();
+  }
+
+private:
+  const LayoutCostModel &costModel;
+};
+
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
@@ -869,8 +1138,7 @@ int computeCapabilityToMMAVersion(int computeCapability) {
   } else if (computeCapability < 90) {
     return 2;
   } else if (computeCapability < 100) {
-    // FIXME: temporarily add this to pass unis tests
-    return 2;
+    return 3;
   } else {
     assert(false && "computeCapability > 100 not supported");
     return 3;
@@ -880,7 +1148,7 @@ int computeCapabilityToMMAVersion(int computeCapability) {
 SmallVector<int64_t, 2> mmaVersionToShapePerWarp(int version) {
   if (version == 1)
     return {16, 16};
-  else if (version == 2)
+  else if (version == 2 || version == 3)
     return {16, 8};
   else {
     assert(false && "version not supported");
@@ -894,11 +1162,11 @@ SmallVector<unsigned, 2> warpsPerTileV1(const ArrayRef<int64_t> shape,
   return {static_cast<unsigned>(numWarps), 1};
 }
 
-SmallVector<unsigned, 2> warpsPerTileV2(triton::DotOp dotOp,
+SmallVector<unsigned, 2> warpsPerTileV2(Operation *dotOp,
                                         const ArrayRef<int64_t> shape,
                                         int numWarps) {
   SetVector<Operation *> slices;
-  mlir::getForwardSlice(dotOp.getResult(), &slices);
+  mlir::getForwardSlice(dotOp->getResult(0), &slices);
   if (llvm::find_if(slices, [](Operation *op) {
         return isa<triton::DotOp>(op);
       }) != slices.end())
@@ -928,6 +1196,60 @@ SmallVector<unsigned, 2> warpsPerTileV2(triton::DotOp dotOp,
   return ret;
 }
 
+// The warps of a warpgroup compute together 64 rows of the result with
+// wgmma, so all the warps are along M
+SmallVector<unsigned, 2> warpsPerTileV3(const ArrayRef<int64_t> shape,
+                                        int numWarps) {
+  return {static_cast<unsigned>(numWarps), 1};
+}
+
+// Tell whether a dot can be lowered to wgmma: every warpgroup owns a multiple
+// of 64 rows, and the contiguous dimension of $b spans one of the swizzling
+// widths of the wgmma shared memory layouts. Others use mma.sync on Hopper.
+bool supportWGMMA(triton::DotOp dotOp, int numWarps) {
+  if (!supportMMA(dotOp, 3) || numWarps % 4 != 0)
+    return false;
+  auto retShape = dotOp.getType().cast<RankedTensorType>().getShape();
+  if (retShape[0] % (16 * numWarps) != 0)
+    return false;
+  auto bType = dotOp.b().getType().cast<RankedTensorType>();
+  auto bOrder = triton::gpu::getOrder(
+      bType.getEncoding().cast<DotOperandEncodingAttr>().getParent());
+  int64_t contigBytes =
+      bType.getShape()[bOrder[0]] * bType.getElementTypeBitWidth() / 8;
+  return contigBytes == 32 || contigBytes == 64 || contigBytes == 128;
+}
+
+// Number of 64-lane wavefronts along each dimension of the result of a dot
+// lowered to 32x32 MFMA instructions.
+SmallVector<unsigned, 2> wavesPerTileMFMA(triton::DotOp dotOp,
+                                          const ArrayRef<int64_t> shape,
+                                          int numWaves) {
+  SetVector<Operation *> slices;
+  mlir::getForwardSlice(dotOp.getResult(), &slices);
+  if (llvm::find_if(slices, [](Operation *op) {
+        return isa<triton::DotOp>(op);
+      }) != slices.end())
+    return {(unsigned)numWaves, 1};
+
+  SmallVector<unsigned, 2> ret = {1, 1};
+  SmallVector<int64_t, 2> shapePerWave = {32, 32};
+  do {
+    if (ret[0] * ret[1] >= numWaves)
+      break;
+    if (shape[0] / shapePerWave[0] / ret[0] >=
+        shape[1] / shapePerWave[1] / ret[1]) {
+      if (ret[0] < shape[0] / shapePerWave[0])
+        ret[0] *= 2;
+      else
+        ret[1] *= 2;
+    } else {
+      ret[1] *= 2;
+    }
+  } while (true);
+  return ret;
+}
+
 } // namespace
 
 class OptimizeBlockedToShared : public mlir::RewritePattern {
@@ -1043,6 +1365,8 @@ public:
       return warpsPerTileV1(shape, numWarps);
     case 2:
       return warpsPerTileV2(dotOp, shape, numWarps);
+    case 3:
+      return warpsPerTileV3(shape, numWarps);
     default:
       assert(false && "not supported version");
       return {0, 0};
@@ -1058,12 +1382,20 @@ public:
     if (!oldRetType.getEncoding() ||
         oldRetType.getEncoding().isa<triton::gpu::MmaEncodingAttr>())
       return failure();
+    // mma layouts are 2D: batched dots stay on the FMA path
+    if (oldRetType.getRank() != 2)
+      return failure();
 
     auto AType = dotOp.getOperand(0).getType().cast<RankedTensorType>();
     auto BType = dotOp.getOperand(1).getType().cast<RankedTensorType>();
 
+    auto mod = op->getParentOfType<mlir::ModuleOp>();
+    int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+
     // for FMA, should retain the blocked layout.
     int versionMajor = computeCapabilityToMMAVersion(computeCapability);
+    if (versionMajor == 3 && !supportWGMMA(dotOp, numWarps))
+      versionMajor = 2;
     if (!supportMMA(dotOp, versionMajor))
       return failure();
 
@@ -1080,8 +1412,6 @@ public:
 
     // get MMA encoding for the given number of warps
     auto retShape = oldRetType.getShape();
-    auto mod = op->getParentOfType<mlir::ModuleOp>();
-    int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
 
     auto warpsPerTile =
         getWarpsPerTile(dotOp, retShape, versionMajor, numWarps);
@@ -1089,12 +1419,12 @@ public:
     if (versionMajor == 1) {
       mmaEnc = triton::gpu::MmaEncodingAttr::get(
           oldRetType.getContext(), versionMajor, numWarps, mmaV1Counter++);
-    } else if (versionMajor == 2) {
+    } else if (versionMajor == 2 || versionMajor == 3) {
       mmaEnc = triton::gpu::MmaEncodingAttr::get(
           oldRetType.getContext(), versionMajor, 0 /*versionMinor*/,
           warpsPerTile);
     } else {
-      assert(false && "Mma layout only support versionMajor of 1 or 2");
+      assert(false && "Mma layout only support versionMajor of 1, 2 or 3");
     }
     auto newRetType =
         RankedTensorType::get(retShape, oldRetType.getElementType(), mmaEnc);
@@ -1135,8 +1465,135 @@ public:
 
     a = rewriter.create<triton::gpu::ConvertLayoutOp>(a.getLoc(), newAType, a);
     b = rewriter.create<triton::gpu::ConvertLayoutOp>(b.getLoc(), newBType, b);
-    auto newDot = rewriter.create<triton::DotOp>(dotOp.getLoc(), newRetType, a,
-                                                 b, newAcc, dotOp.allowTF32());
+    auto newDot = rewriter.create<triton::DotOp>(
+        dotOp.getLoc(), newRetType, a, b, newAcc, dotOp.allowTF32Attr(),
+        dotOp.aFp8FormatAttr(), dotOp.bFp8FormatAttr(),
+        dotOp.precisionAttr());
+
+    rewriter.replaceOpWithNewOp<triton::gpu::ConvertLayoutOp>(
+        op, oldRetType, newDot.getResult());
+    return success();
+  }
+};
+
+// Same as BlockedToMMA for the dots of 2:4 sparse matrices, lowered to
+// mma.sp.m16n8k32 from sm_80 on: $aMeta gets the layout of the metadata
+// registers of the mma layout.
+class BlockedToSparseMMA : public mlir::RewritePattern {
+  int computeCapability;
+
+public:
+  BlockedToSparseMMA(mlir::MLIRContext *context, int computeCapability)
+      : mlir::RewritePattern(triton::SparseDotOp::getOperationName(), 2,
+                             context),
+        computeCapability(computeCapability) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::Operation *op,
+                  mlir::PatternRewriter &rewriter) const override {
+    auto dotOp = cast<triton::SparseDotOp>(op);
+    auto oldRetType = dotOp.getType().cast<RankedTensorType>();
+    if (!oldRetType.getEncoding() ||
+        oldRetType.getEncoding().isa<triton::gpu::MmaEncodingAttr>())
+      return failure();
+    if (computeCapability < 80 || !supportSparseMMA(dotOp))
+      return failure();
+
+    auto mod = op->getParentOfType<mlir::ModuleOp>();
+    int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+    auto retShape = oldRetType.getShape();
+    auto mmaEnc = triton::gpu::MmaEncodingAttr::get(
+        oldRetType.getContext(), 2, 0 /*versionMinor*/,
+        warpsPerTileV2(dotOp, retShape, numWarps));
+    auto newRetType =
+        RankedTensorType::get(retShape, oldRetType.getElementType(), mmaEnc);
+
+    auto convert = [&](Value operand, Attribute encoding) -> Value {
+      auto type = operand.getType().cast<RankedTensorType>();
+      auto newType = RankedTensorType::get(type.getShape(),
+                                           type.getElementType(), encoding);
+      return rewriter.create<triton::gpu::ConvertLayoutOp>(operand.getLoc(),
+                                                           newType, operand);
+    };
+    Value a = convert(dotOp.a(),
+                      DotOperandEncodingAttr::get(getContext(), 0, mmaEnc));
+    Value aMeta = convert(
+        dotOp.aMeta(),
+        triton::gpu::SparseDotMetaEncodingAttr::get(getContext(), mmaEnc));
+    Value b = convert(dotOp.b(),
+                      DotOperandEncodingAttr::get(getContext(), 1, mmaEnc));
+    Value c = convert(dotOp.c(), mmaEnc);
+    auto newDot = rewriter.create<triton::SparseDotOp>(
+        dotOp.getLoc(), newRetType, a, aMeta, b, c);
+
+    rewriter.replaceOpWithNewOp<triton::gpu::ConvertLayoutOp>(
+        op, oldRetType, newDot.getResult());
+    return success();
+  }
+};
+
+// Same as BlockedToMMA, but targets the matrix cores of AMD CDNA GPUs.
+// A wavefront has 64 lanes, so the mfma layout is distributed over
+// numWarps * threadsPerWarp / 64 wavefronts.
+class BlockedToMFMA : public mlir::RewritePattern {
+public:
+  BlockedToMFMA(mlir::MLIRContext *context)
+      : mlir::RewritePattern(triton::DotOp::getOperationName(), 2, context) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::Operation *op,
+                  mlir::PatternRewriter &rewriter) const override {
+    auto dotOp = cast<triton::DotOp>(op);
+    auto oldRetType = dotOp.getResult().getType().cast<RankedTensorType>();
+    if (!oldRetType.getEncoding() ||
+        !oldRetType.getEncoding().isa<triton::gpu::BlockedEncodingAttr>())
+      return failure();
+    if (oldRetType.getRank() != 2)
+      return failure();
+
+    // for FMA, should retain the blocked layout.
+    if (!supportMFMA(dotOp))
+      return failure();
+
+    auto mod = op->getParentOfType<mlir::ModuleOp>();
+    int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+    int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+    int numWaves = numWarps * threadsPerWarp / 64;
+    if (numWaves == 0)
+      return failure();
+
+    // get MFMA encoding for the given number of wavefronts
+    auto retShape = oldRetType.getShape();
+    auto wavesPerTile = wavesPerTileMFMA(dotOp, retShape, numWaves);
+    auto mfmaEnc = triton::gpu::MfmaEncodingAttr::get(
+        oldRetType.getContext(), 32 /*nonKDim*/, wavesPerTile);
+    auto newRetType =
+        RankedTensorType::get(retShape, oldRetType.getElementType(), mfmaEnc);
+
+    // convert accumulator
+    auto oldAcc = dotOp.getOperand(2);
+    auto newAcc = rewriter.create<triton::gpu::ConvertLayoutOp>(
+        oldAcc.getLoc(), newRetType, oldAcc);
+    Value a = dotOp.a();
+    Value b = dotOp.b();
+    auto oldAType = a.getType().cast<RankedTensorType>();
+    auto oldBType = b.getType().cast<RankedTensorType>();
+
+    auto newAType = RankedTensorType::get(
+        oldAType.getShape(), oldAType.getElementType(),
+        triton::gpu::DotOperandEncodingAttr::get(oldAType.getContext(), 0,
+                                                 mfmaEnc));
+    auto newBType = RankedTensorType::get(
+        oldBType.getShape(), oldBType.getElementType(),
+        triton::gpu::DotOperandEncodingAttr::get(oldBType.getContext(), 1,
+                                                 mfmaEnc));
+
+    a = rewriter.create<triton::gpu::ConvertLayoutOp>(a.getLoc(), newAType, a);
+    b = rewriter.create<triton::gpu::ConvertLayoutOp>(b.getLoc(), newBType, b);
+    auto newDot = rewriter.create<triton::DotOp>(
+        dotOp.getLoc(), newRetType, a, b, newAcc, dotOp.allowTF32Attr(),
+        dotOp.aFp8FormatAttr(), dotOp.bFp8FormatAttr(),
+        dotOp.precisionAttr());
 
     rewriter.replaceOpWithNewOp<triton::gpu::ConvertLayoutOp>(
         op, oldRetType, newDot.getResult());
@@ -1188,7 +1645,9 @@ public:
     auto newXOrder = triton::gpu::getOrder(argEncoding);
     auto newXEncoding = triton::gpu::SharedEncodingAttr::get(
         getContext(), ZEncoding, XType.getShape(), newXOrder,
-        XType.getElementType());
+        XType.getElementType(),
+        triton::gpu::TritonGPUDialect::getSharedBanks(
+            op->getParentOfType<ModuleOp>()));
     auto newXType = RankedTensorType::get(XType.getShape(),
                                           XType.getElementType(), newXEncoding);
     if (XEncoding == newXEncoding)
@@ -1239,7 +1698,8 @@ public:
         op->getLoc(), dotOp.getResult().getType(), _0f);
     auto newDot = rewriter.create<triton::DotOp>(
         op->getLoc(), dotOp.getResult().getType(), dotOp.getOperand(0),
-        dotOp.getOperand(1), _0, dotOp.allowTF32());
+        dotOp.getOperand(1), _0, dotOp.allowTF32Attr(), dotOp.aFp8FormatAttr(),
+        dotOp.bFp8FormatAttr(), dotOp.precisionAttr());
     auto newCvt = rewriter.create<triton::gpu::ConvertLayoutOp>(
         op->getLoc(), dstTy, newDot.getResult());
     auto newAdd = rewriter.replaceOpWithNewOp<arith::AddFOp>(
@@ -1257,12 +1717,14 @@ class TritonGPUCombineOpsPass
     : public TritonGPUCombineOpsBase<TritonGPUCombineOpsPass> {
 public:
   TritonGPUCombineOpsPass() = default;
-  TritonGPUCombineOpsPass(int computeCapability) {
+  TritonGPUCombineOpsPass(int computeCapability, double rematWeight) {
     this->computeCapability = computeCapability;
+    this->rematWeight = rematWeight;
   }
   void runOnOperation() override {
     MLIRContext *context = &getContext();
     ModuleOp m = getOperation();
+    LayoutCostModel costModel(rematWeight);
 
     mlir::RewritePatternSet patterns(context);
 
@@ -1270,13 +1732,19 @@ public:
     patterns.add<OptimizeConvertToDotOperand>(context);
     patterns.add<SimplifyConversion>(context);
     patterns.add<SimplifyReduceCvt>(context);
-    patterns.add<FoldConvertAndReduce>(context);
+    patterns.add<FoldConvertAndReduce>(context, costModel);
     patterns.add<DecomposeDotOperand>(context);
-    patterns.add<RematerializeBackward>(context);
+    patterns.add<RematerializeBackward>(context, costModel);
     patterns.add<RematerializeForward>(context);
+    patterns.add<SinkConversionIntoStore>(context, costModel);
     patterns.add<MoveConvertOutOfLoop>(context);
     patterns.add<MoveConvertOutOfIf>(context);
+#ifdef USE_ROCM
+    patterns.add<BlockedToMFMA>(context);
+#else
     patterns.add<BlockedToMMA>(context, computeCapability);
+    patterns.add<BlockedToSparseMMA>(context, computeCapability);
+#endif
     patterns.add<ConvertTransConvert>(context);
     patterns.add<ConvertDotConvert>(context);
 
@@ -1291,6 +1759,7 @@ public:
 };
 
 std::unique_ptr<Pass>
-mlir::createTritonGPUCombineOpsPass(int computeCapability) {
-  return std::make_unique<TritonGPUCombineOpsPass>(computeCapability);
+mlir::createTritonGPUCombineOpsPass(int computeCapability, double rematWeight) {
+  return std::make_unique<TritonGPUCombineOpsPass>(computeCapability,
+                                                   rematWeight);
 }
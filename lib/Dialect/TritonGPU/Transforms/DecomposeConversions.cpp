@@ -45,15 +45,15 @@ public:
               srcEncoding.dyn_cast<triton::gpu::MmaEncodingAttr>()) {
 
         if (srcMmaEncoding.getVersionMajor() == 1 ||
-            (srcMmaEncoding.getWarpsPerCTA()[1] == 1 &&
-             dstDotOp.getParent() == srcMmaEncoding))
+            isMmaToDotShortcut(srcMmaEncoding, dstDotOp))
           return;
       }
       auto tmpType = RankedTensorType::get(
           dstType.getShape(), dstType.getElementType(),
           triton::gpu::SharedEncodingAttr::get(
               mod.getContext(), dstDotOp, srcType.getShape(),
-              triton::gpu::getOrder(srcEncoding), srcType.getElementType()));
+              triton::gpu::getOrder(srcEncoding), srcType.getElementType(),
+              triton::gpu::TritonGPUDialect::getSharedBanks(mod)));
       auto tmp = builder.create<triton::gpu::ConvertLayoutOp>(
           cvtOp.getLoc(), tmpType, cvtOp.getOperand());
       auto newConvert = builder.create<triton::gpu::ConvertLayoutOp>(
@@ -0,0 +1,172 @@
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "triton/Analysis/Utility.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+//
+// This file implements the hoisting of loop invariant loads out of scf.for
+// loops, e.g. of the bias or scale vectors reloaded in every iteration of the
+// K loop of a matmul. Generic LICM leaves them in the loop, as loads read
+// memory.
+//
+// A load is loop invariant when its pointer, mask and other value are defined
+// outside the loop, and no op of the loop may write to the memory it reads:
+// the pointers of the loop's stores and atomics are traced back to the
+// arguments of the kernel, which alias each other unless one of them is
+// tt.noalias. Its side-effect free users, e.g. its layout conversions, are
+// hoisted with it.
+//
+// Unless the loop is known to run, the mask of a hoisted load is and-ed with
+// lb < ub, so that it accesses no memory when the loop doesn't.
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
+
+namespace {
+
+class LoadHoister {
+  scf::ForOp forOp;
+  FuncOp funcOp;
+  // roots of the global pointers the loop may write through, None if any
+  // may be derived from anything
+  Optional<SmallVector<unsigned>> writtenRoots = SmallVector<unsigned>();
+
+  bool mayAlias(unsigned a, unsigned b) const {
+    return a == b || (!funcOp.getArgAttr(a, "tt.noalias") &&
+                      !funcOp.getArgAttr(b, "tt.noalias"));
+  }
+
+  bool isInvariant(triton::LoadOp loadOp) const;
+
+  Value getGuardedMask(OpBuilder &builder, triton::LoadOp loadOp) const;
+
+public:
+  explicit LoadHoister(scf::ForOp forOp);
+
+  // Hoists the invariant loads directly in the body of the loop, and their
+  // side-effect free users
+  void hoist();
+};
+
+LoadHoister::LoadHoister(scf::ForOp forOp)
+    : forOp(forOp), funcOp(forOp->getParentOfType<FuncOp>()) {
+  forOp.getBody()->walk([&](Operation *op) {
+    if (!writtenRoots || !mayWriteThroughPointers(op))
+      return;
+    for (Value operand : op->getOperands()) {
+      if (!isGlobalPointer(operand))
+        continue;
+      auto roots = getPointerRoots(operand);
+      if (!roots) {
+        writtenRoots = llvm::None;
+        return;
+      }
+      writtenRoots->append(roots->begin(), roots->end());
+    }
+  });
+}
+
+bool LoadHoister::isInvariant(triton::LoadOp loadOp) const {
+  if (loadOp.isVolatile() || !isGlobalPointer(loadOp.ptr()) ||
+      !writtenRoots)
+    return false;
+  if (llvm::any_of(loadOp->getOperands(), [&](Value operand) {
+        return !forOp.isDefinedOutsideOfLoop(operand);
+      }))
+    return false;
+  auto roots = getPointerRoots(loadOp.ptr());
+  if (!roots || roots->empty())
+    return false;
+  for (unsigned root : *roots)
+    for (unsigned written : *writtenRoots)
+      if (mayAlias(root, written))
+        return false;
+  return true;
+}
+
+Value LoadHoister::getGuardedMask(OpBuilder &builder,
+                                  triton::LoadOp loadOp) const {
+  Value mask = loadOp.mask();
+  APInt lb, ub;
+  if (matchPattern(forOp.getLowerBound(), m_ConstantInt(&lb)) &&
+      matchPattern(forOp.getUpperBound(), m_ConstantInt(&ub)) &&
+      lb.slt(ub))
+    return mask;
+  Location loc = loadOp.getLoc();
+  Value runs = builder.create<arith::CmpIOp>(loc, arith::CmpIPredicate::slt,
+                                             forOp.getLowerBound(),
+                                             forOp.getUpperBound());
+  if (auto ptrTy = loadOp.ptr().getType().dyn_cast<RankedTensorType>()) {
+    auto maskTy = RankedTensorType::get(
+        ptrTy.getShape(), builder.getI1Type(), ptrTy.getEncoding());
+    runs = builder.create<triton::SplatOp>(loc, maskTy, runs);
+  }
+  if (!mask)
+    return runs;
+  return builder.create<arith::AndIOp>(loc, mask, runs);
+}
+
+void LoadHoister::hoist() {
+  SmallVector<triton::LoadOp> loadOps;
+  for (auto loadOp : forOp.getBody()->getOps<triton::LoadOp>())
+    if (isInvariant(loadOp))
+      loadOps.push_back(loadOp);
+  if (loadOps.empty())
+    return;
+
+  OpBuilder builder(forOp);
+  SmallVector<Value> hoisted;
+  for (triton::LoadOp loadOp : loadOps) {
+    auto newLoadOp = builder.create<triton::LoadOp>(
+        loadOp.getLoc(), loadOp.getType(), loadOp.ptr(),
+        getGuardedMask(builder, loadOp), loadOp.other(), loadOp.cache(),
+        loadOp.evict(), loadOp.isVolatile(),
+        loadOp.l2EvictLastFractionAttr());
+    loadOp.getResult().replaceAllUsesWith(newLoadOp.getResult());
+    loadOp.erase();
+    hoisted.push_back(newLoadOp.getResult());
+  }
+
+  // The users of the hoisted values, e.g. their layout conversions, follow
+  // them once all their operands are outside the loop
+  while (!hoisted.empty()) {
+    Value value = hoisted.pop_back_val();
+    for (Operation *user : llvm::make_early_inc_range(value.getUsers())) {
+      if (user->getBlock() != forOp.getBody() || user->getNumRegions() ||
+          !MemoryEffectOpInterface::hasNoEffect(user))
+        continue;
+      if (llvm::any_of(user->getOperands(), [&](Value operand) {
+            return !forOp.isDefinedOutsideOfLoop(operand);
+          }))
+        continue;
+      user->moveBefore(forOp);
+      hoisted.append(user->result_begin(), user->result_end());
+    }
+  }
+}
+
+} // anonymous namespace
+
+class HoistInvariantLoadsPass
+    : public TritonGPUHoistInvariantLoadsBase<HoistInvariantLoadsPass> {
+public:
+  void runOnOperation() override {
+    // Inner loops first, so that the loads they hoist may be hoisted out of
+    // the outer ones
+    SmallVector<scf::ForOp> forOps;
+    getOperation()->walk([&](scf::ForOp forOp) { forOps.push_back(forOp); });
+    for (scf::ForOp forOp : forOps)
+      LoadHoister(forOp).hoist();
+  }
+};
+
+std::unique_ptr<Pass> mlir::createTritonGPUHoistInvariantLoadsPass() {
+  return std::make_unique<HoistInvariantLoadsPass>();
+}
@@ -0,0 +1,274 @@
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "triton/Analysis/Utility.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+
+#include <set>
+
+//===----------------------------------------------------------------------===//
+//
+// This file implements a list scheduler bounding the register pressure.
+//
+// The ops of each block are scheduled top-down. Among the ops whose
+// dependences are scheduled, the first one in the original order is picked,
+// unless it would raise the number of live registers above the budget: the
+// ready op freeing the most registers is picked then, e.g. the elementwise op
+// consuming a loaded tile before the next load, or the dot consuming a
+// converted operand before the next conversion.
+//
+// Values are live from their definition to their last use in the block, or
+// until the end of the block if used by its terminator. Values defined above
+// the block are accounted for in the enclosing block, where they are live
+// until the op whose regions use them, whose own peak is added to the
+// registers live around it.
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
+
+namespace {
+
+using triton::gpu::DotOperandEncodingAttr;
+using triton::gpu::MmaEncodingAttr;
+using triton::gpu::SharedEncodingAttr;
+
+// 32-bit registers per thread holding a value
+unsigned getNumRegisters(Type type) {
+  auto tensorTy = type.dyn_cast<RankedTensorType>();
+  if (!tensorTy)
+    return type.isIntOrIndexOrFloat() || type.isa<triton::PointerType>() ? 1
+                                                                         : 0;
+  Attribute encoding = tensorTy.getEncoding();
+  if (!encoding)
+    return 0;
+  auto shape = tensorTy.getShape();
+  unsigned elems;
+  if (auto dotLayout = encoding.dyn_cast<DotOperandEncodingAttr>()) {
+    // Mma operands are split between the warps along their non-k dimension
+    // and replicated along the other one
+    if (auto mmaLayout = dotLayout.getParent().dyn_cast<MmaEncodingAttr>()) {
+      unsigned numWarps =
+          mmaLayout.getWarpsPerCTA()[dotLayout.getOpIdx() == 0 ? 0 : 1];
+      elems = ceil<unsigned>(product<int64_t>(shape), 32 * numWarps);
+    } else {
+      elems = dotLayout.getElemsPerThread(shape);
+    }
+  } else if (triton::gpu::isaDistributedLayout(encoding)) {
+    elems = triton::gpu::getElemsPerThread(encoding, shape);
+  } else {
+    return 0;
+  }
+  Type elemTy = tensorTy.getElementType();
+  unsigned bits;
+  if (elemTy.isa<triton::PointerType>())
+    bits = 64;
+  else if (triton::isFloat8(elemTy))
+    bits = 8;
+  else if (elemTy.isInteger(1))
+    bits = 32;
+  else
+    bits = elemTy.getIntOrFloatBitWidth();
+  return ceil<unsigned>(elems * bits, 32);
+}
+
+bool isSharedTensor(Value value) {
+  auto tensorTy = value.getType().dyn_cast<RankedTensorType>();
+  return tensorTy && tensorTy.getEncoding() &&
+         tensorTy.getEncoding().isa<SharedEncodingAttr>();
+}
+
+// Ops that keep their relative order: those with side effects or regions, and
+// those accessing shared memory, whose writes are ordered by barriers and
+// async waits rather than by def-use chains
+bool isOrdered(Operation *op) {
+  if (op->getNumRegions() != 0 || !MemoryEffectOpInterface::hasNoEffect(op))
+    return true;
+  return llvm::any_of(op->getOperands(), isSharedTensor) ||
+         llvm::any_of(op->getResults(), isSharedTensor);
+}
+
+class ListScheduler {
+  int budget;
+  // Peak of the registers live within the regions of an op
+  DenseMap<Operation *, unsigned> innerPeaks;
+
+public:
+  explicit ListScheduler(int budget) : budget(budget) {}
+
+  // Schedules the ops of `block` and of its nested blocks, and returns the
+  // peak of the registers live in `block`
+  unsigned schedule(Block &block);
+
+  // Whether any op was moved
+  bool changed = false;
+};
+
+unsigned ListScheduler::schedule(Block &block) {
+  for (Operation &op : block)
+    for (Region &region : op.getRegions())
+      for (Block &nested : region)
+        innerPeaks[&op] = std::max(innerPeaks[&op], schedule(nested));
+
+  Operation *terminator = nullptr;
+  if (!block.empty() && block.back().hasTrait<OpTrait::IsTerminator>())
+    terminator = &block.back();
+  SmallVector<Operation *> ops;
+  DenseMap<Operation *, unsigned> index;
+  for (Operation &op : block) {
+    if (&op == terminator)
+      break;
+    index[&op] = ops.size();
+    ops.push_back(&op);
+  }
+  if (ops.empty())
+    return 0;
+
+  // Values of the block used by each op, directly or in its regions
+  SmallVector<SetVector<Value>> used(ops.size());
+  for (unsigned i = 0; i < ops.size(); ++i) {
+    ops[i]->walk([&](Operation *nested) {
+      for (Value operand : nested->getOperands()) {
+        Operation *def = operand.getDefiningOp();
+        Block *defBlock = def ? def->getBlock() : operand.getParentBlock();
+        if (defBlock == &block && def != ops[i])
+          used[i].insert(operand);
+      }
+    });
+  }
+
+  // Dependences
+  SmallVector<unsigned> numPreds(ops.size(), 0);
+  SmallVector<SmallVector<unsigned>> succs(ops.size());
+  Optional<unsigned> lastOrdered;
+  for (unsigned i = 0; i < ops.size(); ++i) {
+    SetVector<unsigned> preds;
+    for (Value value : used[i])
+      if (Operation *def = value.getDefiningOp())
+        preds.insert(index.lookup(def));
+    if (isOrdered(ops[i])) {
+      if (lastOrdered)
+        preds.insert(*lastOrdered);
+      lastOrdered = i;
+    }
+    for (unsigned pred : preds)
+      succs[pred].push_back(i);
+    numPreds[i] = preds.size();
+  }
+
+  // Remaining uses of the values of the block, the values used by the
+  // terminator being live until its end
+  DenseMap<Value, unsigned> remainingUses;
+  DenseSet<Value> liveOut;
+  for (const SetVector<Value> &values : used)
+    for (Value value : values)
+      ++remainingUses[value];
+  if (terminator)
+    terminator->walk([&](Operation *nested) {
+      for (Value operand : nested->getOperands())
+        liveOut.insert(operand);
+    });
+  auto isLive = [&](Value value) {
+    return remainingUses.lookup(value) > 0 || liveOut.contains(value);
+  };
+
+  int64_t pressure = 0;
+  for (BlockArgument arg : block.getArguments())
+    if (isLive(arg))
+      pressure += getNumRegisters(arg.getType());
+  int64_t peak = pressure;
+
+  // Registers the op allocates for its results, and frees as the last user
+  // of its operands
+  auto getResultRegisters = [&](unsigned i) {
+    int64_t regs = 0;
+    for (Value result : ops[i]->getResults())
+      if (isLive(result))
+        regs += getNumRegisters(result.getType());
+    return regs;
+  };
+  auto getDelta = [&](unsigned i) {
+    int64_t delta = getResultRegisters(i);
+    for (Value value : used[i])
+      if (remainingUses.lookup(value) == 1 && !liveOut.contains(value))
+        delta -= getNumRegisters(value.getType());
+    return delta;
+  };
+
+  std::set<unsigned> ready;
+  for (unsigned i = 0; i < ops.size(); ++i)
+    if (numPreds[i] == 0)
+      ready.insert(i);
+  SmallVector<unsigned> order;
+  while (!ready.empty()) {
+    unsigned pick = *ready.begin();
+    if (pressure + getDelta(pick) > budget) {
+      int64_t minDelta = getDelta(pick);
+      for (unsigned i : ready) {
+        int64_t delta = getDelta(i);
+        if (delta < minDelta) {
+          pick = i;
+          minDelta = delta;
+        }
+      }
+    }
+    ready.erase(pick);
+    peak = std::max(peak, pressure + getResultRegisters(pick) +
+                              innerPeaks.lookup(ops[pick]));
+    pressure += getDelta(pick);
+    for (Value value : used[pick])
+      --remainingUses[value];
+    for (unsigned succ : succs[pick])
+      if (--numPreds[succ] == 0)
+        ready.insert(succ);
+    order.push_back(pick);
+  }
+  assert(order.size() == ops.size() && "cyclic dependences");
+
+  if (!llvm::is_sorted(order)) {
+    changed = true;
+    for (unsigned i : order) {
+      if (terminator)
+        ops[i]->moveBefore(terminator);
+      else
+        ops[i]->moveBefore(&block, block.end());
+    }
+  }
+  return peak;
+}
+
+} // anonymous namespace
+
+class TritonGPUListSchedulePass
+    : public TritonGPUListScheduleBase<TritonGPUListSchedulePass> {
+public:
+  TritonGPUListSchedulePass() = default;
+  TritonGPUListSchedulePass(int registerBudget) {
+    this->registerBudget = registerBudget;
+  }
+
+  void runOnOperation() override {
+    ModuleOp m = getOperation();
+    ListScheduler scheduler(registerBudget);
+    unsigned peak = 0;
+    for (auto funcOp : m.getOps<FuncOp>())
+      for (Block &block : funcOp.getBody())
+        peak = std::max(peak, scheduler.schedule(block));
+
+    Builder builder(m.getContext());
+    int predictedSpills = std::max<int>(0, int(peak) - registerBudget);
+    m->setAttr("triton_gpu.live-registers", builder.getI32IntegerAttr(peak));
+    m->setAttr("triton_gpu.predicted-spills",
+               builder.getI32IntegerAttr(predictedSpills));
+    // The attributes do not affect the analyses
+    if (!scheduler.changed)
+      markAllAnalysesPreserved();
+  }
+};
+
+std::unique_ptr<Pass>
+mlir::createTritonGPUListSchedulePass(int registerBudget) {
+  return std::make_unique<TritonGPUListSchedulePass>(registerBudget);
+}
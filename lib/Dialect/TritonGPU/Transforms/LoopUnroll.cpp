@@ -0,0 +1,146 @@
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Matchers.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+//
+// This file implements the unrolling of the loops with a tt.unroll_factor
+// attribute and a constant trip count. With a factor of 2,
+//
+//   for (iv = lb; iv < ub; iv += step)
+//     body(iv)
+//
+// becomes
+//
+//   for (iv = lb; iv < mainUb; iv += 2 * step)
+//     body(iv)
+//     body(iv + step)
+//   for (iv = mainUb; iv < ub; iv += step)
+//     body(iv)
+//
+// where mainUb = lb + (tripCount - tripCount % 2) * step. The second loop is
+// only kept if the trip count isn't a multiple of the factor, and the first
+// one is replaced by its body if it has a single iteration.
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
+
+namespace {
+
+constexpr StringRef kUnrollFactorAttrName = "tt.unroll_factor";
+
+Optional<int64_t> getConstantIndex(Value value) {
+  APInt cst;
+  if (matchPattern(value, m_ConstantInt(&cst)))
+    return cst.getSExtValue();
+  return llvm::None;
+}
+
+// Clones bodyOps, the body of forOp, for the iterations [first, first + count)
+// at the insertion point of the builder. The iteration k has the induction
+// variable iv + k * step and the iteration arguments yielded by the iteration
+// k - 1, those of the first one being iterArgs. Returns the values yielded by
+// the last iteration.
+SmallVector<Value> cloneIterations(OpBuilder &builder, scf::ForOp forOp,
+                                   ArrayRef<Operation *> bodyOps, Value iv,
+                                   int64_t step, int64_t first, int64_t count,
+                                   SmallVector<Value> iterArgs) {
+  Location loc = forOp.getLoc();
+  auto yieldOp = cast<scf::YieldOp>(forOp.getBody()->getTerminator());
+  for (int64_t k = first; k < first + count; ++k) {
+    BlockAndValueMapping mapping;
+    Value ivK = iv;
+    if (k != 0)
+      ivK = builder.create<arith::AddIOp>(
+          loc, iv, builder.create<arith::ConstantIndexOp>(loc, k * step));
+    mapping.map(forOp.getInductionVar(), ivK);
+    mapping.map(forOp.getRegionIterArgs(), iterArgs);
+    for (Operation *op : bodyOps)
+      builder.clone(*op, mapping);
+    for (unsigned i = 0; i < iterArgs.size(); ++i)
+      iterArgs[i] = mapping.lookupOrDefault(yieldOp.getOperand(i));
+  }
+  return iterArgs;
+}
+
+void unroll(scf::ForOp forOp) {
+  auto factorAttr = forOp->getAttrOfType<IntegerAttr>(kUnrollFactorAttrName);
+  forOp->removeAttr(kUnrollFactorAttrName);
+  auto lb = getConstantIndex(forOp.getLowerBound());
+  auto ub = getConstantIndex(forOp.getUpperBound());
+  auto step = getConstantIndex(forOp.getStep());
+  if (!factorAttr || !lb || !ub || !step || *step <= 0)
+    return;
+  int64_t tripCount = *ub > *lb ? (*ub - *lb + *step - 1) / *step : 0;
+  int64_t factor = std::min<int64_t>(factorAttr.getInt(), tripCount);
+  if (factor <= 1)
+    return;
+  int64_t mainTripCount = tripCount - tripCount % factor;
+
+  // The remaining iterations run in the original loop, fed by the unrolled one
+  OpBuilder builder(forOp);
+  Location loc = forOp.getLoc();
+  scf::ForOp mainForOp = forOp;
+  if (mainTripCount != tripCount) {
+    Value mainUb = builder.create<arith::ConstantIndexOp>(
+        loc, *lb + mainTripCount * *step);
+    mainForOp = cast<scf::ForOp>(builder.clone(*forOp));
+    mainForOp.setUpperBound(mainUb);
+    forOp.setLowerBound(mainUb);
+    for (auto [initArg, result] :
+         llvm::zip(forOp.getIterOpOperands(), mainForOp.getResults()))
+      initArg.set(result);
+  }
+
+  SmallVector<Operation *> bodyOps;
+  for (Operation &op : mainForOp.getBody()->without_terminator())
+    bodyOps.push_back(&op);
+
+  // A single iteration of the unrolled loop is inlined
+  if (mainTripCount == factor) {
+    builder.setInsertionPoint(mainForOp);
+    auto results = cloneIterations(
+        builder, mainForOp, bodyOps, mainForOp.getLowerBound(), *step, 0,
+        factor, llvm::to_vector(mainForOp.getIterOperands()));
+    mainForOp->replaceAllUsesWith(results);
+    mainForOp.erase();
+    return;
+  }
+
+  auto yieldOp = cast<scf::YieldOp>(mainForOp.getBody()->getTerminator());
+  builder.setInsertionPoint(yieldOp);
+  auto results = cloneIterations(
+      builder, mainForOp, bodyOps, mainForOp.getInductionVar(), *step, 1,
+      factor - 1, llvm::to_vector(yieldOp->getOperands()));
+  yieldOp->setOperands(results);
+  builder.setInsertionPoint(mainForOp);
+  mainForOp.setStep(
+      builder.create<arith::ConstantIndexOp>(loc, factor * *step));
+}
+
+} // anonymous namespace
+
+class LoopUnrollPass : public TritonGPULoopUnrollBase<LoopUnrollPass> {
+public:
+  void runOnOperation() override {
+    // Inner loops come first, so that the copies of the body of an outer loop
+    // contain the unrolled inner loops
+    SmallVector<scf::ForOp> forOps;
+    getOperation()->walk([&](scf::ForOp forOp) {
+      if (forOp->hasAttr(kUnrollFactorAttrName))
+        forOps.push_back(forOp);
+    });
+    for (scf::ForOp forOp : forOps)
+      unroll(forOp);
+  }
+};
+
+std::unique_ptr<Pass> mlir::createTritonGPULoopUnrollPass() {
+  return std::make_unique<LoopUnrollPass>();
+}
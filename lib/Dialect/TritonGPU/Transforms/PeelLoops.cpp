@@ -0,0 +1,244 @@
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Matchers.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+//
+// This file implements the peeling of the partial last iteration of loops
+// whose memory accesses are masked by a bound on the induction variable.
+//
+//   for (iv = lb; iv < ub; iv += step)
+//     load(ptr, iv + arange(0, step) < ub)
+//
+// is split into a steady-state loop over [lb, ub - (ub - lb) % step), where
+// iv + step <= ub holds and the masks are dropped, and a tail loop running the
+// (at most one) remaining iteration with the original masks.
+//
+// A mask is proven to be all true by writing both sides of its comparison as
+//   sum(coeff * symbol) + ivCoeff * iv + [minOffset, maxOffset]
+// where the symbols are loop invariant values, and checking the sign of the
+// difference at the extremal value of the induction variable.
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
+
+namespace {
+
+struct LinearExpr {
+  llvm::MapVector<Value, int64_t> symbols;
+  int64_t ivCoeff = 0;
+  int64_t minOffset = 0;
+  int64_t maxOffset = 0;
+
+  void add(const LinearExpr &other, int64_t sign) {
+    for (auto &[symbol, coeff] : other.symbols)
+      symbols[symbol] += sign * coeff;
+    ivCoeff += sign * other.ivCoeff;
+    if (sign > 0) {
+      minOffset += other.minOffset;
+      maxOffset += other.maxOffset;
+    } else {
+      minOffset -= other.maxOffset;
+      maxOffset -= other.minOffset;
+    }
+  }
+
+  bool hasNoSymbols() const {
+    return llvm::all_of(symbols, [](auto &it) { return it.second == 0; });
+  }
+};
+
+class LoopPeeler {
+  scf::ForOp forOp;
+
+  Optional<LinearExpr> getLinearExpr(Value value, int depth = 0) const;
+
+  bool isAlwaysTrue(Value mask, int depth = 0) const;
+
+public:
+  explicit LoopPeeler(scf::ForOp forOp) : forOp(forOp) {}
+
+  // Masked loads and stores of the loop whose masks are all true in every
+  // iteration where iv + step <= ub
+  SmallVector<Operation *> getUnmaskableOps() const;
+};
+
+Optional<LinearExpr> LoopPeeler::getLinearExpr(Value value, int depth) const {
+  if (depth > 16)
+    return llvm::None;
+  LinearExpr expr;
+  if (value == forOp.getInductionVar()) {
+    expr.ivCoeff = 1;
+    return expr;
+  }
+  APInt cst;
+  if (matchPattern(value, m_ConstantInt(&cst))) {
+    expr.minOffset = expr.maxOffset = cst.getSExtValue();
+    return expr;
+  }
+  Operation *op = value.getDefiningOp();
+  if (auto makeRange = dyn_cast_or_null<triton::MakeRangeOp>(op)) {
+    expr.minOffset = makeRange.start();
+    expr.maxOffset = makeRange.end() - 1;
+    return expr;
+  }
+  if (isa_and_nonnull<arith::IndexCastOp, triton::SplatOp, triton::BroadcastOp,
+                      triton::ExpandDimsOp, triton::gpu::ConvertLayoutOp>(op))
+    return getLinearExpr(op->getOperand(0), depth + 1);
+  if (isa_and_nonnull<arith::AddIOp, arith::SubIOp>(op)) {
+    auto lhs = getLinearExpr(op->getOperand(0), depth + 1);
+    auto rhs = getLinearExpr(op->getOperand(1), depth + 1);
+    if (lhs && rhs) {
+      lhs->add(*rhs, isa<arith::AddIOp>(op) ? 1 : -1);
+      return lhs;
+    }
+  }
+  // Other loop invariant scalars are opaque symbols
+  if (value.getType().isIntOrIndex() &&
+      !forOp->isAncestor(value.getParentRegion()->getParentOp())) {
+    expr.symbols[value] = 1;
+    return expr;
+  }
+  return llvm::None;
+}
+
+bool LoopPeeler::isAlwaysTrue(Value mask, int depth) const {
+  if (depth > 16)
+    return false;
+  Operation *op = mask.getDefiningOp();
+  if (!op || !forOp->isProperAncestor(op))
+    return false;
+  if (isa<triton::SplatOp, triton::BroadcastOp, triton::ExpandDimsOp,
+          triton::gpu::ConvertLayoutOp>(op))
+    return isAlwaysTrue(op->getOperand(0), depth + 1);
+  if (isa<arith::AndIOp>(op))
+    return isAlwaysTrue(op->getOperand(0), depth + 1) &&
+           isAlwaysTrue(op->getOperand(1), depth + 1);
+  auto cmpOp = dyn_cast<arith::CmpIOp>(op);
+  if (!cmpOp)
+    return false;
+
+  // Rewrite the comparison as diff < 0 or diff <= 0
+  Value lhs = cmpOp.getLhs();
+  Value rhs = cmpOp.getRhs();
+  bool strict;
+  switch (cmpOp.getPredicate()) {
+  case arith::CmpIPredicate::slt:
+    strict = true;
+    break;
+  case arith::CmpIPredicate::sle:
+    strict = false;
+    break;
+  case arith::CmpIPredicate::sgt:
+    strict = true;
+    std::swap(lhs, rhs);
+    break;
+  case arith::CmpIPredicate::sge:
+    strict = false;
+    std::swap(lhs, rhs);
+    break;
+  default:
+    return false;
+  }
+  auto diff = getLinearExpr(lhs);
+  auto rhsExpr = getLinearExpr(rhs);
+  if (!diff || !rhsExpr)
+    return false;
+  diff->add(*rhsExpr, -1);
+
+  // The difference is largest for iv = ub - step if it increases with iv, and
+  // for iv = lb if it decreases
+  int64_t ivCoeff = diff->ivCoeff;
+  if (ivCoeff != 1 && ivCoeff != -1)
+    return false;
+  auto ub = getLinearExpr(forOp.getUpperBound());
+  auto lb = getLinearExpr(forOp.getLowerBound());
+  auto step = getLinearExpr(forOp.getStep());
+  if (!ub || !lb || !step)
+    return false;
+  LinearExpr ivMax = *ub;
+  ivMax.add(*step, -1);
+  diff->ivCoeff = 0;
+  diff->add(ivCoeff > 0 ? ivMax : *lb, ivCoeff);
+  if (!diff->hasNoSymbols() || diff->ivCoeff != 0)
+    return false;
+  return strict ? diff->maxOffset < 0 : diff->maxOffset <= 0;
+}
+
+SmallVector<Operation *> LoopPeeler::getUnmaskableOps() const {
+  SmallVector<Operation *> ops;
+  forOp.getBody()->walk([&](Operation *op) {
+    Value mask;
+    if (auto loadOp = dyn_cast<triton::LoadOp>(op))
+      mask = loadOp.mask();
+    else if (auto storeOp = dyn_cast<triton::StoreOp>(op))
+      mask = storeOp.mask();
+    if (mask && isAlwaysTrue(mask))
+      ops.push_back(op);
+  });
+  return ops;
+}
+
+void dropMask(Operation *op) {
+  OpBuilder builder(op);
+  if (auto loadOp = dyn_cast<triton::LoadOp>(op)) {
+    auto newLoadOp = builder.create<triton::LoadOp>(
+        loadOp.getLoc(), loadOp.getType(), loadOp.ptr(), Value(), Value(),
+        loadOp.cache(), loadOp.evict(), loadOp.isVolatile(),
+        loadOp.l2EvictLastFractionAttr());
+    loadOp.getResult().replaceAllUsesWith(newLoadOp.getResult());
+  } else {
+    auto storeOp = cast<triton::StoreOp>(op);
+    builder.create<triton::StoreOp>(storeOp.getLoc(), storeOp.ptr(),
+                                    storeOp.value(), storeOp.cache(),
+                                    storeOp.evict());
+  }
+  op->erase();
+}
+
+} // anonymous namespace
+
+class PeelLoopsPass : public TritonGPUPeelLoopsBase<PeelLoopsPass> {
+public:
+  void runOnOperation() override {
+    SmallVector<scf::ForOp> forOps;
+    getOperation()->walk([&](scf::ForOp forOp) { forOps.push_back(forOp); });
+
+    for (scf::ForOp forOp : forOps) {
+      if (LoopPeeler(forOp).getUnmaskableOps().empty())
+        continue;
+
+      // mainUb = ub - (ub - lb) % step
+      OpBuilder builder(forOp);
+      Location loc = forOp.getLoc();
+      Value ub = forOp.getUpperBound();
+      Value tripSpan =
+          builder.create<arith::SubIOp>(loc, ub, forOp.getLowerBound());
+      Value rem =
+          builder.create<arith::RemSIOp>(loc, tripSpan, forOp.getStep());
+      Value mainUb = builder.create<arith::SubIOp>(loc, ub, rem);
+
+      // The steady-state loop feeds the tail loop, i.e. the original one
+      auto mainForOp = cast<scf::ForOp>(builder.clone(*forOp));
+      mainForOp.setUpperBound(mainUb);
+      forOp.setLowerBound(mainUb);
+      for (auto [initArg, result] :
+           llvm::zip(forOp.getIterOpOperands(), mainForOp.getResults()))
+        initArg.set(result);
+      forOp->setAttr("triton_gpu.peeled_tail", builder.getUnitAttr());
+
+      for (Operation *op : LoopPeeler(mainForOp).getUnmaskableOps())
+        dropMask(op);
+    }
+  }
+};
+
+std::unique_ptr<Pass> mlir::createTritonGPUPeelLoopsPass() {
+  return std::make_unique<PeelLoopsPass>();
+}
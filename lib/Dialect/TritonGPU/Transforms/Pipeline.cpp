@@ -1,7 +1,9 @@
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/TypeUtilities.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "triton/Analysis/AxisInfo.h"
+#include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
 
@@ -11,6 +13,10 @@
 // The implementation here is inspired by the pipeline pass in Triton (-v2.0)
 // and SCF's LoopPipelining.
 //
+// In kernels launched in thread block clusters (sm_90+), the tiles all the
+// CTAs of a cluster load are shared: every CTA only copies its part of a
+// stage, and gathers the others from the shared memory of its peers.
+//
 //===----------------------------------------------------------------------===//
 
 using namespace mlir;
@@ -69,9 +75,25 @@ class LoopPipeliner {
   /// Operations (inside the loop body) that loads depend on
   SetVector<Operation *> depOps;
 
+  /// Index loads (in depOps) that loads gather through in the same iteration.
+  /// They are issued one iteration ahead of these loads, i.e. numStages
+  /// iterations ahead, and carried by the loop.
+  SetVector<Operation *> aheadLoads;
+  /// Operations (inside the loop body) computing the operands of aheadLoads,
+  /// in program order
+  SetVector<Operation *> aheadDeps;
+  /// Block arguments that the operands of aheadLoads depend on
+  SetVector<BlockArgument> aheadArgs;
+  /// aheadLoads issued by the prologue, for iteration numStages-1
+  SmallVector<Value> aheadValues;
+
   /// collect values that v depends on and are defined inside the loop
   void collectDeps(Value v, int stages, SetVector<Value> &deps);
 
+  /// collect operations that v depends on within an iteration, i.e. without
+  /// going through block arguments
+  void collectIterationDeps(Value v, SetVector<Operation *> &deps);
+
   void setValueMapping(Value origin, Value newValue, int stage);
 
   Value lookupOrDefault(Value origin, int stage);
@@ -79,6 +101,48 @@ class LoopPipeliner {
   /// Returns a empty buffer of size <numStages, ...>
   ttg::AllocTensorOp allocateEmptyBuffer(Operation *op, OpBuilder &builder);
 
+  /// Whether `loadOp` is a scalar load of an index the pipelined loads may
+  /// gather through, e.g. of a page of a block table. Such loads are issued
+  /// ahead with the address computation of the pipelined loads, one iteration
+  /// further if the pipelined loads use them in the same iteration.
+  bool isIndexLoad(triton::LoadOp loadOp);
+
+  /// Masks `op`, a clone of an index load, by the condition of the iteration
+  /// it is issued for, so that it does not read past the end of the indices
+  Operation *guardIndexLoad(OpBuilder &builder, Operation *op, Value cond);
+
+  /// Picks the index loads of depOps to issue ahead, and their dependencies
+  void collectAheadLoads();
+
+  /// Issues aheadLoads for the iteration `mapping` maps the induction
+  /// variable and aheadArgs to, masked by `cond`
+  SmallVector<Value> emitAheadLoads(OpBuilder &builder,
+                                    BlockAndValueMapping &mapping, Value cond);
+
+  /// The slot `index` of the stages of `buffer`, of type `sliceType`.
+  Value extractSliceOfStage(OpBuilder &builder, Location loc,
+                            RankedTensorType sliceType, Value buffer,
+                            OpFoldResult index);
+
+  /// Whether all the CTAs of a cluster of numCTAs CTAs load the same tile of
+  /// type `ty` by `loadOp`, which can then be split between them
+  bool isSharedInCluster(triton::LoadOp loadOp, RankedTensorType ty,
+                         ArrayRef<unsigned> order, unsigned numCTAs,
+                         const ClusterUniformity &uniformity);
+
+  /// Completes the slot `index` (i32) of `buffer` with the parts the peers of
+  /// the CTA loaded, if the buffer is shared in a cluster
+  Value gatherSliceOfStage(OpBuilder &builder, Location loc, Value buffer,
+                           Value index);
+
+#ifdef USE_ROCM
+  /// AMD GPUs have no async copy into LDS. Pipelined loads are staged
+  /// through registers instead: `tile` is written to slot `index` of
+  /// `buffer` with a regular insert_slice.
+  Value insertSliceFromRegisters(OpBuilder &builder, Location loc, Value tile,
+                                 Value buffer, Value index);
+#endif
+
 public:
   LoopPipeliner(scf::ForOp forOp, int numStages)
       : forOp(forOp), numStages(numStages) {
@@ -141,6 +205,17 @@ void LoopPipeliner::collectDeps(Value v, int stages, SetVector<Value> &deps) {
   }
 }
 
+void LoopPipeliner::collectIterationDeps(Value v,
+                                         SetVector<Operation *> &deps) {
+  Operation *op = v.getDefiningOp();
+  if (!op || op->getParentRegion() != &forOp.getLoopBody() ||
+      deps.contains(op))
+    return;
+  deps.insert(op);
+  for (Value operand : op->getOperands())
+    collectIterationDeps(operand, deps);
+}
+
 ttg::AllocTensorOp LoopPipeliner::allocateEmptyBuffer(Operation *op,
                                                       OpBuilder &builder) {
   // Allocate a buffer for each pipelined tensor
@@ -153,8 +228,176 @@ ttg::AllocTensorOp LoopPipeliner::allocateEmptyBuffer(Operation *op,
   llvm_unreachable("Async copy's return should be of RankedTensorType");
 }
 
+bool LoopPipeliner::isIndexLoad(triton::LoadOp loadOp) {
+  if (loadOp.getType().isa<RankedTensorType>() || loadOp.isVolatile())
+    return false;
+  SetVector<Value> deps;
+  for (Value op : loadOp->getOperands())
+    collectDeps(op, numStages - 1, deps);
+  return llvm::none_of(deps, [](Value dep) {
+    return dep.getDefiningOp<triton::LoadOp>() != nullptr;
+  });
+}
+
+Operation *LoopPipeliner::guardIndexLoad(OpBuilder &builder, Operation *op,
+                                         Value cond) {
+  auto loadOp = dyn_cast<triton::LoadOp>(op);
+  if (!loadOp)
+    return op;
+  Value mask = cond;
+  if (Value oldMask = loadOp.mask())
+    mask = builder.create<arith::AndIOp>(loadOp.getLoc(), oldMask, cond);
+  Operation *newOp = builder.create<triton::LoadOp>(
+      loadOp.getLoc(), loadOp.getType(), loadOp.ptr(), mask, loadOp.other(),
+      loadOp.cache(), loadOp.evict(), loadOp.isVolatile(),
+      loadOp.l2EvictLastFractionAttr());
+  loadOp.erase();
+  return newOp;
+}
+
+void LoopPipeliner::collectAheadLoads() {
+  // The index loads whose results a pipelined load uses in the same
+  // iteration; those feeding the next iterations through loop-carried values
+  // (e.g. the increments of the pointers of a LUT) are already ahead
+  SetVector<Operation *> candidates;
+  for (Value loadOp : loads) {
+    SetVector<Operation *> deps;
+    for (Value operand : loadOp.getDefiningOp()->getOperands())
+      collectIterationDeps(operand, deps);
+    for (Operation *op : deps)
+      if (isa<triton::LoadOp>(op))
+        candidates.insert(op);
+  }
+
+  SetVector<Operation *> deps;
+  SetVector<BlockArgument> args;
+  for (Operation *op : candidates) {
+    // Loop-carried index loads would need the value of both iterations
+    if (llvm::any_of(op->getUsers(),
+                     [&](Operation *user) { return user == yieldOp; }))
+      continue;
+    SetVector<Operation *> opDeps;
+    SetVector<BlockArgument> opArgs;
+    bool isAhead = true;
+    for (Value operand : op->getOperands()) {
+      collectIterationDeps(operand, opDeps);
+      if (auto arg = operand.dyn_cast<BlockArgument>())
+        if (arg.getOwner() == forOp.getBody() && arg.getArgNumber() > 0)
+          opArgs.insert(arg);
+    }
+    for (Operation *dep : opDeps)
+      for (Value operand : dep->getOperands())
+        if (auto arg = operand.dyn_cast<BlockArgument>())
+          if (arg.getOwner() == forOp.getBody() && arg.getArgNumber() > 0)
+            opArgs.insert(arg);
+    // The values of the block arguments one iteration further are those the
+    // prefetched iteration yields, which must be rematerialized with depOps
+    for (BlockArgument arg : opArgs) {
+      Value next = yieldOp->getOperand(arg.getArgNumber() - 1);
+      if (!forOp.isDefinedOutsideOfLoop(next) &&
+          !(next.getDefiningOp() && depOps.contains(next.getDefiningOp())))
+        isAhead = false;
+    }
+    if (!isAhead)
+      continue;
+    aheadLoads.insert(op);
+    deps.insert(opDeps.begin(), opDeps.end());
+    args.insert(opArgs.begin(), opArgs.end());
+  }
+
+  for (Operation &op : forOp.getLoopBody().front())
+    if (deps.contains(&op))
+      aheadDeps.insert(&op);
+  for (BlockArgument arg : forOp.getRegionIterArgs())
+    if (args.contains(arg))
+      aheadArgs.insert(arg);
+}
+
+SmallVector<Value>
+LoopPipeliner::emitAheadLoads(OpBuilder &builder,
+                              BlockAndValueMapping &mapping, Value cond) {
+  for (Operation *op : aheadDeps) {
+    if (aheadLoads.contains(op))
+      continue;
+    Operation *newOp = builder.clone(*op, mapping);
+    for (unsigned dstIdx : llvm::seq(unsigned(0), op->getNumResults()))
+      mapping.map(op->getResult(dstIdx), newOp->getResult(dstIdx));
+  }
+  SmallVector<Value> results;
+  for (Operation *op : aheadLoads) {
+    Operation *newOp =
+        guardIndexLoad(builder, builder.clone(*op, mapping), cond);
+    results.push_back(newOp->getResult(0));
+  }
+  return results;
+}
+
+Value LoopPipeliner::extractSliceOfStage(OpBuilder &builder, Location loc,
+                                         RankedTensorType sliceType,
+                                         Value buffer, OpFoldResult index) {
+  // the buffer has a leading dimension of stages over the shape of a slice
+  int64_t rank = sliceType.getRank() + 1;
+  SmallVector<OpFoldResult> offsets(rank, int_attr(0));
+  SmallVector<OpFoldResult> sizes(rank, int_attr(1));
+  SmallVector<OpFoldResult> strides(rank, int_attr(1));
+  offsets[0] = index;
+  for (int64_t i = 1; i < rank; ++i)
+    sizes[i] = int_attr(sliceType.getShape()[i - 1]);
+  return builder.create<tensor::ExtractSliceOp>(loc, sliceType, buffer,
+                                                offsets, sizes, strides);
+}
+
+bool LoopPipeliner::isSharedInCluster(triton::LoadOp loadOp,
+                                      RankedTensorType ty,
+                                      ArrayRef<unsigned> order,
+                                      unsigned numCTAs,
+                                      const ClusterUniformity &uniformity) {
+  if (numCTAs == 1 || ty.getRank() != 2)
+    return false;
+  if (!llvm::all_of(loadOp->getOperands(), [&](Value operand) {
+        return uniformity.isUniform(operand);
+      }))
+    return false;
+  // every iteration waits for the peers, which must run as many
+  if (!uniformity.isUniformControlFlow(loadOp))
+    return false;
+  // the CTAs copy their rows (along order[1]) of the tile in 16 bytes chunks
+  unsigned eltBytes = std::max<unsigned>(ty.getElementTypeBitWidth() / 8, 1);
+  return ty.getShape()[order[1]] % numCTAs == 0 &&
+         ty.getNumElements() * eltBytes / numCTAs % 16 == 0;
+}
+
+Value LoopPipeliner::gatherSliceOfStage(OpBuilder &builder, Location loc,
+                                        Value buffer, Value index) {
+  auto bufferType = buffer.getType().cast<RankedTensorType>();
+  auto sharedEnc = bufferType.getEncoding().cast<ttg::SharedEncodingAttr>();
+  if (sharedEnc.getClusterSize() == 1)
+    return buffer;
+  return builder.create<ttg::ClusterGatherOp>(loc, bufferType, buffer, index,
+                                              builder.getI32IntegerAttr(0));
+}
+
+#ifdef USE_ROCM
+Value LoopPipeliner::insertSliceFromRegisters(OpBuilder &builder, Location loc,
+                                              Value tile, Value buffer,
+                                              Value index) {
+  auto bufferTy = buffer.getType().cast<RankedTensorType>();
+  Value offset =
+      builder.create<arith::IndexCastOp>(loc, builder.getIndexType(), index);
+  SmallVector<OpFoldResult> offsets(bufferTy.getRank(), int_attr(0));
+  SmallVector<OpFoldResult> sizes(bufferTy.getRank(), int_attr(1));
+  SmallVector<OpFoldResult> strides(bufferTy.getRank(), int_attr(1));
+  offsets[0] = offset;
+  for (int64_t i = 1; i < bufferTy.getRank(); ++i)
+    sizes[i] = int_attr(bufferTy.getShape()[i]);
+  return builder.create<tensor::InsertSliceOp>(loc, tile, buffer, offsets,
+                                               sizes, strides);
+}
+#endif
+
 /// A load instruction can be pipelined if:
-///   - the load doesn't depend on any other loads (after loop peeling)
+///   - the load doesn't depend on any other loads (after loop peeling), but
+///     the scalar loads of the indices its address is gathered through
 ///   - (?) this load is not a loop-invariant value (we should run LICM before
 ///                                                  this pass?)
 LogicalResult LoopPipeliner::initialize() {
@@ -163,6 +406,12 @@ LogicalResult LoopPipeliner::initialize() {
   AxisInfoAnalysis axisInfoAnalysis(forOp.getContext());
   axisInfoAnalysis.run(forOp->getParentOfType<ModuleOp>());
 
+  unsigned numCTAs = ttg::TritonGPUDialect::getNumCTAs(
+      forOp->getParentOfType<ModuleOp>());
+  Optional<ClusterUniformity> uniformity;
+  if (numCTAs > 1)
+    uniformity.emplace(forOp->getParentOfType<FuncOp>(), numCTAs);
+
   // can we use forOp.walk(...) here?
   SmallVector<triton::LoadOp, 2> allLoads;
   for (Operation &op : *loop)
@@ -197,7 +446,7 @@ LogicalResult LoopPipeliner::initialize() {
   for (triton::LoadOp loadOp : allLoads) {
     bool isCandidate = true;
     for (triton::LoadOp other : allLoads) {
-      if (loadDeps[loadOp].contains(other)) {
+      if (loadDeps[loadOp].contains(other) && !isIndexLoad(other)) {
         isCandidate = false;
         break;
       }
@@ -220,9 +469,17 @@ LogicalResult LoopPipeliner::initialize() {
             SmallVector<int64_t> bufferShape(ty.getShape().begin(),
                                              ty.getShape().end());
             bufferShape.insert(bufferShape.begin(), numStages);
+            auto order = triton::gpu::getOrder(ty.getEncoding());
             auto sharedEnc = ttg::SharedEncodingAttr::get(
-                ty.getContext(), dotOpEnc, ty.getShape(),
-                triton::gpu::getOrder(ty.getEncoding()), ty.getElementType());
+                ty.getContext(), dotOpEnc, ty.getShape(), order,
+                ty.getElementType(),
+                ttg::TritonGPUDialect::getSharedBanks(
+                    forOp->getParentOfType<ModuleOp>()));
+            if (uniformity &&
+                isSharedInCluster(loadOp, ty, order, numCTAs, *uniformity))
+              sharedEnc = ttg::SharedEncodingAttr::get(
+                  ty.getContext(), sharedEnc.getVec(), sharedEnc.getPerPhase(),
+                  sharedEnc.getMaxPhase(), sharedEnc.getOrder(), numCTAs);
             loadsBufferType[loadOp] = RankedTensorType::get(
                 bufferShape, ty.getElementType(), sharedEnc);
           }
@@ -247,6 +504,7 @@ LogicalResult LoopPipeliner::initialize() {
           depOps.insert(dep.getDefiningOp());
       }
     }
+    collectAheadLoads();
     return success();
   }
 
@@ -308,7 +566,17 @@ void LoopPipeliner::emitPrologue() {
             newMask = builder.create<triton::SplatOp>(
                 loopCond.getLoc(), getI1SameShape(loadOp), loopCond);
           }
-          // TODO: check if the hardware supports async copy
+#ifdef USE_ROCM
+          Value tile = builder.create<triton::LoadOp>(
+              op->getLoc(), loadOp.getType(),
+              lookupOrDefault(loadOp.ptr(), stage), newMask,
+              lookupOrDefault(loadOp.other(), stage), loadOp.cache(),
+              loadOp.evict(), loadOp.isVolatile());
+          newOp = insertSliceFromRegisters(builder, op->getLoc(), tile,
+                                           loadStageBuffer[loadOp][stage],
+                                           pipelineIterIdx)
+                      .getDefiningOp();
+#else
           newOp = builder.create<triton::gpu::InsertSliceAsyncOp>(
               op->getLoc(), loadsBuffer[loadOp].getType(),
               lookupOrDefault(loadOp.ptr(), stage),
@@ -316,6 +584,7 @@ void LoopPipeliner::emitPrologue() {
               lookupOrDefault(loadOp.other(), stage), loadOp.cache(),
               loadOp.evict(), loadOp.isVolatile(), /*axis*/ 0);
           builder.create<triton::gpu::AsyncCommitGroupOp>(op->getLoc());
+#endif
           loadStageBuffer[loadOp].push_back(newOp->getResult(0));
         } else
           llvm_unreachable("This should be LoadOp");
@@ -330,6 +599,7 @@ void LoopPipeliner::emitPrologue() {
             newOp->setOperand(opIdx, v);
           } // else, op at opIdx is a loop-invariant value
         }
+        newOp = guardIndexLoad(builder, newOp, loopCond);
       }
 
       // Update mapping of results
@@ -360,22 +630,40 @@ void LoopPipeliner::emitPrologue() {
         builder.create<arith::ConstantIntOp>(iv.getLoc(), 1, 32));
   } // for (int stage = 0; stage < numStages - 1; ++stage)
 
+  // Index loads of the first iteration the loop body prefetches
+  if (!aheadLoads.empty()) {
+    BlockAndValueMapping aheadMapping;
+    Value aheadIV =
+        builder.create<arith::AddIOp>(iv.getLoc(), iv, forOp.getStep());
+    Value aheadCond = builder.create<arith::CmpIOp>(
+        iv.getLoc(), arith::CmpIPredicate::slt, aheadIV,
+        forOp.getUpperBound());
+    aheadMapping.map(forOp.getInductionVar(), aheadIV);
+    for (BlockArgument arg : aheadArgs) {
+      Value next = yieldOp->getOperand(arg.getArgNumber() - 1);
+      aheadMapping.map(arg, forOp.isDefinedOutsideOfLoop(next)
+                                ? next
+                                : valueMapping[arg][numStages - 1]);
+    }
+    aheadValues = emitAheadLoads(builder, aheadMapping, aheadCond);
+  }
+
   // async.wait & extract_slice
+#ifndef USE_ROCM
   builder.create<ttg::AsyncWaitOp>(loads[0].getLoc(),
                                    loads.size() * (numStages - 2));
+#endif
   loopIterIdx = builder.create<arith::ConstantIntOp>(iv.getLoc(), 0, 32);
   for (Value loadOp : loads) {
     auto sliceType = loadsMapping[loadOp].getType().cast<RankedTensorType>();
     sliceType =
         RankedTensorType::get(sliceType.getShape(), sliceType.getElementType(),
                               loadsBufferType[loadOp].getEncoding());
-    Value extractSlice = builder.create<tensor::ExtractSliceOp>(
-        loadOp.getLoc(), sliceType, loadStageBuffer[loadOp][numStages - 1],
-        SmallVector<OpFoldResult>{int_attr(0), int_attr(0), int_attr(0)},
-        SmallVector<OpFoldResult>{int_attr(1),
-                                  int_attr(sliceType.getShape()[0]),
-                                  int_attr(sliceType.getShape()[1])},
-        SmallVector<OpFoldResult>{int_attr(1), int_attr(1), int_attr(1)});
+    Value buffer =
+        gatherSliceOfStage(builder, loadOp.getLoc(),
+                           loadStageBuffer[loadOp][numStages - 1], loopIterIdx);
+    Value extractSlice = extractSliceOfStage(builder, loadOp.getLoc(),
+                                             sliceType, buffer, int_attr(0));
     loadsExtract[loadOp] = extractSlice;
   }
   // Bump up loopIterIdx, this is used for getting the correct slice for the
@@ -386,11 +674,13 @@ void LoopPipeliner::emitPrologue() {
 }
 
 void LoopPipeliner::emitEpilogue() {
+#ifndef USE_ROCM
   // If there's any outstanding async copies, we need to wait for them.
   OpBuilder builder(forOp);
   OpBuilder::InsertionGuard g(builder);
   builder.setInsertionPointAfter(forOp);
   builder.create<triton::gpu::AsyncWaitOp>(forOp.getLoc(), 0);
+#endif
 }
 
 scf::ForOp LoopPipeliner::createNewForOp() {
@@ -401,6 +691,7 @@ scf::ForOp LoopPipeliner::createNewForOp() {
   //   (insertSliceAsync buffer at stage numStages - 1) for each load
   //   (extracted tensor) for each load
   //   (depArgs at stage numStages - 2)
+  //   (aheadLoads at stage numStages - 1)
   //   (iv at stage numStages - 2)
   //   (pipeline iteration index)
   //   (loop iteration index)
@@ -424,6 +715,10 @@ scf::ForOp LoopPipeliner::createNewForOp() {
     newLoopArgs.push_back(valueMapping[depArg][numStages - 2]);
   }
 
+  size_t aheadLoadsIdx = newLoopArgs.size();
+  for (Value aheadValue : aheadValues)
+    newLoopArgs.push_back(aheadValue);
+
   size_t nextIVIdx = newLoopArgs.size();
   newLoopArgs.push_back(valueMapping[forOp.getInductionVar()][numStages - 2]);
   newLoopArgs.push_back(pipelineIterIdx);
@@ -507,12 +802,22 @@ scf::ForOp LoopPipeliner::createNewForOp() {
   Value extractSliceIndex = builder.create<arith::RemSIOp>(
       nextIV.getLoc(), loopIterIdx,
       builder.create<arith::ConstantIntOp>(nextIV.getLoc(), numStages, 32));
+  Value gatherIndex = extractSliceIndex;
   extractSliceIndex = builder.create<arith::IndexCastOp>(
       extractSliceIndex.getLoc(), builder.getIndexType(), extractSliceIndex);
 
   for (Operation *op : orderedDeps)
-    if (!loads.contains(op->getResult(0))) {
-      Operation *nextOp = builder.clone(*op, nextMapping);
+    if (aheadLoads.contains(op)) {
+      // Issued by the previous iteration
+      size_t aheadIdx =
+          std::distance(aheadLoads.begin(), llvm::find(aheadLoads, op));
+      nextMapping.map(op->getResult(0),
+                      newForOp.getRegionIterArgs()[aheadLoadsIdx + aheadIdx]);
+    } else if (!loads.contains(op->getResult(0))) {
+      Operation *nextOp = guardIndexLoad(
+          builder, builder.clone(*op, nextMapping), nextLoopCond);
+      for (unsigned dstIdx : llvm::seq(unsigned(0), op->getNumResults()))
+        nextMapping.map(op->getResult(dstIdx), nextOp->getResult(dstIdx));
 
       auto originYield = cast<scf::YieldOp>(forOp.getBody()->getTerminator());
       for (unsigned dstIdx : llvm::seq(unsigned(0), op->getNumResults())) {
@@ -529,6 +834,26 @@ scf::ForOp LoopPipeliner::createNewForOp() {
       }
     }
 
+  // Issue the index loads of the iteration after the prefetched one
+  if (!aheadLoads.empty()) {
+    BlockAndValueMapping aheadMapping;
+    Value aheadIV = builder.create<arith::AddIOp>(nextIV.getLoc(), nextIV,
+                                                  newForOp.getStep());
+    Value aheadCond = builder.create<arith::CmpIOp>(
+        nextIV.getLoc(), arith::CmpIPredicate::slt, aheadIV,
+        newForOp.getUpperBound());
+    aheadMapping.map(forOp.getInductionVar(), aheadIV);
+    for (BlockArgument arg : aheadArgs)
+      aheadMapping.map(arg, nextMapping.lookupOrDefault(
+                                yieldOp->getOperand(arg.getArgNumber() - 1)));
+    SmallVector<Value> nextAheadValues =
+        emitAheadLoads(builder, aheadMapping, aheadCond);
+    for (const auto &value : llvm::enumerate(nextAheadValues))
+      depArgsMapping[newForOp.getRegionIterArgs()[aheadLoadsIdx +
+                                                  value.index()]] =
+          value.value();
+  }
+
   for (Operation *op : orderedDeps) {
     Operation *nextOp = nullptr;
     // Update loading mask
@@ -549,6 +874,17 @@ scf::ForOp LoopPipeliner::createNewForOp() {
       } else
         newMask = builder.create<triton::SplatOp>(
             loadOp.getLoc(), getI1SameShape(loadOp), nextLoopCond);
+#ifdef USE_ROCM
+      Value tile = builder.create<triton::LoadOp>(
+          op->getLoc(), loadOp.getType(),
+          nextMapping.lookupOrDefault(loadOp.ptr()), newMask,
+          nextMapping.lookupOrDefault(loadOp.other()), loadOp.cache(),
+          loadOp.evict(), loadOp.isVolatile());
+      Value insertAsyncOp = insertSliceFromRegisters(
+          builder, op->getLoc(), tile,
+          newForOp.getRegionIterArgs()[bufferIdx + nextBuffers.size()],
+          insertSliceIndex);
+#else
       Value insertAsyncOp = builder.create<triton::gpu::InsertSliceAsyncOp>(
           op->getLoc(), loadsBuffer[loadOp].getType(),
           nextMapping.lookupOrDefault(loadOp.ptr()),
@@ -557,20 +893,18 @@ scf::ForOp LoopPipeliner::createNewForOp() {
           nextMapping.lookupOrDefault(loadOp.other()), loadOp.cache(),
           loadOp.evict(), loadOp.isVolatile(), /*axis*/ 0);
       builder.create<triton::gpu::AsyncCommitGroupOp>(op->getLoc());
+#endif
       nextBuffers.push_back(insertAsyncOp);
       auto sliceType = loadsMapping[loadOp].getType().cast<RankedTensorType>();
       sliceType = RankedTensorType::get(sliceType.getShape(),
                                         sliceType.getElementType(),
                                         loadsBufferType[loadOp].getEncoding());
-      nextOp = builder.create<tensor::ExtractSliceOp>(
-          op->getLoc(), sliceType, insertAsyncOp,
-          SmallVector<OpFoldResult>{extractSliceIndex, int_attr(0),
-                                    int_attr(0)},
-          SmallVector<OpFoldResult>{int_attr(1),
-                                    int_attr(sliceType.getShape()[0]),
-                                    int_attr(sliceType.getShape()[1])},
-          SmallVector<OpFoldResult>{int_attr(1), int_attr(1), int_attr(1)});
-      extractSlices.push_back(nextOp->getResult(0));
+      Value buffer = gatherSliceOfStage(builder, op->getLoc(), insertAsyncOp,
+                                        gatherIndex);
+      Value extractSlice = extractSliceOfStage(
+          builder, op->getLoc(), sliceType, buffer, extractSliceIndex);
+      nextOp = extractSlice.getDefiningOp();
+      extractSlices.push_back(extractSlice);
 
       // Update mapping of results
       for (unsigned dstIdx : llvm::seq(unsigned(0), op->getNumResults())) {
@@ -618,13 +952,35 @@ scf::ForOp LoopPipeliner::createNewForOp() {
     }
   }
 
+#ifdef USE_ROCM
+  // Hoist the address computation and the register loads of the next stage
+  // above the loop body so that their latency overlaps with the compute of
+  // the current stage. The LDS writes (insert_slice) and the slices read by
+  // the next iteration stay at the end of the body.
+  Operation *bodyBegin = &newForOp.getBody()->front();
+  Operation *prefetchBegin = nextIV.getDefiningOp();
+  if (bodyBegin != prefetchBegin) {
+    for (Operation &op : llvm::make_early_inc_range(llvm::make_range(
+             prefetchBegin->getIterator(), newForOp.getBody()->end()))) {
+      if (isa<tensor::InsertSliceOp, tensor::ExtractSliceOp>(op))
+        continue;
+      op.moveBefore(bodyBegin);
+    }
+  }
+#else
   // async.wait & extract_slice
   Operation *asyncWait = builder.create<ttg::AsyncWaitOp>(
       loads[0].getLoc(), loads.size() * (numStages - 2));
   for (auto it = extractSlices.rbegin(); it != extractSlices.rend(); ++it) {
     // move extract_slice after asyncWait
-    it->getDefiningOp()->moveAfter(asyncWait);
+    Operation *extractSlice = it->getDefiningOp();
+    extractSlice->moveAfter(asyncWait);
+    // with the gather of the slice, if shared in a cluster
+    if (auto gather = extractSlice->getOperand(0)
+                          .getDefiningOp<ttg::ClusterGatherOp>())
+      gather->moveAfter(asyncWait);
   }
+#endif
 
   // Bump iteration count
   pipelineIterIdx = builder.create<arith::AddIOp>(
@@ -658,6 +1014,258 @@ scf::ForOp LoopPipeliner::createNewForOp() {
   return newForOp;
 }
 
+/// Pipelines the loads that do not feed a dot through registers: the results
+/// of the next numStages-1 iterations are kept in flight as loop-carried
+/// values, so that no shared memory (nor layout conversion) is needed.
+///
+/// A load can be pipelined this way if its operands only depend on the
+/// induction variable and loop invariant values through side effect free ops,
+/// and if it does not read what the loop body writes, since it is moved above
+/// the stores and atomics of earlier iterations.
+class RegisterPipeliner {
+  struct PipelinedLoad {
+    triton::LoadOp loadOp;
+    int numStages;
+    /// Operations (inside the loop body) the load depends on, in def-use order
+    SetVector<Operation *> deps;
+  };
+
+  /// Registers (per thread) a pipelined load may keep in flight
+  static constexpr unsigned kRegisterBudget = 32;
+
+  scf::ForOp forOp;
+  int numStages;
+  SmallVector<PipelinedLoad> loads;
+
+  /// Roots (see getPointerRoots) of the global pointers the loop body may
+  /// write through, None if some of them are unknown
+  Optional<SmallVector<unsigned>> writtenRoots = SmallVector<unsigned>();
+  /// Whether the loop body may write to shared memory, e.g. to tt.scratch
+  /// buffers
+  bool writesShared = false;
+
+  bool collectDeps(Value v, SetVector<Operation *> &deps);
+
+  /// Whether `loadOp` may read memory the loop body writes
+  bool mayReadWritten(triton::LoadOp loadOp);
+
+  int getNumStages(triton::LoadOp loadOp);
+
+  /// Issue `load` for the iteration `iv` is mapped to in `mapping`, masked by
+  /// iv < ub
+  Value emitLoad(OpBuilder &builder, const PipelinedLoad &load,
+                 BlockAndValueMapping &mapping);
+
+public:
+  RegisterPipeliner(scf::ForOp forOp, int numStages)
+      : forOp(forOp), numStages(numStages) {}
+
+  /// Collect loads to pipeline. Return success if we can pipeline this loop
+  LogicalResult initialize();
+
+  /// Emit the prologue and create the new ForOp
+  scf::ForOp createNewForOp();
+};
+
+bool RegisterPipeliner::collectDeps(Value v, SetVector<Operation *> &deps) {
+  if (forOp.isDefinedOutsideOfLoop(v))
+    return true;
+  if (auto arg = v.dyn_cast<BlockArgument>())
+    return arg == forOp.getInductionVar();
+  Operation *op = v.getDefiningOp();
+  if (deps.contains(op))
+    return true;
+  if (op->getNumRegions() != 0 || !MemoryEffectOpInterface::hasNoEffect(op))
+    return false;
+  for (Value operand : op->getOperands())
+    if (!collectDeps(operand, deps))
+      return false;
+  deps.insert(op);
+  return true;
+}
+
+// Global loads are in the same latency class whatever their consumer, so all
+// of them get numStages stages, unless the values in flight would exceed the
+// register budget of the load
+int RegisterPipeliner::getNumStages(triton::LoadOp loadOp) {
+  auto ty = loadOp.getType().cast<RankedTensorType>();
+  unsigned bitsPerThread =
+      ttg::getElemsPerThread(ty) * ty.getElementTypeBitWidth();
+  unsigned regsPerStage = std::max<unsigned>(1, (bitsPerThread + 31) / 32);
+  int maxInFlight = kRegisterBudget / regsPerStage;
+  return 1 + std::min(numStages - 1, maxInFlight);
+}
+
+bool RegisterPipeliner::mayReadWritten(triton::LoadOp loadOp) {
+  if (!isGlobalPointer(loadOp.ptr()))
+    return writesShared;
+  if (!writtenRoots)
+    return true;
+  if (writtenRoots->empty())
+    return false;
+  auto roots = getPointerRoots(loadOp.ptr());
+  if (!roots)
+    return true;
+  auto funcOp = forOp->getParentOfType<FuncOp>();
+  auto isNoAlias = [&](unsigned arg) {
+    return static_cast<bool>(funcOp.getArgAttr(arg, "tt.noalias"));
+  };
+  for (unsigned root : *roots)
+    for (unsigned written : *writtenRoots)
+      if (root == written || (!isNoAlias(root) && !isNoAlias(written)))
+        return true;
+  return false;
+}
+
+LogicalResult RegisterPipeliner::initialize() {
+  forOp.getBody()->walk([&](Operation *op) {
+    if (!mayWriteThroughPointers(op))
+      return;
+    for (Value operand : op->getOperands()) {
+      if (!getElementTypeOrSelf(operand.getType())
+               .isa<triton::PointerType>())
+        continue;
+      if (!isGlobalPointer(operand)) {
+        writesShared = true;
+        continue;
+      }
+      auto roots = getPointerRoots(operand);
+      if (!roots)
+        writtenRoots = llvm::None;
+      else if (writtenRoots)
+        writtenRoots->append(roots->begin(), roots->end());
+    }
+  });
+  for (Operation &op : *forOp.getBody()) {
+    auto loadOp = dyn_cast<triton::LoadOp>(&op);
+    // Volatile loads can't be issued ahead of time
+    if (!loadOp || loadOp.isVolatile() || mayReadWritten(loadOp))
+      continue;
+    auto ty = loadOp.getType().dyn_cast<RankedTensorType>();
+    if (!ty || !ty.getElementType().isIntOrFloat())
+      continue;
+    SetVector<Operation *> deps;
+    if (!llvm::all_of(loadOp->getOperands(),
+                      [&](Value v) { return collectDeps(v, deps); }))
+      continue;
+    int loadStages = getNumStages(loadOp);
+    if (loadStages > 1)
+      loads.push_back({loadOp, loadStages, deps});
+  }
+  return success(!loads.empty());
+}
+
+Value RegisterPipeliner::emitLoad(OpBuilder &builder,
+                                  const PipelinedLoad &load,
+                                  BlockAndValueMapping &mapping) {
+  for (Operation *op : load.deps)
+    if (!mapping.contains(op->getResult(0)))
+      builder.clone(*op, mapping);
+  triton::LoadOp loadOp = load.loadOp;
+  Location loc = loadOp.getLoc();
+  Value iv = mapping.lookup(forOp.getInductionVar());
+  Value loopCond = builder.create<arith::CmpIOp>(
+      loc, arith::CmpIPredicate::slt, iv, forOp.getUpperBound());
+  Value newMask =
+      builder.create<triton::SplatOp>(loc, getI1SameShape(loadOp), loopCond);
+  if (Value mask = loadOp.mask())
+    newMask = builder.create<arith::AndIOp>(
+        loc, mapping.lookupOrDefault(mask), newMask);
+  return builder.create<triton::LoadOp>(
+      loc, loadOp.getType(), mapping.lookupOrDefault(loadOp.ptr()), newMask,
+      mapping.lookupOrDefault(loadOp.other()), loadOp.cache(), loadOp.evict(),
+      loadOp.isVolatile(), loadOp.l2EvictLastFractionAttr());
+}
+
+scf::ForOp RegisterPipeliner::createNewForOp() {
+  OpBuilder builder(forOp);
+  Location loc = forOp.getLoc();
+
+  // prologue: loads of the iterations [0, numStages-1) of each load
+  int maxNumStages = 0;
+  for (const PipelinedLoad &load : loads)
+    maxNumStages = std::max(maxNumStages, load.numStages);
+  SmallVector<SmallVector<Value>> inFlight(loads.size());
+  Value iv = forOp.getLowerBound();
+  for (int stage = 0; stage < maxNumStages - 1; ++stage) {
+    if (stage != 0)
+      iv = builder.create<arith::AddIOp>(loc, iv, forOp.getStep());
+    BlockAndValueMapping mapping;
+    mapping.map(forOp.getInductionVar(), iv);
+    for (auto load : llvm::enumerate(loads))
+      if (stage < load.value().numStages - 1)
+        inFlight[load.index()].push_back(
+            emitLoad(builder, load.value(), mapping));
+  }
+
+  // Order of new args:
+  //   (original args)
+  //   (results of the iterations [iv, iv + (numStages-1) * step)) for each load
+  SmallVector<Value> newLoopArgs;
+  for (auto v : forOp.getIterOperands())
+    newLoopArgs.push_back(v);
+  SmallVector<size_t> inFlightIdx;
+  for (ArrayRef<Value> values : inFlight) {
+    inFlightIdx.push_back(newLoopArgs.size());
+    newLoopArgs.append(values.begin(), values.end());
+  }
+  auto newForOp =
+      builder.create<scf::ForOp>(loc, forOp.getLowerBound(),
+                                 forOp.getUpperBound(), forOp.getStep(),
+                                 newLoopArgs);
+
+  builder.setInsertionPointToStart(newForOp.getBody());
+  BlockAndValueMapping mapping;
+  for (const auto &arg : llvm::enumerate(forOp.getRegionIterArgs()))
+    mapping.map(arg.value(), newForOp.getRegionIterArgs()[arg.index()]);
+  mapping.map(forOp.getInductionVar(), newForOp.getInductionVar());
+
+  // Issue the loads of iteration iv + (numStages-1) * step before the body, so
+  // that their latency overlaps with its compute
+  std::map<int, BlockAndValueMapping> nextMappings;
+  SmallVector<Value> nextValues;
+  for (const PipelinedLoad &load : loads) {
+    BlockAndValueMapping &nextMapping = nextMappings[load.numStages];
+    if (!nextMapping.contains(forOp.getInductionVar())) {
+      Value distance = builder.create<arith::MulIOp>(
+          loc, newForOp.getStep(),
+          builder.create<arith::ConstantIndexOp>(loc, load.numStages - 1));
+      nextMapping.map(forOp.getInductionVar(),
+                      builder.create<arith::AddIOp>(
+                          loc, newForOp.getInductionVar(), distance));
+    }
+    nextValues.push_back(emitLoad(builder, load, nextMapping));
+  }
+
+  // Clone the loop body, the pipelined loads are replaced by the values loaded
+  // numStages-1 iterations ago
+  for (auto load : llvm::enumerate(loads))
+    mapping.map(load.value().loadOp.getResult(),
+                newForOp.getRegionIterArgs()[inFlightIdx[load.index()]]);
+  for (Operation &op : forOp.getBody()->without_terminator()) {
+    if (auto loadOp = dyn_cast<triton::LoadOp>(&op))
+      if (llvm::any_of(loads, [&](const PipelinedLoad &load) {
+            return load.loadOp == loadOp;
+          }))
+        continue;
+    builder.clone(op, mapping);
+  }
+
+  // Shift the values in flight
+  SmallVector<Value> yieldValues;
+  for (Value v : forOp.getBody()->getTerminator()->getOperands())
+    yieldValues.push_back(mapping.lookupOrDefault(v));
+  for (auto load : llvm::enumerate(loads)) {
+    size_t idx = inFlightIdx[load.index()];
+    for (int stage = 1; stage < load.value().numStages - 1; ++stage)
+      yieldValues.push_back(newForOp.getRegionIterArgs()[idx + stage]);
+    yieldValues.push_back(nextValues[load.index()]);
+  }
+  builder.create<scf::YieldOp>(forOp.getBody()->getTerminator()->getLoc(),
+                               yieldValues);
+  return newForOp;
+}
+
 // ref: mlir/lib/Dialect/SCF/Transforms/LoopPipelining.cpp
 struct PipelinePass : public TritonGPUPipelineBase<PipelinePass> {
   PipelinePass() = default;
@@ -670,16 +1278,30 @@ struct PipelinePass : public TritonGPUPipelineBase<PipelinePass> {
       return;
 
     getOperation()->walk([&](scf::ForOp forOp) -> void {
-      LoopPipeliner pipeliner(forOp, numStages);
-
-      if (pipeliner.initialize().failed())
+      // The partial last iteration split off by the peeling pass runs at most
+      // once, and is not worth the shared memory of a pipeline
+      if (forOp->hasAttr("triton_gpu.peeled_tail"))
         return;
 
-      pipeliner.emitPrologue();
+      LoopPipeliner pipeliner(forOp, numStages);
+      scf::ForOp newForOp;
 
-      scf::ForOp newForOp = pipeliner.createNewForOp();
+      if (pipeliner.initialize().succeeded()) {
+        pipeliner.emitPrologue();
 
-      pipeliner.emitEpilogue();
+        newForOp = pipeliner.createNewForOp();
+
+        pipeliner.emitEpilogue();
+      } else {
+        // Loops without dot operands to stage in shared memory (e.g.
+        // reductions, softmax or layer-norm) pipeline their loads through
+        // registers instead
+        RegisterPipeliner regPipeliner(forOp, numStages);
+        if (regPipeliner.initialize().failed())
+          return;
+
+        newForOp = regPipeliner.createNewForOp();
+      }
 
       // replace the original loop
       for (unsigned i = 0; i < forOp->getNumResults(); ++i)
@@ -24,6 +24,10 @@
 //   ...
 //   scf.yield %next_a, ..., %a_prefetch_next
 // }
+//
+// The prefetch width (16 above) is a multiple of the K extent of the MMA
+// instruction of the dot encoding. Operands defined outside the loop (e.g. by
+// an enclosing loop) are prefetched once, before the loop.
 //===----------------------------------------------------------------------===//
 
 #include "mlir/IR/BlockAndValueMapping.h"
@@ -43,8 +47,9 @@ class Prefetcher {
   scf::ForOp forOp;
   /// cache the YieldOp of this ForOp
   scf::YieldOp yieldOp;
+  /// prefetch width requested by the user, 0 if it should be inferred
+  unsigned userPrefetchWidth;
   ///
-  // TODO: add a hook to infer prefetchWidth
   unsigned prefetchWidth = 16;
 
   /// dots to be prefetched
@@ -61,6 +66,8 @@ class Prefetcher {
 
   LogicalResult isForOpOperand(Value v);
 
+  unsigned getPrefetchWidth(triton::DotOp dot, int64_t kSize);
+
   Value generatePrefetch(Value v, unsigned opIdx, bool isPrologue,
                          Attribute dotEncoding, OpBuilder &builder,
                          llvm::Optional<int64_t> offsetK = llvm::None,
@@ -69,7 +76,8 @@ class Prefetcher {
 public:
   Prefetcher() = delete;
 
-  Prefetcher(scf::ForOp forOp) : forOp(forOp) {
+  Prefetcher(scf::ForOp forOp, unsigned userPrefetchWidth = 0)
+      : forOp(forOp), userPrefetchWidth(userPrefetchWidth) {
     yieldOp = cast<scf::YieldOp>(forOp.getBody()->getTerminator());
   }
 
@@ -120,6 +128,48 @@ Value Prefetcher::generatePrefetch(Value v, unsigned opIdx, bool isPrologue,
   return prefetchSlice;
 }
 
+// Returns the K extent of a single MMA instruction for operands of type
+// `elemTy` in `dotEncoding`
+static unsigned getInstrShapeK(Attribute dotEncoding, Type elemTy) {
+  unsigned bitWidth = elemTy.getIntOrFloatBitWidth();
+  if (auto mmaEnc = dotEncoding.dyn_cast<triton::gpu::MmaEncodingAttr>())
+    // mma.m8n8k4 on Volta, mma.m16n8k{8,16,32} (32 bytes along K) otherwise
+    return mmaEnc.isVolta() ? 4 : 256 / bitWidth;
+  if (dotEncoding.isa<triton::gpu::MfmaEncodingAttr>()) {
+    // v_mfma_*_32x32x{2f32,4bf16,8f16,8i8}
+    if (elemTy.isF32())
+      return 2;
+    if (elemTy.isBF16())
+      return 4;
+    return 8;
+  }
+  return 256 / bitWidth;
+}
+
+// The prefetched slices are kept in registers while the previous ones are
+// consumed, so the width grows with K to keep at most kMaxSlices slices per
+// iteration, but it spans at least one instruction and 32 bytes along K
+unsigned Prefetcher::getPrefetchWidth(triton::DotOp dot, int64_t kSize) {
+  constexpr int64_t kMaxSlices = 4;
+  auto aType = dot.a().getType().cast<RankedTensorType>();
+  Attribute dotEncoding = dot.getType().cast<RankedTensorType>().getEncoding();
+  int64_t instrK = getInstrShapeK(dotEncoding, aType.getElementType());
+  int64_t minWidth = std::max<int64_t>(
+      instrK, 256 / aType.getElementTypeBitWidth());
+
+  if (userPrefetchWidth > 0 && userPrefetchWidth % instrK == 0 &&
+      kSize % userPrefetchWidth == 0 && kSize > userPrefetchWidth)
+    return userPrefetchWidth;
+
+  int64_t width = minWidth;
+  while (kSize / width > kMaxSlices)
+    width *= 2;
+  // There must be a remaining part to overlap the prefetch with
+  if (kSize % width != 0 || kSize <= width)
+    return 0;
+  return width;
+}
+
 LogicalResult Prefetcher::initialize() {
   Block *loop = forOp.getBody();
 
@@ -144,29 +194,40 @@ LogicalResult Prefetcher::initialize() {
     return Value();
   };
 
+  // loop-invariant operands are their own header definition
   auto getIncomingOp = [this](Value v) -> Value {
     if (auto arg = v.dyn_cast<BlockArgument>())
       if (arg.getOwner()->getParentOp() == forOp.getOperation())
         return forOp.getOpOperandForRegionIterArg(arg).get();
+    if (forOp.isDefinedOutsideOfLoop(v))
+      return v;
     return Value();
   };
 
+  // loop-invariant operands have no next value to prefetch
   auto getYieldOp = [this](Value v) -> Value {
-    auto arg = v.cast<BlockArgument>();
+    auto arg = v.dyn_cast<BlockArgument>();
+    if (!arg || arg.getOwner()->getParentOp() != forOp.getOperation())
+      return Value();
     unsigned yieldIdx = arg.getArgNumber() - forOp.getNumInductionVars();
     return yieldOp.getOperand(yieldIdx);
   };
 
   for (triton::DotOp dot : dotsInFor) {
+    // batched dots are lowered through the FMA path, which does not slice k
+    if (dot.getType().cast<RankedTensorType>().getRank() != 2)
+      continue;
+    // wgmma reads $b from shared memory itself: there is nothing to prefetch
+    // into registers
+    auto dotEncoding = dot.getType().cast<RankedTensorType>().getEncoding();
+    if (auto mmaEnc = dotEncoding.dyn_cast<triton::gpu::MmaEncodingAttr>())
+      if (mmaEnc.isHopper())
+        continue;
     auto kSize = dot.a().getType().cast<RankedTensorType>().getShape()[1];
 
-    // works better with nvidia tensor cores
-    unsigned elementWidth =
-        dot.a().getType().cast<RankedTensorType>().getElementTypeBitWidth();
-    prefetchWidth = 256 / elementWidth;
-
-    // Skip prefetching if kSize is less than prefetchWidth
-    if (kSize < prefetchWidth)
+    prefetchWidth = getPrefetchWidth(dot, kSize);
+    // Skip prefetching if K can't be split into prefetchWidth slices
+    if (prefetchWidth == 0)
       continue;
     Value aSmem = getPrefetchSrc(dot.a());
     Value bSmem = getPrefetchSrc(dot.b());
@@ -186,6 +247,9 @@ LogicalResult Prefetcher::initialize() {
     }
   }
 
+  if (dots.empty())
+    return failure();
+
   return success();
 }
 
@@ -259,11 +323,11 @@ scf::ForOp Prefetcher::createNewForOp() {
         auto insertionPoint = builder.saveInsertionPoint();
         builder.setInsertionPoint(prevDot);
         Value aRem =
-            generatePrefetch(mapping.lookup(dot2aLoopArg[dot]), 0, false,
-                             dotEncoding, builder, kOff, kShape);
+            generatePrefetch(mapping.lookupOrDefault(dot2aLoopArg[dot]), 0,
+                             false, dotEncoding, builder, kOff, kShape);
         Value bRem =
-            generatePrefetch(mapping.lookup(dot2bLoopArg[dot]), 1, false,
-                             dotEncoding, builder, kOff, kShape);
+            generatePrefetch(mapping.lookupOrDefault(dot2bLoopArg[dot]), 1,
+                             false, dotEncoding, builder, kOff, kShape);
         builder.restoreInsertionPoint(insertionPoint);
         newOp = builder.clone(*dot, mapping);
         newOp->setOperand(0, aRem);
@@ -283,13 +347,20 @@ scf::ForOp Prefetcher::createNewForOp() {
   SmallVector<Value> yieldValues;
   for (Value v : forOp.getBody()->getTerminator()->getOperands())
     yieldValues.push_back(mapping.lookup(v));
+  unsigned prefetchArgIdx = forOp.getNumIterOperands();
   for (Value dot : dots) {
     Attribute dotEncoding =
         dot.getType().cast<RankedTensorType>().getEncoding();
-    yieldValues.push_back(generatePrefetch(mapping.lookup(dot2aYield[dot]), 0,
-                                           true, dotEncoding, builder));
-    yieldValues.push_back(generatePrefetch(mapping.lookup(dot2bYield[dot]), 1,
-                                           true, dotEncoding, builder));
+    // loop-invariant operands keep the slice prefetched before the loop
+    auto nextPrefetch = [&](Value yieldValue, unsigned opIdx) -> Value {
+      Value prefetchArg = newForOp.getRegionIterArgs()[prefetchArgIdx++];
+      if (!yieldValue)
+        return prefetchArg;
+      return generatePrefetch(mapping.lookup(yieldValue), opIdx, true,
+                              dotEncoding, builder);
+    };
+    yieldValues.push_back(nextPrefetch(dot2aYield[dot], 0));
+    yieldValues.push_back(nextPrefetch(dot2bYield[dot], 1));
   }
   // Update ops of yield
   builder.create<scf::YieldOp>(yieldOp.getLoc(), yieldValues);
@@ -297,9 +368,13 @@ scf::ForOp Prefetcher::createNewForOp() {
 }
 
 struct PrefetchPass : public TritonGPUPrefetchBase<PrefetchPass> {
+  PrefetchPass() = default;
+  PrefetchPass(int prefetchWidth) { this->prefetchWidth = prefetchWidth; }
+
   void runOnOperation() override {
     getOperation()->walk([&](scf::ForOp forOp) {
-      Prefetcher prefetcher(forOp);
+      int userPrefetchWidth = this->prefetchWidth;
+      Prefetcher prefetcher(forOp, std::max(0, userPrefetchWidth));
 
       if (prefetcher.initialize().failed())
         return;
@@ -318,6 +393,6 @@ struct PrefetchPass : public TritonGPUPrefetchBase<PrefetchPass> {
 
 } // anonymous namespace
 
-std::unique_ptr<Pass> mlir::createTritonGPUPrefetchPass() {
-  return std::make_unique<PrefetchPass>();
+std::unique_ptr<Pass> mlir::createTritonGPUPrefetchPass(int prefetchWidth) {
+  return std::make_unique<PrefetchPass>(prefetchWidth);
 }
@@ -29,7 +29,8 @@ willIncreaseRegisterPressure(triton::gpu::ConvertLayoutOp op) {
   auto dstEncoding = dstType.getEncoding();
   if (srcEncoding.isa<triton::gpu::SharedEncodingAttr>())
     return true;
-  if (dstEncoding.isa<triton::gpu::DotOperandEncodingAttr>())
+  if (dstEncoding.isa<triton::gpu::DotOperandEncodingAttr,
+                      triton::gpu::SparseDotMetaEncodingAttr>())
     return true;
   return false;
 }
@@ -12,8 +12,9 @@ using namespace mlir::triton::gpu;
 // TypeConverter
 //
 TritonGPUTypeConverter::TritonGPUTypeConverter(MLIRContext *context,
-                                               int numWarps)
-    : context(context), numWarps(numWarps) {
+                                               int numWarps,
+                                               int threadsPerWarp)
+    : context(context), numWarps(numWarps), threadsPerWarp(threadsPerWarp) {
   // TODO: how does MLIR pick the right conversion?
   addConversion([](Type type) { return type; });
   addConversion([this](RankedTensorType tensorType) -> RankedTensorType {
@@ -30,7 +31,8 @@ TritonGPUTypeConverter::TritonGPUTypeConverter(MLIRContext *context,
     std::iota(order.begin(), order.end(), 0);
     llvm::SmallVector<unsigned> sizePerThread(rank, 1);
     Attribute encoding = triton::gpu::BlockedEncodingAttr::get(
-        this->context, shape, sizePerThread, order, this->numWarps);
+        this->context, shape, sizePerThread, order, this->numWarps,
+        this->threadsPerWarp);
     return RankedTensorType::get(shape, tensorType.getElementType(), encoding);
   });
 
@@ -100,4 +102,15 @@ TritonGPUConversionTarget::TritonGPUConversionTarget(
       return true;
     return false;
   });
+  addDynamicallyLegalOp<triton::SparseDotOp>(
+      [](triton::SparseDotOp dotOp) -> bool {
+        Attribute aEncoding =
+            dotOp.a().getType().cast<RankedTensorType>().getEncoding();
+        Attribute bEncoding =
+            dotOp.b().getType().cast<RankedTensorType>().getEncoding();
+        return aEncoding &&
+               aEncoding.isa<triton::gpu::DotOperandEncodingAttr>() &&
+               bEncoding &&
+               bEncoding.isa<triton::gpu::DotOperandEncodingAttr>();
+      });
 }
@@ -171,8 +171,9 @@ public:
       return failure();
 
     auto newTensorTy = getUpdatedType(tensorTy);
-    rewriter.replaceOpWithNewOp<DotOp>(op, newTensorTy, dotOp.a(), dotOp.b(),
-                                       dotOp.c(), dotOp.allowTF32());
+    rewriter.replaceOpWithNewOp<DotOp>(
+        op, newTensorTy, dotOp.a(), dotOp.b(), dotOp.c(), dotOp.allowTF32Attr(),
+        dotOp.aFp8FormatAttr(), dotOp.bFp8FormatAttr(), dotOp.precisionAttr());
     return success();
   }
 
@@ -2,6 +2,9 @@
 #include "mlir/Dialect/SCF/SCF.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "triton/Analysis/Allocation.h"
+#include "triton/Analysis/Utility.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
 
 namespace mlir {
 
@@ -60,4 +63,73 @@ LogicalResult fixupLoops(ModuleOp mod) {
   return success();
 }
 
+namespace {
+
+// Relative per-thread costs of the instructions layout changes lower to
+constexpr double kAluOpCost = 1.0;
+constexpr double kShuffleCost = 2.0;
+constexpr double kMemAccessCost = 4.0;
+constexpr double kBarrierCost = 32.0;
+// Trip count assumed for scf.for loops, whose bounds are seldom constant
+constexpr double kLoopTripCount = 8.0;
+
+unsigned getRegElemsPerThread(Attribute encoding, ArrayRef<int64_t> shape) {
+  if (!triton::gpu::isaDistributedLayout(encoding))
+    return 0;
+  return triton::gpu::getElemsPerThread(encoding, shape);
+}
+
+} // namespace
+
+double LayoutCostModel::getLoopWeight(Operation *op) const {
+  double weight = 1.0;
+  for (auto forOp = op->getParentOfType<scf::ForOp>(); forOp;
+       forOp = forOp->getParentOfType<scf::ForOp>())
+    weight *= kLoopTripCount;
+  return weight;
+}
+
+double LayoutCostModel::getConversionCost(RankedTensorType srcTy,
+                                          Attribute dstEncoding,
+                                          Operation *where) const {
+  Attribute srcEncoding = srcTy.getEncoding();
+  if (srcEncoding == dstEncoding)
+    return 0.0;
+  // mma -> dot_operand shortcuts stay in registers
+  if (auto mmaLayout = srcEncoding.dyn_cast<triton::gpu::MmaEncodingAttr>())
+    if (auto dotOperandLayout =
+            dstEncoding.dyn_cast<triton::gpu::DotOperandEncodingAttr>())
+      if (isMmaToDotShortcut(mmaLayout, dotOperandLayout))
+        return 0.0;
+  auto shape = srcTy.getShape();
+  auto dstTy =
+      RankedTensorType::get(shape, srcTy.getElementType(), dstEncoding);
+  double weight = getLoopWeight(where);
+  unsigned srcElems = getRegElemsPerThread(srcEncoding, shape);
+  unsigned dstElems = getRegElemsPerThread(dstEncoding, shape);
+  if (!getWarpShuffleSrcElems(srcTy, dstTy).empty())
+    return weight * kShuffleCost * dstElems;
+  // Otherwise every thread stores its source elements to shared memory and
+  // loads back its destination ones, with a barrier before and after each
+  // replica going through the scratch buffer
+  unsigned elemBits = srcTy.getElementType().isa<triton::PointerType>()
+                          ? 64
+                          : std::max(8u, srcTy.getElementTypeBitWidth());
+  unsigned bytes = elemBits / 8 * product<int64_t>(shape);
+  unsigned numReps =
+      ceil<unsigned>(bytes, triton::kMaxSingleRepCvtScratchBytes);
+  double numWords = (srcElems + dstElems) * elemBits / 32.0;
+  return weight * (kMemAccessCost * numWords + kBarrierCost * 2 * numReps);
+}
+
+double LayoutCostModel::getRematerializationCost(Operation *op,
+                                                 Attribute encoding) const {
+  double opCost = isa<triton::LoadOp>(op) ? kMemAccessCost : kAluOpCost;
+  double cost = 0.0;
+  for (Value result : op->getResults())
+    if (auto tensorTy = result.getType().dyn_cast<RankedTensorType>())
+      cost += opCost * getRegElemsPerThread(encoding, tensorTy.getShape());
+  return rematWeight * getLoopWeight(op) * cost;
+}
+
 } // namespace mlir
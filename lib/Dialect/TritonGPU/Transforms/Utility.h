@@ -1,5 +1,6 @@
 #ifndef TRITON_LIB_DIALECT_TRITONGPU_TRANSFORMS_UTILITY_H_
 #define TRITON_LIB_DIALECT_TRITONGPU_TRANSFORMS_UTILITY_H_
+#include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
 
@@ -7,6 +8,34 @@ namespace mlir {
 
 LogicalResult fixupLoops(ModuleOp mod);
 
+// Estimates the per-thread cost of the layout conversions and of the
+// recomputations introduced when a value is rematerialized in another layout.
+// Costs are in arbitrary units, and are scaled by the loop nesting depth of the
+// operation they are attributed to so that conversions left inside hot loops
+// dominate. Subclass it to tune the heuristics of the combine pass.
+class LayoutCostModel {
+public:
+  // `rematWeight` scales the cost of recomputations relative to conversions
+  explicit LayoutCostModel(double rematWeight = 1.0)
+      : rematWeight(rematWeight) {}
+  virtual ~LayoutCostModel() = default;
+
+  // Cost of converting a value of type `srcTy` to `dstEncoding` right after
+  // `where`: shared memory traffic and barriers, or warp shuffles.
+  virtual double getConversionCost(RankedTensorType srcTy,
+                                   Attribute dstEncoding,
+                                   Operation *where) const;
+
+  // Cost of computing `op` once more, with its results in `encoding`.
+  virtual double getRematerializationCost(Operation *op,
+                                          Attribute encoding) const;
+
+protected:
+  double getLoopWeight(Operation *op) const;
+
+  double rematWeight;
+};
+
 } // namespace mlir
 
 #endif // TRITON_LIB_DIALECT_TRITONGPU_TRANSFORMS_UTILITY_H_
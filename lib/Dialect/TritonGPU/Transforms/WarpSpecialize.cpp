@@ -0,0 +1,449 @@
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+//
+// This file implements warp specialization of pipelined loops.
+//
+// The function body is duplicated into the two branches of an scf.if on the
+// warp group id. Warp group 0 (producer) only keeps the async copies into the
+// stages of the pipeline, warp group 1 (consumer) only keeps the math. Both
+// groups use the same layouts (triton_gpu.num-warps warps each), and are
+// synchronized through two named barriers per stage:
+//
+//   producer                           consumer
+//   prologue copies
+//   async_wait                         arrive(empty[S-1])
+//   arrive(full[0])                    wait(full[0])
+//   for n in [0, N):                   for n in [0, N):
+//     wait(empty[(n+S-1)%S])             dot on stage n%S
+//     copies into stage (n+S-1)%S        arrive(empty[n%S])
+//     async_wait                         wait(full[(n+1)%S])
+//     arrive(full[(n+1)%S])
+//   wait(empty[(N+S-1)%S])             epilogue
+//
+// Every arrive is matched by exactly one wait, so that the phases of a named
+// barrier never run ahead of each other.
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+namespace ttg = triton::gpu;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
+
+namespace {
+
+// Named barrier 0 is used by __syncthreads, and the last two ones are used by
+// barriers local to each warp group (see GPUBarrierOpConversion)
+constexpr int kFullBarrierBase = 1;
+constexpr int kMaxNumStages = 6;
+
+class WarpSpecializer {
+  ModuleOp mod;
+  mlir::FuncOp funcOp;
+  int numStages = 0;
+  int numThreads = 0;
+
+  // barrier id = base + (iteration + offset) % numStages
+  Value getStageBarrier(OpBuilder &builder, Location loc, Value iteration,
+                        int offset, int base);
+
+  Value getIteration(OpBuilder &builder, Location loc, scf::ForOp forOp);
+
+  void arrive(OpBuilder &builder, Location loc, Value bar) {
+    builder.create<ttg::NamedBarrierArriveOp>(loc, bar, numThreads);
+  }
+
+  void wait(OpBuilder &builder, Location loc, Value bar) {
+    builder.create<ttg::NamedBarrierWaitOp>(loc, bar, numThreads);
+  }
+
+  int getEmptyBarrierBase() const { return kFullBarrierBase + numStages; }
+
+  void specializeProducer(Block *block);
+
+  void specializeConsumer(Block *block);
+
+public:
+  WarpSpecializer(ModuleOp mod, mlir::FuncOp funcOp)
+      : mod(mod), funcOp(funcOp) {}
+
+  LogicalResult initialize();
+
+  void run();
+};
+
+// Returns the unique loop of the block pipelined by LoopPipeliner
+scf::ForOp getPipelinedLoop(Block *block) {
+  scf::ForOp pipelinedLoop;
+  for (auto forOp : block->getOps<scf::ForOp>()) {
+    bool hasAsyncCopy = false;
+    bool hasDot = false;
+    forOp.getBody()->walk([&](Operation *op) {
+      hasAsyncCopy |= isa<ttg::InsertSliceAsyncOp>(op);
+      hasDot |= isa<triton::DotOp>(op);
+    });
+    if (!hasAsyncCopy || !hasDot)
+      continue;
+    if (pipelinedLoop)
+      return scf::ForOp();
+    pipelinedLoop = forOp;
+  }
+  return pipelinedLoop;
+}
+
+// Returns the unique async_wait of the block that precedes `op`, or the
+// unique one of the block if `op` is null
+ttg::AsyncWaitOp getAsyncWait(Block *block, Operation *op = nullptr) {
+  ttg::AsyncWaitOp asyncWait;
+  for (auto waitOp : block->getOps<ttg::AsyncWaitOp>()) {
+    if (op && !waitOp->isBeforeInBlock(op))
+      continue;
+    if (asyncWait)
+      return ttg::AsyncWaitOp();
+    asyncWait = waitOp;
+  }
+  return asyncWait;
+}
+
+// Removes side effect free operations without uses, innermost first
+void eraseDeadOps(Block *block) {
+  for (Operation &op : llvm::make_early_inc_range(llvm::reverse(*block))) {
+    for (Region &region : op.getRegions())
+      for (Block &nested : region)
+        eraseDeadOps(&nested);
+    if (isOpTriviallyDead(&op))
+      op.erase();
+  }
+}
+
+// Removes the iter args of the loop that only feed their own yield operand
+scf::ForOp eraseDeadIterArgs(scf::ForOp forOp) {
+  Block *body = forOp.getBody();
+  auto yieldOp = cast<scf::YieldOp>(body->getTerminator());
+  llvm::BitVector dead(forOp.getNumIterOperands());
+  SmallVector<SetVector<Operation *>> deadSlices(dead.size());
+  for (unsigned i = 0; i < dead.size(); ++i) {
+    if (!forOp.getResult(i).use_empty())
+      continue;
+    // Forward slice of the iter arg, which must be closed but for the yield
+    SetVector<Operation *> &slice = deadSlices[i];
+    SmallVector<Value> worklist{forOp.getRegionIterArgs()[i]};
+    bool isDead = true;
+    while (!worklist.empty() && isDead) {
+      Value value = worklist.pop_back_val();
+      for (OpOperand &use : value.getUses()) {
+        Operation *user = use.getOwner();
+        if (user == yieldOp) {
+          isDead &= use.getOperandNumber() == i;
+          continue;
+        }
+        if (user->getBlock() != body || user->getNumRegions() != 0 ||
+            !MemoryEffectOpInterface::hasNoEffect(user)) {
+          isDead = false;
+          break;
+        }
+        if (slice.insert(user))
+          worklist.append(user->result_begin(), user->result_end());
+      }
+    }
+    dead[i] = isDead;
+  }
+  if (dead.none())
+    return forOp;
+
+  // Drop the dead slices
+  for (unsigned i = 0; i < dead.size(); ++i) {
+    if (!dead[i])
+      continue;
+    yieldOp->setOperand(i, forOp.getRegionIterArgs()[i]);
+    for (Operation *op : llvm::reverse(deadSlices[i])) {
+      op->dropAllUses();
+      op->erase();
+    }
+  }
+
+  // Rebuild the loop with the remaining iter args
+  SmallVector<Value> initArgs;
+  SmallVector<Value> yieldOperands;
+  for (unsigned i = 0; i < dead.size(); ++i) {
+    if (dead[i])
+      continue;
+    initArgs.push_back(forOp.getIterOperands()[i]);
+    yieldOperands.push_back(yieldOp.getOperand(i));
+  }
+  OpBuilder builder(forOp);
+  auto newForOp = builder.create<scf::ForOp>(
+      forOp.getLoc(), forOp.getLowerBound(), forOp.getUpperBound(),
+      forOp.getStep(), initArgs);
+  Block *newBody = newForOp.getBody();
+  newBody->getTerminator()->erase();
+  newBody->getOperations().splice(newBody->end(), body->getOperations());
+  forOp.getInductionVar().replaceAllUsesWith(newForOp.getInductionVar());
+  unsigned newIdx = 0;
+  for (unsigned i = 0; i < dead.size(); ++i) {
+    Value iterArg = forOp.getRegionIterArgs()[i];
+    if (dead[i]) {
+      iterArg.replaceAllUsesWith(forOp.getIterOperands()[i]);
+      continue;
+    }
+    iterArg.replaceAllUsesWith(newForOp.getRegionIterArgs()[newIdx]);
+    forOp.getResult(i).replaceAllUsesWith(newForOp.getResult(newIdx));
+    ++newIdx;
+  }
+  builder.setInsertionPointToEnd(newBody);
+  builder.create<scf::YieldOp>(yieldOp.getLoc(), yieldOperands);
+  yieldOp.erase();
+  forOp.erase();
+  return newForOp;
+}
+
+} // anonymous namespace
+
+LogicalResult WarpSpecializer::initialize() {
+  if (!funcOp.getBody().hasOneBlock())
+    return failure();
+  Block *entry = &funcOp.getBody().front();
+  auto returnOp = dyn_cast<mlir::ReturnOp>(entry->getTerminator());
+  if (!returnOp || returnOp.getNumOperands() != 0)
+    return failure();
+
+  scf::ForOp forOp = getPipelinedLoop(entry);
+  if (!forOp || !forOp.getInductionVar().getType().isIndex())
+    return failure();
+  if (!getAsyncWait(entry, forOp) || !getAsyncWait(forOp.getBody()))
+    return failure();
+
+  // Both warp groups run the ops up to the end of the loop, so writes there
+  // other than the copies would be duplicated. The producer drops the ones
+  // after the loop.
+  bool hasOtherWrites = false;
+  for (Operation &entryOp : *entry) {
+    entryOp.walk([&](Operation *op) {
+      if (isa<ttg::InsertSliceAsyncOp, ttg::AsyncCommitGroupOp,
+              ttg::AsyncWaitOp>(op))
+        return;
+      auto memEffects = dyn_cast<MemoryEffectOpInterface>(op);
+      if (memEffects && memEffects.hasEffect<MemoryEffects::Write>())
+        hasOtherWrites = true;
+    });
+    if (&entryOp == forOp.getOperation())
+      break;
+  }
+  if (hasOtherWrites)
+    return failure();
+
+  // All the stage buffers have the same number of stages
+  forOp.getBody()->walk([&](ttg::InsertSliceAsyncOp insertOp) {
+    auto dstTy = insertOp.dst().getType().cast<RankedTensorType>();
+    if (numStages == 0 || numStages == dstTy.getShape()[0])
+      numStages = dstTy.getShape()[0];
+    else
+      numStages = -1;
+  });
+  if (numStages < 2 || numStages > kMaxNumStages)
+    return failure();
+
+  numThreads = 2 * ttg::TritonGPUDialect::getNumWarps(mod) *
+               ttg::TritonGPUDialect::getThreadsPerWarp(mod);
+  return success();
+}
+
+Value WarpSpecializer::getStageBarrier(OpBuilder &builder, Location loc,
+                                       Value iteration, int offset, int base) {
+  Value stage = builder.create<arith::AddIOp>(
+      loc, iteration, builder.create<arith::ConstantIndexOp>(loc, offset));
+  stage = builder.create<arith::RemUIOp>(
+      loc, stage, builder.create<arith::ConstantIndexOp>(loc, numStages));
+  Value bar = builder.create<arith::AddIOp>(
+      loc, stage, builder.create<arith::ConstantIndexOp>(loc, base));
+  return builder.create<arith::IndexCastOp>(loc, builder.getI32Type(), bar);
+}
+
+Value WarpSpecializer::getIteration(OpBuilder &builder, Location loc,
+                                    scf::ForOp forOp) {
+  Value offset = builder.create<arith::SubIOp>(loc, forOp.getInductionVar(),
+                                               forOp.getLowerBound());
+  return builder.create<arith::DivUIOp>(loc, offset, forOp.getStep());
+}
+
+void WarpSpecializer::specializeProducer(Block *block) {
+  scf::ForOp forOp = getPipelinedLoop(block);
+  Location loc = forOp.getLoc();
+  OpBuilder builder(forOp);
+
+  // The epilogue belongs to the consumer, but outstanding copies still have
+  // to complete
+  for (Operation &op : llvm::make_early_inc_range(llvm::reverse(*block))) {
+    if (&op == forOp.getOperation())
+      break;
+    if (!isa<scf::YieldOp, ttg::AsyncWaitOp>(op)) {
+      op.dropAllUses();
+      op.erase();
+    }
+  }
+
+  // The consumer does the math
+  forOp.getBody()->walk([&](triton::DotOp dotOp) {
+    dotOp.replaceAllUsesWith(dotOp.c());
+    dotOp.erase();
+  });
+
+  // Stage 0 has landed
+  ttg::AsyncWaitOp prologueWait = getAsyncWait(block, forOp);
+  builder.setInsertionPointAfter(prologueWait);
+  arrive(builder, loc,
+         builder.create<arith::ConstantIntOp>(loc, kFullBarrierBase, 32));
+
+  // Wait for the consumer to release the stage before overwriting it, and
+  // signal the stage of the next iteration once it has landed
+  Block *body = forOp.getBody();
+  builder.setInsertionPointToStart(body);
+  Value iteration = getIteration(builder, loc, forOp);
+  Operation *firstCopy = *body->getOps<ttg::InsertSliceAsyncOp>().begin();
+  builder.setInsertionPoint(firstCopy);
+  wait(builder, loc,
+       getStageBarrier(builder, loc, iteration, numStages - 1,
+                       getEmptyBarrierBase()));
+  ttg::AsyncWaitOp loopWait = getAsyncWait(body);
+  builder.setInsertionPointAfter(loopWait);
+  arrive(builder, loc,
+         getStageBarrier(builder, loc, iteration, 1, kFullBarrierBase));
+
+  // Consume the release of the last iteration
+  builder.setInsertionPointAfter(forOp);
+  Value zero = builder.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = builder.create<arith::ConstantIndexOp>(loc, 1);
+  Value range = builder.create<arith::SubIOp>(loc, forOp.getUpperBound(),
+                                              forOp.getLowerBound());
+  Value numIterations = builder.create<arith::DivUIOp>(
+      loc,
+      builder.create<arith::SubIOp>(
+          loc, builder.create<arith::AddIOp>(loc, range, forOp.getStep()),
+          one),
+      forOp.getStep());
+  Value isEmpty = builder.create<arith::CmpIOp>(
+      loc, arith::CmpIPredicate::sle, forOp.getUpperBound(),
+      forOp.getLowerBound());
+  numIterations =
+      builder.create<arith::SelectOp>(loc, isEmpty, zero, numIterations);
+  wait(builder, loc,
+       getStageBarrier(builder, loc, numIterations, numStages - 1,
+                       getEmptyBarrierBase()));
+
+  eraseDeadOps(block);
+  eraseDeadIterArgs(getPipelinedLoop(block));
+  eraseDeadOps(block);
+}
+
+void WarpSpecializer::specializeConsumer(Block *block) {
+  scf::ForOp forOp = getPipelinedLoop(block);
+  Location loc = forOp.getLoc();
+  OpBuilder builder(forOp);
+  ttg::AsyncWaitOp prologueWait = getAsyncWait(block, forOp);
+  ttg::AsyncWaitOp loopWait = getAsyncWait(forOp.getBody());
+
+  // The stages are written by the producer: reads go to the buffers directly
+  block->walk([&](ttg::InsertSliceAsyncOp insertOp) {
+    insertOp.replaceAllUsesWith(insertOp.dst());
+    insertOp.erase();
+  });
+  block->walk([&](ttg::AsyncCommitGroupOp commitOp) { commitOp.erase(); });
+
+  // The first stage that the producer waits for is released upfront, then
+  // wait for stage 0
+  builder.setInsertionPoint(prologueWait);
+  arrive(builder, loc,
+         builder.create<arith::ConstantIntOp>(
+             loc, getEmptyBarrierBase() + numStages - 1, 32));
+  wait(builder, loc,
+       builder.create<arith::ConstantIntOp>(loc, kFullBarrierBase, 32));
+
+  // Release the stage of the iteration, and wait for the next one
+  Block *body = forOp.getBody();
+  builder.setInsertionPointToStart(body);
+  Value iteration = getIteration(builder, loc, forOp);
+  builder.setInsertionPoint(loopWait);
+  arrive(builder, loc,
+         getStageBarrier(builder, loc, iteration, 0, getEmptyBarrierBase()));
+  wait(builder, loc,
+       getStageBarrier(builder, loc, iteration, 1, kFullBarrierBase));
+
+  block->walk([&](ttg::AsyncWaitOp waitOp) { waitOp.erase(); });
+
+  eraseDeadOps(block);
+  eraseDeadIterArgs(getPipelinedLoop(block));
+  eraseDeadOps(block);
+}
+
+void WarpSpecializer::run() {
+  Block *entry = &funcOp.getBody().front();
+  Operation *returnOp = entry->getTerminator();
+  Location loc = funcOp.getLoc();
+
+  // Stage buffers are shared by both warp groups
+  for (auto allocOp :
+       llvm::make_early_inc_range(entry->getOps<ttg::AllocTensorOp>()))
+    allocOp->moveBefore(entry, entry->begin());
+  auto firstOp = entry->begin();
+  while (isa<ttg::AllocTensorOp>(*firstOp))
+    ++firstOp;
+
+  OpBuilder builder(returnOp);
+  Value groupId =
+      builder.create<ttg::WarpGroupIdOp>(loc, builder.getI32Type());
+  Value isProducer = builder.create<arith::CmpIOp>(
+      loc, arith::CmpIPredicate::eq, groupId,
+      builder.create<arith::ConstantIntOp>(loc, 0, 32));
+  auto ifOp = builder.create<scf::IfOp>(loc, TypeRange{}, isProducer,
+                                        /*withElseRegion=*/true);
+  ifOp->setAttr(ttg::TritonGPUDialect::getWarpSpecializedAttrName(),
+                builder.getUnitAttr());
+
+  // Move the body into the producer, and clone it into the consumer
+  Block *producer = ifOp.thenBlock();
+  Block *consumer = ifOp.elseBlock();
+  producer->getOperations().splice(producer->begin(), entry->getOperations(),
+                                   firstOp,
+                                   groupId.getDefiningOp()->getIterator());
+  BlockAndValueMapping mapping;
+  builder.setInsertionPointToStart(consumer);
+  for (Operation &op : producer->without_terminator())
+    builder.clone(op, mapping);
+
+  specializeProducer(producer);
+  specializeConsumer(consumer);
+
+  mod->setAttr(ttg::TritonGPUDialect::getNumWarpGroupsAttrName(),
+               builder.getI32IntegerAttr(2));
+}
+
+class WarpSpecializePass
+    : public TritonGPUWarpSpecializeBase<WarpSpecializePass> {
+public:
+  WarpSpecializePass() = default;
+
+  void runOnOperation() override {
+    ModuleOp mod = getOperation();
+    if (ttg::TritonGPUDialect::getNumWarpGroups(mod) != 1)
+      return;
+    // All the functions of the module would see the warp groups
+    auto funcOps = llvm::to_vector(mod.getOps<mlir::FuncOp>());
+    if (funcOps.size() != 1)
+      return;
+    WarpSpecializer specializer(mod, funcOps[0]);
+    if (specializer.initialize().failed())
+      return;
+    specializer.run();
+  }
+};
+
+std::unique_ptr<Pass> mlir::createTritonGPUWarpSpecializePass() {
+  return std::make_unique<WarpSpecializePass>();
+}
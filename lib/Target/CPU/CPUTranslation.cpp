@@ -0,0 +1,113 @@
+#include "triton/Target/CPU/CPUTranslation.h"
+#include "triton/Conversion/TritonGPUToCPU/TritonGPUToCPUPass.h"
+#include "triton/Target/LLVMIR/LLVMIRTranslation.h"
+#include "triton/Tools/Sys/GetEnv.hpp"
+#include "triton/Tools/Sys/Timing.hpp"
+
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
+
+namespace triton {
+
+static void initLLVM() {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+}
+
+std::unique_ptr<llvm::Module>
+translateTritonGPUToCPULLVMIR(llvm::LLVMContext *llvmContext,
+                              mlir::ModuleOp module) {
+  mlir::PassManager pm(module->getContext());
+  mlir::applyPassManagerCLOptions(pm);
+  if (::triton::tools::CompileTimer::get().isEnabled())
+    pm.addInstrumentation(
+        std::make_unique<::triton::tools::PassTimingInstrumentation>());
+
+  pm.addPass(mlir::triton::createConvertTritonGPUToCPUPass());
+  // Canonicalize to eliminate the remaining UnrealizedConversionCastOp
+  pm.addPass(mlir::createCanonicalizerPass());
+  pm.addPass(mlir::createCSEPass());
+  pm.addPass(mlir::createSymbolDCEPass());
+  pm.addPass(mlir::createCanonicalizerPass());
+
+  if (failed(pm.run(module))) {
+    llvm::errs() << "Pass execution failed";
+    return nullptr;
+  }
+
+  auto llvmIR = mlir::triton::translateLLVMToLLVMIR(llvmContext, module);
+  if (!llvmIR) {
+    llvm::errs() << "Translate to LLVM IR failed";
+    return nullptr;
+  }
+  return llvmIR;
+}
+
+std::string getHostCPUName() { return llvm::sys::getHostCPUName().str(); }
+
+std::string translateLLVMIRToCPUObject(llvm::Module &module) {
+  initLLVM();
+  // verify and store llvm
+  llvm::legacy::PassManager pm;
+  pm.add(llvm::createVerifierPass());
+  pm.run(module);
+
+  // create machine, for the features of the host
+  module.setTargetTriple(llvm::sys::getProcessTriple());
+  std::string proc = getHostCPUName();
+  llvm::SubtargetFeatures features;
+  llvm::StringMap<bool> hostFeatures;
+  if (llvm::sys::getHostCPUFeatures(hostFeatures))
+    for (auto &feature : hostFeatures)
+      features.AddFeature(feature.first(), feature.second);
+  std::string error;
+  auto target =
+      llvm::TargetRegistry::lookupTarget(module.getTargetTriple(), error);
+  if (!target) {
+    llvm::errs() << "Failed to find the target of the host: " << error;
+    return "";
+  }
+  llvm::TargetOptions opt;
+  opt.AllowFPOpFusion = llvm::FPOpFusion::Fast;
+  opt.UnsafeFPMath = false;
+  opt.NoInfsFPMath = false;
+  opt.NoNaNsFPMath = true;
+  std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(
+      module.getTargetTriple(), proc, features.getString(), opt,
+      llvm::Reloc::PIC_, llvm::None, llvm::CodeGenOpt::Aggressive));
+  module.setDataLayout(machine->createDataLayout());
+
+  // The module was optimized without a target: optimize it again now that
+  // the width of the vector registers is known
+  auto optPipeline = mlir::makeOptimizingTransformer(
+      /*optLevel=*/3, /*sizeLevel=*/0, /*targetMachine=*/machine.get());
+  if (auto err = optPipeline(&module)) {
+    llvm::errs() << "Failed to optimize LLVM IR " << err << "\n";
+    return "";
+  }
+
+  // emit machine code
+  llvm::SmallVector<char, 0> buffer;
+  llvm::legacy::PassManager pass;
+  llvm::raw_svector_ostream stream(buffer);
+  machine->addPassesToEmitFile(pass, stream, nullptr,
+                               llvm::CodeGenFileType::CGFT_ObjectFile);
+  {
+    ::triton::tools::CompileTimer::Scope timer("llvm/codegen");
+    pass.run(module);
+  }
+  return std::string(buffer.begin(), buffer.end());
+}
+
+} // namespace triton
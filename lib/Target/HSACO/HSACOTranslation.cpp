@@ -12,6 +12,7 @@
 #include "mlir/Target/LLVMIR/LLVMTranslationInterface.h"
 #include "triton/Target/LLVMIR/LLVMIRTranslation.h"
 #include "triton/Tools/Sys/GetEnv.hpp"
+#include "triton/Tools/Sys/Timing.hpp"
 
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
@@ -23,6 +24,10 @@
 #include "llvm/MC/TargetRegistry.h"
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
@@ -30,8 +35,10 @@
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#ifdef TRITON_USE_LLD
+#include "lld/Common/Driver.h"
+#endif
 #include <regex>
-#include <cstdio>
 #include <iostream>
 #include <memory>
 
@@ -45,6 +52,41 @@ void init_llvm() {
   LLVMInitializeAMDGPUAsmPrinter();
 }
 
+// gfx90a and later have global_atomic_add_f32 and global_atomic_pk_add_f16
+// with return, which LLVM only selects with amdgpu-unsafe-fp-atomics as they
+// are no-ops on fine-grained host memory
+bool has_fp_atomics(const std::string& proc) {
+  return proc == "gfx90a" || proc.rfind("gfx94", 0) == 0;
+}
+
+// Splits the packed f16 atomic fadds into scalar atomics, which LLVM expands
+// into compare-and-swap loops
+void expand_packed_atomic_fadd(llvm::Module* module) {
+  llvm::SmallVector<llvm::CallInst*> calls;
+  for (llvm::Function &f : module->functions())
+    if (f.getName().startswith("llvm.amdgcn.global.atomic.fadd.v2f16"))
+      for (llvm::User *user : f.users())
+        if (auto *call = llvm::dyn_cast<llvm::CallInst>(user))
+          calls.push_back(call);
+  for (llvm::CallInst *call : calls) {
+    llvm::IRBuilder<> builder(call);
+    llvm::Value *vec = call->getArgOperand(1);
+    auto *halfTy = llvm::cast<llvm::VectorType>(vec->getType())->getElementType();
+    llvm::Value *ptr = builder.CreateBitCast(
+        call->getArgOperand(0), halfTy->getPointerTo(/*AddrSpace=*/1));
+    llvm::Value *res = llvm::UndefValue::get(vec->getType());
+    for (unsigned i = 0; i < 2; ++i) {
+      llvm::Value *old = builder.CreateAtomicRMW(
+          llvm::AtomicRMWInst::FAdd, builder.CreateConstGEP1_32(halfTy, ptr, i),
+          builder.CreateExtractElement(vec, i), llvm::MaybeAlign(2),
+          llvm::AtomicOrdering::Monotonic);
+      res = builder.CreateInsertElement(res, old, i);
+    }
+    call->replaceAllUsesWith(res);
+    call->eraseFromParent();
+  }
+}
+
 std::unique_ptr<llvm::TargetMachine> initialize_module(llvm::Module* module,
                                                        const std::string& triple,
                                                        const std::string& proc,
@@ -70,8 +112,14 @@ std::unique_ptr<llvm::TargetMachine> initialize_module(llvm::Module* module,
 
   module->setDataLayout(machine->createDataLayout());
 
-  for (llvm::Function &f : module->functions())
+  bool fp_atomics = has_fp_atomics(proc);
+  if (!fp_atomics)
+    expand_packed_atomic_fadd(module);
+  for (llvm::Function &f : module->functions()) {
     f.addFnAttr(llvm::Attribute::AlwaysInline);
+    if (fp_atomics && !f.isDeclaration())
+      f.addFnAttr("amdgpu-unsafe-fp-atomics", "true");
+  }
 
   return std::unique_ptr<llvm::TargetMachine>(machine);
 }
@@ -89,7 +137,10 @@ std::string generate_amdgcn_assembly(llvm::Module* module,
   // emit
   machine->addPassesToEmitFile(pass, stream, nullptr,
                                llvm::CodeGenFileType::CGFT_AssemblyFile);
-  pass.run(*module);
+  {
+    ::triton::tools::CompileTimer::Scope timer("llvm/codegen");
+    pass.run(*module);
+  }
 
   std::string amdgcn(buffer.begin(), buffer.end());
   if (::triton::tools::getBoolEnv("AMDGCN_ENABLE_DUMP")) {
@@ -105,39 +156,63 @@ std::string generate_hsaco(llvm::Module* module,
                            const std::string& features) {
   auto machine = initialize_module(module, triple, proc, features);
 
-  std::string kernel_name = std::string(std::tmpnam(nullptr)) + "_" + module->getModuleIdentifier();
-
-  // create dump files
-  std::error_code ec;
-  // Save GCN ISA binary.
-  std::string isabin_path = kernel_name + std::string(".o");
-  std::unique_ptr<llvm::raw_fd_ostream> isabin_fs(
-      new llvm::raw_fd_ostream(isabin_path, ec, llvm::sys::fs::OF_Text));
-  if (ec)
+  // emit the relocatable GCN ISA object in memory
+  llvm::SmallVector<char, 0> isabin;
   {
-    std::cout << isabin_path << " was not created. error code: " << ec << std::endl;
+    llvm::raw_svector_ostream stream(isabin);
+    llvm::legacy::PassManager pass;
+    machine->addPassesToEmitFile(pass, stream, nullptr, llvm::CGFT_ObjectFile);
+    ::triton::tools::CompileTimer::Scope timer("llvm/codegen-object");
+    pass.run(*module);
   }
-  // emit
-  llvm::legacy::PassManager pass;
-  machine->addPassesToEmitFile(pass, *isabin_fs, nullptr, llvm::CGFT_ObjectFile);
-  pass.run(*module);
-
-  // generate HASCO file
-  std::string hsaco_path = kernel_name + std::string(".hsaco");
 
-  std::string error_message;
-  int lld_result =
-      llvm::sys::ExecuteAndWait("/opt/rocm/llvm/bin/ld.lld",
-                                {"/opt/rocm/llvm/bin/ld.lld", "-flavor", "gnu", "-shared", "-o", hsaco_path, isabin_path},
-                                llvm::None, {}, 0, 0, &error_message);
-  if (lld_result)
+  // link it into a code object; lld only reads and writes files, which live
+  // in a private scratch directory for the duration of the link
+  llvm::SmallString<64> scratch_dir;
+  if (llvm::sys::fs::createUniqueDirectory("triton-hsaco", scratch_dir)) {
+    llvm::errs() << "failed to create a scratch directory for ld.lld\n";
+    return "";
+  }
+  llvm::SmallString<64> isabin_path(scratch_dir);
+  llvm::sys::path::append(isabin_path, "kernel.o");
+  llvm::SmallString<64> hsaco_path(scratch_dir);
+  llvm::sys::path::append(hsaco_path, "kernel.hsaco");
   {
-    std::cout << "ld.lld execute fail: " << std::endl;
-    std::cout << error_message << std::endl;
-    std::cout << lld_result << std::endl;
+    std::error_code ec;
+    llvm::raw_fd_ostream isabin_fs(isabin_path, ec, llvm::sys::fs::OF_None);
+    if (!ec)
+      isabin_fs << llvm::StringRef(isabin.data(), isabin.size());
   }
 
-  return hsaco_path;
+  std::string error_message;
+  ::triton::tools::CompileTimer::Scope timer("tool/ld.lld");
+#ifdef TRITON_USE_LLD
+  llvm::raw_string_ostream error_stream(error_message);
+  bool linked = lld::elf::link(
+      {"ld.lld", "-shared", isabin_path.c_str(), "-o", hsaco_path.c_str()},
+      llvm::nulls(), error_stream, /*exitEarly=*/false,
+      /*disableOutput=*/false);
+  error_stream.flush();
+#else
+  bool linked = !llvm::sys::ExecuteAndWait(
+      "/opt/rocm/llvm/bin/ld.lld",
+      {"/opt/rocm/llvm/bin/ld.lld", "-flavor", "gnu", "-shared", "-o",
+       hsaco_path, isabin_path},
+      llvm::None, {}, 0, 0, &error_message);
+#endif
+
+  std::string hsaco;
+  if (linked) {
+    auto buffer = llvm::MemoryBuffer::getFile(hsaco_path);
+    if (buffer)
+      hsaco = (*buffer)->getBuffer().str();
+  } else {
+    llvm::errs() << "ld.lld failed: " << error_message << "\n";
+  }
+  llvm::sys::fs::remove(isabin_path);
+  llvm::sys::fs::remove(hsaco_path);
+  llvm::sys::fs::remove(scratch_dir);
+  return hsaco;
 }
 
 std::tuple<std::string, std::string> llir_to_amdgcn_and_hsaco(llvm::Module* module,
@@ -152,9 +227,9 @@ std::tuple<std::string, std::string> llir_to_amdgcn_and_hsaco(llvm::Module* modu
   // verify and store llvm
   auto module_obj = llvm::CloneModule(*module);
   auto amdgcn = generate_amdgcn_assembly(module, triple, proc, features);
-  auto hsaco_path = generate_hsaco(module_obj.get(), triple, proc, features);
+  auto hsaco = generate_hsaco(module_obj.get(), triple, proc, features);
 
-  return std::make_tuple(amdgcn, hsaco_path);
+  return std::make_tuple(amdgcn, hsaco);
 }
 
 }
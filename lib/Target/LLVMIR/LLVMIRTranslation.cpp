@@ -15,14 +15,20 @@
 #include "mlir/Transforms/Passes.h"
 #include "triton/Conversion/TritonGPUToLLVM/TritonGPUToLLVMPass.h"
 #include "triton/Tools/Sys/GetEnv.hpp"
+#include "triton/Tools/Sys/Timing.hpp"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/IR/CallingConv.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 
 #include <iostream>
 #include <filesystem>
+#include <mutex>
 
 namespace mlir {
 namespace triton {
@@ -31,7 +37,13 @@ namespace triton {
 // information from mlir module.
 struct NVVMMetadata {
   int maxntidx{-1};
+  // launch bounds, unset if 0
+  int maxnreg{};
+  int minctasm{};
+  int wavesPerEU{};
   bool isKernel{};
+  // pointer arguments never written through
+  SmallVector<unsigned> readOnlyArgs;
   // Free to extend with other information.
 };
 
@@ -40,17 +52,26 @@ static void amendLLVMFunc(llvm::Function *func, const NVVMMetadata &metadata) {
   auto *module = func->getParent();
   auto &ctx = func->getContext();
 
-  if (metadata.maxntidx > 0) {
-    auto warps = llvm::ConstantInt::get(llvm::IntegerType::get(ctx, 32),
-                                        llvm::APInt(32, metadata.maxntidx));
+#ifndef USE_ROCM
+  auto annotate = [&](llvm::StringRef key, int value) {
+    auto constant = llvm::ConstantInt::get(llvm::IntegerType::get(ctx, 32),
+                                           llvm::APInt(32, value));
 
     llvm::Metadata *md_args[] = {llvm::ValueAsMetadata::get(func),
-                                 llvm::MDString::get(ctx, "maxntidx"),
-                                 llvm::ValueAsMetadata::get(warps)};
+                                 llvm::MDString::get(ctx, key),
+                                 llvm::ValueAsMetadata::get(constant)};
 
     module->getOrInsertNamedMetadata("nvvm.annotations")
         ->addOperand(llvm::MDNode::get(ctx, md_args));
-  }
+  };
+  if (metadata.maxntidx > 0)
+    annotate("maxntidx", metadata.maxntidx);
+  // emitted as the .maxnreg and .minnctapersm directives of the PTX kernel
+  if (metadata.maxnreg > 0)
+    annotate("maxnreg", metadata.maxnreg);
+  if (metadata.minctasm > 0)
+    annotate("minctasm", metadata.minctasm);
+#endif
 
   if (metadata.isKernel) {
 #ifndef USE_ROCM
@@ -62,7 +83,15 @@ static void amendLLVMFunc(llvm::Function *func, const NVVMMetadata &metadata) {
         ->addOperand(llvm::MDNode::get(ctx, mdargs));
 #else // AMDGCN
     func->setCallingConv(llvm::CallingConv::AMDGPU_KERNEL);
-    func->addFnAttr("amdgpu-flat-work-group-size", "1, 1024");
+    // The kernel is launched with exactly maxntidx threads
+    int maxntidx = metadata.maxntidx > 0 ? metadata.maxntidx : 1024;
+    func->addFnAttr("amdgpu-flat-work-group-size",
+                    "1, " + std::to_string(maxntidx));
+    if (metadata.wavesPerEU > 0)
+      func->addFnAttr("amdgpu-waves-per-eu",
+                      std::to_string(metadata.wavesPerEU));
+    if (metadata.maxnreg > 0)
+      func->addFnAttr("amdgpu-num-vgpr", std::to_string(metadata.maxnreg));
 #endif
   }
 }
@@ -82,6 +111,23 @@ extractNVVMMetadata(mlir::ModuleOp module,
       hasMetadata = true;
     }
 
+    // launch bounds
+    auto readBound = [&](StringRef name, int &bound) {
+      if (auto attr = op->getAttrOfType<IntegerAttr>(name)) {
+        bound = attr.getInt();
+        hasMetadata = true;
+      }
+    };
+    readBound("nvvm.maxnreg", meta.maxnreg);
+    readBound("nvvm.minctasm", meta.minctasm);
+    readBound("rocdl.waves_per_eu", meta.wavesPerEU);
+
+    for (unsigned i = 0; i < op.getNumArguments(); ++i)
+      if (op.getArgAttr(i, "llvm.readonly")) {
+        meta.readOnlyArgs.push_back(i);
+        hasMetadata = true;
+      }
+
     // kernel
     if (op->hasAttr("nvvm.kernel")) {
       meta.isKernel = true;
@@ -161,17 +207,109 @@ static void linkLibdevice(llvm::Module &module) {
   module.addModuleFlag(reflect);
 }
 
+// Replaces the declarations of the libdevice and ocml functions that are
+// equivalent to an LLVM intrinsic by the intrinsic, which the backends lower
+// inline, so that their libraries need not be linked.
+static void resolveExternsToIntrinsics(llvm::Module &module) {
+  SmallVector<llvm::Function *> resolved;
+  for (llvm::Function &func : module.functions()) {
+    if (!func.isDeclaration() || func.isIntrinsic())
+      continue;
+    llvm::StringRef name = func.getName();
+    llvm::StringRef base;
+    if (name.consume_front("__nv_"))
+      // The f32 functions of libdevice have a f suffix
+      base = name.endswith("f") && !func.getReturnType()->isDoubleTy()
+                 ? name.drop_back()
+                 : name;
+    else if (name.consume_front("__ocml_"))
+      base = name.rsplit('_').first;
+    else
+      continue;
+    // The intrinsic and its number of arguments
+    std::pair<llvm::Intrinsic::ID, unsigned> intrinsic =
+        llvm::StringSwitch<std::pair<llvm::Intrinsic::ID, unsigned>>(base)
+            .Case("fabs", {llvm::Intrinsic::fabs, 1})
+            .Case("floor", {llvm::Intrinsic::floor, 1})
+            .Case("ceil", {llvm::Intrinsic::ceil, 1})
+            .Case("trunc", {llvm::Intrinsic::trunc, 1})
+            .Case("rint", {llvm::Intrinsic::rint, 1})
+            .Case("nearbyint", {llvm::Intrinsic::nearbyint, 1})
+            .Case("fmin", {llvm::Intrinsic::minnum, 2})
+            .Case("fmax", {llvm::Intrinsic::maxnum, 2})
+            .Case("copysign", {llvm::Intrinsic::copysign, 2})
+            .Case("fma", {llvm::Intrinsic::fma, 3})
+            .Default({llvm::Intrinsic::not_intrinsic, 0});
+    // The intrinsics take and return values of the same floating-point type
+    llvm::Type *type = func.getReturnType();
+    if (intrinsic.first == llvm::Intrinsic::not_intrinsic ||
+        !type->isFloatingPointTy() || func.arg_size() != intrinsic.second ||
+        llvm::any_of(func.args(), [&](llvm::Argument &arg) {
+          return arg.getType() != type;
+        }))
+      continue;
+    func.replaceAllUsesWith(
+        llvm::Intrinsic::getDeclaration(&module, intrinsic.first, {type}));
+    resolved.push_back(&func);
+  }
+  for (llvm::Function *func : resolved)
+    func->eraseFromParent();
+}
+
+// The contents of the external libraries, read once per process. The modules
+// are loaded lazily from them, so that only the functions used by the kernel
+// are parsed when linking.
+static llvm::MemoryBufferRef getExternLibBuffer(llvm::StringRef path) {
+  static std::mutex mutex;
+  static llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> buffers;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &buffer = buffers[path];
+  if (!buffer) {
+    auto file = llvm::MemoryBuffer::getFile(path);
+    if (!file)
+      return {};
+    buffer = std::move(*file);
+  }
+  return buffer->getMemBufferRef();
+}
+
 static bool linkExternLib(llvm::Module &module, llvm::StringRef name,
                           llvm::StringRef path) {
   llvm::SMDiagnostic err;
   auto &ctx = module.getContext();
 
-  auto extMod = llvm::parseIRFile(path, err, ctx);
+  llvm::MemoryBufferRef buffer = getExternLibBuffer(path);
+  std::unique_ptr<llvm::Module> extMod;
+  if (!buffer.getBufferStart()) {
+    // Not found, reported below
+  } else if (llvm::isBitcode(
+                 reinterpret_cast<const unsigned char *>(
+                     buffer.getBufferStart()),
+                 reinterpret_cast<const unsigned char *>(
+                     buffer.getBufferEnd()))) {
+    auto lazyMod = llvm::getLazyBitcodeModule(buffer, ctx);
+    if (lazyMod)
+      extMod = std::move(*lazyMod);
+    else
+      llvm::consumeError(lazyMod.takeError());
+  } else {
+    extMod = llvm::parseIR(buffer, err, ctx);
+  }
   if (!extMod) {
     llvm::errs() << "Failed to load " << path;
     return true;
   }
 
+  // Skip the libraries defining none of the functions used by the kernel
+  bool needed = llvm::any_of(module.functions(), [&](llvm::Function &func) {
+    if (!func.isDeclaration() || func.isIntrinsic())
+      return false;
+    llvm::Function *def = extMod->getFunction(func.getName());
+    return def && !def->isDeclaration();
+  });
+  if (!needed)
+    return false;
+
   extMod->setTargetTriple(module.getTargetTriple());
   extMod->setDataLayout(module.getDataLayout());
 
@@ -203,12 +341,26 @@ translateLLVMToLLVMIR(llvm::LLVMContext *llvmContext, mlir::ModuleOp module) {
   llvm::DenseMap<llvm::StringRef, NVVMMetadata> nvvmMetadata;
   extractNVVMMetadata(module, &nvvmMetadata);
 
-  auto llvmModule = mlir::translateModuleToLLVMIR(module, *llvmContext);
+  std::unique_ptr<llvm::Module> llvmModule;
+  {
+    ::triton::tools::CompileTimer::Scope timer("llvm/translate");
+    llvmModule = mlir::translateModuleToLLVMIR(module, *llvmContext);
+  }
   if (!llvmModule) {
     llvm::errs() << "Failed to emit LLVM IR\n";
     return nullptr;
   }
 
+  // The translation has no read-only argument attribute: it is added before
+  // the module is optimized
+  for (auto &func : llvmModule->functions()) {
+    auto it = nvvmMetadata.find(func.getName());
+    if (it == nvvmMetadata.end())
+      continue;
+    for (unsigned i : it->second.readOnlyArgs)
+      func.addParamAttr(i, llvm::Attribute::ReadOnly);
+  }
+
   // Link external libraries before perform optimizations
   // Note from libdevice users guide:
   // https://docs.nvidia.com/cuda/libdevice-users-guide/basic-usage.html
@@ -217,8 +369,15 @@ translateLLVMToLLVMIR(llvm::LLVMContext *llvmContext, mlir::ModuleOp module) {
   // generation passes. This allows the optimizers to inline and perform
   // analyses on the used library functions, and eliminate any used functions as
   // dead code.
-  auto externLibs = getExternLibs(module);
+  resolveExternsToIntrinsics(*llvmModule);
+  bool hasExterns =
+      llvm::any_of(llvmModule->functions(), [](llvm::Function &func) {
+        return func.isDeclaration() && !func.isIntrinsic();
+      });
+  auto externLibs = hasExterns ? getExternLibs(module)
+                               : std::map<std::string, std::string>();
   for (auto &lib : externLibs) {
+    ::triton::tools::CompileTimer::Scope timer("llvm/link-" + lib.first);
     if (linkExternLib(*llvmModule, lib.first, lib.second))
       return nullptr;
   }
@@ -227,7 +386,11 @@ translateLLVMToLLVMIR(llvm::LLVMContext *llvmContext, mlir::ModuleOp module) {
       /*optLevel=*/3, /*sizeLevel=*/0,
       /*targetMachine=*/nullptr);
 
-  if (auto err = optPipeline(llvmModule.get())) {
+  auto err = [&]() {
+    ::triton::tools::CompileTimer::Scope timer("llvm/O3");
+    return optPipeline(llvmModule.get());
+  }();
+  if (err) {
     llvm::errs() << "Failed to optimize LLVM IR " << err << "\n";
     return nullptr;
   }
@@ -243,7 +406,8 @@ translateLLVMToLLVMIR(llvm::LLVMContext *llvmContext, mlir::ModuleOp module) {
 
 std::unique_ptr<llvm::Module>
 translateTritonGPUToLLVMIR(llvm::LLVMContext *llvmContext,
-                           mlir::ModuleOp module, int computeCapability) {
+                           mlir::ModuleOp module, int computeCapability,
+                           bool fastMath, int ptxVersion) {
   mlir::PassManager pm(module->getContext());
   applyPassManagerCLOptions(pm);
   auto printingFlags = mlir::OpPrintingFlags();
@@ -257,8 +421,12 @@ translateTritonGPUToLLVMIR(llvm::LLVMContext *llvmContext,
       /*printModuleScope=*/false,
       /*printAfterOnlyOnChange=*/true,
       /*printAfterOnlyOnFailure*/ false, llvm::dbgs(), printingFlags);
+  if (::triton::tools::CompileTimer::get().isEnabled())
+    pm.addInstrumentation(
+        std::make_unique<::triton::tools::PassTimingInstrumentation>());
 
-  pm.addPass(createConvertTritonGPUToLLVMPass(computeCapability));
+  pm.addPass(createConvertTritonGPUToLLVMPass(computeCapability, fastMath,
+                                              ptxVersion));
   // Canonicalize to eliminate the remaining UnrealizedConversionCastOp
   pm.addPass(mlir::createCanonicalizerPass());
   pm.addPass(mlir::createCSEPass()); // Simplify the IR to improve readability.
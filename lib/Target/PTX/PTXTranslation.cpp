@@ -1,5 +1,6 @@
 #include "triton/Target/PTX/PTXTranslation.h"
 #include "triton/Target/LLVMIR/LLVMIRTranslation.h"
+#include "triton/Tools/Sys/Timing.hpp"
 
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LegacyPassManager.h"
@@ -30,11 +31,15 @@ static bool findAndReplace(std::string &str, const std::string &begin,
   return true;
 }
 
-std::string translateLLVMIRToPTX(llvm::Module &module, int cc, int version) {
+int getEmittedPTXVersion(int version) {
   // LLVM version in use may not officially support target hardware.
   // Supported versions for LLVM 14 are here:
   // https://github.com/llvm/llvm-project/blob/f28c006a5895fc0e329fe15fead81e37457cb1d1/clang/include/clang/Basic/BuiltinsNVPTX.def
-  int maxPTX = std::min(80, version);
+  return std::min(80, version);
+}
+
+std::string translateLLVMIRToPTX(llvm::Module &module, int cc, int version) {
+  int maxPTX = getEmittedPTXVersion(version);
   int maxCC = std::min(90, cc);
   // options
   auto options = llvm::cl::getRegisteredOptions();
@@ -86,7 +91,10 @@ std::string translateLLVMIRToPTX(llvm::Module &module, int cc, int version) {
   // emit
   machine->addPassesToEmitFile(pass, stream, nullptr,
                                llvm::CodeGenFileType::CGFT_AssemblyFile);
-  pass.run(module);
+  {
+    ::triton::tools::CompileTimer::Scope timer("llvm/codegen");
+    pass.run(module);
+  }
 
   // post-process
   std::string result(buffer.begin(), buffer.end());
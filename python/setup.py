@@ -194,7 +194,6 @@ setup(
     packages=["triton", "triton/_C", "triton/language", "triton/tools", "triton/impl", "triton/ops", "triton/runtime", "triton/ops/blocksparse"],
     install_requires=[
         "cmake",
-        "filelock",
         "torch",
         "lit",
     ],
@@ -13,29 +13,42 @@
 
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "triton/Analysis/Allocation.h"
+#include "triton/Analysis/Utility.h"
 #include "triton/Conversion/TritonGPUToLLVM/TritonGPUToLLVMPass.h"
 #include "triton/Conversion/TritonToTritonGPU/TritonToTritonGPUPass.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/Triton/IR/Types.h"
 #include "triton/Dialect/Triton/Transforms/Passes.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
 #include "triton/Target/LLVMIR/LLVMIRTranslation.h"
+#include "triton/Target/CPU/CPUTranslation.h"
 #include "triton/Target/PTX/PTXTranslation.h"
 #include "triton/Target/HSACO/HSACOTranslation.h"
 #include "triton/Tools/Sys/GetEnv.hpp"
+#include "triton/Tools/Sys/Timing.hpp"
 
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "llvm/Support/SourceMgr.h"
 
+#ifdef TRITON_USE_NVPTX_COMPILER
+#include <nvPTXCompiler.h>
+#endif
+
 #include <Python.h>
 #include <cctype>
+#include <cstdint>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <optional>
 #include <pybind11/buffer_info.h>
 #include <pybind11/functional.h>
@@ -43,6 +56,7 @@
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -55,6 +69,326 @@ enum backend_t {
   ROCM,
 };
 
+/*****************************************************************************/
+/* Kernel dispatch fast path                                                 */
+/*****************************************************************************/
+
+// Launches the CompiledKernel bin as its runner does: grid is a sequence of 1
+// to 3 sizes and args holds the arguments that are not constexprs
+static void launchKernel(py::handle bin, py::handle grid, py::handle stream,
+                         py::handle compiledKernel, py::handle args) {
+  // getting c_wrapper loads the module, which sets cu_function
+  py::object cWrapper = bin.attr("c_wrapper");
+  size_t gridSize = py::len(grid);
+  py::object one = py::int_(1);
+  py::object grid0 = grid[py::int_(0)];
+  py::object grid1 = gridSize > 1 ? py::object(grid[py::int_(1)]) : one;
+  py::object grid2 = gridSize > 2 ? py::object(grid[py::int_(2)]) : one;
+  if (py::bool_(bin.attr("profile_regions")))
+    bin.attr("profile_launch")(grid0, grid1, grid2);
+  if (py::bool_(bin.attr("trace_formats")))
+    bin.attr("trace_launch")();
+  py::list launchArgs;
+  launchArgs.append(grid0);
+  launchArgs.append(grid1);
+  launchArgs.append(grid2);
+  launchArgs.append(bin.attr("num_threads"));
+  launchArgs.append(bin.attr("shared"));
+  launchArgs.append(bin.attr("cooperative"));
+  launchArgs.append(bin.attr("num_ctas"));
+  launchArgs.append(stream);
+  launchArgs.append(bin.attr("cu_function"));
+  launchArgs.append(compiledKernel.attr("launch_enter_hook"));
+  launchArgs.append(compiledKernel.attr("launch_exit_hook"));
+  launchArgs.append(bin);
+  for (py::handle arg : args)
+    launchArgs.append(arg);
+  cWrapper(*py::tuple(launchArgs));
+}
+
+// Launches the (kernel, grid, args) triples of launches in order on stream
+static void launchMany(py::iterable launches, py::object stream,
+                       py::object compiledKernel) {
+  for (py::handle launch : launches) {
+    auto item = launch.cast<py::sequence>();
+    if (item.size() != 3)
+      throw py::value_error("a launch is a (kernel, grid, args) triple");
+    py::object kernel = item[0];
+    py::object grid = item[1];
+    py::object args = item[2];
+    launchKernel(kernel, grid, stream, compiledKernel, args);
+  }
+}
+
+// Mirrors the launcher generated by JITFunction._make_launcher for cache
+// hits: the cache key is built and the cached kernel is launched without
+// running any Python code but the data_ptr/dtype accessors of the arguments.
+// Calls that may require a compilation or use non-default compilation options
+// are forwarded to the Python launcher, which fills the same cache.
+class KernelDispatcher {
+public:
+  KernelDispatcher(py::object fn, py::object pyLauncher, py::object versionKey,
+                   py::object getStream, py::object getDevice,
+                   py::object compiledKernel, py::object gridType)
+      : pyLauncher(pyLauncher), versionKey(versionKey), getStream(getStream),
+        getDevice(getDevice), compiledKernel(compiledKernel),
+        gridType(gridType) {
+    cache = fn.attr("cache");
+    for (py::handle name : fn.attr("arg_names"))
+      argNames.push_back(name.cast<std::string>());
+    isConstexpr.resize(argNames.size(), false);
+    for (py::handle idx : fn.attr("constexprs"))
+      isConstexpr[idx.cast<size_t>()] = true;
+    // the Python launcher checks the indices of do_not_specialize against
+    // the indices of the non-constexpr arguments
+    for (py::handle idx : fn.attr("do_not_specialize"))
+      doNotSpecialize.insert(idx.cast<size_t>());
+    versionAlignment = fn.attr("version_alignment").cast<bool>();
+    divisibility = fn.attr("divisibility").cast<unsigned long long>();
+    // "pow2" buckets are stored as 0
+    for (auto item : fn.attr("constexpr_buckets").cast<py::dict>())
+      constexprBuckets[item.first.cast<size_t>()] =
+          py::isinstance<py::str>(item.second)
+              ? 0
+              : item.second.cast<unsigned long long>();
+    for (auto item : fn.attr("divisibility_buckets").cast<py::dict>())
+      divisibilityBuckets[item.first.cast<size_t>()] =
+          item.second.cast<unsigned long long>();
+  }
+
+  py::object operator()(py::args args, py::kwargs kwargs) {
+    auto fallback = [&]() { return pyLauncher(*args, **kwargs); };
+
+    // bind arguments
+    size_t numArgs = argNames.size();
+    if (args.size() > numArgs)
+      return fallback();
+    std::vector<py::handle> boundArgs(numArgs);
+    for (size_t i = 0; i < args.size(); ++i)
+      boundArgs[i] = args[i];
+    py::handle grid;
+    py::handle stream;
+    for (auto item : kwargs) {
+      std::string name = py::str(item.first);
+      py::handle value = item.second;
+      if (name == "grid") {
+        grid = value;
+      } else if (name == "stream") {
+        stream = value;
+      } else if (name == "num_warps") {
+        if (!PyLong_Check(value.ptr()))
+          return fallback();
+        long numWarps = PyLong_AsLong(value.ptr());
+        if (numWarps <= 0 || (numWarps & (numWarps - 1)) != 0)
+          return fallback();
+      } else if (name == "num_stages") {
+        continue;
+      } else if (name == "warp_specialize" || name == "warmup") {
+        if (PyObject_IsTrue(value.ptr()) != 0)
+          return fallback();
+      } else if (name == "prefetch_width" || name == "extern_libs") {
+        if (!value.is_none())
+          return fallback();
+      } else {
+        auto it = std::find(argNames.begin(), argNames.end(), name);
+        if (it == argNames.end() || boundArgs[it - argNames.begin()])
+          return fallback();
+        boundArgs[it - argNames.begin()] = value;
+      }
+    }
+    if (!grid || llvm::any_of(boundArgs, [](py::handle h) { return !h; }))
+      return fallback();
+
+    // key = (version_key, sig_key, constexpr_key, spec_key)
+    py::list sigKey;
+    py::list constexprKey;
+    py::list specKey;
+    py::list regularArgs;
+    for (size_t i = 0, regularIdx = 0; i < numArgs; ++i) {
+      py::handle arg = boundArgs[i];
+      if (isConstexpr[i]) {
+        auto bucket = constexprBuckets.find(i);
+        if (bucket == constexprBuckets.end()) {
+          constexprKey.append(arg);
+          continue;
+        }
+        py::object value = getBucket(arg, bucket->second);
+        if (!value)
+          return fallback();
+        constexprKey.append(value);
+        continue;
+      }
+      regularArgs.append(arg);
+      py::object typeKey = getTypeKey(arg);
+      if (!typeKey)
+        return fallback();
+      sigKey.append(typeKey);
+      if (!doNotSpecialize.count(regularIdx++)) {
+        auto bucket = divisibilityBuckets.find(i);
+        py::object spec = bucket == divisibilityBuckets.end()
+                              ? getSpecKey(arg)
+                              : getDivisibilityKey(arg, bucket->second);
+        if (!spec)
+          return fallback();
+        specKey.append(spec);
+      }
+    }
+    py::tuple key =
+        py::make_tuple(versionKey, py::tuple(sigKey), py::tuple(constexprKey),
+                       py::tuple(specKey));
+
+    // cache lookup, PyDict_GetItem doesn't create the per-device cache of the
+    // defaultdict and suppresses hashing errors
+    py::object device = getDevice();
+    PyObject *deviceCache = PyDict_GetItem(cache.ptr(), device.ptr());
+    if (!deviceCache || !PyDict_Check(deviceCache))
+      return fallback();
+    PyObject *cached = PyDict_GetItem(deviceCache, key.ptr());
+    if (!cached)
+      return fallback();
+    py::object bin = py::reinterpret_borrow<py::object>(cached);
+
+    // launch
+    py::object gridValue = getGrid(grid, boundArgs);
+    py::object streamValue = stream && !stream.is_none()
+                                 ? py::reinterpret_borrow<py::object>(stream)
+                                 : getStream(device);
+    launchKernel(bin, gridValue, streamValue, compiledKernel, regularArgs);
+    return bin;
+  }
+
+private:
+  // The grid of a launch: a Grid is looked up in its cache by the values of
+  // its key arguments, other callables are called with all the arguments
+  py::object getGrid(py::handle grid,
+                     const std::vector<py::handle> &boundArgs) const {
+    if (!PyCallable_Check(grid.ptr()))
+      return py::reinterpret_borrow<py::object>(grid);
+    if (PyObject_IsInstance(grid.ptr(), gridType.ptr()) == 1) {
+      py::list key;
+      bool isBound = true;
+      for (py::handle name : grid.attr("key")) {
+        auto it = std::find(argNames.begin(), argNames.end(),
+                            name.cast<std::string>());
+        if (it == argNames.end()) {
+          isBound = false;
+          break;
+        }
+        key.append(boundArgs[it - argNames.begin()]);
+      }
+      py::object cache = grid.attr("cache");
+      py::tuple keyTuple(key);
+      if (isBound)
+        if (PyObject *cached = PyDict_GetItem(cache.ptr(), keyTuple.ptr()))
+          return py::reinterpret_borrow<py::object>(cached);
+    }
+    py::dict namedArgs;
+    for (size_t i = 0; i < boundArgs.size(); ++i)
+      namedArgs[py::str(argNames[i])] = boundArgs[i];
+    return py::reinterpret_borrow<py::object>(grid)(namedArgs);
+  }
+
+  // JITFunction._key_of, or an empty object if the Python launcher should
+  // handle the argument
+  static py::object getTypeKey(py::handle arg) {
+    if (py::hasattr(arg, "dtype"))
+      return arg.attr("dtype");
+    if (PyBool_Check(arg.ptr()))
+      return py::str("i1");
+    if (PyLong_Check(arg.ptr())) {
+      int overflow;
+      long long value = PyLong_AsLongLongAndOverflow(arg.ptr(), &overflow);
+      if (overflow)
+        return py::object();
+      if (value >= INT32_MIN && value <= INT32_MAX)
+        return py::str("i32");
+      if (value > INT32_MAX && value <= UINT32_MAX)
+        return py::str("u32");
+      return py::str("i64");
+    }
+    if (PyFloat_Check(arg.ptr()))
+      return py::str("fp32");
+    if (arg.is_none())
+      return py::none();
+    return py::object();
+  }
+
+  // specialization of an argument, as computed by the Python launcher
+  py::object getSpecKey(py::handle arg) const {
+    if (py::hasattr(arg, "data_ptr")) {
+      if (versionAlignment)
+        return py::make_tuple(true);
+      py::object ptr = arg.attr("data_ptr")();
+      unsigned long long addr = PyLong_AsUnsignedLongLong(ptr.ptr());
+      if (PyErr_Occurred()) {
+        PyErr_Clear();
+        return py::object();
+      }
+      return py::bool_(addr % divisibility == 0);
+    }
+    if (PyLong_Check(arg.ptr())) {
+      int overflow;
+      long long value = PyLong_AsLongLongAndOverflow(arg.ptr(), &overflow);
+      if (overflow)
+        return py::object();
+      return py::make_tuple(value % (long long)divisibility == 0, value == 1);
+    }
+    return py::make_tuple(false);
+  }
+
+  // JITFunction._bucket_of, with pow2 buckets as 0
+  static py::object getBucket(py::handle arg, unsigned long long bucket) {
+    if (!PyLong_Check(arg.ptr()) || PyBool_Check(arg.ptr()))
+      return py::reinterpret_borrow<py::object>(arg);
+    int overflow;
+    long long value = PyLong_AsLongLongAndOverflow(arg.ptr(), &overflow);
+    if (overflow || value > (1LL << 62))
+      return py::object();
+    if (value <= 0)
+      return py::reinterpret_borrow<py::object>(arg);
+    if (bucket == 0)
+      return py::int_(llvm::PowerOf2Ceil(value));
+    return py::int_((value + bucket - 1) / bucket * bucket);
+  }
+
+  // specialization of an argument bucketed by divisibility
+  static py::object getDivisibilityKey(py::handle arg,
+                                       unsigned long long bucket) {
+    if (py::hasattr(arg, "data_ptr")) {
+      py::object ptr = arg.attr("data_ptr")();
+      unsigned long long addr = PyLong_AsUnsignedLongLong(ptr.ptr());
+      if (PyErr_Occurred()) {
+        PyErr_Clear();
+        return py::object();
+      }
+      return py::make_tuple(addr % bucket == 0);
+    }
+    if (PyLong_Check(arg.ptr())) {
+      int overflow;
+      long long value = PyLong_AsLongLongAndOverflow(arg.ptr(), &overflow);
+      if (overflow)
+        return py::object();
+      return py::make_tuple(value % (long long)bucket == 0);
+    }
+    return py::make_tuple(false);
+  }
+
+  py::object pyLauncher;
+  py::object versionKey;
+  py::object getStream;
+  py::object getDevice;
+  py::object compiledKernel;
+  py::object gridType;
+  py::object cache;
+  std::vector<std::string> argNames;
+  std::vector<bool> isConstexpr;
+  std::set<size_t> doNotSpecialize;
+  bool versionAlignment;
+  unsigned long long divisibility;
+  std::map<size_t, unsigned long long> constexprBuckets;
+  std::map<size_t, unsigned long long> divisibilityBuckets;
+};
+
 void init_triton_runtime(py::module &&m) {
   // wrap backend_t
   py::enum_<backend_t>(m, "backend")
@@ -62,12 +396,52 @@ void init_triton_runtime(py::module &&m) {
       .value("CUDA", CUDA)
       .value("ROCM", ROCM)
       .export_values();
+
+  py::class_<KernelDispatcher>(m, "KernelDispatcher")
+      .def(py::init<py::object, py::object, py::object, py::object,
+                    py::object, py::object, py::object>())
+      .def("__call__", &KernelDispatcher::operator());
+
+  m.def("launch_many", &launchMany);
 }
 
 /*****************************************************************************/
 /* Python bindings for triton::ir                                            */
 /*****************************************************************************/
 
+// Thread pools shared by the contexts, one per number of threads (0 for all
+// the hardware threads), so that contexts created for each compilation do
+// not spawn threads of their own
+static llvm::ThreadPool &getCompileThreadPool(unsigned numThreads) {
+  static std::mutex mutex;
+  static std::map<unsigned, std::unique_ptr<llvm::ThreadPool>> pools;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &pool = pools[numThreads];
+  if (!pool)
+    pool = std::make_unique<llvm::ThreadPool>(
+        llvm::hardware_concurrency(numThreads));
+  return *pool;
+}
+
+// The memory semantic of an atomic, none for an empty string
+static mlir::triton::MemSemanticAttr
+getMemSemanticAttr(mlir::OpBuilder &self, const std::string &sem) {
+  mlir::triton::MemSemanticAttr attr;
+  if (auto memSemantic = mlir::triton::symbolizeMemSemantic(sem))
+    attr = mlir::triton::MemSemanticAttr::get(self.getContext(), *memSemantic);
+  return attr;
+}
+
+// The memory scope of an atomic, none for an empty string
+static mlir::triton::MemSyncScopeAttr
+getMemSyncScopeAttr(mlir::OpBuilder &self, const std::string &scope) {
+  mlir::triton::MemSyncScopeAttr attr;
+  if (auto memSyncScope = mlir::triton::symbolizeMemSyncScope(scope))
+    attr =
+        mlir::triton::MemSyncScopeAttr::get(self.getContext(), *memSyncScope);
+  return attr;
+}
+
 void init_triton_ir(py::module &&m) {
   using ret = py::return_value_policy;
   using namespace pybind11::literals;
@@ -76,6 +450,9 @@ void init_triton_ir(py::module &&m) {
       .value("NONE", mlir::triton::CacheModifier::NONE)
       .value("CA", mlir::triton::CacheModifier::CA)
       .value("CG", mlir::triton::CacheModifier::CG)
+      .value("WB", mlir::triton::CacheModifier::WB)
+      .value("CS", mlir::triton::CacheModifier::CS)
+      .value("WT", mlir::triton::CacheModifier::WT)
       .export_values();
 
   py::enum_<mlir::triton::EvictionPolicy>(m, "EVICTION_POLICY")
@@ -84,6 +461,11 @@ void init_triton_ir(py::module &&m) {
       .value("EVICT_LAST", mlir::triton::EvictionPolicy::EVICT_LAST)
       .export_values();
 
+  py::enum_<mlir::triton::PaddingOption>(m, "PADDING_OPTION")
+      .value("PAD_ZERO", mlir::triton::PaddingOption::PAD_ZERO)
+      .value("PAD_NAN", mlir::triton::PaddingOption::PAD_NAN)
+      .export_values();
+
   py::enum_<mlir::triton::RedOp>(m, "REDUCE_OP")
       .value("ADD", mlir::triton::RedOp::ADD)
       .value("FADD", mlir::triton::RedOp::FADD)
@@ -114,7 +496,20 @@ void init_triton_ir(py::module &&m) {
       .value("UMAX", mlir::triton::RMWOp::UMAX);
 
   py::class_<mlir::MLIRContext>(m, "context")
-      .def(py::init<>())
+      // With more than one thread, the pass managers run the passes nested
+      // under the functions of a module in parallel, and several modules can
+      // be built and compiled concurrently in the context
+      .def(py::init([](unsigned numThreads) {
+             auto context = std::make_unique<mlir::MLIRContext>(
+                 mlir::MLIRContext::Threading::DISABLED);
+             if (numThreads != 1)
+               context->setThreadPool(getCompileThreadPool(numThreads));
+             return context;
+           }),
+           py::arg("num_threads") = 0)
+      .def("num_threads", &mlir::MLIRContext::getNumThreads)
+      .def("is_multithreading_enabled",
+           &mlir::MLIRContext::isMultithreadingEnabled)
       .def("load_triton", [](mlir::MLIRContext &self) {
         self.getOrLoadDialect<mlir::triton::TritonDialect>();
         // we load LLVM because the frontend uses LLVM.undef for
@@ -373,9 +768,11 @@ void init_triton_ir(py::module &&m) {
               .cast<mlir::Attribute>();
         });
 
-  m.def(
-      "parse_mlir_module",
-      [](const std::string &inputFilename, mlir::MLIRContext &context) {
+  // parses a module with `parse`, in a context where the dialects of the
+  // compiler are loaded
+  auto parseModule =
+      [](mlir::MLIRContext &context,
+         llvm::function_ref<mlir::OwningOpRef<mlir::ModuleOp>()> parse) {
         // initialize registry
         // note: we initialize llvm for undef
         mlir::DialectRegistry registry;
@@ -387,16 +784,33 @@ void init_triton_ir(py::module &&m) {
         context.loadAllAvailableDialects();
 
         // parse module
-        mlir::OwningOpRef<mlir::ModuleOp> module(
-            mlir::parseSourceFile(inputFilename, &context));
+        mlir::OwningOpRef<mlir::ModuleOp> module = parse();
+        if (!module)
+          throw std::runtime_error("Parse MLIR file failed.");
         // locations are incompatible with ptx < 7.5 !
         module->walk([](mlir::Operation *op) {
           op->setLoc(mlir::UnknownLoc::get(op->getContext()));
         });
-        if (!module)
-          throw std::runtime_error("Parse MLIR file failed.");
 
         return module->clone();
+      };
+
+  m.def(
+      "parse_mlir_module",
+      [parseModule](const std::string &inputFilename,
+                    mlir::MLIRContext &context) {
+        return parseModule(context, [&]() {
+          return mlir::parseSourceFile(inputFilename, &context);
+        });
+      },
+      ret::take_ownership);
+
+  m.def(
+      "parse_mlir_module_str",
+      [parseModule](const std::string &source, mlir::MLIRContext &context) {
+        return parseModule(context, [&]() {
+          return mlir::parseSourceString(source, &context);
+        });
       },
       ret::take_ownership);
 
@@ -421,6 +835,10 @@ void init_triton_ir(py::module &&m) {
             self.setArgAttr(arg_no, name, mlir::IntegerAttr::get(attrTy, val));
           },
           ret::reference)
+      .def("set_name",
+           [](mlir::FuncOp &self, const std::string &name) {
+             self.setName(name);
+           })
       .def_property_readonly("type", &mlir::FuncOp::getType)
       .def("reset_type", &mlir::FuncOp::setType);
 
@@ -588,6 +1006,14 @@ void init_triton_ir(py::module &&m) {
            [](mlir::OpBuilder &self) -> mlir::Type {
              return self.getType<mlir::triton::Float8Type>();
            })
+      .def("get_fp8e4_ty",
+           [](mlir::OpBuilder &self) -> mlir::Type {
+             return self.getType<mlir::triton::Float8E4M3Type>();
+           })
+      .def("get_fp8e5_ty",
+           [](mlir::OpBuilder &self) -> mlir::Type {
+             return self.getType<mlir::triton::Float8E5M2Type>();
+           })
       .def(
           "get_half_ty",
           [](mlir::OpBuilder &self) -> mlir::Type { return self.getF16Type(); })
@@ -1151,34 +1577,105 @@ void init_triton_ir(py::module &&m) {
       .def("create_load",
            [](mlir::OpBuilder &self, mlir::Value &ptrs,
               mlir::triton::CacheModifier cacheModifier,
-              mlir::triton::EvictionPolicy evictionPolicy,
-              bool isVolatile) -> mlir::Value {
+              mlir::triton::EvictionPolicy evictionPolicy, bool isVolatile,
+              std::optional<float> l2EvictLastFraction) -> mlir::Value {
              auto loc = self.getUnknownLoc();
-             return self.create<mlir::triton::LoadOp>(
+             auto loadOp = self.create<mlir::triton::LoadOp>(
                  loc, ptrs, cacheModifier, evictionPolicy, isVolatile);
+             if (l2EvictLastFraction)
+               loadOp.l2EvictLastFractionAttr(
+                   self.getF32FloatAttr(*l2EvictLastFraction));
+             return loadOp;
            })
       .def("create_store",
-           [](mlir::OpBuilder &self, mlir::Value &ptrs,
-              mlir::Value &value) -> void {
+           [](mlir::OpBuilder &self, mlir::Value &ptrs, mlir::Value &value,
+              mlir::triton::CacheModifier cacheModifier,
+              mlir::triton::EvictionPolicy evictionPolicy) -> void {
              auto loc = self.getUnknownLoc();
-             self.create<mlir::triton::StoreOp>(loc, ptrs, value);
+             self.create<mlir::triton::StoreOp>(loc, ptrs, value, cacheModifier,
+                                                evictionPolicy);
            })
       .def("create_masked_load",
            [](mlir::OpBuilder &self, mlir::Value &ptrs, mlir::Value &mask,
               std::optional<mlir::Value> &other,
               mlir::triton::CacheModifier cacheModifier,
-              mlir::triton::EvictionPolicy evictionPolicy,
-              bool isVolatile) -> mlir::Value {
+              mlir::triton::EvictionPolicy evictionPolicy, bool isVolatile,
+              std::optional<float> l2EvictLastFraction) -> mlir::Value {
              auto loc = self.getUnknownLoc();
-             return self.create<mlir::triton::LoadOp>(
+             auto loadOp = self.create<mlir::triton::LoadOp>(
                  loc, ptrs, mask, other.value_or(mlir::Value()), cacheModifier,
                  evictionPolicy, isVolatile);
+             if (l2EvictLastFraction)
+               loadOp.l2EvictLastFractionAttr(
+                   self.getF32FloatAttr(*l2EvictLastFraction));
+             return loadOp;
            })
       .def("create_masked_store",
            [](mlir::OpBuilder &self, mlir::Value &ptrs, mlir::Value &val,
-              mlir::Value &mask) -> void {
+              mlir::Value &mask, mlir::triton::CacheModifier cacheModifier,
+              mlir::triton::EvictionPolicy evictionPolicy) -> void {
+             auto loc = self.getUnknownLoc();
+             self.create<mlir::triton::StoreOp>(loc, ptrs, val, mask,
+                                                cacheModifier, evictionPolicy);
+           })
+      // Block pointers
+      .def("create_make_block_ptr",
+           [](mlir::OpBuilder &self, mlir::Value &base,
+              std::vector<mlir::Value> &shape,
+              std::vector<mlir::Value> &strides,
+              std::vector<mlir::Value> &offsets,
+              std::vector<int64_t> &blockShape,
+              std::vector<int32_t> &order) -> mlir::Value {
+             auto loc = self.getUnknownLoc();
+             auto ptrType = base.getType().cast<mlir::triton::PointerType>();
+             auto blockType = mlir::RankedTensorType::get(
+                 blockShape, ptrType.getPointeeType());
+             return self.create<mlir::triton::MakeTensorPtrOp>(
+                 loc,
+                 mlir::triton::PointerType::get(blockType,
+                                                ptrType.getAddressSpace()),
+                 base, shape, strides, offsets, self.getI32ArrayAttr(order));
+           })
+      .def("create_advance",
+           [](mlir::OpBuilder &self, mlir::Value &ptr,
+              std::vector<mlir::Value> &offsets) -> mlir::Value {
+             auto loc = self.getUnknownLoc();
+             return self.create<mlir::triton::AdvanceOp>(loc, ptr.getType(),
+                                                         ptr, offsets);
+           })
+      .def("create_tensor_ptr_load",
+           [](mlir::OpBuilder &self, mlir::Value &ptr,
+              std::vector<int32_t> &boundaryCheck,
+              std::optional<mlir::triton::PaddingOption> padding,
+              mlir::triton::CacheModifier cacheModifier,
+              mlir::triton::EvictionPolicy evictionPolicy,
+              bool isVolatile) -> mlir::Value {
+             auto loc = self.getUnknownLoc();
+             auto blockType = ptr.getType()
+                                  .cast<mlir::triton::PointerType>()
+                                  .getPointeeType();
+             mlir::triton::PaddingOptionAttr paddingAttr;
+             if (padding)
+               paddingAttr = mlir::triton::PaddingOptionAttr::get(
+                   self.getContext(), *padding);
+             return self.create<mlir::triton::TensorPtrLoadOp>(
+                 loc, blockType, ptr, self.getI32ArrayAttr(boundaryCheck),
+                 paddingAttr,
+                 mlir::triton::CacheModifierAttr::get(self.getContext(),
+                                                      cacheModifier),
+                 mlir::triton::EvictionPolicyAttr::get(self.getContext(),
+                                                       evictionPolicy),
+                 self.getBoolAttr(isVolatile));
+           })
+      .def("create_tensor_ptr_store",
+           [](mlir::OpBuilder &self, mlir::Value &ptr, mlir::Value &val,
+              std::vector<int32_t> &boundaryCheck,
+              mlir::triton::CacheModifier cacheModifier,
+              mlir::triton::EvictionPolicy evictionPolicy) -> void {
              auto loc = self.getUnknownLoc();
-             self.create<mlir::triton::StoreOp>(loc, ptrs, val, mask);
+             self.create<mlir::triton::TensorPtrStoreOp>(
+                 loc, ptr, val, self.getI32ArrayAttr(boundaryCheck),
+                 cacheModifier, evictionPolicy);
            })
       .def("create_view",
            [](mlir::OpBuilder &self, mlir::Value &arg,
@@ -1217,7 +1714,35 @@ void init_triton_ir(py::module &&m) {
              return self.create<mlir::triton::CatOp>(
                  loc,
                  mlir::RankedTensorType::get(shape, lhsType.getElementType()),
-                 lhs, rhs);
+                 lhs, rhs, mlir::IntegerAttr());
+           })
+      .def("create_ordered_cat",
+           [](mlir::OpBuilder &self, mlir::Value &lhs, mlir::Value &rhs,
+              int axis) -> mlir::Value {
+             auto loc = self.getUnknownLoc();
+             auto lhsType = lhs.getType().dyn_cast<mlir::RankedTensorType>();
+             if (lhs.getType() != rhs.getType())
+               throw std::runtime_error(
+                   "ordered cat expects inputs of the same type");
+             std::vector<int64_t> shape = lhsType.getShape();
+             shape[axis] *= 2;
+             return self.create<mlir::triton::CatOp>(
+                 loc,
+                 mlir::RankedTensorType::get(shape, lhsType.getElementType()),
+                 lhs, rhs, self.getI32IntegerAttr(axis));
+           })
+      .def("create_join",
+           [](mlir::OpBuilder &self, mlir::Value &lhs,
+              mlir::Value &rhs) -> mlir::Value {
+             auto loc = self.getUnknownLoc();
+             return self.create<mlir::triton::JoinOp>(loc, lhs, rhs);
+           })
+      .def("create_split",
+           [](mlir::OpBuilder &self,
+              mlir::Value &arg) -> std::vector<mlir::Value> {
+             auto loc = self.getUnknownLoc();
+             auto op = self.create<mlir::triton::SplitOp>(loc, arg);
+             return {op.outLHS(), op.outRHS()};
            })
       .def("create_trans",
            [](mlir::OpBuilder &self, mlir::Value &arg) -> mlir::Value {
@@ -1254,7 +1779,8 @@ void init_triton_ir(py::module &&m) {
       // // atomic
       .def("create_atomic_cas",
            [](mlir::OpBuilder &self, mlir::Value &ptr, mlir::Value &cmp,
-              mlir::Value &val) -> mlir::Value {
+              mlir::Value &val, const std::string &sem,
+              const std::string &scope) -> mlir::Value {
              auto loc = self.getUnknownLoc();
              mlir::Type dstType;
              if (auto srcTensorType =
@@ -1269,13 +1795,14 @@ void init_triton_ir(py::module &&m) {
                                   .cast<mlir::triton::PointerType>();
                dstType = ptrType.getPointeeType();
              }
-             return self.create<mlir::triton::AtomicCASOp>(loc, dstType, ptr,
-                                                           cmp, val);
+             return self.create<mlir::triton::AtomicCASOp>(
+                 loc, dstType, ptr, cmp, val, getMemSemanticAttr(self, sem),
+                 getMemSyncScopeAttr(self, scope));
            })
       .def("create_atomic_rmw",
            [](mlir::OpBuilder &self, mlir::triton::RMWOp rmwOp,
-              mlir::Value &ptr, mlir::Value &val,
-              mlir::Value &mask) -> mlir::Value {
+              mlir::Value &ptr, mlir::Value &val, mlir::Value &mask,
+              const std::string &sem, const std::string &scope) -> mlir::Value {
              auto loc = self.getUnknownLoc();
              mlir::Type dstType;
              if (auto srcTensorType =
@@ -1290,8 +1817,10 @@ void init_triton_ir(py::module &&m) {
                                   .cast<mlir::triton::PointerType>();
                dstType = ptrType.getPointeeType();
              }
-             return self.create<mlir::triton::AtomicRMWOp>(loc, dstType, rmwOp,
-                                                           ptr, val, mask);
+             return self.create<mlir::triton::AtomicRMWOp>(
+                 loc, dstType, rmwOp, ptr, val, mask,
+                 getMemSemanticAttr(self, sem),
+                 getMemSyncScopeAttr(self, scope));
            })
       // External
       .def("create_external_elementwise",
@@ -1316,12 +1845,44 @@ void init_triton_ir(py::module &&m) {
              return self.create<mlir::triton::GetNumProgramsOp>(
                  loc, self.getI32Type(), self.getI32IntegerAttr(axis));
            })
+      .def("create_scratch",
+           [](mlir::OpBuilder &self, mlir::Type &ptrType,
+              int size) -> mlir::Value {
+             auto loc = self.getUnknownLoc();
+             return self.create<mlir::triton::ScratchOp>(
+                 loc, ptrType, self.getI32IntegerAttr(size));
+           })
       .def("create_dot",
            [](mlir::OpBuilder &self, mlir::Value &a, mlir::Value &b,
-              mlir::Value &c, bool allowTF32) -> mlir::Value {
-             auto loc = self.getUnknownLoc();
-             return self.create<mlir::triton::DotOp>(loc, c.getType(), a, b, c,
-                                                     allowTF32);
+              mlir::Value &c, bool allowTF32, const std::string &aFp8Format,
+              const std::string &bFp8Format,
+              const std::string &precision) -> mlir::Value {
+             auto loc = self.getUnknownLoc();
+             // Operands that are not fp8 have an empty format
+             auto getFp8FormatAttr = [&](const std::string &format) {
+               mlir::triton::Fp8FormatAttr attr;
+               if (auto fp8Format = mlir::triton::symbolizeFp8Format(format))
+                 attr = mlir::triton::Fp8FormatAttr::get(self.getContext(),
+                                                         *fp8Format);
+               return attr;
+             };
+             // An empty precision leaves it to allowTF32
+             mlir::triton::DotPrecisionAttr precisionAttr;
+             if (auto dotPrecision =
+                     mlir::triton::symbolizeDotPrecision(precision))
+               precisionAttr = mlir::triton::DotPrecisionAttr::get(
+                   self.getContext(), *dotPrecision);
+             return self.create<mlir::triton::DotOp>(
+                 loc, c.getType(), a, b, c, self.getBoolAttr(allowTF32),
+                 getFp8FormatAttr(aFp8Format), getFp8FormatAttr(bFp8Format),
+                 precisionAttr);
+           })
+      .def("create_sparse_dot",
+           [](mlir::OpBuilder &self, mlir::Value &a, mlir::Value &aMeta,
+              mlir::Value &b, mlir::Value &c) -> mlir::Value {
+             auto loc = self.getUnknownLoc();
+             return self.create<mlir::triton::SparseDotOp>(loc, c.getType(), a,
+                                                           aMeta, b, c);
            })
       .def("create_exp",
            [](mlir::OpBuilder &self, mlir::Value &val) -> mlir::Value {
@@ -1348,6 +1909,17 @@ void init_triton_ir(py::module &&m) {
              auto loc = self.getUnknownLoc();
              return self.create<mlir::math::SqrtOp>(loc, val);
            })
+      .def("create_philox",
+           [](mlir::OpBuilder &self, mlir::Value &c0, mlir::Value &c1,
+              mlir::Value &c2, mlir::Value &c3, mlir::Value &k0,
+              mlir::Value &k1, int nRounds) -> std::vector<mlir::Value> {
+             auto loc = self.getUnknownLoc();
+             auto type = c0.getType();
+             auto op = self.create<mlir::triton::PhiloxOp>(
+                 loc, type, type, type, type, c0, c1, c2, c3, k0, k1,
+                 self.getI32IntegerAttr(nRounds));
+             return {op.out0(), op.out1(), op.out2(), op.out3()};
+           })
       .def("create_reduce",
            [](mlir::OpBuilder &self, mlir::Value &operand,
               mlir::triton::RedOp redOp, int axis) -> mlir::Value {
@@ -1365,6 +1937,45 @@ void init_triton_ir(py::module &&m) {
              return self.create<mlir::triton::ReduceOp>(loc, resType, redOp,
                                                         operand, axis);
            })
+      .def("create_generic_reduce",
+           [](mlir::OpBuilder &self, std::vector<mlir::Value> &operands,
+              int axis) -> mlir::OpState {
+             auto loc = self.getUnknownLoc();
+             return self.create<mlir::triton::GenericReduceOp>(loc, operands,
+                                                               axis);
+           })
+      .def("create_generic_reduce_ret",
+           [](mlir::OpBuilder &self,
+              std::vector<mlir::Value> &returnValues) -> mlir::OpState {
+             auto loc = self.getUnknownLoc();
+             return self.create<mlir::triton::GenericReduceReturnOp>(
+                 loc, returnValues);
+           })
+      .def("create_scan",
+           [](mlir::OpBuilder &self, std::vector<mlir::Value> &operands,
+              int axis, bool reverse) -> mlir::OpState {
+             auto loc = self.getUnknownLoc();
+             return self.create<mlir::triton::ScanOp>(loc, operands, axis,
+                                                      reverse);
+           })
+      .def("create_scan_ret",
+           [](mlir::OpBuilder &self,
+              std::vector<mlir::Value> &returnValues) -> mlir::OpState {
+             auto loc = self.getUnknownLoc();
+             return self.create<mlir::triton::ScanReturnOp>(loc, returnValues);
+           })
+      .def("create_sort",
+           [](mlir::OpBuilder &self, std::vector<mlir::Value> &operands,
+              int axis, bool descending, int k) -> mlir::OpState {
+             // k is 0 for a full sort
+             auto loc = self.getUnknownLoc();
+             mlir::IntegerAttr kAttr;
+             if (k > 0)
+               kAttr = self.getI32IntegerAttr(k);
+             return self.create<mlir::triton::SortOp>(
+                 loc, operands, self.getI32IntegerAttr(axis),
+                 self.getBoolAttr(descending), kAttr);
+           })
       .def("create_ptr_to_int",
            [](mlir::OpBuilder &self, mlir::Value &val,
               mlir::Type &type) -> mlir::Value {
@@ -1401,13 +2012,36 @@ void init_triton_ir(py::module &&m) {
              return self.create<::mlir::LLVM::UndefOp>(loc, type);
            })
       // Force GPU barrier
-      .def("create_barrier", [](mlir::OpBuilder &self) {
-        auto loc = self.getUnknownLoc();
-        self.create<mlir::gpu::BarrierOp>(loc);
-      });
+      .def("create_barrier",
+           [](mlir::OpBuilder &self) {
+             auto loc = self.getUnknownLoc();
+             self.create<mlir::gpu::BarrierOp>(loc);
+           })
+      .def("create_grid_barrier",
+           [](mlir::OpBuilder &self) {
+             auto loc = self.getUnknownLoc();
+             self.create<mlir::triton::GridBarrierOp>(loc);
+           })
+      .def("create_profile_region",
+           [](mlir::OpBuilder &self, const std::string &name) {
+             auto loc = self.getUnknownLoc();
+             self.create<mlir::triton::ProfileRegionOp>(loc, name);
+           })
+      .def("create_trace",
+           [](mlir::OpBuilder &self, const std::string &prefix,
+              const std::vector<mlir::Value> &values) {
+             auto loc = self.getUnknownLoc();
+             self.create<mlir::triton::TraceOp>(loc, prefix, values);
+           });
 
   py::class_<mlir::PassManager>(m, "pass_manager")
-      .def(py::init<mlir::MLIRContext *>())
+      .def(py::init([](mlir::MLIRContext *context) {
+        auto pm = std::make_unique<mlir::PassManager>(context);
+        if (::triton::tools::CompileTimer::get().isEnabled())
+          pm->addInstrumentation(
+              std::make_unique<::triton::tools::PassTimingInstrumentation>());
+        return pm;
+      }))
       .def("enable_debug",
            [](mlir::PassManager &self) {
              auto printingFlags = mlir::OpPrintingFlags();
@@ -1425,6 +2059,7 @@ void init_triton_ir(py::module &&m) {
            })
       .def("run",
            [](mlir::PassManager &self, mlir::ModuleOp &mod) {
+             py::gil_scoped_release allow_threads;
              // TODO: maybe dump module to file and print error for better
              // diagnostics
              if (mlir::failed(self.run(mod.getOperation())))
@@ -1445,12 +2080,15 @@ void init_triton_ir(py::module &&m) {
            [](mlir::PassManager &self) {
              self.addPass(mlir::createInlinerPass());
            })
+      // Nested under the functions, to run on each of them in parallel
       .def("add_canonicalizer_pass",
            [](mlir::PassManager &self) {
-             self.addPass(mlir::createCanonicalizerPass());
+             self.addNestedPass<mlir::FuncOp>(mlir::createCanonicalizerPass());
            })
       .def("add_cse_pass",
-           [](mlir::PassManager &self) { self.addPass(mlir::createCSEPass()); })
+           [](mlir::PassManager &self) {
+             self.addNestedPass<mlir::FuncOp>(mlir::createCSEPass());
+           })
       .def("add_licm_pass",
            [](mlir::PassManager &self) {
              self.addPass(mlir::createLoopInvariantCodeMotionPass());
@@ -1459,24 +2097,69 @@ void init_triton_ir(py::module &&m) {
            [](mlir::PassManager &self) {
              self.addPass(mlir::triton::createCombineOpsPass());
            })
-      .def("add_convert_triton_to_tritongpu_pass",
-           [](mlir::PassManager &self, int numWarps) {
+      .def("add_triton_rewrite_tensor_pointer_pass",
+           [](mlir::PassManager &self) {
+             self.addPass(mlir::triton::createRewriteTensorPointerPass());
+           })
+      .def("add_triton_canonicalize_pointers_pass",
+           [](mlir::PassManager &self, bool int32Indexing) {
              self.addPass(
-                 mlir::triton::createConvertTritonToTritonGPUPass(numWarps));
+                 mlir::triton::createCanonicalizePointersPass(int32Indexing));
+           })
+      .def("add_triton_version_alignment_pass",
+           [](mlir::PassManager &self) {
+             self.addPass(mlir::triton::createVersionAlignmentPass());
+           })
+      .def("add_triton_remap_program_ids_pass",
+           [](mlir::PassManager &self, const std::string &order,
+              int groupSize) {
+             self.addPass(
+                 mlir::triton::createRemapProgramIdsPass(order, groupSize));
+           })
+      .def("add_convert_triton_to_tritongpu_pass",
+           [](mlir::PassManager &self, int numWarps, int threadsPerWarp,
+              int sharedBanks, int minBlocksPerSM, int maxRegisters,
+              int wavesPerEU, int numCTAs) {
+             self.addPass(mlir::triton::createConvertTritonToTritonGPUPass(
+                 numWarps, threadsPerWarp, sharedBanks, minBlocksPerSM,
+                 maxRegisters, wavesPerEU, numCTAs));
+           },
+           py::arg("num_warps"), py::arg("threads_per_warp") = 32,
+           py::arg("shared_banks") = 32, py::arg("min_blocks_per_sm") = 0,
+           py::arg("max_registers") = 0, py::arg("waves_per_eu") = 0,
+           py::arg("num_ctas") = 1)
+      .def("add_tritongpu_peel_loops_pass",
+           [](mlir::PassManager &self) {
+             self.addPass(mlir::createTritonGPUPeelLoopsPass());
+           })
+      .def("add_tritongpu_hoist_invariant_loads_pass",
+           [](mlir::PassManager &self) {
+             self.addPass(mlir::createTritonGPUHoistInvariantLoadsPass());
+           })
+      .def("add_tritongpu_loop_unroll_pass",
+           [](mlir::PassManager &self) {
+             self.addPass(mlir::createTritonGPULoopUnrollPass());
            })
       .def("add_tritongpu_pipeline_pass",
            [](mlir::PassManager &self, int numStages) {
              self.addPass(mlir::createTritonGPUPipelinePass(numStages));
            })
-      .def("add_tritongpu_prefetch_pass",
+      .def("add_tritongpu_warp_specialize_pass",
            [](mlir::PassManager &self) {
-             self.addPass(mlir::createTritonGPUPrefetchPass());
+             self.addPass(mlir::createTritonGPUWarpSpecializePass());
            })
-      .def("add_tritongpu_combine_pass",
-           [](mlir::PassManager &self, int computeCapability) {
-             self.addPass(
-                 mlir::createTritonGPUCombineOpsPass(computeCapability));
+      .def("add_tritongpu_prefetch_pass",
+           [](mlir::PassManager &self, int prefetchWidth) {
+             self.addPass(mlir::createTritonGPUPrefetchPass(prefetchWidth));
            })
+      .def(
+          "add_tritongpu_combine_pass",
+          [](mlir::PassManager &self, int computeCapability,
+             double rematWeight) {
+            self.addPass(mlir::createTritonGPUCombineOpsPass(computeCapability,
+                                                             rematWeight));
+          },
+          py::arg("compute_capability"), py::arg("remat_weight") = 1.0)
       .def("add_tritongpu_update_mma_for_volta_pass",
            [](mlir::PassManager &self) {
              self.addPass(mlir::createTritonGPUUpdateMmaForVoltaPass());
@@ -1485,6 +2168,11 @@ void init_triton_ir(py::module &&m) {
            [](mlir::PassManager &self) {
              self.addPass(mlir::createTritonGPUReorderInstructionsPass());
            })
+      .def("add_tritongpu_list_schedule_pass",
+           [](mlir::PassManager &self, int registerBudget) {
+             self.addPass(
+                 mlir::createTritonGPUListSchedulePass(registerBudget));
+           })
       .def("add_tritongpu_decompose_conversions_pass",
            [](mlir::PassManager &self) {
              self.addPass(mlir::createTritonGPUDecomposeConversionsPass());
@@ -1506,13 +2194,108 @@ void init_triton_translation(py::module &m) {
     return shared.getInt();
   });
 
+  m.def("get_num_warp_groups", [](mlir::ModuleOp mod) {
+    return mlir::triton::gpu::TritonGPUDialect::getNumWarpGroups(mod);
+  });
+
+  // Estimated peak of live registers per thread and registers above the
+  // budget of the list scheduler, or None if it did not run
+  m.def("get_register_estimate", [](mlir::ModuleOp mod) -> py::object {
+    auto live =
+        mod->getAttrOfType<mlir::IntegerAttr>("triton_gpu.live-registers");
+    auto spills =
+        mod->getAttrOfType<mlir::IntegerAttr>("triton_gpu.predicted-spills");
+    if (!live || !spills)
+      return py::none();
+    return py::make_tuple(live.getInt(), spills.getInt());
+  });
+
+  // Kernels with a grid barrier need all their programs to be resident
+  m.def("has_grid_barrier", [](mlir::ModuleOp mod) {
+    bool found = false;
+    mod.walk([&](mlir::triton::GridBarrierOp) { found = true; });
+    return found;
+  });
+
+  // Profiles the kernels of a module as a whole: opens the region `name` at
+  // their entry, unless the module already has profiled regions
+  m.def("add_profile_region", [](mlir::ModuleOp mod, const std::string &name) {
+    bool found = false;
+    mod.walk([&](mlir::triton::ProfileRegionOp) { found = true; });
+    if (found)
+      return;
+    mlir::OpBuilder b(mod.getContext());
+    for (auto funcOp : mod.getOps<mlir::FuncOp>()) {
+      if (funcOp.isExternal() || funcOp.isPrivate())
+        continue;
+      b.setInsertionPointToStart(&funcOp.getBody().front());
+      b.create<mlir::triton::ProfileRegionOp>(funcOp.getLoc(), name);
+    }
+  });
+
+  // Names of the profiled regions, in the order they are numbered by the
+  // conversion to LLVM
+  m.def("get_profile_regions", [](mlir::ModuleOp mod) {
+    std::vector<std::string> names;
+    mod.walk([&](mlir::triton::ProfileRegionOp op) {
+      if (llvm::find(names, op.name().str()) == names.end())
+        names.push_back(op.name().str());
+    });
+    return names;
+  });
+
+  // Formats of the trace records, in the order they are numbered by the
+  // conversion to LLVM: the prefix and the words of the records, and the
+  // element type, shape and elements per thread of each argument
+  m.def("get_trace_formats", [](mlir::ModuleOp mod) {
+    py::list formats;
+    mod.walk([&](mlir::triton::TraceOp op) {
+      py::list args;
+      for (mlir::Value arg : op.args()) {
+        py::dict desc;
+        mlir::Type elemTy = arg.getType();
+        desc["shape"] = py::none();
+        desc["elems"] = 1;
+        if (auto tensorTy = elemTy.dyn_cast<mlir::RankedTensorType>()) {
+          elemTy = tensorTy.getElementType();
+          desc["shape"] = std::vector<int64_t>(tensorTy.getShape().begin(),
+                                               tensorTy.getShape().end());
+          desc["elems"] = mlir::triton::gpu::getElemsPerThread(tensorTy);
+        }
+        std::string dtype;
+        llvm::raw_string_ostream os(dtype);
+        if (elemTy.isa<mlir::triton::PointerType>())
+          os << "ptr";
+        else
+          elemTy.print(os);
+        desc["dtype"] = os.str();
+        args.append(desc);
+      }
+      py::dict format;
+      format["prefix"] = op.prefix().str();
+      format["args"] = args;
+      format["words"] = mlir::getTraceRecordWords(op);
+      formats.append(format);
+    });
+    return formats;
+  });
+
+  // Record the time spent in the phases of compilation until the matching
+  // disable_compile_timer, which returns the (phase, seconds) records
+  m.def("enable_compile_timer",
+        []() { ::triton::tools::CompileTimer::get().enable(); });
+  m.def("disable_compile_timer",
+        []() { return ::triton::tools::CompileTimer::get().disable(); });
+
   m.def(
       "translate_triton_gpu_to_llvmir",
-      [](mlir::ModuleOp op, int computeCapability) {
+      [](mlir::ModuleOp op, int computeCapability, bool fastMath,
+         int ptxVersion) {
         py::gil_scoped_release allow_threads;
         llvm::LLVMContext llvmContext;
         auto llvmModule = ::mlir::triton::translateTritonGPUToLLVMIR(
-            &llvmContext, op, computeCapability);
+            &llvmContext, op, computeCapability, fastMath,
+            ::triton::getEmittedPTXVersion(ptxVersion));
         if (!llvmModule)
           llvm::report_fatal_error("Failed to translate TritonGPU to LLVM IR.");
 
@@ -1548,9 +2331,100 @@ void init_triton_translation(py::module &m) {
       },
       ret::take_ownership);
 
+  m.def(
+      "translate_triton_gpu_to_cpu_llvmir",
+      [](mlir::ModuleOp op) {
+        py::gil_scoped_release allow_threads;
+        llvm::LLVMContext llvmContext;
+        auto llvmModule =
+            triton::translateTritonGPUToCPULLVMIR(&llvmContext, op);
+        if (!llvmModule)
+          llvm::report_fatal_error(
+              "Failed to translate TritonGPU to LLVM IR for the CPU.");
+
+        std::string str;
+        llvm::raw_string_ostream os(str);
+        llvmModule->print(os, nullptr);
+        os.flush();
+        return str;
+      },
+      ret::take_ownership);
+
+  m.def("translate_llvmir_to_cpu_object",
+        [](const std::string llvmIR) -> py::object {
+          std::string object;
+          {
+            py::gil_scoped_release allow_threads;
+            llvm::LLVMContext context;
+            std::unique_ptr<llvm::MemoryBuffer> buffer =
+                llvm::MemoryBuffer::getMemBuffer(llvmIR.c_str());
+            llvm::SMDiagnostic error;
+            std::unique_ptr<llvm::Module> module =
+                llvm::parseIR(buffer->getMemBufferRef(), error, context);
+            if (!module) {
+              llvm::report_fatal_error(
+                  "failed to parse IR: " + error.getMessage() +
+                  "lineno: " + std::to_string(error.getLineNo()));
+            }
+            object = triton::translateLLVMIRToCPUObject(*module);
+          }
+          if (object.empty())
+            throw std::runtime_error("Failed to compile LLVM IR for the CPU");
+          return py::bytes(object);
+        });
+
+  m.def("get_host_cpu_name", []() { return triton::getHostCPUName(); });
+
+  // Version of the in-process PTX compiler, or an empty string if ptx has to
+  // be compiled by an external ptxas
+  m.def("get_ptx_compiler_version", []() -> std::string {
+#ifdef TRITON_USE_NVPTX_COMPILER
+    unsigned major, minor;
+    if (nvPTXCompilerGetVersion(&major, &minor) != NVPTXCOMPILE_SUCCESS)
+      return "";
+    return std::to_string(major) + "." + std::to_string(minor);
+#else
+    return "";
+#endif
+  });
+
   m.def("compile_ptx_to_cubin",
         [](const std::string &ptxCode, const std::string &ptxasPath,
            int capability) -> py::object {
+#ifdef TRITON_USE_NVPTX_COMPILER
+          std::string cubin;
+          {
+            py::gil_scoped_release allow_threads;
+
+            // compile ptx in memory
+            ::triton::tools::CompileTimer::Scope timer("tool/nvptxcompiler");
+            nvPTXCompilerHandle compiler;
+            if (nvPTXCompilerCreate(&compiler, ptxCode.size(),
+                                    ptxCode.c_str()) != NVPTXCOMPILE_SUCCESS)
+              throw std::runtime_error("Failed to create the PTX compiler");
+            std::string gpuName = "--gpu-name=sm_" + std::to_string(capability) +
+                                  (capability == 90 ? "a" : "");
+            const char *options[] = {gpuName.c_str()};
+            if (nvPTXCompilerCompile(compiler, 1, options) !=
+                NVPTXCOMPILE_SUCCESS) {
+              size_t logSize = 0;
+              nvPTXCompilerGetErrorLogSize(compiler, &logSize);
+              std::string log(logSize, '\0');
+              if (logSize)
+                nvPTXCompilerGetErrorLog(compiler, &log[0]);
+              nvPTXCompilerDestroy(&compiler);
+              throw std::runtime_error("Internal Triton PTX codegen error: \n" +
+                                       log);
+            }
+            size_t cubinSize = 0;
+            nvPTXCompilerGetCompiledProgramSize(compiler, &cubinSize);
+            cubin.resize(cubinSize);
+            nvPTXCompilerGetCompiledProgram(compiler, &cubin[0]);
+            nvPTXCompilerDestroy(&compiler);
+          }
+          py::bytes bytes(cubin);
+          return std::move(bytes);
+#else
           py::gil_scoped_release allow_threads;
 
           // compile ptx with ptxas
@@ -1574,7 +2448,10 @@ void init_triton_translation(py::module &m) {
                 (capability == 90 ? "a " : " ") + _fsrc + " -o " + _fsrc +
                 ".o 2> " + _flog;
 
-          err = system(cmd.c_str());
+          {
+            ::triton::tools::CompileTimer::Scope timer("tool/ptxas");
+            err = system(cmd.c_str());
+          }
           if (err != 0) {
             std::ifstream _log(_flog);
             std::string log(std::istreambuf_iterator<char>(_log), {});
@@ -1586,6 +2463,7 @@ void init_triton_translation(py::module &m) {
           _cubin.close();
           py::bytes bytes(cubin);
           return std::move(bytes);
+#endif
         });
 
   m.def("add_external_libs",
@@ -1596,18 +2474,21 @@ void init_triton_translation(py::module &m) {
 
   m.def(
       "translate_llvmir_to_hsaco",
-      [](const std::string llvmIR, std::string cc) -> std::tuple<std::string, std::string> {
-        // create LLVM module from C++
-        llvm::LLVMContext context;
-        std::unique_ptr<llvm::MemoryBuffer> buffer =
-            llvm::MemoryBuffer::getMemBuffer(llvmIR.c_str());
-        llvm::SMDiagnostic error;
-        std::unique_ptr<llvm::Module> module =
-            llvm::parseIR(buffer->getMemBufferRef(), error, context);
-        // translate module to HSACO
-        auto hsacoCode =
-            triton::translateLLVMIRToHSACO(*module, cc);
-        return hsacoCode;
+      [](const std::string llvmIR, std::string cc) -> py::tuple {
+        std::string amdgcn, hsaco;
+        {
+          py::gil_scoped_release allow_threads;
+          // create LLVM module from C++
+          llvm::LLVMContext context;
+          std::unique_ptr<llvm::MemoryBuffer> buffer =
+              llvm::MemoryBuffer::getMemBuffer(llvmIR.c_str());
+          llvm::SMDiagnostic error;
+          std::unique_ptr<llvm::Module> module =
+              llvm::parseIR(buffer->getMemBufferRef(), error, context);
+          // translate module to HSACO
+          std::tie(amdgcn, hsaco) = triton::translateLLVMIRToHSACO(*module, cc);
+        }
+        return py::make_tuple(amdgcn, py::bytes(hsaco));
       },
       ret::take_ownership);
 }
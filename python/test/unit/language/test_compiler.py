@@ -1,3 +1,8 @@
+import ctypes
+import os
+import subprocess
+
+import pytest
 import torch
 
 import triton
@@ -18,7 +23,7 @@ def test_empty_kernel_cubin_compile():
                             signature="*fp32,i32,i32",
                             constants={"BLOCK": 256})
     if torch.version.hip is not None:
-        assert len(kernel.asm["hsaco_path"]) > 0
+        assert len(kernel.asm["hsaco"]) > 0
     else:
         assert len(kernel.asm["cubin"]) > 0
 
@@ -30,3 +35,289 @@ def test_empty_kernel_launch():
 
     A = torch.zeros([1024], device="cuda")
     empty_kernel[grid](X=A, stride_xm=256, BLOCK=256)
+
+
+def test_compile_times_report(monkeypatch, tmp_path):
+    # compile from scratch
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    kernel = triton.compile(empty_kernel,
+                            signature="*fp32,i32,i32",
+                            constants={"BLOCK": 256},
+                            profile=True)
+    report = kernel.metadata["compile_times"]
+    assert {"ttir", "ttgir", "llir"} <= report["stages"].keys()
+    assert any(name.startswith("TritonGPUCombine") for name in report["passes"])
+    assert "O3" in report["llvm"]
+    assert len(report["tools"]) > 0
+
+
+@triton.jit
+def copy_kernel(X, Y, BLOCK: tl.constexpr):
+    offs = tl.arange(0, BLOCK)
+    tl.store(Y + offs, tl.load(X + offs))
+
+
+def test_kernel_bundle(monkeypatch, tmp_path):
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path / "build-cache"))
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 128})
+    config = triton.Config({"BLOCK": 128}, num_warps=4)
+    path = tmp_path / "kernels.bundle"
+    triton.write_kernel_bundle(path, [(kernel, config)])
+    # bundles are reproducible
+    data = path.read_bytes()
+    triton.write_kernel_bundle(path, [(kernel, config)])
+    assert path.read_bytes() == data
+
+    # loaded from an empty cache, without compiling
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path / "deploy-cache"))
+    bundle = triton.KernelBundle(path)
+    loaded = bundle.get(kernel.metadata["name"], constants={"2": 128})
+    assert loaded.autotune == config.to_dict()
+    assert loaded.shared == kernel.shared
+    x = torch.randn(128, device="cuda")
+    y = torch.empty_like(x)
+    loaded[(1, 1, 1)](x, y)
+    assert torch.equal(x, y)
+    assert not list((tmp_path / "deploy-cache").glob("*/*.ttir"))
+
+
+def test_kernel_library(tmp_path):
+    generic = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 128})
+    aligned = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 128},
+                             configs=[triton.compiler.instance_descriptor(divisible_by_16={0, 1})])
+    paths = triton.write_kernel_library(tmp_path, "copy", {"copy": [generic, aligned]})
+    assert [p.rsplit("/", 1)[1] for p in paths] == ["copy.h", "copy.c", "libcopy.a"]
+
+    # called from C, through a shared object linking the static library
+    if torch.version.hip is not None:
+        libs = [f"-L{triton.compiler.libhip_dir()}", "-lamdhip64"]
+    else:
+        libs = [f"-L{d}" for d in triton.compiler.libcuda_dirs()] + ["-lcuda"]
+    so = str(tmp_path / "libcopy.so")
+    subprocess.check_call([triton.compiler._c_compiler(), "-shared", "-o", so,
+                           "-Wl,--whole-archive", paths[2], "-Wl,--no-whole-archive"] + libs)
+    lib = ctypes.CDLL(so)
+    assert lib.copy_load() == 0
+    stream = ctypes.c_void_p(torch.cuda.current_stream().cuda_stream)
+    x = torch.randn(129, device="cuda")
+    # aligned pointers launch the specialized variant, unaligned ones the generic one
+    for offset in (0, 1):
+        y = torch.zeros_like(x)
+        assert lib.copy(stream, 1, 1, 1, ctypes.c_uint64(x.data_ptr() + 4 * offset),
+                        ctypes.c_uint64(y.data_ptr() + 4 * offset)) == 0
+        torch.cuda.synchronize()
+        assert torch.equal(x[offset:offset + 128], y[offset:offset + 128])
+    lib.copy_unload()
+
+
+def test_launch_bounds():
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 1024},
+                            min_blocks_per_sm=4, max_registers=32)
+    if torch.version.hip is not None:
+        assert '"amdgpu-waves-per-eu"="4"' in kernel.asm["llir"]
+        assert '"amdgpu-num-vgpr"="32"' in kernel.asm["llir"]
+    else:
+        assert ".maxnreg 32" in kernel.asm["ptx"]
+        assert ".minnctapersm 4" in kernel.asm["ptx"]
+    assert kernel.register_report()["registers"] <= 32
+    # from the launcher
+    x = torch.randn(1024, device="cuda")
+    y = torch.empty_like(x)
+    copy_kernel[(1,)](x, y, BLOCK=1024, min_blocks_per_sm=4, max_registers=32)
+    assert torch.equal(x, y)
+
+
+def test_static_analysis(monkeypatch, tmp_path):
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 1024},
+                            configs=[triton.compiler.instance_descriptor(divisible_by_16={0, 1})])
+    report = kernel.metadata["static_analysis"]
+    assert report["registers"] > 0
+    assert report["spills"] == 0
+    assert report["shared"] == kernel.shared
+    assert 0 < report["occupancy"] <= 1
+    # each thread copies 8 aligned elements with vectorized accesses
+    assert report["global_loads"] == [128, 128]
+    assert report["global_stores"] == [128, 128]
+    assert report["mma"] == 0
+    # the report is cached with the metadata
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 1024},
+                            configs=[triton.compiler.instance_descriptor(divisible_by_16={0, 1})])
+    assert kernel.metadata["static_analysis"] == report
+
+
+def test_lazy_loading(monkeypatch, tmp_path):
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    compiled = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 256})
+    # from the cache, the stages are read on first use and the module is
+    # loaded on first launch
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 256})
+    assert isinstance(kernel.asm, triton.compiler.CachedAsm)
+    assert kernel.cu_module is None
+    assert kernel.asm["ttgir"] == compiled.asm["ttgir"]
+    triton.prefetch_kernels([kernel]).join()
+    assert kernel.cu_module is not None
+    x = torch.randn(256, device="cuda")
+    y = torch.empty_like(x)
+    kernel[(1, 1, 1)](x, y)
+    assert torch.equal(x, y)
+    # a stage changed in the cache since the kernel was loaded is rebuilt
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 256})
+    next(tmp_path.glob("*/copy_kernel.ttgir")).write_text("stale")
+    assert kernel.asm["ttgir"] == compiled.asm["ttgir"]
+
+
+def test_cached_stages_parsed_on_demand(monkeypatch, tmp_path):
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    compiled = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 512})
+    next(tmp_path.glob("*/copy_kernel.llir")).unlink()
+    parsed = []
+    ir = triton._C.libtriton.triton.ir
+    parse = ir.parse_mlir_module
+    monkeypatch.setattr(ir, "parse_mlir_module", lambda path, context: parsed.append(path) or parse(path, context))
+    # only the stage the missing one is compiled from is parsed
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 512})
+    assert [os.path.splitext(path)[1] for path in parsed] == [".ttgir"]
+    assert kernel.asm["ttir"] == compiled.asm["ttir"]
+    assert kernel.asm["llir"] == compiled.asm["llir"]
+
+
+def test_launch_many():
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 128})
+    xs = [torch.randn(128, device="cuda") for _ in range(4)]
+    ys = [torch.empty_like(x) for x in xs]
+    triton.launch_many([(kernel, (1,), (x, y)) for x, y in zip(xs, ys)])
+    for x, y in zip(xs, ys):
+        assert torch.equal(x, y)
+
+
+def test_cached_grid():
+    calls = []
+
+    def fn(args):
+        calls.append(args["BLOCK"])
+        return (1,)
+
+    grid = triton.Grid(fn, key=["BLOCK"])
+    x = torch.randn(128, device="cuda")
+    for _ in range(3):
+        y = torch.empty_like(x)
+        copy_kernel[grid](x, y, BLOCK=128)
+        assert torch.equal(x, y)
+    assert calls == [128]
+
+
+@triton.jit
+def dot_kernel(A, B, C, M: tl.constexpr, N: tl.constexpr, K: tl.constexpr):
+    rm = tl.arange(0, M)
+    rn = tl.arange(0, N)
+    rk = tl.arange(0, K)
+    a = tl.load(A + rm[:, None] * K + rk[None, :])
+    b = tl.load(B + rk[:, None] * N + rn[None, :])
+    c = tl.dot(a, b)
+    tl.store(C + rm[:, None] * N + rn[None, :], c)
+
+
+def test_wgmma():
+    if torch.version.hip is not None or torch.cuda.get_device_capability()[0] != 9:
+        pytest.skip("wgmma is only available on Hopper")
+    M, N, K = 128, 64, 64
+    a = torch.randn((M, K), device="cuda", dtype=torch.float16)
+    b = torch.randn((K, N), device="cuda", dtype=torch.float16)
+    c = torch.empty((M, N), device="cuda", dtype=torch.float32)
+    kernel = dot_kernel[(1,)](a, b, c, M=M, N=N, K=K, num_warps=4)
+    assert "wgmma.mma_async.sync.aligned.m64n64k16.f32.f16.f16" in kernel.asm["ptx"]
+    torch.testing.assert_close(c, torch.matmul(a.float(), b.float()), rtol=1e-2, atol=1e-2)
+
+
+@triton.jit
+def add_kernel(X, Y, Z, N, BLOCK: tl.constexpr):
+    offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+    mask = offs < N
+    tl.store(Z + offs, tl.load(X + offs, mask=mask) + tl.load(Y + offs, mask=mask), mask=mask)
+
+
+@triton.jit
+def matmul_kernel(A, B, C, M: tl.constexpr, N: tl.constexpr, K: tl.constexpr):
+    rm = tl.arange(0, M)
+    rn = tl.arange(0, N)
+    rk = tl.arange(0, K)
+    a = tl.load(A + rm[:, None] * K + rk[None, :])
+    b = tl.load(B + rk[:, None] * N + rn[None, :])
+    c = tl.dot(a, b) + tl.sum(a, axis=1)[:, None]
+    tl.store(C + rm[:, None] * N + rn[None, :], c)
+
+
+def test_cpu_target(monkeypatch, tmp_path):
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    kernel = triton.compile(add_kernel, signature="*fp32,*fp32,*fp32,i32", constants={4: 256}, target="cpu")
+    assert kernel.metadata["arch"].startswith("cpu-")
+    assert len(kernel.asm["obj"]) > 0
+    n = 1000
+    x, y = torch.randn(n), torch.randn(n)
+    z = torch.zeros(n)
+    kernel[(triton.cdiv(n, 256),)](x, y, z, n)
+    assert torch.equal(z, x + y)
+    # with a single thread, and from the cache
+    kernel = triton.compile(add_kernel, signature="*fp32,*fp32,*fp32,i32", constants={4: 256}, target="cpu")
+    z = torch.zeros(n)
+    kernel[(triton.cdiv(n, 256),)](x, y, z, n, num_threads=1)
+    assert torch.equal(z, x + y)
+
+    kernel = triton.compile(matmul_kernel, signature="*fp32,*fp32,*fp32",
+                            constants={3: 16, 4: 32, 5: 16}, target="cpu")
+    a, b = torch.randn(16, 16), torch.randn(16, 32)
+    c = torch.empty(16, 32)
+    kernel[(1,)](a, b, c)
+    torch.testing.assert_close(c, a @ b + a.sum(1, keepdim=True))
+
+
+def test_profile_guided_compilation(monkeypatch, tmp_path):
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    x = torch.randn(256, device="cuda")
+    y = torch.empty_like(x)
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 256}, pgo="train")
+    # the defaults are tried first, and the whole kernel is profiled
+    assert kernel.metadata["pgo"]["decisions"] == {}
+    assert kernel.profile_regions == ["kernel"]
+    for _ in range(4):
+        kernel[(2, 1, 1)](x, y)
+    assert torch.equal(x, y)
+    trial = kernel.record_feedback()
+    assert trial["programs"] == 8
+    assert trial["cycles"] > 0
+    assert trial["spills"] == 0
+    # the variants of a copy compile to the same binary: they are not run, and
+    # the search converges on the defaults
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 256}, pgo="train")
+    assert kernel.metadata["pgo"]["decisions"] == {}
+    feedback = triton.compiler.ProfileFeedback(triton.compiler.CacheManager(kernel.metadata["pgo"]["key"]),
+                                               "copy_kernel")
+    assert len(feedback.trials) == 1 + sum(len(values) - 1 for values in triton.compiler.PGO_KNOBS.values())
+    # the fastest variant is compiled without profiled regions
+    kernel = triton.compile(copy_kernel, signature="*fp32,*fp32", constants={2: 256}, pgo="use")
+    assert kernel.metadata["pgo"]["decisions"] == {}
+    assert not kernel.profile_regions
+    kernel[(1, 1, 1)](x, y)
+    assert torch.equal(x, y)
+
+
+@triton.jit(restrict=["X"])
+def restrict_add_kernel(X, Y, BLOCK: tl.constexpr):
+    offs = tl.arange(0, BLOCK)
+    tl.store(Y + offs, tl.load(X + offs) + tl.load(Y + offs))
+
+
+def test_restrict():
+    if torch.version.hip is not None:
+        pytest.skip("non-coherent loads are NVIDIA-only")
+    x = torch.randn(128, device="cuda")
+    y = torch.randn(128, device="cuda")
+    ref = x + y
+    kernel = restrict_add_kernel[(1,)](x, y, BLOCK=128)
+    torch.testing.assert_close(y, ref)
+    assert kernel.metadata["specialization"]["noalias"] == [0]
+    # X is only read, through the non-coherent cache; Y is also written
+    ptx = kernel.asm["ptx"]
+    assert ptx.count("ld.global.nc") == 1
+    assert ptx.count("ld.global") == 2
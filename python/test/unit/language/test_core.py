@@ -95,7 +95,7 @@ def to_numpy(x):
 
 
 def patch_kernel(template, to_replace):
-    kernel = triton.JITFunction(template.fn)
+    kernel = triton.JITFunction(template.fn, fast_math=template.fast_math)
     for key, value in to_replace.items():
         kernel.src = kernel.src.replace(key, value)
     return kernel
@@ -447,6 +447,57 @@ def test_where_broadcast():
     z = np.where(0, x, 0)
     assert (z == to_numpy(z_tri)).all()
 
+
+@pytest.mark.parametrize("M, N, dim", [(32, 64, 0), (32, 64, 1), (4, 8, 1)])
+def test_cat_ordered(M, N, dim):
+    @triton.jit
+    def kernel(X, Y, Z, M: tl.constexpr, N: tl.constexpr, DIM: tl.constexpr):
+        off_m = tl.arange(0, M)[:, None]
+        off_n = tl.arange(0, N)[None, :]
+        x = tl.load(X + off_m * N + off_n)
+        y = tl.load(Y + off_m * N + off_n)
+        z = tl.cat(x, y, dim=DIM)
+        if DIM == 0:
+            off_zm = tl.arange(0, 2 * M)[:, None]
+            tl.store(Z + off_zm * N + off_n, z)
+        else:
+            off_zn = tl.arange(0, 2 * N)[None, :]
+            tl.store(Z + off_m * 2 * N + off_zn, z)
+
+    rs = RandomState(17)
+    x = numpy_random((M, N), dtype_str='float32', rs=rs)
+    y = numpy_random((M, N), dtype_str='float32', rs=rs)
+    z = np.concatenate([x, y], axis=dim)
+    z_tri = to_triton(np.empty_like(z), device='cuda')
+    kernel[(1,)](to_triton(x, device='cuda'), to_triton(y, device='cuda'), z_tri, M, N, dim)
+    np.testing.assert_equal(z, to_numpy(z_tri))
+
+
+def test_join_split():
+    SIZE = 128
+
+    @triton.jit
+    def kernel(X, Y, Z, A, B, SIZE: tl.constexpr):
+        off = tl.arange(0, SIZE)
+        x = tl.load(X + off)
+        y = tl.load(Y + off)
+        z = tl.join(x, y)
+        tl.store(Z + off[:, None] * 2 + tl.arange(0, 2)[None, :], z)
+        a, b = tl.split(z)
+        tl.store(A + off, a)
+        tl.store(B + off, b)
+
+    rs = RandomState(17)
+    x = numpy_random(SIZE, dtype_str='float32', rs=rs)
+    y = numpy_random(SIZE, dtype_str='float32', rs=rs)
+    z_tri = to_triton(np.empty((SIZE, 2), dtype=np.float32), device='cuda')
+    a_tri = to_triton(np.empty(SIZE, dtype=np.float32), device='cuda')
+    b_tri = to_triton(np.empty(SIZE, dtype=np.float32), device='cuda')
+    kernel[(1,)](to_triton(x, device='cuda'), to_triton(y, device='cuda'), z_tri, a_tri, b_tri, SIZE)
+    np.testing.assert_equal(np.stack([x, y], axis=-1), to_numpy(z_tri))
+    np.testing.assert_equal(x, to_numpy(a_tri))
+    np.testing.assert_equal(y, to_numpy(b_tri))
+
 # ---------------
 # test unary ops
 # ---------------
@@ -472,6 +523,39 @@ def test_math_op(expr, device='cuda'):
     _test_unary('float32', f'tl.{expr}(x)', f'np.{expr}(x) ', device=device)
 
 
+@pytest.mark.parametrize("expr, numpy_expr", [
+    ('tl.exp(x)', 'np.exp(x)'),
+    ('tl.log(x)', 'np.log(x)'),
+    ('tl.cos(x)', 'np.cos(x)'),
+    ('tl.sin(x)', 'np.sin(x)'),
+    ('tl.libdevice.rsqrt(x)', '1 / np.sqrt(x)'),
+    ('tl.libdevice.tanh(x)', 'np.tanh(x)'),
+    ('tl.sigmoid(x)', '1 / (1 + np.exp(-x))'),
+    ('tl.gelu(x)', '0.5 * x * (1 + np.tanh(np.sqrt(2 / np.pi) * (x + 0.044715 * x ** 3)))'),
+])
+def test_fast_math_op(expr, numpy_expr, device='cuda'):
+    SIZE = 128
+
+    @triton.jit(fast_math=True)
+    def kernel(Z, X, SIZE: tl.constexpr):
+        off = tl.arange(0, SIZE)
+        x = tl.load(X + off)
+        z = GENERATE_TEST_HERE
+        tl.store(Z + off, z)
+
+    kernel = patch_kernel(kernel, {'GENERATE_TEST_HERE': expr})
+    x = numpy_random(SIZE, dtype_str='float32')
+    if 'log' in expr or 'rsqrt' in expr:
+        x = np.abs(x) + 0.01
+    z_ref = eval(numpy_expr)
+    x_tri = to_triton(x, device=device)
+    z_tri = to_triton(np.empty_like(z_ref), device=device)
+    pgm = kernel[(1, )](z_tri, x_tri, SIZE=SIZE, num_warps=4)
+    np.testing.assert_allclose(z_ref, to_numpy(z_tri), rtol=0.01, atol=1e-5)
+    if torch.version.hip is None:
+        assert 'approx' in pgm.asm['ptx']
+
+
 # ----------------
 # test indexing
 # ----------------
@@ -680,6 +764,54 @@ def test_tensor_atomic_rmw(shape, axis, device="cuda"):
     np.testing.assert_allclose(z_ref, to_numpy(z_tri), rtol=1e-4)
 
 
+@pytest.mark.parametrize("n", [127, 255])
+def test_atomic_add_f16_masked(n, device='cuda'):
+    if torch.cuda.get_device_capability()[0] < 7:
+        pytest.skip("Only test atomic float16 ops on devices with sm >= 70")
+    # f16 adds are issued in pairs, which must not cross the end of the mask
+    @triton.jit
+    def kernel(Z, X, N, BLOCK: tl.constexpr):
+        offs = tl.arange(0, BLOCK)
+        mask = offs < N
+        tl.atomic_add(Z + offs, tl.load(X + offs, mask=mask), mask=mask)
+
+    rs = RandomState(17)
+    x = numpy_random((256, ), dtype_str='float16', rs=rs)
+    z_ref = np.where(np.arange(256) < n, x, 0).astype(np.float16)
+    x_tri = to_triton(x, device=device)
+    z_tri = to_triton(np.zeros((256, ), dtype=np.float16), device=device)
+    kernel[(1,)](z_tri, x_tri, n, BLOCK=256)
+    np.testing.assert_allclose(z_ref, to_numpy(z_tri), rtol=0.01)
+
+
+@pytest.mark.parametrize("dtype_str, num_bins", [(dtype_str, num_bins)
+                                                 for dtype_str in ['int32', 'float32', 'int64']
+                                                 for num_bins in [1, 7, 1024]])
+def test_atomic_add_aggregate(dtype_str, num_bins, device='cuda'):
+    @triton.jit
+    def kernel(Z, B, X, N, BLOCK: tl.constexpr):
+        offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        mask = offs < N
+        b = tl.load(B + offs, mask=mask)
+        x = tl.load(X + offs, mask=mask)
+        tl.atomic_add(Z + b, x, mask=mask, aggregate=True)
+
+    n = 4000
+    rs = RandomState(17)
+    bins = rs.randint(0, num_bins, size=(n, )).astype("int32")
+    x = numpy_random((n, ), dtype_str=dtype_str, rs=rs)
+    if dtype_str != 'float32':
+        x = x % 64
+    z_ref = np.zeros((num_bins, ), dtype=x.dtype)
+    np.add.at(z_ref, bins, x)
+    z_tri = to_triton(np.zeros((num_bins, ), dtype=x.dtype), device=device)
+    kernel[(triton.cdiv(n, 512),)](z_tri, to_triton(bins, device=device), to_triton(x, device=device), n, BLOCK=512)
+    if dtype_str == 'float32':
+        np.testing.assert_allclose(z_ref, to_numpy(z_tri), rtol=1e-3, atol=1e-3)
+    else:
+        np.testing.assert_equal(z_ref, to_numpy(z_tri))
+
+
 def test_atomic_cas():
     # 1. make sure that atomic_cas changes the original value (Lock)
     @triton.jit
@@ -710,6 +842,45 @@ def test_atomic_cas():
     triton.testing.assert_almost_equal(data, ref)
 
 
+@pytest.mark.parametrize("dtype_str, num_bins", [(dtype_str, num_bins)
+                                                 for dtype_str in ['int32', 'float32']
+                                                 for num_bins in [16, 256]])
+def test_scratch_histogram(dtype_str, num_bins, device='cuda'):
+    # each program accumulates its histogram with atomics in shared memory
+    @triton.jit
+    def kernel(Z, B, X, N, BLOCK: tl.constexpr, NUM_BINS: tl.constexpr):
+        bins = tl.arange(0, NUM_BINS)
+        H = tl.scratch(Z.dtype.element_ty, NUM_BINS)
+        tl.store(H + bins, tl.zeros((NUM_BINS,), dtype=Z.dtype.element_ty))
+        offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        mask = offs < N
+        b = tl.load(B + offs, mask=mask)
+        x = tl.load(X + offs, mask=mask)
+        tl.atomic_add(H + b, x, mask=mask)
+        tl.atomic_add(Z + bins, tl.load(H + bins))
+
+    n = 4000
+    rs = RandomState(17)
+    bins = rs.randint(0, num_bins, size=(n, )).astype("int32")
+    x = numpy_random((n, ), dtype_str=dtype_str, rs=rs)
+    if dtype_str != 'float32':
+        x = x % 64
+    z_ref = np.zeros((num_bins, ), dtype=x.dtype)
+    np.add.at(z_ref, bins, x)
+    z_tri = to_triton(np.zeros((num_bins, ), dtype=x.dtype), device=device)
+    pgm = kernel[(triton.cdiv(n, 512),)](z_tri, to_triton(bins, device=device), to_triton(x, device=device), n,
+                                         BLOCK=512, NUM_BINS=num_bins)
+    if torch.version.hip is None:
+        # shared memory is addressed with 32-bit registers
+        ptx = pgm.asm['ptx']
+        for instr in ['st.shared', 'ld.shared', 'atom.shared']:
+            assert re.search(instr + r"[.\w]* [^;]*\[ ?%r\d+", ptx), instr
+    if dtype_str == 'float32':
+        np.testing.assert_allclose(z_ref, to_numpy(z_tri), rtol=1e-3, atol=1e-3)
+    else:
+        np.testing.assert_equal(z_ref, to_numpy(z_tri))
+
+
 # ---------------
 # test cast
 # ---------------
@@ -879,6 +1050,47 @@ def test_f16_to_f8_rounding():
     ), f"f16_input[mismatch]={f16_input[mismatch]} f16_output[mismatch]={f16_output[mismatch]} abs_error[mismatch]={abs_error[mismatch]} min_error[mismatch]={min_error[mismatch]}"
 
 
+def decode_ocp_f8(bits, exp_bits):
+    """Reference decoding of E4M3 (exp_bits=4) and E5M2 (exp_bits=5) fp8 bits to float32"""
+    man_bits = 7 - exp_bits
+    bias = 2 ** (exp_bits - 1) - 1
+    bits = bits.astype(np.int32) & 0xFF
+    sign = np.where(bits & 0x80, -1.0, 1.0)
+    exp = (bits >> man_bits) & ((1 << exp_bits) - 1)
+    man = bits & ((1 << man_bits) - 1)
+    normal = (1 + man / 2 ** man_bits) * 2.0 ** (exp - bias)
+    subnormal = (man / 2 ** man_bits) * 2.0 ** (1 - bias)
+    return (sign * np.where(exp == 0, subnormal, normal)).astype(np.float32)
+
+
+@pytest.mark.parametrize("dtype_str, exp_bits", [('float8e4', 4), ('float8e5', 5)])
+def test_ocp_f8_roundtrip(dtype_str, exp_bits):
+    """Tests that E4M3 and E5M2 values are decoded exactly, and encoded back to the same bits"""
+    @triton.jit
+    def copy_kernel(input_ptr, output_ptr, n_elements, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(axis=0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        mask = offsets < n_elements
+        input = tl.load(input_ptr + offsets, mask=mask)
+        tl.store(output_ptr + offsets, input, mask=mask)
+
+    bits = np.arange(-128, 128, dtype=np.int8)
+    # skip NaNs and infinities
+    magnitude = bits.astype(np.int32) & 0x7F
+    bits = bits[magnitude < (0x7F if exp_bits == 4 else 0x7C)]
+    f8_tensor = torch.tensor(bits, device='cuda')
+    f8 = triton.reinterpret(f8_tensor, getattr(tl, dtype_str))
+    n_elements = f8_tensor.numel()
+    f32 = torch.empty_like(f8_tensor, dtype=torch.float32)
+    grid = lambda meta: (triton.cdiv(n_elements, meta['BLOCK_SIZE']),)
+    copy_kernel[grid](f8, f32, n_elements, BLOCK_SIZE=256)
+    np.testing.assert_array_equal(f32.cpu().numpy(), decode_ocp_f8(bits, exp_bits))
+
+    f8_output_tensor = torch.empty_like(f8_tensor)
+    f8_output = triton.reinterpret(f8_output_tensor, getattr(tl, dtype_str))
+    copy_kernel[grid](f32, f8_output, n_elements, BLOCK_SIZE=256)
+    assert torch.all(f8_tensor == f8_output_tensor)
+
+
 # ---------------
 # test reduce
 # ---------------
@@ -1024,6 +1236,127 @@ def test_reduce2d(op, dtype_str, shape, axis, device='cuda'):
         else:
             np.testing.assert_equal(z_ref, z_tri)
 
+
+@triton.jit
+def _welford_combine(mean_1, m2_1, weight_1, mean_2, m2_2, weight_2):
+    delta = mean_2 - mean_1
+    new_weight = weight_1 + weight_2
+    w2_over_w = weight_2 / new_weight
+    return (
+        mean_1 + delta * w2_over_w,
+        m2_1 + m2_2 + delta * delta * weight_1 * w2_over_w,
+        new_weight,
+    )
+
+
+@pytest.mark.parametrize("shape, axis",
+                         [(shape, axis) for shape in [(1, 128), (4, 64), (32, 32), (128, 16)]
+                          for axis in [0, 1]])
+def test_generic_reduce(shape, axis, device='cuda'):
+    # single-pass mean and variance
+    @triton.jit
+    def kernel(X, Mean, Var, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, AXIS: tl.constexpr):
+        range_m = tl.arange(0, BLOCK_M)
+        range_n = tl.arange(0, BLOCK_N)
+        x = tl.load(X + range_m[:, None] * BLOCK_N + range_n[None, :])
+        m2 = tl.zeros([BLOCK_M, BLOCK_N], dtype=tl.float32)
+        weight = m2 + 1.0
+        mean, m2, weight = tl.reduce((x, m2, weight), AXIS, _welford_combine)
+        if AXIS == 1:
+            tl.store(Mean + range_m, mean)
+            tl.store(Var + range_m, m2 / weight)
+        else:
+            tl.store(Mean + range_n, mean)
+            tl.store(Var + range_n, m2 / weight)
+
+    rs = RandomState(17)
+    x = numpy_random(shape, dtype_str='float32', rs=rs)
+    x_tri = to_triton(x, device=device)
+    mean_tri = torch.empty((shape[1 - axis],), dtype=torch.float32, device=device)
+    var_tri = torch.empty((shape[1 - axis],), dtype=torch.float32, device=device)
+    kernel[(1,)](x_tri, mean_tri, var_tri, BLOCK_M=shape[0], BLOCK_N=shape[1], AXIS=axis)
+    np.testing.assert_allclose(np.mean(x, axis=axis), to_numpy(mean_tri), rtol=1e-3, atol=1e-3)
+    np.testing.assert_allclose(np.var(x, axis=axis), to_numpy(var_tri), rtol=1e-3, atol=1e-3)
+
+@triton.jit
+def _sum_combine(a, b):
+    return a + b
+
+
+@pytest.mark.parametrize("shape, axis, reverse",
+                         [(shape, axis, reverse) for shape in [(1, 128), (4, 64), (32, 32), (128, 16), (256, 4)]
+                          for axis in [0, 1] for reverse in [False, True]])
+def test_associative_scan(shape, axis, reverse, device='cuda'):
+    @triton.jit
+    def kernel(X, Z, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, AXIS: tl.constexpr, REVERSE: tl.constexpr):
+        range_m = tl.arange(0, BLOCK_M)
+        range_n = tl.arange(0, BLOCK_N)
+        offs = range_m[:, None] * BLOCK_N + range_n[None, :]
+        x = tl.load(X + offs)
+        z = tl.associative_scan(x, AXIS, _sum_combine, REVERSE)
+        tl.store(Z + offs, z)
+
+    rs = RandomState(17)
+    x = numpy_random(shape, dtype_str='int32', rs=rs)
+    if reverse:
+        z_ref = np.flip(np.cumsum(np.flip(x, axis=axis), axis=axis), axis=axis)
+    else:
+        z_ref = np.cumsum(x, axis=axis)
+    x_tri = to_triton(x, device=device)
+    z_tri = to_triton(np.empty_like(x), device=device)
+    kernel[(1,)](x_tri, z_tri, BLOCK_M=shape[0], BLOCK_N=shape[1], AXIS=axis, REVERSE=reverse)
+    np.testing.assert_equal(z_ref.astype(np.int32), to_numpy(z_tri))
+
+
+# ---------------
+# test sort
+# ---------------
+
+
+@pytest.mark.parametrize("dtype_str, shape, axis, descending",
+                         [(dtype, shape, axis, descending)
+                          for dtype in ['int32', 'float16', 'float32', 'bfloat16']
+                          for shape in [(1, 128), (4, 64), (32, 32), (128, 16), (4, 1024)]
+                          for axis in [0, 1] for descending in [False, True]])
+def test_sort(dtype_str, shape, axis, descending, device='cuda'):
+    check_type_supported(dtype_str)
+
+    @triton.jit
+    def kernel(X, Z, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, AXIS: tl.constexpr,
+               DESCENDING: tl.constexpr):
+        offs = tl.arange(0, BLOCK_M)[:, None] * BLOCK_N + tl.arange(0, BLOCK_N)[None, :]
+        x = tl.load(X + offs)
+        tl.store(Z + offs, tl.sort(x, AXIS, DESCENDING))
+
+    rs = RandomState(17)
+    x = numpy_random(shape, dtype_str='float32' if dtype_str == 'bfloat16' else dtype_str, rs=rs)
+    x_tri = to_triton(x, device=device, dst_type=dtype_str)
+    z_tri = torch.empty_like(x_tri)
+    kernel[(1,)](x_tri, z_tri, BLOCK_M=shape[0], BLOCK_N=shape[1], AXIS=axis, DESCENDING=descending)
+    z_ref = torch.sort(x_tri, dim=axis, descending=descending).values
+    assert torch.equal(z_ref, z_tri)
+
+
+@pytest.mark.parametrize("shape, k", [((4, 64), 8), ((16, 128), 1), ((4, 1024), 32), ((2, 2048), 64)])
+def test_topk(shape, k, device='cuda'):
+    @triton.jit
+    def kernel(X, V, I, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, K: tl.constexpr):
+        rm = tl.arange(0, BLOCK_M)[:, None]
+        x = tl.load(X + rm * BLOCK_N + tl.arange(0, BLOCK_N)[None, :])
+        values, indices = tl.topk(x, K)
+        offs = rm * K + tl.arange(0, K)[None, :]
+        tl.store(V + offs, values)
+        tl.store(I + offs, indices)
+
+    x = torch.randn(shape, device=device, dtype=torch.float32)
+    values = torch.empty((shape[0], k), device=device, dtype=torch.float32)
+    indices = torch.empty((shape[0], k), device=device, dtype=torch.int32)
+    kernel[(1,)](x, values, indices, BLOCK_M=shape[0], BLOCK_N=shape[1], K=k)
+    ref = torch.topk(x, k, dim=1)
+    assert torch.equal(ref.values, values)
+    assert torch.equal(x.gather(1, indices.long()), values)
+
+
 # ---------------
 # test permute
 # ---------------
@@ -1253,6 +1586,100 @@ def test_dot_without_load(dtype_str):
     kernel[(1,)](out)
     assert torch.all(out == out_ref)
 
+
+@pytest.mark.parametrize("dtype_str, exp_bits", [('float8e4', 4), ('float8e5', 5)])
+def test_dot_fp8(dtype_str, exp_bits):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 8:
+        pytest.skip("Only test fp8 tl.dot() on devices with sm >= 80")
+    M, N, K = 64, 64, 64
+
+    @triton.jit
+    def kernel(X, Y, Z, scale, M: tl.constexpr, N: tl.constexpr, K: tl.constexpr):
+        off_m = tl.arange(0, M)
+        off_n = tl.arange(0, N)
+        off_k = tl.arange(0, K)
+        x = tl.load(X + off_m[:, None] * K + off_k[None, :])
+        y = tl.load(Y + off_k[:, None] * N + off_n[None, :])
+        z = tl.dot(x, y, input_scale=scale)
+        tl.store(Z + off_m[:, None] * N + off_n[None, :], z)
+
+    rs = RandomState(17)
+    # finite values of magnitude at most 2
+    x_bits = rs.randint(-0x40, 0x40, size=(M, K)).astype(np.int8)
+    y_bits = rs.randint(-0x40, 0x40, size=(K, N)).astype(np.int8)
+    x = triton.reinterpret(torch.tensor(x_bits, device='cuda'), getattr(tl, dtype_str))
+    y = triton.reinterpret(torch.tensor(y_bits, device='cuda'), getattr(tl, dtype_str))
+    z = torch.empty((M, N), dtype=torch.float32, device='cuda')
+    pgm = kernel[(1,)](x, y, z, 0.5, M, N, K)
+    z_ref = 0.5 * np.matmul(decode_ocp_f8(x_bits, exp_bits), decode_ocp_f8(y_bits, exp_bits))
+    np.testing.assert_allclose(z.cpu().numpy(), z_ref, rtol=1e-5, atol=1e-5)
+    ptx = pgm.asm['ptx']
+    # the fp8 mma of sm_89 needs PTX ISA 8.4, and the operands are converted
+    # to f16 otherwise
+    ptx_version = tuple(int(v) for v in re.search(r"^\.version (\d+)\.(\d+)", ptx, re.MULTILINE).groups())
+    fmt = {4: 'e4m3', 5: 'e5m2'}[exp_bits]
+    fp8_mma = f'mma.sync.aligned.m16n8k32.row.col.f32.{fmt}.{fmt}.f32'
+    if capability >= (8, 9) and ptx_version >= (8, 4):
+        assert fp8_mma in ptx
+    else:
+        assert fp8_mma not in ptx
+        if capability[0] == 8:
+            assert 'mma.sync.aligned.m16n8k16.row.col.f32.f16.f16.f32' in ptx
+
+
+@pytest.mark.parametrize("precision", ['tf32', 'tf32x3'])
+def test_dot_precision(precision):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 8:
+        pytest.skip("Only test tf32 on devices with sm >= 80")
+    M, N, K = 64, 64, 64
+
+    @triton.jit
+    def kernel(X, Y, Z, M: tl.constexpr, N: tl.constexpr, K: tl.constexpr, PRECISION: tl.constexpr):
+        off_m = tl.arange(0, M)
+        off_n = tl.arange(0, N)
+        off_k = tl.arange(0, K)
+        x = tl.load(X + off_m[:, None] * K + off_k[None, :])
+        y = tl.load(Y + off_k[:, None] * N + off_n[None, :])
+        z = tl.dot(x, y, precision=PRECISION)
+        tl.store(Z + off_m[:, None] * N + off_n[None, :], z)
+
+    rs = RandomState(17)
+    x = rs.randn(M, K).astype(np.float32)
+    y = rs.randn(K, N).astype(np.float32)
+    z = torch.empty((M, N), dtype=torch.float32, device='cuda')
+    pgm = kernel[(1,)](torch.tensor(x, device='cuda'), torch.tensor(y, device='cuda'), z, M, N, K, precision)
+    z_ref = np.matmul(x.astype(np.float64), y.astype(np.float64))
+    assert 'mma.sync.aligned.m16n8k8.row.col.f32.tf32.tf32.f32' in pgm.asm['ptx']
+    # tf32 keeps 10 bits of mantissa, tf32x3 about as many as fp32
+    tol = 1e-1 if precision == 'tf32' else 1e-4
+    np.testing.assert_allclose(z.cpu().numpy(), z_ref, rtol=tol, atol=tol)
+
+
+@pytest.mark.parametrize("B, num_warps", [(2, 4), (4, 4), (8, 4)])
+def test_dot_batched(B, num_warps):
+    M, N, K = 32, 32, 32
+
+    @triton.jit
+    def kernel(X, Y, Z, B: tl.constexpr, M: tl.constexpr, N: tl.constexpr, K: tl.constexpr):
+        off_b = tl.arange(0, B)[:, None, None]
+        off_m = tl.arange(0, M)[None, :, None]
+        off_n = tl.arange(0, N)[None, None, :]
+        off_k = tl.arange(0, K)
+        x = tl.load(X + off_b * M * K + off_m * K + off_k[None, None, :])
+        y = tl.load(Y + off_b * K * N + off_k[None, :, None] * N + off_n)
+        z = tl.dot(x, y, allow_tf32=False)
+        tl.store(Z + off_b * M * N + off_m * N + off_n, z)
+
+    rs = RandomState(17)
+    x = rs.randn(B, M, K).astype(np.float32)
+    y = rs.randn(B, K, N).astype(np.float32)
+    z = torch.empty((B, M, N), dtype=torch.float32, device='cuda')
+    kernel[(1,)](torch.tensor(x, device='cuda'), torch.tensor(y, device='cuda'), z,
+                 B, M, N, K, num_warps=num_warps)
+    np.testing.assert_allclose(z.cpu().numpy(), np.matmul(x, y), rtol=1e-4, atol=1e-4)
+
 # ---------------
 # test arange
 # ---------------
@@ -1361,6 +1788,125 @@ def test_masked_load_shared_memory(dtype, device='cuda'):
     triton.testing.allclose(out, reference_out)
 
 
+def test_grid_barrier():
+    @triton.jit
+    def kernel(X, Partial, Z, n_iters, NUM_PROGRAMS: tl.constexpr, BLOCK: tl.constexpr):
+        pid = tl.program_id(0)
+        offs = pid * BLOCK + tl.arange(0, BLOCK)
+        x = tl.load(X + offs)
+        # every program reads the partial sums of all the others, several times
+        # to check that the barrier can be reused
+        for i in range(n_iters):
+            tl.store(Partial + pid, tl.sum(x, axis=0))
+            tl.grid_barrier()
+            total = tl.sum(tl.load(Partial + tl.arange(0, NUM_PROGRAMS)), axis=0)
+            tl.grid_barrier()
+            x = x + total
+        tl.store(Z + offs, x)
+
+    num_programs, block = 16, 128
+    x = torch.randint(0, 4, (num_programs * block,), device='cuda', dtype=torch.int32)
+    partial = torch.empty((num_programs,), device='cuda', dtype=torch.int32)
+    z = torch.empty_like(x)
+    kernel[(num_programs,)](x, partial, z, 2, NUM_PROGRAMS=num_programs, BLOCK=block)
+    z_ref = x.cpu().clone()
+    for _ in range(2):
+        z_ref += z_ref.sum()
+    assert torch.equal(z.cpu(), z_ref)
+
+
+def test_thread_block_cluster():
+    @triton.jit
+    def kernel(A, B, C, K, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr):
+        # the programs of a cluster share pid_m, and so the tiles of A
+        pid_n = tl.program_id(0)
+        pid_m = tl.program_id(1)
+        rm = pid_m * BLOCK_M + tl.arange(0, BLOCK_M)
+        rn = pid_n * BLOCK_N + tl.arange(0, BLOCK_N)
+        rk = tl.arange(0, BLOCK_K)
+        a_ptrs = A + rm[:, None] * K + rk[None, :]
+        b_ptrs = B + rk[:, None] * (BLOCK_N * tl.num_programs(0)) + rn[None, :]
+        acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=tl.float32)
+        for k in range(0, K, BLOCK_K):
+            acc += tl.dot(tl.load(a_ptrs), tl.load(b_ptrs))
+            a_ptrs += BLOCK_K
+            b_ptrs += BLOCK_K * BLOCK_N * tl.num_programs(0)
+        tl.store(C + rm[:, None] * (BLOCK_N * tl.num_programs(0)) + rn[None, :], acc.to(tl.float16))
+
+    M, N, K = 256, 256, 256
+    a = torch.randn((M, K), device='cuda', dtype=torch.float16)
+    b = torch.randn((K, N), device='cuda', dtype=torch.float16)
+    c = torch.empty((M, N), device='cuda', dtype=torch.float16)
+    grid = (N // 64, M // 64)
+    # clusters are CUDA only: gfx90a and gfx94x also report a major of 9
+    if torch.version.hip is not None or torch.cuda.get_device_capability()[0] < 9:
+        with pytest.raises(ValueError):
+            kernel[grid](a, b, c, K, BLOCK_M=64, BLOCK_N=64, BLOCK_K=32, num_ctas=2)
+        return
+    pgm = kernel[grid](a, b, c, K, BLOCK_M=64, BLOCK_N=64, BLOCK_K=32, num_ctas=2)
+    assert "cluster = 2" in pgm.asm["ttgir"]
+    torch.testing.assert_close(c, torch.matmul(a, b), atol=1e-1, rtol=1e-2)
+    # the cache hit and launch_many pass num_ctas to the launcher as well
+    for launch in range(2):
+        c.zero_()
+        if launch == 0:
+            kernel[grid](a, b, c, K, BLOCK_M=64, BLOCK_N=64, BLOCK_K=32, num_ctas=2)
+        else:
+            triton.launch_many([(pgm, grid, (a, b, c, K))])
+        torch.testing.assert_close(c, torch.matmul(a, b), atol=1e-1, rtol=1e-2)
+
+
+def test_profile_region():
+    @triton.jit
+    def kernel(X, Z, n_iters, BLOCK: tl.constexpr):
+        offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        x = tl.load(X + offs)
+        tl.profile_region("main_loop")
+        for i in range(n_iters):
+            x = tl.sqrt(x * x + 1.)
+        tl.profile_region("epilogue")
+        tl.store(Z + offs, x)
+
+    num_programs, block = 8, 128
+    x = torch.randn((num_programs * block,), device='cuda')
+    z = torch.empty_like(x)
+    kernel[(num_programs,)](x, z, 1000, BLOCK=block)
+    pgm = kernel[(num_programs,)](x, z, 1000, BLOCK=block)
+    assert pgm.profile_regions == ["main_loop", "epilogue"]
+    report = pgm.profile_report()
+    assert list(report.keys()) == ["prologue", "main_loop", "epilogue"]
+    assert all(region["cycles"] > 0 for region in report.values())
+    assert report["main_loop"]["cycles"] > report["epilogue"]["cycles"]
+    assert report["main_loop"]["per_program"] == report["main_loop"]["cycles"] / (2 * num_programs)
+    assert sum(region["fraction"] for region in report.values()) == pytest.approx(1.)
+    pgm.profile_reset()
+    assert all(region["cycles"] == 0 for region in pgm.profile_report().values())
+
+
+def test_trace():
+    @triton.jit
+    def kernel(X, n, BLOCK: tl.constexpr):
+        x = tl.load(X + tl.program_id(0) * BLOCK + tl.arange(0, BLOCK))
+        tl.trace("n", n)
+        tl.trace("x", x)
+
+    num_programs, block = 2, 128
+    x = torch.randn((num_programs * block,), device='cuda')
+    pgm = kernel[(num_programs,)](x, 7, BLOCK=block)
+    records = pgm.trace_records()
+    scalars = [record for record in records if record["prefix"] == "n"]
+    assert sorted(record["program"] for record in scalars) == list(range(num_programs))
+    assert all(record["thread"] == 0 and record["values"] == [7] for record in scalars)
+    for program in range(num_programs):
+        elements = dict()
+        for record in records:
+            if record["prefix"] == "x" and record["program"] == program:
+                elements.update(record["values"][0])
+        assert [elements[(i,)] for i in range(block)] == x[program * block:(program + 1) * block].tolist()
+    pgm.trace_reset()
+    assert pgm.trace_records() == []
+
+
 @pytest.mark.parametrize("cache", ["", ".ca", ".cg"])
 def test_load_cache_modifier(cache):
     src = torch.empty(128, device='cuda')
@@ -1385,6 +1931,118 @@ def test_load_cache_modifier(cache):
         assert 'ld.global.cg' not in ptx
 
 
+@pytest.mark.parametrize("fraction", [None, 0.5, 1.0])
+def test_load_l2_evict_last_fraction(fraction):
+    src = torch.empty(128, device='cuda')
+    dst = torch.empty(128, device='cuda')
+
+    @triton.jit
+    def _kernel(dst, src, FRACTION: tl.constexpr):
+        offsets = tl.arange(0, 128)
+        x = tl.load(src + offsets, l2_evict_last_fraction=FRACTION)
+        tl.store(dst + offsets, x)
+
+    pgm = _kernel[(1,)](dst, src, FRACTION=fraction)
+    ptx = pgm.asm['ptx']
+    if fraction is None:
+        assert 'createpolicy' not in ptx
+        assert 'L2::cache_hint' not in ptx
+    else:
+        assert 'createpolicy.fractional.L2::evict_last' in ptx
+        assert 'ld.global.L2::cache_hint' in ptx
+
+
+@pytest.mark.parametrize("cache, eviction", [("", ""), (".cg", ""), (".cs", ""), (".wt", ""),
+                                             ("", "evict_first"), ("", "evict_last")])
+def test_store_cache_modifier(cache, eviction):
+    src = torch.empty(128, device='cuda')
+    dst = torch.empty(128, device='cuda')
+
+    @triton.jit
+    def _kernel(dst, src, CACHE: tl.constexpr, EVICTION: tl.constexpr):
+        offsets = tl.arange(0, 128)
+        x = tl.load(src + offsets)
+        tl.store(dst + offsets, x, cache_modifier=CACHE, eviction_policy=EVICTION)
+
+    pgm = _kernel[(1,)](dst, src, CACHE=cache, EVICTION=eviction)
+    ptx = pgm.asm['ptx']
+    for modifier in [".cg", ".cs", ".wt"]:
+        assert (f'st.global{modifier}' in ptx) == (modifier == cache)
+    for policy in ["evict_first", "evict_last"]:
+        assert (f'L1::{policy}' in ptx) == (policy == eviction)
+
+
+@pytest.mark.parametrize("dtype_str, padding_option, boundary_check",
+                         [(dtype_str, padding_option, boundary_check)
+                          for dtype_str in ["float16", "float32", "int32"]
+                          for padding_option in ["zero", "nan"]
+                          for boundary_check in [(0, ), (1, ), (0, 1)]
+                          if padding_option == "zero" or dtype_str != "int32"])
+def test_block_ptr_load_store(dtype_str, padding_option, boundary_check, device='cuda'):
+    BLOCK_M, BLOCK_N = 32, 64
+    # the blocks out of bounds along the unchecked dimensions would be loaded
+    # out of bounds
+    M = 50 if 0 in boundary_check else 64
+    N = 70 if 1 in boundary_check else 128
+    src = to_triton(numpy_random((M, N), dtype_str=dtype_str), device=device)
+    dst = torch.zeros((M, N), device=device, dtype=src.dtype)
+    out = torch.zeros((triton.cdiv(M, BLOCK_M) * BLOCK_M, triton.cdiv(N, BLOCK_N) * BLOCK_N),
+                      device=device, dtype=src.dtype)
+
+    @triton.jit
+    def _kernel(src, dst, out, M, N, stride_m, stride_out,
+                BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr,
+                PADDING: tl.constexpr, CHECK: tl.constexpr):
+        offs_m = tl.program_id(0) * BLOCK_M
+        offs_n = tl.program_id(1) * BLOCK_N
+        src_ptr = tl.make_block_ptr(src, (M, N), (stride_m, 1), (offs_m, offs_n), (BLOCK_M, BLOCK_N), (1, 0))
+        x = tl.load(src_ptr, boundary_check=CHECK, padding_option=PADDING)
+        dst_ptr = tl.make_block_ptr(dst, (M, N), (stride_m, 1), (offs_m, offs_n), (BLOCK_M, BLOCK_N), (1, 0))
+        tl.store(dst_ptr, x, boundary_check=(0, 1))
+        # the whole block, padding included
+        out_ptr = tl.make_block_ptr(out, (M, N), (stride_out, 1), (offs_m, offs_n), (BLOCK_M, BLOCK_N), (1, 0))
+        tl.store(out_ptr, x)
+
+    grid = (triton.cdiv(M, BLOCK_M), triton.cdiv(N, BLOCK_N))
+    _kernel[grid](src, dst, out, M, N, src.stride(0), out.stride(0),
+                  BLOCK_M=BLOCK_M, BLOCK_N=BLOCK_N, PADDING=padding_option, CHECK=boundary_check)
+    assert torch.equal(dst, src)
+    assert torch.equal(out[:M, :N], src)
+    padded = torch.ones(out.shape, device=device, dtype=torch.bool)
+    padded[:M, :N] = False
+    if padding_option == "zero":
+        assert torch.all(out[padded] == 0)
+    else:
+        assert torch.all(torch.isnan(out[padded]))
+
+
+def test_block_ptr_matmul(device='cuda'):
+    M, N, K = 64, 64, 256
+    BLOCK_K = 32
+    a = torch.randn((M, K), device=device, dtype=torch.float16)
+    b = torch.randn((K, N), device=device, dtype=torch.float16)
+    c = torch.empty((M, N), device=device, dtype=torch.float32)
+
+    @triton.jit
+    def _kernel(A, B, C, M, N, K, stride_am, stride_bk, stride_cm,
+                BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr):
+        a_ptr = tl.make_block_ptr(A, (M, K), (stride_am, 1), (0, 0), (BLOCK_M, BLOCK_K), (1, 0))
+        b_ptr = tl.make_block_ptr(B, (K, N), (stride_bk, 1), (0, 0), (BLOCK_K, BLOCK_N), (1, 0))
+        acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=tl.float32)
+        for k in range(0, K, BLOCK_K):
+            acc += tl.dot(tl.load(a_ptr), tl.load(b_ptr))
+            a_ptr = tl.advance(a_ptr, (0, BLOCK_K))
+            b_ptr = tl.advance(b_ptr, (BLOCK_K, 0))
+        c_ptr = tl.make_block_ptr(C, (M, N), (stride_cm, 1), (0, 0), (BLOCK_M, BLOCK_N), (1, 0))
+        tl.store(c_ptr, acc)
+
+    pgm = _kernel[(1,)](a, b, c, M, N, K, a.stride(0), b.stride(0), c.stride(0),
+                        BLOCK_M=M, BLOCK_N=N, BLOCK_K=BLOCK_K)
+    # the loop carries the offsets of the block pointers, not their pointers
+    assert 'tt.ptr<tensor' not in pgm.asm['ttir']
+    triton.testing.assert_almost_equal(c, torch.matmul(a.float(), b.float()))
+
+
 @pytest.mark.parametrize("N", [16, 10, 11, 1024])
 def test_vectorization(N):
     src = torch.empty(1024, device='cuda')
@@ -1403,6 +2061,38 @@ def test_vectorization(N):
         assert "ld.global.b32" in ptx
     # triton.testing.assert_almost_equal(dst, src[:N])
 
+
+def test_version_alignment():
+    src = torch.randn(1024 + 1, device='cuda')
+    dst = torch.zeros(1024 + 1, device='cuda')
+
+    @triton.jit(version_alignment=True)
+    def _kernel(dst, src, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets)
+        tl.store(dst + offsets, x)
+    # aligned and misaligned pointers share the same versioned binary
+    pgm = _kernel[(1,)](dst, src, BLOCK_SIZE=1024)
+    _kernel[(1,)](dst[1:], src[1:], BLOCK_SIZE=1024)
+    assert len(_kernel.cache[torch.cuda.current_device()]) == 1
+    assert "st.global.v4.b32" in pgm.asm["ptx"]
+    triton.testing.assert_almost_equal(dst[1:], src[1:])
+
+
+@pytest.mark.parametrize("pid_order, n0, n1", [(pid_order, n0, n1)
+                                                for pid_order in ["grouped", ("grouped", 3), "hilbert"]
+                                                for n0, n1 in [(8, 8), (7, 5), (1, 9)]])
+def test_pid_order(pid_order, n0, n1, device='cuda'):
+    @triton.jit
+    def _kernel(Out):
+        pid0 = tl.program_id(0)
+        pid1 = tl.program_id(1)
+        tl.store(Out + pid0 * tl.num_programs(1) + pid1, pid0 + pid1 * tl.num_programs(0))
+    out = torch.full((n0 * n1,), -1, dtype=torch.int32, device=device)
+    _kernel[(n0, n1)](out, pid_order=pid_order)
+    # every program of the grid still runs exactly once
+    assert sorted(out.tolist()) == list(range(n0 * n1))
+
 # ---------------
 # test store
 # ---------------
@@ -1849,6 +2539,26 @@ def test_while():
     assert out_i[0] == init_i[0] + 1
     assert out_j[0] == cut_off[0] + 1
 
+
+@pytest.mark.parametrize("num_chunks, factor", [(4, 2), (7, 3), (3, 4), (5, 1)])
+def test_unrolled_range(num_chunks, factor, device='cuda'):
+    @triton.jit
+    def kernel(X, Z, NUM_CHUNKS: tl.constexpr, FACTOR: tl.constexpr, BLOCK: tl.constexpr):
+        offs = tl.arange(0, BLOCK)
+        acc = tl.zeros((BLOCK,), dtype=tl.float32)
+        for i in tl.unrolled_range(0, NUM_CHUNKS, factor=FACTOR):
+            acc = acc * 0.5 + tl.load(X + i * BLOCK + offs)
+        tl.store(Z + offs, acc)
+
+    BLOCK = 128
+    x = torch.randn((num_chunks, BLOCK), device=device)
+    z = torch.empty(BLOCK, device=device)
+    kernel[(1,)](x, z, NUM_CHUNKS=num_chunks, FACTOR=factor, BLOCK=BLOCK)
+    ref = torch.zeros(BLOCK, device=device)
+    for i in range(num_chunks):
+        ref = ref * 0.5 + x[i]
+    assert torch.allclose(z, ref)
+
 # def test_for_if():
 
 #     @triton.jit
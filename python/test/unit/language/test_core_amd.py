@@ -1051,6 +1051,103 @@ def test_reduce2d(op, dtype_str, shape, axis, device='cuda'):
             np.testing.assert_equal(z_ref, z_tri)
 
 
+# ---------------
+# test dot
+# ---------------
+
+
+@pytest.mark.parametrize("M, N, K, num_warps, col_a, col_b, dtype",
+                         [(M, N, K, num_warps, col_a, col_b, dtype)
+                          for M, N, K in [(32, 32, 16), (64, 64, 32), (128, 64, 64)]
+                          for num_warps in [2, 4, 8]
+                          for col_a in [True, False]
+                          for col_b in [True, False]
+                          for dtype in ['float16', 'float32', 'int8']])
+def test_dot(M, N, K, num_warps, col_a, col_b, dtype, device='cuda'):
+    @triton.jit
+    def kernel(X, stride_xm, stride_xk,
+               Y, stride_yk, stride_yn,
+               Z, stride_zm, stride_zn,
+               BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr):
+        off_m = tl.arange(0, BLOCK_M)
+        off_n = tl.arange(0, BLOCK_N)
+        off_k = tl.arange(0, BLOCK_K)
+        Xs = X + off_m[:, None] * stride_xm + off_k[None, :] * stride_xk
+        Ys = Y + off_k[:, None] * stride_yk + off_n[None, :] * stride_yn
+        Zs = Z + off_m[:, None] * stride_zm + off_n[None, :] * stride_zn
+        x = tl.load(Xs)
+        y = tl.load(Ys)
+        z = tl.dot(x, y, allow_tf32=False)
+        tl.store(Zs, z)
+    # input
+    rs = RandomState(17)
+    if col_a:
+        x = numpy_random((K, M), dtype_str=dtype, rs=rs).T
+    else:
+        x = numpy_random((M, K), dtype_str=dtype, rs=rs)
+    if col_b:
+        y = numpy_random((N, K), dtype_str=dtype, rs=rs).T
+    else:
+        y = numpy_random((K, N), dtype_str=dtype, rs=rs)
+    if dtype == 'int8':
+        x = x % 4
+        y = y % 4
+        z_dtype = 'int32'
+    else:
+        x = x * .1
+        y = y * .1
+        z_dtype = 'float32'
+    x_tri = to_triton(x, device=device)
+    y_tri = to_triton(y, device=device)
+    z = numpy_random((M, N), dtype_str=z_dtype, rs=rs)
+    z_tri = to_triton(z, device=device)
+    # run test
+    pgm = kernel[(1, 1)](x_tri, x_tri.stride(0), x_tri.stride(1),
+                         y_tri, y_tri.stride(0), y_tri.stride(1),
+                         z_tri, z_tri.stride(0), z_tri.stride(1),
+                         BLOCK_M=M, BLOCK_K=K, BLOCK_N=N,
+                         num_warps=num_warps)
+    # torch result
+    if dtype == 'int8':
+        z_ref = np.matmul(x.astype(np.int32), y.astype(np.int32))
+        np.testing.assert_equal(z_ref, to_numpy(z_tri))
+    else:
+        z_ref = np.matmul(x.astype(np.float32), y.astype(np.float32))
+        np.testing.assert_allclose(z_ref, to_numpy(z_tri), rtol=0.01, atol=1e-3)
+    # make sure the matrix cores are used
+    assert 'v_mfma' in pgm.asm['amdgcn']
+
+
+@pytest.mark.parametrize("num_stages", [1, 2, 3, 4])
+def test_dot_pipelined(num_stages, device='cuda'):
+    @triton.jit
+    def kernel(X, Y, Z, K,
+               BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr):
+        off_m = tl.arange(0, BLOCK_M)
+        off_n = tl.arange(0, BLOCK_N)
+        off_k = tl.arange(0, BLOCK_K)
+        Xs = X + off_m[:, None] * K + off_k[None, :]
+        Ys = Y + off_k[:, None] * BLOCK_N + off_n[None, :]
+        acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=tl.float32)
+        for k in range(0, K, BLOCK_K):
+            acc += tl.dot(tl.load(Xs), tl.load(Ys))
+            Xs += BLOCK_K
+            Ys += BLOCK_K * BLOCK_N
+        tl.store(Z + off_m[:, None] * BLOCK_N + off_n[None, :], acc)
+    M, N, K, BLOCK_K = 64, 64, 256, 32
+    rs = RandomState(17)
+    x = numpy_random((M, K), dtype_str='float16', rs=rs) * .1
+    y = numpy_random((K, N), dtype_str='float16', rs=rs) * .1
+    x_tri = to_triton(x, device=device)
+    y_tri = to_triton(y, device=device)
+    z_tri = to_triton(np.empty((M, N), dtype=np.float32), device=device)
+    kernel[(1, 1)](x_tri, y_tri, z_tri, K,
+                   BLOCK_M=M, BLOCK_N=N, BLOCK_K=BLOCK_K,
+                   num_warps=4, num_stages=num_stages)
+    z_ref = np.matmul(x.astype(np.float32), y.astype(np.float32))
+    np.testing.assert_allclose(z_ref, to_numpy(z_tri), rtol=0.01, atol=1e-3)
+
+
 # ---------------
 # test arange
 # ---------------
@@ -134,6 +134,27 @@ def test_randint(size, seed, device='cuda'):
     out_ref = [gen.random_raw()[0] for _ in out_tri]
     assert out_tri == out_ref
 
+
+# test the four outputs of the philox op
+
+
+@pytest.mark.parametrize('seed', [0, 42, 0xffffffff, 0xdeadbeefcafeb0ba])
+def test_randint4x(seed, device='cuda'):
+    @triton.jit
+    def kernel(X, seed):
+        offset = tl.arange(0, BLOCK)
+        r0, r1, r2, r3 = tl.randint4x(seed, offset)
+        tl.store(X + 4 * offset + 0, r0)
+        tl.store(X + 4 * offset + 1, r1)
+        tl.store(X + 4 * offset + 2, r2)
+        tl.store(X + 4 * offset + 3, r3)
+    x = torch.empty((BLOCK, 4), dtype=torch.int32, device=device)
+    kernel[(1,)](x, seed)
+    out_tri = x.cpu().numpy().astype(np.uint32).tolist()
+    gen = CustomPhilox4x(seed, config=PHILOX_32)
+    out_ref = [gen.random_raw().tolist() for _ in out_tri]
+    assert out_tri == out_ref
+
 # test uniform PRNG
 
 
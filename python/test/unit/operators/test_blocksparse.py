@@ -190,3 +190,18 @@ def triton_attention(
     w = sparse_softmax(w, scale=scale, is_causal=True)
     a = sparse_dot_dsd_nn(w, value)
     return a
+
+
+def test_lut_cache(BLOCK=32, H=2, M=256, N=256):
+    torch.manual_seed(0)
+    layout = torch.randint(2, (H, M // BLOCK, N // BLOCK), device="cuda")
+    sdd = triton.ops.blocksparse.matmul(layout, BLOCK, "sdd", device="cuda")
+    # an equal layout shares the look-up tables of the ops built from it
+    dsd = triton.ops.blocksparse.matmul(layout.clone(), BLOCK, "dsd", device="cuda")
+    assert dsd.c_lut is sdd.da_lut
+    assert dsd.da_lut is sdd.c_lut
+    softmax = triton.ops.blocksparse.softmax(layout, BLOCK, device="cuda")
+    assert triton.ops.blocksparse.softmax(layout.cpu(), BLOCK, device="cuda").lut is softmax.lut
+    # a different one does not
+    layout[0, 0, 0] = 1 - layout[0, 0, 0]
+    assert triton.ops.blocksparse.matmul(layout, BLOCK, "sdd", device="cuda").c_lut is not sdd.c_lut
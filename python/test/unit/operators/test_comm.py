@@ -0,0 +1,45 @@
+import pytest
+import torch
+
+import triton
+
+
+@pytest.mark.parametrize('world', [1, 2])
+def test_all_gather_matmul(world):
+    if torch.cuda.device_count() < world:
+        pytest.skip(f"requires {world} GPUs")
+    torch.manual_seed(0)
+    M, N, K = 192, 160, 96
+    heap = triton.ops.SymmetricHeap(1 << 24, devices=range(world))
+    a = heap.empty((M, K), torch.float16)
+    shards = [torch.randn((M, K), dtype=torch.float16) for _ in range(world)]
+    for tensor, shard in zip(a, shards):
+        tensor.copy_(shard)
+    b = torch.randn((K, N), dtype=torch.float16)
+    bs = [b.to(f'cuda:{device}') for device in heap.devices]
+    ref = (torch.cat(shards).cuda().float() @ b.cuda().float()).half()
+    # twice, through the same shards
+    for _ in range(2):
+        outputs = triton.ops.all_gather_matmul(heap, a, bs)
+        for c in outputs:
+            torch.testing.assert_close(c.cpu(), ref.cpu(), atol=1e-1, rtol=1e-2)
+
+
+@pytest.mark.parametrize('world', [1, 2])
+def test_matmul_reduce_scatter(world):
+    if torch.cuda.device_count() < world:
+        pytest.skip(f"requires {world} GPUs")
+    torch.manual_seed(0)
+    M, N, K = 256, 160, 96
+    heap = triton.ops.SymmetricHeap(1 << 24, devices=range(world))
+    a = [torch.randn((M, K), dtype=torch.float16) for _ in range(world)]
+    b = [torch.randn((K, N), dtype=torch.float16) for _ in range(world)]
+    ref = sum(x.cuda().float() @ y.cuda().float() for x, y in zip(a, b))
+    a_dev = [x.to(f'cuda:{device}') for x, device in zip(a, heap.devices)]
+    b_dev = [y.to(f'cuda:{device}') for y, device in zip(b, heap.devices)]
+    out = None
+    for _ in range(2):
+        out = triton.ops.matmul_reduce_scatter(heap, a_dev, b_dev, out=out)
+        for rank, c in enumerate(out):
+            rows = slice(rank * M // world, (rank + 1) * M // world)
+            torch.testing.assert_close(c.cpu(), ref[rows].cpu(), atol=1e-1, rtol=1e-2)
@@ -36,3 +36,40 @@ def test_op(M, N, dtype, mode):
         th_y.backward(dy)
         th_dx = x.grad.clone()
         triton.testing.assert_almost_equal(th_dx, tt_dx)
+
+
+@pytest.mark.parametrize("M, N, label_smoothing", [(512, 857, 0.), (512, 857, 0.1), (128, 131072, 0.1)])
+def test_smoothing_ignore_index(M, N, label_smoothing, dtype=torch.float32):
+    torch.manual_seed(0)
+    x = torch.randn(M, N, dtype=dtype, device='cuda', requires_grad=True)
+    idx = torch.randint(N, (M,), dtype=torch.int64, device='cuda')
+    idx[::7] = -100
+    tt_y = triton.ops.cross_entropy(x, idx, label_smoothing=label_smoothing, ignore_index=-100)
+    th_y = torch.nn.CrossEntropyLoss(reduction="none", label_smoothing=label_smoothing, ignore_index=-100)(x, idx)
+    triton.testing.assert_almost_equal(th_y, tt_y)
+    dy = torch.randn_like(tt_y)
+    tt_y.backward(dy)
+    tt_dx = x.grad.clone()
+    x.grad.zero_()
+    th_y.backward(dy)
+    triton.testing.assert_almost_equal(x.grad, tt_dx)
+
+
+@pytest.mark.parametrize("M, N, K, label_smoothing", [(1000, 5003, 256, 0.), (256, 32000, 128, 0.1)])
+def test_linear(M, N, K, label_smoothing, dtype=torch.float16):
+    torch.manual_seed(0)
+    x = torch.randn(M, K, dtype=dtype, device='cuda').mul_(0.1).requires_grad_()
+    w = torch.randn(N, K, dtype=dtype, device='cuda').mul_(0.1).requires_grad_()
+    idx = torch.randint(N, (M,), dtype=torch.int64, device='cuda')
+    idx[::5] = -100
+    tt_y = triton.ops.linear_cross_entropy(x, w, idx, label_smoothing=label_smoothing)
+    th_y = torch.nn.CrossEntropyLoss(reduction="none", label_smoothing=label_smoothing)(
+        torch.matmul(x.float(), w.float().t()), idx)
+    triton.testing.assert_almost_equal(th_y, tt_y.float())
+    dy = torch.randn_like(th_y)
+    tt_y.backward(dy.to(dtype))
+    tt_dx, tt_dw = x.grad.clone(), w.grad.clone()
+    x.grad, w.grad = None, None
+    th_y.backward(dy)
+    triton.testing.assert_almost_equal(x.grad, tt_dx)
+    triton.testing.assert_almost_equal(w.grad, tt_dw)
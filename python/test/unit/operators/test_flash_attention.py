@@ -41,3 +41,71 @@ def test_op(Z, H, N_CTX, D_HEAD, dtype=torch.float16):
     triton.testing.assert_almost_equal(ref_dv, tri_dv)
     triton.testing.assert_almost_equal(ref_dk, tri_dk)
     triton.testing.assert_almost_equal(ref_dq, tri_dq)
+
+
+def _reference(q, k, v, sm_scale, causal):
+    # q, k, v of shape (H, N_CTX, D_HEAD)
+    p = torch.matmul(q.float(), k.float().transpose(-1, -2)) * sm_scale
+    if causal:
+        M = torch.tril(torch.ones((q.shape[-2], k.shape[-2]), device="cuda"))
+        p[..., M == 0] = float("-inf")
+    p = torch.softmax(p, dim=-1).to(q.dtype)
+    return torch.matmul(p, v)
+
+
+def _check_grads(q, k, v, out, ref_out, dout):
+    ref_out.backward(dout)
+    ref_grads = [x.grad.clone() for x in (q, k, v)]
+    for x in (q, k, v):
+        x.grad = None
+    out.backward(dout)
+    for ref, tri in zip(ref_grads, [x.grad for x in (q, k, v)]):
+        triton.testing.assert_almost_equal(ref, tri, decimal=1)
+
+
+@pytest.mark.parametrize('Z, H, N_CTX, D_HEAD, causal', [(2, 4, 1000, 64, False), (2, 4, 333, 32, True),
+                                                         (1, 2, 256, 128, False)])
+def test_op_unaligned(Z, H, N_CTX, D_HEAD, causal, dtype=torch.float16):
+    torch.manual_seed(20)
+    q, k, v = [torch.empty((Z, H, N_CTX, D_HEAD), dtype=dtype, device="cuda").normal_(mean=0.1, std=0.2).requires_grad_()
+               for _ in range(3)]
+    sm_scale = D_HEAD ** -0.5
+    dout = torch.randn_like(q)
+    ref_out = _reference(q, k, v, sm_scale, causal)
+    tri_out = triton.ops.attention(q, k, v, sm_scale, causal=causal)
+    triton.testing.assert_almost_equal(ref_out, tri_out)
+    _check_grads(q, k, v, tri_out, ref_out, dout)
+
+
+@pytest.mark.parametrize('causal', [False, True])
+def test_op_varlen(causal, H=4, D_HEAD=64, dtype=torch.float16):
+    torch.manual_seed(20)
+    seqlens = [17, 256, 1, 300, 64]
+    cu_seqlens = torch.tensor([0] + seqlens, device="cuda").cumsum(0).to(torch.int32)
+    total = sum(seqlens)
+    q, k, v = [torch.empty((total, H, D_HEAD), dtype=dtype, device="cuda").normal_(mean=0.1, std=0.2).requires_grad_()
+               for _ in range(3)]
+    sm_scale = D_HEAD ** -0.5
+    dout = torch.randn_like(q)
+    # each sequence on its own, of shape (H, N_CTX, D_HEAD)
+    ref_out = torch.cat([_reference(q[s:e].transpose(0, 1), k[s:e].transpose(0, 1), v[s:e].transpose(0, 1),
+                                    sm_scale, causal).transpose(0, 1)
+                         for s, e in zip(cu_seqlens[:-1].tolist(), cu_seqlens[1:].tolist())])
+    tri_out = triton.ops.varlen_attention(q, k, v, cu_seqlens, cu_seqlens, max(seqlens), max(seqlens),
+                                          sm_scale, causal=causal)
+    triton.testing.assert_almost_equal(ref_out, tri_out)
+    _check_grads(q, k, v, tri_out, ref_out, dout)
+
+
+@pytest.mark.parametrize('num_splits', [None, 1, 7])
+def test_decode(num_splits, Z=3, H=8, N_Q=1, N_CTX=2048, D_HEAD=64, dtype=torch.float16):
+    torch.manual_seed(20)
+    q = torch.randn((Z, H, N_Q, D_HEAD), dtype=dtype, device="cuda")
+    k = torch.randn((Z, H, N_CTX, D_HEAD), dtype=dtype, device="cuda")
+    v = torch.randn((Z, H, N_CTX, D_HEAD), dtype=dtype, device="cuda")
+    seqlens_k = torch.tensor([N_CTX, 1000, 5], dtype=torch.int32, device="cuda")
+    sm_scale = D_HEAD ** -0.5
+    tri_out = triton.ops.decode_attention(q, k, v, sm_scale, seqlens_k=seqlens_k, num_splits=num_splits)
+    for z, n in enumerate(seqlens_k.tolist()):
+        ref_out = _reference(q[z], k[z, :, :n], v[z, :, :n], sm_scale, False)
+        triton.testing.assert_almost_equal(ref_out, tri_out[z])
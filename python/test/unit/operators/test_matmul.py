@@ -96,3 +96,138 @@ def test_op(BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, NWARP, NSTAGE, M, N, K, AT, BT,
     th_c = torch.matmul(a, b)
     tt_c = triton.testing.catch_oor(lambda: triton.ops.matmul(a, b), pytest)
     triton.testing.assert_almost_equal(th_c, tt_c)
+
+
+@pytest.mark.parametrize(
+    "BLOCK_M, BLOCK_N, BLOCK_K, NWARP, NSTAGE, M, N, K, DTYPE",
+    [
+        (64, 64, 32, 4, 2, 64, 64, 64, DTYPE) for DTYPE in ["float16", "float32"]
+    ] + [
+        (64, 64, 32, 4, 3, 1024, 1024, 256, DTYPE) for DTYPE in ["float16", "float32"]
+    ] + [
+        (128, 64, 32, 4, 2, 107, 233, 311, DTYPE) for DTYPE in ["float16", "float32"]
+    ] + [
+        (32, 32, 64, 2, 4, 4096, 96, 128, DTYPE) for DTYPE in ["float16", "float32"]
+    ],
+)
+def test_op_persistent(BLOCK_M, BLOCK_N, BLOCK_K, NWARP, NSTAGE, M, N, K, DTYPE):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 7:
+        pytest.skip("Only test tl.dot() on devices with sm >= 70")
+    torch.manual_seed(0)
+    kwargs = {'BLOCK_M': BLOCK_M, 'BLOCK_N': BLOCK_N, 'BLOCK_K': BLOCK_K, 'GROUP_M': 8}
+    kernel = triton.ops._matmul.persistent_kernel
+    kernel.configs = [triton.Config(kwargs=kwargs, num_warps=NWARP, num_stages=NSTAGE)]
+    DTYPE = {"float16": torch.float16, "float32": torch.float32}[DTYPE]
+    a = .1 * torch.randn((M, K), device="cuda", dtype=DTYPE)
+    b = .1 * torch.randn((K, N), device="cuda", dtype=DTYPE)
+    th_c = torch.matmul(a, b)
+    tt_c = triton.testing.catch_oor(lambda: triton.ops.matmul(a, b, True), pytest)
+    triton.testing.assert_almost_equal(th_c, tt_c)
+
+
+@pytest.mark.parametrize(
+    "BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, NWARP, NSTAGE, M, N, K, DTYPE",
+    [
+        (64, 64, 16, SPLIT_K, 4, 2, 1024, 1024, 1024, DTYPE)
+        for SPLIT_K in [2, 4, 8] for DTYPE in ["float16", "bfloat16", "float32"]
+    ] + [
+        (128, 128, 32, 4, 4, 2, 107, 233, 311, DTYPE) for DTYPE in ["float16", "float32"]
+    ],
+)
+def test_op_deterministic_split_k(BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, NWARP, NSTAGE, M, N, K, DTYPE):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 7:
+        pytest.skip("Only test tl.dot() on devices with sm >= 70")
+    if capability[0] < 8 and DTYPE == "bfloat16":
+        pytest.skip("Only test bfloat16 on devices with sm >= 80")
+    torch.manual_seed(0)
+    kwargs = {'BLOCK_M': BLOCK_M, 'BLOCK_N': BLOCK_N, 'BLOCK_K': BLOCK_K, 'SPLIT_K': SPLIT_K}
+    kernel = triton.ops._matmul.kernel
+    kernel.configs = [triton.Config(kwargs=kwargs, num_warps=NWARP, num_stages=NSTAGE)]
+    DTYPE = {"float16": torch.float16, "bfloat16": torch.bfloat16, "float32": torch.float32}[DTYPE]
+    a = .1 * torch.randn((M, K), device="cuda", dtype=DTYPE)
+    b = .1 * torch.randn((K, N), device="cuda", dtype=DTYPE)
+    th_c = torch.matmul(a, b)
+    tt_c = triton.testing.catch_oor(lambda: triton.ops.matmul(a, b, False, True), pytest)
+    triton.testing.assert_almost_equal(th_c, tt_c)
+    # the partial tiles are always reduced in the same order
+    for _ in range(4):
+        assert torch.equal(tt_c, triton.ops.matmul(a, b, False, True))
+
+
+@pytest.mark.parametrize(
+    "BLOCK_M, BLOCK_N, BLOCK_K, NWARP, NSTAGE, MS, N, K, DTYPE",
+    [
+        (64, 64, 32, 4, 3, [256, 17, 0, 1000, 64], 512, 256, DTYPE) for DTYPE in ["float16", "float32"]
+    ] + [
+        (32, 64, 64, 2, 3, [5, 300, 129], 96, 200, "float16"),
+    ],
+)
+def test_op_grouped(BLOCK_M, BLOCK_N, BLOCK_K, NWARP, NSTAGE, MS, N, K, DTYPE):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 7:
+        pytest.skip("Only test tl.dot() on devices with sm >= 70")
+    torch.manual_seed(0)
+    kwargs = {'BLOCK_M': BLOCK_M, 'BLOCK_N': BLOCK_N, 'BLOCK_K': BLOCK_K}
+    kernel = triton.ops._grouped_matmul.kernel
+    kernel.configs = [triton.Config(kwargs=kwargs, num_warps=NWARP, num_stages=NSTAGE)]
+    DTYPE = {"float16": torch.float16, "float32": torch.float32}[DTYPE]
+    # one problem per expert, with a different number of rows each
+    a = [.1 * torch.randn((M, K), device="cuda", dtype=DTYPE) for M in MS]
+    b = [.1 * torch.randn((K, N), device="cuda", dtype=DTYPE) for _ in MS]
+    tt_c = triton.testing.catch_oor(lambda: triton.ops.grouped_matmul(a, b), pytest)
+    for a_, b_, c_ in zip(a, b, tt_c):
+        triton.testing.assert_almost_equal(torch.matmul(a_, b_), c_)
+
+
+@pytest.mark.parametrize("M, N, K, DTYPE", [
+    (128, 128, 64, "float16"),
+    (100, 72, 160, "float16"),
+    (64, 256, 128, "bfloat16"),
+])
+def test_op_sparse(M, N, K, DTYPE):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 8:
+        pytest.skip("Only test tl.sparse_dot() on devices with sm >= 80")
+    torch.manual_seed(0)
+    DTYPE = {"float16": torch.float16, "bfloat16": torch.bfloat16}[DTYPE]
+    a = .1 * torch.randn((M, K), device="cuda", dtype=DTYPE)
+    b = .1 * torch.randn((K, N), device="cuda", dtype=DTYPE)
+    values, meta = triton.ops.compress_2to4(a)
+    # a pruned to 2:4 sparsity
+    a = triton.ops.decompress_2to4(values, meta)
+    assert ((a.view(M, K // 4, 4) != 0).sum(dim=-1) <= 2).all()
+    th_c = torch.matmul(a, b)
+    tt_c = triton.ops.sparse_matmul(values, meta, b)
+    triton.testing.assert_almost_equal(th_c, tt_c)
+
+
+def test_perf_model_rocm(monkeypatch):
+    # the ROCm branch of the model, on the properties of an MI250X GCD
+    from triton.ops import matmul_perf_model
+    props = {"multiprocessor_count": 110, "sm_clock_rate": 1700000, "max_shared_mem": 65536}
+    monkeypatch.setattr(torch.version, "hip", "5.7")
+    monkeypatch.setenv("MI_GPU_ARCH", "gfx90a")
+    monkeypatch.setattr(matmul_perf_model, "_get_device_properties", lambda device: props)
+    monkeypatch.setattr(torch.cuda, "current_device", lambda: 0)
+    monkeypatch.setattr(torch.cuda, "get_device_capability", lambda device=None: (9, 0))
+
+    def config(block_m, block_n, block_k, num_warps, num_stages):
+        return triton.Config({'BLOCK_M': block_m, 'BLOCK_N': block_n, 'BLOCK_K': block_k, 'SPLIT_K': 1},
+                             num_warps=num_warps, num_stages=num_stages)
+    configs = [
+        # 512 accumulator registers per lane
+        config(256, 256, 32, 2, 2),
+        # 3 stages don't fit in the LDS
+        config(128, 128, 64, 4, 2), config(128, 128, 64, 4, 3),
+        # the MFMAs of a stage take 256 cycles: 2 stages hide the load latency
+        *[config(64, 64, 32, 4, num_stages) for num_stages in range(1, 6)],
+    ]
+    pruned = matmul_perf_model.early_config_prune(configs, {'A': torch.empty((16, 16), dtype=torch.float16)})
+    assert sorted((c.kwargs['BLOCK_M'], c.num_stages) for c in pruned) == [(64, 2), (64, 3), (128, 2)]
+
+    # narrow tiles are bound by the LDS bandwidth, which NVIDIA GPUs don't model
+    assert matmul_perf_model.estimate_shared_ms(0, 110, 4, 4096, 4096, 4096, 64, 64, 2) > 0
+    monkeypatch.setattr(torch.version, "hip", None)
+    assert matmul_perf_model.estimate_shared_ms(0, 110, 4, 4096, 4096, 4096, 64, 64, 2) == 0
@@ -0,0 +1,32 @@
+import pytest
+import torch
+
+import triton
+
+
+@pytest.mark.parametrize('H, H_KV, N_Q', [(8, 8, 1), (8, 2, 1), (8, 1, 1), (8, 2, 4)])
+@pytest.mark.parametrize('num_splits', [None, 1, 5])
+def test_op(H, H_KV, N_Q, num_splits, Z=3, PAGE_SIZE=16, D_HEAD=64, dtype=torch.float16):
+    torch.manual_seed(20)
+    seqlens_k = torch.tensor([1000, 257, 5], dtype=torch.int32, device="cuda")
+    max_pages = triton.cdiv(max(seqlens_k.tolist()), PAGE_SIZE)
+    # the pages of the sequences, in a shuffled pool
+    num_pages = Z * max_pages
+    block_table = torch.randperm(num_pages, device="cuda").to(torch.int32).view(Z, max_pages)
+    q = torch.randn((Z, H, N_Q, D_HEAD), dtype=dtype, device="cuda")
+    k_cache = torch.randn((num_pages, H_KV, PAGE_SIZE, D_HEAD), dtype=dtype, device="cuda")
+    v_cache = torch.randn((num_pages, H_KV, PAGE_SIZE, D_HEAD), dtype=dtype, device="cuda")
+    sm_scale = D_HEAD ** -0.5
+    tri_out = triton.ops.paged_attention(q, k_cache, v_cache, block_table, seqlens_k, sm_scale,
+                                         num_splits=num_splits)
+    for z, n in enumerate(seqlens_k.tolist()):
+        # the keys and values of the sequence, of shape (H, n, D_HEAD)
+        pages = block_table[z].long()
+        k = k_cache[pages].transpose(0, 1).reshape(H_KV, -1, D_HEAD)[:, :n]
+        v = v_cache[pages].transpose(0, 1).reshape(H_KV, -1, D_HEAD)[:, :n]
+        k = k.repeat_interleave(H // H_KV, dim=0)
+        v = v.repeat_interleave(H // H_KV, dim=0)
+        p = torch.matmul(q[z].float(), k.float().transpose(-1, -2)) * sm_scale
+        p = torch.softmax(p, dim=-1).to(dtype)
+        ref_out = torch.matmul(p, v)
+        triton.testing.assert_almost_equal(ref_out, tri_out[z])
@@ -0,0 +1,28 @@
+import pytest
+import torch
+
+import triton
+
+
+@pytest.mark.parametrize('N', [1, 1000, 1024, 100_000])
+@pytest.mark.parametrize('dtype', [torch.int32, torch.float32])
+def test_cumsum(N, dtype):
+    torch.manual_seed(0)
+    if dtype.is_floating_point:
+        x = torch.randn(N, dtype=dtype, device="cuda")
+    else:
+        x = torch.randint(-100, 100, (N,), dtype=dtype, device="cuda")
+    tri_y = triton.ops.cumsum(x)
+    ref_y = torch.cumsum(x.double(), 0).to(tri_y.dtype)
+    if dtype.is_floating_point:
+        torch.testing.assert_close(tri_y, ref_y, atol=1e-2, rtol=1e-4)
+    else:
+        assert torch.equal(tri_y, ref_y)
+
+
+@pytest.mark.parametrize('N', [1, 1000, 100_000])
+def test_compact(N):
+    torch.manual_seed(0)
+    x = torch.randn(N, device="cuda")
+    keep = x > 0.5
+    assert torch.equal(triton.ops.compact(x, keep), x[keep])
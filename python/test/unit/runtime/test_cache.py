@@ -107,6 +107,62 @@ def test_specialize(mode):
     assert counter == target
 
 
+def test_specialize_buckets():
+    @triton.jit(specialize={"N": 32, "BLOCK": "pow2"})
+    def kernel_bucketed(X, N, BLOCK: tl.constexpr):
+        offs = tl.arange(0, BLOCK)
+        tl.store(X + offs, BLOCK, mask=offs < N)
+
+    compiled = []
+
+    def collect(*args, **kwargs):
+        compiled.append(kwargs["compile"])
+    JITFunction.cache_hook = collect
+    reset_tmp_dir()
+    x = torch.empty(64, dtype=torch.int32, device='cuda')
+    for n in range(1, 65):
+        kernel_bucketed[(1,)](x, n, BLOCK=n)
+    # 7 power of 2 buckets, the last two of which are split by N % 32 == 0
+    assert len(compiled) == 9
+    assert sorted({c["constants"][2] for c in compiled}) == [1, 2, 4, 8, 16, 32, 64]
+    assert all(c["configs"][0].equal_to_1 == () for c in compiled)
+    assert [c["configs"][0].divisibility for c in compiled].count(((1, 32),)) == 2
+    JITFunction.cache_hook = None
+    kernel_bucketed[(1,)](x, 33, BLOCK=33)
+    assert torch.all(x[:33] == 64)
+
+
+def test_async_compile():
+    @triton.jit(async_compile=True)
+    def kernel_async(X, Y, N, BLOCK: tl.constexpr):
+        offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        mask = offs < N
+        tl.store(Y + offs, tl.load(X + offs, mask=mask) + 1, mask=mask)
+
+    reset_tmp_dir()
+    device = torch.cuda.current_device()
+    x = torch.randn(1024, device='cuda')
+    y = torch.empty_like(x)
+    # the generic variant is launched while the specialized one compiles
+    generic = kernel_async[(8,)](x, y, 1024, BLOCK=128)
+    assert torch.allclose(y, x + 1)
+    for future in list(kernel_async.pending.values()):
+        future.result()
+    y.zero_()
+    specialized = kernel_async[(8,)](x, y, 1024, BLOCK=128)
+    assert specialized is not generic
+    assert len(kernel_async.pending) == 0
+    assert len(kernel_async.cache[device]) == 2
+    assert torch.allclose(y, x + 1)
+
+
+def test_specialize_invalid_policy():
+    with pytest.raises(ValueError):
+        @triton.jit(specialize={"BLOCK": "never"})
+        def kernel_invalid(X, BLOCK: tl.constexpr):
+            pass
+
+
 @pytest.mark.parametrize("value, value_type", [
     (-1, 'i32'), (0, 'i32'), (1, 'i32'), (-2**31, 'i32'), (2**31 - 1, 'i32'),
     (2**32, 'i64'), (2**63 - 1, 'i64'), (-2**63, 'i64'),
@@ -134,6 +190,34 @@ def test_value_specialization(value: int, value_type: str, device='cuda') -> Non
     assert spec_type == value_type
 
 
+def test_dispatch_cache_hit() -> None:
+    @triton.jit
+    def kernel_inc(X, Y, N, BLOCK: tl.constexpr):
+        offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        tl.store(Y + offs, tl.load(X + offs, mask=offs < N) + 1, mask=offs < N)
+
+    counter = 0
+
+    def inc_counter(*args, **kwargs):
+        nonlocal counter
+        counter += 1
+    JITFunction.cache_hook = inc_counter
+    reset_tmp_dir()
+    x = torch.arange(1000, dtype=torch.float32, device='cuda')
+    y = torch.empty_like(x)
+    grid = lambda meta: (triton.cdiv(meta['N'], meta['BLOCK']),)
+    # positional, keyword and callable-grid launches share the same cache entry
+    for _ in range(3):
+        kernel_inc[grid](x, y, 1000, BLOCK=128)
+        kernel_inc[(8,)](X=x, Y=y, N=1000, BLOCK=128, num_warps=4)
+    assert counter == 1
+    assert torch.equal(y, x + 1)
+    # a different specialization of N misses the cache
+    kernel_inc[grid](x, y, 992, BLOCK=128)
+    assert counter == 2
+    JITFunction.cache_hook = None
+
+
 def test_constexpr_not_callable() -> None:
     @triton.jit
     def kernel(X, c: tl.constexpr):
@@ -204,3 +288,175 @@ def test_compile_in_subproc() -> None:
     proc.start()
     proc.join()
     assert proc.exitcode == 0
+
+
+def test_ttir_template(monkeypatch) -> None:
+    @triton.jit
+    def kernel_axpy(x, y, n, alpha, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        mask = idx < n
+        tl.store(y + idx, tl.load(x + idx, mask=mask) * alpha + tl.load(y + idx, mask=mask), mask=mask)
+
+    signature = {0: "*fp32", 1: "*fp32", 2: "i32", 3: "fp32"}
+    specializations = [triton.compiler.instance_descriptor(divisible_by_16={0, 1}),
+                       triton.compiler.instance_descriptor(divisible_by_16={0}, equal_to_1={2}),
+                       triton.compiler.instance_descriptor(divisible_by_16={0, 1, 2}),
+                       triton.compiler.instance_descriptor(divisibility=((2, 8),), version_alignment={0})]
+
+    def ttir(specialization):
+        return triton.compiler.ast_to_ttir(kernel_axpy, signature, specialization, {4: 64}).str()
+    triton.compiler._ttir_templates.clear()
+    templated = [ttir(spec) for spec in specializations]
+    # one template per set of constant arguments
+    assert len(triton.compiler._ttir_templates) == 2
+    monkeypatch.setenv("TRITON_DISABLE_TTIR_TEMPLATES", "1")
+    assert templated == [ttir(spec) for spec in specializations]
+
+
+def test_compile_many() -> None:
+    @triton.jit
+    def kernel_scale(a, o, N: tl.constexpr, SCALE: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) * SCALE)
+
+    major, minor = torch.cuda.get_device_capability(0)
+    cc = major * 10 + minor
+    config = namedtuple("instance_descriptor", [
+        "divisible_by_16", "equal_to_1"])(
+        tuple(range(2)),
+        ())
+    jobs = [(kernel_scale, dict(signature={0: "*fp32", 1: "*fp32"}, device=0,
+                                constants={2: 32 * i, 3: i}, configs=[config], cc=cc))
+            for i in range(1, 5)]
+    kernels = triton.compile_many(jobs, num_threads=4)
+    assert [k.asm["ttir"] for k in kernels] == \
+        [triton.compile(fn, **kwargs).asm["ttir"] for fn, kwargs in jobs]
+    # a single thread compiles the jobs one after the other
+    assert len(triton.compile_many(jobs, num_threads=1)) == len(jobs)
+    assert triton.compiler.make_context(1).num_threads() == 1
+    assert not triton.compiler.make_context(1).is_multithreading_enabled()
+
+
+def test_autotune_precompile(monkeypatch) -> None:
+    @triton.autotune(configs=[triton.Config({'BLOCK': 64}), triton.Config({'BLOCK': 128}),
+                              triton.Config({'BLOCK': 256}, num_warps=8)], key=['N'])
+    @triton.jit
+    def kernel_dec(X, Y, N, BLOCK: tl.constexpr):
+        offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        tl.store(Y + offs, tl.load(X + offs, mask=offs < N) - 1, mask=offs < N)
+
+    monkeypatch.setenv("TRITON_AUTOTUNE_COMPILE_WORKERS", "2")
+    reset_tmp_dir()
+    x = torch.arange(1000, dtype=torch.float32, device='cuda')
+    y = torch.empty_like(x)
+    grid = lambda meta: (triton.cdiv(meta['N'], meta['BLOCK']),)
+    kernel_dec[grid](x, y, 1000)
+    assert torch.equal(y, x - 1)
+    # every config was compiled by the workers and benchmarked
+    assert len(kernel_dec.configs_timings) == 3
+    assert all(t < float('inf') for t in kernel_dec.configs_timings.values())
+    assert len(os.listdir(tmpdir)) >= 3
+
+
+def test_autotune_results_persist(tmp_path) -> None:
+    @triton.jit
+    def kernel_neg(X, Y, N, BLOCK: tl.constexpr):
+        offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        tl.store(Y + offs, -tl.load(X + offs, mask=offs < N), mask=offs < N)
+
+    configs = [triton.Config({'BLOCK': 64}), triton.Config({'BLOCK': 128})]
+    make_tuner = lambda: triton.autotune(configs=configs, key=['N'])(kernel_neg)
+    reset_tmp_dir()
+    x = torch.arange(1000, dtype=torch.float32, device='cuda')
+    y = torch.empty_like(x)
+    grid = lambda meta: (triton.cdiv(meta['N'], meta['BLOCK']),)
+    tuner = make_tuner()
+    tuner[grid](x, y, 1000)
+    assert hasattr(tuner, 'configs_timings')
+    # a new process picks the persisted config without benchmarking
+    restarted = make_tuner()
+    restarted[grid](x, y, 1000)
+    assert not hasattr(restarted, 'configs_timings')
+    assert restarted.best_config is tuner.best_config
+    # and so does a machine the results are shipped to
+    path = str(tmp_path / "autotune.json")
+    triton.runtime.export_autotune_results(path)
+    reset_tmp_dir()
+    triton.runtime.import_autotune_results(path)
+    shipped = make_tuner()
+    shipped[grid](x, y, 1000)
+    assert not hasattr(shipped, 'configs_timings')
+    assert shipped.best_config is tuner.best_config
+    assert torch.equal(y, -x)
+
+
+def test_autotune_successive_halving() -> None:
+    space = triton.ConfigSpace({'BLOCK': [32, 64, 128, 256, 512, 1024]}, num_warps=[1, 2, 4, 8], num_samples=12,
+                               constraint=lambda config: config.kwargs['BLOCK'] >= 32 * config.num_warps)
+    # the samples are reproducible
+    assert [config.to_dict() for config in space.sample()] == [config.to_dict() for config in space.sample()]
+
+    @triton.autotune(configs=space, key=['N'], tuning={'strategy': 'successive_halving'})
+    @triton.jit
+    def kernel_inc(X, Y, N, BLOCK: tl.constexpr):
+        offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        tl.store(Y + offs, tl.load(X + offs, mask=offs < N) + 1, mask=offs < N)
+
+    reset_tmp_dir()
+    x = torch.arange(100000, dtype=torch.float32, device='cuda')
+    y = torch.empty_like(x)
+    grid = lambda meta: (triton.cdiv(meta['N'], meta['BLOCK']),)
+    kernel_inc[grid](x, y, x.numel())
+    assert torch.equal(y, x + 1)
+    assert len(kernel_inc.configs) == 12
+    assert all(config.kwargs['BLOCK'] >= 32 * config.num_warps for config in kernel_inc.configs)
+    # every config was timed, and the last one standing is picked
+    assert len(kernel_inc.configs_timings) == 12
+    assert all(t < float('inf') for t in kernel_inc.configs_timings.values())
+    assert kernel_inc.best_config in kernel_inc.configs
+
+
+def test_remote_cache_tier(tmp_path, monkeypatch) -> None:
+    @triton.jit
+    def kernel_sq(X, Y, N, BLOCK: tl.constexpr):
+        offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        x = tl.load(X + offs, mask=offs < N)
+        tl.store(Y + offs, x * x, mask=offs < N)
+
+    counter = 0
+
+    def inc_counter(*args, **kwargs):
+        nonlocal counter
+        counter += 1
+        return False
+    monkeypatch.setenv("TRITON_REMOTE_CACHE_DIR", str(tmp_path))
+    reset_tmp_dir()
+    x = torch.arange(1000, dtype=torch.float32, device='cuda')
+    y = torch.empty_like(x)
+    kernel_sq[(8,)](x, y, 1000, BLOCK=128)
+    assert len(os.listdir(tmp_path)) > 0
+    # another rank with an empty local cache fetches the published kernel
+    reset_tmp_dir()
+    kernel_sq.cache.clear()
+    JITFunction.cache_hook = inc_counter
+    y.zero_()
+    kernel_sq[(8,)](x, y, 1000, BLOCK=128)
+    JITFunction.cache_hook = None
+    assert counter == 1
+    assert torch.equal(y, x * x)
+    assert any(f.endswith(".cubin") or f.endswith(".hsaco") for _, _, files in os.walk(tmpdir) for f in files)
+
+
+def test_cache_size_cap(monkeypatch) -> None:
+    from triton.compiler import CacheManager
+    reset_tmp_dir()
+    monkeypatch.setenv("TRITON_CACHE_MAX_SIZE", "64K")
+    CacheManager.bytes_since_eviction = None
+    for i in range(8):
+        CacheManager(f"key{i}").put(bytes(16 << 10), "data.bin")
+        CacheManager.bytes_since_eviction = None
+    total = sum(os.path.getsize(os.path.join(root, f)) for root, _, files in os.walk(tmpdir) for f in files)
+    assert total <= 64 << 10
+    # the most recent entries survive
+    assert os.path.exists(os.path.join(tmpdir, "key7", "data.bin"))
+    assert not os.path.exists(os.path.join(tmpdir, "key0"))
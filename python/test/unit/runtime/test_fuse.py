@@ -0,0 +1,55 @@
+import torch
+
+import triton
+import triton.language as tl
+
+
+@triton.jit
+def scale_kernel(X, Y, alpha, n, BLOCK: tl.constexpr):
+    offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+    mask = offs < n
+    x = tl.load(X + offs, mask=mask)
+    tl.store(Y + offs, alpha * x, mask=mask)
+
+
+@triton.jit
+def row_sum_kernel(X, S, n_cols, stride, BLOCK: tl.constexpr):
+    # one program per (row, block of columns), on a 2D grid
+    row = tl.program_id(1)
+    cols = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+    x = tl.load(X + row * stride + cols, mask=cols < n_cols, other=0.)
+    tl.atomic_add(S + row, tl.sum(x, axis=0))
+
+
+@triton.jit
+def program_count_kernel(N):
+    tl.store(N + tl.program_id(0), tl.num_programs(0))
+
+
+def test_fuse():
+    n = 1000
+    x = torch.randn(n, device='cuda')
+    y = torch.empty_like(x)
+    m = torch.randn((37, 300), device='cuda')
+    s = torch.zeros(37, device='cuda')
+    counts = torch.zeros(5, device='cuda', dtype=torch.int32)
+
+    fused = triton.fuse(scale_kernel, row_sum_kernel, program_count_kernel)
+    grids = ((triton.cdiv(n, 128),),
+             lambda args: (triton.cdiv(args['n_cols'], args['BLOCK']), args['X'].shape[0]),
+             (5,))
+    fused[grids]((x, y, 2., n, 128),
+                 dict(X=m, S=s, n_cols=m.shape[1], stride=m.stride(0), BLOCK=64),
+                 (counts,), num_warps=4)
+    torch.cuda.synchronize()
+    assert torch.allclose(y, 2. * x)
+    assert torch.allclose(s, m.sum(dim=1), rtol=1e-4, atol=1e-4)
+    assert torch.all(counts == 5)
+
+    # empty grids are skipped
+    y.zero_()
+    fused[((triton.cdiv(n, 128),), (0, 37), (0,))]((x, y, 3., n, 128),
+                                                     dict(X=m, S=s, n_cols=0, stride=m.stride(0), BLOCK=64),
+                                                     (counts,), num_warps=4)
+    torch.cuda.synchronize()
+    assert torch.allclose(y, 3. * x)
@@ -0,0 +1,55 @@
+import torch
+
+import triton
+import triton.language as tl
+
+
+@triton.jit
+def add_kernel(X, Y, Z, n, BLOCK: tl.constexpr):
+    offs = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+    mask = offs < n
+    x = tl.load(X + offs, mask=mask)
+    y = tl.load(Y + offs, mask=mask)
+    tl.store(Z + offs, x + y, mask=mask)
+
+
+def test_graph_replay_and_update():
+    n = 1000
+    x, y, w = [torch.randn(n, device='cuda') for _ in range(3)]
+    z = torch.empty_like(x)
+    out = torch.empty_like(x)
+    grid = (triton.cdiv(n, 128),)
+    kernel = add_kernel[grid](x, y, z, n, BLOCK=128)
+
+    graph = triton.KernelGraph()
+    n0 = graph.add(kernel, grid, x, y, z, n)
+    n1 = graph.add(kernel, grid, z, y, out, n, deps=[n0])
+    z.zero_()
+    out.zero_()
+    graph.replay()
+    torch.cuda.synchronize()
+    assert torch.allclose(out, x + 2 * y)
+
+    # pointers and scalars are rewritten in place between replays
+    graph.update(n1, z, w, out, n // 2)
+    out.zero_()
+    graph.replay()
+    torch.cuda.synchronize()
+    assert torch.allclose(out[:n // 2], x[:n // 2] + y[:n // 2] + w[:n // 2])
+    assert torch.all(out[n // 2:] == 0)
+
+
+def test_graph_stream_capture():
+    n = 1000
+    x, y = [torch.randn(n, device='cuda') for _ in range(2)]
+    z = torch.empty_like(x)
+    grid = (triton.cdiv(n, 128),)
+    kernel = add_kernel[grid](x, y, z, n, BLOCK=128)
+
+    z.zero_()
+    g = torch.cuda.CUDAGraph()
+    with torch.cuda.graph(g):
+        kernel.graph_node(grid, x, y, z, n)
+    g.replay()
+    torch.cuda.synchronize()
+    assert torch.allclose(z, x + y)
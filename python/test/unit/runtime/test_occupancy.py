@@ -0,0 +1,55 @@
+import pytest
+
+from triton.runtime.occupancy import (DeviceLimits, occupancy, predicted_efficiency, programs_per_sm,
+                                      propose_layout, propose_num_warps, wave_efficiency)
+
+# A100
+limits = DeviceLimits(warp_size=32, num_sms=108, max_threads_per_sm=2048, max_registers_per_sm=65536,
+                      max_shared_per_sm=167936)
+
+
+@pytest.mark.parametrize("num_warps, registers, shared, expected", [
+    (4, 32, 0, 16),         # bound by threads
+    (4, 128, 0, 4),         # bound by registers
+    (4, 125, 0, 4),         # rounded up to the allocation granularity
+    (4, 32, 65536, 2),      # bound by shared memory
+    (4, 32, 200000, 0),     # does not fit
+    (1, 16, 0, 32),         # bound by programs
+    (64, 32, 0, 0),         # too many threads
+])
+def test_programs_per_sm(num_warps, registers, shared, expected):
+    assert programs_per_sm(limits, num_warps, registers, shared) == expected
+
+
+def test_efficiency():
+    assert occupancy(limits, 4, 128) == 0.25
+    assert occupancy(limits, 8, 32) == 1.
+    # a full last wave
+    assert wave_efficiency(limits, 108 * 4, 4) == 1.
+    # one program more than a wave
+    assert wave_efficiency(limits, 108 * 4 + 1, 4) == pytest.approx((108 * 4 + 1) / (2 * 108 * 4))
+    # beyond half occupancy, only the waves matter
+    assert predicted_efficiency(limits, 8, 64, num_programs=108 * 4) == 1.
+    assert predicted_efficiency(limits, 4, 128) == 0.5
+
+
+def test_propose_num_warps():
+    assert propose_num_warps(1024, 32, limits) == 4
+    assert propose_num_warps(128 * 128, 16, limits) == 8
+    assert propose_num_warps(64, 32, limits) == 1
+    assert propose_num_warps(128 * 128, 16, limits, max_num_warps=4) == 4
+    # at most 1024 threads per program, and no more than 4 waves of 64 lanes
+    # using 512 registers each fit on the multiprocessor
+    amd = DeviceLimits(warp_size=64, max_registers_per_sm=4 * 512 * 64, max_registers_per_thread=512,
+                       max_shared_per_sm=65536)
+    assert propose_num_warps(1 << 20, 32, amd, max_num_warps=32) == 16
+    assert propose_num_warps(1 << 20, 32, amd, registers=512, max_num_warps=32) == 4
+
+
+def test_propose_layout():
+    assert propose_layout([1024], 4, 32) == {"sizePerThread": [4], "threadsPerWarp": [32],
+                                             "warpsPerCTA": [4], "order": [0]}
+    assert propose_layout([64, 64], 4, 16) == {"sizePerThread": [1, 8], "threadsPerWarp": [4, 8],
+                                               "warpsPerCTA": [4, 1], "order": [1, 0]}
+    assert propose_layout([16, 128], 8, 32, warp_size=64, order=[1, 0]) == {
+        "sizePerThread": [1, 4], "threadsPerWarp": [2, 32], "warpsPerCTA": [8, 1], "order": [1, 0]}
@@ -0,0 +1,31 @@
+import json
+
+import pytest
+import torch
+
+from triton.testing import Roofline
+
+
+def test_roofline():
+    # A100
+    roofline = Roofline(torch.float16, peak_gbps=1555., peak_tflops=312.)
+    # 1 GB copied in 1 ms
+    copy = roofline.record(1., bytes=1e9, name="copy", config={"N": 1 << 28})
+    assert copy["gbps"] == pytest.approx(1000.)
+    assert copy["bound"] == "memory"
+    assert copy["roofline_pct"] == pytest.approx(100 * 1000. / 1555.)
+    # 4096^3 matmul in 0.5 ms
+    M = 4096
+    matmul = roofline.record(0.5, bytes=3 * M * M * 2, flops=2 * M * M * M, name="matmul", config={"M": M})
+    assert matmul["bound"] == "compute"
+    assert matmul["tflops"] == pytest.approx(2 * M ** 3 / 0.5e-3 * 1e-12)
+    assert matmul["roofline_pct"] == pytest.approx(100 * matmul["tflops"] / 312.)
+
+    baseline = roofline.to_json()
+    assert [r["name"] for r in json.loads(baseline)["results"]] == ["copy", "matmul"]
+    current = Roofline(torch.float16, peak_gbps=1555., peak_tflops=312.)
+    current.record(1.01, bytes=1e9, name="copy", config={"N": 1 << 28})
+    current.record(0.6, bytes=3 * M * M * 2, flops=2 * M * M * M, name="matmul", config={"M": M})
+    current.record(0.6, bytes=3 * M * M * 2, flops=2 * M * M * M, name="matmul", config={"M": 2 * M})
+    regressions = current.compare(baseline, tolerance=0.05)
+    assert [(r["name"], ref["ms"]) for r, ref in regressions] == [("matmul", 0.5)]
@@ -20,12 +20,17 @@ from .utils import (
 from .runtime import (
     autotune,
     Config,
+    ConfigSpace,
+    fuse,
+    Grid,
     heuristics,
+    HorizontalFusion,
     JITFunction,
     KernelInterface,
 )
 from .runtime.jit import jit
-from .compiler import compile, CompilationError
+from .compiler import (compile, compile_many, CompilationError, KernelBundle, KernelGraph, launch_many,
+                       prefetch_kernels, write_kernel_bundle, write_kernel_library)
 from . import language
 from . import testing
 from . import ops
@@ -35,18 +40,29 @@ __all__ = [
     "cdiv",
     "CompilationError",
     "compile",
+    "compile_many",
     "Config",
+    "ConfigSpace",
+    "fuse",
+    "Grid",
     "heuristics",
+    "HorizontalFusion",
     "impl",
     "jit",
     "JITFunction",
+    "KernelBundle",
     "KernelInterface",
+    "KernelGraph",
     "language",
+    "launch_many",
     "MockTensor",
     "next_power_of_2",
     "ops",
+    "prefetch_kernels",
     "reinterpret",
     "runtime",
     "TensorWrapper",
     "testing",
+    "write_kernel_bundle",
+    "write_kernel_library",
 ]
@@ -1,19 +1,28 @@
 from __future__ import annotations
 
 import ast
+import atexit
+import collections
+import collections.abc
 import contextlib
 import functools
 import hashlib
 import io
 import json
+import mmap
 import os
 import re
 import shutil
+import struct
 import subprocess
 import sys
 import sysconfig
 import tempfile
+import threading
+import time
+import uuid
 import warnings
+import weakref
 from collections import namedtuple
 from pathlib import Path
 from sysconfig import get_paths
@@ -21,12 +30,13 @@ from typing import Any, Callable, Dict, Tuple, Union
 
 import setuptools
 import torch
-from filelock import FileLock
 
 import triton
 import triton._C.libtriton.triton as _triton
 from . import impl
-from .tools.disasm import extract
+from .runtime.jit import current_device, get_cuda_stream
+from .tools.disasm import (extract, gcn_instruction_mix, gcn_resource_usage, resource_usage,
+                           sass_instruction_mix)
 
 def static_vars(**kwargs):
     def decorate(func):
@@ -41,6 +51,8 @@ def str_to_ty(name):
         return triton.language.pointer_type(ty)
     tys = {
         "fp8": triton.language.float8,
+        "fp8e4": triton.language.float8e4,
+        "fp8e5": triton.language.float8e5,
         "fp16": triton.language.float16,
         "bf16": triton.language.bfloat16,
         "fp32": triton.language.float32,
@@ -66,6 +78,10 @@ def mangle_ty(ty):
         return 'i' + str(ty.int_bitwidth)
     if ty.is_fp8():
         return 'fp8'
+    if ty.is_fp8e4():
+        return 'fp8e4'
+    if ty.is_fp8e5():
+        return 'fp8e5'
     if ty.is_fp16():
         return 'fp16'
     if ty.is_bf16():
@@ -112,7 +128,8 @@ class enter_sub_region:
         self.generator.local_defs = self.prev_defs
 
 class CodeGenerator(ast.NodeVisitor):
-    def __init__(self, context, prototype, gscope, attributes, constants, function_name, module=None, is_kernel=False, function_types=dict()):
+    def __init__(self, context, prototype, gscope, attributes, constants, function_name, module=None, is_kernel=False, function_types=dict(),
+                 pass_program_ids=False):
         self.builder = _triton.ir.builder(context)
         self.module = self.builder.create_module() if module is None else module
         self.function_ret_types = function_types
@@ -134,6 +151,12 @@ class CodeGenerator(ast.NodeVisitor):
             'getattr': getattr,
         }
         self.scf_stack = []
+        # program ids and numbers of programs of the functions called with
+        # remapped program ids (see `call_JitFunction`), passed as their last
+        # arguments, which `tl.program_id` and `tl.num_programs` return
+        self.pass_program_ids = pass_program_ids
+        self.program_ids = None
+        self.num_programs = None
         # SSA-construction
         # name => triton.language.tensor
         self.local_defs: Dict[str, triton.language.tensor] = {}
@@ -244,10 +267,13 @@ class CodeGenerator(ast.NodeVisitor):
                 arg_values.append(cst)
                 continue
             else:
-                if i in self.attributes:
-                    fn.set_arg_attr(idx, "tt.divisibility", self.attributes[i][1])
+                for attr_name, value in self.attributes.get(i, ()):
+                    fn.set_arg_attr(idx, attr_name, value)
                 arg_values.append(triton.language.tensor(fn.args(idx), self.prototype.param_types[idx]))
                 idx += 1
+        if self.pass_program_ids:
+            ids = [triton.language.tensor(fn.args(idx + i), triton.language.int32) for i in range(6)]
+            self.program_ids, self.num_programs = ids[:3], ids[3:]
 
         insert_pt = self.builder.get_insertion_block()
         for arg_name, arg_value in zip(arg_names, arg_values):
@@ -644,8 +670,16 @@ class CodeGenerator(ast.NodeVisitor):
                     ast.NodeVisitor.generic_visit(self, stmt)
             return
 
-        if IteratorClass != self.builtins['range']:
-            raise RuntimeError('Only `range` and `static_range` iterators are currently supported')
+        unroll_factor = None
+        if IteratorClass == triton.language.unrolled_range:
+            kws = dict()
+            for keyword in node.iter.keywords:
+                kws.update(self.visit(keyword))
+            iterator = IteratorClass(*iter_args, **kws)
+            iter_args = [iterator.start, iterator.end, iterator.step]
+            unroll_factor = iterator.factor.value
+        elif IteratorClass != self.builtins['range']:
+            raise RuntimeError('Only `range`, `static_range` and `unrolled_range` iterators are currently supported')
 
         # visit iterator arguments
         # note: only `range` iterator is supported now
@@ -705,6 +739,8 @@ class CodeGenerator(ast.NodeVisitor):
             # create ForOp
             self.builder.restore_insertion_point(ip)
             for_op = self.builder.create_for_op(lb, ub, step, [arg.handle for arg in init_args])
+            if unroll_factor is not None and unroll_factor > 1:
+                for_op.set_attr("tt.unroll_factor", self.builder.get_int32_attr(unroll_factor))
 
             self.scf_stack.append(node)
             self.builder.set_insertion_point_to_start(for_op.get_body(0))
@@ -752,6 +788,58 @@ class CodeGenerator(ast.NodeVisitor):
     def visit_keyword(self, node):
         return {node.arg: self.visit(node.value)}
 
+    def call_JitFunction(self, fn: triton.runtime.JITFunction, args, kws, program_ids=None, num_programs=None):
+        '''
+        Calls `fn`. Its `tl.program_id` and `tl.num_programs` return
+        `program_ids` and `num_programs` when they are given, triples of int32
+        tensors, and those of the caller otherwise.
+        '''
+        from inspect import getcallargs
+        args = getcallargs(fn.fn, *args, **kws)
+        args = [args[name] for name in fn.arg_names]
+        args = [arg if isinstance(arg, triton.language.tensor)
+                else triton.language.constexpr(arg) for arg in args]
+        # generate function def
+        attributes = dict()
+        constexprs = [i for i, arg in enumerate(args) if isinstance(arg, triton.language.constexpr)]
+        constants = {i: args[i] for i in constexprs}
+        # generate call
+        args = [None if i in constexprs else arg for i, arg in enumerate(args)]
+        arg_vals = [arg.handle for arg in args if arg is not None]
+        arg_types = [arg.type for arg in args if arg is not None]
+        fn_name = mangle_fn(fn.__name__, arg_types, constants)
+        if program_ids is None and self.program_ids is not None:
+            program_ids, num_programs = self.program_ids, self.num_programs
+        pass_program_ids = program_ids is not None
+        if pass_program_ids:
+            ids = list(program_ids) + list(num_programs)
+            arg_vals += [id.handle for id in ids]
+            arg_types += [triton.language.int32] * len(ids)
+            fn_name = mangle_fn(fn.__name__ + "_pids", arg_types, constants)
+        # generate function def if necessary
+        if not self.module.has_function(fn_name):
+            prototype = triton.language.function_type([], arg_types)
+            gscope = sys.modules[fn.fn.__module__].__dict__
+            generator = CodeGenerator(self.builder.context, prototype, gscope, attributes, constants, module=self.module, function_name=fn_name, function_types=self.function_ret_types,
+                                      pass_program_ids=pass_program_ids)
+            generator.visit(fn.parse())
+            callee_ret_type = generator.last_ret_type
+            self.function_ret_types[fn_name] = callee_ret_type
+        else:
+            callee_ret_type = self.function_ret_types[fn_name]
+        symbol = self.module.get_function(fn_name)
+        call_op = self.builder.call(symbol, arg_vals)
+        if call_op.get_num_results() == 0 or callee_ret_type is None:
+            return None
+        elif call_op.get_num_results() == 1:
+            return triton.language.tensor(call_op.get_result(0), callee_ret_type)
+        else:
+            # should return a tuple of tl.tensor
+            results = []
+            for i in range(call_op.get_num_results()):
+                results.append(triton.language.tensor(call_op.get_result(i), callee_ret_type[i]))
+            return tuple(results)
+
     def visit_Call(self, node):
         fn = self.visit(node.func)
         if isinstance(fn, triton.language.constexpr):
@@ -761,45 +849,13 @@ class CodeGenerator(ast.NodeVisitor):
             kws.update(self.visit(keyword))
         args = [self.visit(arg) for arg in node.args]
         if isinstance(fn, triton.runtime.JITFunction):
-            from inspect import getcallargs
-            args = getcallargs(fn.fn, *args, **kws)
-            args = [args[name] for name in fn.arg_names]
-            args = [arg if isinstance(arg, triton.language.tensor)
-                    else triton.language.constexpr(arg) for arg in args]
-            # generate function def
-            attributes = dict()
-            constexprs = [i for i, arg in enumerate(args) if isinstance(arg, triton.language.constexpr)]
-            constants = {i: args[i] for i in constexprs}
-            # generate call
-            args = [None if i in constexprs else arg for i, arg in enumerate(args)]
-            arg_vals = [arg.handle for arg in args if arg is not None]
-            arg_types = [arg.type for arg in args if arg is not None]
-            fn_name = mangle_fn(fn.__name__, arg_types, constants)
-            # generate function def if necessary
-            if not self.module.has_function(fn_name):
-                prototype = triton.language.function_type([], arg_types)
-                gscope = sys.modules[fn.fn.__module__].__dict__
-                generator = CodeGenerator(self.builder.context, prototype, gscope, attributes, constants, module=self.module, function_name=fn_name, function_types=self.function_ret_types)
-                generator.visit(fn.parse())
-                callee_ret_type = generator.last_ret_type
-                self.function_ret_types[fn_name] = callee_ret_type
-            else:
-                callee_ret_type = self.function_ret_types[fn_name]
-            symbol = self.module.get_function(fn_name)
-            call_op = self.builder.call(symbol, arg_vals)
-            if call_op.get_num_results() == 0 or callee_ret_type is None:
-                return None
-            elif call_op.get_num_results() == 1:
-                return triton.language.tensor(call_op.get_result(0), callee_ret_type)
-            else:
-                # should return a tuple of tl.tensor
-                results = []
-                for i in range(call_op.get_num_results()):
-                    results.append(triton.language.tensor(call_op.get_result(i), callee_ret_type[i]))
-                return tuple(results)
+            return self.call_JitFunction(fn, args, kws)
         if (hasattr(fn, '__self__') and self.is_triton_tensor(fn.__self__)) \
                 or impl.is_builtin(fn):
-            return fn(*args, _builder=self.builder, **kws)
+            extra_kwargs = dict(_builder=self.builder)
+            if impl.takes_generator(fn):
+                extra_kwargs['_generator'] = self
+            return fn(*args, **extra_kwargs, **kws)
         if fn in self.builtins.values():
             args = [arg.value if isinstance(arg, triton.language.constexpr) else arg
                     for arg in args]
@@ -896,14 +952,19 @@ class OutOfResources(Exception):
 
 def kernel_suffix(signature, specialization):
     # suffix format:
-    # <argid><'c' if equal to 1><'d' if divisible by 16>
+    # <argid><'c' if equal to 1><'d' if divisible by 16><'v' if versioned on alignment><'d<N>' if divisible by N>
     suffix = ''
+    divisibility = dict(getattr(specialization, "divisibility", ()))
     for i, _ in enumerate(signature):
         suffix += str(i)
         if i in specialization.equal_to_1:
             suffix += 'c'
         if i in specialization.divisible_by_16:
             suffix += 'd'
+        if i in getattr(specialization, "version_alignment", ()):
+            suffix += 'v'
+        if i in divisibility:
+            suffix += f'd{divisibility[i]}'
     return suffix
 
 # ------------------------------------------------------------------------------
@@ -917,11 +978,39 @@ def parse_mlir_module(path, context):
     return module
 
 
-def build_triton_ir(fn, signature, specialization, constants):
+def make_context(num_threads=None):
+    '''
+    Creates an MLIR context whose pass managers run the passes nested under the
+    functions of a module on `num_threads` threads: all the hardware threads if
+    0, and the calling thread only if 1. Defaults to the value of the
+    TRITON_COMPILE_THREADS environment variable, or 0.
+    '''
+    if num_threads is None:
+        num_threads = int(os.environ.get("TRITON_COMPILE_THREADS", "0"))
+    return _triton.ir.context(num_threads)
+
+
+def specialization_attrs(specialization):
+    # attributes of the arguments of the kernel, by index
+    attrs = collections.defaultdict(list)
+    for k in specialization.divisible_by_16:
+        attrs[k].append(("tt.divisibility", 16))
+    for k in getattr(specialization, "version_alignment", ()):
+        attrs[k].append(("tt.version_divisibility", 16))
+    for k, n in getattr(specialization, "divisibility", ()):
+        attrs[k].append(("tt.divisibility", n))
+    # pointers the kernel asserts alias no other argument
+    for k in getattr(specialization, "noalias", ()):
+        attrs[k].append(("tt.noalias", 1))
+    return attrs
+
+
+def build_triton_ir(fn, signature, specialization, constants, context=None):
     # canonicalize signature
     if isinstance(signature, str):
         signature = {k: v.strip() for k, v in enumerate(signature.split(","))}
-    context = _triton.ir.context()
+    if context is None:
+        context = make_context()
     context.load_triton()
     # create kernel prototype
     cst_key = lambda i: fn.arg_names.index(i) if isinstance(i, str) else i
@@ -931,7 +1020,7 @@ def build_triton_ir(fn, signature, specialization, constants):
     function_name = '_'.join([fn.__name__, kernel_suffix(signature.values(), specialization)])
     tys = list(signature.values())
     new_constants = {k: True if k in tys and tys[k] == "i1" else 1 for k in specialization.equal_to_1}
-    new_attrs = {k: ("multiple_of", 16) for k in specialization.divisible_by_16}
+    new_attrs = specialization_attrs(specialization)
     all_constants = constants.copy()
     all_constants.update(new_constants)
     arg_types = [str_to_ty(v) for k, v in signature.items() if k not in constants]
@@ -951,40 +1040,135 @@ def build_triton_ir(fn, signature, specialization, constants):
     return ret, generator
 
 
-def optimize_triton_ir(mod):
+def optimize_triton_ir(mod, int32_indexing=False):
     pm = _triton.ir.pass_manager(mod.context)
     pm.enable_debug()
     pm.add_inliner_pass()
+    pm.add_triton_rewrite_tensor_pointer_pass()
+    pm.add_triton_canonicalize_pointers_pass(int32_indexing)
     pm.add_triton_combine_pass()
     pm.add_canonicalizer_pass()
     pm.add_cse_pass()
     pm.add_licm_pass()
+    pm.add_triton_version_alignment_pass()
     pm.run(mod)
     return mod
 
 
-def ast_to_ttir(fn, signature, specialization, constants):
-    mod, _ = build_triton_ir(fn, signature, specialization, constants)
-    return optimize_triton_ir(mod)
+# Frontend IR of the kernels before their specialization on the divisibility
+# of their arguments, which only sets attributes of the arguments: the
+# specializations of a kernel then share the code generated from its AST
+_ttir_templates = collections.OrderedDict()
+_TTIR_TEMPLATES_SIZE = 256
+
+
+def _specialize_triton_ir(mod, template_name, fn, signature, constants, specialization):
+    function_name = '_'.join([fn.__name__, kernel_suffix(signature.values(), specialization)])
+    kernel = mod.get_function(template_name)
+    kernel.set_name(function_name)
+    # the attributes are set on the arguments with no value, as by the frontend
+    cst_key = lambda i: fn.arg_names.index(i) if isinstance(i, str) else i
+    all_constants = {cst_key(key) for key in constants} | set(specialization.equal_to_1)
+    for i, attrs in sorted(specialization_attrs(specialization).items()):
+        if i not in all_constants:
+            idx = len([j for j in range(i) if j not in all_constants])
+            for attr, value in attrs:
+                kernel.set_arg_attr(idx, attr, value)
+    return mod
+
+
+def ast_to_ttir(fn, signature, specialization, constants, context=None):
+    if os.environ.get("TRITON_DISABLE_TTIR_TEMPLATES", "0") == "1":
+        mod, _ = build_triton_ir(fn, signature, specialization, constants, context)
+        return optimize_triton_ir(mod, getattr(fn, "int32_indexing", False))
+    if isinstance(signature, str):
+        signature = {k: v.strip() for k, v in enumerate(signature.split(","))}
+    if context is None:
+        context = make_context()
+    generic = instance_descriptor(equal_to_1=specialization.equal_to_1)
+    template_name = '_'.join([fn.__name__, kernel_suffix(signature.values(), generic)])
+    key = (fn.cache_key, tuple(signature.items()), repr(sorted(constants.items(), key=repr)),
+           tuple(sorted(specialization.equal_to_1)))
+    src = _ttir_templates.get(key, None)
+    if src is None:
+        mod, _ = build_triton_ir(fn, signature, generic, constants, context)
+        src = mod.str()
+        _ttir_templates[key] = src
+        while len(_ttir_templates) > _TTIR_TEMPLATES_SIZE:
+            _ttir_templates.popitem(last=False)
+    else:
+        _ttir_templates.move_to_end(key)
+        context.load_triton()
+        mod = _triton.ir.parse_mlir_module_str(src, context)
+        mod.context = context
+    mod = _specialize_triton_ir(mod, template_name, fn, signature, constants, specialization)
+    return optimize_triton_ir(mod, getattr(fn, "int32_indexing", False))
+
+
+def _parse_pid_order(pid_order):
+    # None, "grouped", "hilbert" or ("grouped", group_size)
+    order, group_size = (pid_order, 8) if isinstance(pid_order, str) else pid_order
+    if order not in ("grouped", "hilbert") or group_size < 1:
+        raise ValueError(f"invalid pid_order {pid_order!r}")
+    return order, group_size
 
 
-def ttir_to_ttgir(mod, num_warps, num_stages, compute_capability):
+def get_shared_memory_banks(gfx_arch=None):
+    '''
+    Number of 4-byte banks of the shared memory (LDS on AMD GPUs), which shared
+    layouts are swizzled for. The LDS of gfx950 has twice the banks of the
+    earlier CDNA GPUs.
+    '''
+    if gfx_arch is not None and gfx_arch.startswith("gfx950"):
+        return 64
+    return 32
+
+
+def ttir_to_ttgir(mod, num_warps, num_stages, compute_capability, warp_specialize=False, prefetch_width=None,
+                  pid_order=None, threads_per_warp=32, gfx_arch=None, min_blocks_per_sm=None, max_registers=None,
+                  waves_per_eu=None, pgo_decisions=None, profile_kernel=False, num_ctas=1):
+    # the decisions of the passes varied by profile-guided compilation
+    decisions = pgo_decisions or dict()
+    remat_weight = decisions.get("remat_weight", 1.0)
+    # the whole kernel is a profiled region when it has none
+    if profile_kernel:
+        _triton.add_profile_region(mod, "kernel")
     pm = _triton.ir.pass_manager(mod.context)
-    pm.add_convert_triton_to_tritongpu_pass(num_warps)
+    # Program ids are scalars untouched by the conversion to TritonGPU
+    if pid_order is not None:
+        pm.add_triton_remap_program_ids_pass(*_parse_pid_order(pid_order))
+    # The launch bounds are recorded on the module, and lowered to annotations
+    # of the kernel, as well as the size of its thread block clusters
+    pm.add_convert_triton_to_tritongpu_pass(num_warps, threads_per_warp, get_shared_memory_banks(gfx_arch),
+                                            min_blocks_per_sm or 0, max_registers or 0, waves_per_eu or 0,
+                                            num_ctas)
     pm.enable_debug()
+    # Loops are unrolled first, so that the pipeline and prefetch passes and the
+    # schedulers see the unrolled bodies
+    pm.add_tritongpu_loop_unroll_pass()
     pm.add_coalesce_pass()
     # The combine pass converts blocked layout to mma layout
     # for dot ops so that pipeline can get shared memory swizzled correctly.
-    pm.add_tritongpu_combine_pass(compute_capability)
+    pm.add_tritongpu_combine_pass(compute_capability, remat_weight)
+    # Peeling the partial last iteration of loops drops the masks of the
+    # steady-state loop before the pipeline pass emits its prologue
+    pm.add_tritongpu_peel_loops_pass()
+    # Loads of loop invariant pointers, e.g. of bias or scale vectors, are
+    # hoisted out of the loops once their addresses are
+    pm.add_licm_pass()
+    pm.add_tritongpu_hoist_invariant_loads_pass()
     pm.add_tritongpu_pipeline_pass(num_stages)
+    # Named barriers are required to hand buffers over between warp groups
+    if warp_specialize and torch.version.hip is None:
+        pm.add_tritongpu_warp_specialize_pass()
     # Prefetch must be done after pipeline pass because pipeline pass
     # extracts slices from the original tensor.
-    pm.add_tritongpu_prefetch_pass()
+    pm.add_tritongpu_prefetch_pass(prefetch_width or decisions.get("prefetch_width", 0))
     pm.add_canonicalizer_pass()
     pm.add_cse_pass()
-    pm.add_tritongpu_combine_pass(compute_capability)
+    pm.add_tritongpu_combine_pass(compute_capability, remat_weight)
     pm.add_licm_pass()
-    pm.add_tritongpu_combine_pass(compute_capability)
+    pm.add_tritongpu_combine_pass(compute_capability, remat_weight)
     pm.add_cse_pass()
     pm.add_tritongpu_decompose_conversions_pass()
     if compute_capability // 10 == 7:
@@ -994,6 +1178,19 @@ def ttir_to_ttgir(mod, num_warps, num_stages, compute_capability):
     pm.add_cse_pass()
     pm.add_symbol_dce_pass()
     pm.add_tritongpu_reorder_instructions_pass()
+    # The register file is shared by the warps of the program, which are
+    # spread over the 4 SIMDs of a compute unit on AMD GPUs
+    if torch.version.hip is None:
+        register_budget = min(255, 65536 // (threads_per_warp * num_warps))
+    else:
+        register_budget = min(256, 512 // max(1, num_warps * threads_per_warp // 128))
+    # with launch bounds, the backend allocates fewer registers
+    if max_registers:
+        register_budget = min(register_budget, max_registers)
+    if min_blocks_per_sm and torch.version.hip is None:
+        register_budget = min(register_budget, 65536 // (threads_per_warp * num_warps * min_blocks_per_sm))
+    register_budget = int(register_budget * decisions.get("register_budget", 1.0))
+    pm.add_tritongpu_list_schedule_pass(register_budget)
     pm.run(mod)
     return mod
 
@@ -1005,10 +1202,46 @@ def add_external_libs(mod, libs):
     _triton.add_external_libs(mod, list(libs.keys()), list(libs.values()))
 
 
-def ttgir_to_llir(mod, extern_libs, compute_capability):
+def ttgir_to_llir(mod, extern_libs, compute_capability, fast_math=False, ptx_version=80):
     if extern_libs:
         add_external_libs(mod, extern_libs)
-    return _triton.translate_triton_gpu_to_llvmir(mod, compute_capability)
+    return _triton.translate_triton_gpu_to_llvmir(mod, compute_capability, fast_math, ptx_version)
+
+
+def ttir_to_cpu_ttgir(mod):
+    pm = _triton.ir.pass_manager(mod.context)
+    # A program runs on one thread of the host, which holds its tensors as
+    # vectors whatever their layout: the layouts for GPUs are not optimized
+    pm.add_convert_triton_to_tritongpu_pass(1, 1, get_shared_memory_banks(), 0, 0, 0)
+    pm.enable_debug()
+    pm.add_tritongpu_loop_unroll_pass()
+    pm.add_canonicalizer_pass()
+    pm.add_cse_pass()
+    pm.add_licm_pass()
+    pm.add_symbol_dce_pass()
+    pm.run(mod)
+    return mod
+
+
+def ttgir_to_cpu_llir(mod):
+    return _triton.translate_triton_gpu_to_cpu_llvmir(mod)
+
+
+def llir_get_kernel_name(llir: str) -> str:
+    '''
+    Get the name of the kernel, i.e. of the first function defined with
+    external linkage, from LLVM IR.
+    '''
+    match = re.search(r'^define\s+(?!internal|private)[^@\n]*@(\w+)\(', llir, re.MULTILINE)
+    if match is None:
+        raise RuntimeError("Failed to find the kernel in LLVM IR")
+    return match.group(1)
+
+
+# The translations to PTX and HSACO initialize the LLVM targets and set global
+# LLVM options, so that concurrent compilations (see `compile_many`) run them
+# one at a time
+_llvm_target_lock = threading.Lock()
 
 
 def llir_to_ptx(mod: Any, compute_capability: int, ptx_version: int = None) -> Tuple[str, int]:
@@ -1020,9 +1253,9 @@ def llir_to_ptx(mod: Any, compute_capability: int, ptx_version: int = None) -> T
         - shared memory allocation size
     '''
     if ptx_version is None:
-        _, cuda_version = path_to_ptxas()
-        ptx_version = ptx_get_version(cuda_version)
-    return _triton.translate_llvmir_to_ptx(mod, compute_capability, ptx_version)
+        ptx_version = get_ptx_version()
+    with _llvm_target_lock:
+        return _triton.translate_llvmir_to_ptx(mod, compute_capability, ptx_version)
 
 
 def ptx_to_cubin(ptx: str, compute_capability: int):
@@ -1032,7 +1265,8 @@ def ptx_to_cubin(ptx: str, compute_capability: int):
     :param compute_capability: compute capability
     :return: str
     '''
-    ptxas, _ = path_to_ptxas()
+    # the ptx is compiled in memory if libtriton links the PTX compiler library
+    ptxas = "" if _triton.get_ptx_compiler_version() else path_to_ptxas()[0]
     return _triton.compile_ptx_to_cubin(ptx, ptxas, compute_capability)
 
 
@@ -1060,15 +1294,29 @@ def amdgcn_get_kernel_name(amdgcn: str) -> str:
             return line.split()[-1].strip()
 
 
-def llir_to_amdgcn_and_hsaco(mod: Any, gfx_arch: str) -> Tuple[str, str]:
+def llir_to_amdgcn_and_hsaco(mod: Any, gfx_arch: str) -> Tuple[str, bytes]:
     '''
     Translate TritonGPU module to HSACO code.
     :param mod: a TritonGPU dialect module
     :return:
         - AMDGCN code
-        - Path to HSACO object
+        - HSACO code object
+    '''
+    with _llvm_target_lock:
+        amdgcn, hsaco = _triton.translate_llvmir_to_hsaco(mod, gfx_arch)
+    if not hsaco:
+        raise RuntimeError("Internal Triton HSACO codegen error: failed to link the code object")
+    return amdgcn, hsaco
+
+
+def get_ptx_version() -> int:
     '''
-    return _triton.translate_llvmir_to_hsaco(mod, gfx_arch)
+    Get the highest PTX version supported by the PTX compiler in use.
+    '''
+    cuda_version = _triton.get_ptx_compiler_version()
+    if not cuda_version:
+        _, cuda_version = path_to_ptxas()
+    return ptx_get_version(cuda_version)
 
 
 @functools.lru_cache
@@ -1108,7 +1356,48 @@ def path_to_ptxas():
     raise RuntimeError("Cannot find ptxas")
 
 
-instance_descriptor = namedtuple("instance_descriptor", ["divisible_by_16", "equal_to_1"], defaults=[set(), set()])
+def static_analysis_report(asm, metadata):
+    """
+    Static analysis of the binary of a kernel, read from its SASS (with
+    cuobjdump) or its GCN assembly: the registers per thread and the spilled
+    ones, the shared memory, the instruction mix (see
+    `tools.disasm.sass_instruction_mix`) and the occupancy the kernel can
+    achieve on a multiprocessor of its architecture. Returns None if the
+    binary can't be disassembled.
+    """
+    from .runtime.occupancy import DeviceLimits, occupancy
+    if "hsaco" in asm:
+        report = gcn_resource_usage(asm["amdgcn"])
+        report.update(gcn_instruction_mix(asm["amdgcn"]))
+    else:
+        if shutil.which("cuobjdump") is None:
+            return None
+        fd, path = tempfile.mkstemp()
+        try:
+            with open(fd, 'wb') as cubin:
+                cubin.write(asm["cubin"])
+            usage = resource_usage(path, metadata.get("name"))
+            sass = extract(path, metadata.get("name"))
+        except subprocess.CalledProcessError:
+            return None
+        finally:
+            os.remove(path)
+        if usage is None or sass is None:
+            return None
+        asm["sass"] = sass
+        # the registers spilled to local memory, as reported by the driver
+        report = {"registers": usage["registers"], "spills": usage["local"] // 4,
+                  "stack": usage["stack"], "local": usage["local"]}
+        report.update(sass_instruction_mix(sass))
+    report["shared"] = metadata["shared"]
+    report["occupancy"] = occupancy(DeviceLimits.for_arch(metadata["arch"]), metadata["num_warps"],
+                                    report["registers"] or None, report["shared"])
+    return report
+
+
+instance_descriptor = namedtuple("instance_descriptor", ["divisible_by_16", "equal_to_1", "version_alignment",
+                                                       "divisibility", "noalias"],
+                                 defaults=[set(), set(), set(), (), ()])
 
 
 # ------------------------------------------------------------------------------
@@ -1180,7 +1469,14 @@ def generate_launcher(constants, signature):
             "int64_t": "L",
         }[ty]
 
-    format = "iiiiiKKOOO" + ''.join([format_of(_extracted_type(ty)) for ty in signature.values()])
+    format = "iiiiipiKKOOO" + ''.join([format_of(_extracted_type(ty)) for ty in signature.values()])
+    # graph_node(graph, deps, stream, gridX, gridY, gridZ, num_threads, shared_memory, function, *args)
+    # graph_node_set_params(graph_exec, node, params, gridX, gridY, gridZ, num_threads, shared_memory, function, *args)
+    graph_format = "KOKiiiiiK" + ''.join([format_of(_extracted_type(ty)) for ty in signature.values()])
+    set_params_format = "KKOiiiiiK" + ''.join([format_of(_extracted_type(ty)) for ty in signature.values()])
+    params = [i for i in signature.keys() if i not in constants]
+    arg_decls_parsed = ' '.join([f"{_extracted_type(ty)} _arg{i}; " for i, ty in signature.items()])
+    arg_refs_parsed = ', '.join(f"&_arg{i}" for i, ty in signature.items())
 
     # generate glue code
     if torch.version.hip is not None:
@@ -1204,10 +1500,22 @@ def generate_launcher(constants, signature):
 
     #define HIP_CHECK(ans) {{ gpuAssert((ans), __FILE__, __LINE__); }}
 
-    void _launch(int gridX, int gridY, int gridZ, int num_warps, int shared_memory, hipStream_t stream, hipFunction_t function, {arg_decls}) {{
+    void _launch(int gridX, int gridY, int gridZ, int num_threads, int shared_memory, int cooperative, int num_ctas, hipStream_t stream, hipFunction_t function, {arg_decls}) {{
     void *params[] = {{ {', '.join(f"&arg{i}" for i in signature.keys() if i not in constants)} }};
-    if(gridX*gridY*gridZ > 0){{
-        HIP_CHECK(hipModuleLaunchKernel(function, gridX, gridY, gridZ, 32*num_warps, 1, 1, shared_memory, stream, params, 0));
+    if(gridX*gridY*gridZ > 0 && cooperative){{
+        // the programs of kernels with a grid barrier must all be resident
+        int device = 0, num_cus = 0, num_blocks = 0;
+        HIP_CHECK(hipGetDevice(&device));
+        HIP_CHECK(hipDeviceGetAttribute(&num_cus, hipDeviceAttributeMultiprocessorCount, device));
+        HIP_CHECK(hipModuleOccupancyMaxActiveBlocksPerMultiprocessor(&num_blocks, function, num_threads, shared_memory));
+        if (!PyErr_Occurred() && gridX*gridY*gridZ > num_blocks*num_cus) {{
+        PyErr_Format(PyExc_RuntimeError, "Triton Error [HIP]: grid of %d programs is larger than the %d that can be resident for a grid barrier", gridX*gridY*gridZ, num_blocks*num_cus);
+        }}
+        if (!PyErr_Occurred()) {{
+        HIP_CHECK(hipModuleLaunchCooperativeKernel(function, gridX, gridY, gridZ, num_threads, 1, 1, shared_memory, stream, params));
+        }}
+    }} else if(gridX*gridY*gridZ > 0){{
+        HIP_CHECK(hipModuleLaunchKernel(function, gridX, gridY, gridZ, num_threads, 1, 1, shared_memory, stream, params, 0));
     }}
     }}
 
@@ -1237,14 +1545,16 @@ def generate_launcher(constants, signature):
     int gridX, gridY, gridZ;
     uint64_t _stream;
     uint64_t _function;
-    int num_warps;
+    int num_threads;
     int shared_memory;
+    int cooperative;
+    int num_ctas;
     PyObject *launch_enter_hook = NULL;
     PyObject *launch_exit_hook = NULL;
     PyObject *compiled_kernel = NULL;
     PyObject *hook_ret = NULL;
     {' '.join([f"{_extracted_type(ty)} _arg{i}; " for i, ty in signature.items()])}
-    if(!PyArg_ParseTuple(args, \"{format}\", &gridX, &gridY, &gridZ, &num_warps, &shared_memory, &_stream, &_function, &launch_enter_hook, &launch_exit_hook, &compiled_kernel, {', '.join(f"&_arg{i}" for i, ty in signature.items())})) {{
+    if(!PyArg_ParseTuple(args, \"{format}\", &gridX, &gridY, &gridZ, &num_threads, &shared_memory, &cooperative, &num_ctas, &_stream, &_function, &launch_enter_hook, &launch_exit_hook, &compiled_kernel, {', '.join(f"&_arg{i}" for i, ty in signature.items())})) {{
         return NULL;
     }}
 
@@ -1254,7 +1564,7 @@ def generate_launcher(constants, signature):
         Py_DECREF(new_args);
     }}
 
-    _launch(gridX, gridY, gridZ, num_warps, shared_memory, (hipStream_t)_stream, (hipFunction_t)_function, {', '.join(f"getPointer(_arg{i},{i})" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items())});
+    _launch(gridX, gridY, gridZ, num_threads, shared_memory, cooperative, num_ctas, (hipStream_t)_stream, (hipFunction_t)_function, {', '.join(f"getPointer(_arg{i},{i})" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items())});
 
     if (launch_exit_hook != Py_None) {{
         PyObject *new_args = NULL;
@@ -1278,8 +1588,133 @@ def generate_launcher(constants, signature):
     return Py_None;
     }}
 
+    // Graph kernel nodes own a stable copy of their arguments, which is
+    // rewritten in place when the node is updated between replays
+    typedef struct _GraphParams {{
+    {' '.join(f"{ty_to_cpp(signature[i])} arg{i};" for i in params)}
+    void *params[{max(len(params), 1)}];
+    }} GraphParams;
+
+    static void freeGraphParams(PyObject *capsule) {{
+    free(PyCapsule_GetPointer(capsule, "GraphParams"));
+    }}
+
+    static void fillGraphParams(GraphParams *p, int gridX, int gridY, int gridZ, int num_threads, int shared_memory, hipFunction_t function, hipKernelNodeParams *node_params, {arg_decls}) {{
+    {' '.join(f"p->arg{i} = arg{i}; p->params[{j}] = &p->arg{i};" for j, i in enumerate(params))}
+    memset(node_params, 0, sizeof(*node_params));
+    node_params->func = (void*)function;
+    node_params->gridDim.x = gridX;
+    node_params->gridDim.y = gridY;
+    node_params->gridDim.z = gridZ;
+    node_params->blockDim.x = num_threads;
+    node_params->blockDim.y = 1;
+    node_params->blockDim.z = 1;
+    node_params->sharedMemBytes = shared_memory;
+    node_params->kernelParams = p->params;
+    }}
+
+    static PyObject* graph_node(PyObject* self, PyObject* args) {{
+    int gridX, gridY, gridZ;
+    uint64_t _graph;
+    uint64_t _stream;
+    uint64_t _function;
+    int num_threads;
+    int shared_memory;
+    PyObject *deps = NULL;
+    {arg_decls_parsed}
+    if(!PyArg_ParseTuple(args, \"{graph_format}\", &_graph, &deps, &_stream, &gridX, &gridY, &gridZ, &num_threads, &shared_memory, &_function, {arg_refs_parsed})) {{
+        return NULL;
+    }}
+
+    GraphParams *p = (GraphParams*)malloc(sizeof(GraphParams));
+    PyObject *capsule = PyCapsule_New(p, "GraphParams", freeGraphParams);
+    hipKernelNodeParams node_params;
+    fillGraphParams(p, gridX, gridY, gridZ, num_threads, shared_memory, (hipFunction_t)_function, &node_params, {', '.join(f"getPointer(_arg{i},{i})" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items())});
+    hipGraphNode_t node = NULL;
+    hipGraph_t graph = (hipGraph_t)_graph;
+    if (PyErr_Occurred()) {{
+        // invalid pointer arguments are reported below
+    }} else if (graph) {{
+        // explicit graph: the dependencies are a sequence of node handles
+        PyObject *seq = PySequence_Fast(deps, "graph node dependencies must be a sequence");
+        if (seq) {{
+        Py_ssize_t num_deps = PySequence_Fast_GET_SIZE(seq);
+        hipGraphNode_t *dep_nodes = (hipGraphNode_t*)malloc((num_deps + 1) * sizeof(hipGraphNode_t));
+        for (Py_ssize_t i = 0; i < num_deps; i++) {{
+            dep_nodes[i] = (hipGraphNode_t)PyLong_AsUnsignedLongLong(PySequence_Fast_GET_ITEM(seq, i));
+        }}
+        Py_DECREF(seq);
+        if (!PyErr_Occurred()) {{
+            HIP_CHECK(hipGraphAddKernelNode(&node, graph, dep_nodes, num_deps, &node_params));
+        }}
+        free(dep_nodes);
+        }}
+    }} else {{
+        // record into the capture in progress on the stream
+        hipStream_t stream = (hipStream_t)_stream;
+        hipStreamCaptureStatus status;
+        const hipGraphNode_t *dep_nodes = NULL;
+        size_t num_deps = 0;
+        HIP_CHECK(hipStreamGetCaptureInfo_v2(stream, &status, NULL, &graph, &dep_nodes, &num_deps));
+        if (!PyErr_Occurred() && status != hipStreamCaptureStatusActive) {{
+        PyErr_SetString(PyExc_RuntimeError, "graph_node requires a graph or a capturing stream");
+        }}
+        if (!PyErr_Occurred()) {{
+        HIP_CHECK(hipGraphAddKernelNode(&node, graph, dep_nodes, num_deps, &node_params));
+        }}
+        if (!PyErr_Occurred()) {{
+        HIP_CHECK(hipStreamUpdateCaptureDependencies(stream, &node, 1, hipStreamSetCaptureDependencies));
+        }}
+    }}
+
+    if(PyErr_Occurred()) {{
+        Py_DECREF(capsule);
+        return NULL;
+    }}
+    PyObject *ret = Py_BuildValue("(KO)", (uint64_t)node, capsule);
+    Py_DECREF(capsule);
+    return ret;
+    }}
+
+    static PyObject* graph_node_set_params(PyObject* self, PyObject* args) {{
+    int gridX, gridY, gridZ;
+    uint64_t _graph_exec;
+    uint64_t _node;
+    uint64_t _function;
+    int num_threads;
+    int shared_memory;
+    PyObject *capsule = NULL;
+    {arg_decls_parsed}
+    if(!PyArg_ParseTuple(args, \"{set_params_format}\", &_graph_exec, &_node, &capsule, &gridX, &gridY, &gridZ, &num_threads, &shared_memory, &_function, {arg_refs_parsed})) {{
+        return NULL;
+    }}
+    GraphParams *p = (GraphParams*)PyCapsule_GetPointer(capsule, "GraphParams");
+    if (!p) {{
+        return NULL;
+    }}
+
+    hipKernelNodeParams node_params;
+    fillGraphParams(p, gridX, gridY, gridZ, num_threads, shared_memory, (hipFunction_t)_function, &node_params, {', '.join(f"getPointer(_arg{i},{i})" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items())});
+    if (PyErr_Occurred()) {{
+        return NULL;
+    }}
+    if (_graph_exec) {{
+        HIP_CHECK(hipGraphExecKernelNodeSetParams((hipGraphExec_t)_graph_exec, (hipGraphNode_t)_node, &node_params));
+    }} else {{
+        HIP_CHECK(hipGraphKernelNodeSetParams((hipGraphNode_t)_node, &node_params));
+    }}
+    if(PyErr_Occurred()) {{
+        return NULL;
+    }}
+    // return None
+    Py_INCREF(Py_None);
+    return Py_None;
+    }}
+
     static PyMethodDef ModuleMethods[] = {{
     {{"launch", launch, METH_VARARGS, "Entry point for all kernels with this signature"}},
+    {{"graph_node", graph_node, METH_VARARGS, "Add a kernel node to a graph or to the capture of a stream"}},
+    {{"graph_node_set_params", graph_node_set_params, METH_VARARGS, "Update the grid and arguments of a kernel node"}},
     {{NULL, NULL, 0, NULL}} // sentinel
     }};
 
@@ -1322,10 +1757,50 @@ def generate_launcher(constants, signature):
 
     #define CUDA_CHECK(ans) {{ gpuAssert((ans), __FILE__, __LINE__); }}
 
-    void _launch(int gridX, int gridY, int gridZ, int num_warps, int shared_memory, CUstream stream, CUfunction function, {arg_decls}) {{
+    void _launch(int gridX, int gridY, int gridZ, int num_threads, int shared_memory, int cooperative, int num_ctas, CUstream stream, CUfunction function, {arg_decls}) {{
       void *params[] = {{ {', '.join(f"&arg{i}" for i in signature.keys() if i not in constants)} }};
-      if(gridX*gridY*gridZ > 0){{
-        CUDA_CHECK(cuLaunchKernel(function, gridX, gridY, gridZ, 32*num_warps, 1, 1, shared_memory, stream, params, 0));
+      if(gridX*gridY*gridZ > 0 && cooperative){{
+        // the programs of kernels with a grid barrier must all be resident
+        CUdevice device;
+        int num_sms = 0, num_blocks = 0;
+        CUDA_CHECK(cuCtxGetDevice(&device));
+        CUDA_CHECK(cuDeviceGetAttribute(&num_sms, CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT, device));
+        CUDA_CHECK(cuOccupancyMaxActiveBlocksPerMultiprocessor(&num_blocks, function, num_threads, shared_memory));
+        if (!PyErr_Occurred() && gridX*gridY*gridZ > num_blocks*num_sms) {{
+          PyErr_Format(PyExc_RuntimeError, "Triton Error [CUDA]: grid of %d programs is larger than the %d that can be resident for a grid barrier", gridX*gridY*gridZ, num_blocks*num_sms);
+        }}
+        if (!PyErr_Occurred()) {{
+          CUDA_CHECK(cuLaunchCooperativeKernel(function, gridX, gridY, gridZ, num_threads, 1, 1, shared_memory, stream, params));
+        }}
+      }} else if(gridX*gridY*gridZ > 0 && num_ctas > 1){{
+        // thread block clusters of num_ctas consecutive programs along x
+        if (gridX % num_ctas != 0) {{
+          PyErr_Format(PyExc_ValueError, "Triton Error [CUDA]: grid size along x (%d) is not a multiple of num_ctas (%d)", gridX, num_ctas);
+          return;
+        }}
+#if CUDA_VERSION >= 12000
+        CUlaunchAttribute attr;
+        attr.id = CU_LAUNCH_ATTRIBUTE_CLUSTER_DIMENSION;
+        attr.value.clusterDim.x = num_ctas;
+        attr.value.clusterDim.y = 1;
+        attr.value.clusterDim.z = 1;
+        CUlaunchConfig config;
+        config.gridDimX = gridX;
+        config.gridDimY = gridY;
+        config.gridDimZ = gridZ;
+        config.blockDimX = num_threads;
+        config.blockDimY = 1;
+        config.blockDimZ = 1;
+        config.sharedMemBytes = shared_memory;
+        config.hStream = stream;
+        config.attrs = &attr;
+        config.numAttrs = 1;
+        CUDA_CHECK(cuLaunchKernelEx(&config, function, params, 0));
+#else
+        PyErr_SetString(PyExc_RuntimeError, "Triton Error [CUDA]: thread block clusters require CUDA 12");
+#endif
+      }} else if(gridX*gridY*gridZ > 0){{
+        CUDA_CHECK(cuLaunchKernel(function, gridX, gridY, gridZ, num_threads, 1, 1, shared_memory, stream, params, 0));
       }}
     }}
 
@@ -1378,14 +1853,16 @@ def generate_launcher(constants, signature):
       int gridX, gridY, gridZ;
       uint64_t _stream;
       uint64_t _function;
-      int num_warps;
+      int num_threads;
       int shared_memory;
+      int cooperative;
+      int num_ctas;
       PyObject *launch_enter_hook = NULL;
       PyObject *launch_exit_hook = NULL;
       PyObject *compiled_kernel = NULL;
       PyObject *hook_ret = NULL;
       {' '.join([f"{_extracted_type(ty)} _arg{i}; " for i, ty in signature.items()])}
-      if(!PyArg_ParseTuple(args, \"{format}\", &gridX, &gridY, &gridZ, &num_warps, &shared_memory, &_stream, &_function, &launch_enter_hook, &launch_exit_hook, &compiled_kernel, {', '.join(f"&_arg{i}" for i, ty in signature.items())})) {{
+      if(!PyArg_ParseTuple(args, \"{format}\", &gridX, &gridY, &gridZ, &num_threads, &shared_memory, &cooperative, &num_ctas, &_stream, &_function, &launch_enter_hook, &launch_exit_hook, &compiled_kernel, {', '.join(f"&_arg{i}" for i, ty in signature.items())})) {{
         return NULL;
       }}
 
@@ -1398,7 +1875,7 @@ def generate_launcher(constants, signature):
 
       // raise exception asap
       {"; ".join([f"DevicePtrInfo ptr_info{i} = getPointer(_arg{i}, {i}); if (!ptr_info{i}.valid) return NULL;" if ty[0] == "*" else "" for i, ty in signature.items()])};
-      _launch(gridX, gridY, gridZ, num_warps, shared_memory, (CUstream)_stream, (CUfunction)_function, {', '.join(f"ptr_info{i}.dev_ptr" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items())});
+      _launch(gridX, gridY, gridZ, num_threads, shared_memory, cooperative, num_ctas, (CUstream)_stream, (CUfunction)_function, {', '.join(f"ptr_info{i}.dev_ptr" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items())});
 
       if (launch_exit_hook != Py_None) {{
         PyObject *new_args = NULL;
@@ -1422,8 +1899,132 @@ def generate_launcher(constants, signature):
       return Py_None;
     }}
 
+    // Graph kernel nodes own a stable copy of their arguments, which is
+    // rewritten in place when the node is updated between replays
+    typedef struct _GraphParams {{
+      {' '.join(f"{ty_to_cpp(signature[i])} arg{i};" for i in params)}
+      void *params[{max(len(params), 1)}];
+    }} GraphParams;
+
+    static void freeGraphParams(PyObject *capsule) {{
+      free(PyCapsule_GetPointer(capsule, "GraphParams"));
+    }}
+
+    static void fillGraphParams(GraphParams *p, int gridX, int gridY, int gridZ, int num_threads, int shared_memory, CUfunction function, CUDA_KERNEL_NODE_PARAMS *node_params, {arg_decls}) {{
+      {' '.join(f"p->arg{i} = arg{i}; p->params[{j}] = &p->arg{i};" for j, i in enumerate(params))}
+      memset(node_params, 0, sizeof(*node_params));
+      node_params->func = function;
+      node_params->gridDimX = gridX;
+      node_params->gridDimY = gridY;
+      node_params->gridDimZ = gridZ;
+      node_params->blockDimX = num_threads;
+      node_params->blockDimY = 1;
+      node_params->blockDimZ = 1;
+      node_params->sharedMemBytes = shared_memory;
+      node_params->kernelParams = p->params;
+    }}
+
+    static PyObject* graph_node(PyObject* self, PyObject* args) {{
+      int gridX, gridY, gridZ;
+      uint64_t _graph;
+      uint64_t _stream;
+      uint64_t _function;
+      int num_threads;
+      int shared_memory;
+      PyObject *deps = NULL;
+      {arg_decls_parsed}
+      if(!PyArg_ParseTuple(args, \"{graph_format}\", &_graph, &deps, &_stream, &gridX, &gridY, &gridZ, &num_threads, &shared_memory, &_function, {arg_refs_parsed})) {{
+        return NULL;
+      }}
+
+      // raise exception asap
+      {"; ".join([f"DevicePtrInfo ptr_info{i} = getPointer(_arg{i}, {i}); if (!ptr_info{i}.valid) return NULL;" if ty[0] == "*" else "" for i, ty in signature.items()])};
+      GraphParams *p = (GraphParams*)malloc(sizeof(GraphParams));
+      PyObject *capsule = PyCapsule_New(p, "GraphParams", freeGraphParams);
+      CUDA_KERNEL_NODE_PARAMS node_params;
+      fillGraphParams(p, gridX, gridY, gridZ, num_threads, shared_memory, (CUfunction)_function, &node_params, {', '.join(f"ptr_info{i}.dev_ptr" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items())});
+      CUgraphNode node = NULL;
+      CUgraph graph = (CUgraph)_graph;
+      if (graph) {{
+        // explicit graph: the dependencies are a sequence of node handles
+        PyObject *seq = PySequence_Fast(deps, "graph node dependencies must be a sequence");
+        if (seq) {{
+          Py_ssize_t num_deps = PySequence_Fast_GET_SIZE(seq);
+          CUgraphNode *dep_nodes = (CUgraphNode*)malloc((num_deps + 1) * sizeof(CUgraphNode));
+          for (Py_ssize_t i = 0; i < num_deps; i++) {{
+            dep_nodes[i] = (CUgraphNode)PyLong_AsUnsignedLongLong(PySequence_Fast_GET_ITEM(seq, i));
+          }}
+          Py_DECREF(seq);
+          if (!PyErr_Occurred()) {{
+            CUDA_CHECK(cuGraphAddKernelNode(&node, graph, dep_nodes, num_deps, &node_params));
+          }}
+          free(dep_nodes);
+        }}
+      }} else {{
+        // record into the capture in progress on the stream
+        CUstream stream = (CUstream)_stream;
+        CUstreamCaptureStatus status;
+        const CUgraphNode *dep_nodes = NULL;
+        size_t num_deps = 0;
+        CUDA_CHECK(cuStreamGetCaptureInfo_v2(stream, &status, NULL, &graph, &dep_nodes, &num_deps));
+        if (!PyErr_Occurred() && status != CU_STREAM_CAPTURE_STATUS_ACTIVE) {{
+          PyErr_SetString(PyExc_RuntimeError, "graph_node requires a graph or a capturing stream");
+        }}
+        if (!PyErr_Occurred()) {{
+          CUDA_CHECK(cuGraphAddKernelNode(&node, graph, dep_nodes, num_deps, &node_params));
+        }}
+        if (!PyErr_Occurred()) {{
+          CUDA_CHECK(cuStreamUpdateCaptureDependencies(stream, &node, 1, CU_STREAM_SET_CAPTURE_DEPENDENCIES));
+        }}
+      }}
+
+      if(PyErr_Occurred()) {{
+        Py_DECREF(capsule);
+        return NULL;
+      }}
+      PyObject *ret = Py_BuildValue("(KO)", (uint64_t)node, capsule);
+      Py_DECREF(capsule);
+      return ret;
+    }}
+
+    static PyObject* graph_node_set_params(PyObject* self, PyObject* args) {{
+      int gridX, gridY, gridZ;
+      uint64_t _graph_exec;
+      uint64_t _node;
+      uint64_t _function;
+      int num_threads;
+      int shared_memory;
+      PyObject *capsule = NULL;
+      {arg_decls_parsed}
+      if(!PyArg_ParseTuple(args, \"{set_params_format}\", &_graph_exec, &_node, &capsule, &gridX, &gridY, &gridZ, &num_threads, &shared_memory, &_function, {arg_refs_parsed})) {{
+        return NULL;
+      }}
+      GraphParams *p = (GraphParams*)PyCapsule_GetPointer(capsule, "GraphParams");
+      if (!p) {{
+        return NULL;
+      }}
+
+      // raise exception asap
+      {"; ".join([f"DevicePtrInfo ptr_info{i} = getPointer(_arg{i}, {i}); if (!ptr_info{i}.valid) return NULL;" if ty[0] == "*" else "" for i, ty in signature.items()])};
+      CUDA_KERNEL_NODE_PARAMS node_params;
+      fillGraphParams(p, gridX, gridY, gridZ, num_threads, shared_memory, (CUfunction)_function, &node_params, {', '.join(f"ptr_info{i}.dev_ptr" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items())});
+      if (_graph_exec) {{
+        CUDA_CHECK(cuGraphExecKernelNodeSetParams((CUgraphExec)_graph_exec, (CUgraphNode)_node, &node_params));
+      }} else {{
+        CUDA_CHECK(cuGraphKernelNodeSetParams((CUgraphNode)_node, &node_params));
+      }}
+      if(PyErr_Occurred()) {{
+        return NULL;
+      }}
+      // return None
+      Py_INCREF(Py_None);
+      return Py_None;
+    }}
+
     static PyMethodDef ModuleMethods[] = {{
       {{"launch", launch, METH_VARARGS, "Entry point for all kernels with this signature"}},
+      {{"graph_node", graph_node, METH_VARARGS, "Add a kernel node to a graph or to the capture of a stream"}},
+      {{"graph_node_set_params", graph_node_set_params, METH_VARARGS, "Update the grid and arguments of a kernel node"}},
       {{NULL, NULL, 0, NULL}} // sentinel
     }};
 
@@ -1456,17 +2057,159 @@ def default_cuda_dir():
     return os.getenv("CUDA_HOME", default=default_dir)
 
 
+def parse_cache_size(size):
+    units = {"K": 1 << 10, "M": 1 << 20, "G": 1 << 30, "T": 1 << 40}
+    size = size.strip().upper().rstrip("B")
+    if size and size[-1] in units:
+        return int(float(size[:-1]) * units[size[-1]])
+    return int(size) if size else 0
+
+
+def make_compile_report(stage_times, records):
+    '''
+    Group the (phase, seconds) records of the compile timer by kind: MLIR
+    passes, LLVM phases and external tools. Repeated phases are summed.
+    '''
+    report = {"stages": stage_times, "passes": dict(), "llvm": dict(), "tools": dict()}
+    groups = {"pass": "passes", "llvm": "llvm", "tool": "tools"}
+    for phase, seconds in records:
+        kind, name = phase.split("/", 1)
+        group = report[groups[kind]]
+        group[name] = group.get(name, 0.) + seconds
+    return report
+
+
+def format_compile_report(name, report):
+    lines = [f"// -----// Compile times of {name} (s) //----- //"]
+    for group in ["stages", "passes", "llvm", "tools"]:
+        if not report[group]:
+            continue
+        lines.append(f"{group}:")
+        for phase, seconds in sorted(report[group].items(), key=lambda item: -item[1]):
+            lines.append(f"  {seconds:10.4f}  {phase}")
+    return "\n".join(lines)
+
+
+def file_digest(path):
+    with open(path, "rb") as f:
+        return hashlib.md5(f.read()).hexdigest()
+
+
+class CachedModule:
+    """
+    An MLIR stage read from the cache, only parsed if a later stage is
+    compiled from it. Its text is that of the file, which was printed from the
+    module.
+    """
+
+    def __init__(self, parse, path):
+        self._parse = parse
+        self._path = path
+        self._text = Path(path).read_text()
+
+    def parse(self):
+        return self._parse(self._path)
+
+    def __str__(self):
+        return self._text
+
+
+class CachedAsm(collections.abc.MutableMapping):
+    """
+    The assembly of a kernel whose stages are all in the cache, read when it
+    is first accessed rather than when the kernel is loaded. Binaries are
+    memory-mapped. A stage is checked against its digest when it is read, and
+    if the cache changed in the meantime, `recompile` rebuilds the whole
+    assembly.
+    """
+
+    BINARIES = ("cubin", "hsaco")
+
+    def __init__(self, asm, paths, digests, recompile):
+        self._asm = dict(asm)
+        self._paths = dict(paths)
+        self._digests = digests
+        self._recompile = recompile
+        # the stages may be read by `prefetch_kernels` concurrently
+        self._lock = threading.Lock()
+
+    def _read(self, ir):
+        path = self._paths.pop(ir)
+        try:
+            with open(path, "rb") as f:
+                data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except (OSError, ValueError):
+            data = None
+        digest = self._digests.get(ir)
+        if data is None or (digest is not None and hashlib.md5(data).hexdigest() != digest):
+            self._asm.update(self._recompile())
+            self._paths.clear()
+        elif ir in self.BINARIES:
+            self._asm[ir] = data
+        else:
+            self._asm[ir] = data[:].decode("utf-8")
+            data.close()
+
+    def __getitem__(self, ir):
+        with self._lock:
+            if ir in self._paths:
+                self._read(ir)
+            return self._asm[ir]
+
+    def __setitem__(self, ir, value):
+        with self._lock:
+            self._paths.pop(ir, None)
+            self._asm[ir] = value
+
+    def __delitem__(self, ir):
+        with self._lock:
+            if ir not in self:
+                raise KeyError(ir)
+            self._paths.pop(ir, None)
+            self._asm.pop(ir, None)
+
+    def __contains__(self, ir):
+        return ir in self._asm or ir in self._paths
+
+    def __iter__(self):
+        return iter(list(self._asm) + [ir for ir in self._paths if ir not in self._asm])
+
+    def __len__(self):
+        return len(set(self._asm) | set(self._paths))
+
+
 class CacheManager:
+    """
+    A directory of compiled artifacts per key, where the key is a hash of the
+    compilation inputs.
+
+    Files are published by atomically renaming a uniquely named temporary, so
+    concurrent writers of a key need no lock and readers never observe partial
+    files. Each hit refreshes the modification time of the key's directory, and
+    the least recently used keys are evicted once the cache grows beyond
+    `TRITON_CACHE_MAX_SIZE` (in bytes, with an optional K/M/G suffix).
+
+    If `TRITON_REMOTE_CACHE_DIR` points to a shared directory, files are also
+    published there, and local misses are fetched from it, so that a kernel
+    compiled by one rank is loaded by the others.
+    """
+
+    # bytes written by this process since the size of the cache was last checked
+    bytes_since_eviction = None
 
     def __init__(self, key):
         self.key = key
-        self.lock_path = None
+        self.remote_dir = None
         # create cache directory if it doesn't exist
         self.cache_dir = os.environ.get('TRITON_CACHE_DIR', default_cache_dir())
         if self.cache_dir:
+            self.root_dir = self.cache_dir
             self.cache_dir = os.path.join(self.cache_dir, self.key)
-            self.lock_path = os.path.join(self.cache_dir, "lock")
             os.makedirs(self.cache_dir, exist_ok=True)
+            remote_dir = os.environ.get('TRITON_REMOTE_CACHE_DIR', "")
+            if remote_dir:
+                self.remote_dir = os.path.join(remote_dir, self.key)
+                os.makedirs(self.remote_dir, exist_ok=True)
 
     def _make_path(self, filename):
         return os.path.join(self.cache_dir, filename)
@@ -1474,7 +2217,38 @@ class CacheManager:
     def has_file(self, filename):
         if not self.cache_dir:
             return False
-        return os.path.exists(self._make_path(filename))
+        if os.path.exists(self._make_path(filename)):
+            # refresh the entry for eviction
+            os.utime(self.cache_dir)
+            return True
+        # fetch the file from the shared tier
+        if self.remote_dir is None:
+            return False
+        remote_path = os.path.join(self.remote_dir, filename)
+        try:
+            with open(remote_path, "rb") as f:
+                data = f.read()
+        except OSError:
+            return False
+        self._publish(self._make_path(filename), data)
+        return True
+
+    def list_files(self):
+        if not self.cache_dir:
+            return []
+        filenames = set(os.listdir(self.cache_dir))
+        if self.remote_dir is not None:
+            filenames.update(os.listdir(self.remote_dir))
+        return sorted(filename for filename in filenames if ".tmp." not in filename)
+
+    @staticmethod
+    def _publish(filepath, data):
+        mode = "wb" if isinstance(data, bytes) else "w"
+        # write under a name unique to this writer, then publish atomically
+        tmp_path = f"{filepath}.tmp.{uuid.uuid4().hex}"
+        with open(tmp_path, mode) as f:
+            f.write(data)
+        os.replace(tmp_path, filepath)
 
     def put(self, data, filename, binary=True):
         if not self.cache_dir:
@@ -1482,14 +2256,51 @@ class CacheManager:
         binary = isinstance(data, bytes)
         if not binary:
             data = str(data)
-        assert self.lock_path is not None
-        filepath = self._make_path(filename)
-        with FileLock(self.lock_path):
-            # use tempfile to be robust against program interruptions
-            mode = "wb" if binary else "w"
-            with open(filepath + ".tmp", mode) as f:
-                f.write(data)
-            os.rename(filepath + ".tmp", filepath)
+        self._publish(self._make_path(filename), data)
+        if self.remote_dir is not None:
+            try:
+                self._publish(os.path.join(self.remote_dir, filename), data)
+            except OSError:
+                # the shared tier is best effort
+                pass
+        self._evict(len(data))
+
+    def _evict(self, num_bytes):
+        max_size = parse_cache_size(os.environ.get('TRITON_CACHE_MAX_SIZE', ""))
+        if max_size <= 0:
+            return
+        # the cache is scanned on the first write of the process, and then
+        # whenever it may have grown by 5% of its capacity
+        if CacheManager.bytes_since_eviction is not None:
+            CacheManager.bytes_since_eviction += num_bytes
+            if CacheManager.bytes_since_eviction < max_size // 20:
+                return
+        CacheManager.bytes_since_eviction = 0
+        entries = []
+        for key in os.listdir(self.root_dir):
+            path = os.path.join(self.root_dir, key)
+            if key.startswith(".") or key == self.key or not os.path.isdir(path):
+                continue
+            try:
+                size = sum(entry.stat().st_size for entry in os.scandir(path) if entry.is_file())
+                entries.append((os.path.getmtime(path), size, key))
+            except OSError:
+                continue
+        total_size = sum(size for _, size, _ in entries) + \
+            sum(entry.stat().st_size for entry in os.scandir(self.cache_dir) if entry.is_file())
+        for _, size, key in sorted(entries):
+            if total_size <= max_size:
+                break
+            # move the entry out of the way first, so that readers either see
+            # all of its files or none of them
+            path = os.path.join(self.root_dir, key)
+            evicted_path = os.path.join(self.root_dir, f".{key}.evicted.{uuid.uuid4().hex}")
+            try:
+                os.rename(path, evicted_path)
+            except OSError:
+                continue
+            shutil.rmtree(evicted_path, ignore_errors=True)
+            total_size -= size
 
 
 # Utilities for generating and compiling C wrappers
@@ -1523,23 +2334,21 @@ def hip_home_dirs():
 def rocm_path_dir():
     return os.getenv("ROCM_PATH", default="/opt/rocm")
 
-def _build(name, src, srcdir):
+def _gpu_include_dir():
+    # headers of the driver API
     if torch.version.hip is not None:
-        hip_lib_dir = libhip_dir()
-        hip_include_dir = os.path.join(hip_home_dirs(), "include")
-    else:
-        cuda_lib_dirs = libcuda_dirs()
-        cuda_path = os.environ.get('CUDA_PATH', default_cuda_dir())
-        cu_include_dir = os.path.join(cuda_path, "include")
-        triton_include_dir = os.path.join(os.path.dirname(__file__), "include")
-        cuda_header = os.path.join(cu_include_dir, "cuda.h")
-        triton_cuda_header = os.path.join(triton_include_dir, "cuda.h")
-        if not os.path.exists(cuda_header) and os.path.exists(triton_cuda_header):
-            cu_include_dir = triton_include_dir
-
-    suffix = sysconfig.get_config_var('EXT_SUFFIX')
-    so = os.path.join(srcdir, '{name}{suffix}'.format(name=name, suffix=suffix))
-    # try to avoid setuptools if possible
+        return os.path.join(hip_home_dirs(), "include")
+    cuda_path = os.environ.get('CUDA_PATH', default_cuda_dir())
+    cu_include_dir = os.path.join(cuda_path, "include")
+    triton_include_dir = os.path.join(os.path.dirname(__file__), "include")
+    cuda_header = os.path.join(cu_include_dir, "cuda.h")
+    triton_cuda_header = os.path.join(triton_include_dir, "cuda.h")
+    if not os.path.exists(cuda_header) and os.path.exists(triton_cuda_header):
+        return triton_include_dir
+    return cu_include_dir
+
+
+def _c_compiler():
     cc = os.environ.get("CC")
     if cc is None:
         # TODO: support more things here.
@@ -1548,6 +2357,21 @@ def _build(name, src, srcdir):
         cc = gcc if gcc is not None else clang
         if cc is None:
             raise RuntimeError("Failed to find C compiler. Please specify via CC environment variable.")
+    return cc
+
+
+def _build(name, src, srcdir):
+    if torch.version.hip is not None:
+        hip_lib_dir = libhip_dir()
+        hip_include_dir = _gpu_include_dir()
+    else:
+        cuda_lib_dirs = libcuda_dirs()
+        cu_include_dir = _gpu_include_dir()
+
+    suffix = sysconfig.get_config_var('EXT_SUFFIX')
+    so = os.path.join(srcdir, '{name}{suffix}'.format(name=name, suffix=suffix))
+    # try to avoid setuptools if possible
+    cc = _c_compiler()
     py_include_dir = get_paths()["include"]
     if torch.version.hip is not None:
         ret = subprocess.check_call([cc, src, f"-I{hip_include_dir}", f"-I{py_include_dir}", f"-I{srcdir}", "-shared", "-fPIC", f"-L{hip_lib_dir}", "-lamdhip64", "-o", so])
@@ -1601,7 +2425,9 @@ def make_so_cache_key(version_hash, signature, constants):
 
 def make_fn_cache_key(fn_hash, signature, configs, constants, num_warps, num_stages):
     # Get unique key for the compiled code
-    get_conf_key = lambda conf: (sorted(conf.divisible_by_16), sorted(conf.equal_to_1))
+    get_conf_key = lambda conf: (sorted(conf.divisible_by_16), sorted(conf.equal_to_1),
+                                 sorted(getattr(conf, "version_alignment", ())), sorted(getattr(conf, "divisibility", ())),
+                                 sorted(getattr(conf, "noalias", ())))
     configs_key = [get_conf_key(conf) for conf in configs]
     key = f"{fn_hash}-{''.join(signature.values())}-{configs_key}-{constants}-{num_warps}-{num_stages}"
     key = hashlib.md5(key.encode("utf-8")).hexdigest()
@@ -1634,6 +2460,24 @@ def _get_amdgpu_arch():
     except:
         return None
 
+
+@functools.lru_cache()
+def get_device_arch(device):
+    # architecture the kernels of a device are compiled for, e.g. sm80 or gfx90a
+    if torch.version.hip is not None:
+        return os.environ.get('MI_GPU_ARCH', compile.discovered_gfx_arch)
+    capability = torch.cuda.get_device_capability(device)
+    return f"sm{capability[0] * 10 + capability[1]}"
+
+
+def _json_constant(value):
+    if isinstance(value, triton.language.constexpr):
+        value = value.value
+    if value is None or isinstance(value, (bool, int, float, str)):
+        return value
+    return repr(value)
+
+
 def make_stub(name, signature, constants):
     # name of files that are cached
     so_cache_key = make_so_cache_key(triton.runtime.jit.version_key(), signature, constants)
@@ -1652,6 +2496,245 @@ def make_stub(name, signature, constants):
     return so_cache_manager._make_path(so_name)
 
 
+def generate_cpu_launcher(name, constants, signature):
+    def cpu_ty(ty):
+        if ty[0] == '*':
+            return "void*"
+        if ty in ("fp16", "bf16"):
+            raise NotImplementedError(f"{ty} scalar arguments are not supported on the CPU")
+        return {
+            "i1": "_Bool",
+            "i8": "int8_t",
+            "i16": "int16_t",
+            "i32": "int32_t",
+            "i64": "int64_t",
+            "u32": "uint32_t",
+            "u64": "uint64_t",
+            "fp32": "float",
+            "f32": "float",
+            "fp64": "double",
+        }[ty]
+
+    def _extracted_type(ty):
+        if ty[0] == '*':
+            return "PyObject*"
+        return {
+            "_Bool": "int32_t",
+            "int8_t": "int32_t",
+            "int16_t": "int32_t",
+        }.get(cpu_ty(ty), cpu_ty(ty))
+
+    format_of = {
+        "PyObject*": "O",
+        "float": "f",
+        "double": "d",
+        "uint32_t": "I",
+        "int32_t": "i",
+        "uint64_t": "K",
+        "int64_t": "L",
+    }
+    # launch(gridX, gridY, gridZ, num_threads, *args)
+    format = "iiii" + ''.join(format_of[_extracted_type(ty)] for ty in signature.values())
+    params = [i for i in signature.keys() if i not in constants]
+    kernel_decls = ''.join(f"{cpu_ty(signature[i])}, " for i in params)
+    field_decls = ' '.join(f"{cpu_ty(signature[i])} arg{i};" for i in params)
+    arg_decls_parsed = ' '.join(f"{_extracted_type(ty)} _arg{i};" for i, ty in signature.items())
+    arg_refs_parsed = ''.join(f", &_arg{i}" for i in signature.keys())
+    arg_fields = ''.join(f"pool.args.arg{i}, " for i in params)
+
+    def arg_value(i):
+        if signature[i][0] == '*':
+            return f"getPointer(_arg{i}, {i})"
+        return f"({cpu_ty(signature[i])})_arg{i}"
+    args_init = ' '.join(f"args.arg{i} = {arg_value(i)};" for i in params)
+
+    # The programs of a launch are run by a pool of threads, which pick them
+    # in order with an atomic counter; the calling thread is one of them
+    return f"""
+#include <Python.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+void {name}({kernel_decls}int32_t, int32_t, int32_t, int32_t, int32_t, int32_t);
+
+typedef struct {{ {field_decls} }} args_t;
+
+static struct {{
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  int num_workers;
+  int active;
+  int running;
+  uint64_t generation;
+  int32_t gridX, gridY, gridZ;
+  int64_t next, total;
+  args_t args;
+}} pool = {{PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER}};
+
+// launches from different Python threads are serialized
+static pthread_mutex_t launch_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void run_programs(void) {{
+  for (;;) {{
+    int64_t pid = __atomic_fetch_add(&pool.next, 1, __ATOMIC_RELAXED);
+    if (pid >= pool.total)
+      return;
+    int32_t x = pid % pool.gridX;
+    int32_t y = (pid / pool.gridX) % pool.gridY;
+    int32_t z = pid / ((int64_t)pool.gridX * pool.gridY);
+    {name}({arg_fields}x, y, z, pool.gridX, pool.gridY, pool.gridZ);
+  }}
+}}
+
+static void *worker(void *arg) {{
+  int index = (int)(intptr_t)arg;
+  uint64_t seen = 0;
+  pthread_mutex_lock(&pool.lock);
+  for (;;) {{
+    while (pool.generation == seen)
+      pthread_cond_wait(&pool.start, &pool.lock);
+    seen = pool.generation;
+    if (index >= pool.active)
+      continue;
+    pthread_mutex_unlock(&pool.lock);
+    run_programs();
+    pthread_mutex_lock(&pool.lock);
+    if (--pool.running == 0)
+      pthread_cond_signal(&pool.done);
+  }}
+  return NULL;
+}}
+
+static void _launch(int gridX, int gridY, int gridZ, int num_threads, args_t *args) {{
+  int64_t total = (int64_t)gridX * gridY * gridZ;
+  if (total <= 0)
+    return;
+  int64_t workers = num_threads - 1 < total - 1 ? num_threads - 1 : total - 1;
+  pthread_mutex_lock(&launch_lock);
+  pthread_mutex_lock(&pool.lock);
+  while (pool.num_workers < workers) {{
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, worker, (void *)(intptr_t)pool.num_workers))
+      break;
+    pthread_detach(thread);
+    pool.num_workers++;
+  }}
+  if (workers > pool.num_workers)
+    workers = pool.num_workers;
+  if (workers < 0)
+    workers = 0;
+  pool.args = *args;
+  pool.gridX = gridX;
+  pool.gridY = gridY;
+  pool.gridZ = gridZ;
+  pool.next = 0;
+  pool.total = total;
+  pool.active = workers;
+  pool.running = workers;
+  pool.generation++;
+  pthread_cond_broadcast(&pool.start);
+  pthread_mutex_unlock(&pool.lock);
+  run_programs();
+  pthread_mutex_lock(&pool.lock);
+  while (pool.running > 0)
+    pthread_cond_wait(&pool.done, &pool.lock);
+  pthread_mutex_unlock(&pool.lock);
+  pthread_mutex_unlock(&launch_lock);
+}}
+
+static inline void *getPointer(PyObject *obj, int idx) {{
+  if (PyLong_Check(obj)) {{
+    return (void *)PyLong_AsUnsignedLongLong(obj);
+  }}
+  if (obj == Py_None) {{
+    return NULL;
+  }}
+  PyObject *ptr = PyObject_GetAttrString(obj, "data_ptr");
+  if (ptr) {{
+    PyObject *empty_tuple = PyTuple_New(0);
+    PyObject *ret = PyObject_Call(ptr, empty_tuple, NULL);
+    Py_DECREF(empty_tuple);
+    Py_DECREF(ptr);
+    if (!ret)
+      return NULL;
+    if (!PyLong_Check(ret)) {{
+      PyErr_SetString(PyExc_TypeError, "data_ptr method of Pointer object must return 64-bit int");
+    }}
+    void *result = (void *)PyLong_AsUnsignedLongLong(ret);
+    Py_DECREF(ret);
+    return result;
+  }}
+  PyErr_SetString(PyExc_TypeError, "Pointer argument must be either uint64 or have data_ptr method");
+  return NULL;
+}}
+
+static PyObject* launch(PyObject* self, PyObject* args_tuple) {{
+  int gridX, gridY, gridZ, num_threads;
+  {arg_decls_parsed}
+  if (!PyArg_ParseTuple(args_tuple, \"{format}\", &gridX, &gridY, &gridZ, &num_threads{arg_refs_parsed})) {{
+    return NULL;
+  }}
+  args_t args;
+  {args_init}
+  if (PyErr_Occurred()) {{
+    return NULL;
+  }}
+  Py_BEGIN_ALLOW_THREADS;
+  _launch(gridX, gridY, gridZ, num_threads, &args);
+  Py_END_ALLOW_THREADS;
+  Py_INCREF(Py_None);
+  return Py_None;
+}}
+
+static PyMethodDef ModuleMethods[] = {{
+  {{"launch", launch, METH_VARARGS, "Entry point for all kernels with this signature"}},
+  {{NULL, NULL, 0, NULL}} // sentinel
+}};
+
+static struct PyModuleDef ModuleDef = {{
+  PyModuleDef_HEAD_INIT,
+  \"cpu_launcher\",
+  NULL, //documentation
+  -1, //size
+  ModuleMethods
+}};
+
+PyMODINIT_FUNC PyInit_cpu_launcher(void) {{
+  PyObject *m = PyModule_Create(&ModuleDef);
+  if(m == NULL) {{
+    return NULL;
+  }}
+  PyModule_AddFunctions(m, ModuleMethods);
+  return m;
+}}
+"""
+
+
+def make_cpu_stub(name, signature, constants, obj):
+    # the launcher is linked with the kernel, whose object is part of the key
+    so_cache_key = make_so_cache_key(triton.runtime.jit.version_key() + hashlib.md5(obj).hexdigest(),
+                                     signature, constants)
+    so_cache_manager = CacheManager(so_cache_key)
+    so_name = f"{name}.cpu.so"
+    if not so_cache_manager.has_file(so_name):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            src_path = os.path.join(tmpdir, "main.c")
+            with open(src_path, "w") as f:
+                f.write(generate_cpu_launcher(name, constants, signature))
+            obj_path = os.path.join(tmpdir, "kernel.o")
+            with open(obj_path, "wb") as f:
+                f.write(obj)
+            so = os.path.join(tmpdir, "launcher.so")
+            py_include_dir = get_paths()["include"]
+            subprocess.check_call([_c_compiler(), src_path, obj_path, "-O3", f"-I{py_include_dir}", "-shared",
+                                   "-fPIC", "-lpthread", "-o", so])
+            with open(so, "rb") as f:
+                so_cache_manager.put(f.read(), so_name, binary=True)
+    return so_cache_manager._make_path(so_name)
+
+
 def convert_type_repr(x):
     match = re.search(r'!tt\.ptr<(.*)>', x)
     if match is not None:
@@ -1666,13 +2749,36 @@ def make_hash(fn, **kwargs):
         constants = kwargs.get("constants", dict())
         num_warps = kwargs.get("num_warps", 4)
         num_stages = kwargs.get("num_stages", 3)
+        warp_specialize = kwargs.get("warp_specialize", False)
+        prefetch_width = kwargs.get("prefetch_width", None)
+        pid_order = kwargs.get("pid_order", None)
+        launch_bounds = tuple(kwargs.get(bound, None) for bound in ("min_blocks_per_sm", "max_registers", "waves_per_eu"))
+        fast_math = kwargs.get("fast_math", fn.fast_math)
+        int32_indexing = fn.int32_indexing
+        threads_per_warp = kwargs.get("threads_per_warp", fn.threads_per_warp)
         # Get unique key for the compiled code
-        get_conf_key = lambda conf: (sorted(conf.divisible_by_16), sorted(conf.equal_to_1))
+        get_conf_key = lambda conf: (sorted(conf.divisible_by_16), sorted(conf.equal_to_1),
+                                     sorted(getattr(conf, "version_alignment", ())), sorted(getattr(conf, "divisibility", ())),
+                                     sorted(getattr(conf, "noalias", ())))
         configs_key = [get_conf_key(conf) for conf in configs]
-        key = f"{fn.cache_key}-{''.join(signature.values())}-{configs_key}-{constants}-{num_warps}-{num_stages}"
-        return hashlib.md5(key.encode("utf-8")).hexdigest()
-    assert isinstance(fn, str)
-    return hashlib.md5((Path(fn).read_text() + triton.runtime.jit.version_key()).encode("utf-8")).hexdigest()
+        key = f"{fn.cache_key}-{''.join(signature.values())}-{configs_key}-{constants}-{num_warps}-{num_stages}-{warp_specialize}-{prefetch_width}-{pid_order}-{fast_math}-{int32_indexing}-{threads_per_warp}"
+        if launch_bounds != (None, None, None):
+            key += f"-{launch_bounds}"
+        num_ctas = kwargs.get("num_ctas", 1)
+        if num_ctas != 1:
+            key += f"-ctas{num_ctas}"
+    else:
+        assert isinstance(fn, str)
+        key = Path(fn).read_text() + triton.runtime.jit.version_key()
+        if kwargs.get("fast_math", False):
+            key += "-fast_math"
+    # objects for the CPU are compiled for the features of the host
+    if kwargs.get("target", None) == "cpu":
+        key += f"-cpu-{_triton.get_host_cpu_name()}"
+    # variants of profile-guided compilation
+    if kwargs.get("pgo_decisions", None) is not None:
+        key += f"-pgo-{kwargs['pgo']}-{json.dumps(kwargs['pgo_decisions'], sort_keys=True)}"
+    return hashlib.md5(key.encode("utf-8")).hexdigest()
 
 
 # - ^\s*func\s+ : match the start of the string, any leading whitespace, the keyword func,
@@ -1699,10 +2805,152 @@ arg_type_pattern = {
 }
 
 
+# Decisions of the passes varied by profile-guided compilation, and the values
+# tried for each, the default first
+PGO_KNOBS = {
+    # fraction of its budget of registers given to the list scheduler
+    "register_budget": (1.0, 0.75, 0.5),
+    # weight of rematerializations against conversions in the combine pass
+    "remat_weight": (1.0, 0.5, 2.0),
+    # K extent of the slices of the operands of dots prefetched, 0 to infer it
+    "prefetch_width": (0, 16, 32),
+}
+
+
+class ProfileFeedback:
+    '''
+    Measurements of the variants of a kernel compiled with `pgo`, stored in the
+    cache of the kernel: for each set of decisions tried, the cycles per
+    program measured by the device timers of its profiled regions, and the
+    registers and spills of its binary.
+    '''
+
+    def __init__(self, cache_manager, name):
+        self.cache_manager = cache_manager
+        self.file_name = f"{name}.pgo.json"
+        self.trials = []
+        if cache_manager.has_file(self.file_name):
+            with open(cache_manager._make_path(self.file_name)) as f:
+                self.trials = json.load(f)["trials"]
+
+    def find(self, decisions):
+        return next((trial for trial in self.trials if trial["decisions"] == decisions), None)
+
+    def best_decisions(self):
+        '''
+        The decisions of the fastest variant measured, spills breaking ties, or
+        the defaults if none was.
+        '''
+        if not self.trials:
+            return dict()
+        best = min(self.trials, key=lambda trial: (trial["cycles"], trial["spills"] or 0))
+        return dict(best["decisions"])
+
+    def next_decisions(self, knobs):
+        '''
+        The decisions to try next: the first variant not measured yet which
+        differs from the best one by a single decision, or the best one once
+        they all are. Repeated compiles of a kernel thus converge on the
+        fastest decisions. The register budget is varied first when the best
+        variant spills.
+        '''
+        best = self.best_decisions()
+        trial = self.find(best)
+        order = sorted(knobs, key=lambda knob: knob != "register_budget" or not (trial and trial["spills"]))
+        for knob in order:
+            for value in knobs[knob]:
+                decisions = dict(best, **{knob: value})
+                # defaults are omitted, so that each variant has one key
+                if value == knobs[knob][0]:
+                    del decisions[knob]
+                if self.find(decisions) is None:
+                    return decisions
+        return best
+
+    def record(self, trial):
+        '''
+        Adds the measurements of `trial`; those of the same decisions are
+        averaged, weighted by the number of programs they measured.
+        '''
+        previous = self.find(trial["decisions"])
+        if previous is not None:
+            programs = max(previous["programs"] + trial["programs"], 1)
+            for key in ("cycles", "regions"):
+                if isinstance(trial[key], dict):
+                    trial[key] = {name: (previous[key].get(name, 0) * previous["programs"] +
+                                         value * trial["programs"]) / programs
+                                  for name, value in trial[key].items()}
+                else:
+                    trial[key] = (previous[key] * previous["programs"] + trial[key] * trial["programs"]) / programs
+            trial["programs"] = programs
+            self.trials.remove(previous)
+        self.trials.append(trial)
+        self.cache_manager.put(json.dumps({"trials": self.trials}), self.file_name, binary=False)
+
+
+def compile_with_feedback(fn, pgo, kwargs, name):
+    '''
+    Compiles a variant of `fn` chosen from the feedback of the previous ones.
+    With `pgo="train"` (or `True`), the variant is the next to try, and the
+    whole kernel is a profiled region: the cycles measured by its launches are
+    recorded as feedback by :code:`CompiledKernel.record_feedback`, or when
+    the process exits. With `pgo="use"`, the variant is the fastest measured,
+    without profiled regions. `TRITON_PGO` sets the mode of the kernels
+    compiled without `pgo`, such as those of the JIT.
+    '''
+    if pgo is True or pgo == "train":
+        pgo = "train"
+    elif pgo != "use":
+        raise ValueError(f"unknown profile-guided compilation mode {pgo!r}")
+    if not isinstance(fn, triton.runtime.JITFunction):
+        name = os.path.basename(fn).split(".")[0]
+    kwargs = {key: value for key, value in kwargs.items() if key not in ("pgo", "pgo_decisions")}
+    key = make_hash(fn, **kwargs)
+    feedback = ProfileFeedback(CacheManager(key), name)
+    knobs = dict(PGO_KNOBS)
+    if kwargs.get("prefetch_width", None) is not None:
+        del knobs["prefetch_width"]
+    while True:
+        decisions = feedback.next_decisions(knobs) if pgo == "train" else feedback.best_decisions()
+        kernel = compile(fn, **dict(kwargs, pgo=pgo, pgo_decisions=decisions))
+        digest = kernel.metadata["digest"]
+        binary = digest.get("cubin", digest.get("amdgcn"))
+        if pgo == "use":
+            break
+        # a variant which compiles to the binary of a measured one is not run
+        same = next((trial for trial in feedback.trials if trial["binary"] == binary), None)
+        if same is None or feedback.find(decisions) is not None:
+            break
+        feedback.record(dict(same, decisions=decisions, programs=0))
+    kernel.metadata["pgo"] = {"mode": pgo, "key": key, "name": name, "decisions": decisions, "binary": binary}
+    if pgo == "train":
+        _pgo_training_kernels.add(kernel)
+    return kernel
+
+
+# kernels compiled with `pgo="train"`, whose feedback is recorded on exit
+_pgo_training_kernels = weakref.WeakSet()
+
+
+@atexit.register
+def _record_pgo_feedback():
+    for kernel in list(_pgo_training_kernels):
+        try:
+            kernel.record_feedback()
+        except Exception as e:
+            warnings.warn(f"failed to record the feedback of {kernel.metadata['pgo']['name']}: {e}")
+
+
 # def compile(fn, signature: str, device: int = -1, constants=dict(), num_warps: int = 4, num_stages: int = 3, extern_libs=None, configs=None):
 @static_vars(discovered_gfx_arch = _get_amdgpu_arch())
 def compile(fn, **kwargs):
+    # kernels for the CPU of the host run their programs on a pool of threads
+    target = kwargs.get("target", None)
+    if target not in (None, "cpu"):
+        raise ValueError(f"unknown target {target!r}")
     capability = kwargs.get("cc", None)
+    if target == "cpu":
+        capability = 0
     if capability is None:
         device = torch.cuda.current_device()
         capability = torch.cuda.get_device_capability(device)
@@ -1710,14 +2958,47 @@ def compile(fn, **kwargs):
     # we get the kernel, i.e. the first function generated in the module
     # if fn is not a JITFunction, then it
     # has to be a path to a file
-    context = _triton.ir.context()
+    # the context is only made if a stage is not in the cache
+    context = kwargs.get("context", None)
     asm = dict()
     constants = kwargs.get("constants", dict())
     num_warps = kwargs.get("num_warps", 4)
     num_stages = kwargs.get("num_stages", 3 if capability >= 75 else 2)
+    warp_specialize = kwargs.get("warp_specialize", False)
+    prefetch_width = kwargs.get("prefetch_width", None)
+    pid_order = kwargs.get("pid_order", None)
+    min_blocks_per_sm = kwargs.get("min_blocks_per_sm", None)
+    max_registers = kwargs.get("max_registers", None)
+    waves_per_eu = kwargs.get("waves_per_eu", None)
+    # programs launched in thread block clusters of num_ctas programs along x,
+    # which share the tiles they all load
+    num_ctas = kwargs.get("num_ctas", 1)
+    if not 1 <= num_ctas <= 8:
+        raise ValueError(f"num_ctas must be between 1 and 8, got {num_ctas}")
+    if num_ctas > 1 and (target == "cpu" or torch.version.hip is not None or capability < 90):
+        raise ValueError("thread block clusters (num_ctas > 1) require sm_90 or newer")
+    fast_math = kwargs.get("fast_math", getattr(fn, "fast_math", False))
+    threads_per_warp = kwargs.get("threads_per_warp", getattr(fn, "threads_per_warp", 32))
     extern_libs = kwargs.get("extern_libs", dict())
+    # variants of profile-guided compilation, see `compile_with_feedback`
+    pgo = kwargs.get("pgo", os.environ.get("TRITON_PGO") or None)
+    pgo_decisions = kwargs.get("pgo_decisions", None)
+    pgo_train = pgo_decisions is not None and pgo == "train"
     # build compilation stages
-    if torch.version.hip is not None:
+    if target == "cpu":
+        num_warps, threads_per_warp = 1, 1
+        stages = {
+            "ast": (lambda path: fn, None),
+            "ttir": (lambda path: _triton.ir.parse_mlir_module(path, context),
+                    lambda src: ast_to_ttir(src, signature, configs[0], constants, context)),
+            "ttgir": (lambda path: _triton.ir.parse_mlir_module(path, context),
+                    lambda src: ttir_to_cpu_ttgir(src)),
+            "llir": (lambda path: Path(path).read_text(),
+                    lambda src: ttgir_to_cpu_llir(src)),
+            "obj": (lambda path: Path(path).read_bytes(),
+                    lambda src: _triton.translate_llvmir_to_cpu_object(src)),
+        }
+    elif torch.version.hip is not None:
         if extern_libs is None:
             extern_libs = get_amdgcn_bitcode_paths()
         else:
@@ -1731,11 +3012,13 @@ def compile(fn, **kwargs):
         stages = {
             "ast": (lambda path: fn, None),
             "ttir": (lambda path: _triton.ir.parse_mlir_module(path, context),
-                    lambda src: ast_to_ttir(src, signature, configs[0], constants)),
+                    lambda src: ast_to_ttir(src, signature, configs[0], constants, context)),
             "ttgir": (lambda path: _triton.ir.parse_mlir_module(path, context),
-                    lambda src: ttir_to_ttgir(src, num_warps, num_stages, capability)),
+                    lambda src: ttir_to_ttgir(src, num_warps, num_stages, capability, warp_specialize, prefetch_width,
+                                          pid_order, threads_per_warp, gfx_arch, min_blocks_per_sm, max_registers,
+                                          waves_per_eu, pgo_decisions, pgo_train)),
             "llir": (lambda path: Path(path).read_text(),
-                    lambda src: ttgir_to_llir(src, extern_libs, capability)),
+                    lambda src: ttgir_to_llir(src, extern_libs, capability, fast_math)),
             "amdgcn": (lambda path: Path(path).read_text(),
                     lambda src: llir_to_amdgcn_and_hsaco(src, gfx_arch)),
         }
@@ -1743,11 +3026,13 @@ def compile(fn, **kwargs):
         stages = {
             "ast": (lambda path: fn, None),
             "ttir": (lambda path: _triton.ir.parse_mlir_module(path, context),
-                    lambda src: ast_to_ttir(src, signature, configs[0], constants)),
+                    lambda src: ast_to_ttir(src, signature, configs[0], constants, context)),
             "ttgir": (lambda path: _triton.ir.parse_mlir_module(path, context),
-                    lambda src: ttir_to_ttgir(src, num_warps, num_stages, capability)),
+                    lambda src: ttir_to_ttgir(src, num_warps, num_stages, capability, warp_specialize, prefetch_width,
+                                          pid_order, threads_per_warp, None, min_blocks_per_sm, max_registers,
+                                          None, pgo_decisions, pgo_train, num_ctas)),
             "llir": (lambda path: Path(path).read_text(),
-                    lambda src: ttgir_to_llir(src, extern_libs, capability)),
+                    lambda src: ttgir_to_llir(src, extern_libs, capability, fast_math, get_ptx_version())),
             "ptx": (lambda path: Path(path).read_text(),
                     lambda src: llir_to_ptx(src, capability)),
             "cubin": (lambda path: Path(path).read_bytes(),
@@ -1782,7 +3067,12 @@ def compile(fn, **kwargs):
         first_stage = list(stages.keys()).index(ir)
 
     # cache manager
-    so_path = make_stub(name, signature, constants)
+    # the launcher for the CPU is linked with the kernel once it is compiled
+    so_path = make_stub(name, signature, constants) if target != "cpu" else None
+    # the variants of profile-guided compilation are chosen from the feedback
+    # of the previous ones; kernels for the CPU have no device timers
+    if pgo and pgo_decisions is None and target != "cpu":
+        return compile_with_feedback(fn, pgo, kwargs, name)
     # create cache manager
     fn_cache_manager = CacheManager(make_hash(fn, **kwargs))
     # determine name and extension type of provided function
@@ -1793,11 +3083,26 @@ def compile(fn, **kwargs):
 
     # load metadata if any
     metadata = None
-    if fn_cache_manager.has_file(f'{name}.json'):
+    is_cached = fn_cache_manager.has_file(f'{name}.json')
+    if is_cached:
         with open(fn_cache_manager._make_path(f"{name}.json")) as f:
             metadata = json.load(f)
     else:
-        metadata = {"num_warps": num_warps, "num_stages": num_stages, "ctime": dict()}
+        metadata = {"num_warps": num_warps, "num_stages": num_stages, "threads_per_warp": threads_per_warp,
+                    "num_ctas": num_ctas, "digest": dict()}
+        # description of the variant, for kernel bundles
+        if target == "cpu":
+            metadata["arch"] = f"cpu-{_triton.get_host_cpu_name()}"
+        else:
+            metadata["arch"] = gfx_arch if torch.version.hip is not None else f"sm{capability}"
+        metadata["signature"] = {str(i): ty for i, ty in signature.items()}
+        metadata["constants"] = {str(i): _json_constant(c) for i, c in constants.items()}
+        if isinstance(fn, triton.runtime.JITFunction):
+            metadata["specialization"] = {field: [list(i) if isinstance(i, tuple) else i for i in getattr(configs[0], field, ())]
+                                          for field in instance_descriptor._fields}
+            metadata["source_hash"] = hashlib.md5(fn.cache_key.encode("utf-8")).hexdigest()
+        else:
+            metadata["source_hash"] = hashlib.md5(src.encode("utf-8")).hexdigest()
         if ext == "ptx":
             assert "shared" in kwargs, "ptx compilation must provide shared memory size"
             metadata["shared"] = kwargs["shared"]
@@ -1805,46 +3110,171 @@ def compile(fn, **kwargs):
     first_stage = list(stages.keys()).index(ext)
     asm = dict()
     module = fn
+    # time the stages, and the passes and tools they run, if requested
+    print_times = os.environ.get("TRITON_PRINT_COMPILE_TIMES", "").lower() in ("1", "on", "true")
+    profile = kwargs.get("profile", False) or print_times
+    # a kernel whose stages are all cached is returned without reading them:
+    # they are read on first use, and its module loaded on first launch
+    if is_cached and ext == "ast" and kwargs.get("lazy", True) and not profile and target != "cpu":
+        later_stages = list(stages.keys())[first_stage + 1:]
+        files = [f"{name}.{ir}" for ir in later_stages]
+        if "amdgcn" in later_stages:
+            files.append(f"{name}.hsaco")
+        if "name" in metadata and all(ir in metadata.get("digest", dict()) for ir in later_stages) and\
+                all(fn_cache_manager.has_file(file) for file in files):
+            paths = {file.rsplit(".", 1)[1]: fn_cache_manager._make_path(file) for file in files}
+            recompile = lambda: compile(fn, **dict(kwargs, lazy=False)).asm
+            return CompiledKernel(so_path, metadata, CachedAsm({"ast": str(fn)}, paths, metadata["digest"], recompile))
+    if context is None:
+        context = make_context()
+    stage_times = dict()
+    if profile:
+        _triton.enable_compile_timer()
     # run compilation pipeline  and populate metadata
     for ir, (parse, compile_kernel) in list(stages.items())[first_stage:]:
         path = fn_cache_manager._make_path(f"{name}.{ir}")
+        # cached stages are checked against the digest recorded in the
+        # metadata, which survives copies between cache tiers
         if ir == ext:
             next_module = parse(fn)
-        elif os.path.exists(path) and\
-                ir in metadata["ctime"] and\
-                os.path.getctime(path) == metadata["ctime"][ir]:
+        elif fn_cache_manager.has_file(f"{name}.{ir}") and\
+                ir in metadata.get("digest", dict()) and\
+                file_digest(path) == metadata["digest"][ir] and\
+                (ir != "amdgcn" or fn_cache_manager.has_file(f"{name}.hsaco")):
             if ir == "amdgcn":
-                next_module = (parse(path), parse(fn_cache_manager._make_path(f"{name}.hsaco_path")))
+                with open(fn_cache_manager._make_path(f"{name}.hsaco"), "rb") as f:
+                    next_module = (parse(path), f.read())
+            elif ir in ("ttir", "ttgir") and "name" in metadata:
+                # the metadata computed from the module is cached as well
+                next_module = CachedModule(parse, path)
             else:
                 next_module = parse(path)
         else:
-            next_module = compile_kernel(module)
+            stage_start = time.perf_counter()
+            if isinstance(module, CachedModule):
+                module = module.parse()
+            try:
+                next_module = compile_kernel(module)
+            except BaseException:
+                if profile:
+                    _triton.disable_compile_timer()
+                raise
+            stage_times[ir] = time.perf_counter() - stage_start
             if ir == "amdgcn":
                 fn_cache_manager.put(next_module[0], f"{name}.{ir}")
-                fn_cache_manager.put(next_module[1], f"{name}.hsaco_path")
+                fn_cache_manager.put(next_module[1], f"{name}.hsaco")
             else:
                 fn_cache_manager.put(next_module, f"{name}.{ir}")
         if os.path.exists(path):
-            metadata["ctime"][ir] = os.path.getctime(path)
-        if ir == "cubin":
+            metadata.setdefault("digest", dict())[ir] = file_digest(path)
+        if ir in ("cubin", "obj"):
             asm[ir] = next_module
         elif ir == "amdgcn":
             asm[ir] = str(next_module[0])
         else:
             asm[ir] = str(next_module)
+        if ir == "ttgir" and not isinstance(next_module, CachedModule) and target != "cpu":
+            # warp-specialized kernels are launched with one set of warps per warp group
+            metadata["num_warps"] = num_warps * _triton.get_num_warp_groups(next_module)
+            metadata["cooperative"] = _triton.has_grid_barrier(next_module)
+            estimate = _triton.get_register_estimate(next_module)
+            if estimate is not None:
+                metadata["live_registers"], metadata["predicted_spills"] = estimate
+            profile_regions = _triton.get_profile_regions(next_module)
+            if profile_regions:
+                metadata["profile_regions"] = profile_regions
+            trace_formats = _triton.get_trace_formats(next_module)
+            if trace_formats:
+                metadata["trace_formats"] = trace_formats
+        if ir == "llir" and target == "cpu":
+            metadata["shared"] = 0
+            metadata["name"] = llir_get_kernel_name(asm[ir])
         if ir == "llir" and "shared" not in metadata:
             metadata["shared"] = _triton.get_shared_memory_size(module)
         if ir == "ptx":
             metadata["name"] = ptx_get_kernel_name(next_module)
         if ir == "amdgcn":
             metadata["name"] = amdgcn_get_kernel_name(next_module[0])
-            asm["hsaco_path"] = next_module[1]
+            asm["hsaco"] = next_module[1]
+        if ir in ("cubin", "amdgcn") and "static_analysis" not in metadata:
+            report = static_analysis_report(asm, metadata)
+            if report is not None:
+                metadata["static_analysis"] = report
         module = next_module
     # write-back metadata
     fn_cache_manager.put(json.dumps(metadata), f"{name}.json", binary=False)
+    if profile:
+        metadata["compile_times"] = make_compile_report(stage_times, _triton.disable_compile_timer())
+        if print_times:
+            print(format_compile_report(metadata.get("name", name), metadata["compile_times"]))
     # return handle to compiled kernel
+    if target == "cpu":
+        so_path = make_cpu_stub(metadata["name"], signature, constants, asm["obj"])
+        return CPUKernel(so_path, metadata, asm)
     return CompiledKernel(so_path, metadata, asm)
 
+
+def prefetch_kernels(kernels, device=None):
+    '''
+    Loads the modules of `kernels` on `device`, by default the current one, in
+    a background thread, so that their first launches do not wait for them.
+    The kernels are loaded in order: those most likely to be launched first
+    come first. A kernel failing to load is skipped, and fails again when it
+    is launched. Returns the thread.
+    '''
+    if device is None:
+        device = torch.cuda.current_device()
+    kernels = list(kernels)
+
+    def load():
+        torch.cuda.set_device(device)
+        for kernel in kernels:
+            try:
+                kernel._init_handles()
+            except Exception:
+                pass
+
+    thread = threading.Thread(target=load, name="triton-prefetch", daemon=True)
+    thread.start()
+    return thread
+
+
+def launch_many(launches, stream=None):
+    '''
+    Launches `launches`, triples of a compiled kernel, its grid and the tuple
+    of its arguments, in order on `stream`, by default the current stream. The
+    launches are enqueued in a single call, which queries the stream once.
+    '''
+    if stream is None:
+        stream = get_cuda_stream(current_device())
+    _triton.runtime.launch_many(launches, stream, CompiledKernel)
+
+
+def compile_many(jobs, num_threads=None):
+    '''
+    Compiles `jobs`, pairs of a function and of the keyword arguments of
+    `compile`, concurrently in a single context of `num_threads` threads (see
+    `make_context`). The frontend holds the GIL, but the passes, translations
+    and external tools release it, so that the pipelines of the jobs overlap.
+    The translations to PTX and HSACO run one at a time.
+    Returns the compiled kernels, in the order of the jobs.
+    '''
+    jobs = [(fn, dict(kwargs)) for fn, kwargs in jobs]
+    context = make_context(num_threads)
+    for _, kwargs in jobs:
+        kwargs["context"] = context
+    if len(jobs) <= 1 or not context.is_multithreading_enabled():
+        return [compile(fn, **kwargs) for fn, kwargs in jobs]
+    # the context does not guard the loading of dialects, hence the first job
+    # runs alone and loads those of the pipeline
+    fn, kwargs = jobs[0]
+    kernels = [compile(fn, **kwargs)]
+    from concurrent.futures import ThreadPoolExecutor
+    with ThreadPoolExecutor(max_workers=min(len(jobs) - 1, context.num_threads())) as executor:
+        futures = [executor.submit(compile, fn, **kwargs) for fn, kwargs in jobs[1:]]
+        kernels += [future.result() for future in futures]
+    return kernels
+
 @static_vars(discovered_gfx_arch = _get_amdgpu_arch())
 def _get_amdgcn_bitcode_paths():
   if torch.version.hip is not None:
@@ -1873,6 +3303,33 @@ def _get_amdgcn_bitcode_paths():
 def get_amdgcn_bitcode_paths():
   return get_amdgcn_bitcode_paths.amdgcn_bitcode_paths
 
+def _unravel_index(index, shape):
+    coords = []
+    for dim in reversed(shape):
+        coords.append(index % dim)
+        index //= dim
+    return tuple(reversed(coords))
+
+
+def _decode_trace_value(words, dtype):
+    bits = words[0] | (words[1] << 32 if len(words) > 1 else 0)
+    if dtype == "f16":
+        return struct.unpack("<e", struct.pack("<H", bits & 0xffff))[0]
+    if dtype == "bf16":
+        return struct.unpack("<f", struct.pack("<I", (bits & 0xffff) << 16))[0]
+    if dtype == "f32":
+        return struct.unpack("<f", struct.pack("<I", bits))[0]
+    if dtype == "f64":
+        return struct.unpack("<d", struct.pack("<Q", bits))[0]
+    if dtype == "ptr":
+        return bits
+    width = int(dtype[1:])
+    if width == 1:
+        return bool(bits & 1)
+    bits &= (1 << width) - 1
+    return bits - (1 << width) if bits >> (width - 1) else bits
+
+
 class CompiledKernel:
 
     # Hooks for external tools to monitor the execution of triton kernels
@@ -1885,11 +3342,19 @@ class CompiledKernel:
         spec = importlib.util.spec_from_file_location("launcher", so_path)
         mod = importlib.util.module_from_spec(spec)
         spec.loader.exec_module(mod)
+        self.so_path = so_path
         self.c_wrapper = getattr(mod, "launch")
+        self.c_graph_node = getattr(mod, "graph_node")
+        self.c_graph_node_set_params = getattr(mod, "graph_node_set_params")
         # initialize metadata
         self.shared = metadata["shared"]
         self.num_warps = metadata["num_warps"]
+        self.num_threads = self.num_warps * metadata.get("threads_per_warp", 32)
         self.num_stages = metadata["num_stages"]
+        self.cooperative = metadata.get("cooperative", False)
+        self.num_ctas = metadata.get("num_ctas", 1)
+        self.profile_regions = metadata.get("profile_regions")
+        self.trace_formats = metadata.get("trace_formats")
         # initialize asm dict
         self.asm = asm
         # binaries are lazily initialized
@@ -1898,27 +3363,201 @@ class CompiledKernel:
         self.metadata = metadata
         self.cu_module = None
         self.cu_function = None
+        self.n_regs = None
+        self.n_spills = None
+        # the module may be loaded by `prefetch_kernels` concurrently
+        self._load_lock = threading.Lock()
+        # per-program cycle counters of the profiled regions, and the number of
+        # programs launched since the last reset
+        self._profile_buffers = []
+        self._profile_programs = 0
+        # ring buffer of the trace records
+        self._trace_buffer = None
+
+    def register_report(self):
+        """
+        Compares the registers estimated by the list scheduler with those
+        allocated by the backend, which spills the registers it can't allocate
+        to local memory.
+        """
+        self._init_handles()
+        return {"live_registers": self.metadata.get("live_registers"),
+                "predicted_spills": self.metadata.get("predicted_spills"),
+                "registers": self.n_regs,
+                "spills": self.n_spills}
+
+    def profile_launch(self, grid_0, grid_1, grid_2):
+        """
+        Provides the kernel with counters for the programs of a launch,
+        before launching it. The counters of each program accumulate over the
+        launches until :code:`profile_reset`.
+        """
+        self._init_handles()
+        num_programs = grid_0 * grid_1 * grid_2
+        self._profile_programs += num_programs
+        row_size = len(self.profile_regions) + 3
+        if self._profile_buffers and self._profile_buffers[-1].shape[0] >= num_programs:
+            return
+        # the previous counters are kept for the report, and the launches in
+        # flight must not see the buffer change
+        torch.cuda.synchronize()
+        buffer = torch.zeros((num_programs, row_size), dtype=torch.int64, device="cuda")
+        utils = hip_utils if torch.version.hip is not None else cuda_utils
+        utils.set_global(self.cu_module, "triton_profile_buffer", buffer.data_ptr())
+        self._profile_buffers.append(buffer)
+
+    def profile_reset(self):
+        """
+        Clears the counters of the profiled regions.
+        """
+        torch.cuda.synchronize()
+        for buffer in self._profile_buffers:
+            buffer.zero_()
+        self._profile_programs = 0
+
+    def profile_report(self):
+        """
+        Returns the breakdown of the cycles spent by the first thread of each
+        program in the regions marked by :code:`tl.profile_region`, since the
+        last reset: for each region, the total over the programs, the average
+        per program launched, the maximum accumulated by a program and the
+        fraction of the total of all regions.
+        """
+        if not self.profile_regions:
+            raise RuntimeError("the kernel has no profiled region")
+        torch.cuda.synchronize()
+        if not self._profile_buffers:
+            rows = torch.zeros((0, len(self.profile_regions) + 3), dtype=torch.int64)
+        else:
+            rows = torch.cat([buffer.cpu() for buffer in self._profile_buffers])
+        cycles = rows[:, 2:]
+        totals = cycles.sum(dim=0).tolist()
+        maxima = cycles.max(dim=0).values.tolist() if rows.shape[0] else [0] * cycles.shape[1]
+        report = dict()
+        for name, total, maximum in zip(["prologue"] + list(self.profile_regions), totals, maxima):
+            region = report.setdefault(name, {"cycles": 0, "max_per_program": 0})
+            region["cycles"] += total
+            region["max_per_program"] = max(region["max_per_program"], maximum)
+        all_cycles = sum(region["cycles"] for region in report.values())
+        for region in report.values():
+            region["per_program"] = region["cycles"] / max(self._profile_programs, 1)
+            region["fraction"] = region["cycles"] / all_cycles if all_cycles else 0.
+        return report
+
+    def record_feedback(self):
+        """
+        Records the cycles per program measured since the last reset, and the
+        registers and spills of the kernel, as the feedback of the next
+        profile-guided compile of the kernel (see :code:`compile_with_feedback`),
+        and resets the counters. Returns the measurements, or None if the
+        kernel was not launched.
+        """
+        pgo = self.metadata.get("pgo")
+        if pgo is None or pgo["mode"] != "train":
+            raise RuntimeError("the kernel was not compiled with pgo=\"train\"")
+        if self._profile_programs == 0:
+            return None
+        report = self.profile_report()
+        self._init_handles()
+        # stall counters are not read: the launcher has no hardware counters
+        trial = {"decisions": pgo["decisions"], "binary": pgo["binary"], "programs": self._profile_programs,
+                 "cycles": sum(region["per_program"] for region in report.values()),
+                 "regions": {name: region["per_program"] for name, region in report.items()},
+                 "registers": self.n_regs, "spills": self.n_spills}
+        self.profile_reset()
+        ProfileFeedback(CacheManager(pgo["key"]), pgo["name"]).record(dict(trial))
+        return trial
+
+    def trace_launch(self):
+        """
+        Provides the kernel with the ring buffer of its trace records, before
+        launching it. The buffer holds the last :code:`TRITON_TRACE_SLOTS`
+        records (65536 by default) written since :code:`trace_reset`, and is
+        only read back by :code:`trace_records`: the launches don't wait for
+        the host.
+        """
+        self._init_handles()
+        if self._trace_buffer is not None:
+            return
+        num_slots = int(os.environ.get("TRITON_TRACE_SLOTS", 1 << 16))
+        slot_words = max(fmt["words"] for fmt in self.trace_formats)
+        buffer = torch.zeros(4 + num_slots * slot_words, dtype=torch.int32, device="cuda")
+        buffer[1] = num_slots
+        utils = hip_utils if torch.version.hip is not None else cuda_utils
+        utils.set_global(self.cu_module, "triton_trace_buffer", buffer.data_ptr())
+        self._trace_buffer = buffer
+
+    def trace_reset(self):
+        """
+        Discards the trace records.
+        """
+        if self._trace_buffer is not None:
+            self._trace_buffer[0] = 0
+
+    def trace_records(self):
+        """
+        Returns the records of the :code:`tl.trace` calls of the kernel since
+        the last reset, oldest first, once the launches in flight on the
+        current stream are done. Each record is a dict of the prefix of the
+        call, the program and the thread that wrote it, and its values: the
+        scalars, and for each tensor a dict of the elements of the thread by
+        index. Only the most recent records are kept when they overflow the
+        ring buffer.
+        """
+        if not self.trace_formats:
+            raise RuntimeError("the kernel has no trace")
+        if self._trace_buffer is None:
+            return []
+        torch.cuda.current_stream().synchronize()
+        header = [word & 0xffffffff for word in self._trace_buffer[:4].tolist()]
+        count, num_slots = header[0], header[1]
+        slot_words = max(fmt["words"] for fmt in self.trace_formats)
+        slots = self._trace_buffer[4:].view(num_slots, slot_words).cpu()
+        records = []
+        for n in range(max(count - num_slots, 0), count):
+            words = [word & 0xffffffff for word in slots[n % num_slots].tolist()]
+            if words[0] == 0:
+                continue
+            fmt = self.trace_formats[words[0] - 1]
+            record = {"prefix": fmt["prefix"], "program": words[1], "thread": words[2], "values": []}
+            pos = 3
+            for arg in fmt["args"]:
+                size = 2 if arg["dtype"] in ("f64", "i64", "ptr") else 1
+                if arg["shape"] is None:
+                    record["values"].append(_decode_trace_value(words[pos:pos + size], arg["dtype"]))
+                    pos += size
+                    continue
+                elements = dict()
+                for _ in range(arg["elems"]):
+                    index = _unravel_index(words[pos], arg["shape"])
+                    elements[index] = _decode_trace_value(words[pos + 1:pos + 1 + size], arg["dtype"])
+                    pos += 1 + size
+                record["values"].append(elements)
+            records.append(record)
+        return records
 
     def _init_handles(self):
         if self.cu_module is not None:
             return
-        device = torch.cuda.current_device()
-        global cuda_utils
-        global hip_utils
-        if torch.version.hip is not None:
-            init_hip_utils()
-            mod, func, n_regs, n_spills = hip_utils.load_binary(self.metadata["name"], self.asm["hsaco_path"], self.shared, device)
-            self.cu_module = mod
+        with self._load_lock:
+            if self.cu_module is not None:
+                return
+            device = torch.cuda.current_device()
+            global cuda_utils
+            global hip_utils
+            if torch.version.hip is not None:
+                init_hip_utils()
+                mod, func, n_regs, n_spills = hip_utils.load_binary(self.metadata["name"], self.asm["hsaco"], self.shared, device)
+            else:
+                init_cuda_utils()
+                max_shared = cuda_utils.get_device_properties(device)["max_shared_mem"]
+                if self.shared > max_shared:
+                    raise OutOfResources(self.shared, max_shared, "shared memory")
+                mod, func, n_regs, n_spills = cuda_utils.load_binary(self.metadata["name"], self.asm["cubin"], self.shared, device)
+            # the module is set last: the kernel is loaded once it is set
             self.cu_function = func
-        else:
-            init_cuda_utils()
-            max_shared = cuda_utils.get_device_properties(device)["max_shared_mem"]
-            if self.shared > max_shared:
-                raise OutOfResources(self.shared, max_shared, "shared memory")
-            mod, func, n_regs, n_spills = cuda_utils.load_binary(self.metadata["name"], self.asm["cubin"], self.shared, device)
-            # print(self.shared, n_regs, n_spills)
+            self.n_regs, self.n_spills = n_regs, n_spills
             self.cu_module = mod
-            self.cu_function = func
 
     def __getattribute__(self, name):
         if name == 'c_wrapper':
@@ -1930,11 +3569,53 @@ class CompiledKernel:
 
         def runner(*args, stream=None):
             if stream is None:
-                stream = torch.cuda.current_stream().cuda_stream
-            self.c_wrapper(grid[0], grid[1], grid[2], self.num_warps, self.shared, stream, self.cu_function,
+                stream = get_cuda_stream(current_device())
+            if self.profile_regions:
+                self.profile_launch(grid[0], grid[1], grid[2])
+            if self.trace_formats:
+                self.trace_launch()
+            self.c_wrapper(grid[0], grid[1], grid[2], self.num_threads, self.shared, self.cooperative, self.num_ctas,
+                           stream, self.cu_function,
                            CompiledKernel.launch_enter_hook, CompiledKernel.launch_exit_hook, self, *args)
         return runner
 
+    def graph_node(self, grid, *args, graph=None, deps=(), stream=None):
+        """
+        Add a launch of this kernel to a CUDA/HIP graph and return its
+        :class:`GraphKernelNode`.
+
+        :param grid: the launch grid, padded to three dimensions
+        :param args: the kernel arguments, as they would be given to the launcher
+        :param graph: the handle of the graph to add the node to; if None, the
+            node is recorded into the capture in progress on :code:`stream`
+        :param deps: the nodes of :code:`graph` the launch depends on
+        :param stream: the capturing stream; defaults to the current stream
+        """
+        if self.cooperative:
+            raise RuntimeError("kernels with a grid barrier cannot be added to graphs")
+        if self.num_ctas > 1:
+            raise RuntimeError("kernels launched in thread block clusters cannot be added to graphs")
+        if self.profile_regions:
+            raise RuntimeError("kernels with profiled regions cannot be added to graphs")
+        self._init_handles()
+        if self.trace_formats:
+            self.trace_launch()
+        grid = tuple(grid) + (1,) * (3 - len(grid))
+        if stream is None:
+            stream = torch.cuda.current_stream().cuda_stream
+        deps = [dep.node if isinstance(dep, GraphKernelNode) else dep for dep in deps]
+        node, params = self.c_graph_node(graph or 0, deps, stream, grid[0], grid[1], grid[2],
+                                         self.num_threads, self.shared, self.cu_function, *args)
+        return GraphKernelNode(self, node, params, grid, args)
+
+    @staticmethod
+    def from_bundle(path, name, arch=None, **metadata):
+        """
+        Load a kernel from a bundle written by :func:`write_kernel_bundle`.
+        See :meth:`KernelBundle.get`.
+        """
+        return KernelBundle(path).get(name, arch=arch, **metadata)
+
     def get_sass(self, fun=None):
         if 'sass' in self.asm:
             return self.asm['sass']
@@ -1949,6 +3630,538 @@ class CompiledKernel:
         return self.sass
 
 
+class CPUKernel:
+    '''
+    A kernel compiled for the CPU of the host, returned by
+    `compile(fn, target="cpu", ...)`. Its programs are run by a pool of threads,
+    by default one per core or `TRITON_CPU_THREADS`, on host memory: pointer
+    arguments are CPU tensors or addresses.
+
+        kernel = triton.compile(add_kernel, signature="*fp32,*fp32,*fp32,i32",
+                                constants={4: 1024}, target="cpu")
+        kernel[(triton.cdiv(n, 1024),)](x, y, out, n)
+    '''
+
+    def __init__(self, so_path, metadata, asm):
+        import importlib.util
+        spec = importlib.util.spec_from_file_location("cpu_launcher", so_path)
+        mod = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(mod)
+        self.so_path = so_path
+        self.c_wrapper = getattr(mod, "launch")
+        self.metadata = metadata
+        self.asm = asm
+        self.name = metadata["name"]
+        self.num_threads = int(os.environ.get("TRITON_CPU_THREADS", 0)) or os.cpu_count() or 1
+
+    def __getitem__(self, grid):
+        grid = tuple(grid) + (1,) * (3 - len(grid))
+
+        def runner(*args, num_threads=None):
+            self.c_wrapper(grid[0], grid[1], grid[2], num_threads or self.num_threads, *args)
+        return runner
+
+
+class GraphKernelNode:
+    """
+    A kernel node of a CUDA/HIP graph. The node owns a stable copy of its
+    arguments, so that the pointers and scalars it is launched with can be
+    updated between replays without rebuilding the graph.
+    """
+
+    def __init__(self, kernel, node, params, grid, args):
+        self.kernel = kernel
+        self.node = node
+        self.params = params
+        self.grid = grid
+        self.args = args
+
+    def update(self, *args, grid=None, graph_exec=None):
+        """
+        Update the grid and arguments of the node. Omitted arguments keep their
+        previous values.
+
+        :param graph_exec: the handle of an instantiated graph containing the
+            node; if None, only the graph the node belongs to is updated
+        """
+        if args:
+            self.args = args
+        if grid is not None:
+            self.grid = tuple(grid) + (1,) * (3 - len(grid))
+        kernel = self.kernel
+        kernel.c_graph_node_set_params(graph_exec or 0, self.node, self.params,
+                                       self.grid[0], self.grid[1], self.grid[2],
+                                       kernel.num_threads, kernel.shared, kernel.cu_function, *self.args)
+
+
+def get_graph_utils():
+    if torch.version.hip is not None:
+        init_hip_utils()
+        return hip_utils
+    init_cuda_utils()
+    return cuda_utils
+
+
+class KernelGraph:
+    """
+    A CUDA/HIP graph built from Triton kernel launches, e.g. a whole decoder
+    step, that is replayed with a single launch.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        graph = KernelGraph()
+        n0 = graph.add(bin_a, grid, x, y, n)
+        n1 = graph.add(bin_b, grid, y, z, n, deps=[n0])
+        graph.replay()
+        graph.update(n1, y, w, n)
+        graph.replay()
+    """
+
+    def __init__(self):
+        self.utils = get_graph_utils()
+        self.graph = self.utils.graph_create()
+        self.graph_exec = None
+
+    def add(self, kernel, grid, *args, deps=()):
+        assert self.graph_exec is None, "nodes cannot be added to an instantiated graph"
+        return kernel.graph_node(grid, *args, graph=self.graph, deps=deps)
+
+    def update(self, node, *args, grid=None):
+        node.update(*args, grid=grid, graph_exec=self.graph_exec)
+
+    def replay(self, stream=None):
+        if self.graph_exec is None:
+            self.graph_exec = self.utils.graph_instantiate(self.graph)
+        if stream is None:
+            stream = torch.cuda.current_stream().cuda_stream
+        self.utils.graph_launch(self.graph_exec, stream)
+
+    def __del__(self):
+        if self.graph_exec is not None:
+            self.utils.graph_exec_destroy(self.graph_exec)
+        self.utils.graph_destroy(self.graph)
+
+
+# ------------------------------------------------------------------------------
+# kernel bundles
+# ------------------------------------------------------------------------------
+
+# Binary bundle of compiled kernels, loaded without the compiler toolchain:
+#
+#   header  "<8sIIQQ": magic, format version, flags, offset and size of the index
+#   blobs   binaries, launchers and runtime modules, deduplicated and aligned to
+#           BUNDLE_ALIGNMENT bytes
+#   index   JSON with sorted keys, listing the kernels and modules with the
+#           (offset, size) of their blobs
+#
+# Bundles are deterministic: the same kernels produce the same bytes.
+BUNDLE_MAGIC = b"TRTNBNDL"
+BUNDLE_VERSION = 1
+BUNDLE_ALIGNMENT = 64
+BUNDLE_HEADER = "<8sIIQQ"
+
+
+def _host_tag():
+    # launchers and runtime modules are Python extensions of the host
+    return sysconfig.get_config_var("EXT_SUFFIX") or ".so"
+
+
+def write_kernel_bundle(path, kernels):
+    """
+    Write compiled kernels, e.g. of several architectures, to a bundle.
+
+    :param kernels: :class:`CompiledKernel` objects, or (kernel, config) pairs
+        recording the :class:`triton.Config` an autotuner selected for them
+    """
+    import struct
+    blobs = []
+    offsets = dict()
+    offset = struct.calcsize(BUNDLE_HEADER)
+
+    def add_blob(data):
+        nonlocal offset
+        data = bytes(data)
+        digest = hashlib.md5(data).hexdigest()
+        if digest not in offsets:
+            offset += -offset % BUNDLE_ALIGNMENT
+            offsets[digest] = [offset, len(data)]
+            blobs.append((offset, data))
+            offset += len(data)
+        return offsets[digest]
+
+    entries = []
+    for kernel in kernels:
+        kernel, config = kernel if isinstance(kernel, tuple) else (kernel, None)
+        metadata = {k: v for k, v in kernel.metadata.items() if k not in ("digest", "compile_times")}
+        entries.append({"metadata": metadata,
+                        "autotune": None if config is None else config.to_dict(),
+                        "binary": "hsaco" if "hsaco" in kernel.asm else "cubin",
+                        "data": kernel.asm["hsaco" if "hsaco" in kernel.asm else "cubin"],
+                        "launcher": Path(kernel.so_path).read_bytes()})
+    entries.sort(key=lambda e: json.dumps([e["metadata"], e["autotune"]], sort_keys=True))
+    tag = _host_tag()
+    index = {"kernels": [], "modules": []}
+    for entry in entries:
+        index["kernels"].append({"metadata": entry["metadata"], "autotune": entry["autotune"],
+                                 "binary": entry["binary"], "data": add_blob(entry["data"]),
+                                 "launchers": {tag: add_blob(entry["launcher"])}})
+    # runtime module loading the binaries, which would otherwise be built on
+    # first use
+    utils = get_graph_utils()
+    index["modules"].append({"key": utils.so_key, "name": utils.so_name, "tag": tag,
+                             "data": add_blob(Path(CacheManager(utils.so_key)._make_path(utils.so_name)).read_bytes())})
+    index = json.dumps(index, sort_keys=True, separators=(",", ":")).encode("utf-8")
+    tmp_path = f"{path}.tmp.{uuid.uuid4()}"
+    with open(tmp_path, "wb") as f:
+        f.write(struct.pack(BUNDLE_HEADER, BUNDLE_MAGIC, BUNDLE_VERSION, 0, offset, len(index)))
+        for blob_offset, data in blobs:
+            f.write(b"\0" * (blob_offset - f.tell()))
+            f.write(data)
+        f.write(index)
+    os.replace(tmp_path, path)
+
+
+class KernelBundle:
+    """
+    A kernel bundle written by :func:`write_kernel_bundle`, memory-mapped.
+    Kernel binaries are read from the mapping when they are loaded on the
+    device.
+    """
+
+    def __init__(self, path):
+        import mmap
+        import struct
+        with open(path, "rb") as f:
+            self.mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        magic, version, _, index_offset, index_size = struct.unpack_from(BUNDLE_HEADER, self.mm)
+        if magic != BUNDLE_MAGIC:
+            raise RuntimeError(f"{path} is not a kernel bundle")
+        if version != BUNDLE_VERSION:
+            raise RuntimeError(f"{path} has bundle format version {version}, expected {BUNDLE_VERSION}")
+        index = json.loads(bytes(self.mm[index_offset:index_offset + index_size]))
+        self.path = path
+        self.kernels = index["kernels"]
+        # install the runtime modules built for this host in the cache
+        for module in index["modules"]:
+            cache = CacheManager(module["key"])
+            if module["tag"] == _host_tag() and not cache.has_file(module["name"]):
+                cache.put(bytes(self._blob(module["data"])), module["name"], binary=True)
+
+    def _blob(self, location):
+        offset, size = location
+        return memoryview(self.mm)[offset:offset + size]
+
+    def find(self, name, arch=None, **metadata):
+        """
+        Return the index entries of the kernels called `name` compiled for
+        `arch`, by default the architecture of the current device, whose
+        metadata match the given values, e.g. :code:`constants={"3": 128}`.
+        """
+        if arch is None:
+            arch = get_device_arch(torch.cuda.current_device())
+        return [entry for entry in self.kernels
+                if entry["metadata"].get("name") == name and entry["metadata"].get("arch") == arch
+                and all(entry["metadata"].get(k) == v for k, v in metadata.items())]
+
+    def get(self, name, arch=None, **metadata):
+        """
+        Load the unique kernel matching :meth:`find` as a :class:`CompiledKernel`.
+        Its autotuned configuration, if any, is available as :code:`autotune`.
+        """
+        entries = self.find(name, arch=arch, **metadata)
+        if len(entries) != 1:
+            raise KeyError(f"{len(entries)} kernels of {self.path} match {name}, {arch}, {metadata}")
+        entry = entries[0]
+        metadata = dict(entry["metadata"])
+        launcher = entry["launchers"].get(_host_tag())
+        if launcher is None:
+            # the launcher is built for this host
+            signature = {int(i): ty for i, ty in metadata["signature"].items()}
+            constants = {int(i): c for i, c in metadata["constants"].items()}
+            so_path = make_stub(name, signature, constants)
+        else:
+            data = self._blob(launcher)
+            cache = CacheManager(f"bundle-{hashlib.md5(data).hexdigest()}")
+            if not cache.has_file(f"{name}.so"):
+                cache.put(bytes(data), f"{name}.so", binary=True)
+            so_path = cache._make_path(f"{name}.so")
+        kernel = CompiledKernel(so_path, metadata, {entry["binary"]: self._blob(entry["data"])})
+        kernel.autotune = entry["autotune"]
+        return kernel
+
+
+# ------------------------------------------------------------------------------
+# kernel libraries
+# ------------------------------------------------------------------------------
+
+# C library of compiled kernels, called without Python: a function of the
+# library takes the stream, the grid and the arguments of the signature of its
+# variants, and launches the most specialized of them whose specialization
+# matches the arguments, among those loaded for the device of the current
+# context.
+
+
+def _library_api():
+    if torch.version.hip is not None:
+        return dict(header="#define __HIP_PLATFORM_AMD__\n#include <hip/hip_runtime.h>",
+                    result="hipError_t", success="hipSuccess", not_found="hipErrorNotFound",
+                    stream="hipStream_t", module="hipModule_t", function="hipFunction_t",
+                    load="hipModuleLoadData", get_function="hipModuleGetFunction", unload="hipModuleUnload",
+                    launch="hipModuleLaunchKernel", launch_cooperative="hipModuleLaunchCooperativeKernel")
+    return dict(header="#include <cuda.h>",
+                result="CUresult", success="CUDA_SUCCESS", not_found="CUDA_ERROR_NOT_FOUND",
+                stream="CUstream", module="CUmodule", function="CUfunction",
+                load="cuModuleLoadData", get_function="cuModuleGetFunction", unload="cuModuleUnload",
+                launch="cuLaunchKernel", launch_cooperative="cuLaunchCooperativeKernel")
+
+
+def _variant_conditions(metadata):
+    # C conditions on the arguments under which the variant can be launched
+    signature = {int(i): ty for i, ty in metadata["signature"].items()}
+    constants = {int(i): c for i, c in metadata["constants"].items()}
+    specialization = metadata.get("specialization", dict())
+
+    def integer(i):
+        return f"(uintptr_t)arg{i}" if signature[i][0] == '*' else f"arg{i}"
+
+    conditions = []
+    for i in signature:
+        if i not in constants:
+            continue
+        value = 0 if constants[i] is None else constants[i]
+        if not isinstance(value, int):
+            raise ValueError(f"argument {i} is specialized to {value!r}, which the library can't check")
+        conditions.append(f"{integer(i)} == {value}")
+    for i in specialization.get("divisible_by_16", []):
+        if i in signature and i not in constants:
+            conditions.append(f"{integer(i)} % 16 == 0")
+    for i, divisor in specialization.get("divisibility", []):
+        conditions.append(f"{integer(i)} % {divisor} == 0")
+    return conditions
+
+
+def _generate_library(name, functions):
+    api = _library_api()
+    variants = []
+    for function, kernels in functions.items():
+        signatures = {json.dumps(kernel.metadata["signature"], sort_keys=True) for kernel in kernels}
+        if len(signatures) != 1:
+            raise ValueError(f"the variants of {function} have different signatures")
+        # the most specialized variants first
+        entries = sorted(((kernel, _variant_conditions(kernel.metadata)) for kernel in kernels),
+                         key=lambda entry: -len(entry[1]))
+        for kernel, conditions in entries:
+            if kernel.profile_regions or kernel.trace_formats:
+                raise ValueError(f"{function} has profiled regions or traces, which need the Python runtime")
+            variants.append((function, f"{function}_{len(variants)}", kernel, conditions))
+    signatures = {function: {int(i): ty for i, ty in kernels[0].metadata["signature"].items()}
+                  for function, kernels in functions.items()}
+
+    def arg_decls(signature):
+        return ''.join(f", {ty_to_cpp(ty)} arg{i}" for i, ty in signature.items())
+
+    def arg_names(signature):
+        return ''.join(f", arg{i}" for i in signature)
+
+    guard = f"TRITON_{name.upper()}_H"
+    header = f"""#ifndef {guard}
+#define {guard}
+
+{api["header"]}
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {{
+#endif
+
+// Loads the variants compiled for the device of the current context
+{api["result"]} {name}_load(void);
+void {name}_unload(void);
+"""
+    for function, signature in signatures.items():
+        header += f"""
+{api["result"]} {function}({api["stream"]} stream, unsigned int gridX, unsigned int gridY, unsigned int gridZ{arg_decls(signature)});
+"""
+    header += f"""
+#ifdef __cplusplus
+}}
+#endif
+
+#endif // {guard}
+"""
+
+    src = f"""#include "{name}.h"
+#include <stdio.h>
+#include <string.h>
+"""
+    for function, variant, kernel, conditions in variants:
+        data = bytes(kernel.asm["hsaco" if "hsaco" in kernel.asm else "cubin"])
+        lines = [", ".join(f"0x{byte:02x}" for byte in data[i:i + 16]) for i in range(0, len(data), 16)]
+        image = ",\n  ".join(lines)
+        src += f"""
+// {kernel.metadata["name"]} for {kernel.metadata["arch"]}, if {" && ".join(conditions) or "any arguments"}
+static const unsigned char {variant}_image[] = {{
+  {image}
+}};
+static {api["module"]} {variant}_module;
+static {api["function"]} {variant}_function;
+"""
+    if torch.version.hip is not None:
+        device_arch = """
+static int device_arch_is(const char *arch) {
+  int device;
+  hipDeviceProp_t props;
+  if (hipGetDevice(&device) != hipSuccess || hipGetDeviceProperties(&props, device) != hipSuccess)
+    return 0;
+  // gcnArchName has the features of the device after the architecture
+  size_t size = strlen(arch);
+  return strncmp(props.gcnArchName, arch, size) == 0 &&
+         (props.gcnArchName[size] == '\\0' || props.gcnArchName[size] == ':');
+}
+"""
+        set_shared = ""
+    else:
+        device_arch = """
+static int device_arch_is(const char *arch) {
+  CUdevice device;
+  int major, minor;
+  char name[16];
+  if (cuCtxGetDevice(&device) != CUDA_SUCCESS ||
+      cuDeviceGetAttribute(&major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, device) != CUDA_SUCCESS ||
+      cuDeviceGetAttribute(&minor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, device) != CUDA_SUCCESS)
+    return 0;
+  snprintf(name, sizeof(name), "sm%d", major * 10 + minor);
+  return strcmp(name, arch) == 0;
+}
+"""
+        set_shared = """
+  if (shared > 49152)
+    return cuFuncSetAttribute(*function, CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES, shared);"""
+    src += device_arch
+    src += f"""
+static {api["result"]} load_variant(const unsigned char *image, const char *kernel, int shared,
+                                  {api["module"]} *module, {api["function"]} *function) {{
+  {api["result"]} err = {api["load"]}(module, image);
+  if (err != {api["success"]})
+    return err;
+  err = {api["get_function"]}(function, *module, kernel);
+  if (err != {api["success"]})
+    return err;{set_shared}
+  return {api["success"]};
+}}
+
+{api["result"]} {name}_load(void) {{
+  {api["result"]} err;
+"""
+    for function, variant, kernel, conditions in variants:
+        src += f"""  if (device_arch_is("{kernel.metadata["arch"]}") &&
+      (err = load_variant({variant}_image, "{kernel.metadata["name"]}", {kernel.shared}, &{variant}_module, &{variant}_function)) != {api["success"]})
+    return err;
+"""
+    src += f"""  return {api["success"]};
+}}
+
+void {name}_unload(void) {{
+"""
+    for function, variant, kernel, conditions in variants:
+        src += f"""  if ({variant}_module)
+    {api["unload"]}({variant}_module);
+  {variant}_module = 0;
+  {variant}_function = 0;
+"""
+    src += "}\n"
+    for function, variant, kernel, conditions in variants:
+        signature = signatures[function]
+        constants = {int(i) for i in kernel.metadata["constants"]}
+        params = ', '.join(f"&arg{i}" for i in signature if i not in constants)
+        launch = api["launch_cooperative"] if kernel.cooperative else api["launch"]
+        extra = "" if kernel.cooperative else ", 0"
+        if kernel.num_ctas > 1:
+            # thread block clusters of num_ctas programs along x (CUDA 12)
+            src += f"""
+static {api["result"]} {variant}({api["stream"]} stream, unsigned int gridX, unsigned int gridY, unsigned int gridZ{arg_decls(signature)}) {{
+  void *params[] = {{ {params} }};
+  CUlaunchAttribute attr;
+  CUlaunchConfig config;
+  if (gridX % {kernel.num_ctas} != 0)
+    return CUDA_ERROR_INVALID_VALUE;
+  attr.id = CU_LAUNCH_ATTRIBUTE_CLUSTER_DIMENSION;
+  attr.value.clusterDim.x = {kernel.num_ctas};
+  attr.value.clusterDim.y = 1;
+  attr.value.clusterDim.z = 1;
+  config.gridDimX = gridX;
+  config.gridDimY = gridY;
+  config.gridDimZ = gridZ;
+  config.blockDimX = {kernel.num_threads};
+  config.blockDimY = 1;
+  config.blockDimZ = 1;
+  config.sharedMemBytes = {kernel.shared};
+  config.hStream = stream;
+  config.attrs = &attr;
+  config.numAttrs = 1;
+  return cuLaunchKernelEx(&config, {variant}_function, params, 0);
+}}
+"""
+            continue
+        src += f"""
+static {api["result"]} {variant}({api["stream"]} stream, unsigned int gridX, unsigned int gridY, unsigned int gridZ{arg_decls(signature)}) {{
+  void *params[] = {{ {params} }};
+  return {launch}({variant}_function, gridX, gridY, gridZ, {kernel.num_threads}, 1, 1, {kernel.shared}, stream, params{extra});
+}}
+"""
+    for function, signature in signatures.items():
+        src += f"""
+{api["result"]} {function}({api["stream"]} stream, unsigned int gridX, unsigned int gridY, unsigned int gridZ{arg_decls(signature)}) {{
+"""
+        for _, variant, kernel, conditions in (v for v in variants if v[0] == function):
+            condition = " && ".join([f"{variant}_function"] + conditions)
+            src += f"""  if ({condition})
+    return {variant}(stream, gridX, gridY, gridZ{arg_names(signature)});
+"""
+        src += f"""  return {api["not_found"]};
+}}
+"""
+    return header, src
+
+
+def write_kernel_library(path, name, functions, build=True):
+    """
+    Write compiled kernels as a C library, called without Python: the header
+    :code:`{name}.h`, the source :code:`{name}.c` embedding the binaries, and
+    unless :code:`build` is False the static library :code:`lib{name}.a`, in
+    the directory :code:`path`.
+
+    :param functions: for each function of the library, its variants: the
+        :class:`CompiledKernel` objects compiled from the same signature for
+        different specializations (configs, or constants of the signature
+        such as :code:`{3: 1}`) and architectures. The function takes the
+        stream, the grid and the arguments of the signature, and launches the
+        most specialized of the variants :code:`{name}_load` loaded for the
+        device of the current context that match the arguments. It returns
+        the error of the launch, or not found when no variant matches.
+    :return: the paths of the files written
+    """
+    os.makedirs(path, exist_ok=True)
+    header, src = _generate_library(name, functions)
+    header_path = os.path.join(path, f"{name}.h")
+    src_path = os.path.join(path, f"{name}.c")
+    Path(header_path).write_text(header)
+    Path(src_path).write_text(src)
+    paths = [header_path, src_path]
+    if build:
+        obj_path = os.path.join(path, f"{name}.o")
+        lib_path = os.path.join(path, f"lib{name}.a")
+        subprocess.check_call([_c_compiler(), "-c", src_path, "-O2", "-fPIC", f"-I{_gpu_include_dir()}",
+                               f"-I{path}", "-o", obj_path])
+        if os.path.exists(lib_path):
+            os.remove(lib_path)
+        subprocess.check_call([shutil.which("ar") or "ar", "rcs", lib_path, obj_path])
+        os.remove(obj_path)
+        paths.append(lib_path)
+    return paths
+
+
 class CudaUtils(object):
 
     def __new__(cls):
@@ -1995,35 +4208,48 @@ class CudaUtils(object):
             int sm_clock_rate;
             int mem_clock_rate;
             int mem_bus_width;
+            int max_shared_mem_per_sm;
+            int max_threads_per_sm;
+            int max_registers_per_sm;
             CUDA_CHECK(cuDeviceGetAttribute(&max_shared_mem, CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_BLOCK_OPTIN, device));
             CUDA_CHECK(cuDeviceGetAttribute(&multiprocessor_count, CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT, device));
             CUDA_CHECK(cuDeviceGetAttribute(&sm_clock_rate, CU_DEVICE_ATTRIBUTE_CLOCK_RATE, device));
             CUDA_CHECK(cuDeviceGetAttribute(&mem_clock_rate, CU_DEVICE_ATTRIBUTE_MEMORY_CLOCK_RATE, device));
             CUDA_CHECK(cuDeviceGetAttribute(&mem_bus_width, CU_DEVICE_ATTRIBUTE_GLOBAL_MEMORY_BUS_WIDTH, device));
+            CUDA_CHECK(cuDeviceGetAttribute(&max_shared_mem_per_sm, CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_MULTIPROCESSOR, device));
+            CUDA_CHECK(cuDeviceGetAttribute(&max_threads_per_sm, CU_DEVICE_ATTRIBUTE_MAX_THREADS_PER_MULTIPROCESSOR, device));
+            CUDA_CHECK(cuDeviceGetAttribute(&max_registers_per_sm, CU_DEVICE_ATTRIBUTE_MAX_REGISTERS_PER_MULTIPROCESSOR, device));
 
 
-            return Py_BuildValue("{s:i, s:i, s:i, s:i, s:i}", "max_shared_mem", max_shared_mem,
+            return Py_BuildValue("{s:i, s:i, s:i, s:i, s:i, s:i, s:i, s:i}", "max_shared_mem", max_shared_mem,
                                        "multiprocessor_count", multiprocessor_count,
                                        "sm_clock_rate", sm_clock_rate,
                                        "mem_clock_rate", mem_clock_rate,
-                                       "mem_bus_width", mem_bus_width);
+                                       "mem_bus_width", mem_bus_width,
+                                       "max_shared_mem_per_sm", max_shared_mem_per_sm,
+                                       "max_threads_per_sm", max_threads_per_sm,
+                                       "max_registers_per_sm", max_registers_per_sm);
         }
 
         static PyObject* loadBinary(PyObject* self, PyObject* args) {
             const char* name;
-            const char* data;
-            Py_ssize_t data_size;
+            Py_buffer data;
             int shared;
             int device;
-            if(!PyArg_ParseTuple(args, "ss#ii", &name, &data, &data_size, &shared, &device)) {
+            if(!PyArg_ParseTuple(args, "sy*ii", &name, &data, &shared, &device)) {
                 return NULL;
             }
             CUfunction fun;
             CUmodule mod;
             int32_t n_regs = 0;
             int32_t n_spills = 0;
-            // create driver handles
-            CUDA_CHECK(cuModuleLoadData(&mod, data));
+            // create driver handles, other threads running meanwhile
+            CUresult load_result;
+            Py_BEGIN_ALLOW_THREADS
+            load_result = cuModuleLoadData(&mod, data.buf);
+            Py_END_ALLOW_THREADS
+            PyBuffer_Release(&data);
+            CUDA_CHECK(load_result);
             CUDA_CHECK(cuModuleGetFunction(&fun, mod, name));
             // get allocated registers and spilled registers from the function
             CUDA_CHECK(cuFuncGetAttribute(&n_regs, CU_FUNC_ATTRIBUTE_NUM_REGS, fun));
@@ -2046,9 +4272,94 @@ class CudaUtils(object):
             return Py_BuildValue("(KKii)", (uint64_t)mod, (uint64_t)fun, n_regs, n_spills);
         }
 
+        static PyObject* setGlobal(PyObject* self, PyObject* args) {
+            uint64_t mod;
+            const char* name;
+            uint64_t value;
+            if(!PyArg_ParseTuple(args, "KsK", &mod, &name, &value))
+                return NULL;
+            CUdeviceptr ptr;
+            size_t size;
+            CUDA_CHECK(cuModuleGetGlobal(&ptr, &size, (CUmodule)mod, name));
+            CUDA_CHECK(cuMemcpyHtoD(ptr, &value, sizeof(value)));
+            Py_RETURN_NONE;
+        }
+
+        static PyObject* graphCreate(PyObject* self, PyObject* args) {
+            CUgraph graph;
+            CUDA_CHECK(cuGraphCreate(&graph, 0));
+            return PyLong_FromUnsignedLongLong((uint64_t)graph);
+        }
+
+        static PyObject* graphInstantiate(PyObject* self, PyObject* args) {
+            uint64_t graph;
+            if(!PyArg_ParseTuple(args, "K", &graph))
+                return NULL;
+            CUgraphExec graph_exec;
+            CUDA_CHECK(cuGraphInstantiateWithFlags(&graph_exec, (CUgraph)graph, 0));
+            return PyLong_FromUnsignedLongLong((uint64_t)graph_exec);
+        }
+
+        static PyObject* graphLaunch(PyObject* self, PyObject* args) {
+            uint64_t graph_exec;
+            uint64_t stream;
+            if(!PyArg_ParseTuple(args, "KK", &graph_exec, &stream))
+                return NULL;
+            CUDA_CHECK(cuGraphLaunch((CUgraphExec)graph_exec, (CUstream)stream));
+            Py_RETURN_NONE;
+        }
+
+        static PyObject* enablePeerAccess(PyObject* self, PyObject* args) {
+            int device_id;
+            int peer_id;
+            if(!PyArg_ParseTuple(args, "ii", &device_id, &peer_id))
+                return NULL;
+            int can_access;
+            CUDA_CHECK(cuDeviceCanAccessPeer(&can_access, device_id, peer_id));
+            if (!can_access)
+                return PyBool_FromLong(0);
+            // enabled from the primary context of the device, as used by the
+            // runtime API, to that of the peer
+            CUcontext ctx;
+            CUcontext peer_ctx;
+            CUDA_CHECK(cuDevicePrimaryCtxRetain(&ctx, device_id));
+            CUDA_CHECK(cuDevicePrimaryCtxRetain(&peer_ctx, peer_id));
+            CUDA_CHECK(cuCtxPushCurrent(ctx));
+            CUresult result = cuCtxEnablePeerAccess(peer_ctx, 0);
+            cuCtxPopCurrent(NULL);
+            cuDevicePrimaryCtxRelease(peer_id);
+            cuDevicePrimaryCtxRelease(device_id);
+            if (result != CUDA_ERROR_PEER_ACCESS_ALREADY_ENABLED)
+                CUDA_CHECK(result);
+            return PyBool_FromLong(1);
+        }
+
+        static PyObject* graphDestroy(PyObject* self, PyObject* args) {
+            uint64_t graph;
+            if(!PyArg_ParseTuple(args, "K", &graph))
+                return NULL;
+            CUDA_CHECK(cuGraphDestroy((CUgraph)graph));
+            Py_RETURN_NONE;
+        }
+
+        static PyObject* graphExecDestroy(PyObject* self, PyObject* args) {
+            uint64_t graph_exec;
+            if(!PyArg_ParseTuple(args, "K", &graph_exec))
+                return NULL;
+            CUDA_CHECK(cuGraphExecDestroy((CUgraphExec)graph_exec));
+            Py_RETURN_NONE;
+        }
+
         static PyMethodDef ModuleMethods[] = {
           {"load_binary", loadBinary, METH_VARARGS, "Load provided cubin into CUDA driver"},
           {"get_device_properties", getDeviceProperties, METH_VARARGS, "Get the properties for a given device"},
+          {"set_global", setGlobal, METH_VARARGS, "Set a 64-bit global variable of a loaded module"},
+          {"graph_create", graphCreate, METH_VARARGS, "Create an empty CUDA graph"},
+          {"graph_instantiate", graphInstantiate, METH_VARARGS, "Instantiate a CUDA graph"},
+          {"graph_launch", graphLaunch, METH_VARARGS, "Launch an instantiated CUDA graph on a stream"},
+          {"graph_destroy", graphDestroy, METH_VARARGS, "Destroy a CUDA graph"},
+          {"graph_exec_destroy", graphExecDestroy, METH_VARARGS, "Destroy an instantiated CUDA graph"},
+          {"enable_peer_access", enablePeerAccess, METH_VARARGS, "Give a device access to the memory of a peer device"},
           {NULL, NULL, 0, NULL} // sentinel
         };
 
@@ -2075,6 +4386,8 @@ class CudaUtils(object):
         key = hashlib.md5(src.encode("utf-8")).hexdigest()
         cache = CacheManager(key)
         fname = "cuda_utils.so"
+        self.so_key = key
+        self.so_name = fname
         if not cache.has_file(fname):
             with tempfile.TemporaryDirectory() as tmpdir:
                 src_path = os.path.join(tmpdir, "main.c")
@@ -2089,6 +4402,13 @@ class CudaUtils(object):
         spec.loader.exec_module(mod)
         self.load_binary = mod.load_binary
         self.get_device_properties = mod.get_device_properties
+        self.set_global = mod.set_global
+        self.graph_create = mod.graph_create
+        self.graph_instantiate = mod.graph_instantiate
+        self.graph_launch = mod.graph_launch
+        self.graph_destroy = mod.graph_destroy
+        self.graph_exec_destroy = mod.graph_exec_destroy
+        self.enable_peer_access = mod.enable_peer_access
 
 
 def init_cuda_utils():
@@ -2134,28 +4454,13 @@ class HIPUtils(object):
 
         static PyObject* loadBinary(PyObject* self, PyObject* args) {
             const char* name;
-            const char* data;
-            Py_ssize_t data_size;
+            Py_buffer data;
             int shared;
             int device;
-            if(!PyArg_ParseTuple(args, "ss#ii", &name, &data, &data_size, &shared, &device)) {
-                return NULL;
-            }
-
-            // Open HSACO file
-            FILE* hsaco_file;
-            if ((hsaco_file = fopen(data, "rb")) == NULL) {
+            if(!PyArg_ParseTuple(args, "sy*ii", &name, &data, &shared, &device)) {
                 return NULL;
             }
 
-            // Read HSCAO file into Buffer
-            fseek(hsaco_file, 0L, SEEK_END);
-            size_t hsaco_file_size = ftell(hsaco_file);
-            unsigned char* hsaco = (unsigned char*) malloc(hsaco_file_size * sizeof(unsigned char));
-            rewind(hsaco_file);
-            fread(hsaco, sizeof(unsigned char), hsaco_file_size, hsaco_file);
-            fclose(hsaco_file);
-
             // set HIP options
             hipJitOption opt[] = {hipJitOptionErrorLogBufferSizeBytes, hipJitOptionErrorLogBuffer,
                                   hipJitOptionInfoLogBufferSizeBytes, hipJitOptionInfoLogBuffer,
@@ -2171,9 +4476,11 @@ class HIPUtils(object):
             // launch HIP Binary
             hipModule_t mod;
             hipFunction_t fun;
-            hipModuleLoadDataEx(&mod, hsaco, 5, opt, optval);
+            Py_BEGIN_ALLOW_THREADS
+            hipModuleLoadDataEx(&mod, data.buf, 5, opt, optval);
+            Py_END_ALLOW_THREADS
+            PyBuffer_Release(&data);
             hipModuleGetFunction(&fun, mod, name);
-            free(hsaco);
 
             // get allocated registers and spilled registers from the function
             int n_regs = 0;
@@ -2184,8 +4491,112 @@ class HIPUtils(object):
             return Py_BuildValue("(KKii)", (uint64_t)mod, (uint64_t)fun, n_regs, n_spills);
         }
 
+        #define HIP_CHECK(ans) { gpuAssert((ans), __FILE__, __LINE__); if(PyErr_Occurred()) return NULL; }
+
+        static PyObject* setGlobal(PyObject* self, PyObject* args) {
+            uint64_t mod;
+            const char* name;
+            uint64_t value;
+            if(!PyArg_ParseTuple(args, "KsK", &mod, &name, &value))
+                return NULL;
+            hipDeviceptr_t ptr;
+            size_t size;
+            HIP_CHECK(hipModuleGetGlobal(&ptr, &size, (hipModule_t)mod, name));
+            HIP_CHECK(hipMemcpyHtoD(ptr, &value, sizeof(value)));
+            Py_RETURN_NONE;
+        }
+
+        static PyObject* getDeviceProperties(PyObject* self, PyObject* args){
+            int device;
+            if(!PyArg_ParseTuple(args, "i", &device))
+                return NULL;
+            int max_shared_mem;
+            int multiprocessor_count;
+            int sm_clock_rate;
+            int mem_clock_rate;
+            int mem_bus_width;
+            HIP_CHECK(hipDeviceGetAttribute(&max_shared_mem, hipDeviceAttributeMaxSharedMemoryPerBlock, device));
+            HIP_CHECK(hipDeviceGetAttribute(&multiprocessor_count, hipDeviceAttributeMultiprocessorCount, device));
+            HIP_CHECK(hipDeviceGetAttribute(&sm_clock_rate, hipDeviceAttributeClockRate, device));
+            HIP_CHECK(hipDeviceGetAttribute(&mem_clock_rate, hipDeviceAttributeMemoryClockRate, device));
+            HIP_CHECK(hipDeviceGetAttribute(&mem_bus_width, hipDeviceAttributeMemoryBusWidth, device));
+
+            return Py_BuildValue("{s:i, s:i, s:i, s:i, s:i}", "max_shared_mem", max_shared_mem,
+                                 "multiprocessor_count", multiprocessor_count,
+                                 "sm_clock_rate", sm_clock_rate,
+                                 "mem_clock_rate", mem_clock_rate,
+                                 "mem_bus_width", mem_bus_width);
+        }
+
+        static PyObject* graphCreate(PyObject* self, PyObject* args) {
+            hipGraph_t graph;
+            HIP_CHECK(hipGraphCreate(&graph, 0));
+            return PyLong_FromUnsignedLongLong((uint64_t)graph);
+        }
+
+        static PyObject* graphInstantiate(PyObject* self, PyObject* args) {
+            uint64_t graph;
+            if(!PyArg_ParseTuple(args, "K", &graph))
+                return NULL;
+            hipGraphExec_t graph_exec;
+            HIP_CHECK(hipGraphInstantiate(&graph_exec, (hipGraph_t)graph, NULL, NULL, 0));
+            return PyLong_FromUnsignedLongLong((uint64_t)graph_exec);
+        }
+
+        static PyObject* graphLaunch(PyObject* self, PyObject* args) {
+            uint64_t graph_exec;
+            uint64_t stream;
+            if(!PyArg_ParseTuple(args, "KK", &graph_exec, &stream))
+                return NULL;
+            HIP_CHECK(hipGraphLaunch((hipGraphExec_t)graph_exec, (hipStream_t)stream));
+            Py_RETURN_NONE;
+        }
+
+        static PyObject* enablePeerAccess(PyObject* self, PyObject* args) {
+            int device;
+            int peer;
+            if(!PyArg_ParseTuple(args, "ii", &device, &peer))
+                return NULL;
+            int can_access;
+            HIP_CHECK(hipDeviceCanAccessPeer(&can_access, device, peer));
+            if (!can_access)
+                return PyBool_FromLong(0);
+            int current;
+            HIP_CHECK(hipGetDevice(&current));
+            HIP_CHECK(hipSetDevice(device));
+            hipError_t result = hipDeviceEnablePeerAccess(peer, 0);
+            HIP_CHECK(hipSetDevice(current));
+            if (result != hipErrorPeerAccessAlreadyEnabled)
+                HIP_CHECK(result);
+            return PyBool_FromLong(1);
+        }
+
+        static PyObject* graphDestroy(PyObject* self, PyObject* args) {
+            uint64_t graph;
+            if(!PyArg_ParseTuple(args, "K", &graph))
+                return NULL;
+            HIP_CHECK(hipGraphDestroy((hipGraph_t)graph));
+            Py_RETURN_NONE;
+        }
+
+        static PyObject* graphExecDestroy(PyObject* self, PyObject* args) {
+            uint64_t graph_exec;
+            if(!PyArg_ParseTuple(args, "K", &graph_exec))
+                return NULL;
+            HIP_CHECK(hipGraphExecDestroy((hipGraphExec_t)graph_exec));
+            Py_RETURN_NONE;
+        }
+
         static PyMethodDef ModuleMethods[] = {
-          {"load_binary", loadBinary, METH_VARARGS, "Load provided hsaco into HIP driver"},
+          {"load_binary", loadBinary, METH_VARARGS, "Load provided hsaco code object into HIP driver"},
+          {"set_global", setGlobal, METH_VARARGS, "Set a 64-bit global variable of a loaded module"},
+          {"get_device_properties", getDeviceProperties, METH_VARARGS, "Get the properties for a given device"},
+          {"graph_create", graphCreate, METH_VARARGS, "Create an empty HIP graph"},
+          {"graph_instantiate", graphInstantiate, METH_VARARGS, "Instantiate a HIP graph"},
+          {"graph_launch", graphLaunch, METH_VARARGS, "Launch an instantiated HIP graph on a stream"},
+          {"graph_destroy", graphDestroy, METH_VARARGS, "Destroy a HIP graph"},
+          {"graph_exec_destroy", graphExecDestroy, METH_VARARGS, "Destroy an instantiated HIP graph"},
+          {"enable_peer_access", enablePeerAccess, METH_VARARGS, "Give a device access to the memory of a peer device"},
           {NULL, NULL, 0, NULL} // sentinel
         };
 
@@ -2212,6 +4623,8 @@ class HIPUtils(object):
         key = hashlib.md5(src.encode("utf-8")).hexdigest()
         cache = CacheManager(key)
         fname = "hip_utils.so"
+        self.so_key = key
+        self.so_name = fname
         if not cache.has_file(fname):
             with tempfile.TemporaryDirectory() as tmpdir:
                 src_path = os.path.join(tmpdir, "main.c")
@@ -2225,4 +4638,11 @@ class HIPUtils(object):
         mod = importlib.util.module_from_spec(spec)
         spec.loader.exec_module(mod)
         self.load_binary = mod.load_binary
-        # self.get_device_properties = mod.get_device_properties
+        self.set_global = mod.set_global
+        self.get_device_properties = mod.get_device_properties
+        self.graph_create = mod.graph_create
+        self.graph_instantiate = mod.graph_instantiate
+        self.graph_launch = mod.graph_launch
+        self.graph_destroy = mod.graph_destroy
+        self.graph_exec_destroy = mod.graph_exec_destroy
+        self.enable_peer_access = mod.enable_peer_access
@@ -7,7 +7,7 @@ APIs defined in the `triton.impl` module which are public will be re-exported
 in other relevant `triton` module namespaces.
 """
 
-from .base import builtin, extern, is_builtin
+from .base import builtin, extern, is_builtin, takes_generator
 from triton._C.libtriton.triton import ir
 
 __all__ = [
@@ -15,4 +15,5 @@ __all__ = [
     "extern",
     "ir",
     "is_builtin",
+    "takes_generator",
 ]
@@ -1,11 +1,13 @@
 from __future__ import annotations
 
+import inspect
 from functools import wraps
 from typing import TypeVar
 
 T = TypeVar("T")
 
 TRITON_BUILTIN = "__triton_builtin__"
+TRITON_TAKES_GENERATOR = "__triton_takes_generator__"
 
 
 def builtin(fn: T) -> T:
@@ -22,6 +24,9 @@ def builtin(fn: T) -> T:
         return fn(*args, **kwargs)
 
     setattr(wrapper, TRITON_BUILTIN, True)
+    # builtins taking functions as arguments (e.g. reduce) call them through
+    # the code generator, passed as `_generator`
+    setattr(wrapper, TRITON_TAKES_GENERATOR, "_generator" in inspect.signature(fn).parameters)
 
     return wrapper
 
@@ -31,6 +36,11 @@ def is_builtin(fn) -> bool:
     return getattr(fn, TRITON_BUILTIN, False)
 
 
+def takes_generator(fn) -> bool:
+    """Does this builtin take the code generator as `_generator`?"""
+    return getattr(fn, TRITON_TAKES_GENERATOR, False)
+
+
 def extern(fn: T) -> T:
     """A decorator for external functions."""
     return builtin(fn)
@@ -8,7 +8,9 @@ from ..impl import (
 from . import libdevice
 from .core import (
     abs,
+    advance,
     arange,
+    associative_scan,
     argmin,
     argmax,
     atomic_add,
@@ -37,14 +39,20 @@ from .core import (
     float32,
     float64,
     float8,
+    float8e4,
+    float8e5,
     function_type,
+    gelu,
+    grid_barrier,
     int1,
     int16,
     int32,
     int64,
     int8,
+    join,
     load,
     log,
+    make_block_ptr,
     max,
     max_contiguous,
     maximum,
@@ -52,21 +60,30 @@ from .core import (
     minimum,
     multiple_of,
     num_programs,
+    philox_rounds,
     pi32_t,
     pointer_type,
     printf,
+    profile_region,
     program_id,
     ravel,
+    reduce,
     reshape,
+    scratch,
     sigmoid,
     sin,
     softmax,
+    sort,
+    sparse_dot,
+    split,
     sqrt,
     store,
     sum,
     swizzle2d,
     static_range,
     tensor,
+    topk,
+    trace,
     trans,
     triton,
     uint16,
@@ -74,6 +91,7 @@ from .core import (
     uint64,
     uint8,
     umulhi,
+    unrolled_range,
     view,
     void,
     where,
@@ -97,7 +115,9 @@ from .random import (
 
 __all__ = [
     "abs",
+    "advance",
     "arange",
+    "associative_scan",
     "argmin",
     "argmax",
     "atomic_add",
@@ -126,17 +146,23 @@ __all__ = [
     "float32",
     "float64",
     "float8",
+    "float8e4",
+    "float8e5",
     "full",
     "function_type",
+    "gelu",
+    "grid_barrier",
     "int1",
     "int16",
     "int32",
     "int64",
     "int8",
     "ir",
+    "join",
     "libdevice",
     "load",
     "log",
+    "make_block_ptr",
     "max",
     "max_contiguous",
     "maximum",
@@ -147,9 +173,11 @@ __all__ = [
     "pair_uniform_to_normal",
     "philox",
     "philox_impl",
+    "philox_rounds",
     "pi32_t",
     "pointer_type",
     "printf",
+    "profile_region",
     "program_id",
     "rand",
     "rand4x",
@@ -158,16 +186,23 @@ __all__ = [
     "randn",
     "randn4x",
     "ravel",
+    "reduce",
     "reshape",
+    "scratch",
     "sigmoid",
     "sin",
     "softmax",
+    "sort",
+    "sparse_dot",
+    "split",
     "sqrt",
     "static_range",
     "store",
     "sum",
     "swizzle2d",
     "tensor",
+    "topk",
+    "trace",
     "trans",
     "triton",
     "uint16",
@@ -176,6 +211,7 @@ __all__ = [
     "uint64",
     "uint8",
     "umulhi",
+    "unrolled_range",
     "view",
     "void",
     "where",
@@ -37,8 +37,8 @@ def _to_tensor(x, builder):
 class dtype:
     SINT_TYPES = ['int1', 'int8', 'int16', 'int32', 'int64']
     UINT_TYPES = ['uint8', 'uint16', 'uint32', 'uint64']
-    FP_TYPES = ['fp8', 'fp16', 'bf16', 'fp32', 'fp64']
-    CUSTOMIZED_FP_TYPES = ['fp8']
+    FP_TYPES = ['fp8', 'fp8e4', 'fp8e5', 'fp16', 'bf16', 'fp32', 'fp64']
+    CUSTOMIZED_FP_TYPES = ['fp8', 'fp8e4', 'fp8e5']
     STANDARD_FP_TYPES = ['fp16', 'bf16', 'fp32', 'fp64']
     OTHER_TYPES = ['void']
 
@@ -58,9 +58,12 @@ class dtype:
             self.int_bitwidth = int(name.split('int')[-1])
             self.primitive_bitwidth = self.int_bitwidth
         elif name in dtype.FP_TYPES:
-            if name == 'fp8':
+            if name in ('fp8', 'fp8e4'):
                 self.fp_mantissa_width = 3
                 self.primitive_bitwidth = 8
+            elif name == 'fp8e5':
+                self.fp_mantissa_width = 2
+                self.primitive_bitwidth = 8
             elif name == 'fp16':
                 self.fp_mantissa_width = 10
                 self.primitive_bitwidth = 16
@@ -79,6 +82,12 @@ class dtype:
     def is_fp8(self):
         return self.name == 'fp8'
 
+    def is_fp8e4(self):
+        return self.name == 'fp8e4'
+
+    def is_fp8e5(self):
+        return self.name == 'fp8e5'
+
     def is_fp16(self):
         return self.name == 'fp16'
 
@@ -181,6 +190,10 @@ class dtype:
             return builder.get_int64_ty()
         elif self.name == 'fp8':
             return builder.get_fp8_ty()
+        elif self.name == 'fp8e4':
+            return builder.get_fp8e4_ty()
+        elif self.name == 'fp8e5':
+            return builder.get_fp8e5_ty()
         elif self.name == 'fp16':
             return builder.get_half_ty()
         elif self.name == 'bf16':
@@ -213,9 +226,11 @@ class pointer_type(dtype):
         self.name = self.__str__()
 
     def to_ir(self, builder: ir.builder) -> ir.pointer_type:
-        return builder.get_ptr_ty(self.element_ty.to_ir(builder), 1)
+        return builder.get_ptr_ty(self.element_ty.to_ir(builder), self.address_space)
 
     def __str__(self):
+        if self.address_space != 1:
+            return f'pointer<{self.element_ty}, {self.address_space}>'
         return f'pointer<{self.element_ty}>'
 
     def __repr__(self):
@@ -311,6 +326,8 @@ uint16 = dtype('uint16')
 uint32 = dtype('uint32')
 uint64 = dtype('uint64')
 float8 = dtype('fp8')
+float8e4 = dtype('fp8e4')
+float8e5 = dtype('fp8e5')
 float16 = dtype('fp16')
 bfloat16 = dtype('bf16')
 float32 = dtype('fp32')
@@ -661,7 +678,7 @@ def _constexpr_to_value(v):
 
 
 @builtin
-def program_id(axis, _builder=None):
+def program_id(axis, _builder=None, _generator=None):
     """
     Returns the id of the current program instance along the given :code:`axis`.
 
@@ -676,11 +693,14 @@ def program_id(axis, _builder=None):
     #     npg1 = num_programs(0, _builder)
     #     return pid0 + pid1*npg0 + pid2*npg0*npg1
     axis = _constexpr_to_value(axis)
+    # the program ids of the bodies of horizontally fused kernels are remapped
+    if _generator is not None and _generator.program_ids is not None:
+        return _generator.program_ids[axis]
     return semantic.program_id(axis, _builder)
 
 
 @builtin
-def num_programs(axis, _builder=None):
+def num_programs(axis, _builder=None, _generator=None):
     """
     Returns the number of program instances launched along the given :code:`axis`.
 
@@ -688,9 +708,29 @@ def num_programs(axis, _builder=None):
     :type axis: int
     """
     axis = _constexpr_to_value(axis)
+    if _generator is not None and _generator.num_programs is not None:
+        return _generator.num_programs[axis]
     return semantic.num_programs(axis, _builder)
 
 
+@builtin
+def scratch(dtype, size, _builder=None):
+    """
+    Returns a pointer to :code:`size` elements of type :code:`dtype` in the shared memory of
+    the current program instance. Their initial values are undefined, and they can be
+    accessed with :code:`load`, :code:`store` and the :code:`atomic_*` functions, the atomics
+    being done in shared memory.
+
+    :param dtype: Data-type of the elements
+    :type dtype: DType
+    :param size: Number of elements
+    :type size: int
+    """
+    dtype = _constexpr_to_value(dtype)
+    size = _constexpr_to_value(size)
+    return semantic.scratch(dtype, size, _builder)
+
+
 # -----------------------
 # Block Initialization
 # -----------------------
@@ -796,7 +836,7 @@ def trans(input, _builder=None):
 
 
 @builtin
-def cat(input, other, can_reorder=False, _builder=None):
+def cat(input, other, can_reorder=False, dim=0, _builder=None):
     """
     Concatenate the given blocks
 
@@ -808,8 +848,39 @@ def cat(input, other, can_reorder=False, _builder=None):
     allowed to reorder elements while concatenating inputs.
     Only use if the order does not matter (e.g., result is
     only used in reduction ops)
+    :param dim: The dimension along which :code:`other` follows :code:`input`,
+    if the elements are not reordered. Both blocks must then have the same shape.
     """
-    return semantic.cat(input, other, can_reorder, _builder)
+    can_reorder = _constexpr_to_value(can_reorder)
+    dim = _constexpr_to_value(dim)
+    return semantic.cat(input, other, can_reorder, dim, _builder)
+
+
+@builtin
+def join(a, b, _builder=None):
+    """
+    Joins two blocks of the same shape along a new minor dimension of size 2,
+    such that :code:`join(a, b)[..., 0] == a` and :code:`join(a, b)[..., 1] == b`.
+
+    Reshaped to drop the new dimension, the result interleaves the elements of
+    :code:`a` and :code:`b`.
+
+    :param a: The first input tensor.
+    :param b: The second input tensor.
+    """
+    return semantic.join(a, b, _builder)
+
+
+@builtin
+def split(a, _builder=None):
+    """
+    Splits a block whose last dimension is 2 into its two halves along that
+    dimension, the inverse of :code:`join`.
+
+    :param a: The tensor to split.
+    :returns: The two tensors :code:`a[..., 0]` and :code:`a[..., 1]`.
+    """
+    return semantic.split(a, _builder)
 
 
 @builtin
@@ -840,19 +911,55 @@ def reshape(input, shape, _builder=None):
 
 
 @builtin
-def dot(input, other, allow_tf32=True, _builder=None):
+def dot(input, other, allow_tf32=True, input_scale=None, other_scale=None, precision=None, _builder=None):
     """
     Returns the matrix product of two blocks.
 
-    The two blocks must be two-dimensional and have compatible inner dimensions.
+    The two blocks must be two-dimensional and have compatible inner dimensions, or
+    three-dimensional with the same leading batch dimension, in which case the
+    matrices of each batch are multiplied together.
 
     :param input: The first tensor to be multiplied.
-    :type input: 2D tensor of scalar-type in {:code:`float16`, :code:`bfloat16`, :code:`float32`}
+    :type input: 2D or 3D tensor of scalar-type in {:code:`float8e4`, :code:`float8e5`, :code:`float16`, :code:`bfloat16`, :code:`float32`}
     :param other: The second tensor to be multiplied.
-    :type other: 2D tensor of scalar-type in {:code:`float16`, :code:`bfloat16`, :code:`float32`}
+    :type other: 2D or 3D tensor of scalar-type in {:code:`float8e4`, :code:`float8e5`, :code:`float16`, :code:`bfloat16`, :code:`float32`}
+    :param input_scale: Optional scalar factor of :code:`input`, e.g. the per-tensor scale of fp8 data.
+    :param other_scale: Optional scalar factor of :code:`other`.
+    :param precision: Precision of the products of :code:`float32` blocks: :code:`"ieee"`, :code:`"tf32"`,
+        or :code:`"tf32x3"`, which splits each operand into two :code:`tf32` values and accumulates three
+        tensor-core products to be about as accurate as :code:`"ieee"`. Defaults to :code:`"tf32"` if
+        :code:`allow_tf32` and :code:`"ieee"` otherwise.
+    :type precision: str, optional
     """
     allow_tf32 = _constexpr_to_value(allow_tf32)
-    return semantic.dot(input, other, allow_tf32, _builder)
+    precision = _constexpr_to_value(precision)
+    if input_scale is not None:
+        input_scale = _to_tensor(input_scale, _builder)
+    if other_scale is not None:
+        other_scale = _to_tensor(other_scale, _builder)
+    return semantic.dot(input, other, allow_tf32, _builder, input_scale, other_scale, precision)
+
+
+@builtin
+def sparse_dot(input, meta, other, _builder=None):
+    """
+    Returns the matrix product of a 2:4 structured-sparse block and a dense block.
+
+    In every group of 4 consecutive elements of a row of the sparse block, at most 2 are non-zero.
+    :code:`input` holds these 2 values of each group, and :code:`meta` their positions in the
+    group: the bits :code:`[4 * j, 4 * j + 4)` of :code:`meta[i, k]` hold the positions of the
+    values of the group :code:`j` of the 16 columns :code:`[8 * k, 8 * k + 8)` of :code:`input`,
+    2 bits each. :code:`triton.ops.compress_2to4` computes both from a dense matrix.
+    Only supported by the sparse tensor cores of NVIDIA GPUs of compute capability 8.0 or more.
+
+    :param input: The compressed values of the sparse block, of shape :code:`(M, K / 2)`.
+    :type input: 2D tensor of scalar-type in {:code:`float16`, :code:`bfloat16`}
+    :param meta: The positions of the values of :code:`input`, of shape :code:`(M, K / 16)`.
+    :type meta: 2D tensor of scalar-type :code:`int16`
+    :param other: The dense block, of shape :code:`(K, N)`.
+    :type other: 2D tensor of the scalar-type of :code:`input`
+    """
+    return semantic.sparse_dot(input, meta, other, _builder)
 
 
 # -----------------------
@@ -861,7 +968,38 @@ def dot(input, other, allow_tf32=True, _builder=None):
 
 
 @builtin
-def load(pointer, mask=None, other=None, cache_modifier="", eviction_policy="", volatile=False, _builder=None):
+def make_block_ptr(base, shape, strides, offsets, block_shape, order, _builder=None):
+    """
+    Returns a pointer to the block of shape :code:`block_shape` of the tensor of :code:`shape` and
+    :code:`strides` at :code:`base`, whose first element is at :code:`offsets`. Loads and stores through
+    it only compute the addresses of its elements from a scalar base and offsets, and check
+    the bounds of the tensor along the dimensions given by their :code:`boundary_check`.
+
+    :param base: Pointer to the first element of the tensor.
+    :param shape: Sizes of the tensor.
+    :param strides: Strides of the tensor, in elements.
+    :param offsets: Coordinates of the first element of the block.
+    :param block_shape: Sizes of the block, powers of two.
+    :type block_shape: tuple of constexpr
+    :param order: Dimensions of the block from the fastest-varying one to the slowest one.
+    :type order: tuple of constexpr
+    """
+    block_shape = [_constexpr_to_value(s) for s in block_shape]
+    order = [_constexpr_to_value(o) for o in order]
+    return semantic.make_block_ptr(base, shape, strides, offsets, block_shape, order, _builder)
+
+
+@builtin
+def advance(base, offsets, _builder=None):
+    """
+    Returns the block pointer :code:`base` moved by :code:`offsets` elements along each dimension.
+    """
+    return semantic.advance(base, offsets, _builder)
+
+
+@builtin
+def load(pointer, mask=None, other=None, cache_modifier="", eviction_policy="", volatile=False,
+         l2_evict_last_fraction=None, boundary_check=tuple(), padding_option="", _builder=None):
     """
     Return a tensor of data whose values are, elementwise, loaded from memory at location defined by :code:`pointer`.
 
@@ -869,14 +1007,26 @@ def load(pointer, mask=None, other=None, cache_modifier="", eviction_policy="",
 
     :code:`other` is implicitly typecast to :code:`pointer.dtype.element_ty`.
 
+    If :code:`pointer` is a block pointer made by :code:`make_block_ptr`, :code:`mask` and :code:`other`
+    must be left unset: the elements out of the bounds of the tensor along the dimensions of
+    :code:`boundary_check` are not loaded, and are set according to :code:`padding_option`.
+
     :param pointer: Pointers to the data to be loaded.
-    :type pointer: Block of dtype=triton.PointerDType
+    :type pointer: Block of dtype=triton.PointerDType, or block pointer
     :param mask: if mask[idx] is false, do not load the data at address :code:`pointer[idx]`.
     :type mask: Block of triton.int1, optional
     :param other: if mask[idx] is false, return other[idx]
     :type other: Block, optional
     :param cache_modifier: changes cache option in nvidia ptx
     'type cache_modifier: str, optional
+    :param l2_evict_last_fraction: if set, keeps this fraction of the loaded lines resident in L2
+        with evict_last priority (sm_80+, ignored on AMD GPUs)
+    'type l2_evict_last_fraction: float, optional
+    :param boundary_check: dimensions of a block pointer along which to check the bounds
+    'type boundary_check: tuple of int, optional
+    :param padding_option: value of the elements out of bounds of a block pointer ("zero", "nan"),
+        undefined if unset
+    'type padding_option: str, optional
     """
     # mask, other can be constexpr
     if _constexpr_to_value(mask) is not None:
@@ -886,11 +1036,14 @@ def load(pointer, mask=None, other=None, cache_modifier="", eviction_policy="",
     cache_modifier = _constexpr_to_value(cache_modifier)
     eviction_policy = _constexpr_to_value(eviction_policy)
     volatile = _constexpr_to_value(volatile)
-    return semantic.load(pointer, mask, other, cache_modifier, eviction_policy, volatile, _builder)
+    l2_evict_last_fraction = _constexpr_to_value(l2_evict_last_fraction)
+    padding_option = _constexpr_to_value(padding_option)
+    return semantic.load(pointer, mask, other, cache_modifier, eviction_policy, volatile, _builder,
+                         l2_evict_last_fraction, boundary_check, padding_option)
 
 
 @builtin
-def store(pointer, value, mask=None, _builder=None):
+def store(pointer, value, mask=None, cache_modifier="", eviction_policy="", boundary_check=tuple(), _builder=None):
     """
     Stores :code:`value` tensor of elements in memory, element-wise, at the memory locations specified by :code:`pointer`.
 
@@ -902,19 +1055,28 @@ def store(pointer, value, mask=None, _builder=None):
     :type value: Block
     :param mask: If mask[idx] is false, do not store :code:`value[idx]` at :code:`pointer[idx]`.
     :type mask: Block of triton.int1, optional
+    :param cache_modifier: changes cache option in nvidia ptx (".wb", ".cg", ".cs" or ".wt")
+    'type cache_modifier: str, optional
+    :param eviction_policy: changes eviction policy ("evict_first" or "evict_last")
+    'type eviction_policy: str, optional
+    :param boundary_check: dimensions of a block pointer along which the elements out of the bounds
+        of the tensor are not stored
+    'type boundary_check: tuple of int, optional
     """
     # value can be constexpr
     value = _to_tensor(value, _builder)
     if _constexpr_to_value(mask) is not None:
         mask = _to_tensor(mask, _builder)
-    return semantic.store(pointer, value, mask, _builder)
+    cache_modifier = _constexpr_to_value(cache_modifier)
+    eviction_policy = _constexpr_to_value(eviction_policy)
+    return semantic.store(pointer, value, mask, cache_modifier, eviction_policy, _builder, boundary_check)
 
 
 # -----------------------
 # Atomic Memory Operations
 # -----------------------
 
-def _add_atomic_docstr(name: str) -> Callable[[T], T]:
+def _add_atomic_docstr(name: str, extra_params: str = "") -> Callable[[T], T]:
 
     def _decorator(func: T) -> T:
         docstr = """
@@ -928,8 +1090,17 @@ def _add_atomic_docstr(name: str) -> Callable[[T], T]:
     :type cmp: Block of dtype=`pointer.dtype.element_ty`
     :param val: The values to copy in case the expected value matches the contained value.
     :type val: Block of dtype=`pointer.dtype.element_ty`
+    :param sem: Memory semantic of the atomic: :code:`"relaxed"`, :code:`"acquire"`, :code:`"release"`
+        or :code:`"acq_rel"`. An acquire is ordered before the later memory accesses of the program and a
+        release after the earlier ones, so that a flag set by a release and read by an acquire of another
+        program makes the data written before it visible. Relaxed by default.
+    :type sem: str, optional
+    :param scope: The set of threads the atomic, and the ordering of its semantic, is visible to:
+        :code:`"cta"`, :code:`"gpu"` or :code:`"sys"`. Flags shared with other GPUs, e.g. through peer
+        pointers, need :code:`"sys"`. The GPU by default on NVIDIA GPUs, and the system on AMD GPUs.
+    :type scope: str, optional
     """
-        func.__doc__ = docstr.format(name=name)
+        func.__doc__ = docstr.format(name=name) + extra_params
         return func
 
     return _decorator
@@ -937,59 +1108,80 @@ def _add_atomic_docstr(name: str) -> Callable[[T], T]:
 
 @builtin
 @_add_atomic_docstr("compare-and-swap")
-def atomic_cas(pointer, cmp, val, _builder=None):
+def atomic_cas(pointer, cmp, val, sem=None, scope=None, _builder=None):
     cmp = _to_tensor(cmp, _builder)
     val = _to_tensor(val, _builder)
-    return semantic.atomic_cas(pointer, cmp, val, _builder)
+    sem = _constexpr_to_value(sem)
+    scope = _constexpr_to_value(scope)
+    return semantic.atomic_cas(pointer, cmp, val, sem, scope, _builder)
 
 
 @builtin
 @_add_atomic_docstr("exchange")
-def atomic_xchg(pointer, val, mask=None, _builder=None):
+def atomic_xchg(pointer, val, mask=None, sem=None, scope=None, _builder=None):
     val = _to_tensor(val, _builder)
-    return semantic.atomic_xchg(pointer, val, mask, _builder)
+    sem = _constexpr_to_value(sem)
+    scope = _constexpr_to_value(scope)
+    return semantic.atomic_xchg(pointer, val, mask, sem, scope, _builder)
 
 
 @builtin
-@_add_atomic_docstr("add")
-def atomic_add(pointer, val, mask=None, _builder=None):
+@_add_atomic_docstr("add", """:param aggregate: If true, the values of the lanes of a warp with the same address are
+        summed before a single atomic is issued for them, which speeds up histograms and scatters with
+        many collisions. Only applies to 32 and 64-bit types when the return value is unused.
+    :type aggregate: bool, optional
+    """)
+def atomic_add(pointer, val, mask=None, aggregate=False, sem=None, scope=None, _builder=None):
     val = _to_tensor(val, _builder)
-    return semantic.atomic_add(pointer, val, mask, _builder)
+    aggregate = _constexpr_to_value(aggregate)
+    sem = _constexpr_to_value(sem)
+    scope = _constexpr_to_value(scope)
+    return semantic.atomic_add(pointer, val, mask, aggregate, sem, scope, _builder)
 
 
 @builtin
 @_add_atomic_docstr("max")
-def atomic_max(pointer, val, mask=None, _builder=None):
+def atomic_max(pointer, val, mask=None, sem=None, scope=None, _builder=None):
     val = _to_tensor(val, _builder)
-    return semantic.atomic_max(pointer, val, mask, _builder)
+    sem = _constexpr_to_value(sem)
+    scope = _constexpr_to_value(scope)
+    return semantic.atomic_max(pointer, val, mask, sem, scope, _builder)
 
 
 @builtin
 @_add_atomic_docstr("min")
-def atomic_min(pointer, val, mask=None, _builder=None):
+def atomic_min(pointer, val, mask=None, sem=None, scope=None, _builder=None):
     val = _to_tensor(val, _builder)
-    return semantic.atomic_min(pointer, val, mask, _builder)
+    sem = _constexpr_to_value(sem)
+    scope = _constexpr_to_value(scope)
+    return semantic.atomic_min(pointer, val, mask, sem, scope, _builder)
 
 
 @builtin
 @_add_atomic_docstr("logical and")
-def atomic_and(pointer, val, mask=None, _builder=None):
+def atomic_and(pointer, val, mask=None, sem=None, scope=None, _builder=None):
     val = _to_tensor(val, _builder)
-    return semantic.atomic_and(pointer, val, mask, _builder)
+    sem = _constexpr_to_value(sem)
+    scope = _constexpr_to_value(scope)
+    return semantic.atomic_and(pointer, val, mask, sem, scope, _builder)
 
 
 @builtin
 @_add_atomic_docstr("logical or")
-def atomic_or(pointer, val, mask=None, _builder=None):
+def atomic_or(pointer, val, mask=None, sem=None, scope=None, _builder=None):
     val = _to_tensor(val, _builder)
-    return semantic.atomic_or(pointer, val, mask, _builder)
+    sem = _constexpr_to_value(sem)
+    scope = _constexpr_to_value(scope)
+    return semantic.atomic_or(pointer, val, mask, sem, scope, _builder)
 
 
 @builtin
 @_add_atomic_docstr("logical xor")
-def atomic_xor(pointer, val, mask=None, _builder=None):
+def atomic_xor(pointer, val, mask=None, sem=None, scope=None, _builder=None):
     val = _to_tensor(val, _builder)
-    return semantic.atomic_xor(pointer, val, mask, _builder)
+    sem = _constexpr_to_value(sem)
+    scope = _constexpr_to_value(scope)
+    return semantic.atomic_xor(pointer, val, mask, sem, scope, _builder)
 
 
 # -----------------------
@@ -1031,6 +1223,18 @@ def umulhi(x, y, _builder=None):
     return semantic.umulhi(x, y, _builder)
 
 
+@builtin
+def philox_rounds(c0, c1, c2, c3, k0, k1, n_rounds, _builder=None):
+    """
+    Runs :code:`n_rounds` rounds of Philox4x32 on the uint32 counter
+    :code:`(c0, c1, c2, c3)` with the uint32 key :code:`(k0, k1)`, and returns
+    the four blocks of the resulting counter.
+    """
+    args = [_to_tensor(x, _builder) for x in (c0, c1, c2, c3, k0, k1)]
+    n_rounds = _constexpr_to_value(n_rounds)
+    return semantic.philox(*args, n_rounds, _builder)
+
+
 @builtin
 def fdiv(x, y, ieee_rounding=False, _builder=None):
     ieee_rounding = _constexpr_to_value(ieee_rounding)
@@ -1101,6 +1305,101 @@ def _add_reduction_docstr(name: str) -> Callable[[T], T]:
     return _decorator
 
 
+def _make_combine_region(op, inputs, combine_fn, create_ret, _builder, _generator):
+    # The combine function takes the accumulated values of the inputs followed by
+    # their current values, and is called from the body of the region of `op`
+    scalar_tys = [t.type.scalar for t in inputs]
+    region = op.get_region(0)
+    insertion_point = _builder.get_insertion_point()
+    block = _builder.create_block_with_parent(
+        region, [ty.to_ir(_builder) for ty in scalar_tys * 2])
+    args = [tensor(block.arg(i), ty) for i, ty in enumerate(scalar_tys * 2)]
+    results = _generator.call_JitFunction(combine_fn, args, kws={})
+    if isinstance(results, tensor):
+        results = (results,)
+    create_ret([r.handle for r in results])
+    _builder.restore_insertion_point(insertion_point)
+
+
+@builtin
+def reduce(input, axis, combine_fn, _builder=None, _generator=None):
+    """Applies the :code:`combine_fn` to all the elements of the :code:`input`
+    tensors along the provided :code:`axis`
+
+    :param input: the input tensor, or a tuple of tensors of the same shape
+    :param axis: the dimension along which the reduction should be done
+    :param combine_fn: a function taking the accumulated and the current values
+        of every input tensor, and returning the new accumulated ones. It must be
+        associative and commutative, and be marked with @triton.jit
+    """
+    if isinstance(input, tensor):
+        return reduce((input,), axis, combine_fn,
+                      _builder=_builder, _generator=_generator)[0]
+
+    def make_combine_region(reduce_op):
+        _make_combine_region(reduce_op, input, combine_fn,
+                             _builder.create_generic_reduce_ret, _builder, _generator)
+
+    axis = _constexpr_to_value(axis)
+    return semantic.generic_reduce(input, axis, make_combine_region, _builder)
+
+
+@builtin
+def associative_scan(input, axis, combine_fn, reverse=False, _builder=None, _generator=None):
+    """Returns the inclusive scans of the :code:`input` tensors along the
+    provided :code:`axis`, combining their elements with :code:`combine_fn`
+
+    :param input: the input tensor, or a tuple of tensors of the same shape
+    :param axis: the dimension along which the scan should be done
+    :param combine_fn: a function taking the accumulated and the current values
+        of every input tensor, and returning the new accumulated ones. It must be
+        associative, and be marked with @triton.jit
+    :param reverse: whether to scan from the last element to the first one
+    """
+    if isinstance(input, tensor):
+        return associative_scan((input,), axis, combine_fn, reverse,
+                                _builder=_builder, _generator=_generator)[0]
+
+    def make_combine_region(scan_op):
+        _make_combine_region(scan_op, input, combine_fn,
+                             _builder.create_scan_ret, _builder, _generator)
+
+    axis = _constexpr_to_value(axis)
+    reverse = _constexpr_to_value(reverse)
+    return semantic.associative_scan(input, axis, reverse, make_combine_region, _builder)
+
+
+@builtin
+def sort(input, axis=None, descending=False, _builder=None):
+    """Returns the :code:`input` tensor sorted along the provided :code:`axis`,
+    with a bitonic network kept in registers as far as the layout allows
+
+    :param input: the input tensor, of floats or signed integers
+    :param axis: the dimension along which to sort, the last one if None. Its
+        size must be a power of 2
+    :param descending: whether to sort from the largest element to the smallest
+    """
+    axis = _constexpr_to_value(axis)
+    descending = _constexpr_to_value(descending)
+    return semantic.sort(input, axis, descending, _builder)
+
+
+@builtin
+def topk(input, k, axis=None, _builder=None):
+    """Returns the :code:`k` largest elements of the :code:`input` tensor along
+    the provided :code:`axis`, from the largest to the smallest, and their
+    indices along it, as :code:`int32`
+
+    :param input: the input tensor, of floats or signed integers
+    :param k: the number of elements to keep, a power of 2
+    :param axis: the dimension along which to select, the last one if None.
+        Its size must be a power of 2
+    """
+    k = _constexpr_to_value(k)
+    axis = _constexpr_to_value(axis)
+    return semantic.topk(input, k, axis, _builder)
+
+
 @builtin
 @_add_reduction_docstr("maximum")
 def max(input, axis, _builder=None):
@@ -1153,6 +1452,57 @@ def debug_barrier(_builder=None):
     return semantic.debug_barrier(_builder)
 
 
+@builtin
+def grid_barrier(_builder=None):
+    """
+    Waits until all the program instances of the launch grid have reached the barrier,
+    after which the global memory writes of each are visible to all the others.
+
+    Kernels calling it are launched cooperatively, and fail to launch when the grid is
+    larger than the number of programs that can be resident on the device at once.
+    """
+    return semantic.grid_barrier(_builder)
+
+
+@builtin
+def profile_region(name, _builder=None):
+    """
+    Marks the start of the profiled region :code:`name`, which lasts until the next call or the end of the
+    kernel. The time from the start of the kernel to the first call is accounted to the region "prologue".
+
+    The cycles spent in each region by each program instance are accumulated over the launches of the kernel,
+    and reported by :code:`CompiledKernel.profile_report`.
+
+    :param name: the name of the region
+    :type name: str, must be a compile-time constant
+    """
+    name = _constexpr_to_value(name)
+    if not isinstance(name, str):
+        raise TypeError(f"profile_region name must be a string, got {name!r}")
+    return semantic.profile_region(name, _builder)
+
+
+@builtin
+def trace(prefix, *args, _builder=None):
+    """
+    Records the scalars and tensors :code:`args` into the trace of the kernel, a ring buffer in device memory
+    that the host reads back with :code:`CompiledKernel.trace_records`. The kernel only stores the binary values,
+    with the program and the thread that recorded them, and the host decodes them with the format of the call:
+    unlike :code:`printf`, tracing doesn't serialize the threads, and works on the targets without vprintf.
+
+    Each thread records its own elements of the tensors, with their indices, and only the first thread of the
+    program records the scalars when there are no tensors.
+
+    :param prefix: the prefix of the records
+    :type prefix: str, must be a compile-time constant
+    """
+    prefix = _constexpr_to_value(prefix)
+    if not isinstance(prefix, str):
+        raise TypeError(f"trace prefix must be a string, got {prefix!r}")
+    new_args = [_to_tensor(arg, _builder) for arg in args]
+    return semantic.trace(prefix, new_args, _builder)
+
+
 @builtin
 def multiple_of(input, values, _builder=None):
     """
@@ -1239,6 +1589,14 @@ def sigmoid(x):
     return 1 / (1 + triton.language.exp(-x))
 
 
+@triton.jit
+@_add_math_1arg_docstr("GELU (tanh approximation)")
+def gelu(x):
+    # 0.5 * x * (1 + tanh(y)) == x * sigmoid(2 * y)
+    # with y = sqrt(2 / pi) * (x + 0.044715 * x^3)
+    return x * sigmoid(1.5957691216057308 * (x + 0.044715 * x * x * x))
+
+
 @triton.jit
 @_add_math_1arg_docstr("softmax")
 def softmax(x, ieee_rounding=False):
@@ -1357,3 +1715,37 @@ class static_range:
 
     def __next__(self):
         raise RuntimeError("static_range can only be used in @triton.jit'd functions")
+
+
+class unrolled_range:
+
+    """
+    Iterator like :code:`range`, whose loop is unrolled :code:`factor` times by the compiler
+    when its bounds and step are compile-time constants, e.g. the loop over the chunks of a
+    head dimension. Unlike :code:`static_range`, the loop is kept when the trip count is
+    larger than the factor, and the remaining iterations run in a second loop.
+
+    :param factor: Number of iterations per unrolled iteration, e.g. a meta-parameter
+        tuned by the autotuner.
+    :type factor: int
+    """
+
+    def __init__(self, arg1, arg2=None, step=None, factor=2):
+        if step is None:
+            self.step = constexpr(1)
+        else:
+            self.step = step
+        if arg2 is None:
+            self.start = constexpr(0)
+            self.end = arg1
+        else:
+            self.start = arg1
+            self.end = arg2
+        self.factor = factor if isinstance(factor, constexpr) else constexpr(factor)
+        assert isinstance(self.factor.value, int) and self.factor.value >= 1, "factor must be a positive integer"
+
+    def __iter__(self):
+        raise RuntimeError("unrolled_range can only be used in @triton.jit'd functions")
+
+    def __next__(self):
+        raise RuntimeError("unrolled_range can only be used in @triton.jit'd functions")
@@ -16,20 +16,14 @@ N_ROUNDS_DEFAULT = 10  # Default number of rounds for philox
 def philox_impl(c0, c1, c2, c3, k0, k1, n_rounds: tl.constexpr = N_ROUNDS_DEFAULT):
     """
     Run `n_rounds` rounds of Philox for state (c0, c1, c2, c3) and key (k0, k1).
+
+    The rounds are a single `tt.philox` op, whose 32x32->64 bit products are
+    hardware multiplications: in each round,
+        c0, c1, c2, c3 = umulhi(B, c2) ^ c1 ^ k0, B * c2, umulhi(A, c0) ^ c3 ^ k1, A * c0
+        k0, k1 = k0 + PHILOX_KEY_A, k1 + PHILOX_KEY_B
+    with A = PHILOX_ROUND_A and B = PHILOX_ROUND_B.
     """
-    for _ in tl.static_range(n_rounds):
-        # update random state
-        A = PHILOX_ROUND_A
-        B = PHILOX_ROUND_B
-        _c0, _c2 = c0, c2
-        c0 = tl.umulhi(B, _c2) ^ c1 ^ k0
-        c2 = tl.umulhi(A, _c0) ^ c3 ^ k1
-        c1 = B * _c2
-        c3 = A * _c0
-        # raise key
-        k0 = k0 + PHILOX_KEY_A
-        k1 = k1 + PHILOX_KEY_B
-    return c0, c1, c2, c3
+    return tl.philox_rounds(c0, c1, c2, c3, k0, k1, n_rounds)
 
 
 @triton.jit
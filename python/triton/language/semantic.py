@@ -26,6 +26,14 @@ def program_id(axis: int, builder: ir.builder) -> tl.tensor:
 def num_programs(axis: int, builder: ir.builder) -> tl.tensor:
     return tl.tensor(builder.create_get_num_programs(axis), tl.int32)
 
+
+def scratch(dtype: tl.dtype, size: int, builder: ir.builder) -> tl.tensor:
+    if not isinstance(size, int) or size <= 0:
+        raise ValueError(f"scratch size must be a positive integer, got {size}")
+    # shared memory is address space 3
+    ptr_ty = tl.pointer_type(dtype, 3)
+    return tl.tensor(builder.create_scratch(ptr_ty.to_ir(builder), size), ptr_ty)
+
 # ===----------------------------------------------------------------------===//
 #                               Implicit Casting Utilities
 # ===----------------------------------------------------------------------===//
@@ -520,11 +528,36 @@ def expand_dims(input: tl.tensor, axis: int, builder: ir.builder) -> tl.tensor:
     return tl.tensor(builder.create_expand_dims(input.handle, axis), ret_ty)
 
 
-def cat(lhs: tl.tensor, rhs: tl.tensor, can_reorder: bool, builder: ir.builder) -> tl.tensor:
-    assert can_reorder, "current implementation of `cat` always may reorder elements"
-    assert len(lhs.shape) == 1
-    ret_type = tl.block_type(lhs.type.scalar, [lhs.shape[0] + rhs.shape[0]])
-    return tl.tensor(builder.create_cat(lhs.handle, rhs.handle), ret_type)
+def cat(lhs: tl.tensor, rhs: tl.tensor, can_reorder: bool, dim: int, builder: ir.builder) -> tl.tensor:
+    if can_reorder:
+        assert len(lhs.shape) == 1
+        ret_type = tl.block_type(lhs.type.scalar, [lhs.shape[0] + rhs.shape[0]])
+        return tl.tensor(builder.create_cat(lhs.handle, rhs.handle), ret_type)
+    if lhs.type != rhs.type:
+        raise ValueError(f"Ordered cat expects blocks of the same type, got {lhs.type} and {rhs.type}")
+    shape = lhs.type.get_block_shapes()
+    if not 0 <= dim < len(shape):
+        raise ValueError(f"cat dimension {dim} out of range for a block of rank {len(shape)}")
+    ret_shape = list(shape)
+    ret_shape[dim] *= 2
+    ret_type = tl.block_type(lhs.type.scalar, ret_shape)
+    return tl.tensor(builder.create_ordered_cat(lhs.handle, rhs.handle, dim), ret_type)
+
+
+def join(lhs: tl.tensor, rhs: tl.tensor, builder: ir.builder) -> tl.tensor:
+    if not lhs.type.is_block() or lhs.type != rhs.type:
+        raise ValueError(f"join expects blocks of the same type, got {lhs.type} and {rhs.type}")
+    ret_type = tl.block_type(lhs.type.scalar, lhs.type.get_block_shapes() + [2])
+    return tl.tensor(builder.create_join(lhs.handle, rhs.handle), ret_type)
+
+
+def split(input: tl.tensor, builder: ir.builder) -> Tuple[tl.tensor, tl.tensor]:
+    shape = input.type.get_block_shapes() if input.type.is_block() else []
+    if not shape or shape[-1] != 2:
+        raise ValueError(f"split expects a block whose last dimension is 2, got shape {shape}")
+    ret_type = tl.block_type(input.type.scalar, shape[:-1])
+    lhs, rhs = builder.create_split(input.handle)
+    return tl.tensor(lhs, ret_type), tl.tensor(rhs, ret_type)
 
 
 def trans(input: tl.tensor, builder: ir.builder) -> tl.tensor:
@@ -746,15 +779,148 @@ def cast(input: tl.tensor,
 # ===----------------------------------------------------------------------===//
 
 
+def _str_to_load_cache_modifier(cache_modifier):
+    cache = ir.CACHE_MODIFIER.NONE  # default
+    if cache_modifier:
+        if cache_modifier == ".ca":
+            cache = ir.CACHE_MODIFIER.CA
+        elif cache_modifier == ".cg":
+            cache = ir.CACHE_MODIFIER.CG
+        elif cache_modifier == ".cs":
+            cache = ir.CACHE_MODIFIER.CS
+        else:
+            raise ValueError(f"Cache modifier {cache_modifier} not supported")
+    return cache
+
+
+def _str_to_store_cache_modifier(cache_modifier):
+    cache = ir.CACHE_MODIFIER.NONE  # default
+    if cache_modifier:
+        if cache_modifier == ".wb":
+            cache = ir.CACHE_MODIFIER.WB
+        elif cache_modifier == ".cg":
+            cache = ir.CACHE_MODIFIER.CG
+        elif cache_modifier == ".cs":
+            cache = ir.CACHE_MODIFIER.CS
+        elif cache_modifier == ".wt":
+            cache = ir.CACHE_MODIFIER.WT
+        else:
+            raise ValueError(f"Cache modifier {cache_modifier} not supported")
+    return cache
+
+
+def _str_to_eviction_policy(eviction_policy):
+    eviction = ir.EVICTION_POLICY.NORMAL  # default
+    if eviction_policy:
+        if eviction_policy == "evict_last":
+            eviction = ir.EVICTION_POLICY.EVICT_LAST
+        elif eviction_policy == "evict_first":
+            eviction = ir.EVICTION_POLICY.EVICT_FIRST
+        else:
+            raise ValueError(f"Eviction policy {eviction_policy} not supported")
+    return eviction
+
+
+def _is_block_ptr(ptr: tl.tensor) -> bool:
+    return ptr.type.is_ptr() and ptr.type.element_ty.is_block()
+
+
+def _to_scalars(values, dst_ty: tl.dtype, name: str, builder: ir.builder) -> List[ir.value]:
+    scalars = []
+    for value in values:
+        value = tl._to_tensor(value, builder)
+        if value.type.is_block() or not value.type.is_int():
+            raise ValueError(f"Expected integer scalars in `{name}`, got {value.type}")
+        scalars.append(cast(value, dst_ty, builder).handle)
+    return scalars
+
+
+def _str_to_padding_option(padding_option):
+    if not padding_option:
+        return None
+    if padding_option == "zero":
+        return ir.PADDING_OPTION.PAD_ZERO
+    if padding_option == "nan":
+        return ir.PADDING_OPTION.PAD_NAN
+    raise ValueError(f"Padding option {padding_option} not supported")
+
+
+def _canonicalize_boundary_check(boundary_check, block_shape) -> List[int]:
+    dims = sorted(set(tl._constexpr_to_value(dim) for dim in boundary_check))
+    for dim in dims:
+        if not isinstance(dim, int) or not 0 <= dim < len(block_shape):
+            raise ValueError(f"Boundary check dimension {dim} out of range for a block of shape {block_shape}")
+    return dims
+
+
+def make_block_ptr(base: tl.tensor,
+                   shape, strides, offsets,
+                   block_shape: List[int],
+                   order: List[int],
+                   builder: ir.builder) -> tl.tensor:
+    if not base.type.is_ptr() or base.type.is_block() or base.type.element_ty.is_block():
+        raise ValueError(f"Expected a scalar pointer as the base of a block pointer, got {base.type}")
+    if not (len(shape) == len(strides) == len(offsets) == len(block_shape) == len(order)):
+        raise ValueError("Expected shape, strides, offsets, block_shape and order of the same length")
+    for size in block_shape:
+        if size <= 0 or size & (size - 1) != 0:
+            raise ValueError(f"Expected power-of-two block dimensions, got {block_shape}")
+    if sorted(order) != list(range(len(block_shape))):
+        raise ValueError(f"Expected the order to be a permutation of the dimensions, got {order}")
+    # treat bool* as tl.int8*
+    elt_ty = base.type.element_ty
+    if elt_ty == tl.int1:
+        elt_ty = tl.int8
+        base = cast(base, tl.pointer_type(elt_ty, base.type.address_space), builder)
+    handle = builder.create_make_block_ptr(base.handle,
+                                           _to_scalars(shape, tl.int64, "shape", builder),
+                                           _to_scalars(strides, tl.int64, "strides", builder),
+                                           _to_scalars(offsets, tl.int32, "offsets", builder),
+                                           block_shape, order)
+    return tl.tensor(handle, tl.pointer_type(tl.block_type(elt_ty, block_shape), base.type.address_space))
+
+
+def advance(base: tl.tensor, offsets, builder: ir.builder) -> tl.tensor:
+    if not _is_block_ptr(base):
+        raise ValueError(f"Expected a block pointer, got {base.type}")
+    if len(offsets) != len(base.type.element_ty.get_block_shapes()):
+        raise ValueError("Expected an offset per dimension of the block")
+    return tl.tensor(builder.create_advance(base.handle, _to_scalars(offsets, tl.int32, "offsets", builder)),
+                     base.type)
+
+
+def _load_block_ptr(ptr, mask, other, boundary_check, padding_option, cache, eviction, is_volatile, builder):
+    if mask or other:
+        raise ValueError("`mask` and `other` cannot be provided with block pointers, use `boundary_check`")
+    block_ty = ptr.type.element_ty
+    boundary_check = _canonicalize_boundary_check(boundary_check, block_ty.get_block_shapes())
+    padding = _str_to_padding_option(padding_option)
+    if padding == ir.PADDING_OPTION.PAD_NAN and not block_ty.element_ty.is_floating():
+        raise ValueError("Padding with NaN requires a floating-point block")
+    return tl.tensor(builder.create_tensor_ptr_load(ptr.handle, boundary_check, padding, cache, eviction, is_volatile),
+                     block_ty)
+
+
 def load(ptr: tl.tensor,
          mask: Optional[tl.tensor],
          other: Optional[tl.tensor],
          cache_modifier: str,
          eviction_policy: str,
          is_volatile: bool,
-         builder: ir.builder) -> tl.tensor:
+         builder: ir.builder,
+         l2_evict_last_fraction: Optional[float] = None,
+         boundary_check=(),
+         padding_option: str = "") -> tl.tensor:
+    if _is_block_ptr(ptr):
+        cache = _str_to_load_cache_modifier(cache_modifier)
+        eviction = _str_to_eviction_policy(eviction_policy)
+        return _load_block_ptr(ptr, mask, other, boundary_check, padding_option, cache, eviction, is_volatile, builder)
+    if boundary_check or padding_option:
+        raise ValueError("`boundary_check` and `padding_option` are only supported with block pointers")
     if not ptr.type.scalar.is_ptr():
         raise ValueError("Pointer argument of load instruction is " + ptr.type.__repr__())
+    if l2_evict_last_fraction is not None and not 0.0 < l2_evict_last_fraction <= 1.0:
+        raise ValueError(f"L2 evict_last fraction must be in (0, 1], got {l2_evict_last_fraction}")
     if ptr.type.is_block():
         if mask:
             mask = broadcast_impl_shape(mask, ptr.type.get_block_shapes(), builder)
@@ -773,25 +939,8 @@ def load(ptr: tl.tensor,
     if other:
         other = cast(other, elt_ty, builder)
 
-    # cache modifier
-    cache = ir.CACHE_MODIFIER.NONE  # default
-    if cache_modifier:
-        if cache_modifier == ".ca":
-            cache = ir.CACHE_MODIFIER.CA
-        elif cache_modifier == ".cg":
-            cache = ir.CACHE_MODIFIER.CG
-        else:
-            raise ValueError(f"Cache modifier {cache_modifier} not supported")
-
-    # eviction policy
-    eviction = ir.EVICTION_POLICY.NORMAL  # default
-    if eviction_policy:
-        if eviction_policy == "evict_last":
-            eviction = ir.EVICTION_POLICY.EVICT_LAST
-        elif eviction_policy == "evict_first":
-            eviction = ir.EVICTION_POLICY.EVICT_FIRST
-        else:
-            raise ValueError(f"Eviction policy {eviction_policy} not supported")
+    cache = _str_to_load_cache_modifier(cache_modifier)
+    eviction = _str_to_eviction_policy(eviction_policy)
 
     if ptr.type.is_block():
         shape = ptr.type.get_block_shapes()
@@ -802,20 +951,38 @@ def load(ptr: tl.tensor,
     if not mask:
         if other:
             raise ValueError("`other` cannot be provided without `mask`")
-        return tl.tensor(builder.create_load(ptr.handle, cache, eviction, is_volatile),
+        return tl.tensor(builder.create_load(ptr.handle, cache, eviction, is_volatile,
+                                             l2_evict_last_fraction),
                          dst_ty)
     else:
         return tl.tensor(builder.create_masked_load(ptr.handle,
                                                     mask.handle,
                                                     other.handle if other else None,
-                                                    cache, eviction, is_volatile),
+                                                    cache, eviction, is_volatile,
+                                                    l2_evict_last_fraction),
                          dst_ty)
 
 
 def store(ptr: tl.tensor,
           val: tl.tensor,
           mask: Optional[tl.tensor],
-          builder: ir.builder) -> tl.tensor:
+          cache_modifier: str,
+          eviction_policy: str,
+          builder: ir.builder,
+          boundary_check=()) -> tl.tensor:
+    if _is_block_ptr(ptr):
+        if mask:
+            raise ValueError("`mask` cannot be provided with block pointers, use `boundary_check`")
+        block_ty = ptr.type.element_ty
+        boundary_check = _canonicalize_boundary_check(boundary_check, block_ty.get_block_shapes())
+        val = broadcast_impl_shape(val, block_ty.get_block_shapes(), builder)
+        val = cast(val, block_ty.element_ty, builder)
+        cache = _str_to_store_cache_modifier(cache_modifier)
+        eviction = _str_to_eviction_policy(eviction_policy)
+        builder.create_tensor_ptr_store(ptr.handle, val.handle, boundary_check, cache, eviction)
+        return tl.tensor(None, tl.void)
+    if boundary_check:
+        raise ValueError("`boundary_check` is only supported with block pointers")
     if not ptr.type.scalar.is_ptr():
         raise ValueError("Pointer argument of store instruction is " + ptr.type.__repr__())
     if ptr.type.is_block():
@@ -830,27 +997,53 @@ def store(ptr: tl.tensor,
         ptr_ty = tl.pointer_type(elt_ty, ptr_ty.address_space)
         ptr = cast(ptr, ptr_ty, builder)
 
+    cache = _str_to_store_cache_modifier(cache_modifier)
+    eviction = _str_to_eviction_policy(eviction_policy)
+
     # cast to target data-type
     val = cast(val, elt_ty, builder)
     if not mask:
-        return tl.tensor(builder.create_store(ptr.handle, val.handle), tl.void)
+        return tl.tensor(builder.create_store(ptr.handle, val.handle, cache, eviction), tl.void)
     if not mask.type.scalar.is_bool():
         raise ValueError("Mask must have boolean scalar type")
-    return tl.tensor(builder.create_masked_store(ptr.handle, val.handle, mask.handle), tl.void)
+    return tl.tensor(builder.create_masked_store(ptr.handle, val.handle, mask.handle, cache, eviction), tl.void)
 
 #########
 # atomic
 #########
 
 
+def _str_to_sem(sem):
+    # no semantic keeps the default ordering of the atomics of the target
+    if sem is None:
+        return ''
+    if sem not in ('relaxed', 'acquire', 'release', 'acq_rel'):
+        raise ValueError(f"Memory semantic {sem} not supported")
+    return sem
+
+
+def _str_to_scope(scope):
+    # no scope keeps the default scope of the atomics of the target, the GPU
+    # on NVIDIA and the system on AMD
+    if scope is None:
+        return ''
+    if scope not in ('cta', 'gpu', 'sys'):
+        raise ValueError(f"Memory scope {scope} not supported")
+    return scope
+
+
 def atomic_cas(ptr: tl.tensor,
                cmp: tl.tensor,
                val: tl.tensor,
+               sem: str,
+               scope: str,
                builder: ir.builder) -> tl.tensor:
+    sem = _str_to_sem(sem)
+    scope = _str_to_scope(scope)
     element_ty = ptr.type.scalar.element_ty
     if element_ty.primitive_bitwidth not in [16, 32, 64]:
         raise ValueError("atomic_cas only supports elements with width {16, 32, 64}")
-    return tl.tensor(builder.create_atomic_cas(ptr.handle, cmp.handle, val.handle), val.type)
+    return tl.tensor(builder.create_atomic_cas(ptr.handle, cmp.handle, val.handle, sem, scope), val.type)
 
 
 def atom_red_typechecking_impl(ptr: tl.tensor,
@@ -885,8 +1078,12 @@ def atom_red_typechecking_impl(ptr: tl.tensor,
 def atomic_max(ptr: tl.tensor,
                val: tl.tensor,
                mask: tl.tensor,
+               sem: str,
+               scope: str,
                builder: ir.builder) -> tl.tensor:
     ptr, val, mask = atom_red_typechecking_impl(ptr, val, mask, 'max', builder)
+    sem = _str_to_sem(sem)
+    scope = _str_to_scope(scope)
     sca_ty = val.type.scalar
     # direct call to atomic_max for integers
     if sca_ty.is_int():
@@ -894,32 +1091,36 @@ def atomic_max(ptr: tl.tensor,
             return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.MAX,
                                                        ptr.handle,
                                                        val.handle,
-                                                       mask.handle),
+                                                       mask.handle, sem, scope),
                              val.type)
         else:
             return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.UMAX,
                                                        ptr.handle,
                                                        val.handle,
-                                                       mask.handle),
+                                                       mask.handle, sem, scope),
                              val.type)
     # ROCM TODO: implement atomic_max/min for f32 as they are supported by MI cards.
     # for float
     # return atomic_smax(i_ptr, i_val) if val >= 0
     # return atomic_umin(i_ptr, i_val) if val < 0
     i_val = bitcast(val, tl.int32, builder)
-    i_ptr = bitcast(ptr, tl.pointer_type(tl.int32, 1), builder)
+    i_ptr = bitcast(ptr, tl.pointer_type(tl.int32, ptr.type.scalar.address_space), builder)
     pos = greater_equal(val, tl.tensor(builder.get_fp32(0), sca_ty), builder)
     neg = less_than(val, tl.tensor(builder.get_fp32(0), sca_ty), builder)
-    pos_ret = tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.MAX, i_ptr.handle, i_val.handle, and_(mask, pos, builder).handle), i_val.type)
-    neg_ret = tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.UMIN, i_ptr.handle, i_val.handle, and_(mask, neg, builder).handle), i_val.type)
+    pos_ret = tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.MAX, i_ptr.handle, i_val.handle, and_(mask, pos, builder).handle, sem, scope), i_val.type)
+    neg_ret = tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.UMIN, i_ptr.handle, i_val.handle, and_(mask, neg, builder).handle, sem, scope), i_val.type)
     return where(pos, pos_ret, neg_ret, builder)
 
 
 def atomic_min(ptr: tl.tensor,
                val: tl.tensor,
                mask: tl.tensor,
+               sem: str,
+               scope: str,
                builder: ir.builder) -> tl.tensor:
     ptr, val, mask = atom_red_typechecking_impl(ptr, val, mask, 'min', builder)
+    sem = _str_to_sem(sem)
+    scope = _str_to_scope(scope)
     sca_ty = val.type.scalar
     # direct call to atomic_min for integers
     if sca_ty.is_int():
@@ -927,30 +1128,30 @@ def atomic_min(ptr: tl.tensor,
             return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.MIN,
                                                        ptr.handle,
                                                        val.handle,
-                                                       mask.handle),
+                                                       mask.handle, sem, scope),
                              val.type)
         else:
             return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.UMIN,
                                                        ptr.handle,
                                                        val.handle,
-                                                       mask.handle),
+                                                       mask.handle, sem, scope),
                              val.type)
     # for float
     # return atomic_smin(i_ptr, i_val) if val >= 0
     # return atomic_umax(i_ptr, i_val) if val < 0
     i_val = bitcast(val, tl.int32, builder)
-    i_ptr = bitcast(ptr, tl.pointer_type(tl.int32, 1), builder)
+    i_ptr = bitcast(ptr, tl.pointer_type(tl.int32, ptr.type.scalar.address_space), builder)
     pos = greater_equal(val, tl.tensor(builder.get_fp32(0), sca_ty), builder)
     neg = less_than(val, tl.tensor(builder.get_fp32(0), sca_ty), builder)
     pos_ret = tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.MIN,
                                                   i_ptr.handle,
                                                   i_val.handle,
-                                                  and_(mask, pos, builder).handle),
+                                                  and_(mask, pos, builder).handle, sem, scope),
                         i_val.type)
     neg_ret = tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.UMAX,
                                                   i_ptr.handle,
                                                   i_val.handle,
-                                                  and_(mask, neg, builder).handle),
+                                                  and_(mask, neg, builder).handle, sem, scope),
                         i_val.type)
     return where(pos, pos_ret, neg_ret, builder)
 
@@ -958,71 +1159,151 @@ def atomic_min(ptr: tl.tensor,
 def atomic_add(ptr: tl.tensor,
                val: tl.tensor,
                mask: tl.tensor,
+               aggregate: bool,
+               sem: str,
+               scope: str,
                builder: ir.builder) -> tl.tensor:
     ptr, val, mask = atom_red_typechecking_impl(ptr, val, mask, 'add', builder)
+    sem = _str_to_sem(sem)
+    scope = _str_to_scope(scope)
     sca_ty = val.type.scalar
     op = ir.ATOMIC_OP.FADD if sca_ty.is_floating() else ir.ATOMIC_OP.ADD
-    return tl.tensor(builder.create_atomic_rmw(op, ptr.handle, val.handle, mask.handle), val.type)
+    ret = builder.create_atomic_rmw(op, ptr.handle, val.handle, mask.handle, sem, scope)
+    if aggregate:
+        ret.set_attr("tt.aggregate", builder.get_bool_attr(True))
+    return tl.tensor(ret, val.type)
 
 
 def atomic_and(ptr: tl.tensor,
                val: tl.tensor,
                mask: tl.tensor,
+               sem: str,
+               scope: str,
                builder: ir.builder) -> tl.tensor:
     ptr, val, mask = atom_red_typechecking_impl(ptr, val, mask, 'and', builder)
-    return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.AND, ptr.handle, val.handle, mask.handle), val.type)
+    sem = _str_to_sem(sem)
+    scope = _str_to_scope(scope)
+    return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.AND, ptr.handle, val.handle, mask.handle, sem, scope), val.type)
 
 
 def atomic_or(ptr: tl.tensor,
               val: tl.tensor,
               mask: tl.tensor,
+              sem: str,
+              scope: str,
               builder: ir.builder) -> tl.tensor:
     ptr, val, mask = atom_red_typechecking_impl(ptr, val, mask, 'or', builder)
-    return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.OR, ptr.handle, val.handle, mask.handle), val.type)
+    sem = _str_to_sem(sem)
+    scope = _str_to_scope(scope)
+    return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.OR, ptr.handle, val.handle, mask.handle, sem, scope), val.type)
 
 
 def atomic_xor(ptr: tl.tensor,
                val: tl.tensor,
                mask: tl.tensor,
+               sem: str,
+               scope: str,
                builder: ir.builder) -> tl.tensor:
     ptr, val, mask = atom_red_typechecking_impl(ptr, val, mask, 'xor', builder)
-    return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.XOR, ptr.handle, val.handle, mask.handle), val.type)
+    sem = _str_to_sem(sem)
+    scope = _str_to_scope(scope)
+    return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.XOR, ptr.handle, val.handle, mask.handle, sem, scope), val.type)
 
 
 def atomic_xchg(ptr: tl.tensor,
                 val: tl.tensor,
                 mask: tl.tensor,
+                sem: str,
+                scope: str,
                 builder: ir.builder) -> tl.tensor:
     ptr, val, mask = atom_red_typechecking_impl(ptr, val, mask, 'xchg', builder)
-    return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.XCHG, ptr.handle, val.handle, mask.handle), val.type)
+    sem = _str_to_sem(sem)
+    scope = _str_to_scope(scope)
+    return tl.tensor(builder.create_atomic_rmw(ir.ATOMIC_OP.XCHG, ptr.handle, val.handle, mask.handle, sem, scope), val.type)
 
 # ===----------------------------------------------------------------------===//
 #                               Linear Algebra
 # ===----------------------------------------------------------------------===//
 
 
+def _fp8_format(ty: tl.dtype) -> str:
+    return {'fp8e4': 'e4m3', 'fp8e5': 'e5m2'}.get(ty.name, '')
+
+
 def dot(lhs: tl.tensor,
         rhs: tl.tensor,
         allow_tf32: bool,
-        builder: ir.builder) -> tl.tensor:
+        builder: ir.builder,
+        lhs_scale: tl.tensor = None,
+        rhs_scale: tl.tensor = None,
+        precision: str = None) -> tl.tensor:
     assert lhs.type.is_block() and rhs.type.is_block()
-    assert len(lhs.shape) == 2 and len(rhs.shape) == 2
-    assert lhs.shape[1].value == rhs.shape[0].value
-    assert lhs.shape[0].value >= 16 and lhs.shape[1].value >= 16 \
-        and rhs.shape[1].value >= 16,\
+    assert len(lhs.shape) == len(rhs.shape) and len(lhs.shape) in (2, 3), \
+        "dot operands must be both 2D, or both 3D with a leading batch dimension"
+    if len(lhs.shape) == 3:
+        assert lhs.shape[0].value == rhs.shape[0].value, "batch dimensions of dot operands differ"
+    assert lhs.shape[-1].value == rhs.shape[-2].value
+    assert lhs.shape[-2].value >= 16 and lhs.shape[-1].value >= 16 \
+        and rhs.shape[-1].value >= 16,\
         "small blocks not supported!"
-    if lhs.type.scalar.is_int():
+    if precision is None:
+        precision = ''
+    else:
+        assert precision in ('ieee', 'tf32', 'tf32x3'), f"unsupported dot precision {precision}"
+        allow_tf32 = precision != 'ieee'
+    # fp8 operands are passed to the dot as their bits, with their formats
+    lhs_format = _fp8_format(lhs.type.scalar)
+    rhs_format = _fp8_format(rhs.type.scalar)
+    if lhs_format and rhs_format:
+        lhs = bitcast(lhs, tl.int8, builder)
+        rhs = bitcast(rhs, tl.int8, builder)
+    elif lhs_format:
+        lhs = cast(lhs, rhs.type.scalar, builder)
+        lhs_format = ''
+    elif rhs_format:
+        rhs = cast(rhs, lhs.type.scalar, builder)
+        rhs_format = ''
+    if lhs.type.scalar.is_int() and not lhs_format:
         _0 = builder.get_int32(0)
         ret_scalar_ty = tl.int32
     else:
         _0 = builder.get_fp32(0)
         ret_scalar_ty = tl.float32
-    M = lhs.type.shape[0]
-    N = rhs.type.shape[1]
-    _0 = builder.create_splat(_0, [M, N])
-    ret_ty = tl.block_type(ret_scalar_ty, [M, N])
-    return tl.tensor(builder.create_dot(lhs.handle, rhs.handle, _0, allow_tf32),
-                     ret_ty)
+    ret_shape = lhs.type.shape[:-1] + [rhs.type.shape[-1]]
+    _0 = builder.create_splat(_0, ret_shape)
+    ret_ty = tl.block_type(ret_scalar_ty, ret_shape)
+    ret = tl.tensor(builder.create_dot(lhs.handle, rhs.handle, _0, allow_tf32,
+                                       lhs_format, rhs_format, precision),
+                    ret_ty)
+    # the scales of the operands factor out of the sum
+    for scale in (lhs_scale, rhs_scale):
+        if scale is None:
+            continue
+        assert ret_scalar_ty.is_fp32(), "scales are only supported by floating-point dots"
+        assert not scale.type.is_block(), "scales must be scalars"
+        ret = mul(ret, cast(scale, tl.float32, builder), builder)
+    return ret
+
+
+def sparse_dot(lhs: tl.tensor,
+               meta: tl.tensor,
+               rhs: tl.tensor,
+               builder: ir.builder) -> tl.tensor:
+    assert lhs.type.is_block() and meta.type.is_block() and rhs.type.is_block()
+    assert len(lhs.shape) == 2 and len(meta.shape) == 2 and len(rhs.shape) == 2, \
+        "sparse_dot operands must be 2D"
+    M, K = lhs.shape[0].value, 2 * lhs.shape[1].value
+    assert rhs.shape[0].value == K, "the compressed lhs of sparse_dot must hold half of the inner dimension"
+    assert meta.shape[0].value == M and meta.shape[1].value * 16 == K, \
+        "the metadata of sparse_dot must be of shape (M, K / 16)"
+    assert meta.type.scalar == tl.int16, "the metadata of sparse_dot must be int16"
+    assert lhs.type.scalar == rhs.type.scalar and (lhs.type.scalar.is_fp16() or lhs.type.scalar.is_bf16()), \
+        "sparse_dot only supports float16 and bfloat16 operands"
+    assert M >= 16 and K % 32 == 0 and rhs.shape[1].value >= 16, "small blocks not supported!"
+    ret_shape = [lhs.type.shape[0], rhs.type.shape[1]]
+    _0 = builder.create_splat(builder.get_fp32(0), ret_shape)
+    ret_ty = tl.block_type(tl.float32, ret_shape)
+    return tl.tensor(builder.create_sparse_dot(lhs.handle, meta.handle, rhs.handle, _0), ret_ty)
 
 
 # ===----------------------------------------------------------------------===//
@@ -1102,6 +1383,89 @@ def reduce_impl(input: tl.tensor, axis: int, builder: ir.builder, name: str,
     assert False
 
 
+def generic_reduce(inputs: Tuple[tl.tensor, ...], axis: int, region_builder_fn,
+                   builder: ir.builder) -> Tuple[tl.tensor, ...]:
+    shape = inputs[0].type.shape
+    for t in inputs:
+        if t.type.shape != shape:
+            raise ValueError("all the tensors of a reduction must have the same shape")
+    ret_shape = [s for i, s in enumerate(shape) if i != axis]
+
+    def wrap_tensor(x, scalar_ty):
+        if ret_shape:
+            res_ty = tl.block_type(scalar_ty, ret_shape)
+        else:
+            # 0d-tensor -> scalar
+            res_ty = scalar_ty
+        return tl.tensor(x, res_ty)
+
+    reduce_op = builder.create_generic_reduce([t.handle for t in inputs], axis)
+    region_builder_fn(reduce_op)
+    return tuple(wrap_tensor(reduce_op.get_result(i), t.type.scalar)
+                 for i, t in enumerate(inputs))
+
+
+def associative_scan(inputs: Tuple[tl.tensor, ...], axis: int, reverse: bool,
+                     region_builder_fn, builder: ir.builder) -> Tuple[tl.tensor, ...]:
+    shape = inputs[0].type.shape
+    for t in inputs:
+        if t.type.shape != shape:
+            raise ValueError("all the tensors of a scan must have the same shape")
+    scan_op = builder.create_scan([t.handle for t in inputs], axis, reverse)
+    region_builder_fn(scan_op)
+    return tuple(tl.tensor(scan_op.get_result(i), t.type)
+                 for i, t in enumerate(inputs))
+
+
+def sort_impl(inputs: Tuple[tl.tensor, ...], axis: int, descending: bool, k: int,
+              builder: ir.builder) -> Tuple[tl.tensor, ...]:
+    # inputs[0] holds the keys, the other tensors are permuted with them
+    shape = list(inputs[0].type.shape)
+    for t in inputs:
+        if not t.type.is_block() or t.type.shape != shape:
+            raise ValueError("all the tensors of a sort must be blocks of the same shape")
+    if axis is None:
+        axis = len(shape) - 1
+    if axis < 0:
+        axis += len(shape)
+    if axis < 0 or axis >= len(shape):
+        raise ValueError(f"sort axis {axis} out of range for a tensor of rank {len(shape)}")
+    size = shape[axis]
+    if size & (size - 1) != 0:
+        raise ValueError(f"the size of the sort axis must be a power of 2, got {size}")
+    key_ty = inputs[0].type.scalar
+    if not (key_ty.is_floating() or key_ty.is_int_signed()):
+        raise ValueError(f"sort keys must be floats or signed integers, got {key_ty}")
+    if k:
+        if k & (k - 1) != 0 or k > size:
+            raise ValueError(f"k must be a power of 2 no larger than {size}, got {k}")
+        shape[axis] = k
+    sort_op = builder.create_sort([t.handle for t in inputs], axis, descending, k)
+    return tuple(tl.tensor(sort_op.get_result(i), tl.block_type(t.type.scalar, shape))
+                 for i, t in enumerate(inputs))
+
+
+def sort(input: tl.tensor, axis: int, descending: bool, builder: ir.builder) -> tl.tensor:
+    return sort_impl((input,), axis, descending, 0, builder)[0]
+
+
+def topk(input: tl.tensor, k: int, axis: int, builder: ir.builder) -> Tuple[tl.tensor, tl.tensor]:
+    if not input.type.is_block():
+        raise ValueError("topk needs a block")
+    shape = input.type.shape
+    if axis is None:
+        axis = len(shape) - 1
+    if axis < 0:
+        axis += len(shape)
+    # positions along the axis, sorted with the values
+    index = arange(0, shape[axis], builder)
+    for d in range(len(shape)):
+        if d != axis:
+            index = expand_dims(index, d, builder)
+    index = broadcast_impl_shape(index, shape, builder)
+    return sort_impl((input, index), axis, True, k, builder)
+
+
 def min(input: tl.tensor, axis: int, builder: ir.builder) -> tl.tensor:
     return reduce_impl(input, axis, builder, "min", ir.REDUCE_OP.FMIN, ir.REDUCE_OP.MIN)
 
@@ -1140,6 +1504,24 @@ def umulhi(x: tl.tensor, y: tl.tensor, builder: ir.builder) -> tl.tensor:
     return libdevice.mulhi(x, y, _builder=builder)
 
 
+def philox(c0: tl.tensor, c1: tl.tensor, c2: tl.tensor, c3: tl.tensor,
+           k0: tl.tensor, k1: tl.tensor, n_rounds: int,
+           builder: ir.builder) -> Tuple[tl.tensor, tl.tensor, tl.tensor, tl.tensor]:
+    if n_rounds <= 0:
+        raise ValueError(f"philox expects a positive number of rounds, got {n_rounds}")
+    args = [c0, c1, c2, c3, k0, k1]
+    for arg in args:
+        if arg.type.scalar != tl.uint32:
+            raise ValueError(f"philox expects uint32 counters and keys, got {arg.type.scalar}")
+    # broadcast the counters and the keys to a common shape
+    for i in range(1, len(args)):
+        args[0], args[i] = broadcast_impl_value(args[0], args[i], builder)
+    args = [broadcast_impl_value(args[0], arg, builder)[1] for arg in args]
+    ret_ty = args[0].type
+    outs = builder.create_philox(*[arg.handle for arg in args], n_rounds)
+    return tuple(tl.tensor(out, ret_ty) for out in outs)
+
+
 def floor(x: tl.tensor, builder: ir.builder) -> tl.tensor:
     # FIXME(Keren): not portable, should be fixed
     from . import libdevice
@@ -1186,6 +1568,18 @@ def debug_barrier(builder: ir.builder) -> tl.tensor:
     return tl.tensor(builder.create_barrier(), tl.void)
 
 
+def grid_barrier(builder: ir.builder) -> tl.tensor:
+    return tl.tensor(builder.create_grid_barrier(), tl.void)
+
+
+def profile_region(name: str, builder: ir.builder) -> tl.tensor:
+    return tl.tensor(builder.create_profile_region(name), tl.void)
+
+
+def trace(prefix: str, args: List[tl.tensor], builder: ir.builder) -> tl.tensor:
+    return tl.tensor(builder.create_trace(prefix, [arg.handle for arg in args]), tl.void)
+
+
 def printf(prefix: str, args: List[tl.tensor], builder: ir.builder) -> tl.tensor:
     new_args = []
     for arg in args:
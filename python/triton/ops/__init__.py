@@ -1,14 +1,33 @@
 # from .conv import _conv, conv
 from . import blocksparse
-from .cross_entropy import _cross_entropy, cross_entropy
-from .flash_attention import attention
+from .comm import SymmetricHeap, all_gather_matmul, matmul_reduce_scatter
+from .cross_entropy import _cross_entropy, cross_entropy, linear_cross_entropy
+from .flash_attention import attention, decode_attention, varlen_attention
+from .grouped_matmul import _grouped_matmul, grouped_matmul
 from .matmul import _matmul, matmul
+from .paged_attention import paged_attention
+from .scan import compact, cumsum
+from .sparse_matmul import compress_2to4, decompress_2to4, sparse_matmul
 
 __all__ = [
     "blocksparse",
     "_cross_entropy",
     "cross_entropy",
+    "linear_cross_entropy",
     "_matmul",
     "matmul",
+    "_grouped_matmul",
+    "grouped_matmul",
     "attention",
+    "decode_attention",
+    "varlen_attention",
+    "paged_attention",
+    "cumsum",
+    "compact",
+    "compress_2to4",
+    "decompress_2to4",
+    "sparse_matmul",
+    "SymmetricHeap",
+    "all_gather_matmul",
+    "matmul_reduce_scatter",
 ]
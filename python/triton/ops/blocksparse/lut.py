@@ -0,0 +1,178 @@
+import collections
+import hashlib
+
+import torch
+
+import triton
+import triton.language as tl
+
+# ********************************************************
+# --------------------------------------------------------
+# Look-up tables
+# The look-up tables of the block-sparse ops are built on
+# the device from the layout, and cached by the contents
+# of the layout: ops sharing a layout (e.g., the matmuls
+# and softmax of sparse attention) build them only once
+# --------------------------------------------------------
+# ********************************************************
+
+
+class LutCache:
+    """
+    Look-up tables keyed by the builder, the hash of the contents of the
+    layout and the other arguments of the builder. At most `max_size` of them
+    are kept, the least recently used being evicted first, so that layouts
+    changing dynamically do not hold on to device memory.
+    """
+
+    def __init__(self, max_size=64):
+        self.max_size = max_size
+        self.luts = collections.OrderedDict()
+
+    @staticmethod
+    def layout_key(layout):
+        data = layout.detach().to(torch.int8).cpu().numpy().tobytes()
+        return tuple(layout.shape), hashlib.sha1(data).hexdigest()
+
+    def get(self, builder, layout, *args, layout_key=None):
+        if layout_key is None:
+            layout_key = self.layout_key(layout)
+        key = (builder.__name__, layout_key) + args
+        if key in self.luts:
+            self.luts.move_to_end(key)
+            return self.luts[key]
+        lut = builder(layout, *args)
+        self.luts[key] = lut
+        if len(self.luts) > self.max_size:
+            self.luts.popitem(last=False)
+        return lut
+
+    def clear(self):
+        self.luts.clear()
+
+
+lut_cache = LutCache()
+
+
+@triton.jit
+def _dsd_lut_kernel(
+    LUT, A_idx, B_idx, Is_first,
+    num_blocks, header_size,
+    BLOCK: tl.constexpr, STEP: tl.constexpr, DIV: tl.constexpr,
+    TRANS: tl.constexpr, TILE: tl.constexpr,
+):
+    # increments of the pointers to B (dense) and A (sparse) for each step of
+    # the blocks, of which the first one is an offset for the first block of
+    # a reduction
+    offs = tl.program_id(0) * TILE + tl.arange(0, TILE)
+    mask = offs < num_blocks
+    a_idx = tl.load(A_idx + offs, mask=mask, other=0)
+    b_idx = tl.load(B_idx + offs, mask=mask, other=0) * BLOCK
+    has_prev = mask & (offs > 0)
+    a_prev = tl.load(A_idx + offs - 1, mask=has_prev, other=0)
+    b_prev = tl.load(B_idx + offs - 1, mask=has_prev, other=0) * BLOCK
+    is_first = tl.load(Is_first + offs, mask=mask, other=0) != 0
+    if TRANS:
+        a_step = STEP
+    else:
+        a_step = STEP * BLOCK
+    b_inc = tl.where(is_first, b_idx, b_idx - b_prev - (DIV - 1) * STEP)
+    a_inc = tl.where(is_first, a_idx, (a_idx - a_prev) * BLOCK * BLOCK - (DIV - 1) * a_step)
+    incs = LUT + header_size + offs * DIV * 2
+    tl.store(incs, b_inc, mask=mask)
+    tl.store(incs + 1, a_inc, mask=mask)
+    b_inc = tl.zeros([TILE], dtype=tl.int32) + STEP
+    a_inc = tl.zeros([TILE], dtype=tl.int32) + a_step
+    for d in range(1, DIV):
+        tl.store(incs + d * 2, b_inc, mask=mask)
+        tl.store(incs + d * 2 + 1, a_inc, mask=mask)
+
+
+def sdd_lut(layout, block, device):
+    lut = layout.to(device).nonzero(as_tuple=False).int()
+    lut = lut.contiguous()
+    return lut, None
+
+
+def dsd_lut(layout, block, step, trans, device):
+    """
+    Generates the look-up table for incrementing pointers in the DSD/DDS matmul.
+    Example (BLOCK=32, STEP=16)
+    [[1, 0, 0, 1, 0],
+     [0, 1, 1, 0, 1],
+     [1, 0, 1, 0, 0]]
+
+    Then the offsets for A are
+     [0 , 16, 32, 48] <- row 0
+      \\----/  \\----/
+      col=0   col=3
+     [64, 80, 96, 112, 128, 144] <- row 1
+      \\----/   \\----/  \\------/
+       col=1    col=2    col=3
+     [160, 176, 192, 208]
+    which leads to increments table
+    [0, 16, 16, 16, || 64, 16, 16, 16, 16, 16, || 160, 16, 16, 16]
+
+    Because B is dense, the offsets are
+    [0, 16, 96, 112] <- row 0
+    [32, 48, 64, 80]  <- row 1
+    [0, 16, 64, 80]   <- row 2
+    """
+    layout = layout.to(device).long()
+    sizes = torch.sum(layout, 2 if trans else 1)
+    head_id, col_id = torch.ones_like(sizes).nonzero(as_tuple=True)
+    sizes = sizes.flatten()
+    segments = sizes * step
+    # blocks of the reductions, in order
+    if trans:
+        nnz = layout.nonzero(as_tuple=False)
+    else:
+        nnz = layout.transpose(1, 2).nonzero(as_tuple=False)
+    num_blocks = nnz.size(0)
+    offsets = torch.zeros_like(sizes)
+    offsets[1:] = torch.cumsum(sizes[:-1], dim=0)
+    offsets = torch.clamp(offsets, max=num_blocks - 1)
+    # indices of the blocks in the dense input (B), and in the sparse memory
+    # layout (A), where they are stored in row-major order
+    B_idx = nnz[:, 2]
+    if trans:
+        A_idx = torch.arange(num_blocks, device=layout.device)
+    else:
+        rank = torch.cumsum(layout.flatten(), dim=0).view(layout.shape) - 1
+        A_idx = rank.transpose(1, 2)[layout.transpose(1, 2) > 0]
+    is_first = torch.zeros(num_blocks, dtype=torch.int32, device=layout.device)
+    is_first[offsets[segments > 0]] = 1
+    # create header
+    # Note that the inner loop matmul kernel may have a fixed step size (e.g., TILE_K)
+    # that is smaller than the block size, so each block takes `div` increments
+    div = block // step
+    width = col_id.size(0)
+    offsets = offsets * 2 * div + 4 * width
+    segments = segments * div
+    header = torch.stack((offsets, segments, col_id, head_id), dim=1).view(-1)
+    # create lut, padded by a factor 2*MAX_NUM_STAGES
+    # to accommodate pre-fetching inside the kernel
+    lut = torch.zeros(header.numel() + 2 * div * num_blocks + 20, dtype=torch.int32, device=layout.device)
+    lut[:header.numel()] = header
+    TILE = 128
+    _dsd_lut_kernel[(triton.cdiv(num_blocks, TILE),)](
+        lut, A_idx.int().contiguous(), B_idx.int().contiguous(), is_first,
+        num_blocks, header.numel(),
+        BLOCK=block, STEP=step, DIV=div, TRANS=trans, TILE=TILE,
+    )
+    return lut, width
+
+
+def softmax_lut(layout, block, device):
+    layout = layout.to(device).long()
+    # sizes along rows
+    sizes = layout.sum(-1).flatten()
+    total_sizes = sizes * block
+    # offsets in block format
+    offsets = torch.zeros_like(sizes)
+    offsets[1:] = torch.cumsum(sizes[:-1], dim=0)
+    # block indices
+    columns = layout.nonzero(as_tuple=False)[:, 2]
+    header = torch.stack((sizes, offsets), dim=1).view(-1)
+    lut = torch.cat((header, columns)).type(torch.int32)
+    return lut, int(total_sizes.max())
@@ -3,6 +3,8 @@ import torch
 import triton
 import triton.language as tl
 
+from .lut import lut_cache, softmax_lut
+
 
 def num_warps(n):
     if n <= 128:
@@ -132,23 +134,6 @@ def _blocksparse_softmax_bwd(
 
 
 class _softmax(torch.autograd.Function):
-    @staticmethod
-    def make_lut(layout, block, device):
-        _empty = torch.tensor([], dtype=torch.int64, device=layout.device)
-        sizes = _empty.clone()
-        # sizes along rows
-        for h in range(layout.shape[0]):
-            sizes = torch.cat((sizes, layout[h, :, :].sum(-1)))
-        total_sizes = sizes * block
-        # offsets in block format
-        offsets = torch.zeros_like(sizes)
-        offsets[1:] = torch.cumsum(sizes[:-1], dim=0)
-        # block indices
-        columns = layout.nonzero(as_tuple=False)[:, 2]
-        header = torch.stack((sizes, offsets), dim=1).view(-1)
-        lut = torch.cat((header, columns)).type(torch.int32).to(device)
-        return lut, int(total_sizes.max())
-
     @staticmethod
     def forward(
         ctx, a, scale, rel_logits, is_causal,
@@ -226,7 +211,7 @@ class softmax:
         self.spdims = layout.shape
         self.layout = layout
         self.block = block
-        self.lut, self.maxlut = _softmax.make_lut(self.layout, self.block, device)
+        self.lut, self.maxlut = lut_cache.get(softmax_lut, self.layout, self.block, device)
         self.is_dense = is_dense
 
     def __call__(self, a, *, scale=1.0, rel_logits=None, is_causal=False):
@@ -0,0 +1,297 @@
+"""
+Overlapped Communication
+========================
+Matmuls fused with the collectives of tensor-parallel layers, for the GPUs of
+a process that have peer access to each other's memory, through NVLink or
+xGMI.
+
+Each GPU owns a buffer of a `SymmetricHeap`, and the heap places a tensor at
+the same offset of all the buffers, so that the copy of a tensor on another
+GPU is found by offsetting a pointer by the distance between their buffers.
+The kernels load the tiles of the other GPUs, or add theirs into them, while
+they compute, so that the transfers overlap with the math tile by tile rather
+than running as a separate collective before or after the matmul.
+
+The GPUs order their transfers with flags of the heap, which only grow: a
+flag is raised by a release atomic of system scope, and waited for by acquire
+atomics of system scope until it reaches a value. The kernels of a collective
+run on the current stream of each GPU, and raise their flags before their
+matmuls wait for those of the other GPUs, so that no stream waits for one
+that waits for it.
+"""
+
+import torch
+
+import triton
+import triton.language as tl
+from ..compiler import get_graph_utils
+
+# alignment of the tensors of a heap, in bytes
+_ALIGNMENT = 256
+
+
+class SymmetricHeap:
+    """
+    Buffers of `size` bytes on each of `devices`, all the GPUs by default, in
+    which every tensor is allocated at the same offset. Each device is given
+    access to the memory of the others.
+    """
+
+    def __init__(self, size, devices=None):
+        if devices is None:
+            devices = range(torch.cuda.device_count())
+        self.devices = list(devices)
+        self.size = size
+        utils = get_graph_utils()
+        for device in self.devices:
+            for peer in self.devices:
+                if device != peer and not utils.enable_peer_access(device, peer):
+                    raise RuntimeError(f"device {device} cannot access the memory of device {peer}")
+        self.buffers = [torch.empty(size, dtype=torch.uint8, device=f'cuda:{device}') for device in self.devices]
+        # the bases of all the buffers, on each device
+        bases = [buffer.data_ptr() for buffer in self.buffers]
+        self.bases = [torch.tensor(bases, dtype=torch.int64, device=f'cuda:{device}') for device in self.devices]
+        self.offset = 0
+        # flags raised by each device with the epoch of the last collective,
+        # and counters of the tiles added to the outputs of each device
+        self.ready = self.zeros((self.world_size,), torch.int32)
+        self.done = self.zeros((1,), torch.int32)
+        self.epoch = 0
+        self.done_target = 0
+
+    @property
+    def world_size(self):
+        return len(self.devices)
+
+    def empty(self, shape, dtype):
+        """
+        Returns the copies of a tensor of `shape` and `dtype`, one per device.
+        """
+        shape = tuple(shape)
+        numel = 1
+        for dim in shape:
+            numel *= dim
+        nbytes = numel * torch.tensor([], dtype=dtype).element_size()
+        offset = triton.cdiv(self.offset, _ALIGNMENT) * _ALIGNMENT
+        if offset + nbytes > self.size:
+            raise RuntimeError(f"symmetric heap of {self.size} bytes exhausted")
+        self.offset = offset + nbytes
+        return [buffer[offset:offset + nbytes].view(dtype).view(shape) for buffer in self.buffers]
+
+    def zeros(self, shape, dtype):
+        tensors = self.empty(shape, dtype)
+        for tensor in tensors:
+            tensor.zero_()
+        return tensors
+
+    def synchronize(self):
+        """
+        Waits for the work queued on the current streams of all the devices.
+        """
+        for device in self.devices:
+            torch.cuda.synchronize(device)
+
+
+@triton.jit
+def remote_ptr(ptr, Bases, rank, peer):
+    # the pointer to the copy on the GPU `peer` of the data at `ptr` on the
+    # GPU `rank`, both in the heap of `Bases`
+    delta = tl.load(Bases + peer) - tl.load(Bases + rank)
+    return ptr + delta // (ptr.dtype.element_ty.primitive_bitwidth // 8)
+
+
+@triton.jit
+def signal(Flag, value):
+    # raises the flag to value once the writes of the program before it are
+    # visible to all the GPUs
+    tl.debug_barrier()
+    tl.atomic_xchg(Flag, value, sem='release', scope='sys')
+
+
+@triton.jit
+def signal_add(Counter, value):
+    # adds value to the counter once the writes of the program before it are
+    # visible to all the GPUs
+    tl.debug_barrier()
+    tl.atomic_add(Counter, value, sem='release', scope='sys')
+
+
+@triton.jit
+def wait(Flag, value):
+    # waits until the flag reaches value, after which the writes that came
+    # before its signal are visible to the program
+    seen = tl.atomic_add(Flag, 0, sem='acquire', scope='sys')
+    while seen < value:
+        seen = tl.atomic_add(Flag, 0, sem='acquire', scope='sys')
+    tl.debug_barrier()
+
+
+@triton.jit
+def _signal_kernel(Ready, Bases, rank, epoch, WORLD: tl.constexpr):
+    # raises the flag of the GPU rank on all the GPUs
+    for peer in range(WORLD):
+        signal(remote_ptr(Ready + rank, Bases, rank, peer), epoch)
+
+
+@triton.jit
+def _wait_kernel(Flag, value):
+    wait(Flag, value)
+
+
+@triton.jit
+def _tile_matmul(A, B, rm, rn, M, N, K, stride_am, stride_ak, stride_bk, stride_bn,
+                 BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr):
+    acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=tl.float32)
+    for k in range(0, K, BLOCK_K):
+        rk = k + tl.arange(0, BLOCK_K)
+        a = tl.load(A + rm[:, None] * stride_am + rk[None, :] * stride_ak,
+                    mask=(rm[:, None] < M) & (rk[None, :] < K), other=0.)
+        b = tl.load(B + rk[:, None] * stride_bk + rn[None, :] * stride_bn,
+                    mask=(rk[:, None] < K) & (rn[None, :] < N), other=0.)
+        acc += tl.dot(a, b)
+    return acc
+
+
+@triton.jit
+def _all_gather_matmul_kernel(A, B, C, Bases, Ready, Done, rank, epoch, M, N, K,
+                              stride_am, stride_ak, stride_bk, stride_bn, stride_cm, stride_cn,
+                              WORLD: tl.constexpr, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr,
+                              BLOCK_K: tl.constexpr):
+    # A is the shard of M rows of the GPU. The programs start with the tiles
+    # of the local shard, and then load those of the next GPUs, so that the
+    # first remote loads are issued while the local tiles are computed.
+    pid = tl.program_id(0)
+    tiles_n = tl.cdiv(N, BLOCK_N)
+    tiles = tl.cdiv(M, BLOCK_M) * tiles_n
+    owner = (rank + pid // tiles) % WORLD
+    tile = pid % tiles
+    rm = (tile // tiles_n) * BLOCK_M + tl.arange(0, BLOCK_M)
+    rn = (tile % tiles_n) * BLOCK_N + tl.arange(0, BLOCK_N)
+    if owner != rank:
+        wait(Ready + owner, epoch)
+    A_owner = remote_ptr(A, Bases, rank, owner)
+    acc = _tile_matmul(A_owner, B, rm, rn, M, N, K, stride_am, stride_ak, stride_bk, stride_bn,
+                       BLOCK_M, BLOCK_N, BLOCK_K)
+    c = acc.to(C.dtype.element_ty)
+    rows = owner * M + rm
+    tl.store(C + rows[:, None] * stride_cm + rn[None, :] * stride_cn, c,
+             mask=(rm[:, None] < M) & (rn[None, :] < N))
+    # the owner may overwrite its shard once all the tiles are loaded
+    signal_add(remote_ptr(Done, Bases, rank, owner), 1)
+
+
+@triton.jit
+def _matmul_reduce_scatter_kernel(A, B, C, Bases, Ready, Done, rank, epoch, M, N, K,
+                                  stride_am, stride_ak, stride_bk, stride_bn, stride_cm, stride_cn,
+                                  WORLD: tl.constexpr, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr,
+                                  BLOCK_K: tl.constexpr):
+    # C is the slice of M rows of the output owned by each GPU, and the
+    # partial products of all the GPUs are added into it. The programs start
+    # with the slice of the next GPU and end with the local one.
+    pid = tl.program_id(0)
+    tiles_n = tl.cdiv(N, BLOCK_N)
+    tiles = tl.cdiv(M, BLOCK_M) * tiles_n
+    owner = (rank + 1 + pid // tiles) % WORLD
+    tile = pid % tiles
+    rm = (tile // tiles_n) * BLOCK_M + tl.arange(0, BLOCK_M)
+    rn = (tile % tiles_n) * BLOCK_N + tl.arange(0, BLOCK_N)
+    acc = _tile_matmul(A + owner * M * stride_am, B, rm, rn, M, N, K,
+                       stride_am, stride_ak, stride_bk, stride_bn, BLOCK_M, BLOCK_N, BLOCK_K)
+    # the output of the owner is zeroed before it raises its flag
+    wait(Ready + owner, epoch)
+    C_owner = remote_ptr(C, Bases, rank, owner)
+    tl.atomic_add(C_owner + rm[:, None] * stride_cm + rn[None, :] * stride_cn, acc,
+                  mask=(rm[:, None] < M) & (rn[None, :] < N), scope='sys')
+    signal_add(remote_ptr(Done, Bases, rank, owner), 1)
+
+
+def _check_shards(heap, tensors, name):
+    if len(tensors) != heap.world_size:
+        raise ValueError(f"expected one {name} per device of the heap")
+    for tensor, device in zip(tensors, heap.devices):
+        if tensor.device != torch.device('cuda', device):
+            raise ValueError(f"{name} is not on device {device}")
+
+
+def _raise_ready(heap):
+    heap.epoch += 1
+    for rank, device in enumerate(heap.devices):
+        with torch.cuda.device(device):
+            _signal_kernel[(1,)](heap.ready[rank], heap.bases[rank], rank, heap.epoch, WORLD=heap.world_size)
+
+
+def _wait_done(heap):
+    # every device receives the same number of tiles from each collective
+    for rank, device in enumerate(heap.devices):
+        with torch.cuda.device(device):
+            _wait_kernel[(1,)](heap.done[rank], heap.done_target)
+
+
+def all_gather_matmul(heap, a, b, block_m=64, block_n=64, block_k=32, num_warps=4):
+    """
+    Returns, on each device of `heap`, the product of the concatenation of the
+    shards of rows `a`, tensors of the heap, with `b`, the same on all the
+    devices. The shards are gathered by the matmul itself, and the later
+    work of the stream of each device may overwrite its shard.
+    """
+    _check_shards(heap, a, "shard of a")
+    _check_shards(heap, b, "b")
+    M, K = a[0].shape
+    N = b[0].shape[1]
+    world = heap.world_size
+    # the shards must be complete before the other devices load them
+    _raise_ready(heap)
+    tiles = triton.cdiv(M, block_m) * triton.cdiv(N, block_n)
+    heap.done_target += world * tiles
+    outputs = []
+    for rank, device in enumerate(heap.devices):
+        with torch.cuda.device(device):
+            c = torch.empty((world * M, N), device=a[rank].device, dtype=a[rank].dtype)
+            _all_gather_matmul_kernel[(world * tiles,)](
+                a[rank], b[rank], c, heap.bases[rank], heap.ready[rank], heap.done[rank],
+                rank, heap.epoch, M, N, K,
+                a[rank].stride(0), a[rank].stride(1), b[rank].stride(0), b[rank].stride(1),
+                c.stride(0), c.stride(1),
+                WORLD=world, BLOCK_M=block_m, BLOCK_N=block_n, BLOCK_K=block_k, num_warps=num_warps)
+            outputs.append(c)
+    _wait_done(heap)
+    return outputs
+
+
+def matmul_reduce_scatter(heap, a, b, out=None, block_m=64, block_n=64, block_k=32, num_warps=4):
+    """
+    Returns, on each device of `heap`, its slice of rows of the sum over the
+    devices of the products of `a` and `b`, e.g. the shards along K of a row
+    parallel layer. The slices are fp32 tensors of the heap, `out` if given,
+    and the partial products are added into them by the matmuls of all the
+    devices. The heap does not free its tensors, so that `out` should be
+    reused by repeated calls.
+    """
+    _check_shards(heap, a, "a")
+    _check_shards(heap, b, "b")
+    M, K = a[0].shape
+    N = b[0].shape[1]
+    world = heap.world_size
+    if M % world:
+        raise ValueError(f"{M} rows cannot be scattered to {world} devices")
+    M_shard = M // world
+    c = heap.empty((M_shard, N), torch.float32) if out is None else out
+    _check_shards(heap, c, "slice of the output")
+    for tensor, device in zip(c, heap.devices):
+        with torch.cuda.device(device):
+            tensor.zero_()
+    _raise_ready(heap)
+    tiles = triton.cdiv(M_shard, block_m) * triton.cdiv(N, block_n)
+    # each device receives every tile of its slice from every device
+    heap.done_target += world * tiles
+    for rank, device in enumerate(heap.devices):
+        with torch.cuda.device(device):
+            _matmul_reduce_scatter_kernel[(world * tiles,)](
+                a[rank], b[rank], c[rank], heap.bases[rank], heap.ready[rank], heap.done[rank],
+                rank, heap.epoch, M_shard, N, K,
+                a[rank].stride(0), a[rank].stride(1), b[rank].stride(0), b[rank].stride(1),
+                c[rank].stride(0), c[rank].stride(1),
+                WORLD=world, BLOCK_M=block_m, BLOCK_N=block_n, BLOCK_K=block_k, num_warps=num_warps)
+    # the later work of each stream sees the complete slice
+    _wait_done(heap)
+    return c
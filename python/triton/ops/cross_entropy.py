@@ -1,3 +1,20 @@
+"""
+Cross Entropy
+=============
+The softmax of a row is computed online, a chunk of `BLOCK` columns at a
+time, so that vocabularies of any size fit in registers. Only the logsumexp
+of the rows is kept for the backward pass, which recomputes the probabilities
+from the logits instead of reading back a full `PROBS` tensor.
+
+With label smoothing `eps`, the target distribution puts `1 - eps` on the
+target and spreads `eps` evenly over the vocabulary. The rows whose target is
+`ignore_index` have no loss and no gradient.
+
+`linear_cross_entropy` fuses the GEMM producing the logits: the forward pass
+never materializes them, and the backward pass recomputes them a chunk of the
+vocabulary at a time.
+"""
+
 import torch
 
 import triton
@@ -23,83 +40,237 @@ def num_warps(N):
     return 16
 
 
-@triton.heuristics({'num_warps': lambda nargs: num_warps(nargs['N'])})
-@triton.heuristics({'BLOCK': lambda nargs: next_power_of_2(nargs['N'])})
+# columns of a row processed at once; larger rows are processed in chunks
+MAX_BLOCK = 4096
+
+_heuristics = {
+    'BLOCK': lambda nargs: min(next_power_of_2(nargs['N']), MAX_BLOCK),
+    'HAS_SMOOTHING': lambda nargs: nargs['smoothing'] > 0.,
+}
+
+
+@triton.heuristics(_heuristics)
+@triton.heuristics({'num_warps': lambda nargs: num_warps(nargs['BLOCK'])})
 @triton.jit
-def _forward(LOGITS, PROBS, IDX, LOSS, N, BLOCK: tl.constexpr):
+def _forward(LOGITS, IDX, LOSS, LSE, stride, N, smoothing, ignore_index,
+             HAS_SMOOTHING: tl.constexpr, BLOCK: tl.constexpr):
     row = tl.program_id(0)
-    cols = tl.arange(0, BLOCK)
+    LOGITS = LOGITS + row * stride
     idx = tl.load(IDX + row)
-    # pointers to logit and probs
-    LOGITS = LOGITS + row * N + cols
-    WRIT_PROBS = PROBS + row * N + cols
-    READ_PROBS = PROBS + row * N + idx
-    # write-back negative log-probs
-    logits = tl.load(LOGITS, mask=cols < N, other=-float('inf'))
-    logits = logits.to(tl.float32)
-    logits = logits - tl.max(logits, 0)
-    probs = tl.log(tl.sum(tl.exp(logits), 0)) - logits
-    tl.store(WRIT_PROBS, probs, mask=cols < N)
-    # There is a bug in the compiler, which fails to insert a barrier here.
-    # We add it explicitly for now. Will be fixed soon.
-    tl.debug_barrier()
-    # write-back loss
-    probs = tl.load(READ_PROBS)
-    tl.store(LOSS + row, probs)
-
-
-@triton.heuristics({'num_warps': lambda nargs: num_warps(nargs['N'])})
-@triton.heuristics({'BLOCK': lambda nargs: next_power_of_2(nargs['N'])})
+    # running max and sum of the exponentials, per lane
+    m = tl.zeros([BLOCK], dtype=tl.float32) - float('inf')
+    l = tl.zeros([BLOCK], dtype=tl.float32)
+    sum_logits = tl.zeros([BLOCK], dtype=tl.float32)
+    for start in range(0, N, BLOCK):
+        cols = start + tl.arange(0, BLOCK)
+        logits = tl.load(LOGITS + cols, mask=cols < N, other=-float('inf'))
+        logits = logits.to(tl.float32)
+        m_new = tl.maximum(m, logits)
+        # lanes that have seen no column yet stay empty
+        is_empty = m_new == -float('inf')
+        l = l * tl.where(is_empty, 0., tl.exp(m - m_new)) + tl.where(is_empty, 0., tl.exp(logits - m_new))
+        m = m_new
+        if HAS_SMOOTHING:
+            sum_logits += tl.where(cols < N, logits, 0.)
+    m_row = tl.max(m, 0)
+    lse = m_row + tl.log(tl.sum(l * tl.exp(m - m_row), 0))
+    # -log(p[idx]), mixed with the mean of -log(p) if smoothed
+    is_valid = idx != ignore_index
+    target = tl.load(LOGITS + idx, mask=is_valid, other=0.).to(tl.float32)
+    if HAS_SMOOTHING:
+        loss = lse - (1. - smoothing) * target - smoothing * tl.sum(sum_logits, 0) / N
+    else:
+        loss = lse - target
+    tl.store(LOSS + row, loss * is_valid)
+    tl.store(LSE + row, lse)
+
+
+@triton.heuristics(_heuristics)
+@triton.heuristics({'num_warps': lambda nargs: num_warps(nargs['BLOCK'])})
 @triton.jit
-def _backward(PROBS, IDX, DPROBS, N, BLOCK: tl.constexpr):
+def _backward(LOGITS, DLOGITS, IDX, LSE, DLOSS, stride, stride_d,
+              n_cols, col_start, N, smoothing, ignore_index,
+              HAS_SMOOTHING: tl.constexpr, BLOCK: tl.constexpr):
+    # gradient of the columns [col_start, col_start + n_cols) of a row, of
+    # which LOGITS and DLOGITS hold the n_cols
     row = tl.program_id(0)
-    cols = tl.arange(0, BLOCK)
+    cols = tl.program_id(1) * BLOCK + tl.arange(0, BLOCK)
     idx = tl.load(IDX + row)
-    # pointers to probs
-    PROBS = PROBS + row * N + cols
+    lse = tl.load(LSE + row)
+    dloss = tl.load(DLOSS + row).to(tl.float32) * (idx != ignore_index)
+    logits = tl.load(LOGITS + row * stride + cols, mask=cols < n_cols, other=0.)
     # We know d(-log(p[i])/dlogit[k] = -id_mat[i,k] + p[k]
-    # and we have -log(p[k]) stored in PROBS, so this is easy
-    probs = -tl.load(PROBS, mask=cols < N, other=float('inf'))
-    probs = tl.exp(probs.to(tl.float32))
-    delta = cols == idx
-    # write result in-place in PROBS
-    dout = tl.load(DPROBS + row)
-    din = (probs - delta) * dout
-    tl.store(PROBS, din.to(PROBS.dtype.element_ty), mask=cols < N)
+    # and p[k] = exp(logit[k] - lse)
+    probs = tl.exp(logits.to(tl.float32) - lse)
+    is_target = col_start + cols == idx
+    if HAS_SMOOTHING:
+        din = probs - tl.where(is_target, 1. - smoothing, 0.) - smoothing / N
+    else:
+        din = tl.where(is_target, probs - 1., probs)
+    din = din * dloss
+    tl.store(DLOGITS + row * stride_d + cols, din.to(DLOGITS.dtype.element_ty), mask=cols < n_cols)
+
+
+def _check_indices(indices):
+    # make sure we can use triton
+    assert (indices.dtype == torch.int64), "Indices are expected to be of type long."
 
 
 class _cross_entropy(torch.autograd.Function):
     @classmethod
-    def forward(cls, ctx, logits, indices):
-        # make sure we can use triton
-        assert (indices.dtype == torch.int64), "Indices are expected to be of type long."
-        # make kernel
-        device, dtype = logits.device, logits.dtype
+    def forward(cls, ctx, logits, indices, smoothing=0., ignore_index=-100):
+        _check_indices(indices)
+        device = logits.device
         n_cols = logits.shape[-1]
+        logits_2d = logits.reshape(-1, n_cols)
+        if logits_2d.stride(-1) != 1:
+            logits_2d = logits_2d.contiguous()
+        n_rows = logits_2d.shape[0]
+        indices_1d = indices.reshape(-1).contiguous()
         # run the kernel
-        result = torch.empty_like(indices, dtype=dtype, device=device)
-        neg_logprobs = torch.empty_like(logits, dtype=dtype, device=device)
-        grid = lambda opt: (logits.numel() // n_cols, )
-        _forward[grid](logits, neg_logprobs, indices, result, n_cols)
+        result = torch.empty(n_rows, dtype=logits.dtype, device=device)
+        lse = torch.empty(n_rows, dtype=torch.float32, device=device)
+        _forward[(n_rows,)](logits_2d, indices_1d, result, lse, logits_2d.stride(0), n_cols,
+                            smoothing, ignore_index)
         # save for backward
-        ctx.save_for_backward(neg_logprobs, indices)
-        return result
+        ctx.save_for_backward(logits_2d, indices_1d, lse)
+        ctx.logits_shape = logits.shape
+        ctx.smoothing = smoothing
+        ctx.ignore_index = ignore_index
+        return result.view(indices.shape)
 
     @classmethod
-    def backward(cls, ctx, dneg_logprobs):
-        """We know d(-log(p[i])/dlogit[k] = -id_mat[i,k] + p[k]
-        so we initialize the gradient as neg_logprobs, so we can just exponentiate
-        to get p[k], which is most of what we need...  neg_logprobs will be
-        modified in place to become the gradient we want
+    def backward(cls, ctx, dloss):
+        """The probabilities are recomputed from the logits and their logsumexp"""
+        logits, indices, lse = ctx.saved_tensors
+        n_rows, n_cols = logits.shape
+        dloss = dloss.reshape(-1).contiguous()
+        dlogits = torch.empty_like(logits)
+        grid = lambda META: (n_rows, triton.cdiv(n_cols, META['BLOCK']))
+        _backward[grid](logits, dlogits, indices, lse, dloss, logits.stride(0), dlogits.stride(0),
+                        n_cols, 0, n_cols, ctx.smoothing, ctx.ignore_index)
+        return dlogits.view(ctx.logits_shape), None, None, None
+
+
+def cross_entropy(logits, indices, label_smoothing=0., ignore_index=-100):
+    """
+    Cross entropy between the softmax of `logits`, of shape (..., N), and the
+    targets `indices`, of shape (...). Returns the loss of each row.
+    """
+    return _cross_entropy.apply(logits, indices, label_smoothing, ignore_index)
+
+
+# ------------------------------------------------------------------------------
+# Fused linear layer
+# ------------------------------------------------------------------------------
+
+@triton.heuristics({'HAS_SMOOTHING': lambda nargs: nargs['smoothing'] > 0.})
+@triton.jit
+def _linear_forward(
+    X, W, IDX, LOSS, LSE,
+    M, N, K,
+    stride_xm, stride_xk, stride_wn, stride_wk,
+    smoothing, ignore_index,
+    HAS_SMOOTHING: tl.constexpr,
+    BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr,
+):
+    # the logits of BLOCK_M rows are computed a chunk of BLOCK_N columns at a
+    # time, and reduced right away
+    rm = tl.program_id(0) * BLOCK_M + tl.arange(0, BLOCK_M)
+    rn = tl.arange(0, BLOCK_N)
+    rk = tl.arange(0, BLOCK_K)
+    idx = tl.load(IDX + rm, mask=rm < M, other=ignore_index)
+    m_i = tl.zeros([BLOCK_M], dtype=tl.float32) - float('inf')
+    l_i = tl.zeros([BLOCK_M], dtype=tl.float32)
+    target = tl.zeros([BLOCK_M], dtype=tl.float32)
+    sum_logits = tl.zeros([BLOCK_M], dtype=tl.float32)
+    for start_n in range(0, N, BLOCK_N):
+        cols = start_n + rn
+        acc = tl.zeros([BLOCK_M, BLOCK_N], dtype=tl.float32)
+        for start_k in range(0, K, BLOCK_K):
+            ks = start_k + rk
+            x = tl.load(X + rm[:, None] * stride_xm + ks[None, :] * stride_xk,
+                        mask=(rm[:, None] < M) & (ks[None, :] < K), other=0.)
+            w = tl.load(W + cols[None, :] * stride_wn + ks[:, None] * stride_wk,
+                        mask=(cols[None, :] < N) & (ks[:, None] < K), other=0.)
+            acc += tl.dot(x, w)
+        logits = tl.where(cols[None, :] < N, acc, float('-inf'))
+        # -- update the running max and sum
+        m_ij = tl.maximum(m_i, tl.max(logits, 1))
+        alpha = tl.exp(m_i - m_ij)
+        l_i = l_i * alpha + tl.sum(tl.exp(logits - m_ij[:, None]), 1)
+        m_i = m_ij
+        target += tl.sum(tl.where(cols[None, :] == idx[:, None], acc, 0.), 1)
+        if HAS_SMOOTHING:
+            sum_logits += tl.sum(tl.where(cols[None, :] < N, acc, 0.), 1)
+    lse = m_i + tl.log(l_i)
+    if HAS_SMOOTHING:
+        loss = lse - (1. - smoothing) * target - smoothing * sum_logits / N
+    else:
+        loss = lse - target
+    loss = tl.where(idx != ignore_index, loss, 0.)
+    tl.store(LOSS + rm, loss, mask=rm < M)
+    tl.store(LSE + rm, lse, mask=rm < M)
+
+
+# logits recomputed at once by the backward pass of `linear_cross_entropy`
+MAX_CHUNK_ELEMENTS = 1 << 26
+
+
+class _linear_cross_entropy(torch.autograd.Function):
+    @classmethod
+    def forward(cls, ctx, x, weight, indices, smoothing=0., ignore_index=-100):
+        _check_indices(indices)
+        device = x.device
+        n_cols, K = weight.shape
+        x_2d = x.reshape(-1, K)
+        n_rows = x_2d.shape[0]
+        indices_1d = indices.reshape(-1).contiguous()
+        result = torch.empty(n_rows, dtype=x.dtype, device=device)
+        lse = torch.empty(n_rows, dtype=torch.float32, device=device)
+        BLOCK_M, BLOCK_N, BLOCK_K = 64, 64, 32
+        _linear_forward[(triton.cdiv(n_rows, BLOCK_M),)](
+            x_2d, weight, indices_1d, result, lse,
+            n_rows, n_cols, K,
+            x_2d.stride(0), x_2d.stride(1), weight.stride(0), weight.stride(1),
+            smoothing, ignore_index,
+            BLOCK_M=BLOCK_M, BLOCK_N=BLOCK_N, BLOCK_K=BLOCK_K, num_warps=4, num_stages=3,
+        )
+        ctx.save_for_backward(x_2d, weight, indices_1d, lse)
+        ctx.x_shape = x.shape
+        ctx.smoothing = smoothing
+        ctx.ignore_index = ignore_index
+        return result.view(indices.shape)
+
+    @classmethod
+    def backward(cls, ctx, dloss):
         """
-        # load saved tensors
-        neg_logprobs, indices = ctx.saved_tensors
-        # run the kernel
-        # neg_logprobs will be modified in place to become our gradient:
-        n_cols = neg_logprobs.shape[-1]
-        grid = lambda opt: (neg_logprobs.numel() // n_cols, )
-        _backward[grid](neg_logprobs, indices, dneg_logprobs, n_cols)
-        return neg_logprobs, None
+        The logits are recomputed a chunk of the vocabulary at a time, and so
+        are the gradients of `x` and of the rows of `weight` they depend on
+        """
+        x, weight, indices, lse = ctx.saved_tensors
+        n_rows, n_cols = x.shape[0], weight.shape[0]
+        dloss = dloss.reshape(-1).contiguous()
+        dx = torch.zeros(x.shape, dtype=torch.float32, device=x.device)
+        dweight = torch.empty_like(weight)
+        chunk = max(MAX_BLOCK, MAX_CHUNK_ELEMENTS // max(n_rows, 1))
+        for start in range(0, n_cols, chunk):
+            w = weight[start:start + chunk]
+            logits = torch.matmul(x, w.t())
+            dlogits = torch.empty_like(logits)
+            grid = lambda META: (n_rows, triton.cdiv(w.shape[0], META['BLOCK']))
+            _backward[grid](logits, dlogits, indices, lse, dloss, logits.stride(0), dlogits.stride(0),
+                            w.shape[0], start, n_cols, ctx.smoothing, ctx.ignore_index)
+            dx += torch.matmul(dlogits, w).float()
+            dweight[start:start + chunk] = torch.matmul(dlogits.t(), x)
+        return dx.to(x.dtype).view(ctx.x_shape), dweight, None, None, None
 
 
-cross_entropy = _cross_entropy.apply
+def linear_cross_entropy(x, weight, indices, label_smoothing=0., ignore_index=-100):
+    """
+    Cross entropy between the softmax of the logits `x @ weight.T`, with `x`
+    of shape (..., K) and `weight` of shape (N, K), and the targets
+    `indices`, of shape (...). Returns the loss of each row; the logits are
+    never stored.
+    """
+    return _linear_cross_entropy.apply(x, weight, indices, label_smoothing, ignore_index)
@@ -3,6 +3,15 @@ Fused Attention
 ===============
 This is a Triton implementation of the Flash Attention algorithm
 (see: Dao et al., https://arxiv.org/pdf/2205.14135v2.pdf; Rabe and Staats https://arxiv.org/pdf/2112.05682v2.pdf)
+
+The batches are either padded, of shape (Z, H, N_CTX, D_HEAD), or packed: the
+sequences of the batch are concatenated along the first dimension, of shape
+(total, H, D_HEAD), and delimited by the cumulative sums of their lengths
+(`cu_seqlens`, of Z + 1 elements starting at 0).
+
+With causal masking, the query i attends to the keys j <= i. The tiles of
+keys entirely above the diagonal are skipped, and only those crossing it are
+masked.
 """
 
 import torch
@@ -11,257 +20,637 @@ import triton
 import triton.language as tl
 
 
+@triton.jit
+def _seq_bounds(cu_seqlens, off_z, seqlen, VARLEN: tl.constexpr):
+    # offset and length of the sequence `off_z` of the batch
+    start = 0
+    if VARLEN:
+        start = tl.load(cu_seqlens + off_z)
+        seqlen = tl.load(cu_seqlens + off_z + 1) - start
+    return start, seqlen
+
+
+@triton.jit
+def _attn_fwd_inner(
+    acc, l_i, m_i, q, K, V, sm_scale,
+    stride_kn, stride_kk, stride_vn, stride_vk,
+    offs_m, lo, hi, seqlen_k,
+    BLOCK_N: tl.constexpr, BLOCK_DMODEL: tl.constexpr,
+    CAUSAL: tl.constexpr, MASK: tl.constexpr,
+):
+    # accumulates the keys in [lo, hi), masking those out of the sequence and,
+    # if causal, above the diagonal when `MASK` is set
+    offs_n = tl.arange(0, BLOCK_N)
+    offs_d = tl.arange(0, BLOCK_DMODEL)
+    for start_n in range(lo, hi, BLOCK_N):
+        cols = start_n + offs_n
+        k_ptrs = K + cols[None, :] * stride_kn + offs_d[:, None] * stride_kk
+        v_ptrs = V + cols[:, None] * stride_vn + offs_d[None, :] * stride_vk
+        # -- compute qk ----
+        if MASK:
+            k = tl.load(k_ptrs, mask=cols[None, :] < seqlen_k, other=0.)
+        else:
+            k = tl.load(k_ptrs)
+        qk = tl.dot(q, k) * sm_scale
+        if MASK:
+            mask = cols[None, :] < seqlen_k
+            if CAUSAL:
+                mask = mask & (offs_m[:, None] >= cols[None, :])
+            qk = tl.where(mask, qk, float("-inf"))
+        # -- update the running max and sum, the output being normalized last
+        m_ij = tl.maximum(m_i, tl.max(qk, 1))
+        alpha = tl.exp(m_i - m_ij)
+        p = tl.exp(qk - m_ij[:, None])
+        l_i = l_i * alpha + tl.sum(p, 1)
+        acc = acc * alpha[:, None]
+        if MASK:
+            v = tl.load(v_ptrs, mask=cols[:, None] < seqlen_k, other=0.)
+        else:
+            v = tl.load(v_ptrs)
+        acc += tl.dot(p.to(V.dtype.element_ty), v)
+        m_i = m_ij
+    return acc, l_i, m_i
+
+
 @triton.jit
 def _fwd_kernel(
     Q, K, V, sm_scale,
-    L, M,
-    Out,
+    LSE, Out,
+    cu_seqlens_q, cu_seqlens_k,
     stride_qz, stride_qh, stride_qm, stride_qk,
     stride_kz, stride_kh, stride_kn, stride_kk,
-    stride_vz, stride_vh, stride_vk, stride_vn,
-    stride_oz, stride_oh, stride_om, stride_on,
-    Z, H, N_CTX,
-    BLOCK_M: tl.constexpr, BLOCK_DMODEL: tl.constexpr,
-    BLOCK_N: tl.constexpr,
+    stride_vz, stride_vh, stride_vn, stride_vk,
+    stride_oz, stride_oh, stride_om, stride_ok,
+    stride_lz, stride_lh,
+    H, seqlen_q, seqlen_k,
+    BLOCK_DMODEL: tl.constexpr, CAUSAL: tl.constexpr, VARLEN: tl.constexpr,
+    BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr,
+    EVEN_M: tl.constexpr, EVEN_N: tl.constexpr,
 ):
     start_m = tl.program_id(0)
     off_hz = tl.program_id(1)
+    off_z = off_hz // H
+    off_h = off_hz % H
+    seq_start_q, seqlen_q = _seq_bounds(cu_seqlens_q, off_z, seqlen_q, VARLEN)
+    seq_start_k, seqlen_k = _seq_bounds(cu_seqlens_k, off_z, seqlen_k, VARLEN)
+    # the grid covers the longest sequence of the batch
+    if start_m * BLOCK_M >= seqlen_q:
+        return
+    # offset pointers for batch/head
+    Q += off_z * stride_qz + off_h * stride_qh + seq_start_q * stride_qm
+    K += off_z * stride_kz + off_h * stride_kh + seq_start_k * stride_kn
+    V += off_z * stride_vz + off_h * stride_vh + seq_start_k * stride_vn
+    Out += off_z * stride_oz + off_h * stride_oh + seq_start_q * stride_om
+    LSE += off_z * stride_lz + off_h * stride_lh + seq_start_q
     # initialize offsets
     offs_m = start_m * BLOCK_M + tl.arange(0, BLOCK_M)
-    offs_n = tl.arange(0, BLOCK_N)
     offs_d = tl.arange(0, BLOCK_DMODEL)
-    off_q = off_hz * stride_qh + offs_m[:, None] * stride_qm + offs_d[None, :] * stride_qk
-    off_k = off_hz * stride_qh + offs_n[None, :] * stride_kn + offs_d[:, None] * stride_kk
-    off_v = off_hz * stride_qh + offs_n[:, None] * stride_qm + offs_d[None, :] * stride_qk
-    # Initialize pointers to Q, K, V
-    q_ptrs = Q + off_q
-    k_ptrs = K + off_k
-    v_ptrs = V + off_v
-    # initialize pointer to m and l
-    m_prev = tl.zeros([BLOCK_M], dtype=tl.float32) - float("inf")
-    l_prev = tl.zeros([BLOCK_M], dtype=tl.float32)
-    acc = tl.zeros([BLOCK_M, BLOCK_DMODEL], dtype=tl.float32)
+    q_ptrs = Q + offs_m[:, None] * stride_qm + offs_d[None, :] * stride_qk
     # load q: it will stay in SRAM throughout
-    q = tl.load(q_ptrs)
-    # loop over k, v and update accumulator
-    for start_n in range(0, (start_m + 1) * BLOCK_M, BLOCK_N):
-        # -- compute qk ----
-        k = tl.load(k_ptrs)
-        qk = tl.zeros([BLOCK_M, BLOCK_N], dtype=tl.float32)
-        qk += tl.dot(q, k)
-        qk *= sm_scale
-        qk = tl.where(offs_m[:, None] >= (start_n + offs_n[None, :]), qk, float("-inf"))
-        # compute new m
-        m_curr = tl.maximum(tl.max(qk, 1), m_prev)
-        # correct old l
-        l_prev *= tl.exp(m_prev - m_curr)
-        # attention weights
-        p = tl.exp(qk - m_curr[:, None])
-        l_curr = tl.sum(p, 1) + l_prev
-        # rescale operands of matmuls
-        l_rcp = 1. / l_curr
-        p *= l_rcp
-        acc *= (l_prev * l_rcp)[:, None]
-        # update acc
-        p = p.to(tl.float16)
-        v = tl.load(v_ptrs)
-        acc += tl.dot(p, v)
-        # update m_i and l_i
-        l_prev = l_curr
-        m_prev = m_curr
-        # update pointers
-        k_ptrs += BLOCK_N * stride_kn
-        v_ptrs += BLOCK_N * stride_vk
-    # rematerialize offsets to save registers
-    start_m = tl.program_id(0)
-    offs_m = start_m * BLOCK_M + tl.arange(0, BLOCK_M)
-    # write back l and m
-    l_ptrs = L + off_hz * N_CTX + offs_m
-    m_ptrs = M + off_hz * N_CTX + offs_m
-    tl.store(l_ptrs, l_prev)
-    tl.store(m_ptrs, m_prev)
-    # initialize pointers to output
-    offs_n = tl.arange(0, BLOCK_DMODEL)
-    off_o = off_hz * stride_oh + offs_m[:, None] * stride_om + offs_n[None, :] * stride_on
-    out_ptrs = Out + off_o
-    tl.store(out_ptrs, acc)
+    if EVEN_M:
+        q = tl.load(q_ptrs)
+    else:
+        q = tl.load(q_ptrs, mask=offs_m[:, None] < seqlen_q, other=0.)
+    m_i = tl.zeros([BLOCK_M], dtype=tl.float32) - float("inf")
+    l_i = tl.zeros([BLOCK_M], dtype=tl.float32)
+    acc = tl.zeros([BLOCK_M, BLOCK_DMODEL], dtype=tl.float32)
+    # the tiles of keys entirely below the diagonal and in the sequence are
+    # not masked, those crossing the diagonal or the end of the sequence are
+    if CAUSAL:
+        hi = tl.minimum(seqlen_k, (start_m + 1) * BLOCK_M)
+        full_hi = tl.minimum((start_m * BLOCK_M + 1) // BLOCK_N * BLOCK_N, seqlen_k // BLOCK_N * BLOCK_N)
+    else:
+        hi = seqlen_k
+        full_hi = seqlen_k // BLOCK_N * BLOCK_N
+    acc, l_i, m_i = _attn_fwd_inner(acc, l_i, m_i, q, K, V, sm_scale,
+                                    stride_kn, stride_kk, stride_vn, stride_vk,
+                                    offs_m, 0, full_hi, seqlen_k,
+                                    BLOCK_N, BLOCK_DMODEL, CAUSAL, False)
+    acc, l_i, m_i = _attn_fwd_inner(acc, l_i, m_i, q, K, V, sm_scale,
+                                    stride_kn, stride_kk, stride_vn, stride_vk,
+                                    offs_m, full_hi, hi, seqlen_k,
+                                    BLOCK_N, BLOCK_DMODEL, CAUSAL, True)
+    acc = acc / l_i[:, None]
+    # write back the logsumexp of the rows, from which backward recomputes p
+    out_ptrs = Out + offs_m[:, None] * stride_om + offs_d[None, :] * stride_ok
+    if EVEN_M:
+        tl.store(LSE + offs_m, m_i + tl.log(l_i))
+        tl.store(out_ptrs, acc.to(Out.dtype.element_ty))
+    else:
+        tl.store(LSE + offs_m, m_i + tl.log(l_i), mask=offs_m < seqlen_q)
+        tl.store(out_ptrs, acc.to(Out.dtype.element_ty), mask=offs_m[:, None] < seqlen_q)
 
 
 @triton.jit
 def _bwd_preprocess(
-    Out, DO, L,
-    NewDO, Delta,
-    BLOCK_M: tl.constexpr, D_HEAD: tl.constexpr,
+    Out, DO, Delta,
+    cu_seqlens_q,
+    stride_oz, stride_oh, stride_om, stride_ok,
+    stride_dz, stride_dh, stride_dm, stride_dk,
+    stride_lz, stride_lh,
+    H, seqlen_q,
+    BLOCK_DMODEL: tl.constexpr, VARLEN: tl.constexpr, BLOCK_M: tl.constexpr,
 ):
-    off_m = tl.program_id(0) * BLOCK_M + tl.arange(0, BLOCK_M)
-    off_n = tl.arange(0, D_HEAD)
+    start_m = tl.program_id(0)
+    off_hz = tl.program_id(1)
+    off_z = off_hz // H
+    off_h = off_hz % H
+    seq_start_q, seqlen_q = _seq_bounds(cu_seqlens_q, off_z, seqlen_q, VARLEN)
+    off_m = start_m * BLOCK_M + tl.arange(0, BLOCK_M)
+    off_n = tl.arange(0, BLOCK_DMODEL)
+    mask = off_m < seqlen_q
+    Out += off_z * stride_oz + off_h * stride_oh + seq_start_q * stride_om
+    DO += off_z * stride_dz + off_h * stride_dh + seq_start_q * stride_dm
+    Delta += off_z * stride_lz + off_h * stride_lh + seq_start_q
     # load
-    o = tl.load(Out + off_m[:, None] * D_HEAD + off_n[None, :]).to(tl.float32)
-    do = tl.load(DO + off_m[:, None] * D_HEAD + off_n[None, :]).to(tl.float32)
-    denom = tl.load(L + off_m).to(tl.float32)
+    o = tl.load(Out + off_m[:, None] * stride_om + off_n[None, :] * stride_ok, mask=mask[:, None], other=0.).to(tl.float32)
+    do = tl.load(DO + off_m[:, None] * stride_dm + off_n[None, :] * stride_dk, mask=mask[:, None], other=0.).to(tl.float32)
     # compute
-    do = do / denom[:, None]
     delta = tl.sum(o * do, axis=1)
     # write-back
-    tl.store(NewDO + off_m[:, None] * D_HEAD + off_n[None, :], do)
-    tl.store(Delta + off_m, delta)
+    tl.store(Delta + off_m, delta, mask=mask)
 
 
 @triton.jit
-def _bwd_kernel(
-    Q, K, V, sm_scale, Out, DO,
-    DQ, DK, DV,
-    L, M,
-    D,
+def _bwd_kv_inner(
+    dk, dv, k, v, Q, DO, LSE, Delta, sm_scale,
+    stride_qm, stride_qk, stride_dm, stride_dk,
+    offs_n, lo, hi, seqlen_q,
+    BLOCK_M: tl.constexpr, BLOCK_DMODEL: tl.constexpr,
+    MASK: tl.constexpr, EVEN_M: tl.constexpr,
+):
+    # accumulates the queries in [lo, hi), masking the keys above the
+    # diagonal when `MASK` is set; the rows out of the sequence are loaded as
+    # zeros and contribute nothing
+    offs_m = tl.arange(0, BLOCK_M)
+    offs_d = tl.arange(0, BLOCK_DMODEL)
+    for start_m in range(lo, hi, BLOCK_M):
+        rows = start_m + offs_m
+        q_ptrs = Q + rows[:, None] * stride_qm + offs_d[None, :] * stride_qk
+        do_ptrs = DO + rows[:, None] * stride_dm + offs_d[None, :] * stride_dk
+        if EVEN_M:
+            q = tl.load(q_ptrs)
+            do = tl.load(do_ptrs)
+            lse = tl.load(LSE + rows)
+            Di = tl.load(Delta + rows)
+        else:
+            q = tl.load(q_ptrs, mask=rows[:, None] < seqlen_q, other=0.)
+            do = tl.load(do_ptrs, mask=rows[:, None] < seqlen_q, other=0.)
+            lse = tl.load(LSE + rows, mask=rows < seqlen_q, other=0.)
+            Di = tl.load(Delta + rows, mask=rows < seqlen_q, other=0.)
+        # recompute p = softmax(qk, dim=-1)
+        qk = tl.dot(q, tl.trans(k))
+        p = tl.exp(qk * sm_scale - lse[:, None])
+        if MASK:
+            p = tl.where(rows[:, None] >= offs_n[None, :], p, 0.)
+        # compute dv
+        dv += tl.dot(tl.trans(p.to(Q.dtype.element_ty)), do)
+        # compute dp = dot(do, v) and ds = p * (dp - delta[:, None])
+        dp = tl.dot(do, tl.trans(v))
+        ds = p * (dp - Di[:, None]) * sm_scale
+        # compute dk = dot(ds.T, q)
+        dk += tl.dot(tl.trans(ds.to(Q.dtype.element_ty)), q)
+    return dk, dv
+
+
+@triton.jit
+def _bwd_kv_kernel(
+    Q, K, V, sm_scale, DO,
+    DK, DV,
+    LSE, Delta,
+    cu_seqlens_q, cu_seqlens_k,
     stride_qz, stride_qh, stride_qm, stride_qk,
     stride_kz, stride_kh, stride_kn, stride_kk,
-    stride_vz, stride_vh, stride_vk, stride_vn,
-    Z, H, N_CTX,
-    num_block,
-    BLOCK_M: tl.constexpr, BLOCK_DMODEL: tl.constexpr,
-    BLOCK_N: tl.constexpr,
+    stride_vz, stride_vh, stride_vn, stride_vk,
+    stride_dz, stride_dh, stride_dm, stride_dk,
+    stride_lz, stride_lh,
+    H, seqlen_q, seqlen_k,
+    BLOCK_DMODEL: tl.constexpr, CAUSAL: tl.constexpr, VARLEN: tl.constexpr,
+    BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr,
+    EVEN_M: tl.constexpr, EVEN_N: tl.constexpr,
 ):
-    off_hz = tl.program_id(0)
+    start_n = tl.program_id(0)
+    off_hz = tl.program_id(1)
     off_z = off_hz // H
     off_h = off_hz % H
+    seq_start_q, seqlen_q = _seq_bounds(cu_seqlens_q, off_z, seqlen_q, VARLEN)
+    seq_start_k, seqlen_k = _seq_bounds(cu_seqlens_k, off_z, seqlen_k, VARLEN)
+    if start_n * BLOCK_N >= seqlen_k:
+        return
     # offset pointers for batch/head
-    Q += off_z * stride_qz + off_h * stride_qh
-    K += off_z * stride_qz + off_h * stride_qh
-    V += off_z * stride_qz + off_h * stride_qh
-    DO += off_z * stride_qz + off_h * stride_qh
-    DQ += off_z * stride_qz + off_h * stride_qh
-    DK += off_z * stride_qz + off_h * stride_qh
-    DV += off_z * stride_qz + off_h * stride_qh
-    for start_n in range(0, num_block):
-        lo = start_n * BLOCK_M
-        # initialize row/col offsets
-        offs_qm = lo + tl.arange(0, BLOCK_M)
-        offs_n = start_n * BLOCK_M + tl.arange(0, BLOCK_M)
-        offs_m = tl.arange(0, BLOCK_N)
-        offs_k = tl.arange(0, BLOCK_DMODEL)
-        # initialize pointers to value-like data
-        q_ptrs = Q + (offs_qm[:, None] * stride_qm + offs_k[None, :] * stride_qk)
-        k_ptrs = K + (offs_n[:, None] * stride_kn + offs_k[None, :] * stride_kk)
-        v_ptrs = V + (offs_n[:, None] * stride_qm + offs_k[None, :] * stride_qk)
-        do_ptrs = DO + (offs_qm[:, None] * stride_qm + offs_k[None, :] * stride_qk)
-        dq_ptrs = DQ + (offs_qm[:, None] * stride_qm + offs_k[None, :] * stride_qk)
-        # pointer to row-wise quantities in value-like data
-        D_ptrs = D + off_hz * N_CTX
-        m_ptrs = M + off_hz * N_CTX
-        # initialize dv amd dk
-        dv = tl.zeros([BLOCK_M, BLOCK_DMODEL], dtype=tl.float32)
-        dk = tl.zeros([BLOCK_M, BLOCK_DMODEL], dtype=tl.float32)
-        # k and v stay in SRAM throughout
+    Q += off_z * stride_qz + off_h * stride_qh + seq_start_q * stride_qm
+    K += off_z * stride_kz + off_h * stride_kh + seq_start_k * stride_kn
+    V += off_z * stride_vz + off_h * stride_vh + seq_start_k * stride_vn
+    DO += off_z * stride_dz + off_h * stride_dh + seq_start_q * stride_dm
+    DK += off_z * stride_kz + off_h * stride_kh + seq_start_k * stride_kn
+    DV += off_z * stride_vz + off_h * stride_vh + seq_start_k * stride_vn
+    LSE += off_z * stride_lz + off_h * stride_lh + seq_start_q
+    Delta += off_z * stride_lz + off_h * stride_lh + seq_start_q
+    offs_n = start_n * BLOCK_N + tl.arange(0, BLOCK_N)
+    offs_d = tl.arange(0, BLOCK_DMODEL)
+    k_ptrs = K + offs_n[:, None] * stride_kn + offs_d[None, :] * stride_kk
+    v_ptrs = V + offs_n[:, None] * stride_vn + offs_d[None, :] * stride_vk
+    # k and v stay in SRAM throughout, the keys out of the sequence are zeros
+    if EVEN_N:
         k = tl.load(k_ptrs)
         v = tl.load(v_ptrs)
-        # loop over rows
-        for start_m in range(lo, num_block * BLOCK_M, BLOCK_M):
-            offs_m_curr = start_m + offs_m
-            # load q, k, v, do on-chip
-            q = tl.load(q_ptrs)
-            # recompute p = softmax(qk, dim=-1).T
-            # NOTE: `do` is pre-divided by `l`; no normalization here
-            qk = tl.dot(q, tl.trans(k))
-            qk = tl.where(offs_m_curr[:, None] >= (offs_n[None, :]), qk, float("-inf"))
-            m = tl.load(m_ptrs + offs_m_curr)
-            p = tl.exp(qk * sm_scale - m[:, None])
-            # compute dv
-            do = tl.load(do_ptrs)
-            dv += tl.dot(tl.trans(p.to(tl.float16)), do)
-            # compute dp = dot(v, do)
-            Di = tl.load(D_ptrs + offs_m_curr)
-            dp = tl.zeros([BLOCK_M, BLOCK_N], dtype=tl.float32) - Di[:, None]
-            dp += tl.dot(do, tl.trans(v))
-            # compute ds = p * (dp - delta[:, None])
-            ds = p * dp * sm_scale
-            # compute dk = dot(ds.T, q)
-            dk += tl.dot(tl.trans(ds.to(tl.float16)), q)
-            # compute dq
-            dq = tl.load(dq_ptrs)
-            dq += tl.dot(ds.to(tl.float16), k)
-            tl.store(dq_ptrs, dq)
-            # increment pointers
-            dq_ptrs += BLOCK_M * stride_qm
-            q_ptrs += BLOCK_M * stride_qm
-            do_ptrs += BLOCK_M * stride_qm
-        # write-back
-        dv_ptrs = DV + (offs_n[:, None] * stride_qm + offs_k[None, :] * stride_qk)
-        dk_ptrs = DK + (offs_n[:, None] * stride_kn + offs_k[None, :] * stride_kk)
-        tl.store(dv_ptrs, dv)
-        tl.store(dk_ptrs, dk)
+    else:
+        k = tl.load(k_ptrs, mask=offs_n[:, None] < seqlen_k, other=0.)
+        v = tl.load(v_ptrs, mask=offs_n[:, None] < seqlen_k, other=0.)
+    dv = tl.zeros([BLOCK_N, BLOCK_DMODEL], dtype=tl.float32)
+    dk = tl.zeros([BLOCK_N, BLOCK_DMODEL], dtype=tl.float32)
+    # the tiles of queries entirely above the diagonal are skipped, those
+    # crossing it are masked
+    if CAUSAL:
+        lo = start_n * BLOCK_N // BLOCK_M * BLOCK_M
+        full_lo = tl.minimum((start_n * BLOCK_N + BLOCK_N - 1 + BLOCK_M - 1) // BLOCK_M * BLOCK_M, seqlen_q)
+    else:
+        lo = 0
+        full_lo = 0
+    dk, dv = _bwd_kv_inner(dk, dv, k, v, Q, DO, LSE, Delta, sm_scale,
+                           stride_qm, stride_qk, stride_dm, stride_dk,
+                           offs_n, lo, full_lo, seqlen_q,
+                           BLOCK_M, BLOCK_DMODEL, True, EVEN_M)
+    dk, dv = _bwd_kv_inner(dk, dv, k, v, Q, DO, LSE, Delta, sm_scale,
+                           stride_qm, stride_qk, stride_dm, stride_dk,
+                           offs_n, full_lo, seqlen_q, seqlen_q,
+                           BLOCK_M, BLOCK_DMODEL, False, EVEN_M)
+    # write-back
+    dv_ptrs = DV + offs_n[:, None] * stride_vn + offs_d[None, :] * stride_vk
+    dk_ptrs = DK + offs_n[:, None] * stride_kn + offs_d[None, :] * stride_kk
+    if EVEN_N:
+        tl.store(dv_ptrs, dv.to(DV.dtype.element_ty))
+        tl.store(dk_ptrs, dk.to(DK.dtype.element_ty))
+    else:
+        tl.store(dv_ptrs, dv.to(DV.dtype.element_ty), mask=offs_n[:, None] < seqlen_k)
+        tl.store(dk_ptrs, dk.to(DK.dtype.element_ty), mask=offs_n[:, None] < seqlen_k)
+
+
+@triton.jit
+def _bwd_q_inner(
+    dq, q, do, lse, Di, K, V, sm_scale,
+    stride_kn, stride_kk, stride_vn, stride_vk,
+    offs_m, lo, hi, seqlen_k,
+    BLOCK_N: tl.constexpr, BLOCK_DMODEL: tl.constexpr,
+    MASK: tl.constexpr, EVEN_N: tl.constexpr,
+):
+    # accumulates the keys in [lo, hi), masking those above the diagonal when
+    # `MASK` is set; the keys out of the sequence are loaded as zeros and
+    # contribute nothing
+    offs_n = tl.arange(0, BLOCK_N)
+    offs_d = tl.arange(0, BLOCK_DMODEL)
+    for start_n in range(lo, hi, BLOCK_N):
+        cols = start_n + offs_n
+        k_ptrs = K + cols[:, None] * stride_kn + offs_d[None, :] * stride_kk
+        v_ptrs = V + cols[:, None] * stride_vn + offs_d[None, :] * stride_vk
+        if EVEN_N:
+            k = tl.load(k_ptrs)
+            v = tl.load(v_ptrs)
+        else:
+            k = tl.load(k_ptrs, mask=cols[:, None] < seqlen_k, other=0.)
+            v = tl.load(v_ptrs, mask=cols[:, None] < seqlen_k, other=0.)
+        qk = tl.dot(q, tl.trans(k))
+        p = tl.exp(qk * sm_scale - lse[:, None])
+        if MASK:
+            p = tl.where(offs_m[:, None] >= cols[None, :], p, 0.)
+        dp = tl.dot(do, tl.trans(v))
+        ds = p * (dp - Di[:, None]) * sm_scale
+        dq += tl.dot(ds.to(K.dtype.element_ty), k)
+    return dq
+
+
+@triton.jit
+def _bwd_q_kernel(
+    Q, K, V, sm_scale, DO,
+    DQ,
+    LSE, Delta,
+    cu_seqlens_q, cu_seqlens_k,
+    stride_qz, stride_qh, stride_qm, stride_qk,
+    stride_kz, stride_kh, stride_kn, stride_kk,
+    stride_vz, stride_vh, stride_vn, stride_vk,
+    stride_dz, stride_dh, stride_dm, stride_dk,
+    stride_lz, stride_lh,
+    H, seqlen_q, seqlen_k,
+    BLOCK_DMODEL: tl.constexpr, CAUSAL: tl.constexpr, VARLEN: tl.constexpr,
+    BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr,
+    EVEN_M: tl.constexpr, EVEN_N: tl.constexpr,
+):
+    start_m = tl.program_id(0)
+    off_hz = tl.program_id(1)
+    off_z = off_hz // H
+    off_h = off_hz % H
+    seq_start_q, seqlen_q = _seq_bounds(cu_seqlens_q, off_z, seqlen_q, VARLEN)
+    seq_start_k, seqlen_k = _seq_bounds(cu_seqlens_k, off_z, seqlen_k, VARLEN)
+    if start_m * BLOCK_M >= seqlen_q:
+        return
+    # offset pointers for batch/head
+    Q += off_z * stride_qz + off_h * stride_qh + seq_start_q * stride_qm
+    K += off_z * stride_kz + off_h * stride_kh + seq_start_k * stride_kn
+    V += off_z * stride_vz + off_h * stride_vh + seq_start_k * stride_vn
+    DO += off_z * stride_dz + off_h * stride_dh + seq_start_q * stride_dm
+    DQ += off_z * stride_qz + off_h * stride_qh + seq_start_q * stride_qm
+    LSE += off_z * stride_lz + off_h * stride_lh + seq_start_q
+    Delta += off_z * stride_lz + off_h * stride_lh + seq_start_q
+    offs_m = start_m * BLOCK_M + tl.arange(0, BLOCK_M)
+    offs_d = tl.arange(0, BLOCK_DMODEL)
+    q_ptrs = Q + offs_m[:, None] * stride_qm + offs_d[None, :] * stride_qk
+    do_ptrs = DO + offs_m[:, None] * stride_dm + offs_d[None, :] * stride_dk
+    # q, do and the row-wise quantities stay in SRAM throughout
+    if EVEN_M:
+        q = tl.load(q_ptrs)
+        do = tl.load(do_ptrs)
+        lse = tl.load(LSE + offs_m)
+        Di = tl.load(Delta + offs_m)
+    else:
+        q = tl.load(q_ptrs, mask=offs_m[:, None] < seqlen_q, other=0.)
+        do = tl.load(do_ptrs, mask=offs_m[:, None] < seqlen_q, other=0.)
+        lse = tl.load(LSE + offs_m, mask=offs_m < seqlen_q, other=0.)
+        Di = tl.load(Delta + offs_m, mask=offs_m < seqlen_q, other=0.)
+    dq = tl.zeros([BLOCK_M, BLOCK_DMODEL], dtype=tl.float32)
+    if CAUSAL:
+        hi = tl.minimum(seqlen_k, (start_m + 1) * BLOCK_M)
+        full_hi = tl.minimum((start_m * BLOCK_M + 1) // BLOCK_N * BLOCK_N, hi)
+    else:
+        hi = seqlen_k
+        full_hi = seqlen_k
+    dq = _bwd_q_inner(dq, q, do, lse, Di, K, V, sm_scale,
+                      stride_kn, stride_kk, stride_vn, stride_vk,
+                      offs_m, 0, full_hi, seqlen_k,
+                      BLOCK_N, BLOCK_DMODEL, False, EVEN_N)
+    dq = _bwd_q_inner(dq, q, do, lse, Di, K, V, sm_scale,
+                      stride_kn, stride_kk, stride_vn, stride_vk,
+                      offs_m, full_hi, hi, seqlen_k,
+                      BLOCK_N, BLOCK_DMODEL, True, EVEN_N)
+    # write-back
+    dq_ptrs = DQ + offs_m[:, None] * stride_qm + offs_d[None, :] * stride_qk
+    if EVEN_M:
+        tl.store(dq_ptrs, dq.to(DQ.dtype.element_ty))
+    else:
+        tl.store(dq_ptrs, dq.to(DQ.dtype.element_ty), mask=offs_m[:, None] < seqlen_q)
+
+
+def _configs(blocks):
+    # (BLOCK_M, BLOCK_N, num_warps, num_stages); the wavefronts of AMD GPUs
+    # are twice as wide as the warps of NVIDIA GPUs, and their software
+    # pipelining does not pay off on these loops
+    if torch.version.hip is not None:
+        return [triton.Config({'BLOCK_M': m, 'BLOCK_N': n}, num_warps=max(w // 2, 1), num_stages=1)
+                for m, n, w, _ in blocks]
+    return [triton.Config({'BLOCK_M': m, 'BLOCK_N': n}, num_warps=w, num_stages=s) for m, n, w, s in blocks]
+
+
+_even_heuristics = {
+    'EVEN_M': lambda args: not args['VARLEN'] and args['seqlen_q'] % args['BLOCK_M'] == 0,
+    'EVEN_N': lambda args: not args['VARLEN'] and args['seqlen_k'] % args['BLOCK_N'] == 0,
+}
+_tuning_key = ['seqlen_q', 'seqlen_k', 'BLOCK_DMODEL', 'CAUSAL', 'VARLEN']
+
+_fwd = triton.autotune(
+    configs=_configs([(128, 128, 8, 2), (128, 64, 4, 3), (64, 64, 4, 3), (128, 32, 4, 3)]),
+    key=_tuning_key)(triton.heuristics(_even_heuristics)(_fwd_kernel))
+_bwd_kv = triton.autotune(
+    configs=_configs([(64, 64, 4, 1), (128, 64, 8, 1), (64, 128, 8, 1)]),
+    key=_tuning_key)(triton.heuristics(_even_heuristics)(_bwd_kv_kernel))
+_bwd_q = triton.autotune(
+    configs=_configs([(64, 64, 4, 1), (128, 64, 8, 1), (64, 128, 8, 1)]),
+    key=_tuning_key)(triton.heuristics(_even_heuristics)(_bwd_q_kernel))
+
+
+def _strides(x, varlen):
+    # batch, head, sequence and feature strides
+    if varlen:
+        return 0, x.stride(1), x.stride(0), x.stride(2)
+    return x.stride(0), x.stride(1), x.stride(2), x.stride(3)
+
+
+def _lse_strides(lse, varlen):
+    # batch and head strides of the row-wise quantities
+    if varlen:
+        return 0, lse.stride(1)
+    return lse.stride(0), lse.stride(1)
+
+
+def _seqlen_bucket(seqlen):
+    # the autotuning of packed batches is keyed on their longest sequence,
+    # rounded up not to tune again for each batch
+    return triton.next_power_of_2(seqlen)
 
 
 class _attention(torch.autograd.Function):
 
     @staticmethod
-    def forward(ctx, q, k, v, sm_scale):
+    def forward(ctx, q, k, v, sm_scale, causal, cu_seqlens_q, cu_seqlens_k, max_seqlen_q, max_seqlen_k):
         # only support for Ampere now
-        capability = torch.cuda.get_device_capability()
-        if capability[0] < 8:
-            raise RuntimeError("Flash attention currently only supported for compute capability < 80")
-        BLOCK = 128
+        if torch.version.hip is None:
+            capability = torch.cuda.get_device_capability()
+            if capability[0] < 8:
+                raise RuntimeError("Flash attention currently only supported for compute capability >= 80")
         # shape constraints
         Lq, Lk, Lv = q.shape[-1], k.shape[-1], v.shape[-1]
         assert Lq == Lk and Lk == Lv
-        # assert Lk in {16, 32, 64, 128}
-        assert Lk in {64}  # TODO: fix other cases
+        assert Lk in {16, 32, 64, 128}
+        varlen = cu_seqlens_q is not None
+        if varlen:
+            assert q.dim() == 3 and cu_seqlens_k is not None
+            Z, H = cu_seqlens_q.numel() - 1, q.shape[1]
+            seqlen_q, seqlen_k = _seqlen_bucket(max_seqlen_q), _seqlen_bucket(max_seqlen_k)
+            # the logsumexp of the rows, per head
+            L = torch.empty((1, H, q.shape[0]), device=q.device, dtype=torch.float32)
+        else:
+            assert q.dim() == 4
+            Z, H = q.shape[0], q.shape[1]
+            seqlen_q = max_seqlen_q = q.shape[2]
+            seqlen_k = max_seqlen_k = k.shape[2]
+            L = torch.empty((Z, H, seqlen_q), device=q.device, dtype=torch.float32)
+            cu_seqlens_q = cu_seqlens_k = L  # unused
         o = torch.empty_like(q)
-        grid = (triton.cdiv(q.shape[2], BLOCK), q.shape[0] * q.shape[1], 1)
-        L = torch.empty((q.shape[0] * q.shape[1], q.shape[2]), device=q.device, dtype=torch.float32)
-        m = torch.empty((q.shape[0] * q.shape[1], q.shape[2]), device=q.device, dtype=torch.float32)
-        num_warps = 4 if Lk <= 64 else 8
-
-        _fwd_kernel[grid](
+        grid = lambda META: (triton.cdiv(max_seqlen_q, META['BLOCK_M']), Z * H)
+        _fwd[grid](
             q, k, v, sm_scale,
-            L, m,
-            o,
-            q.stride(0), q.stride(1), q.stride(2), q.stride(3),
-            k.stride(0), k.stride(1), k.stride(2), k.stride(3),
-            v.stride(0), v.stride(1), v.stride(2), v.stride(3),
-            o.stride(0), o.stride(1), o.stride(2), o.stride(3),
-            q.shape[0], q.shape[1], q.shape[2],
-            BLOCK_M=BLOCK, BLOCK_N=BLOCK,
-            BLOCK_DMODEL=Lk, num_warps=num_warps,
-            num_stages=2,
+            L, o,
+            cu_seqlens_q, cu_seqlens_k,
+            *_strides(q, varlen), *_strides(k, varlen), *_strides(v, varlen), *_strides(o, varlen),
+            *_lse_strides(L, varlen),
+            H, seqlen_q, seqlen_k,
+            Lk, causal, varlen,
         )
 
-        ctx.save_for_backward(q, k, v, o, L, m)
-        ctx.grid = grid
+        ctx.save_for_backward(q, k, v, o, L, cu_seqlens_q, cu_seqlens_k)
         ctx.sm_scale = sm_scale
-        ctx.BLOCK_DMODEL = Lk
+        ctx.causal = causal
+        ctx.varlen = varlen
+        ctx.shape = (Z, H, seqlen_q, seqlen_k, max_seqlen_q, max_seqlen_k)
         return o
 
     @staticmethod
     def backward(ctx, do):
-        BLOCK = 128
-        q, k, v, o, l, m = ctx.saved_tensors
+        q, k, v, o, L, cu_seqlens_q, cu_seqlens_k = ctx.saved_tensors
+        Z, H, seqlen_q, seqlen_k, max_seqlen_q, max_seqlen_k = ctx.shape
+        varlen = ctx.varlen
+        Lk = k.shape[-1]
         do = do.contiguous()
-        dq = torch.zeros_like(q, dtype=torch.float32)
+        dq = torch.empty_like(q)
         dk = torch.empty_like(k)
         dv = torch.empty_like(v)
-        do_scaled = torch.empty_like(do)
-        delta = torch.empty_like(l)
-        _bwd_preprocess[(ctx.grid[0] * ctx.grid[1], )](
-            o, do, l,
-            do_scaled, delta,
-            BLOCK_M=BLOCK, D_HEAD=ctx.BLOCK_DMODEL,
-        )
-        _bwd_kernel[(ctx.grid[1],)](
-            q, k, v, ctx.sm_scale,
-            o, do_scaled,
-            dq, dk, dv,
-            l, m,
-            delta,
-            q.stride(0), q.stride(1), q.stride(2), q.stride(3),
-            k.stride(0), k.stride(1), k.stride(2), k.stride(3),
-            v.stride(0), v.stride(1), v.stride(2), v.stride(3),
-            q.shape[0], q.shape[1], q.shape[2],
-            ctx.grid[0],
-            BLOCK_M=BLOCK, BLOCK_N=BLOCK,
-            BLOCK_DMODEL=ctx.BLOCK_DMODEL, num_warps=8,
-            num_stages=1,
+        delta = torch.empty_like(L)
+        BLOCK = 64
+        _bwd_preprocess[(triton.cdiv(max_seqlen_q, BLOCK), Z * H)](
+            o, do, delta,
+            cu_seqlens_q,
+            *_strides(o, varlen), *_strides(do, varlen),
+            *_lse_strides(L, varlen),
+            H, seqlen_q,
+            Lk, varlen, BLOCK_M=BLOCK,
         )
-        return dq, dk, dv, None
+        args = (q, k, v, ctx.sm_scale, do)
+        strides = (*_strides(q, varlen), *_strides(k, varlen), *_strides(v, varlen), *_strides(do, varlen),
+                   *_lse_strides(L, varlen),
+                   H, seqlen_q, seqlen_k,
+                   Lk, ctx.causal, varlen)
+        grid = lambda META: (triton.cdiv(max_seqlen_k, META['BLOCK_N']), Z * H)
+        _bwd_kv[grid](*args, dk, dv, L, delta, cu_seqlens_q, cu_seqlens_k, *strides)
+        grid = lambda META: (triton.cdiv(max_seqlen_q, META['BLOCK_M']), Z * H)
+        _bwd_q[grid](*args, dq, L, delta, cu_seqlens_q, cu_seqlens_k, *strides)
+        return dq, dk, dv, None, None, None, None, None, None
+
+
+def attention(q, k, v, sm_scale, causal=True):
+    """
+    Attention of the padded batches `q`, `k` and `v` of shape
+    (Z, H, N_CTX, D_HEAD), the sequences of `k` and `v` being of the same
+    length.
+    """
+    return _attention.apply(q, k, v, sm_scale, causal, None, None, None, None)
+
+
+def varlen_attention(q, k, v, cu_seqlens_q, cu_seqlens_k, max_seqlen_q, max_seqlen_k, sm_scale, causal=True):
+    """
+    Attention of the packed batches `q`, of shape (total_q, H, D_HEAD), and
+    `k` and `v`, of shape (total_k, H, D_HEAD). The sequences of the batch
+    are delimited by the int32 tensors `cu_seqlens_q` and `cu_seqlens_k`, and
+    `max_seqlen_q` and `max_seqlen_k` are their longest lengths.
+    """
+    return _attention.apply(q, k, v, sm_scale, causal, cu_seqlens_q, cu_seqlens_k, max_seqlen_q, max_seqlen_k)
+
+
+# ------------------------------------------------------------------------------
+# Decoding
+# ------------------------------------------------------------------------------
+
+@triton.jit
+def _decode_kernel(
+    Q, K, V, sm_scale,
+    Seqlens_k, O_split, LSE_split,
+    stride_qz, stride_qh, stride_qm, stride_qk,
+    stride_kz, stride_kh, stride_kn, stride_kk,
+    stride_vz, stride_vh, stride_vn, stride_vk,
+    H, seqlen_q, seqlen_k, keys_per_split,
+    BLOCK_DMODEL: tl.constexpr, HAS_SEQLENS: tl.constexpr,
+    BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr,
+):
+    split = tl.program_id(0)
+    off_hz = tl.program_id(1)
+    off_z = off_hz // H
+    off_h = off_hz % H
+    num_splits = tl.num_programs(0)
+    if HAS_SEQLENS:
+        seqlen_k = tl.load(Seqlens_k + off_z)
+    Q += off_z * stride_qz + off_h * stride_qh
+    K += off_z * stride_kz + off_h * stride_kh
+    V += off_z * stride_vz + off_h * stride_vh
+    offs_m = tl.arange(0, BLOCK_M)
+    offs_d = tl.arange(0, BLOCK_DMODEL)
+    q = tl.load(Q + offs_m[:, None] * stride_qm + offs_d[None, :] * stride_qk,
+                mask=offs_m[:, None] < seqlen_q, other=0.)
+    m_i = tl.zeros([BLOCK_M], dtype=tl.float32) - float("inf")
+    l_i = tl.zeros([BLOCK_M], dtype=tl.float32)
+    acc = tl.zeros([BLOCK_M, BLOCK_DMODEL], dtype=tl.float32)
+    # the keys of the split, none for the splits past the end of the sequence
+    lo = split * keys_per_split
+    hi = tl.minimum(lo + keys_per_split, seqlen_k)
+    acc, l_i, m_i = _attn_fwd_inner(acc, l_i, m_i, q, K, V, sm_scale,
+                                    stride_kn, stride_kk, stride_vn, stride_vk,
+                                    offs_m, lo, hi, seqlen_k,
+                                    BLOCK_N, BLOCK_DMODEL, False, True)
+    # partial outputs, normalized, and their logsumexp, -inf for empty splits
+    acc = acc / tl.where(l_i > 0., l_i, 1.)[:, None]
+    off_split = off_hz * num_splits + split
+    tl.store(LSE_split + off_split * BLOCK_M + offs_m, m_i + tl.log(l_i))
+    tl.store(O_split + (off_split * BLOCK_M + offs_m[:, None]) * BLOCK_DMODEL + offs_d[None, :], acc)
+
+
+@triton.jit
+def _decode_combine_kernel(
+    O_split, LSE_split, Out,
+    stride_oz, stride_oh, stride_om, stride_ok,
+    H, seqlen_q, num_splits,
+    BLOCK_DMODEL: tl.constexpr, BLOCK_M: tl.constexpr,
+):
+    off_hz = tl.program_id(0)
+    off_z = off_hz // H
+    off_h = off_hz % H
+    offs_m = tl.arange(0, BLOCK_M)
+    offs_d = tl.arange(0, BLOCK_DMODEL)
+    O_split += off_hz * num_splits * BLOCK_M * BLOCK_DMODEL
+    LSE_split += off_hz * num_splits * BLOCK_M
+    Out += off_z * stride_oz + off_h * stride_oh
+    # the first split holds keys, and the weights of the empty ones are zeros
+    m_i = tl.zeros([BLOCK_M], dtype=tl.float32) - float("inf")
+    l_i = tl.zeros([BLOCK_M], dtype=tl.float32)
+    acc = tl.zeros([BLOCK_M, BLOCK_DMODEL], dtype=tl.float32)
+    for split in range(0, num_splits):
+        lse = tl.load(LSE_split + split * BLOCK_M + offs_m)
+        o = tl.load(O_split + (split * BLOCK_M + offs_m[:, None]) * BLOCK_DMODEL + offs_d[None, :])
+        m_ij = tl.maximum(m_i, lse)
+        alpha = tl.exp(m_i - m_ij)
+        w = tl.exp(lse - m_ij)
+        l_i = l_i * alpha + w
+        acc = acc * alpha[:, None] + o * w[:, None]
+        m_i = m_ij
+    acc = acc / l_i[:, None]
+    tl.store(Out + offs_m[:, None] * stride_om + offs_d[None, :] * stride_ok, acc.to(Out.dtype.element_ty),
+             mask=offs_m[:, None] < seqlen_q)
 
 
-attention = _attention.apply
+def decode_attention(q, k, v, sm_scale, seqlens_k=None, num_splits=None):
+    """
+    Attention of a few queries `q`, of shape (Z, H, N_Q, D_HEAD) with
+    N_Q <= 16, to the keys and values `k` and `v` of a cache of shape
+    (Z, H, N_CTX, D_HEAD), of which the first `seqlens_k[z]` are valid (all
+    of them if `None`). The keys are split among `num_splits` programs per
+    head (enough to fill the device if `None`), whose partial outputs are
+    then combined.
+    """
+    BLOCK_M, BLOCK_N = 16, 64
+    Z, H, seqlen_q, Lk = q.shape
+    seqlen_k = k.shape[2]
+    assert seqlen_q <= BLOCK_M
+    assert Lk == k.shape[-1] and Lk == v.shape[-1] and Lk in {16, 32, 64, 128}
+    num_blocks = triton.cdiv(seqlen_k, BLOCK_N)
+    if num_splits is None:
+        num_sms = torch.cuda.get_device_properties(q.device).multi_processor_count
+        num_splits = triton.cdiv(2 * num_sms, Z * H)
+    num_splits = max(1, min(num_splits, num_blocks))
+    keys_per_split = triton.cdiv(num_blocks, num_splits) * BLOCK_N
+    num_splits = triton.cdiv(seqlen_k, keys_per_split)
+    o_split = torch.empty((Z * H, num_splits, BLOCK_M, Lk), device=q.device, dtype=torch.float32)
+    lse_split = torch.empty((Z * H, num_splits, BLOCK_M), device=q.device, dtype=torch.float32)
+    has_seqlens = seqlens_k is not None
+    if not has_seqlens:
+        seqlens_k = lse_split  # unused
+    _decode_kernel[(num_splits, Z * H)](
+        q, k, v, sm_scale,
+        seqlens_k, o_split, lse_split,
+        *_strides(q, False), *_strides(k, False), *_strides(v, False),
+        H, seqlen_q, seqlen_k, keys_per_split,
+        Lk, has_seqlens,
+        BLOCK_M=BLOCK_M, BLOCK_N=BLOCK_N, num_warps=4 if torch.version.hip is None else 2,
+    )
+    o = torch.empty_like(q)
+    _decode_combine_kernel[(Z * H,)](
+        o_split, lse_split, o,
+        *_strides(o, False),
+        H, seqlen_q, num_splits,
+        Lk, BLOCK_M=BLOCK_M,
+    )
+    return o
@@ -0,0 +1,152 @@
+"""
+Grouped Matrix Multiplication
+=============================
+C[g] = A[g] @ B[g] for a group of problems of different shapes (e.g., one per
+expert of a mixture of experts), in a single launch.
+
+The problems are described by a table in device memory, with a row per
+problem: the addresses of A, B and C, then M, N, K, then the strides of A, B
+and C. One program is launched per SM (CU on AMD GPUs), and the programs walk
+over the output tiles of all the problems with a stride of the number of
+programs, so that small problems do not leave the device idle.
+"""
+
+import torch
+
+import triton
+import triton.language as tl
+from .matmul_perf_model import early_config_prune, estimate_grouped_matmul_time
+
+# columns of the table of the problems:
+# A, B, C, M, N, K, stride_am, stride_ak, stride_bk, stride_bn, stride_cm, stride_cn
+DESC_SIZE = 12
+
+
+@triton.autotune(
+    configs=[
+        triton.Config({'BLOCK_M': 128, 'BLOCK_N': 128, 'BLOCK_K': 32}, num_stages=4, num_warps=4),
+        triton.Config({'BLOCK_M': 128, 'BLOCK_N': 64, 'BLOCK_K': 32}, num_stages=4, num_warps=4),
+        triton.Config({'BLOCK_M': 64, 'BLOCK_N': 128, 'BLOCK_K': 32}, num_stages=4, num_warps=4),
+        triton.Config({'BLOCK_M': 64, 'BLOCK_N': 64, 'BLOCK_K': 32}, num_stages=4, num_warps=4),
+        triton.Config({'BLOCK_M': 64, 'BLOCK_N': 64, 'BLOCK_K': 64}, num_stages=3, num_warps=4),
+        triton.Config({'BLOCK_M': 32, 'BLOCK_N': 64, 'BLOCK_K': 64}, num_stages=3, num_warps=2),
+        triton.Config({'BLOCK_M': 32, 'BLOCK_N': 32, 'BLOCK_K': 64}, num_stages=3, num_warps=2),
+        triton.Config({'BLOCK_M': 16, 'BLOCK_N': 64, 'BLOCK_K': 64}, num_stages=4, num_warps=2),
+    ],
+    key=['group_count', 'TOTAL_M', 'MAX_N', 'MAX_K'],
+    prune_configs_by={
+        'early_config_prune': early_config_prune,
+        'perf_model': estimate_grouped_matmul_time,
+        'top_k': 4
+    },
+)
+@triton.jit
+def _grouped_kernel(A, B, C, Desc, group_count, NUM_SMS,
+                    TOTAL_M, MAX_N, MAX_K,
+                    BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr,
+                    DESC_SIZE: tl.constexpr, ACC_TYPE: tl.constexpr
+                    ):
+    # A, B and C are those of the first problem, for their element types;
+    # TOTAL_M, MAX_N and MAX_K only key the autotuning
+    tile_id = tl.program_id(0)
+    tiles_end = 0
+    for g in range(0, group_count):
+        desc = Desc + g * DESC_SIZE
+        M = tl.load(desc + 3).to(tl.int32)
+        N = tl.load(desc + 4).to(tl.int32)
+        K = tl.load(desc + 5).to(tl.int32)
+        grid_n = (N + BLOCK_N - 1) // BLOCK_N
+        tiles_begin = tiles_end
+        tiles_end = tiles_begin + (M + BLOCK_M - 1) // BLOCK_M * grid_n
+        # the tiles of the problem the program walks over, if any
+        if tile_id < tiles_end:
+            pa_base = tl.load(desc + 0).to(A.dtype)
+            pb_base = tl.load(desc + 1).to(B.dtype)
+            pc_base = tl.load(desc + 2).to(C.dtype)
+            stride_am = tl.load(desc + 6)
+            stride_ak = tl.load(desc + 7)
+            stride_bk = tl.load(desc + 8)
+            stride_bn = tl.load(desc + 9)
+            stride_cm = tl.load(desc + 10)
+            stride_cn = tl.load(desc + 11)
+            while tile_id < tiles_end:
+                pid_m = (tile_id - tiles_begin) // grid_n
+                pid_n = (tile_id - tiles_begin) % grid_n
+                rm = pid_m * BLOCK_M + tl.arange(0, BLOCK_M)
+                rn = pid_n * BLOCK_N + tl.arange(0, BLOCK_N)
+                ram = tl.max_contiguous(tl.multiple_of(rm % M, BLOCK_M), BLOCK_M)
+                rbn = tl.max_contiguous(tl.multiple_of(rn % N, BLOCK_N), BLOCK_N)
+                rk = tl.arange(0, BLOCK_K)
+                # pointers
+                pa = pa_base + (ram[:, None] * stride_am + rk[None, :] * stride_ak)
+                pb = pb_base + (rk[:, None] * stride_bk + rbn[None, :] * stride_bn)
+                acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=ACC_TYPE)
+                for k in range(K, 0, -BLOCK_K):
+                    a = tl.load(pa, mask=rk[None, :] < k, other=0.)
+                    b = tl.load(pb, mask=rk[:, None] < k, other=0.)
+                    acc += tl.dot(a, b)
+                    pa += BLOCK_K * stride_ak
+                    pb += BLOCK_K * stride_bk
+                acc = acc.to(C.dtype.element_ty)
+                pc = pc_base + (rm[:, None] * stride_cm + rn[None, :] * stride_cn)
+                mask = (rm < M)[:, None] & (rn < N)[None, :]
+                tl.store(pc, acc, mask=mask)
+                tile_id += NUM_SMS
+
+
+class _grouped_matmul:
+    kernel = _grouped_kernel
+
+    @staticmethod
+    def make_desc(a, b, c):
+        """
+        The table of the problems C[g] = A[g] @ B[g], in device memory
+        """
+        rows = [[a_.data_ptr(), b_.data_ptr(), c_.data_ptr(),
+                 a_.shape[0], b_.shape[1], a_.shape[1],
+                 a_.stride(0), a_.stride(1), b_.stride(0), b_.stride(1), c_.stride(0), c_.stride(1)]
+                for a_, b_, c_ in zip(a, b, c)]
+        return torch.tensor(rows, dtype=torch.int64).to(a[0].device)
+
+    @staticmethod
+    def _call(a, b, desc=None, out=None):
+        assert len(a) == len(b) and len(a) > 0, "expected as many A as B matrices"
+        device = a[0].device
+        for a_, b_ in zip(a, b):
+            # checks constraints
+            assert a_.shape[1] == b_.shape[0], "incompatible dimensions"
+            assert a_.dtype == a[0].dtype and b_.dtype == a[0].dtype, "expected the same dtype for all matrices"
+        # allocates output
+        if out is None:
+            out = [torch.empty((a_.shape[0], b_.shape[1]), device=device, dtype=a_.dtype) for a_, b_ in zip(a, b)]
+        if desc is None:
+            desc = _grouped_matmul.make_desc(a, b, out)
+        # accumulator types
+        ACC_TYPE = tl.float32 if a[0].dtype in [torch.float16, torch.bfloat16, torch.float32] else tl.int32
+        # the autotuning is keyed on the total number of rows, rounded up not
+        # to tune again whenever the rows are distributed differently
+        total_m = triton.next_power_of_2(sum(a_.shape[0] for a_ in a))
+        max_n = max(b_.shape[1] for b_ in b)
+        max_k = max(a_.shape[1] for a_ in a)
+        # one program per SM (CU on AMD GPUs), never more than the number of tiles
+        num_sms = torch.cuda.get_device_properties(device).multi_processor_count
+
+        def grid(META):
+            num_tiles = sum(triton.cdiv(a_.shape[0], META['BLOCK_M']) * triton.cdiv(b_.shape[1], META['BLOCK_N'])
+                            for a_, b_ in zip(a, b))
+            return (max(1, min(num_sms, num_tiles)),)
+        _grouped_kernel[grid](a[0], b[0], out[0], desc, len(a), num_sms,
+                              total_m, max_n, max_k,
+                              DESC_SIZE=DESC_SIZE, ACC_TYPE=ACC_TYPE)
+        return out
+
+
+def grouped_matmul(a, b, desc=None, out=None):
+    """
+    C[g] = A[g] @ B[g] for the lists of matrices `a` and `b`, of shapes
+    (M[g], K[g]) and (K[g], N[g]). Returns the list of the C[g], or fills
+    `out` if given. `desc`, the table of the problems built by
+    `_grouped_matmul.make_desc(a, b, out)`, can be reused across calls on the
+    same tensors.
+    """
+    return _grouped_matmul._call(a, b, desc=desc, out=out)
@@ -64,9 +64,10 @@ def _kernel(A, B, C, M, N, K,
             stride_am, stride_ak,
             stride_bk, stride_bn,
             stride_cm, stride_cn,
+            Locks,
             BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr,
             GROUP_M: tl.constexpr, SPLIT_K: tl.constexpr, EVEN_K: tl.constexpr,
-            ACC_TYPE: tl.constexpr
+            ACC_TYPE: tl.constexpr, DETERMINISTIC: tl.constexpr
             ):
     # matrix multiplication
     pid = tl.program_id(0)
@@ -108,17 +109,111 @@ def _kernel(A, B, C, M, N, K,
     # handles write-back with reduction-splitting
     if SPLIT_K == 1:
         tl.store(C, acc, mask=mask)
+    elif DETERMINISTIC:
+        # the partial tiles are reduced in pid_z order: each program waits
+        # for its turn on the lock of the tile, accumulates into C and hands
+        # the lock over to the next one (the last one resets it to 0). The
+        # release of the lock makes the partial C visible to the acquire of
+        # the next program
+        Lock = Locks + pid
+        while tl.atomic_cas(Lock, pid_z, pid_z, sem='acquire', scope='gpu') != pid_z:
+            pass
+        if pid_z != 0:
+            acc += tl.load(C, mask=mask, volatile=True)
+        tl.store(C, acc, mask=mask)
+        tl.debug_barrier()
+        tl.atomic_xchg(Lock, (pid_z + 1) % SPLIT_K, sem='release', scope='gpu')
     else:
         tl.atomic_add(C, acc, mask=mask)
 
 
+def get_persistent_configs():
+    configs = []
+    for block_m, block_n, block_k, num_stages, num_warps in [
+        (128, 128, 32, 4, 4), (128, 64, 32, 4, 4), (64, 128, 32, 4, 4),
+        (64, 64, 32, 4, 4), (32, 64, 64, 3, 2), (32, 32, 64, 3, 2),
+    ]:
+        # tiles visited in grouped (GROUP_M > 1) or linear (GROUP_M == 1) order
+        for group_m in [1, 8]:
+            configs.append(triton.Config({'BLOCK_M': block_m, 'BLOCK_N': block_n, 'BLOCK_K': block_k,
+                                          'GROUP_M': group_m}, num_stages=num_stages, num_warps=num_warps))
+    return configs
+
+
+@triton.autotune(
+    configs=get_persistent_configs(),
+    key=['M', 'N', 'K'],
+)
+@triton.heuristics({
+    'EVEN_K': lambda args: args['K'] % args['BLOCK_K'] == 0,
+})
+@triton.jit
+def _persistent_kernel(A, B, C, M, N, K,
+                       stride_am, stride_ak,
+                       stride_bk, stride_bn,
+                       stride_cm, stride_cn,
+                       NUM_SMS,
+                       BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr,
+                       GROUP_M: tl.constexpr, EVEN_K: tl.constexpr,
+                       ACC_TYPE: tl.constexpr
+                       ):
+    # persistent matrix multiplication: NUM_SMS programs are launched and
+    # each of them walks over the output tiles with a stride of NUM_SMS
+    grid_m = (M + BLOCK_M - 1) // BLOCK_M
+    grid_n = (N + BLOCK_N - 1) // BLOCK_N
+    num_tiles = grid_m * grid_n
+    width = GROUP_M * grid_n
+    for tile_id in range(tl.program_id(0), num_tiles, NUM_SMS):
+        # grouped ordering of the tiles for better L2 performance
+        # (GROUP_M == 1 is the linear row-major order)
+        group_id = tile_id // width
+        group_size = min(grid_m - group_id * GROUP_M, GROUP_M)
+        pid_m = group_id * GROUP_M + (tile_id % group_size)
+        pid_n = (tile_id % width) // (group_size)
+        # do matrix multiplication
+        rm = pid_m * BLOCK_M + tl.arange(0, BLOCK_M)
+        rn = pid_n * BLOCK_N + tl.arange(0, BLOCK_N)
+        ram = tl.max_contiguous(tl.multiple_of(rm % M, BLOCK_M), BLOCK_M)
+        rbn = tl.max_contiguous(tl.multiple_of(rn % N, BLOCK_N), BLOCK_N)
+        rk = tl.arange(0, BLOCK_K)
+        # pointers
+        pa = A + (ram[:, None] * stride_am + rk[None, :] * stride_ak)
+        pb = B + (rk[:, None] * stride_bk + rbn[None, :] * stride_bn)
+        acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=ACC_TYPE)
+        for k in range(K, 0, -BLOCK_K):
+            if EVEN_K:
+                a = tl.load(pa)
+                b = tl.load(pb)
+            else:
+                a = tl.load(pa, mask=rk[None, :] < k, other=0.)
+                b = tl.load(pb, mask=rk[:, None] < k, other=0.)
+            acc += tl.dot(a, b)
+            pa += BLOCK_K * stride_ak
+            pb += BLOCK_K * stride_bk
+        acc = acc.to(C.dtype.element_ty)
+        pc = C + (rm[:, None] * stride_cm + rn[None, :] * stride_cn)
+        mask = (rm < M)[:, None] & (rn < N)[None, :]
+        tl.store(pc, acc, mask=mask)
+
+
 class _matmul(torch.autograd.Function):
     kernel = _kernel
+    persistent_kernel = _persistent_kernel
 
     _locks = dict()
 
     @staticmethod
-    def _call(a, b):
+    def _get_locks(device, num_tiles):
+        # one lock per output tile for deterministic split-k; locks are
+        # always released back to 0 so that they can be reused across calls
+        locks = _matmul._locks.get(device)
+        if locks is None or locks.numel() < num_tiles:
+            locks = torch.zeros(num_tiles, device=device, dtype=torch.int32)
+            _matmul._locks[device] = locks
+        return locks
+
+    @staticmethod
+    def _call(a, b, persistent, deterministic):
         device = a.device
         # handle non-contiguous inputs if necessary
         if a.stride(0) > 1 and a.stride(1) > 1:
@@ -134,17 +229,30 @@ class _matmul(torch.autograd.Function):
         # accumulator types
         ACC_TYPE = tl.float32 if a.dtype in [torch.float16, torch.bfloat16, torch.float32] else tl.int32
         # launch kernel
+        if persistent:
+            # one program per SM (CU on AMD GPUs), never more than the number of tiles
+            num_sms = torch.cuda.get_device_properties(device).multi_processor_count
+            grid = lambda META: (min(num_sms, triton.cdiv(M, META['BLOCK_M']) * triton.cdiv(N, META['BLOCK_N'])),)
+            _persistent_kernel[grid](a, b, c, M, N, K,
+                                     a.stride(0), a.stride(1),
+                                     b.stride(0), b.stride(1),
+                                     c.stride(0), c.stride(1),
+                                     num_sms, ACC_TYPE=ACC_TYPE)
+            return c
+        # enough locks for the smallest (16x16) tiles a dot can have
+        locks = _matmul._get_locks(device, triton.cdiv(M, 16) * triton.cdiv(N, 16)) if deterministic else None
         grid = lambda META: (triton.cdiv(M, META['BLOCK_M']) * triton.cdiv(N, META['BLOCK_N']), META['SPLIT_K'])
         _kernel[grid](a, b, c, M, N, K,
                       a.stride(0), a.stride(1),
                       b.stride(0), b.stride(1),
                       c.stride(0), c.stride(1),
-                      GROUP_M=8, ACC_TYPE=ACC_TYPE)
+                      locks,
+                      GROUP_M=8, ACC_TYPE=ACC_TYPE, DETERMINISTIC=deterministic)
         return c
 
     @staticmethod
-    def forward(ctx, a, b):
-        return _matmul._call(a, b)
+    def forward(ctx, a, b, persistent=False, deterministic=False):
+        return _matmul._call(a, b, persistent, deterministic)
 
 
 matmul = _matmul.apply
@@ -4,15 +4,27 @@ import torch
 
 import triton
 import triton._C.libtriton.triton as _triton
-from triton.testing import get_dram_gbps, get_max_simd_tflops, get_max_tensorcore_tflops
+from triton.testing import (_MFMA_OPS_PER_CU, _get_device_properties, get_dram_gbps, get_max_simd_tflops,
+                            get_max_tensorcore_tflops)
+
+# bytes per clock the shared memory (LDS on AMD GPUs) of a SM (CU) delivers
+SHARED_BYTES_PER_CLOCK = 128
+
+
+def is_hip():
+    return torch.version.hip is not None
+
+
+def get_num_sms(device):
+    ''' return the number of SMs (CUs on AMD GPUs), each of which has 4
+        sub-cores (SIMDs) running one warp (wavefront) at a time '''
+    return _get_device_properties(device)["multiprocessor_count"]
 
 
 def get_tensorcore_tflops(backend, device, num_ctas, num_warps, dtype):
     ''' return compute throughput in TOPS '''
     total_warps = num_ctas * min(num_warps, 4)
-    triton.compiler.init_cuda_utils()
-
-    num_subcores = triton.compiler.cuda_utils.get_device_properties(device)["multiprocessor_count"] * 4  # on recent GPUs
+    num_subcores = get_num_sms(device) * 4  # on recent GPUs
     tflops = min(num_subcores, total_warps) / num_subcores * get_max_tensorcore_tflops(dtype, backend, device)
     return tflops
 
@@ -20,25 +32,56 @@ def get_tensorcore_tflops(backend, device, num_ctas, num_warps, dtype):
 def get_simd_tflops(backend, device, num_ctas, num_warps, dtype):
     ''' return compute throughput in TOPS '''
     total_warps = num_ctas * min(num_warps, 4)
-    num_subcores = triton.compiler.cuda_utils.get_device_properties(device)["multiprocessor_count"] * 4  # on recent GPUs
+    num_subcores = get_num_sms(device) * 4  # on recent GPUs
     tflops = min(num_subcores, total_warps) / num_subcores * get_max_simd_tflops(dtype, backend, device)
     return tflops
 
 
 def get_tflops(backend, device, num_ctas, num_warps, dtype):
+    # the matrix cores of CDNA GPUs (MFMA) also compute in float32
     capability = torch.cuda.get_device_capability(device)
-    if capability[0] < 8 and dtype == torch.float32:
+    if not is_hip() and capability[0] < 8 and dtype == torch.float32:
         return get_simd_tflops(backend, device, num_ctas, num_warps, dtype)
     return get_tensorcore_tflops(backend, device, num_ctas, num_warps, dtype)
 
 
+def get_dram_bw(backend, device, num_ctas):
+    ''' return the DRAM bandwidth (in GB/s) num_ctas CTAs can draw '''
+    # on an A100 (108 SMs), 32 active CTAs get 95% of the bandwidth and the
+    # others the remaining 5%; other GPUs are assumed to scale with their SMs
+    num_sms = get_num_sms(device)
+    saturating_ctas = max(1, num_sms * 32 // 108)
+    active_cta_ratio_bw1 = min(1, num_ctas / saturating_ctas)
+    active_cta_ratio_bw2 = max(min(1, (num_ctas - saturating_ctas) / max(1, num_sms - saturating_ctas)), 0)
+    return get_dram_gbps(backend, device) * (active_cta_ratio_bw1 * 0.95 + active_cta_ratio_bw2 * 0.05)
+
+
+def estimate_shared_ms(device, num_ctas, num_warps, M, N, K, num_cta_m, num_cta_n, dtsize):
+    ''' return the time (in ms) to move the tiles through shared memory (LDS)
+
+    AMD GPUs have no asynchronous copy to LDS: the tiles are written to LDS
+    from registers, then read back by each of the wavefronts that need them,
+    those along N for A and those along M for B. The LDS of a CU then often
+    bounds small-K or narrow-tile configs. '''
+    if not is_hip():
+        return 0
+    clock_rate = _get_device_properties(device)["sm_clock_rate"]  # in kHz
+    active_sms = min(num_ctas, get_num_sms(device))
+    shared_gbps = active_sms * SHARED_BYTES_PER_CLOCK * clock_rate * 1e-6
+    warps_m = 2 ** (triton.next_power_of_2(num_warps).bit_length() // 2)
+    warps_n = max(1, num_warps // warps_m)
+    writes = (M * K * num_cta_n + N * K * num_cta_m) * dtsize
+    reads = (M * K * num_cta_n * warps_n + N * K * num_cta_m * warps_m) * dtsize
+    return (writes + reads) / (1024 * 1024) / shared_gbps
+
+
 def estimate_matmul_time(
     # backend, device,
     num_warps, num_stages,
     A, B, C,
     M, N, K,
     BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K,
-    debug=False, **kwargs
+    DETERMINISTIC=False, debug=False, **kwargs
 ):
     ''' return estimated running time in ms
           = max(compute, loading) + store '''
@@ -61,11 +104,9 @@ def estimate_matmul_time(
     compute_ms = total_ops / tput
 
     # time to load data
-    num_sm = triton.compiler.cuda_utils.get_device_properties(device)["multiprocessor_count"]
+    num_sm = get_num_sms(device)
     active_cta_ratio = min(1, num_ctas / num_sm)
-    active_cta_ratio_bw1 = min(1, num_ctas / 32)  # 32 active ctas are enough to saturate
-    active_cta_ratio_bw2 = max(min(1, (num_ctas - 32) / (108 - 32)), 0)  # 32-108, remaining 5%
-    dram_bw = get_dram_gbps(backend, device) * (active_cta_ratio_bw1 * 0.95 + active_cta_ratio_bw2 * 0.05)  # in GB/s
+    dram_bw = get_dram_bw(backend, device, num_ctas)  # in GB/s
     l2_bw = dram_bw * 4  # rough estimation (should be 4.7 for A100?)
     # assume 80% of (following) loads are in L2 cache
     load_a_dram = M * K * dtsize * (1 + 0.2 * (num_cta_n - 1))
@@ -77,6 +118,7 @@ def estimate_matmul_time(
     total_l2 = (load_a_l2 + load_b_l2) / (1024 * 1024)
     # loading time in ms
     load_ms = total_dram / dram_bw + total_l2 / l2_bw
+    shared_ms = estimate_shared_ms(device, num_ctas, num_warps, M, N, K, num_cta_m, num_cta_n, dtsize)
 
     # estimate storing time
     store_bw = dram_bw * 0.6  # :o
@@ -89,15 +131,73 @@ def estimate_matmul_time(
         # c.zero_()
         zero_ms = M * N * 2 / (1024 * 1024) / store_bw
         store_ms += zero_ms
+        if DETERMINISTIC:
+            # every split but the first one reads back the partial tile, and
+            # the splits of a tile are reduced one after the other
+            load_c_dram = M * N * dtsize * (SPLIT_K - 1) / (1024 * 1024)  # MB
+            lock_ms = 0.001  # ~1us to hand the lock over to the next split
+            store_ms += load_c_dram / dram_bw + (SPLIT_K - 1) * lock_ms
 
-    total_time_ms = max(compute_ms, load_ms) + store_ms
+    total_time_ms = max(compute_ms, load_ms, shared_ms) + store_ms
     if debug:
         print(f'Total time: {total_time_ms}ms, compute time: {compute_ms}ms, '
-              f'loading time: {load_ms}ms, store time: {store_ms}ms, '
+              f'loading time: {load_ms}ms, shared memory time: {shared_ms}ms, store time: {store_ms}ms, '
               f'Activate CTAs: {active_cta_ratio*100}%')
     return total_time_ms
 
 
+def estimate_grouped_matmul_time(
+    num_warps, num_stages,
+    A, Desc, NUM_SMS,
+    BLOCK_M, BLOCK_N, BLOCK_K,
+    debug=False, **kwargs
+):
+    ''' return estimated running time in ms of a persistent grouped matmul
+          = max(compute, loading) + store, over all the groups '''
+    backend = _triton.runtime.backend.CUDA
+    device = torch.cuda.current_device()
+    dtype = A.dtype
+    dtsize = A.element_size()
+    # (M, N, K) of the groups
+    sizes = Desc[:, 3:6].tolist()
+
+    tiles = [(triton.cdiv(M, BLOCK_M), triton.cdiv(N, BLOCK_N)) for M, N, _ in sizes]
+    num_tiles = sum(num_cta_m * num_cta_n for num_cta_m, num_cta_n in tiles)
+    num_ctas = max(1, min(NUM_SMS, num_tiles))
+    # the programs walk over the tiles in waves, the last one possibly partial
+    num_waves = triton.cdiv(num_tiles, num_ctas)
+    wave_efficiency = num_tiles / (num_waves * num_ctas) if num_tiles > 0 else 1
+
+    # time to compute, of the tiles padded to the block size
+    total_ops = sum(2 * num_cta_m * BLOCK_M * num_cta_n * BLOCK_N * K
+                    for (num_cta_m, num_cta_n), (_, _, K) in zip(tiles, sizes)) / (1024 * 1024 * 1024)  # GOPS
+    tput = get_tflops(backend, device, num_ctas, num_warps, dtype) * wave_efficiency
+    compute_ms = total_ops / tput
+
+    # time to load data, assuming as for one matmul that 80% of the
+    # (following) loads of a group are in L2 cache
+    dram_bw = get_dram_bw(backend, device, num_ctas)  # in GB/s
+    l2_bw = dram_bw * 4
+    total_dram, total_l2, store_c_dram, shared_ms = 0, 0, 0, 0
+    for (num_cta_m, num_cta_n), (M, N, K) in zip(tiles, sizes):
+        total_dram += (M * K * (1 + 0.2 * (num_cta_n - 1)) + N * K * (1 + 0.2 * (num_cta_m - 1))) * dtsize
+        total_l2 += (M * K * 0.8 * (num_cta_n - 1) + N * K * 0.8 * (num_cta_m - 1)) * dtsize
+        store_c_dram += M * N * dtsize
+        shared_ms += estimate_shared_ms(device, num_ctas, num_warps, M, N, K, num_cta_m, num_cta_n, dtsize)
+    load_ms = total_dram / (1024 * 1024) / dram_bw + total_l2 / (1024 * 1024) / l2_bw
+
+    # estimate storing time
+    store_bw = dram_bw * 0.6
+    store_ms = store_c_dram / (1024 * 1024) / store_bw
+
+    total_time_ms = max(compute_ms, load_ms, shared_ms) + store_ms
+    if debug:
+        print(f'Total time: {total_time_ms}ms, compute time: {compute_ms}ms, '
+              f'loading time: {load_ms}ms, shared memory time: {shared_ms}ms, store time: {store_ms}ms, '
+              f'Tiles: {num_tiles} in {num_waves} waves of {num_ctas} CTAs')
+    return total_time_ms
+
+
 def early_config_prune(configs, named_args):
     device = torch.cuda.current_device()
     capability = torch.cuda.get_device_capability()
@@ -112,24 +212,25 @@ def early_config_prune(configs, named_args):
         BLOCK_M, BLOCK_N, BLOCK_K, num_stages = \
             kw['BLOCK_M'], kw['BLOCK_N'], kw['BLOCK_K'], config.num_stages
 
-        # TODO: move to `cuda_utils` submodule
-        triton.compiler.init_cuda_utils()
-        max_shared_memory = triton.compiler.cuda_utils.get_device_properties(device)["max_shared_mem"]
+        max_shared_memory = _get_device_properties(device)["max_shared_mem"]
         required_shared_memory = (BLOCK_M + BLOCK_N) * BLOCK_K * num_stages * dtsize
         if required_shared_memory <= max_shared_memory:
             pruned_configs.append(config)
     configs = pruned_configs
 
-    # Some dtypes do not allow atomic_add
-    if dtype not in [torch.float16, torch.float32]:
-        configs = [config for config in configs if config.kwargs['SPLIT_K'] == 1]
+    # Some dtypes do not allow atomic_add (deterministic split-k does not use it)
+    split_k_dtypes = [torch.float16, torch.float32]
+    if named_args.get('Locks') is not None:
+        split_k_dtypes.append(torch.bfloat16)
+    if dtype not in split_k_dtypes:
+        configs = [config for config in configs if config.kwargs.get('SPLIT_K', 1) == 1]
 
     # group configs by (BLOCK_M,_N,_K, SPLIT_K, num_warps)
     configs_map = {}
     for config in configs:
         kw = config.kwargs
         BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, num_warps, num_stages = \
-            kw['BLOCK_M'], kw['BLOCK_N'], kw['BLOCK_K'], kw['SPLIT_K'], config.num_warps, config.num_stages
+            kw['BLOCK_M'], kw['BLOCK_N'], kw['BLOCK_K'], kw.get('SPLIT_K', 1), config.num_warps, config.num_stages
 
         key = (BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, num_warps)
         if key in configs_map:
@@ -140,7 +241,26 @@ def early_config_prune(configs, named_args):
     pruned_configs = []
     for k, v in configs_map.items():
         BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, num_warps = k
-        if capability[0] >= 8:
+        if is_hip():
+            # the accumulator is spread over the 64 lanes of the wavefronts;
+            # beyond 256 registers a lane, it spills
+            if BLOCK_M * BLOCK_N // (num_warps * 64) > 256:
+                continue
+            # compute cycles of the MFMAs of a stage, on the SIMDs of a CU
+            arch = triton.compiler.get_device_arch(device)
+            ops_per_cu = _MFMA_OPS_PER_CU.get(arch, {}).get(dtype, 1024)
+            mfma_cycles = 2 * BLOCK_M * BLOCK_N * BLOCK_K / ops_per_cu * 4 / min(4, num_warps)
+
+            global_load_latency = 500
+            optimal_num_stages = global_load_latency / mfma_cycles
+
+            # nearest stages, prefer large #stages
+            nearest = heapq.nsmallest(2, v, key=lambda x: 10 + abs(x[1] - optimal_num_stages)
+                                      if (x[1] - optimal_num_stages) < 0 else x[1] - optimal_num_stages)
+
+            for n in nearest:
+                pruned_configs.append(n[0])
+        elif capability[0] >= 8:
             # compute cycles (only works for ampere GPUs)
             mmas = BLOCK_M * BLOCK_N * BLOCK_K / (16 * 8 * 16)
             mma_cycles = mmas / min(4, num_warps) * 8
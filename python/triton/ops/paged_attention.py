@@ -0,0 +1,137 @@
+"""
+Paged Attention
+===============
+Decoding attention over a KV cache stored in fixed-size pages. The keys and
+values of the heads of all the sequences are pages of a shared pool, of shape
+(num_pages, H_KV, PAGE_SIZE, D_HEAD), and the pages of the sequence z are
+`block_table[z, 0], block_table[z, 1], ...`
+
+The H query heads are split in H_KV groups sharing the keys and values of a
+head: one for multi-query attention, H for multi-head attention, any divisor
+of H in between for grouped-query attention. A program attends the queries
+of all the heads of a group, so that the pages are loaded once per group.
+
+As in `decode_attention`, the pages of a sequence are split among programs,
+whose partial outputs are then combined by their logsumexp.
+"""
+
+import torch
+
+import triton
+import triton.language as tl
+
+from .flash_attention import _decode_combine_kernel, _strides
+
+
+@triton.jit
+def _paged_decode_kernel(
+    Q, K_cache, V_cache, sm_scale,
+    Block_table, Seqlens_k, O_split, LSE_split,
+    stride_qz, stride_qh, stride_qm, stride_qk,
+    stride_kp, stride_kh, stride_kn, stride_kk,
+    stride_vp, stride_vh, stride_vn, stride_vk,
+    stride_bz, stride_bp,
+    H_KV, seqlen_q, pages_per_split,
+    GROUP_SIZE: tl.constexpr, BLOCK_DMODEL: tl.constexpr,
+    BLOCK_M: tl.constexpr, PAGE_SIZE: tl.constexpr,
+):
+    split = tl.program_id(0)
+    off_hz = tl.program_id(1)
+    off_z = off_hz // H_KV
+    off_h = off_hz % H_KV
+    num_splits = tl.num_programs(0)
+    seqlen_k = tl.load(Seqlens_k + off_z)
+    offs_m = tl.arange(0, BLOCK_M)
+    offs_n = tl.arange(0, PAGE_SIZE)
+    offs_d = tl.arange(0, BLOCK_DMODEL)
+    # the rows are the queries of the heads of the group, head by head
+    q_head = off_h * GROUP_SIZE + offs_m // seqlen_q
+    q_pos = offs_m % seqlen_q
+    q_ptrs = Q + off_z * stride_qz + q_head[:, None] * stride_qh + q_pos[:, None] * stride_qm + offs_d[None, :] * stride_qk
+    q = tl.load(q_ptrs, mask=offs_m[:, None] < GROUP_SIZE * seqlen_q, other=0.)
+    K_cache += off_h * stride_kh
+    V_cache += off_h * stride_vh
+    Block_table += off_z * stride_bz
+    m_i = tl.zeros([BLOCK_M], dtype=tl.float32) - float("inf")
+    l_i = tl.zeros([BLOCK_M], dtype=tl.float32)
+    acc = tl.zeros([BLOCK_M, BLOCK_DMODEL], dtype=tl.float32)
+    # the pages of the split, none for the splits past the end of the sequence
+    lo = split * pages_per_split
+    hi = tl.minimum(lo + pages_per_split, (seqlen_k + PAGE_SIZE - 1) // PAGE_SIZE)
+    for p in range(lo, hi):
+        # the page is gathered through the block table; the pipeliner issues
+        # the load of its index ahead with those of the keys and values
+        page = tl.load(Block_table + p * stride_bp)
+        cols = p * PAGE_SIZE + offs_n
+        k_ptrs = K_cache + page * stride_kp + offs_n[None, :] * stride_kn + offs_d[:, None] * stride_kk
+        v_ptrs = V_cache + page * stride_vp + offs_n[:, None] * stride_vn + offs_d[None, :] * stride_vk
+        # -- compute qk ----
+        k = tl.load(k_ptrs, mask=cols[None, :] < seqlen_k, other=0.)
+        qk = tl.dot(q, k) * sm_scale
+        qk = tl.where(cols[None, :] < seqlen_k, qk, float("-inf"))
+        # -- update the running max and sum, the output being normalized last
+        m_ij = tl.maximum(m_i, tl.max(qk, 1))
+        alpha = tl.exp(m_i - m_ij)
+        p_ij = tl.exp(qk - m_ij[:, None])
+        l_i = l_i * alpha + tl.sum(p_ij, 1)
+        acc = acc * alpha[:, None]
+        v = tl.load(v_ptrs, mask=cols[:, None] < seqlen_k, other=0.)
+        acc += tl.dot(p_ij.to(V_cache.dtype.element_ty), v)
+        m_i = m_ij
+    # partial outputs, normalized, and their logsumexp, -inf for empty splits
+    acc = acc / tl.where(l_i > 0., l_i, 1.)[:, None]
+    off_split = off_hz * num_splits + split
+    tl.store(LSE_split + off_split * BLOCK_M + offs_m, m_i + tl.log(l_i))
+    tl.store(O_split + (off_split * BLOCK_M + offs_m[:, None]) * BLOCK_DMODEL + offs_d[None, :], acc)
+
+
+def paged_attention(q, k_cache, v_cache, block_table, seqlens_k, sm_scale, num_splits=None):
+    """
+    Attention of a few queries `q`, of shape (Z, H, N_Q, D_HEAD), to the
+    paged KV cache `k_cache` and `v_cache`, of shape
+    (num_pages, H_KV, PAGE_SIZE, D_HEAD) with H a multiple of H_KV. The keys
+    of the sequence z are the first `seqlens_k[z]` of its pages
+    `block_table[z]`, an int32 tensor of shape (Z, max_pages). The pages are
+    split among `num_splits` programs per group of heads (enough to fill the
+    device if `None`), whose partial outputs are then combined.
+    """
+    Z, H, seqlen_q, Lk = q.shape
+    _, H_KV, page_size, _ = k_cache.shape
+    assert k_cache.shape == v_cache.shape
+    assert Lk == k_cache.shape[-1] and Lk in {16, 32, 64, 128}
+    assert page_size >= 16 and page_size == triton.next_power_of_2(page_size)
+    assert H % H_KV == 0
+    assert block_table.dtype == torch.int32 and block_table.shape[0] == Z
+    group_size = H // H_KV
+    BLOCK_M = max(16, triton.next_power_of_2(group_size * seqlen_q))
+    assert BLOCK_M <= 64
+    max_pages = block_table.shape[1]
+    if num_splits is None:
+        num_sms = torch.cuda.get_device_properties(q.device).multi_processor_count
+        num_splits = triton.cdiv(2 * num_sms, Z * H_KV)
+    num_splits = max(1, min(num_splits, max_pages))
+    pages_per_split = triton.cdiv(max_pages, num_splits)
+    num_splits = triton.cdiv(max_pages, pages_per_split)
+    o_split = torch.empty((Z * H_KV, num_splits, BLOCK_M, Lk), device=q.device, dtype=torch.float32)
+    lse_split = torch.empty((Z * H_KV, num_splits, BLOCK_M), device=q.device, dtype=torch.float32)
+    _paged_decode_kernel[(num_splits, Z * H_KV)](
+        q, k_cache, v_cache, sm_scale,
+        block_table, seqlens_k, o_split, lse_split,
+        *_strides(q, False), *_strides(k_cache, False), *_strides(v_cache, False),
+        block_table.stride(0), block_table.stride(1),
+        H_KV, seqlen_q, pages_per_split,
+        group_size, Lk,
+        BLOCK_M=BLOCK_M, PAGE_SIZE=page_size,
+        num_warps=4 if torch.version.hip is None else 2, num_stages=3,
+    )
+    # the rows of a group are its heads, each of the queries of the head; in
+    # a contiguous output, they are consecutive rows of a group of heads
+    o = torch.empty(q.shape, device=q.device, dtype=q.dtype)
+    stride_oz, stride_oh, stride_om, stride_ok = _strides(o, False)
+    _decode_combine_kernel[(Z * H_KV,)](
+        o_split, lse_split, o,
+        stride_oz, stride_oh * group_size, stride_om, stride_ok,
+        H_KV, group_size * seqlen_q, num_splits,
+        Lk, BLOCK_M=BLOCK_M,
+    )
+    return o
@@ -0,0 +1,130 @@
+"""
+Single-Pass Scans
+=================
+Prefix sums and stream compaction of whole arrays in a single launch, with
+decoupled look-back.
+
+Each program scans its tile, publishes the sum of the tile in a status word
+and then walks back over the status words of the previous tiles, adding their
+sums until it finds one that holds the inclusive prefix of its tile. It then
+publishes its own inclusive prefix, so that the walks of the next tiles are
+short. A status word packs a flag in its high 32 bits and the bits of the
+value in its low ones, so that both are published by a single atomic: the
+writes release it and the reads acquire it.
+
+The tiles are numbered in the order in which their programs start, from an
+atomic counter, so that the tiles a program waits for always belong to
+programs that are running or done.
+"""
+
+import torch
+
+import triton
+import triton.language as tl
+
+# flags of the status words of the tiles
+_AGGREGATE = 1
+_PREFIX = 2
+
+
+@triton.jit
+def _add_combine(a, b):
+    return a + b
+
+
+@triton.jit
+def _pack(value, FLAG: tl.constexpr):
+    bits = value.to(tl.int32, bitcast=True).to(tl.uint32, bitcast=True).to(tl.int64)
+    return bits | (FLAG << 32)
+
+
+@triton.jit
+def _look_back(Status, tile, aggregate, AGGREGATE: tl.constexpr, PREFIX: tl.constexpr):
+    # returns the sum of the tiles before tile, whose own sum is aggregate
+    tl.atomic_xchg(Status + tile, _pack(aggregate, AGGREGATE), sem='release')
+    exclusive = aggregate - aggregate
+    j = tile - 1
+    while j >= 0:
+        status = tl.atomic_or(Status + j, 0, sem='acquire')
+        flag = status >> 32
+        value = status.to(tl.int32).to(aggregate.dtype, bitcast=True)
+        exclusive = tl.where(flag != 0, exclusive + value, exclusive)
+        # spin on the tile until it publishes something, stop at a prefix
+        j = tl.where(flag == PREFIX, -1, tl.where(flag == AGGREGATE, j - 1, j))
+    tl.atomic_xchg(Status + tile, _pack(exclusive + aggregate, PREFIX), sem='release')
+    return exclusive
+
+
+@triton.jit
+def _cumsum_kernel(X, Y, Status, Counter, N,
+                   BLOCK: tl.constexpr, AGGREGATE: tl.constexpr, PREFIX: tl.constexpr):
+    tile = tl.atomic_add(Counter, 1)
+    offs = tile * BLOCK + tl.arange(0, BLOCK)
+    mask = offs < N
+    x = tl.load(X + offs, mask=mask, other=0).to(Y.dtype.element_ty)
+    y = tl.associative_scan(x, 0, _add_combine)
+    exclusive = _look_back(Status, tile, tl.sum(x, 0), AGGREGATE, PREFIX)
+    tl.store(Y + offs, y + exclusive, mask=mask)
+
+
+@triton.jit
+def _compact_kernel(X, Keep, Y, Count, Status, Counter, N,
+                    BLOCK: tl.constexpr, AGGREGATE: tl.constexpr, PREFIX: tl.constexpr):
+    tile = tl.atomic_add(Counter, 1)
+    offs = tile * BLOCK + tl.arange(0, BLOCK)
+    mask = offs < N
+    keep = (tl.load(Keep + offs, mask=mask, other=0) != 0).to(tl.int32)
+    # positions of the kept elements in the tile
+    pos = tl.associative_scan(keep, 0, _add_combine) - keep
+    kept = tl.sum(keep, 0)
+    exclusive = _look_back(Status, tile, kept, AGGREGATE, PREFIX)
+    x = tl.load(X + offs, mask=mask)
+    tl.store(Y + exclusive + pos, x, mask=keep != 0)
+    tl.store(Count, exclusive + kept, mask=tile == tl.num_programs(0) - 1)
+
+
+def _scan_state(n, block, device):
+    num_tiles = triton.cdiv(n, block)
+    status = torch.zeros(num_tiles, device=device, dtype=torch.int64)
+    counter = torch.zeros(1, device=device, dtype=torch.int32)
+    return num_tiles, status, counter
+
+
+def cumsum(x, BLOCK=1024):
+    """
+    Returns the inclusive prefix sums of the 1D tensor :code:`x`, in a single launch. They are
+    accumulated in :code:`torch.int32` for integers of up to 32 bits, and in :code:`torch.float32`
+    for floating-point types, in an order that depends on the scheduling of the programs.
+    """
+    assert x.dim() == 1 and x.is_contiguous()
+    if x.dtype.is_floating_point:
+        assert x.dtype in (torch.float16, torch.bfloat16, torch.float32)
+        dtype = torch.float32
+    else:
+        assert x.dtype in (torch.int8, torch.int16, torch.int32, torch.uint8, torch.bool)
+        dtype = torch.int32
+    n = x.numel()
+    y = torch.empty(n, device=x.device, dtype=dtype)
+    if n == 0:
+        return y
+    num_tiles, status, counter = _scan_state(n, BLOCK, x.device)
+    _cumsum_kernel[(num_tiles,)](x, y, status, counter, n,
+                                 BLOCK=BLOCK, AGGREGATE=_AGGREGATE, PREFIX=_PREFIX)
+    return y
+
+
+def compact(x, keep, BLOCK=1024):
+    """
+    Returns the elements of the 1D tensor :code:`x` where :code:`keep` is non-zero, in their
+    order, computed in a single launch. Waits for the launch to return the number of elements.
+    """
+    assert x.dim() == 1 and x.is_contiguous() and keep.shape == x.shape and keep.is_contiguous()
+    n = x.numel()
+    y = torch.empty(n, device=x.device, dtype=x.dtype)
+    count = torch.zeros(1, device=x.device, dtype=torch.int32)
+    if n == 0:
+        return y
+    num_tiles, status, counter = _scan_state(n, BLOCK, x.device)
+    _compact_kernel[(num_tiles,)](x, keep, y, count, status, counter, n,
+                                  BLOCK=BLOCK, AGGREGATE=_AGGREGATE, PREFIX=_PREFIX)
+    return y[:count.item()]
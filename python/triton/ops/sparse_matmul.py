@@ -0,0 +1,111 @@
+"""
+2:4 Structured-Sparse Matrix Multiplication
+============================================
+C = A @ B where A is 2:4 structured-sparse: at most 2 elements of every group
+of 4 consecutive elements of a row of A are non-zero. A is stored compressed,
+as its (M, K / 2) non-zero values and their (M, K / 16) int16 positions, and
+the products are computed by the sparse tensor cores (mma.sp) of NVIDIA GPUs
+of compute capability 8.0 or more, at twice the rate of the dense ones.
+"""
+
+import torch
+
+import triton
+import triton.language as tl
+
+# positions (0, 1) in each of the 4 groups of 4 columns of an int16 of
+# metadata, for the values of the masked out rows and columns of A
+_PADDING_META = 0x4444
+
+
+def compress_2to4(a):
+    """
+    Returns the values and the metadata of the 2:4 structured-sparse matrix :code:`a`, for
+    :code:`tl.sparse_dot`. The 2 elements of largest magnitude of each group of 4 are kept.
+
+    :param a: Matrix of shape :code:`(M, K)`, :code:`K` being a multiple of 16.
+    :return: The kept values, of shape :code:`(M, K / 2)`, and their positions, of shape
+        :code:`(M, K / 16)` and type :code:`torch.int16`.
+    """
+    assert a.dim() == 2 and a.shape[1] % 16 == 0, "the columns of a must be a multiple of 16"
+    M, K = a.shape
+    groups = a.view(M, K // 4, 4)
+    idx = torch.topk(groups.abs(), 2, dim=-1).indices.sort(dim=-1).values
+    values = groups.gather(-1, idx).reshape(M, K // 2)
+    # the positions of the values of the group j of 16 columns are at the bits [4j, 4j + 4)
+    nibbles = (idx[..., 0] | (idx[..., 1] << 2)).to(torch.int32).view(M, K // 16, 4)
+    shifts = torch.arange(0, 16, 4, device=a.device, dtype=torch.int32)
+    meta = (nibbles << shifts).sum(dim=-1)
+    meta = torch.where(meta >= 1 << 15, meta - (1 << 16), meta).to(torch.int16)
+    return values.contiguous(), meta.contiguous()
+
+
+def decompress_2to4(values, meta):
+    """
+    Returns the dense matrix of the :code:`values` and :code:`meta` of :code:`compress_2to4`.
+    """
+    M, K = values.shape[0], 2 * values.shape[1]
+    shifts = torch.arange(0, 16, 4, device=meta.device, dtype=torch.int32)
+    nibbles = (meta.to(torch.int32)[..., None] >> shifts) & 0xf
+    idx = torch.stack([nibbles & 0x3, nibbles >> 2], dim=-1).view(M, K // 4, 2)
+    a = torch.zeros((M, K // 4, 4), device=values.device, dtype=values.dtype)
+    a.scatter_(-1, idx.long(), values.view(M, K // 4, 2))
+    return a.view(M, K)
+
+
+@triton.jit
+def _kernel(A, E, B, C, M, N, K,
+            stride_am, stride_ak,
+            stride_em, stride_ek,
+            stride_bk, stride_bn,
+            stride_cm, stride_cn,
+            BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr,
+            PADDING_META: tl.constexpr):
+    pid_m = tl.program_id(0)
+    pid_n = tl.program_id(1)
+    rm = pid_m * BLOCK_M + tl.arange(0, BLOCK_M)
+    rn = pid_n * BLOCK_N + tl.arange(0, BLOCK_N)
+    rka = tl.arange(0, BLOCK_K // 2)
+    rke = tl.arange(0, BLOCK_K // 16)
+    rkb = tl.arange(0, BLOCK_K)
+    acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=tl.float32)
+    for k in range(0, K, BLOCK_K):
+        ka = k // 2 + rka
+        ke = k // 16 + rke
+        kb = k + rkb
+        a = tl.load(A + rm[:, None] * stride_am + ka[None, :] * stride_ak,
+                    mask=(rm[:, None] < M) & (ka[None, :] < K // 2), other=0.)
+        e = tl.load(E + rm[:, None] * stride_em + ke[None, :] * stride_ek,
+                    mask=(rm[:, None] < M) & (ke[None, :] < K // 16), other=PADDING_META)
+        b = tl.load(B + kb[:, None] * stride_bk + rn[None, :] * stride_bn,
+                    mask=(kb[:, None] < K) & (rn[None, :] < N), other=0.)
+        acc += tl.sparse_dot(a, e, b)
+    acc = acc.to(C.dtype.element_ty)
+    mask = (rm[:, None] < M) & (rn[None, :] < N)
+    tl.store(C + rm[:, None] * stride_cm + rn[None, :] * stride_cn, acc, mask=mask)
+
+
+def sparse_matmul(values, meta, b):
+    """
+    Returns the product of the 2:4 structured-sparse matrix of :code:`values` and :code:`meta`,
+    as computed by :code:`compress_2to4`, and the dense matrix :code:`b`.
+    """
+    device = torch.cuda.current_device()
+    if torch.cuda.get_device_capability(device)[0] < 8:
+        raise RuntimeError("sparse_matmul needs the sparse tensor cores of compute capability 8.0 or more")
+    assert values.dtype == b.dtype and values.dtype in (torch.float16, torch.bfloat16)
+    assert meta.dtype == torch.int16
+    M, K = values.shape[0], 2 * values.shape[1]
+    N = b.shape[1]
+    assert b.shape[0] == K and meta.shape == (M, K // 16) and K % 32 == 0
+    c = torch.empty((M, N), device=b.device, dtype=b.dtype)
+    BLOCK_M, BLOCK_N, BLOCK_K = 64, 64, 64
+    grid = (triton.cdiv(M, BLOCK_M), triton.cdiv(N, BLOCK_N))
+    _kernel[grid](values, meta, b, c, M, N, K,
+                  values.stride(0), values.stride(1),
+                  meta.stride(0), meta.stride(1),
+                  b.stride(0), b.stride(1),
+                  c.stride(0), c.stride(1),
+                  BLOCK_M=BLOCK_M, BLOCK_N=BLOCK_N, BLOCK_K=BLOCK_K,
+                  PADDING_META=_PADDING_META, num_warps=4)
+    return c
@@ -1,11 +1,19 @@
-from .autotuner import Config, Heuristics, autotune, heuristics
-from .jit import JITFunction, KernelInterface, version_key
+from .autotuner import (Config, ConfigSpace, Heuristics, autotune, export_autotune_results, heuristics,
+                        import_autotune_results)
+from .jit import Grid, JITFunction, KernelInterface, version_key
+from .fuse import HorizontalFusion, fuse
 
 __all__ = [
     "Config",
+    "ConfigSpace",
     "Heuristics",
     "autotune",
+    "export_autotune_results",
+    "fuse",
+    "Grid",
     "heuristics",
+    "HorizontalFusion",
+    "import_autotune_results",
     "JITFunction",
     "KernelInterface",
     "version_key",
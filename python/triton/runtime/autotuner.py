@@ -1,24 +1,165 @@
 from __future__ import annotations
 
 import builtins
+import hashlib
+import inspect
+import itertools
+import json
+import math
+import multiprocessing
+import os
+import random
+import statistics
 import time
+from concurrent.futures import ProcessPoolExecutor
 from typing import Dict
 
-from ..compiler import OutOfResources
+import torch
+
+from .. import compiler
+from ..compiler import CacheManager, OutOfResources
 from ..testing import do_bench
-from .jit import KernelInterface
+from ..utils import MockTensor
+from .jit import JITFunction, KernelInterface
+from .occupancy import DeviceLimits, predicted_efficiency
+
+# compilation jobs of the current autotuning run, inherited by the forked
+# compile workers
+_compile_jobs = []
+
+
+def _compile_worker(i):
+    fn, kwargs = _compile_jobs[i]
+    metadata = compiler.compile(fn, **kwargs).metadata
+    return {"shared": metadata["shared"], "num_warps": metadata["num_warps"],
+            "live_registers": metadata.get("live_registers"),
+            "spills": metadata.get("static_analysis", dict()).get("spills")}
+
+
+# autotuners of this process, whose results are exported by
+# `export_autotune_results`
+_autotuners = []
+
+
+def _read_results(cache):
+    results = []
+    for filename in cache.list_files():
+        if filename.startswith("autotune-") and filename.endswith(".json") and cache.has_file(filename):
+            with open(cache._make_path(filename)) as f:
+                results.append(json.load(f))
+    return results
+
+
+def _result_filename(result):
+    return f"autotune-{hashlib.md5(result['key'].encode('utf-8')).hexdigest()}.json"
+
+
+def export_autotune_results(path):
+    '''
+    Write the persisted autotuning results of the kernels autotuned in this
+    process to a single file, which can be loaded into the cache of another
+    machine with `import_autotune_results`.
+    '''
+    results = dict()
+    for tuner in _autotuners:
+        cache = tuner._results_cache()
+        entries = _read_results(cache)
+        if entries:
+            results[cache.key] = entries
+    with open(path, "w") as f:
+        json.dump(results, f, indent=2)
+
+
+def import_autotune_results(path):
+    '''
+    Load a file written by `export_autotune_results` into the cache, so that
+    autotuned kernels pick their configs from it without benchmarking.
+    '''
+    with open(path) as f:
+        results = json.load(f)
+    for key, entries in results.items():
+        cache = CacheManager(key)
+        for result in entries:
+            cache.put(json.dumps(result), _result_filename(result), binary=False)
+
+
+class _ConfigTimer:
+    '''
+    Times the launches of the kernel of a config, one sample per launch. The
+    hooks, i.e. `reset_to_zero` and the `pre_hook` of the config, and the flush
+    of the L2 cache run outside of the timed region. The launch is replayed from
+    a CUDA/HIP graph when it can be captured, which removes the overhead of the
+    launches on the host from the measurements.
+    '''
+
+    def __init__(self, launch, hooks, flush_buffer, cuda_graph):
+        self.launch = launch
+        self.hooks = hooks
+        self.flush_buffer = flush_buffer
+        self.samples = []
+        # the kernel is compiled, and its caches allocated, outside of the capture
+        hooks()
+        launch()
+        torch.cuda.synchronize()
+        if cuda_graph:
+            graph = torch.cuda.CUDAGraph()
+            try:
+                with torch.cuda.graph(graph):
+                    launch()
+                self.launch = graph.replay
+            except RuntimeError:
+                torch.cuda.synchronize()
+        # warm-up
+        self.sample(1)
+        self.samples = []
+
+    def sample(self, n):
+        events = [(torch.cuda.Event(enable_timing=True), torch.cuda.Event(enable_timing=True)) for _ in range(n)]
+        for start, end in events:
+            self.hooks()
+            self.flush_buffer.zero_()
+            start.record()
+            self.launch()
+            end.record()
+        torch.cuda.synchronize()
+        self.samples += [start.elapsed_time(end) for start, end in events]
+
+    def median(self):
+        return statistics.median(self.samples)
+
+    def interval(self, z):
+        # confidence interval of the mean, in the normal approximation
+        mean = statistics.fmean(self.samples)
+        if len(self.samples) < 2:
+            return mean, mean
+        half_width = z * statistics.stdev(self.samples) / math.sqrt(len(self.samples))
+        return mean - half_width, mean + half_width
 
 
 class Autotuner(KernelInterface):
-    def __init__(self, fn, arg_names, configs, key, reset_to_zero, prune_configs_by: Dict = None):
+    def __init__(self, fn, arg_names, configs, key, reset_to_zero, prune_configs_by: Dict = None,
+                 tuning: Dict = None):
         '''
         :param prune_configs_by: a dict of functions that are used to prune configs, fields:
             'perf_model': performance model used to predicate running time with different configs, returns running time
             'top_k': number of configs to bench
             'prune_num_stages_by'(optional): a function used to prune num_stages. It take configs:List[Config] as its input, and returns pruned configs.
+            'min_occupancy'(optional): configs whose predicted efficiency is below this fraction of the best one are not benchmarked.
+            'max_spills'(optional): configs whose binary spills more registers than this are not benchmarked.
+        :param tuning: a dict of options of the benchmarks of the configs, fields:
+            'strategy': 'exhaustive' (default) benchmarks every config with `do_bench`, 'successive_halving'
+            benchmarks them in rounds, eliminating the slow ones after each round.
+            'eta'(optional): the fraction 1/eta of the configs kept after each round, 2 by default.
+            'samples'(optional): the number of samples of each config in the first round, 3 by default. Each
+            round takes eta times as many samples as the previous one.
+            'confidence'(optional): the level of the confidence intervals of the mean times, 0.99 by default.
+            Configs slower than the best one at this level are eliminated after each round.
+            'cuda_graph'(optional): whether the launches are replayed from CUDA/HIP graphs, True by default.
         '''
         if not configs:
             self.configs = [Config(dict(), num_warps=4, num_stages=2)]
+        elif isinstance(configs, ConfigSpace):
+            self.configs = configs.sample()
         else:
             self.configs = configs
         self.key_idx = [arg_names.index(k) for k in key]
@@ -35,16 +176,57 @@ class Autotuner(KernelInterface):
         self.arg_names = arg_names
         # prune configs
         if prune_configs_by:
-            perf_model, top_k = prune_configs_by['perf_model'], prune_configs_by['top_k']
-            if 'early_config_prune' in prune_configs_by:
-                early_config_prune = prune_configs_by['early_config_prune']
+            perf_model, top_k = prune_configs_by.get('perf_model'), prune_configs_by.get('top_k')
+            early_config_prune = prune_configs_by.get('early_config_prune')
+            min_occupancy = prune_configs_by.get('min_occupancy')
+            max_spills = prune_configs_by.get('max_spills')
         else:
-            perf_model, top_k, early_config_prune = None, None, None
+            perf_model, top_k, early_config_prune, min_occupancy, max_spills = None, None, None, None, None
         self.perf_model, self.configs_top_k = perf_model, top_k
         self.early_config_prune = early_config_prune
+        self.min_occupancy = min_occupancy
+        self.max_spills = max_spills
+        self.tuning = dict(tuning or dict())
+        strategy = self.tuning.setdefault('strategy', 'exhaustive')
+        if strategy not in ('exhaustive', 'successive_halving'):
+            raise ValueError(f"unknown tuning strategy {strategy!r}")
+        if self.tuning.get('eta', 2) <= 1:
+            raise ValueError("the eta of successive halving must be greater than 1")
         self.fn = fn
+        _autotuners.append(self)
 
-    def _bench(self, *args, config, **meta):
+    def _results_cache(self):
+        jit_fn = self.fn
+        while not isinstance(jit_fn, JITFunction):
+            jit_fn = jit_fn.fn
+        return CacheManager(hashlib.md5(f"{jit_fn.cache_key}-autotune".encode("utf-8")).hexdigest())
+
+    def _results_key(self, key):
+        return f"{compiler.get_device_arch(torch.cuda.current_device())}-{key}"
+
+    def _load_result(self, key):
+        # only configs that are still tuned over can be picked
+        results_key = self._results_key(key)
+        for result in _read_results(self._results_cache()):
+            if result["key"] != results_key:
+                continue
+            for config in self.configs:
+                try:
+                    if json.loads(json.dumps(config.to_dict())) == result["config"]:
+                        return config
+                except TypeError:
+                    continue
+        return None
+
+    def _store_result(self, key, config):
+        try:
+            result = json.loads(json.dumps({"key": self._results_key(key), "config": config.to_dict()}))
+        except TypeError:
+            # meta-parameters that cannot be serialized are not persisted
+            return
+        self._results_cache().put(json.dumps(result), _result_filename(result), binary=False)
+
+    def _launcher(self, args, config, meta):
         # check for conflicts, i.e. meta-parameters both provided
         # as kwargs and by the autotuner
         conflicts = meta.keys() & config.kwargs.keys()
@@ -56,29 +238,212 @@ class Autotuner(KernelInterface):
         # augment meta-parameters with tunable ones
         current = dict(meta, **config.kwargs)
 
-        def kernel_call():
+        def launch():
+            self.fn.run(*args, num_warps=config.num_warps, num_stages=config.num_stages,
+                        warp_specialize=config.warp_specialize, prefetch_width=config.prefetch_width,
+                        pid_order=config.pid_order, min_blocks_per_sm=config.min_blocks_per_sm,
+                        max_registers=config.max_registers, waves_per_eu=config.waves_per_eu,
+                        num_ctas=config.num_ctas, **current)
+
+        def hooks():
             if config.pre_hook:
                 config.pre_hook(self.nargs)
             self.hook(args)
-            self.fn.run(*args, num_warps=config.num_warps, num_stages=config.num_stages, **current)
+        return launch, hooks
+
+    def _bench(self, *args, config, **meta):
+        launch, hooks = self._launcher(args, config, meta)
+
+        def kernel_call():
+            hooks()
+            launch()
         try:
             return do_bench(kernel_call)
         except OutOfResources:
             return float('inf')
 
+    def _successive_halving(self, configs, compiled_configs, *args, **meta):
+        '''
+        Benchmarks the configs in rounds. After each round, the configs whose
+        confidence interval of the mean time lies above that of the best
+        config are eliminated, and of the others only the fastest 1/eta by
+        median time are kept. Each round takes eta times as many samples per
+        config as the previous one. Returns the last config standing and the
+        median times of all the configs, infinite for those not compiled.
+        '''
+        eta = self.tuning.get('eta', 2)
+        n_samples = self.tuning.get('samples', 3)
+        z = statistics.NormalDist().inv_cdf((1 + self.tuning.get('confidence', 0.99)) / 2)
+        cuda_graph = self.tuning.get('cuda_graph', True)
+        # shared by the timers, larger than the L2 cache
+        flush_buffer = torch.empty(int(256e6 // 4), dtype=torch.int, device='cuda')
+        timers = dict()
+        for config in compiled_configs:
+            launch, hooks = self._launcher(args, config, meta)
+            try:
+                timers[config] = _ConfigTimer(launch, hooks, flush_buffer, cuda_graph)
+            except OutOfResources:
+                pass
+        if not timers:
+            return configs[0], {config: float('inf') for config in configs}
+        alive = list(timers)
+        while True:
+            for config in alive:
+                timers[config].sample(n_samples)
+            if len(alive) == 1:
+                break
+            intervals = {config: timers[config].interval(z) for config in alive}
+            best_upper = builtins.min(upper for _, upper in intervals.values())
+            alive = [config for config in alive if intervals[config][0] <= best_upper]
+            alive.sort(key=lambda config: timers[config].median())
+            alive = alive[:builtins.max(1, math.ceil(len(alive) / eta))]
+            if len(alive) == 1:
+                break
+            n_samples = math.ceil(n_samples * eta)
+        timings = {config: timers[config].median() if config in timers else float('inf') for config in configs}
+        return alive[0], timings
+
+    def _precompile(self, configs, *args, **kwargs):
+        '''
+        Compile the kernels of the configs concurrently in a pool of forked
+        processes, which populate the on-disk cache, so that benchmarking
+        only has to load them. Returns the configs whose kernels fit in shared
+        memory, whose binaries spill at most `max_spills` registers when pruning
+        by spills, and whose predicted efficiency is at least `min_occupancy` of
+        the best one when pruning by occupancy. The number of workers is read from
+        `TRITON_AUTOTUNE_COMPILE_WORKERS` and defaults to the number of CPUs.
+        '''
+        global _compile_jobs
+        num_workers = int(os.environ.get("TRITON_AUTOTUNE_COMPILE_WORKERS", os.cpu_count() or 1))
+        if num_workers <= 1 or len(configs) <= 1 or JITFunction.cache_hook is not None or \
+                "fork" not in multiprocessing.get_all_start_methods():
+            return configs
+        jit_fn = self.fn
+        while not isinstance(jit_fn, JITFunction):
+            jit_fn = jit_fn.fn
+
+        # collect the compilation jobs of the configs that are not cached yet,
+        # through the cache hook of the launcher
+        jobs = []
+        pending = []
+
+        def collect_job(**hook_kwargs):
+            job = dict(hook_kwargs["compile"])
+            del job["key"]
+            jobs.append((jit_fn, job))
+            return True
+        JITFunction.cache_hook = collect_job
+        try:
+            for config in configs:
+                if kwargs.keys() & config.kwargs.keys():
+                    continue
+                num_jobs = len(jobs)
+                self.fn.run(*map(MockTensor.wrap_dtype, args), num_warps=config.num_warps,
+                            num_stages=config.num_stages, warp_specialize=config.warp_specialize,
+                            prefetch_width=config.prefetch_width, pid_order=config.pid_order,
+                            min_blocks_per_sm=config.min_blocks_per_sm, max_registers=config.max_registers,
+                            waves_per_eu=config.waves_per_eu, num_ctas=config.num_ctas, warmup=True, **kwargs,
+                            **config.kwargs)
+                if len(jobs) > num_jobs:
+                    pending.append(config)
+        finally:
+            JITFunction.cache_hook = None
+        if len(jobs) <= 1:
+            return configs
+
+        # the workers must not initialize the driver: pass the capability along
+        device = torch.cuda.current_device()
+        capability = torch.cuda.get_device_capability(device)
+        capability = capability[0] * 10 + capability[1]
+        _compile_jobs = [(fn, dict(job, cc=capability)) for fn, job in jobs]
+        resources = dict()
+        try:
+            with ProcessPoolExecutor(max_workers=builtins.min(num_workers, len(jobs)),
+                                     mp_context=multiprocessing.get_context("fork")) as pool:
+                futures = [pool.submit(_compile_worker, i) for i in range(len(jobs))]
+                for config, future in zip(pending, futures):
+                    try:
+                        resources[config] = future.result()
+                    except Exception:
+                        # compiled again, and reported, by the benchmark
+                        pass
+        finally:
+            _compile_jobs = []
+
+        if torch.version.hip is None:
+            compiler.init_cuda_utils()
+            max_shared = compiler.cuda_utils.get_device_properties(device)["max_shared_mem"]
+            configs = [config for config in configs
+                       if config not in resources or resources[config]["shared"] <= max_shared]
+        if self.max_spills is not None:
+            configs = self._prune_by_spills(configs, resources)
+        if self.min_occupancy is not None:
+            configs = self._prune_by_occupancy(configs, resources, device, kwargs)
+        return configs
+
+    def _prune_by_spills(self, configs, resources):
+        '''
+        Drops the compiled configs whose binary spills more than `max_spills`
+        registers, as reported by its static analysis, unless all of them do.
+        The configs that were not compiled or analyzed are kept.
+        '''
+        spills = {config: resources[config]["spills"] for config in configs
+                  if config in resources and resources[config]["spills"] is not None}
+        if not spills or builtins.min(spills.values()) > self.max_spills:
+            return configs
+        return [config for config in configs if spills.get(config, 0) <= self.max_spills]
+
+    def _prune_by_occupancy(self, configs, resources, device, kwargs):
+        '''
+        Drops the compiled configs whose efficiency predicted from their warps,
+        registers, shared memory and grid is below `min_occupancy` of the best
+        one. The configs that were not compiled are kept.
+        '''
+        limits = DeviceLimits.query(device)
+        grid = kwargs.get("grid")
+        efficiency = dict()
+        for config in configs:
+            if config not in resources:
+                continue
+            num_programs = None
+            if grid is not None:
+                config_grid = grid(dict(self.nargs, **kwargs, **config.kwargs)) if callable(grid) else grid
+                num_programs = 1
+                for dim in config_grid:
+                    num_programs *= dim
+            res = resources[config]
+            efficiency[config] = predicted_efficiency(limits, res["num_warps"], res["live_registers"],
+                                                      res["shared"], num_programs)
+        if not efficiency:
+            return configs
+        threshold = self.min_occupancy * builtins.max(efficiency.values())
+        return [config for config in configs if efficiency.get(config, threshold) >= threshold]
+
     def run(self, *args, **kwargs):
         self.nargs = dict(zip(self.arg_names, args))
         if len(self.configs) > 1:
             key = tuple(args[i] for i in self.key_idx)
+            if key not in self.cache:
+                config = self._load_result(key)
+                if config is not None:
+                    self.cache[key] = config
             if key not in self.cache:
                 # prune configs
                 pruned_configs = self.prune_configs(kwargs)
+                # compile the remaining ones concurrently before benchmarking
+                # them; those exceeding the resources of the device are skipped
+                compiled_configs = self._precompile(pruned_configs, *args, **kwargs)
                 bench_start = time.time()
-                timings = {config: self._bench(*args, config=config, **kwargs)
-                           for config in pruned_configs}
+                if self.tuning['strategy'] == 'successive_halving':
+                    best, timings = self._successive_halving(pruned_configs, compiled_configs, *args, **kwargs)
+                else:
+                    timings = {config: self._bench(*args, config=config, **kwargs) if config in compiled_configs
+                               else float('inf') for config in pruned_configs}
+                    best = builtins.min(timings, key=timings.get)
                 bench_end = time.time()
                 self.bench_time = bench_end - bench_start
-                self.cache[key] = builtins.min(timings, key=timings.get)
+                self.cache[key] = best
+                self._store_result(key, self.cache[key])
                 self.hook(args)
                 self.configs_timings = timings
             config = self.cache[key]
@@ -87,7 +452,11 @@ class Autotuner(KernelInterface):
         self.best_config = config
         if config.pre_hook is not None:
             config.pre_hook(self.nargs)
-        return self.fn.run(*args, num_warps=config.num_warps, num_stages=config.num_stages, **kwargs, **config.kwargs)
+        return self.fn.run(*args, num_warps=config.num_warps, num_stages=config.num_stages,
+                           warp_specialize=config.warp_specialize, prefetch_width=config.prefetch_width,
+                           pid_order=config.pid_order, min_blocks_per_sm=config.min_blocks_per_sm,
+                           max_registers=config.max_registers, waves_per_eu=config.waves_per_eu,
+                           num_ctas=config.num_ctas, **kwargs, **config.kwargs)
 
     def prune_configs(self, kwargs):
         pruned_configs = self.configs
@@ -108,11 +477,20 @@ class Autotuner(KernelInterface):
 
     def warmup(self, *args, **kwargs):
         self.nargs = dict(zip(self.arg_names, args))
-        for config in self.prune_configs(kwargs):
+        pruned_configs = self.prune_configs(kwargs)
+        self._precompile(pruned_configs, *args, **kwargs)
+        for config in pruned_configs:
             self.fn.warmup(
                 *args,
                 num_warps=config.num_warps,
                 num_stages=config.num_stages,
+                warp_specialize=config.warp_specialize,
+                prefetch_width=config.prefetch_width,
+                pid_order=config.pid_order,
+                min_blocks_per_sm=config.min_blocks_per_sm,
+                max_registers=config.max_registers,
+                waves_per_eu=config.waves_per_eu,
+                num_ctas=config.num_ctas,
                 **kwargs,
                 **config.kwargs,
             )
@@ -131,26 +509,155 @@ class Config:
     :ivar num_stages: the number of stages that the compiler should use when software-pipelining loops.
                        Mostly useful for matrix multiplication workloads on SM80+ GPUs.
     :type num_stages: int
+    :ivar warp_specialize: if `True`, pipelined loops are split into a producer warp group that issues the
+                           asynchronous copies and a consumer warp group that runs the dots. The kernel is
+                           then launched with `2 * num_warps` warps. Ignored on AMD GPUs.
+    :type warp_specialize: bool
+    :ivar prefetch_width: the K extent of the slices of dot operands prefetched from shared memory into
+                          registers. Must be a multiple of the K extent of the MMA instruction; inferred
+                          from the dot operand encoding if `None`.
+    :type prefetch_width: int
+    :ivar pid_order: the order in which the programs of a 2D grid are assigned to program ids, to improve
+                     L2 reuse: `"grouped"` or `("grouped", group_size)` groups `group_size` (default 8)
+                     rows and walks them column-major, `"hilbert"` follows a Hilbert curve on square grids
+                     of power of two side. Program ids are left as launched if `None`.
+    :type pid_order: str or tuple
+    :ivar min_blocks_per_sm: the number of programs that must fit on a multiprocessor: the registers of
+                             each thread are limited accordingly, and the excess is spilled. Trades registers
+                             for occupancy in memory-bound kernels. Unbounded if `None`.
+    :type min_blocks_per_sm: int
+    :ivar max_registers: the maximum number of registers (VGPRs on AMD GPUs) per thread. Unbounded if `None`.
+    :type max_registers: int
+    :ivar waves_per_eu: the minimum number of waves per SIMD the kernel must allow on AMD GPUs, derived from
+                        `min_blocks_per_sm` if `None`. Ignored on NVIDIA GPUs.
+    :type waves_per_eu: int
+    :ivar num_ctas: the number of consecutive programs along the first axis of the grid launched together
+                    in a thread block cluster on SM90+ GPUs. The tiles loaded in pipelined loops that all
+                    programs of a cluster provably load are fetched once, each program copying a part of
+                    them, and read from the shared memory of the others. The grid size along the first
+                    axis must be a multiple of it.
+    :type num_ctas: int
     :ivar pre_hook: a function that will be called before the kernel is called. Parameters of this
                     function are args.
     """
 
-    def __init__(self, kwargs, num_warps=4, num_stages=2, pre_hook=None):
+    def __init__(self, kwargs, num_warps=4, num_stages=2, warp_specialize=False, prefetch_width=None, pid_order=None,
+                 min_blocks_per_sm=None, max_registers=None, waves_per_eu=None, num_ctas=1,
+                 pre_hook=None):
         self.kwargs = kwargs
         self.num_warps = num_warps
         self.num_stages = num_stages
+        self.warp_specialize = warp_specialize
+        self.prefetch_width = prefetch_width
+        self.pid_order = pid_order
+        self.min_blocks_per_sm = min_blocks_per_sm
+        self.max_registers = max_registers
+        self.waves_per_eu = waves_per_eu
+        self.num_ctas = num_ctas
         self.pre_hook = pre_hook
 
+    def to_dict(self):
+        return {"kwargs": self.kwargs, "num_warps": self.num_warps, "num_stages": self.num_stages,
+                "warp_specialize": self.warp_specialize, "prefetch_width": self.prefetch_width,
+                "pid_order": self.pid_order, "min_blocks_per_sm": self.min_blocks_per_sm,
+                "max_registers": self.max_registers, "waves_per_eu": self.waves_per_eu,
+                "num_ctas": self.num_ctas}
+
     def __str__(self):
         res = []
         for k, v in self.kwargs.items():
             res.append(f'{k}: {v}')
         res.append(f'num_warps: {self.num_warps}')
         res.append(f'num_stages: {self.num_stages}')
+        if self.warp_specialize:
+            res.append('warp_specialize: True')
+        if self.prefetch_width is not None:
+            res.append(f'prefetch_width: {self.prefetch_width}')
+        if self.pid_order is not None:
+            res.append(f'pid_order: {self.pid_order}')
+        for bound in ("min_blocks_per_sm", "max_registers", "waves_per_eu"):
+            if getattr(self, bound) is not None:
+                res.append(f'{bound}: {getattr(self, bound)}')
+        if self.num_ctas != 1:
+            res.append(f'num_ctas: {self.num_ctas}')
         return ', '.join(res)
 
 
-def autotune(configs, key, prune_configs_by=None, reset_to_zero=None):
+class ConfigSpace:
+    """
+    A space of configs, given by the values of each of their fields, from which the auto-tuner samples
+    `num_samples` configs rather than enumerating all of them.
+    .. highlight:: python
+    .. code-block:: python
+        triton.ConfigSpace({'BLOCK_M': [32, 64, 128, 256], 'BLOCK_N': [32, 64, 128, 256], 'BLOCK_K': [32, 64]},
+                           num_warps=[4, 8], num_stages=[2, 3, 4, 5], num_samples=64,
+                           constraint=lambda config: config.kwargs['BLOCK_M'] * config.kwargs['BLOCK_N'] <= 128 * 256)
+    :param kwargs: a dict of the values of each meta-parameter.
+    :type kwargs: dict[Str, list]
+    :param num_samples: the number of configs sampled, all the configs of the space if it has fewer.
+    :type num_samples: int
+    :param constraint: a function of a :code:`triton.Config` that returns whether the config is valid.
+    :param seed: the seed of the sampling. The samples only depend on the space and the seed, so that the
+                 persisted results of the auto-tuner are found by later processes.
+    :type seed: int
+    :param options: the values of each of the other arguments of :code:`triton.Config`, e.g. `num_warps`,
+                    as a list, or a single value.
+    """
+
+    def __init__(self, kwargs, num_samples, constraint=None, seed=0, **options):
+        unknown = options.keys() - (inspect.signature(Config).parameters.keys() - {'kwargs'})
+        if unknown:
+            raise TypeError(f"unknown config fields: {', '.join(sorted(unknown))}")
+        self.names = list(kwargs)
+        self.fields = [list(values) for values in kwargs.values()]
+        self.options = list(options)
+        self.fields += [list(values) if isinstance(values, (list, tuple)) else [values]
+                        for values in options.values()]
+        self.num_samples = num_samples
+        self.constraint = constraint
+        self.seed = seed
+
+    def __len__(self):
+        return math.prod(len(values) for values in self.fields)
+
+    def _config(self, index):
+        # decodes the index of a config in the mixed radix of the fields
+        values = []
+        for field in reversed(self.fields):
+            index, i = divmod(index, len(field))
+            values.append(field[i])
+        values.reverse()
+        n = len(self.names)
+        return Config(dict(zip(self.names, values[:n])), **dict(zip(self.options, values[n:])))
+
+    def _indices(self, rng):
+        size = len(self)
+        if size <= 1 << 16:
+            yield from rng.sample(range(size), size)
+            return
+        # too large to be shuffled, sampled with rejection of the duplicates
+        seen = set()
+        for _ in range(16 * self.num_samples):
+            index = rng.randrange(size)
+            if index not in seen:
+                seen.add(index)
+                yield index
+
+    def sample(self):
+        """
+        Returns the sampled configs, at most `num_samples` of them.
+        """
+        rng = random.Random(self.seed)
+        configs = (self._config(index) for index in self._indices(rng))
+        if self.constraint is not None:
+            configs = filter(self.constraint, configs)
+        configs = list(itertools.islice(configs, self.num_samples))
+        if not configs:
+            raise ValueError("no valid config in the config space")
+        return configs
+
+
+def autotune(configs, key, prune_configs_by=None, reset_to_zero=None, tuning=None):
     """
     Decorator for auto-tuning a :code:`triton.jit`'d function.
     .. highlight:: python
@@ -169,19 +676,37 @@ def autotune(configs, key, prune_configs_by=None, reset_to_zero=None):
            This means that whatever value the kernel updates will be updated multiple times.
            To avoid this undesired behavior, you can use the `reset_to_zero` argument, which
            reset the value of the provided tensor to `zero` before running any configuration.
-    :param configs: a list of :code:`triton.Config` objects
-    :type configs: list[triton.Config]
+    :param configs: a list of :code:`triton.Config` objects, or a :code:`triton.ConfigSpace` to sample them from
+    :type configs: list[triton.Config] or triton.ConfigSpace
     :param key: a list of argument names whose change in value will trigger the evaluation of all provided configs.
     :type key: list[str]
     :param prune_configs_by: a dict of functions that are used to prune configs, fields:
         'perf_model': performance model used to predicate running time with different configs, returns running time
         'top_k': number of configs to bench
         'early_config_prune'(optional): a function used to do early prune (eg, num_stages). It take configs:List[Config] as its input, and returns pruned configs.
+        'min_occupancy'(optional): a fraction; once compiled, the configs whose efficiency predicted from their
+        occupancy is below this fraction of the best one are not benchmarked. See :code:`triton.runtime.occupancy`.
+        'max_spills'(optional): once compiled, the configs whose binary spills more registers than this, as reported
+        by :code:`metadata["static_analysis"]` of the compiled kernel, are not benchmarked.
     :param reset_to_zero: a list of argument names whose value will be reset to zero before evaluating any configs.
     :type reset_to_zero: list[str]
+    :param tuning: a dict of options of the benchmarks of the configs, fields:
+        'strategy': 'exhaustive' (default) benchmarks every config with :code:`triton.testing.do_bench`,
+        'successive_halving' benchmarks them in rounds, and eliminates the slow configs after each round,
+        which tunes over large spaces, e.g. sampled from a :code:`triton.ConfigSpace`, in a fraction of the time.
+        'eta'(optional): only the fastest 1/eta of the configs are kept after each round, 2 by default.
+        'samples'(optional): the number of timed launches of each config in the first round, 3 by default.
+        Each round takes eta times as many as the previous one.
+        'confidence'(optional): the level of the confidence intervals of the mean times, 0.99 by default.
+        The configs whose interval lies above that of the fastest config are eliminated after each round.
+        'cuda_graph'(optional): whether the launches are captured in a CUDA/HIP graph, and replayed, True by
+        default. The hooks of the configs and the flush of the L2 cache run outside of the timed launches.
+    :note: The best config of each key is persisted in the cache directory, per kernel source and device
+           architecture, and later processes pick it without benchmarking. The results can be shipped
+           to other machines with :code:`export_autotune_results` and :code:`import_autotune_results`.
     """
     def decorator(fn):
-        return Autotuner(fn, fn.arg_names, configs, key, reset_to_zero, prune_configs_by)
+        return Autotuner(fn, fn.arg_names, configs, key, reset_to_zero, prune_configs_by, tuning)
 
     return decorator
 
@@ -0,0 +1,119 @@
+from __future__ import annotations
+
+import hashlib
+import inspect
+import linecache
+
+import triton
+from ..impl import builtin
+from .jit import JITFunction, KernelInterface, jit, version_key
+
+
+@builtin
+def _call_body(fn, program_id, grid, *args, _builder=None, _generator=None):
+    # calls the body `fn` of a fused kernel as the program `program_id` of its
+    # own grid, numbered along axis 0 first
+    core, semantic = triton.language.core, triton.language.semantic
+    program_id = core._to_tensor(program_id, _builder)
+    g0, g1, g2 = [core._to_tensor(x, _builder) for x in grid]
+    g01 = semantic.mul(g0, g1, _builder)
+    program_ids = [semantic.mod(program_id, g0, _builder),
+                   semantic.mod(semantic.floordiv(program_id, g0, _builder), g1, _builder),
+                   semantic.floordiv(program_id, g01, _builder)]
+    return _generator.call_JitFunction(fn, args, dict(), program_ids=program_ids, num_programs=[g0, g1, g2])
+
+
+class HorizontalFusion(KernelInterface):
+    """
+    A kernel that runs several independent JIT functions in a single launch,
+    e.g. the small kernels of an optimizer step. Each function gets its own
+    range of programs, in which `tl.program_id` and `tl.num_programs` are those
+    of its own grid, and the shared memory of the kernel is the largest one of
+    the functions.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        fused = triton.fuse(kernel_a, kernel_b)
+        fused[(grid_a, grid_b)]((x, y, n), dict(z=z, n=m, BLOCK=256), num_warps=4)
+
+    Each function is given a tuple of positional arguments or a dict of
+    keyword arguments, and a grid, a tuple or a callable of the dict of its
+    arguments. All the functions run with the same `num_warps` and launch
+    options.
+    """
+
+    def __init__(self, *fns):
+        assert len(fns) > 0, "no function to fuse"
+        for fn in fns:
+            if not isinstance(fn, JITFunction):
+                raise TypeError(f"{fn!r} is not a @triton.jit function")
+        self.fns = fns
+        self.fn = self._make_kernel()
+
+    @staticmethod
+    def _arg_name(i, name):
+        return f"a{i}_{name}"
+
+    def _make_kernel(self):
+        params = []
+        do_not_specialize = []
+        body = ["    hf_pid = tl.program_id(0)"]
+        for i, fn in enumerate(self.fns):
+            args = []
+            for j, name in enumerate(fn.arg_names):
+                arg = self._arg_name(i, name)
+                params.append(f"{arg}: tl.constexpr" if j in fn.constexprs else arg)
+                args.append(arg)
+            # the programs [hf_start_i, hf_start_i + hf_grid_i_0 * hf_grid_i_1 * hf_grid_i_2)
+            # run fn
+            hf = [f"hf_start_{i}"] + [f"hf_grid_{i}_{axis}" for axis in range(3)]
+            params += hf
+            do_not_specialize += hf
+            start, g0, g1, g2 = hf
+            keyword = "if" if i == 0 else "elif"
+            body += [f"    {keyword} hf_pid < {start} + {g0} * {g1} * {g2}:",
+                     f"        _call_body(_body_{i}, hf_pid - {start}, ({g0}, {g1}, {g2}), {', '.join(args)})"]
+        name = "fused_" + "_".join(fn.__name__ for fn in self.fns)
+        src = "\n".join([f"def {name}({', '.join(params)}):"] + body) + "\n"
+        # inspect.getsource, which JITFunction uses, finds the source in linecache
+        key = hashlib.md5("".join([src] + [fn.cache_key for fn in self.fns]).encode("utf-8")).hexdigest()
+        filename = f"<triton-fused-{key}>"
+        linecache.cache[filename] = (len(src), None, src.splitlines(True), filename)
+        scope = {"tl": triton.language, "_call_body": _call_body, "__name__": __name__}
+        scope.update({f"_body_{i}": fn for i, fn in enumerate(self.fns)})
+        exec(compile(src, filename, "exec", dont_inherit=True), scope)
+        kernel = jit(scope[name], do_not_specialize=do_not_specialize)
+        # the generic dependency hash does not see the bodies, which are only
+        # arguments of `_call_body`
+        kernel.hash = key + version_key()
+        return kernel
+
+    def run(self, *args, grid, **kwargs):
+        if len(args) != len(self.fns) or len(grid) != len(self.fns):
+            raise ValueError(f"expected the arguments and the grids of {len(self.fns)} functions")
+        fused_args = dict()
+        start = 0
+        for i, (fn, fn_args, fn_grid) in enumerate(zip(self.fns, args, grid)):
+            signature = inspect.signature(fn.fn)
+            bound = signature.bind(**fn_args) if isinstance(fn_args, dict) else signature.bind(*fn_args)
+            bound.apply_defaults()
+            if callable(fn_grid):
+                fn_grid = fn_grid(bound.arguments)
+            fn_grid = tuple(fn_grid) + (1,) * (3 - len(fn_grid))
+            for name, value in bound.arguments.items():
+                fused_args[self._arg_name(i, name)] = value
+            fused_args[f"hf_start_{i}"] = start
+            for axis in range(3):
+                fused_args[f"hf_grid_{i}_{axis}"] = fn_grid[axis]
+            start += fn_grid[0] * fn_grid[1] * fn_grid[2]
+        if start == 0:
+            return None
+        return self.fn.run(**fused_args, grid=(start,), **kwargs)
+
+
+def fuse(*fns):
+    """
+    Returns a `HorizontalFusion` of the JIT functions `fns`.
+    """
+    return HorizontalFusion(*fns)
@@ -7,12 +7,15 @@ import inspect
 import os
 import subprocess
 import textwrap
+import threading
 from collections import defaultdict, namedtuple
-from typing import Callable, Generic, Iterable, Optional, TypeVar, Union, cast, overload
+from concurrent.futures import ThreadPoolExecutor
+from typing import Callable, Dict, Generic, Iterable, Optional, TypeVar, Union, cast, overload
 
 import torch
 
 import triton
+import triton._C.libtriton.triton as _triton
 from triton.utils import MockTensor
 
 try:
@@ -20,14 +23,39 @@ try:
 except ImportError:
     get_cuda_stream = lambda dev_idx: torch.cuda.current_stream(dev_idx).cuda_stream
 
+try:
+    from torch._C import _cuda_getDevice as get_current_device
+except ImportError:
+    get_current_device = torch.cuda.current_device
+
+# the device made current by the last launch of each thread
+_launch_state = threading.local()
+
+
+def current_device():
+    """
+    The current device of the calling thread. It is made current for the
+    driver by the first launch of the thread, and whenever it changes.
+    """
+    device = get_current_device()
+    if getattr(_launch_state, "device", None) != device:
+        torch.cuda.set_device(device)
+        _launch_state.device = device
+    return device
+
 
 T = TypeVar('T')
 
+# fp8 dtypes of the torch builds that have them
+_torch_fp8_types = {getattr(torch, name): ty
+                    for name, ty in [('float8_e4m3fn', 'fp8e4'), ('float8_e5m2', 'fp8e5')]
+                    if hasattr(torch, name)}
+
+
 # -----------------------------------------------------------------------------
 # Dependencies Finder
 # -----------------------------------------------------------------------------
 
-
 class DependenciesFinder(ast.NodeVisitor):
     """
     This AST visitor is used to find dependencies of a JITFunction. This can
@@ -98,6 +126,13 @@ def version_key():
     return '-'.join(triton.__version__) + '-' + ptxas_version + '-' + '-'.join(contents)
 
 
+@functools.lru_cache()
+def async_compile_executor():
+    # background compilations run one at a time, as the backends modify
+    # global LLVM options
+    return ThreadPoolExecutor(max_workers=1, thread_name_prefix="triton-compile")
+
+
 class KernelInterface(Generic[T]):
     run: T
 
@@ -110,6 +145,32 @@ class KernelInterface(Generic[T]):
         return cast(T, functools.partial(cast(Callable, self.run), grid=grid))
 
 
+class Grid:
+    """
+    A launch grid computed by `fn` from the arguments named in `key`, cached by
+    their values: `fn` is only called for new values. It takes the arguments of
+    the launch as a dict, like the other grid callables, but must not depend on
+    the arguments missing from `key`.
+    """
+
+    # grids kept before the cache is cleared
+    max_size = 4096
+
+    def __init__(self, fn, key):
+        self.fn = fn
+        self.key = tuple(key)
+        self.cache = dict()
+
+    def __call__(self, args):
+        key = tuple(args[name] for name in self.key)
+        grid = self.cache.get(key)
+        if grid is None:
+            if len(self.cache) >= Grid.max_size:
+                self.cache.clear()
+            grid = self.cache[key] = tuple(self.fn(args))
+        return grid
+
+
 class JITFunction(KernelInterface[T]):
 
     # Hook for inspecting compiled functions and modules
@@ -146,6 +207,15 @@ class JITFunction(KernelInterface[T]):
             return (arg % 16 == 0, arg == 1)
         return (arg is None, )
 
+    @staticmethod
+    def _bucket_of(value, policy):
+        # constexpr values are compiled for the upper bound of their bucket
+        if not isinstance(value, int) or isinstance(value, bool) or value <= 0:
+            return value
+        if policy == "pow2":
+            return 1 << (value - 1).bit_length()
+        return -(-value // policy) * policy
+
     def _get_config(self, *args):
         def is_divisible_by_16(x):
             if hasattr(x, "data_ptr"):
@@ -155,9 +225,24 @@ class JITFunction(KernelInterface[T]):
             if x is None:
                 return True
             return False
-        divisible_by_16 = {i for i, arg in enumerate(args) if is_divisible_by_16(arg) and i not in self.do_not_specialize}
-        equal_to_1 = {i for i, arg in enumerate(args) if isinstance(arg, int) and arg == 1 and i not in self.do_not_specialize}
-        return namedtuple("instance_descriptor", ["divisible_by_16", "equal_to_1"])(tuple(divisible_by_16), tuple(equal_to_1))
+
+        def value_of(x):
+            return x.data_ptr() if hasattr(x, "data_ptr") else x
+        # arguments bucketed by divisibility are only specialized on it
+        divisibility = {(i, self.divisibility_buckets[i]) for i, arg in enumerate(args) if i in self.divisibility_buckets
+                        and isinstance(value_of(arg), int) and value_of(arg) % self.divisibility_buckets[i] == 0}
+        not_specialized = self.do_not_specialize | self.divisibility_buckets.keys()
+        # pointers are checked at runtime by versioned kernels instead
+        version_alignment = {i for i, arg in enumerate(args) if self.version_alignment and hasattr(arg, "data_ptr")
+                             and i not in not_specialized}
+        divisible_by_16 = {i for i, arg in enumerate(args) if is_divisible_by_16(arg) and i not in not_specialized
+                           and i not in version_alignment}
+        equal_to_1 = {i for i, arg in enumerate(args) if isinstance(arg, int) and arg == 1 and i not in not_specialized}
+        noalias = {i for i, arg in enumerate(args) if i in self.restrict and hasattr(arg, "data_ptr")}
+        return namedtuple("instance_descriptor", ["divisible_by_16", "equal_to_1", "version_alignment", "divisibility",
+                                                  "noalias"])(
+            tuple(divisible_by_16), tuple(equal_to_1), tuple(version_alignment), tuple(sorted(divisibility)),
+            tuple(sorted(noalias)))
         # return _triton.code_gen.instance_descriptor(divisible_by_16, equal_to_1)
 
     @staticmethod
@@ -174,12 +259,15 @@ class JITFunction(KernelInterface[T]):
                 torch.int16: 'i16',
                 torch.int32: 'i32',
                 torch.int64: 'i64',
+                **_torch_fp8_types,
 
                 triton.language.uint8: 'u8',
                 triton.language.uint16: 'u16',
                 triton.language.uint32: 'u32',
                 triton.language.uint64: 'u64',
                 triton.language.float8: 'fp8',
+                triton.language.float8e4: 'fp8e4',
+                triton.language.float8e5: 'fp8e5',
                 triton.language.float16: 'fp16',
                 triton.language.bfloat16: 'bf16',
                 triton.language.float32: 'fp32',
@@ -198,7 +286,7 @@ class JITFunction(KernelInterface[T]):
         constants = dict(zip(self.constexprs, constexpr_key))
         return constants
 
-    def _call_hook(self, key, signature, device, constants, num_warps, num_stages, extern_libs, configs):
+    def _call_hook(self, key, signature, device, constants, num_warps, num_stages, warp_specialize, prefetch_width, pid_order, min_blocks_per_sm, max_registers, waves_per_eu, num_ctas, extern_libs, configs):
         if JITFunction.cache_hook is None:
             return False
         name = self.fn.__name__
@@ -214,38 +302,108 @@ class JITFunction(KernelInterface[T]):
                 pass
 
         kwargs = dict(signature=signature, device=device, constants=constants,
-                      num_warps=num_warps, num_stages=num_stages, extern_libs=extern_libs,
+                      num_warps=num_warps, num_stages=num_stages, warp_specialize=warp_specialize,
+                      prefetch_width=prefetch_width, pid_order=pid_order, min_blocks_per_sm=min_blocks_per_sm,
+                      max_registers=max_registers, waves_per_eu=waves_per_eu, num_ctas=num_ctas, extern_libs=extern_libs,
                       configs=configs)
 
         return JITFunction.cache_hook(key=key, repr=repr, fn=LegacyCompiler(module, name), compile={"key": key, **kwargs}, is_manual_warmup=False, already_compiled=False)
 
+    @staticmethod
+    def _wrap_key(key, extern_libs, warp_specialize, prefetch_width, pid_order, min_blocks_per_sm, max_registers,
+                  waves_per_eu, num_ctas):
+        # non-default compilation options are appended to the cache key
+        if extern_libs is not None:
+            key = (key, tuple(extern_libs.items()))
+        if warp_specialize:
+            key = (key, warp_specialize)
+        if prefetch_width is not None:
+            key = (key, prefetch_width)
+        if pid_order is not None:
+            key = (key, "pid_order", pid_order)
+        if (min_blocks_per_sm, max_registers, waves_per_eu) != (None, None, None):
+            key = (key, "launch_bounds", min_blocks_per_sm, max_registers, waves_per_eu)
+        if num_ctas != 1:
+            key = (key, "num_ctas", num_ctas)
+        return key
+
+    @staticmethod
+    def _generic_spec(spec_key):
+        # specialization key of the variant valid for any argument value
+        return tuple(tuple(False for _ in spec) if isinstance(spec, tuple) else False for spec in spec_key)
+
+    def _compile_async(self, device, key, generic_key, **kwargs):
+        """
+        Compiles the variant of `key` on the background thread, and returns the
+        variant valid for any argument value to launch until it is ready, or
+        None if `key` is this variant.
+        """
+        if key == generic_key:
+            return None
+        cache = self.cache[device]
+        future = self.pending.get((device, key))
+        if future is not None and future.done():
+            # the specialized variant is ready, or its compilation failed
+            self.pending.pop((device, key), None)
+            cache[key] = future.result()
+            return cache[key]
+        if future is not None and generic_key in cache:
+            return cache[generic_key]
+        capability = torch.cuda.get_device_capability(device)
+        kwargs.update(device=device, cc=capability[0] * 10 + capability[1])
+        executor = async_compile_executor()
+        if generic_key not in cache:
+            config = kwargs["configs"][0]
+            generic = triton.compiler.instance_descriptor(version_alignment=config.version_alignment,
+                                                          noalias=config.noalias)
+            constants = {i: c for i, c in kwargs["constants"].items() if i not in config.equal_to_1}
+            generic_kwargs = dict(kwargs, configs=(generic,), constants=constants)
+            cache[generic_key] = executor.submit(triton.compile, self, **generic_kwargs).result()
+        if future is None:
+            def install(future):
+                # the launcher switches to the specialized variant once it
+                # is in the cache
+                if future.exception() is None:
+                    cache[key] = future.result()
+                    self.pending.pop((device, key), None)
+            future = executor.submit(triton.compile, self, **kwargs)
+            self.pending[(device, key)] = future
+            future.add_done_callback(install)
+        return cache[generic_key]
+
     def _make_launcher(self):
         regular_args = [f'{arg}' for i, arg in enumerate(self.arg_names) if i not in self.constexprs]
-        constexpr_args = [f'{arg}' for i, arg in enumerate(self.arg_names) if i in self.constexprs]
         args = ', '.join(regular_args)
         # cache key for regular argument type
         sig_keys = ', '.join([f'_key_of({arg})' for arg in regular_args])
-        # cache key for constexpr argument values
-        constexpr_keys = ', '.join(constexpr_args)
+        # cache key for constexpr argument values, mapped to their buckets
+        constexpr_keys = ', '.join([f'_bucket_of({arg}, {self.constexpr_buckets[i]!r})' if i in self.constexpr_buckets
+                                    else arg for i, arg in enumerate(self.arg_names) if i in self.constexprs])
         # cache key for argument specialization
         specializations = []
+        # versioned kernels check the alignment of their pointers at runtime
+        ptr_spec = '(True,)' if self.version_alignment else f'({{arg}}.data_ptr() % {JITFunction.divisibility} == 0)'
         for i, arg in enumerate(regular_args):
             if i in self.do_not_specialize:
                 continue
-            specializations += [f'({arg}.data_ptr() % {JITFunction.divisibility} == 0) if hasattr({arg}, "data_ptr") '
+            divisibility = self.divisibility_buckets.get(self.arg_names.index(arg))
+            if divisibility is not None:
+                specializations += [f'({arg}.data_ptr() % {divisibility} == 0,) if hasattr({arg}, "data_ptr") '
+                                    f'else ({arg} % {divisibility} == 0,) if isinstance({arg}, int) '
+                                    f'else (False,)']
+                continue
+            specializations += [f'{ptr_spec.format(arg=arg)} if hasattr({arg}, "data_ptr") '
                                 f'else ({arg} % {JITFunction.divisibility} == 0, {arg} == 1) if isinstance({arg}, int) '
                                 f'else (False,)']
         spec_keys = ', '.join(specializations)
         grid_args = ','.join([f'"{arg}": {arg}' for arg in self.arg_names])
 
         src = f"""
-def {self.fn.__name__}({', '.join(self.arg_names)}, grid, num_warps=4, num_stages=3, extern_libs=None, stream=None, warmup=False):
+def {self.fn.__name__}({', '.join(self.arg_names)}, grid, num_warps=4, num_stages=3, warp_specialize=False, prefetch_width=None, pid_order=None, min_blocks_per_sm=None, max_registers=None, waves_per_eu=None, num_ctas=1, extern_libs=None, stream=None, warmup=False):
     sig_key =  {sig_keys},
     constexpr_key = {f'{constexpr_keys},' if len(constexpr_keys) > 0 else tuple()}
     spec_key = {f'{spec_keys},' if len(spec_keys) > 0 else tuple()}
-    key = (version_key, sig_key, constexpr_key, spec_key)
-    if not extern_libs is None:
-      key = (key, tuple(extern_libs.items()))
+    key = _wrap_key((version_key, sig_key, constexpr_key, spec_key), extern_libs, warp_specialize, prefetch_width, pid_order, min_blocks_per_sm, max_registers, waves_per_eu, num_ctas)
     assert num_warps > 0 and (num_warps & (num_warps - 1)) == 0, "num_warps must be a power of 2"
     if callable(grid):
         grid = grid({{{grid_args}}})
@@ -253,14 +411,17 @@ def {self.fn.__name__}({', '.join(self.arg_names)}, grid, num_warps=4, num_stage
     grid_0 = grid[0]
     grid_1 = grid[1] if grid_size > 1 else 1
     grid_2 = grid[2] if grid_size > 2 else 1
-    device = torch.cuda.current_device()
-    torch.cuda.set_device(device)
+    device = current_device()
     if stream is None and not warmup:
       stream = get_cuda_stream(device)
     try:
       bin = cache[device][key]
       if not warmup:
-          bin.c_wrapper(grid_0, grid_1, grid_2, bin.num_warps, bin.shared, stream, bin.cu_function, triton.compiler.CompiledKernel.launch_enter_hook, triton.compiler.CompiledKernel.launch_exit_hook, bin, {args})
+          if bin.profile_regions:
+              bin.profile_launch(grid_0, grid_1, grid_2)
+          if bin.trace_formats:
+              bin.trace_launch()
+          bin.c_wrapper(grid_0, grid_1, grid_2, bin.num_threads, bin.shared, bin.cooperative, bin.num_ctas, stream, bin.cu_function, triton.compiler.CompiledKernel.launch_enter_hook, triton.compiler.CompiledKernel.launch_exit_hook, bin, {args})
       return bin
     # kernel not cached -- compile
     except KeyError:
@@ -277,24 +438,45 @@ def {self.fn.__name__}({', '.join(self.arg_names)}, grid, num_warps=4, num_stage
       for i, arg in constants.items():
         if callable(arg):
           raise TypeError(f"Callable constexpr at index {{i}} is not supported")
-      if not self._call_hook(key, signature, device, constants, num_warps, num_stages, extern_libs, configs):
-        bin = triton.compile(self, signature=signature, device=device, constants=constants, num_warps=num_warps, num_stages=num_stages, extern_libs=extern_libs, configs=configs)
+      if self.async_compile and not warmup and JITFunction.cache_hook is None:
+        generic_key = _wrap_key((version_key, sig_key, constexpr_key, _generic_spec(spec_key)), extern_libs, warp_specialize, prefetch_width, pid_order, min_blocks_per_sm, max_registers, waves_per_eu, num_ctas)
+        bin = self._compile_async(device, key, generic_key, signature=signature, constants=constants, num_warps=num_warps, num_stages=num_stages, warp_specialize=warp_specialize, prefetch_width=prefetch_width, pid_order=pid_order, min_blocks_per_sm=min_blocks_per_sm, max_registers=max_registers, waves_per_eu=waves_per_eu, num_ctas=num_ctas, extern_libs=extern_libs, configs=configs)
+        if bin is not None:
+          if bin.profile_regions:
+            bin.profile_launch(grid_0, grid_1, grid_2)
+          if bin.trace_formats:
+            bin.trace_launch()
+          bin.c_wrapper(grid_0, grid_1, grid_2, bin.num_threads, bin.shared, bin.cooperative, bin.num_ctas, stream, bin.cu_function, triton.compiler.CompiledKernel.launch_enter_hook, triton.compiler.CompiledKernel.launch_exit_hook, bin, *args)
+          return bin
+      if not self._call_hook(key, signature, device, constants, num_warps, num_stages, warp_specialize, prefetch_width, pid_order, min_blocks_per_sm, max_registers, waves_per_eu, num_ctas, extern_libs, configs):
+        bin = triton.compile(self, signature=signature, device=device, constants=constants, num_warps=num_warps, num_stages=num_stages, warp_specialize=warp_specialize, prefetch_width=prefetch_width, pid_order=pid_order, min_blocks_per_sm=min_blocks_per_sm, max_registers=max_registers, waves_per_eu=waves_per_eu, num_ctas=num_ctas, extern_libs=extern_libs, configs=configs)
         if not warmup:
-            bin.c_wrapper(grid_0, grid_1, grid_2, bin.num_warps, bin.shared, stream, bin.cu_function, triton.compiler.CompiledKernel.launch_enter_hook, triton.compiler.CompiledKernel.launch_exit_hook, bin, *args)
+            if bin.profile_regions:
+                bin.profile_launch(grid_0, grid_1, grid_2)
+            if bin.trace_formats:
+                bin.trace_launch()
+            bin.c_wrapper(grid_0, grid_1, grid_2, bin.num_threads, bin.shared, bin.cooperative, bin.num_ctas, stream, bin.cu_function, triton.compiler.CompiledKernel.launch_enter_hook, triton.compiler.CompiledKernel.launch_exit_hook, bin, *args)
         self.cache[device][key] = bin
         return bin
       return None
 """
-        scope = {"version_key": version_key(), "get_cuda_stream": get_cuda_stream,
+        scope = {"version_key": version_key(), "get_cuda_stream": get_cuda_stream, "current_device": current_device,
                  "self": self, "_spec_of": self._spec_of, "_key_of": self._key_of,
+                 "_bucket_of": self._bucket_of, "_wrap_key": self._wrap_key, "_generic_spec": self._generic_spec,
                  "cache": self.cache, "triton": triton, "torch": torch}
         exec(src, scope)
         return scope[self.fn.__name__]
 
-    def __init__(self, fn, version=None, do_not_specialize=None):
+    def __init__(self, fn, version=None, do_not_specialize=None, version_alignment=False, specialize=None,
+                 async_compile=False, fast_math=False, int32_indexing=False, threads_per_warp=32, restrict=None):
         self.fn = fn
         self.module = fn.__module__
         self.version = version
+        self.version_alignment = version_alignment
+        self.async_compile = async_compile
+        self.fast_math = fast_math
+        self.int32_indexing = int32_indexing
+        self.threads_per_warp = threads_per_warp
         # function signature information
         signature = inspect.signature(fn)
         self.arg_names = [v.name for v in signature.parameters.values()]
@@ -302,11 +484,17 @@ def {self.fn.__name__}({', '.join(self.arg_names)}, grid, num_warps=4, num_stage
         # specialization hints
         self.do_not_specialize = [] if do_not_specialize is None else do_not_specialize
         self.do_not_specialize = {self.arg_names.index(arg) if isinstance(arg, str) else arg for arg in self.do_not_specialize}
+        # pointer arguments asserted to alias no other argument
+        if restrict is True:
+            restrict = range(len(self.arg_names))
+        self.restrict = {self.arg_names.index(arg) if isinstance(arg, str) else arg for arg in (restrict or ())}
         # function source code (without decorators)
         self.src = textwrap.dedent(inspect.getsource(fn))
         self.src = self.src[self.src.find("def"):]
         # cache of just-in-time compiled kernels
         self.cache = defaultdict(dict)
+        # background compilations of async_compile kernels, by (device, key)
+        self.pending = dict()
         self.hash = None
         # JITFunction can be instantiated as kernel
         # when called with a grid using __getitem__
@@ -317,8 +505,27 @@ def {self.fn.__name__}({', '.join(self.arg_names)}, grid, num_warps=4, num_stage
         self.__annotations__ = fn.__annotations__
         # index of constexprs
         self.constexprs = [self.arg_names.index(ann) for ann in self.__annotations__.keys()]
-        # launcher
-        self.run = self._make_launcher()
+        # bucketing policies: constexprs are rounded up to their bucket, other
+        # arguments are only specialized on their divisibility
+        self.constexpr_buckets = dict()
+        self.divisibility_buckets = dict()
+        for arg, policy in ({} if specialize is None else specialize).items():
+            i = self.arg_names.index(arg) if isinstance(arg, str) else arg
+            is_divisibility = isinstance(policy, int) and not isinstance(policy, bool) and policy > 0
+            if policy == "exact":
+                continue
+            elif policy == "never" and i not in self.constexprs:
+                self.do_not_specialize.add(i)
+            elif (policy == "pow2" or is_divisibility) and i in self.constexprs:
+                self.constexpr_buckets[i] = policy
+            elif is_divisibility:
+                self.divisibility_buckets[i] = policy
+            else:
+                raise ValueError(f"Invalid specialization policy {policy!r} for argument {self.arg_names[i]}")
+        # launcher: cache hits are dispatched from C++, other calls go through
+        # the Python launcher
+        self.run = _triton.runtime.KernelDispatcher(self, self._make_launcher(), version_key(), get_cuda_stream,
+                                                    get_current_device, triton.compiler.CompiledKernel, Grid)
         # re-use docs of wrapped function
         self.__doc__ = fn.__doc__
         self.__name__ = fn.__name__
@@ -380,6 +587,13 @@ def jit(
     *,
     version=None,
     do_not_specialize: Optional[Iterable[int]] = None,
+    version_alignment: bool = False,
+    specialize: Optional[Dict[Union[str, int], Union[str, int]]] = None,
+    async_compile: bool = False,
+    fast_math: bool = False,
+    int32_indexing: bool = False,
+    threads_per_warp: int = 32,
+    restrict: Optional[Union[bool, Iterable[Union[str, int]]]] = None,
 ) -> Callable[[T], JITFunction[T]]:
     ...
 
@@ -389,6 +603,13 @@ def jit(
     *,
     version=None,
     do_not_specialize: Optional[Iterable[int]] = None,
+    version_alignment: bool = False,
+    specialize: Optional[Dict[Union[str, int], Union[str, int]]] = None,
+    async_compile: bool = False,
+    fast_math: bool = False,
+    int32_indexing: bool = False,
+    threads_per_warp: int = 32,
+    restrict: Optional[Union[bool, Iterable[Union[str, int]]]] = None,
 ) -> Union[JITFunction[T], Callable[[T], JITFunction[T]]]:
     """
     Decorator for JIT-compiling a function using the Triton compiler.
@@ -405,6 +626,33 @@ def jit(
 
     :param fn: the function to be jit-compiled
     :type fn: Callable
+    :param version_alignment: compile a single kernel for aligned and unaligned pointers, with a
+        vectorized path selected by a runtime alignment check instead of one kernel per alignment
+    :type version_alignment: bool
+    :param specialize: specialization policy of arguments, by name or index, to bound the number of
+        compiled variants. :code:`"exact"` is the default, :code:`"never"` disables the specialization
+        of a non-constexpr argument, an integer :code:`N` buckets pointers and integers by their
+        divisibility by :code:`N` only, and rounds up constexprs to a multiple of :code:`N`.
+        :code:`"pow2"` rounds up constexprs to a power of 2. Kernels see the rounded up values of
+        constexprs and must be correct for any smaller one, e.g. by masking.
+    :type specialize: dict
+    :param async_compile: compile new specializations on a background thread, and launch the
+        variant without value specializations in the meantime
+    :type async_compile: bool
+    :param fast_math: lower :code:`exp`, :code:`log`, :code:`sin`, :code:`cos`, :code:`libdevice.rsqrt`,
+        :code:`libdevice.tanh` and :code:`sigmoid` of float32 values to approximate hardware instructions
+        instead of libdevice calls, at the cost of a few ulps and of denormal handling
+    :type fast_math: bool
+    :param int32_indexing: assert that the offsets of the pointers of the kernel fit in 32 bits, so that tensors
+        of pointers advanced in loops are kept as a scalar base and 32-bit offsets rather than 64-bit pointers
+    :type int32_indexing: bool
+    :param threads_per_warp: number of threads of a warp. AMD GPUs run wavefronts of 64 threads, which
+        kernels see as pairs of 32-thread warps by default, and as single warps with 64
+    :type threads_per_warp: int
+    :param restrict: pointer arguments, by name or index, or :code:`True` for all of them, whose memory the
+        kernel accesses through no other argument, as C's :code:`restrict`. Those the kernel never writes
+        through are then read through the non-coherent cache on NVIDIA GPUs, e.g. weights or lookup tables
+    :type restrict: bool or list
     """
 
     def decorator(fn: T) -> JITFunction[T]:
@@ -413,6 +661,13 @@ def jit(
             fn,
             version=version,
             do_not_specialize=do_not_specialize,
+            version_alignment=version_alignment,
+            specialize=specialize,
+            async_compile=async_compile,
+            fast_math=fast_math,
+            int32_indexing=int32_indexing,
+            threads_per_warp=threads_per_warp,
+            restrict=restrict,
         )
 
     if fn is not None:
@@ -0,0 +1,190 @@
+'''
+Occupancy model of the kernels, used to propose launch configurations and to
+prune the configurations of the autotuner before benchmarking them.
+
+The number of programs resident on a multiprocessor (SM on NVIDIA GPUs, CU on
+AMD GPUs) is bounded by its threads, registers and shared memory. Memory-bound
+kernels hide the latency of the global accesses with the warps in flight, and
+every kernel loses the idle multiprocessors of its last wave of programs.
+'''
+from __future__ import annotations
+
+import builtins
+from dataclasses import dataclass
+
+import torch
+
+from .. import compiler
+
+# occupancy above which the latency of the global accesses is considered hidden
+_LATENCY_HIDING_OCCUPANCY = 0.5
+# width of the vectorized global accesses, in bits
+_VECTOR_BITS = 128
+# vectors each thread should access to amortize the address computations
+_VECTORS_PER_THREAD = 2
+
+
+@dataclass(frozen=True)
+class DeviceLimits:
+    """
+    Resources of a multiprocessor of the device.
+    """
+    warp_size: int = 32
+    num_sms: int = 108
+    max_threads_per_sm: int = 2048
+    max_threads_per_program: int = 1024
+    max_programs_per_sm: int = 32
+    max_registers_per_sm: int = 65536
+    max_registers_per_thread: int = 255
+    # registers are allocated to each thread by multiples of this
+    register_granularity: int = 8
+    max_shared_per_sm: int = 167936
+
+    @staticmethod
+    def for_arch(arch, num_sms=108):
+        """
+        Limits of a multiprocessor of the architecture `arch` of the compiled
+        kernels (`sm<capability>` or a `gfx` target), without querying the
+        device. The architectures that are not known get those of an A100.
+        """
+        if arch.startswith("gfx"):
+            # CDNA: 4 SIMDs of 512 VGPRs per lane and 8 waves of 64 lanes each
+            return DeviceLimits(warp_size=64, num_sms=num_sms, max_threads_per_sm=2048, max_programs_per_sm=32,
+                                max_registers_per_sm=4 * 512 * 64, max_registers_per_thread=512,
+                                register_granularity=8, max_shared_per_sm=65536)
+        # threads, programs and shared memory per SM of each capability
+        threads, programs, shared = {70: (2048, 32, 98304), 75: (1024, 16, 65536), 86: (1536, 16, 102400),
+                                     89: (1536, 24, 102400), 90: (2048, 32, 233472)}.get(
+            int(arch[2:]) if arch[2:].isdigit() else 80, (2048, 32, 167936))
+        return DeviceLimits(warp_size=32, num_sms=num_sms, max_threads_per_sm=threads,
+                            max_programs_per_sm=programs, max_shared_per_sm=shared)
+
+    @staticmethod
+    def query(device=None):
+        if device is None:
+            device = torch.cuda.current_device()
+        if torch.version.hip is not None:
+            return DeviceLimits.for_arch("gfx", torch.cuda.get_device_properties(device).multi_processor_count)
+        compiler.init_cuda_utils()
+        props = compiler.cuda_utils.get_device_properties(device)
+        return DeviceLimits(warp_size=32, num_sms=props["multiprocessor_count"],
+                            max_threads_per_sm=props["max_threads_per_sm"],
+                            max_registers_per_sm=props["max_registers_per_sm"],
+                            max_shared_per_sm=props["max_shared_mem_per_sm"])
+
+
+def programs_per_sm(limits, num_warps, registers=None, shared=0):
+    '''
+    Number of programs of `num_warps` warps resident on a multiprocessor, each
+    thread holding `registers` registers (the maximum if `None`, and at most
+    the maximum otherwise, the rest being spilled) and each program `shared`
+    bytes of shared memory. Zero if a program does not fit.
+    '''
+    threads = num_warps * limits.warp_size
+    if threads > limits.max_threads_per_program or shared > limits.max_shared_per_sm:
+        return 0
+    if registers is None:
+        registers = limits.max_registers_per_thread
+    registers = builtins.min(builtins.max(registers, 1), limits.max_registers_per_thread)
+    granularity = limits.register_granularity
+    registers = (registers + granularity - 1) // granularity * granularity
+    bounds = [limits.max_programs_per_sm,
+              limits.max_threads_per_sm // threads,
+              limits.max_registers_per_sm // (registers * threads)]
+    if shared > 0:
+        bounds.append(limits.max_shared_per_sm // shared)
+    return builtins.min(bounds)
+
+
+def occupancy(limits, num_warps, registers=None, shared=0):
+    '''
+    Fraction of the threads of a multiprocessor kept busy by resident programs.
+    '''
+    programs = programs_per_sm(limits, num_warps, registers, shared)
+    return programs * num_warps * limits.warp_size / limits.max_threads_per_sm
+
+
+def wave_efficiency(limits, num_programs, programs_per_sm):
+    '''
+    Fraction of the slots of the waves of `num_programs` programs in use, the
+    last wave being partial.
+    '''
+    if programs_per_sm == 0 or num_programs == 0:
+        return 0.
+    slots = programs_per_sm * limits.num_sms
+    waves = (num_programs + slots - 1) // slots
+    return num_programs / (waves * slots)
+
+
+def predicted_efficiency(limits, num_warps, registers=None, shared=0, num_programs=None):
+    '''
+    Throughput of a launch relative to the peak of the device: the latency of
+    the global accesses is hidden beyond half occupancy, and the last wave
+    leaves multiprocessors idle. The waves are ignored if `num_programs` is
+    `None`.
+    '''
+    programs = programs_per_sm(limits, num_warps, registers, shared)
+    efficiency = builtins.min(1., occupancy(limits, num_warps, registers, shared) / _LATENCY_HIDING_OCCUPANCY)
+    if num_programs is not None:
+        efficiency *= wave_efficiency(limits, num_programs, programs)
+    return efficiency
+
+
+def propose_num_warps(numel, elem_bits, limits=None, registers=None, shared=0, max_num_warps=8):
+    '''
+    Proposes the number of warps of programs processing blocks of `numel`
+    elements of `elem_bits` bits: the largest power of two giving each thread
+    a few vectorized accesses, reduced while the programs do not fit on a
+    multiprocessor with `registers` registers per thread (assumed to fit if
+    `None`) and `shared` bytes of shared memory.
+    '''
+    if limits is None:
+        limits = DeviceLimits.query()
+    max_num_warps = builtins.min(max_num_warps, limits.max_threads_per_program // limits.warp_size)
+    vectors = numel * elem_bits // _VECTOR_BITS
+    num_warps = 1
+    while num_warps * 2 <= max_num_warps and \
+            num_warps * 2 * limits.warp_size * _VECTORS_PER_THREAD <= vectors:
+        num_warps *= 2
+    if registers is None:
+        registers = 1
+    while num_warps > 1 and programs_per_sm(limits, num_warps, registers, shared) == 0:
+        num_warps //= 2
+    return num_warps
+
+
+def propose_layout(shape, num_warps, elem_bits, warp_size=32, order=None):
+    '''
+    Proposes the blocked layout of a tensor of `shape` distributed over
+    `num_warps` warps: each thread holds a vector of up to 128 bits along the
+    fastest axis, and the threads are assigned along `order` (the last axis
+    first by default) as by the default blocked encoding of the compiler.
+    Returns a dict of the `sizePerThread`, `threadsPerWarp`, `warpsPerCTA` and
+    `order` of the layout.
+    '''
+    rank = len(shape)
+    if order is None:
+        order = list(reversed(range(rank)))
+    size_per_thread = [1] * rank
+    size_per_thread[order[0]] = builtins.max(1, builtins.min(shape[order[0]], _VECTOR_BITS // elem_bits))
+    remaining_lanes = warp_size
+    remaining_threads = num_warps * warp_size
+    remaining_warps = num_warps
+    prev_lanes, prev_warps = 1, 1
+    threads_per_warp = [1] * rank
+    warps_per_cta = [1] * rank
+    for i in order[:-1]:
+        threads_per_cta = builtins.min(builtins.max(remaining_threads, 1),
+                                       builtins.max(shape[i] // size_per_thread[i], 1))
+        threads_per_warp[i] = builtins.min(builtins.max(threads_per_cta, 1), remaining_lanes)
+        warps_per_cta[i] = builtins.min(builtins.max(threads_per_cta // threads_per_warp[i], 1), remaining_warps)
+        remaining_warps //= warps_per_cta[i]
+        remaining_lanes //= threads_per_warp[i]
+        remaining_threads //= threads_per_cta
+        prev_lanes *= threads_per_warp[i]
+        prev_warps *= warps_per_cta[i]
+    # the slowest axis takes the remaining lanes and warps
+    threads_per_warp[order[-1]] = warp_size // prev_lanes
+    warps_per_cta[order[-1]] = num_warps // prev_warps
+    return {"sizePerThread": size_per_thread, "threadsPerWarp": threads_per_warp,
+            "warpsPerCTA": warps_per_cta, "order": list(order)}
@@ -120,7 +120,7 @@ def nvsmi(attrs):
 
 def do_bench(fn, warmup=25, rep=100, grad_to_none=None,
              percentiles=(0.5, 0.2, 0.8),
-             record_clocks=False, fast_flush=False):
+             record_clocks=False, fast_flush=False, cuda_graph=False):
     """
     Benchmark the runtime of the provided function. By default, return the median runtime of :code:`fn` along with
     the 20-th and 80-th performance percentile.
@@ -137,11 +137,22 @@ def do_bench(fn, warmup=25, rep=100, grad_to_none=None,
     :type percentiles: list[float]
     :param fast_flush: Use faster kernel to flush L2 between measurements
     :type fast_flush: bool
+    :param cuda_graph: Capture :code:`fn` in a CUDA/HIP graph and time its replays, which removes the
+        overhead of the launches on the host from the measurements
+    :type cuda_graph: bool
     """
 
     # Estimate the runtime of the function
     fn()
     torch.cuda.synchronize()
+    if cuda_graph:
+        assert grad_to_none is None, "backward passes cannot be captured in a graph"
+        # kernels are compiled and caches allocated by the run above, outside of the capture
+        graph = torch.cuda.CUDAGraph()
+        with torch.cuda.graph(graph):
+            fn()
+        torch.cuda.synchronize()
+        fn = graph.replay
     start_event = torch.cuda.Event(enable_timing=True)
     end_event = torch.cuda.Event(enable_timing=True)
     start_event.record()
@@ -332,6 +343,14 @@ def perf_report(benchmarks):
     return wrapper
 
 
+def _get_device_properties(device):
+    if torch.version.hip is not None:
+        triton.compiler.init_hip_utils()
+        return triton.compiler.hip_utils.get_device_properties(device)
+    triton.compiler.init_cuda_utils()
+    return triton.compiler.cuda_utils.get_device_properties(device)
+
+
 def get_dram_gbps(backend=None, device=None):
     ''' return DRAM bandwidth in GB/s '''
     # assert backend == CUDA
@@ -339,22 +358,38 @@ def get_dram_gbps(backend=None, device=None):
         backend = _triton.runtime.backend.CUDA
     if not device:
         device = torch.cuda.current_device()
-    mem_clock_khz = triton.compiler.cuda_utils.get_device_properties(device)["mem_clock_rate"]  # in kHz
-    bus_width = triton.compiler.cuda_utils.get_device_properties(device)["mem_bus_width"]
+    props = _get_device_properties(device)
+    mem_clock_khz = props["mem_clock_rate"]  # in kHz
+    bus_width = props["mem_bus_width"]
     bw_gbps = mem_clock_khz * bus_width * 2 / 1e6 / 8  # In GB/s
     return bw_gbps
 
 
+# dense matrix core ops per CU per clock of the CDNA GPUs
+_MFMA_OPS_PER_CU = {
+    'gfx908': {torch.float32: 256, torch.float16: 1024, torch.bfloat16: 512, torch.int8: 1024},
+    'gfx90a': {torch.float32: 256, torch.float16: 1024, torch.bfloat16: 1024, torch.int8: 1024},
+    'gfx940': {torch.float32: 256, torch.float16: 2048, torch.bfloat16: 2048, torch.int8: 4096},
+    'gfx941': {torch.float32: 256, torch.float16: 2048, torch.bfloat16: 2048, torch.int8: 4096},
+    'gfx942': {torch.float32: 256, torch.float16: 2048, torch.bfloat16: 2048, torch.int8: 4096},
+}
+
+
 def get_max_tensorcore_tflops(dtype: torch.dtype, backend=None, device=None, clock_rate=None):
     if not backend:
         backend = _triton.runtime.backend.CUDA
     if not device:
         device = torch.cuda.current_device()
 
-    triton.compiler.init_cuda_utils()
-    num_subcores = triton.compiler.cuda_utils.get_device_properties(device)["multiprocessor_count"] * 4
+    props = _get_device_properties(device)
     if not clock_rate:
-        clock_rate = triton.compiler.cuda_utils.get_device_properties(device)["sm_clock_rate"]  # in kHz
+        clock_rate = props["sm_clock_rate"]  # in kHz
+    if torch.version.hip is not None:
+        arch = triton.compiler.get_device_arch(device)
+        if arch not in _MFMA_OPS_PER_CU or dtype not in _MFMA_OPS_PER_CU[arch]:
+            raise RuntimeError(f"peak throughput of {dtype} on {arch} unknown")
+        return props["multiprocessor_count"] * clock_rate * _MFMA_OPS_PER_CU[arch][dtype] * 1e-9
+    num_subcores = props["multiprocessor_count"] * 4
     capability = torch.cuda.get_device_capability(device)
     if capability[0] < 8:
         assert dtype == torch.float16
@@ -371,6 +406,106 @@ def get_max_tensorcore_tflops(dtype: torch.dtype, backend=None, device=None, clo
     tflops = num_subcores * clock_rate * ops_per_sub_core * 1e-9
     return tflops
 
+
+class Roofline:
+    """
+    Reports the throughput achieved by benchmarks against the peaks of the device: each benchmark declares the
+    bytes it moves to and from DRAM and the floating-point operations it performs, and gets its achieved GB/s,
+    TFLOP/s and percentage of the roofline, i.e. of the throughput attainable at its arithmetic intensity.
+
+    .. code-block:: python
+
+        roofline = triton.testing.Roofline(torch.float16)
+        for M in [512, 1024, 2048]:
+            a, b = ...
+            roofline.bench(lambda: matmul(a, b), bytes=3 * M * M * 2, flops=2 * M * M * M,
+                           name="matmul", config={"M": M})
+        roofline.to_json("matmul.json")
+    """
+
+    def __init__(self, dtype=torch.float16, device=None, peak_gbps=None, peak_tflops=None):
+        """
+        :param dtype: Data type the peak compute throughput is given for.
+        :type dtype: torch.dtype
+        :param device: Device the benchmarks run on; the current device by default.
+        :param peak_gbps: Peak DRAM bandwidth in GB/s; queried from the device if None.
+        :type peak_gbps: float, optional
+        :param peak_tflops: Peak compute throughput in TFLOP/s; queried from the device if None.
+        :type peak_tflops: float, optional
+        """
+        if peak_gbps is None or peak_tflops is None:
+            if device is None:
+                device = torch.cuda.current_device()
+            self.device_name = torch.cuda.get_device_name(device)
+        else:
+            self.device_name = None
+        self.dtype = dtype
+        self.peak_gbps = peak_gbps if peak_gbps is not None else get_dram_gbps(device=device)
+        self.peak_tflops = peak_tflops if peak_tflops is not None else \
+            get_max_tensorcore_tflops(dtype, device=device)
+        self.results = []
+
+    def record(self, ms, bytes, flops=0, name='', config=None):
+        """
+        Records a run of :code:`ms` milliseconds moving :code:`bytes` bytes and performing :code:`flops`
+        operations, and returns its record.
+        """
+        s = ms * 1e-3
+        gbps = bytes / s * 1e-9
+        tflops = flops / s * 1e-12
+        intensity = flops / bytes if bytes else float('inf')
+        # the ridge point separates the memory-bound and compute-bound intensities
+        ridge = self.peak_tflops * 1e3 / self.peak_gbps
+        bound = "memory" if intensity < ridge else "compute"
+        if bound == "memory":
+            roofline_pct = 100 * gbps / self.peak_gbps
+        else:
+            roofline_pct = 100 * tflops / self.peak_tflops
+        result = {"name": name, "config": dict(config or {}), "ms": ms, "bytes": bytes, "flops": flops,
+                  "gbps": gbps, "tflops": tflops, "arithmetic_intensity": intensity, "bound": bound,
+                  "roofline_pct": roofline_pct}
+        self.results.append(result)
+        return result
+
+    def bench(self, fn, bytes, flops=0, name='', config=None, warmup=25, rep=100, cuda_graph=True):
+        """
+        Benchmarks :code:`fn` with :code:`do_bench`, flushing the L2 cache before each run and replaying it
+        from a graph unless :code:`cuda_graph` is False, and records its median runtime.
+        """
+        ms = do_bench(fn, warmup=warmup, rep=rep, percentiles=None, fast_flush=True, cuda_graph=cuda_graph)
+        return self.record(ms, bytes, flops, name, config)
+
+    def to_json(self, path=None):
+        """
+        Returns the records as JSON, along with the peaks of the device, and writes them to :code:`path` if given.
+        """
+        import json
+        data = json.dumps({"device": self.device_name, "dtype": str(self.dtype), "peak_gbps": self.peak_gbps,
+                           "peak_tflops": self.peak_tflops, "results": self.results}, indent=2)
+        if path:
+            with open(path, "w") as f:
+                f.write(data)
+        return data
+
+    def compare(self, baseline, tolerance=0.05):
+        """
+        Returns the records whose runtime regressed by more than :code:`tolerance` relative to the record of the
+        same name and configuration in :code:`baseline`, the JSON output of a previous run or its path, as a list of
+        :code:`(record, baseline record)` pairs.
+        """
+        import json
+        if not baseline.lstrip().startswith("{"):
+            with open(baseline) as f:
+                baseline = f.read()
+        key = lambda r: (r["name"], json.dumps(r["config"], sort_keys=True))
+        reference = {key(r): r for r in json.loads(baseline)["results"]}
+        regressions = []
+        for result in self.results:
+            ref = reference.get(key(result))
+            if ref is not None and result["ms"] > ref["ms"] * (1 + tolerance):
+                regressions.append((result, ref))
+        return regressions
+
 # create decorator that wraps test function into
 # a cuda-memcheck system call
 
@@ -120,3 +120,138 @@ def extract(file_path, fun):
             ret += asm + '\n'
         ret += '\n'
         return ret
+
+
+# Static analysis of the binaries. The instruction mix of a kernel is read
+# from its disassembly (SASS as printed by `extract`, or the GCN assembly
+# emitted by the AMDGPU backend), and its resources from the resource usage
+# reported by cuobjdump or the comments of the GCN assembly. Access widths
+# are in bits.
+
+RES_FNAME_RE = re.compile(r'\s*Function (\w+):\s*')
+RES_USAGE_RE = re.compile(r'(\w+(?:\[\d+\])?):(\d+)')
+SASS_PRED_RE = re.compile(r'^@!?U?P\w+\s+')
+SASS_WIDTHS = {'U8': 8, 'S8': 8, 'U16': 16, 'S16': 16, '64': 64, '128': 128}
+GCN_INST_RE = re.compile(r'^\s+([a-z][a-z0-9_]*)(?:\s|$)')
+GCN_COUNT_RE = re.compile(r'^\s*;\s*(NumSgprs|NumVgprs|NumAgprs|TotalNumVgprs|ScratchSize|Occupancy):\s*(\d+)')
+GCN_SPILL_RE = re.compile(r'^\s*\.(vgpr|sgpr)_spill_count:\s*(\d+)')
+GCN_WIDTHS = {'ubyte': 8, 'sbyte': 8, 'ushort': 16, 'sshort': 16, 'short_d16': 16, 'short_d16_hi': 16,
+              'u8': 8, 'i8': 8, 'u16': 16, 'i16': 16, 'b16': 16, 'dword': 32, 'b32': 32,
+              'dwordx2': 64, 'b64': 64, 'dwordx3': 96, 'b96': 96, 'dwordx4': 128, 'b128': 128}
+
+
+def _instruction_mix():
+    return {"instructions": 0, "mma": 0, "barriers": 0, "global_loads": [], "global_stores": [],
+            "shared_loads": [], "shared_stores": [], "spill_loads": 0, "spill_stores": 0}
+
+
+def resource_usage(file_path, fun=None):
+    '''
+    Registers per thread and stack, local, and static shared memory in bytes
+    of the function `fun` of a cubin (the first one if `None`), as reported by
+    `cuobjdump -res-usage`. None if the function is not found.
+    '''
+    args = ["cuobjdump", "-res-usage", file_path]
+    if fun is not None:
+        args[1:1] = ["-fun", fun]
+    lines = subprocess.check_output(args).decode().splitlines()
+    for idx, line in enumerate(lines[:-1]):
+        match = RES_FNAME_RE.match(line)
+        if match is None or (fun is not None and match.group(1) != fun):
+            continue
+        usage = dict(RES_USAGE_RE.findall(lines[idx + 1]))
+        return {"registers": int(usage.get("REG", 0)), "stack": int(usage.get("STACK", 0)),
+                "local": int(usage.get("LOCAL", 0)), "shared": int(usage.get("SHARED", 0))}
+    return None
+
+
+def sass_instruction_mix(sass):
+    '''
+    Instruction mix of SASS printed by `extract`: the number of instructions,
+    MMAs and barriers, the width of each global and shared memory access in
+    program order, and the number of accesses to spilled registers.
+    '''
+    mix = _instruction_mix()
+    for line in sass.splitlines():
+        if '\t' not in line:
+            continue
+        asm = SASS_PRED_RE.sub('', line.split('\t', 1)[1].strip())
+        opcode = asm.split(' ', 1)[0].rstrip(';')
+        name, *modifiers = opcode.split('.')
+        mix["instructions"] += 1
+        width = 32
+        for modifier in modifiers:
+            width = SASS_WIDTHS.get(modifier, width)
+        if name in ('HMMA', 'IMMA', 'DMMA', 'HGMMA', 'IGMMA', 'QGMMA'):
+            mix["mma"] += 1
+        elif name in ('BAR', 'BARRIER'):
+            mix["barriers"] += 1
+        elif name in ('LDG', 'LDGSTS'):
+            mix["global_loads"].append(width)
+        elif name in ('STG', 'RED', 'ATOMG'):
+            mix["global_stores"].append(width)
+        elif name == 'LDS':
+            mix["shared_loads"].append(width)
+        elif name == 'LDSM':
+            # each of the 1, 2 or 4 matrices of 8x8 16-bit elements gives each thread 32 bits
+            mix["shared_loads"].append(32 * {'2': 2, '4': 4}.get(modifiers[-1] if modifiers else '', 1))
+        elif name == 'STS':
+            mix["shared_stores"].append(width)
+        elif name == 'LDL':
+            mix["spill_loads"] += 1
+        elif name == 'STL':
+            mix["spill_stores"] += 1
+    return mix
+
+
+def gcn_resource_usage(amdgcn):
+    '''
+    VGPRs (including the AGPRs) and SGPRs per thread, spilled registers and
+    scratch memory per thread in bytes of the kernel of GCN assembly, as
+    reported by the comments and the metadata emitted by the AMDGPU backend.
+    '''
+    counts = dict()
+    spills = 0
+    for line in amdgcn.splitlines():
+        match = GCN_COUNT_RE.match(line)
+        if match is not None:
+            counts.setdefault(match.group(1), int(match.group(2)))
+            continue
+        match = GCN_SPILL_RE.match(line)
+        if match is not None:
+            spills += int(match.group(2))
+    vgprs = counts.get("TotalNumVgprs", counts.get("NumVgprs", 0) + counts.get("NumAgprs", 0))
+    return {"registers": vgprs, "scalar_registers": counts.get("NumSgprs", 0),
+            "spills": spills, "scratch": counts.get("ScratchSize", 0)}
+
+
+def gcn_instruction_mix(amdgcn):
+    '''
+    Instruction mix of GCN assembly, as `sass_instruction_mix`. The accesses
+    to spilled registers are those to scratch memory.
+    '''
+    mix = _instruction_mix()
+    for line in amdgcn.splitlines():
+        match = GCN_INST_RE.match(line)
+        if match is None:
+            continue
+        name = match.group(1)
+        mix["instructions"] += 1
+        kind, _, suffix = name.partition('_')
+        op, _, type = suffix.partition('_')
+        load = op.startswith(('load', 'read'))
+        if name.startswith(('v_mfma', 'v_smfma', 'v_wmma')):
+            mix["mma"] += 1
+        elif name == 's_barrier':
+            mix["barriers"] += 1
+        elif kind in ('global', 'buffer', 'flat', 'scratch', 'ds') and \
+                (load or op.startswith(('store', 'write', 'atomic'))):
+            # ds_read2_b32 and ds_write2st64_b64 access two elements
+            width = GCN_WIDTHS.get(type, 32) * (2 if op.endswith(('2', '2st64')) else 1)
+            if kind == 'scratch':
+                mix["spill_loads" if load else "spill_stores"] += 1
+            elif kind == 'ds':
+                mix["shared_loads" if load else "shared_stores"].append(width)
+            else:
+                mix["global_loads" if load else "global_stores"].append(width)
+    return mix
@@ -373,6 +373,25 @@ func @store_constant_align(%addr: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %n:
 
 // -----
 
+// CHECK-LABEL: for_dynamic
+func @for_dynamic(%ub: index, %step: index {tt.divisibility = 16 : i32}) {
+  // CHECK-NEXT: Contiguity: [1] ; Divisibility: [32] ; Constancy: [1] ; ConstantValue: [32]
+  %c32 = arith.constant 32 : index
+  // CHECK-NEXT: Contiguity: [1] ; Divisibility: [1] ; Constancy: [1] ; ConstantValue: [None]
+  %pid = tt.get_program_id {axis = 0 : i32} : i32
+  // CHECK-NEXT: Contiguity: [1] ; Divisibility: [1] ; Constancy: [1] ; ConstantValue: [None]
+  %pid_idx = arith.index_cast %pid : i32 to index
+  // CHECK-NEXT: Contiguity: [1] ; Divisibility: [32] ; Constancy: [1] ; ConstantValue: [None]
+  %lb = arith.muli %pid_idx, %c32 : index
+  scf.for %iv = %lb to %ub step %step {
+    // CHECK-NEXT: Contiguity: [1] ; Divisibility: [16] ; Constancy: [1] ; ConstantValue: [None]
+    %t = arith.index_cast %iv : index to i32
+  }
+  return
+}
+
+// -----
+
 // This IR is dumped from vecadd test.
 // Note, the hint {tt.divisibility = 16 : i32} for %n_elements affects the alignment of mask.
 // CHECK-LABEL: vecadd_mask_align_16
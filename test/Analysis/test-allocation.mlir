@@ -9,6 +9,8 @@
 #C = #triton_gpu.mma<{versionMajor = 2, warpsPerCTA = [4, 1]}>
 #A_DOT = #triton_gpu.dot_op<{opIdx = 0, parent = #C}>
 #B_DOT = #triton_gpu.dot_op<{opIdx = 1, parent = #C}>
+#WS_SRC = #triton_gpu.blocked<{sizePerThread = [1, 2], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0]}>
+#WS_DST = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0]}>
 
 module attributes {"triton_gpu.num-warps" = 4 : i32} {
 
@@ -111,6 +113,32 @@ func @preallocate(%A : !tt.ptr<f16>) {
   // CHECK-NEXT: size = 12288
 }
 
+// The coloring alone places %cst3 at offset 3072, best-fit moves it right
+// above %cst1
+// CHECK-LABEL: best_fit
+func @best_fit(%A : !tt.ptr<f16>) {
+  // CHECK: offset = 0, size = 512
+  %cst0 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
+  // CHECK-NEXT: offset = 1024, size = 1024
+  %cst1 = arith.constant dense<0.000000e+00> : tensor<32x16xf16, #A_SHARED>
+  // CHECK-NEXT: offset = 512, size = 512
+  %cst2 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
+  %t0 = tt.trans %cst1 : (tensor<32x16xf16, #A_SHARED>) -> tensor<16x32xf16, #A_SHARED_T>
+  // CHECK-NEXT: offset = 2048, size = 1024
+  %cst3 = arith.constant dense<0.000000e+00> : tensor<32x16xf16, #A_SHARED>
+  %t1 = tt.trans %cst0 : (tensor<16x16xf16, #A_SHARED>) -> tensor<16x16xf16, #A_SHARED_T>
+  // CHECK-NEXT: offset = 0, size = 512
+  %cst4 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
+  %t2 = tt.trans %cst1 : (tensor<32x16xf16, #A_SHARED>) -> tensor<16x32xf16, #A_SHARED_T>
+  %t3 = tt.trans %cst4 : (tensor<16x16xf16, #A_SHARED>) -> tensor<16x16xf16, #A_SHARED_T>
+  // CHECK-NEXT: offset = 512, size = 512
+  %cst5 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
+  %t4 = tt.trans %cst4 : (tensor<16x16xf16, #A_SHARED>) -> tensor<16x16xf16, #A_SHARED_T>
+  %t5 = tt.trans %cst3 : (tensor<32x16xf16, #A_SHARED>) -> tensor<16x32xf16, #A_SHARED_T>
+  return
+  // CHECK-NEXT: size = 3072
+}
+
 // Unused tensors are immediately released
 // CHECK-LABEL: unused
 func @unused(%A : !tt.ptr<f16>) {
@@ -169,10 +197,33 @@ func @alloc(%A : !tt.ptr<f16>) {
 // CHECK-LABEL: scratch
 func @scratch() {
   %cst0 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #AL>
-  // CHECK: scratch offset = 0, size = 512
+  // CHECK: scratch offset = 0, size = 128
   %b = tt.reduce %cst0 {redOp = 1 : i32, axis = 0 : i32} : tensor<16x16xf16, #AL> -> tensor<16xf16, #sliceAd0>
   return
-  // CHECK-NEXT: size = 512
+  // CHECK-NEXT: size = 128
+}
+
+// User scratch buffers are live for the whole kernel, so they never share
+// their memory with the scratch buffers of other ops
+// CHECK-LABEL: user_scratch
+func @user_scratch() {
+  // CHECK: scratch offset = {{[0-9]+}}, size = 256
+  %0 = tt.scratch {size = 64 : i32} : !tt.ptr<f32, 3>
+  %cst0 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #AL>
+  // CHECK-NEXT: scratch offset = {{[0-9]+}}, size = 128
+  %b = tt.reduce %cst0 {redOp = 1 : i32, axis = 0 : i32} : tensor<16x16xf16, #AL> -> tensor<16xf16, #sliceAd0>
+  return
+  // CHECK-NEXT: size = 384
+}
+
+// Conversions within warps don't need scratch memory
+// CHECK-LABEL: warp_shuffle
+func @warp_shuffle() {
+  %cst0 = arith.constant dense<0.000000e+00> : tensor<32x32xf32, #WS_SRC>
+  // CHECK-NOT: scratch
+  %b = triton_gpu.convert_layout %cst0 : (tensor<32x32xf32, #WS_SRC>) -> tensor<32x32xf32, #WS_DST>
+  return
+  // CHECK: size = 0
 }
 
 // CHECK-LABEL: trans
@@ -0,0 +1,70 @@
+// RUN: triton-opt %s -split-input-file --mlir-disable-threading -tritongpu-decompose-conversions -test-print-bank-conflicts -o /dev/null 2>&1 | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [8, 4], warpsPerCTA = [4, 1], order = [1, 0]}>
+#mfma = #triton_gpu.mfma<{nonKDim = 32, warpsPerCTA = [2, 1]}>
+#dot_a = #triton_gpu.dot_op<{opIdx = 0, parent = #mfma}>
+#dot_b = #triton_gpu.dot_op<{opIdx = 1, parent = #mfma}>
+#unswizzled = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
+#ldmatrix = #triton_gpu.shared<{vec = 8, perPhase = 2, maxPhase = 4, order = [1, 0]}>
+
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+
+// Rows of 64 bytes: the 16 lanes of a ds_read_b64 hit every other row of the
+// same banks without swizzling, and pairs of rows with the swizzling of
+// ldmatrix
+
+// CHECK-LABEL: mfma_a_fixed
+func @mfma_a_fixed(%A: tensor<32x32xf16, #unswizzled>, %B: tensor<32x32xf16, #ldmatrix>) {
+  // CHECK-NEXT: load ways = 8
+  %a = triton_gpu.convert_layout %A : (tensor<32x32xf16, #unswizzled>) -> tensor<32x32xf16, #dot_a>
+  // CHECK-NEXT: load ways = 2
+  %b = triton_gpu.convert_layout %B : (tensor<32x32xf16, #ldmatrix>) -> tensor<32x32xf16, #dot_a>
+  return
+}
+
+// The swizzling selected for the LDS spreads the rows read together over all
+// the banks, and keeps the stores conflict-free
+
+// CHECK-LABEL: mfma_a_selected
+func @mfma_a_selected(%A: tensor<32x32xf16, #blocked>) {
+  // CHECK-NEXT: store ways = 1
+  // CHECK-NEXT: load ways = 1
+  %a = triton_gpu.convert_layout %A : (tensor<32x32xf16, #blocked>) -> tensor<32x32xf16, #dot_a>
+  return
+}
+
+// $b is contiguous along n: the lanes read consecutive elements unswizzled
+
+// CHECK-LABEL: mfma_b_selected
+func @mfma_b_selected(%B: tensor<32x32xf16, #blocked>) {
+  // CHECK-NEXT: store ways = 1
+  // CHECK-NEXT: load ways = 1
+  %b = triton_gpu.convert_layout %B : (tensor<32x32xf16, #blocked>) -> tensor<32x32xf16, #dot_b>
+  return
+}
+
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [8, 4], warpsPerCTA = [4, 1], order = [1, 0]}>
+#mfma = #triton_gpu.mfma<{nonKDim = 32, warpsPerCTA = [2, 1]}>
+#dot_a = #triton_gpu.dot_op<{opIdx = 0, parent = #mfma}>
+#lds32 = #triton_gpu.shared<{vec = 4, perPhase = 2, maxPhase = 8, order = [1, 0]}>
+
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.shared-banks" = 64 : i32} {
+
+// With 64 banks, a ds_read_b64 serves 32 lanes: the swizzling selected for 32
+// banks leaves 2-way conflicts, the one selected for 64 none
+
+// CHECK-LABEL: mfma_a_64_banks
+func @mfma_a_64_banks(%A: tensor<32x32xf16, #blocked>, %B: tensor<32x32xf16, #lds32>) {
+  // CHECK-NEXT: load ways = 2
+  %b = triton_gpu.convert_layout %B : (tensor<32x32xf16, #lds32>) -> tensor<32x32xf16, #dot_a>
+  // CHECK-NEXT: store ways = 1
+  // CHECK-NEXT: load ways = 1
+  %a = triton_gpu.convert_layout %A : (tensor<32x32xf16, #blocked>) -> tensor<32x32xf16, #dot_a>
+  return
+}
+
+}
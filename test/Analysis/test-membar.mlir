@@ -3,9 +3,11 @@
 #AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
 #sliceAd0 = #triton_gpu.slice<{dim = 0, parent = #AL}>
 #BL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0]}>
+#AL_W = #triton_gpu.blocked<{sizePerThread = [4, 1], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0]}>
 #A_SHARED = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0]}>
 #A_SHARED_T = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [0, 1]}>
 #B_SHARED = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0]}>
+#A_SHARED_CLUSTER = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0], cluster = 2}>
 #C = #triton_gpu.mma<{versionMajor = 2, warpsPerCTA = [4, 1]}>
 #A_DOT = #triton_gpu.dot_op<{opIdx = 0, parent = #C}>
 #B_DOT = #triton_gpu.dot_op<{opIdx = 1, parent = #C}>
@@ -173,16 +175,17 @@ func @multi_blocks(%i1 : i1) {
 }
 
 // Both branches inserted a barrier for %cst0 and %cst1, then the barrier doesn't need to be inserted in the parent region
+// The two barriers are merged into one before scf.if
 // CHECK-LABEL: multi_blocks_join_barrier
 func @multi_blocks_join_barrier(%i1 : i1) {
   %cst0 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
   %cst1 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
+  // CHECK: Membar 2
+  // CHECK-NOT: Membar
   scf.if %i1 {
-    // CHECK: Membar 2
     %a = tt.cat %cst0, %cst1 {axis = 0} : (tensor<16x16xf16, #A_SHARED>, tensor<16x16xf16, #A_SHARED>) -> tensor<32x16xf16, #A_SHARED>
     scf.yield
   } else {
-    // CHECK-NEXT: Membar 5
     %a = tt.cat %cst0, %cst1 {axis = 0} : (tensor<16x16xf16, #A_SHARED>, tensor<16x16xf16, #A_SHARED>) -> tensor<32x16xf16, #A_SHARED>
     scf.yield
   }
@@ -195,17 +198,16 @@ func @multi_blocks_join_barrier(%i1 : i1) {
 func @multi_blocks_yield(%i1 : i1) {
   %cst0 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
   %cst1 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
+  // CHECK: Membar 2
   %a = scf.if %i1 -> (tensor<32x16xf16, #A_SHARED>) {
-    // CHECK: Membar 2
     %a = tt.cat %cst0, %cst1 {axis = 0} : (tensor<16x16xf16, #A_SHARED>, tensor<16x16xf16, #A_SHARED>) -> tensor<32x16xf16, #A_SHARED>
     scf.yield %a : tensor<32x16xf16, #A_SHARED>
   } else {
-    // CHECK-NEXT: Membar 5
     %b = tt.cat %cst0, %cst1 {axis = 0} : (tensor<16x16xf16, #A_SHARED>, tensor<16x16xf16, #A_SHARED>) -> tensor<32x16xf16, #A_SHARED>
     scf.yield %b : tensor<32x16xf16, #A_SHARED>
   }
   %a_ = triton_gpu.convert_layout %cst0 : (tensor<16x16xf16, #A_SHARED>) -> tensor<16x16xf16, #AL>
-  // CHECK-NEXT: Membar 9
+  // CHECK-NEXT: Membar 8
   %b = tt.cat %a, %a {axis = 0} : (tensor<32x16xf16, #A_SHARED>, tensor<32x16xf16, #A_SHARED>) -> tensor<64x16xf16, #A_SHARED>
   return
 }
@@ -323,4 +325,71 @@ func @for_reuse_nested(%lb : index, %ub : index, %step : index, %A : !tt.ptr<f16
   return
 }
 
+// Each warp reads back only what it wrote to the scratch buffer, so the
+// conflict with the previous iteration only needs a warp barrier
+// CHECK-LABEL: for_warp_local_cvt
+func @for_warp_local_cvt(%lb : index, %ub : index, %step : index) {
+  %cst = arith.constant dense<0.000000e+00> : tensor<128x32xf16, #AL>
+  // CHECK-NOT: Membar
+  scf.for %iv = %lb to %ub step %step {
+    // CHECK: Warp barrier 1
+    %0 = triton_gpu.convert_layout %cst : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #AL_W>
+    scf.yield
+  }
+  return
+}
+
+// Warps exchange elements through the scratch buffer, so a CTA-wide barrier
+// is required
+// CHECK-LABEL: for_cvt
+func @for_cvt(%lb : index, %ub : index, %step : index) {
+  %cst = arith.constant dense<0.000000e+00> : tensor<128x32xf16, #AL>
+  scf.for %iv = %lb to %ub step %step {
+    // CHECK: Membar 1
+    %0 = triton_gpu.convert_layout %cst : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #BL>
+    scf.yield
+  }
+  return
+}
+
+// Atomics on a user scratch buffer need a barrier after the store that
+// initializes it and before the load that reads it back, but not between
+// themselves
+// CHECK-LABEL: user_scratch_atomics
+func @user_scratch_atomics(%idx : tensor<128xi32, #sliceAd0>, %val : tensor<128xf32, #sliceAd0>, %mask : tensor<128xi1, #sliceAd0>) {
+  %0 = tt.scratch {size = 128 : i32} : !tt.ptr<f32, 3>
+  %1 = tt.splat %0 : (!tt.ptr<f32, 3>) -> tensor<128x!tt.ptr<f32, 3>, #sliceAd0>
+  %2 = tt.addptr %1, %idx : tensor<128x!tt.ptr<f32, 3>, #sliceAd0>, tensor<128xi32, #sliceAd0>
+  tt.store %2, %val : tensor<128xf32, #sliceAd0>
+  // CHECK: Membar 4
+  %3 = "tt.atomic_rmw" (%2, %val, %mask) {atomic_rmw_op = 5 : i32} : (tensor<128x!tt.ptr<f32, 3>, #sliceAd0>, tensor<128xf32, #sliceAd0>, tensor<128xi1, #sliceAd0>) -> tensor<128xf32, #sliceAd0>
+  %4 = "tt.atomic_rmw" (%2, %val, %mask) {atomic_rmw_op = 5 : i32} : (tensor<128x!tt.ptr<f32, 3>, #sliceAd0>, tensor<128xf32, #sliceAd0>, tensor<128xi1, #sliceAd0>) -> tensor<128xf32, #sliceAd0>
+  // CHECK-NEXT: Membar 7
+  %5 = tt.load %2 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #sliceAd0>
+  return
+}
+
+// The peers must have written their parts of a cluster-shared buffer before
+// it is gathered, and must not exit before the CTA is done reading theirs.
+// The cluster barriers also synchronize the CTA.
+// CHECK-LABEL: cluster_gather
+func @cluster_gather(%A : !tt.ptr<f16>, %i1 : i1) {
+  %a_ptr = tt.broadcast %A : (!tt.ptr<f16>) -> tensor<16x16x!tt.ptr<f16>, #AL>
+  %mask = tt.splat %i1 : (i1) -> tensor<16x16xi1, #AL>
+  %other = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #AL>
+  %tensor = triton_gpu.alloc_tensor : tensor<1x16x16xf16, #A_SHARED_CLUSTER>
+  %index = arith.constant 0 : i32
+  %zero = arith.constant 0 : index
+  %a = triton_gpu.insert_slice_async %a_ptr, %tensor, %index, %mask, %other {axis = 0 : i32, cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<16x16x!tt.ptr<f16>, #AL> -> tensor<1x16x16xf16, #A_SHARED_CLUSTER>
+  triton_gpu.async_wait {num = 0 : i32}
+  // CHECK-NOT: Membar
+  // CHECK: Cluster barrier 8
+  %b = triton_gpu.cluster_gather %a, %index {axis = 0 : i32} : tensor<1x16x16xf16, #A_SHARED_CLUSTER>
+  %c = tensor.extract_slice %b[%zero, 0, 0][1, 16, 16][1, 1, 1] : tensor<1x16x16xf16, #A_SHARED_CLUSTER> to tensor<16x16xf16, #A_SHARED_CLUSTER>
+  // CHECK-NEXT: Membar 11
+  %d = triton_gpu.convert_layout %c : (tensor<16x16xf16, #A_SHARED_CLUSTER>) -> tensor<16x16xf16, #AL>
+  // CHECK-NEXT: Cluster barrier 13
+  return
+}
+
 }
@@ -0,0 +1,53 @@
+// RUN: triton-opt %s -split-input-file --convert-triton-gpu-to-llvm | FileCheck %s
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [2, 1], order = [1, 0]}>
+#shared0 = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
+#mfma0 = #triton_gpu.mfma<{nonKDim = 32, warpsPerCTA = [1, 1]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#mfma0}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#mfma0}>
+module attributes {"triton_gpu.num-warps" = 2 : i32} {
+  // CHECK-LABEL: convert_dot_mfma_f16
+  func @convert_dot_mfma_f16(%A: tensor<32x16xf16, #blocked0>, %B: tensor<16x32xf16, #blocked0>) {
+    %AA = triton_gpu.convert_layout %A : (tensor<32x16xf16, #blocked0>) -> tensor<32x16xf16, #shared0>
+    %BB = triton_gpu.convert_layout %B : (tensor<16x32xf16, #blocked0>) -> tensor<16x32xf16, #shared0>
+    // $a is contiguous along k: one vectorized load per mfma
+    // CHECK-COUNT-2: llvm.load {{.*}} : !llvm.ptr<vector<4xf16>, 3>
+    %AA_DOT = triton_gpu.convert_layout %AA : (tensor<32x16xf16, #shared0>) -> tensor<32x16xf16, #dot_operand_a>
+    // $b is strided along k: scalar loads packed into a vector
+    // CHECK-COUNT-8: llvm.load {{.*}} : !llvm.ptr<f16, 3>
+    %BB_DOT = triton_gpu.convert_layout %BB : (tensor<16x32xf16, #shared0>) -> tensor<16x32xf16, #dot_operand_b>
+    %cst0 = arith.constant dense<0.000000e+00> : tensor<32x32xf32, #mfma0>
+
+    // CHECK: rocdl.mfma.f32.32x32x8f16
+    // CHECK-SAME: (vector<4xf16>, vector<4xf16>, vector<16xf32>, i32, i32, i32) -> vector<16xf32>
+    // CHECK: rocdl.mfma.f32.32x32x8f16
+    // CHECK-NOT: rocdl.mfma
+    %D = tt.dot %AA_DOT, %BB_DOT, %cst0 {allowTF32 = true, transA = false, transB = false} : tensor<32x16xf16, #dot_operand_a> * tensor<16x32xf16, #dot_operand_b> -> tensor<32x32xf32, #mfma0>
+
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#shared0 = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
+#mfma0 = #triton_gpu.mfma<{nonKDim = 32, warpsPerCTA = [2, 1]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#mfma0}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#mfma0}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: convert_dot_mfma_f32
+  func @convert_dot_mfma_f32(%A: tensor<64x16xf32, #blocked0>, %B: tensor<16x32xf32, #blocked0>) {
+    %AA = triton_gpu.convert_layout %A : (tensor<64x16xf32, #blocked0>) -> tensor<64x16xf32, #shared0>
+    %BB = triton_gpu.convert_layout %B : (tensor<16x32xf32, #blocked0>) -> tensor<16x32xf32, #shared0>
+    %AA_DOT = triton_gpu.convert_layout %AA : (tensor<64x16xf32, #shared0>) -> tensor<64x16xf32, #dot_operand_a>
+    %BB_DOT = triton_gpu.convert_layout %BB : (tensor<16x32xf32, #shared0>) -> tensor<16x32xf32, #dot_operand_b>
+    %cst0 = arith.constant dense<0.000000e+00> : tensor<64x32xf32, #mfma0>
+
+    // CHECK-COUNT-8: rocdl.mfma.f32.32x32x2f32
+    // CHECK-NOT: rocdl.mfma
+    %D = tt.dot %AA_DOT, %BB_DOT, %cst0 {allowTF32 = false, transA = false, transB = false} : tensor<64x16xf32, #dot_operand_a> * tensor<16x32xf32, #dot_operand_b> -> tensor<64x32xf32, #mfma0>
+
+    return
+  }
+}
@@ -18,3 +18,40 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
     return
   }
 }
+
+// -----
+
+// Check contiguous f16 atomic adds are issued in pairs.
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [2], threadsPerWarp = [64], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: @atomic_add_f16x2
+  func public @atomic_add_f16x2(%arg0: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg1 : tensor<512xf16, #blocked0>) {
+    %mask = arith.constant dense<true> : tensor<512xi1, #blocked0>
+    %0 = tt.make_range {end = 512 : i32, start = 0 : i32} : tensor<512xi32, #blocked0>
+    %1 = tt.splat %arg0 : (!tt.ptr<f16>) -> tensor<512x!tt.ptr<f16>, #blocked0>
+    %2 = tt.addptr %1, %0 : tensor<512x!tt.ptr<f16>, #blocked0>, tensor<512xi32, #blocked0>
+    // GCN: llvm.call @llvm.amdgcn.global.atomic.fadd.v2f16.p1v2f16.v2f16({{.*}}) : (!llvm.ptr<vector<2xf16>, 1>, vector<2xf16>) -> vector<2xf16>
+    // GCN-NOT: llvm.atomicrmw
+    %3 = "tt.atomic_rmw" (%2, %arg1, %mask) {atomic_rmw_op = 5 : i32} : (tensor<512x!tt.ptr<f16>, #blocked0>, tensor<512xf16, #blocked0>, tensor<512xi1, #blocked0>) -> tensor<512xf16, #blocked0>
+    return
+  }
+}
+
+// -----
+
+// Check f16 atomic adds stay scalar when the mask does not cover pairs.
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [2], threadsPerWarp = [64], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: @atomic_add_f16_masked
+  func public @atomic_add_f16_masked(%arg0: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg1 : tensor<512xf16, #blocked0>, %n : i32) {
+    %0 = tt.make_range {end = 512 : i32, start = 0 : i32} : tensor<512xi32, #blocked0>
+    %n_splat = tt.splat %n : (i32) -> tensor<512xi32, #blocked0>
+    %mask = arith.cmpi slt, %0, %n_splat : tensor<512xi32, #blocked0>
+    %1 = tt.splat %arg0 : (!tt.ptr<f16>) -> tensor<512x!tt.ptr<f16>, #blocked0>
+    %2 = tt.addptr %1, %0 : tensor<512x!tt.ptr<f16>, #blocked0>, tensor<512xi32, #blocked0>
+    // GCN-NOT: llvm.amdgcn.global.atomic.fadd.v2f16
+    // GCN: llvm.atomicrmw fadd
+    %3 = "tt.atomic_rmw" (%2, %arg1, %mask) {atomic_rmw_op = 5 : i32} : (tensor<512x!tt.ptr<f16>, #blocked0>, tensor<512xf16, #blocked0>, tensor<512xi1, #blocked0>) -> tensor<512xf16, #blocked0>
+    return
+  }
+}
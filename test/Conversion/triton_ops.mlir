@@ -101,6 +101,50 @@ func @reduce_ops_infer(%ptr: !tt.ptr<f32>, %v : tensor<1x2x4xf32>) {
   return
 }
 
+func @generic_reduce_ops_infer(%ptr: !tt.ptr<f32>, %v : tensor<2x4xf32>, %w : tensor<2x4xi32>) {
+  // Test if generic reduce ops infer the types of all their results
+  // CHECK: %{{.*}}:2 = "tt.generic_reduce"(%{{.*}}, %{{.*}}) ({
+  // CHECK: tt.generic_reduce.return %{{.*}}, %{{.*}} : f32, i32
+  // CHECK: }) {axis = 0 : i32} : (tensor<2x4xf32>, tensor<2x4xi32>) -> (tensor<4xf32>, tensor<4xi32>)
+  %a:2 = "tt.generic_reduce"(%v, %w) ({
+  ^bb0(%acc0: f32, %acc1: i32, %cur0: f32, %cur1: i32):
+    %0 = arith.addf %acc0, %cur0 : f32
+    %1 = arith.addi %acc1, %cur1 : i32
+    tt.generic_reduce.return %0, %1 : f32, i32
+  }) {axis = 0 : i32} : (tensor<2x4xf32>, tensor<2x4xi32>) -> (tensor<4xf32>, tensor<4xi32>)
+
+  %ptr4 = tt.splat %ptr : (!tt.ptr<f32>) -> tensor<4x!tt.ptr<f32>>
+  %b = arith.sitofp %a#1 : tensor<4xi32> to tensor<4xf32>
+  tt.store %ptr4, %a#0 : tensor<4xf32>
+  tt.store %ptr4, %b : tensor<4xf32>
+  return
+}
+
+func @scan_ops_infer(%ptr: !tt.ptr<f32>, %v : tensor<2x4xf32>) {
+  // Test if scan ops keep the types of their operands
+  // CHECK: %{{.*}} = "tt.scan"(%{{.*}}) ({
+  // CHECK: tt.scan.return %{{.*}} : f32
+  // CHECK: }) {axis = 1 : i32, reverse = true} : (tensor<2x4xf32>) -> tensor<2x4xf32>
+  %a = "tt.scan"(%v) ({
+  ^bb0(%acc: f32, %cur: f32):
+    %0 = arith.addf %acc, %cur : f32
+    tt.scan.return %0 : f32
+  }) {axis = 1 : i32, reverse = true} : (tensor<2x4xf32>) -> tensor<2x4xf32>
+
+  %ptr2x4 = tt.splat %ptr : (!tt.ptr<f32>) -> tensor<2x4x!tt.ptr<f32>>
+  tt.store %ptr2x4, %a : tensor<2x4xf32>
+  return
+}
+
+func @sort_ops_infer(%v : tensor<2x8xf32>, %i : tensor<2x8xi32>) {
+  // Test if sort ops shorten the axis of their operands to k
+  // CHECK: %{{.*}} = "tt.sort"(%{{.*}}) {axis = 1 : i32, descending = false} : (tensor<2x8xf32>) -> tensor<2x8xf32>
+  %a = "tt.sort"(%v) {axis = 1 : i32, descending = false} : (tensor<2x8xf32>) -> tensor<2x8xf32>
+  // CHECK: %{{.*}}:2 = "tt.sort"(%{{.*}}, %{{.*}}) {axis = 1 : i32, descending = true, k = 4 : i32} : (tensor<2x8xf32>, tensor<2x8xi32>) -> (tensor<2x4xf32>, tensor<2x4xi32>)
+  %b:2 = "tt.sort"(%v, %i) {axis = 1 : i32, descending = true, k = 4 : i32} : (tensor<2x8xf32>, tensor<2x8xi32>) -> (tensor<2x4xf32>, tensor<2x4xi32>)
+  return
+}
+
 func @dot_ops_infer(%ptr: !tt.ptr<f32>, %v : f32) {
   // Test if reduce ops infer types correctly
   %v128x32 = tt.splat %v : (f32) -> tensor<128x32xf32>
@@ -1,7 +1,10 @@
 // RUN: triton-opt %s -split-input-file -convert-triton-to-tritongpu=num-warps=2 | FileCheck %s
+// RUN: triton-opt %s -split-input-file -convert-triton-to-tritongpu="num-warps=2 threads-per-warp=64" | FileCheck %s --check-prefix=W64
+// RUN: triton-opt %s -split-input-file -convert-triton-to-tritongpu="num-warps=2 min-blocks-per-sm=2 max-registers=128" | FileCheck %s --check-prefix=BOUNDS
 
 func @ops() {
-  // CHECK: module attributes {"triton_gpu.num-warps" = 2 : i32} {{.*}}
+  // CHECK: module attributes {"triton_gpu.num-warps" = 2 : i32, "triton_gpu.shared-banks" = 32 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {{.*}}
+  // BOUNDS: module attributes {"triton_gpu.max-registers" = 128 : i32, "triton_gpu.min-blocks-per-sm" = 2 : i32, "triton_gpu.num-warps" = 2 : i32, "triton_gpu.shared-banks" = 32 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {{.*}}
   %a = arith.constant dense<1.00e+00> : tensor<128x32xf16>
   %b = arith.constant dense<2.00e+00> : tensor<32x128xf16>
   %c = arith.constant dense<3.00e+00> : tensor<128x128xf32>
@@ -11,6 +14,20 @@ func @ops() {
 
 // -----
 
+// The batches of a batched dot are distributed over the warps, and the
+// matrices over the lanes of each warp
+
+func @batched_dot() {
+  // CHECK: #triton_gpu.blocked<{sizePerThread = [1, 4, 4], threadsPerWarp = [1, 4, 8], warpsPerCTA = [2, 1, 1], order = [2, 1, 0]}>
+  %a = arith.constant dense<1.00e+00> : tensor<4x32x32xf32>
+  %b = arith.constant dense<2.00e+00> : tensor<4x32x32xf32>
+  %c = arith.constant dense<3.00e+00> : tensor<4x32x32xf32>
+  %0 = tt.dot %a, %b, %c {allowTF32 = false} : tensor<4x32x32xf32> * tensor<4x32x32xf32> -> tensor<4x32x32xf32>
+  return
+}
+
+// -----
+
 func @load_ops(%ptr: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
   // Test if LoadOp is lowered properly (see #771)
   %ptrs = tt.splat %ptr : (!tt.ptr<f32>) -> tensor<128x!tt.ptr<f32>>
@@ -36,7 +53,8 @@ func @reduce_ops(%ptr: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
   // CHECK: #blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [4, 8], warpsPerCTA = [1, 2], order = [0, 1]}>
   // CHECK: #blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [8, 4], warpsPerCTA = [1, 2], order = [0, 1]}>
   // CHECK: #blocked2 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [16, 2], warpsPerCTA = [1, 2], order = [0, 1]}>
-  // CHECK: module attributes {"triton_gpu.num-warps" = 2 : i32} {{.*}}
+  // CHECK: module attributes {"triton_gpu.num-warps" = 2 : i32, "triton_gpu.shared-banks" = 32 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {{.*}}
+  // BOUNDS: module attributes {"triton_gpu.max-registers" = 128 : i32, "triton_gpu.min-blocks-per-sm" = 2 : i32, "triton_gpu.num-warps" = 2 : i32, "triton_gpu.shared-banks" = 32 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {{.*}}
   %c0 = arith.constant dense<1.00e+00> : tensor<4x4xf32>
   %c1 = arith.constant dense<2.00e+00> : tensor<8x2xf32>
   %c2 = arith.constant dense<3.00e+00> : tensor<16x16xf32>
@@ -51,3 +69,30 @@ func @reduce_ops(%ptr: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
 
   return
 }
+
+// -----
+
+// With 64 threads per warp, the default layouts cover 64 lanes per warp
+
+func @wave64() {
+  // W64: #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [64], warpsPerCTA = [2], order = [0]}>
+  // W64: module attributes {"triton_gpu.num-warps" = 2 : i32, "triton_gpu.shared-banks" = 32 : i32, "triton_gpu.threads-per-warp" = 64 : i32}
+  %0 = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32>
+  return
+}
+
+// -----
+
+// The joined dimension is held by each thread, and splitting it back needs no
+// layout conversion
+
+func @join_split() {
+  // CHECK: #[[JOINED:.*]] = #triton_gpu.blocked<{sizePerThread = [1, 2], threadsPerWarp = [32, 1], warpsPerCTA = [2, 1], order = [1, 0]}>
+  // CHECK: tt.join {{.*}} -> tensor<128x2xf32, #[[JOINED]]>
+  // CHECK-NOT: triton_gpu.convert_layout
+  %a = arith.constant dense<1.00e+00> : tensor<128xf32>
+  %b = arith.constant dense<2.00e+00> : tensor<128xf32>
+  %0 = tt.join %a, %b : (tensor<128xf32>, tensor<128xf32>) -> tensor<128x2xf32>
+  %1:2 = tt.split %0 : (tensor<128x2xf32>) -> (tensor<128xf32>, tensor<128xf32>)
+  return
+}
@@ -0,0 +1,96 @@
+// RUN: triton-opt %s -split-input-file --convert-triton-gpu-to-cpu | FileCheck %s
+
+// The program ids and the size of the grid are trailing arguments
+
+module attributes {"triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: llvm.func @program_ids
+  // CHECK-SAME: (%{{.*}}: !llvm.ptr<i32>, %[[X:.*]]: i32, %{{.*}}: i32, %{{.*}}: i32, %[[GX:.*]]: i32, %{{.*}}: i32, %{{.*}}: i32)
+  func @program_ids(%ptr: !tt.ptr<i32>) {
+    %0 = tt.get_program_id {axis = 0 : i32} : i32
+    %1 = tt.get_num_programs {axis = 0 : i32} : i32
+    // CHECK: llvm.add %[[X]], %[[GX]]
+    %2 = arith.addi %0, %1 : i32
+    // CHECK: llvm.store
+    tt.store %ptr, %2 : i32
+    return
+  }
+}
+
+// -----
+
+// Contiguous pointers are accessed by masked loads and stores of vectors,
+// and the others are gathered or scattered
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [1], warpsPerCTA = [1], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: llvm.func @load_store
+  func @load_store(%arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg1: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg2: i32) {
+    %c2 = arith.constant dense<2> : tensor<256xi32, #blocked0>
+    %0 = tt.make_range {end = 256 : i32, start = 0 : i32} : tensor<256xi32, #blocked0>
+    %1 = tt.splat %arg2 : (i32) -> tensor<256xi32, #blocked0>
+    // CHECK: llvm.icmp "slt" %{{.*}}, %{{.*}} : vector<256xi32>
+    %2 = "triton_gpu.cmpi"(%0, %1) {predicate = 2 : i64} : (tensor<256xi32, #blocked0>, tensor<256xi32, #blocked0>) -> tensor<256xi1, #blocked0>
+    %3 = tt.splat %arg0 : (!tt.ptr<f32>) -> tensor<256x!tt.ptr<f32>, #blocked0>
+    %4 = tt.addptr %3, %0 : tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xi32, #blocked0>
+    // CHECK: llvm.intr.masked.load %{{.*}}, %{{.*}}, %{{.*}} {alignment = 16 : i32} : (!llvm.ptr<vector<256xf32>>, vector<256xi1>, vector<256xf32>) -> vector<256xf32>
+    %5 = tt.load %4, %2 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<256xf32, #blocked0>
+    %6 = arith.muli %0, %c2 : tensor<256xi32, #blocked0>
+    %7 = tt.splat %arg1 : (!tt.ptr<f32>) -> tensor<256x!tt.ptr<f32>, #blocked0>
+    %8 = tt.addptr %7, %6 : tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xi32, #blocked0>
+    // CHECK: llvm.intr.masked.scatter %{{.*}}, %{{.*}}, %{{.*}} {alignment = 4 : i32} : vector<256xf32>, vector<256xi1> into !llvm.vec<256 x ptr<f32>>
+    tt.store %8, %5, %2 : tensor<256xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
+// Broadcasts are shuffles of the elements of their operand
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [1, 1], warpsPerCTA = [1, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: llvm.func @broadcast
+  func @broadcast(%arg0: tensor<2x1xf32, #blocked0>) {
+    // CHECK: llvm.shufflevector %{{.*}}, %{{.*}} [0 : i32, 0 : i32, 0 : i32, 1 : i32, 1 : i32, 1 : i32] : vector<2xf32>, vector<2xf32>
+    %0 = tt.broadcast %arg0 : (tensor<2x1xf32, #blocked0>) -> tensor<2x3xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
+// Dots accumulate the outer products of the columns of a and the rows of b
+// in a loop
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [1, 1], warpsPerCTA = [1, 1], order = [1, 0]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#blocked0}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#blocked0}>
+module attributes {"triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: llvm.func @dot
+  func @dot(%a: tensor<4x8xf32, #dot_operand_a>, %b: tensor<8x4xf32, #dot_operand_b>, %c: tensor<4x4xf32, #blocked0>) -> tensor<4x4xf32, #blocked0> {
+    // CHECK: llvm.alloca
+    // CHECK: llvm.alloca
+    // CHECK: llvm.br ^[[BODY:.*]](%{{.*}}, %{{.*}} : i32, vector<16xf32>)
+    // CHECK: ^[[BODY]](%[[K:.*]]: i32, %[[ACC:.*]]: vector<16xf32>):
+    // CHECK: "llvm.intr.fmuladd"(%{{.*}}, %{{.*}}, %[[ACC]])
+    // CHECK: llvm.cond_br
+    %d = tt.dot %a, %b, %c {allowTF32 = false, transA = false, transB = false} : tensor<4x8xf32, #dot_operand_a> * tensor<8x4xf32, #dot_operand_b> -> tensor<4x4xf32, #blocked0>
+    return %d : tensor<4x4xf32, #blocked0>
+  }
+}
+
+// -----
+
+// Reductions combine the slices across their axis
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [1, 1], warpsPerCTA = [1, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: llvm.func @reduce
+  func @reduce(%arg0: tensor<4x2xf32, #blocked0>) {
+    // CHECK: llvm.shufflevector %{{.*}}, %{{.*}} [0 : i32, 2 : i32, 4 : i32, 6 : i32]
+    // CHECK: llvm.shufflevector %{{.*}}, %{{.*}} [1 : i32, 3 : i32, 5 : i32, 7 : i32]
+    // CHECK: llvm.fadd %{{.*}}, %{{.*}} : vector<4xf32>
+    %0 = tt.reduce %arg0 {redOp = 2 : i32, axis = 1 : i32} : tensor<4x2xf32, #blocked0> -> tensor<4xf32, #triton_gpu.slice<{dim = 1, parent = #blocked0}>>
+    return
+  }
+}
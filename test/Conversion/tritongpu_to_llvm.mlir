@@ -1,7 +1,7 @@
 // RUN: triton-opt %s -split-input-file --convert-triton-gpu-to-llvm | FileCheck --check-prefixes=CHECK,GCN %s
 
 module attributes {"triton_gpu.num-warps" = 4 : i32} {
-  // CHECK: llvm.func @test_empty_kernel(%arg0: i32, %arg1: !llvm.ptr<f16, 1>)
+  // CHECK: llvm.func @test_empty_kernel(%arg0: i32, %arg1: !llvm.ptr<f16, 1> {llvm.readonly, tt.readonly})
   // Here the 128 comes from the 4 in module attribute multiples 32
   // PTX:  attributes {nvvm.kernel = 1 : ui1, nvvm.maxntid = 128 : i32} {{.*}}
   func @test_empty_kernel(%lb : index, %A : !tt.ptr<f16>) {
@@ -12,6 +12,20 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
 
 // -----
 
+// The launch bounds are attributes of the kernel: 2 programs of 4 waves
+// need 2 waves per SIMD of AMD GPUs
+
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.min-blocks-per-sm" = 2 : i32, "triton_gpu.max-registers" = 128 : i32} {
+  // CHECK-LABEL: llvm.func @test_launch_bounds
+  // PTX-SAME: attributes {nvvm.kernel = 1 : ui1, nvvm.maxnreg = 128 : i32, nvvm.maxntid = 128 : i32, nvvm.minctasm = 2 : i32}
+  // GCN-SAME: attributes {nvvm.kernel = 1 : ui1, nvvm.maxnreg = 128 : i32, nvvm.maxntid = 128 : i32, nvvm.minctasm = 2 : i32, rocdl.waves_per_eu = 2 : i32}
+  func @test_launch_bounds(%lb : index) {
+    return
+  }
+}
+
+// -----
+
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
 module attributes {"triton_gpu.num-warps" = 4 : i32} {
   // CHECK-LABEL: basic_load
@@ -87,6 +101,61 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
 
 // -----
 
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: global_load_l2_evict_last
+  func @global_load_l2_evict_last(%ptr : tensor<128x!tt.ptr<f32>, #blocked0>) {
+    // PTX: createpolicy.fractional.L2::evict_last.b64 $0, 0f3F000000;
+    // PTX: ld.global.L2::cache_hint.b32
+    %0 = tt.load %ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false, l2EvictLastFraction = 5.000000e-01 : f32} : tensor<128xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
+// Arguments never stored to are read-only, and loads through read-only
+// arguments aliasing no other argument are non-coherent
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK: llvm.func @global_load_non_coherent(%arg0: !llvm.ptr<f32, 1> {llvm.noalias, llvm.readonly, tt.noalias = 1 : i32, tt.readonly}, %arg1: !llvm.ptr<f32, 1> {llvm.readonly, tt.readonly}, %arg2: !llvm.ptr<f32, 1> {tt.noalias = 1 : i32})
+  func @global_load_non_coherent(%arg0: !tt.ptr<f32> {tt.noalias = 1 : i32}, %arg1: !tt.ptr<f32>, %arg2: !tt.ptr<f32> {tt.noalias = 1 : i32}) {
+    %0 = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32, #blocked0>
+    %1 = tt.splat %arg0 : (!tt.ptr<f32>) -> tensor<128x!tt.ptr<f32>, #blocked0>
+    %2 = tt.addptr %1, %0 : tensor<128x!tt.ptr<f32>, #blocked0>, tensor<128xi32, #blocked0>
+    %3 = tt.splat %arg1 : (!tt.ptr<f32>) -> tensor<128x!tt.ptr<f32>, #blocked0>
+    %4 = tt.addptr %3, %0 : tensor<128x!tt.ptr<f32>, #blocked0>, tensor<128xi32, #blocked0>
+    %5 = tt.splat %arg2 : (!tt.ptr<f32>) -> tensor<128x!tt.ptr<f32>, #blocked0>
+    %6 = tt.addptr %5, %0 : tensor<128x!tt.ptr<f32>, #blocked0>, tensor<128xi32, #blocked0>
+    // PTX: ld.global.nc.b32
+    %7 = tt.load %2 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked0>
+    // PTX: ld.global.b32
+    %8 = tt.load %4 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked0>
+    // PTX: ld.global.b32
+    %9 = tt.load %6 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked0>
+    %10 = arith.addf %7, %8 : tensor<128xf32, #blocked0>
+    %11 = arith.addf %10, %9 : tensor<128xf32, #blocked0>
+    tt.store %6, %11 : tensor<128xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: global_store_cache_hints
+  func @global_store_cache_hints(%ptr : tensor<128x!tt.ptr<f32>, #blocked0>, %val : tensor<128xf32, #blocked0>) {
+    // GCN: llvm.store {{.*}}nontemporal
+    // PTX: st.global.cs.L1::evict_first.b32
+    tt.store %ptr, %val {cache = 5 : i32, evict = 2 : i32} : tensor<128xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [2], order = [0]}>
 module attributes {"triton_gpu.num-warps" = 2 : i32} {
   // CHECK-LABEL: global_load_store_no_vec
@@ -324,6 +393,60 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
 
 // -----
 
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 2], threadsPerWarp = [32, 1], warpsPerCTA = [4, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: basic_join_split
+  func @basic_join_split(%a : tensor<256xf32, #blocked0>, %b : tensor<256xf32, #blocked0>) {
+    // CHECK: %[[A0:.*]] = llvm.extractvalue
+    // CHECK-NEXT: %[[A1:.*]] = llvm.extractvalue
+    // CHECK-NEXT: %[[B0:.*]] = llvm.extractvalue
+    // CHECK-NEXT: %[[B1:.*]] = llvm.extractvalue
+    // CHECK: llvm.insertvalue %[[A0]]
+    // CHECK-NEXT: llvm.insertvalue %[[B0]]
+    // CHECK-NEXT: llvm.insertvalue %[[A1]]
+    // CHECK-NEXT: llvm.insertvalue %[[B1]]
+    %0 = tt.join %a, %b : (tensor<256xf32, #blocked0>, tensor<256xf32, #blocked0>) -> tensor<256x2xf32, #blocked1>
+    // CHECK-NOT: llvm.store
+    // CHECK-COUNT-4: llvm.extractvalue
+    // CHECK-COUNT-4: llvm.insertvalue
+    %1:2 = tt.split %0 : (tensor<256x2xf32, #blocked1>) -> (tensor<256xf32, #blocked0>, tensor<256xf32, #blocked0>)
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // The halves of an ordered cat are held by the threads holding its operands
+  // CHECK-LABEL: basic_ordered_cat
+  func @basic_ordered_cat(%a : tensor<256xf32, #blocked0>, %b : tensor<256xf32, #blocked0>) {
+    // CHECK: %[[A0:.*]] = llvm.extractvalue
+    // CHECK-NEXT: %[[A1:.*]] = llvm.extractvalue
+    // CHECK-NEXT: %[[B0:.*]] = llvm.extractvalue
+    // CHECK-NEXT: %[[B1:.*]] = llvm.extractvalue
+    // CHECK: llvm.insertvalue %[[A0]]
+    // CHECK-NEXT: llvm.insertvalue %[[A1]]
+    // CHECK-NEXT: llvm.insertvalue %[[B0]]
+    // CHECK-NEXT: llvm.insertvalue %[[B1]]
+    %0 = tt.cat %a, %b {axis = 0 : i32} : (tensor<256xf32, #blocked0>, tensor<256xf32, #blocked0>) -> tensor<512xf32, #blocked0>
+    return
+  }
+
+  // Operands smaller than the layout are wrapped around: the upper half of
+  // the threads select $rhs
+  // CHECK-LABEL: wrapped_ordered_cat
+  func @wrapped_ordered_cat(%a : tensor<32xf32, #blocked0>, %b : tensor<32xf32, #blocked0>) {
+    // CHECK: llvm.icmp "uge"
+    // CHECK: llvm.select
+    %0 = tt.cat %a, %b {axis = 0 : i32} : (tensor<32xf32, #blocked0>, tensor<32xf32, #blocked0>) -> tensor<64xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [2], threadsPerWarp = [32], warpsPerCTA = [1], order = [0]}>
 module attributes {"triton_gpu.num-warps" = 4 : i32} {
   // CHECK-LABEL: basic_make_range
@@ -365,6 +488,23 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
 
 // -----
 
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: uniform_addi
+  func @uniform_addi(%arg0 : i32, %arg1 : i32) {
+    // GCN: llvm.call @llvm.amdgcn.readfirstlane
+    // GCN: llvm.call @llvm.amdgcn.readfirstlane
+    // CHECK: llvm.add
+    // CHECK-NOT: llvm.add
+    %0 = tt.splat %arg0 : (i32) -> tensor<256xi32,#blocked0>
+    %1 = tt.splat %arg1 : (i32) -> tensor<256xi32,#blocked0>
+    %2 = arith.addi %0, %1 : tensor<256xi32,#blocked0>
+    return
+  }
+}
+
+// -----
+
 module attributes {"triton_gpu.num-warps" = 4 : i32} {
   // CHECK-LABEL: basic_program_id
   func @basic_program_id() {
@@ -749,28 +889,62 @@ module attributes {"triton_gpu.num-warps" = 1 : i32} {
 
 // -----
 
-#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [8, 4], warpsPerCTA = [1, 1], order = [1, 0]}>
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [16, 2], warpsPerCTA = [1, 1], order = [1, 0]}>
 #blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [1, 1], order = [1, 0]}>
 module attributes {"triton_gpu.num-warps" = 1 : i32} {
   // CHECK: llvm.mlir.global external @global_smem() {addr_space = 3 : i32} : !llvm.array<0 x i8>
   // CHECK-LABEL: convert_layout_blocked_blocked_multi_rep
   func @convert_layout_blocked_blocked_multi_rep(%arg0: tensor<16x16xf32, #blocked0>) {
+    // The whole tensor fits in the scratch buffer: all the replicas are
+    // stored, then loaded after a single barrier
     // CHECK: llvm.mlir.addressof @global_smem
-    // CHECK: llvm.store
-    // CHECK-SAME: !llvm.ptr<vector<4xf32>, 3>
-    // PTX: nvvm.barrier0
-    // CHECK: llvm.load
-    // CHECK-SAME: !llvm.ptr<vector<4xf32>, 3>
-    // CHECK: llvm.load
-    // CHECK-SAME: !llvm.ptr<vector<4xf32>, 3>
+    // CHECK-COUNT-2: llvm.store {{.*}} : !llvm.ptr<vector<4xf32>, 3>
+    // CHECK-NOT: llvm.load
     // PTX: nvvm.barrier0
+    // PTX-NOT: nvvm.barrier0
+    // CHECK-COUNT-4: llvm.load {{.*}} : !llvm.ptr<vector<4xf32>, 3>
+    // CHECK-NOT: llvm.store
+    %0 = triton_gpu.convert_layout %arg0 : (tensor<16x16xf32, #blocked0>) -> tensor<16x16xf32, #blocked1>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [8, 4], warpsPerCTA = [1, 1], order = [1, 0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [1, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: convert_layout_blocked_blocked_warp_shuffle
+  func @convert_layout_blocked_blocked_warp_shuffle(%arg0: tensor<16x16xf32, #blocked0>) {
+    // Each element of the result is held by the same register of another
+    // lane: one shuffle per element, no shared memory
+    // CHECK-NOT: llvm.store
+    // CHECK-NOT: rocdl.barrier
+    // GCN-COUNT-16: ds_bpermute_b32
+    // PTX-COUNT-16: shfl.sync.idx.b32
+    // CHECK-NOT: llvm.load
+    // CHECK-NOT: ds_bpermute_b32
+    %0 = triton_gpu.convert_layout %arg0 : (tensor<16x16xf32, #blocked0>) -> tensor<16x16xf32, #blocked1>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [8, 4], warpsPerCTA = [1, 1], order = [1, 0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [2, 2], threadsPerWarp = [4, 8], warpsPerCTA = [1, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: convert_layout_blocked_blocked_warp_local
+  func @convert_layout_blocked_blocked_warp_local(%arg0: tensor<16x16xf32, #blocked0>) {
+    // Both layouts cover the same 8x16 tile per warp: warp barriers only
     // CHECK: llvm.store
-    // CHECK-SAME: !llvm.ptr<vector<4xf32>, 3>
-    // PTX: nvvm.barrier0
+    // GCN-NOT: rocdl.barrier
+    // GCN: llvm.fence syncscope("wavefront") acq_rel
+    // PTX: bar.warp.sync
     // CHECK: llvm.load
-    // CHECK-SAME: !llvm.ptr<vector<4xf32>, 3>
-    // CHECK: llvm.load
-    // CHECK-SAME: !llvm.ptr<vector<4xf32>, 3>
+    // GCN-NOT: rocdl.barrier
+    // GCN-NOT: llvm.fence
+    // PTX-NOT: bar.warp.sync
     %0 = triton_gpu.convert_layout %arg0 : (tensor<16x16xf32, #blocked0>) -> tensor<16x16xf32, #blocked1>
     return
   }
@@ -877,6 +1051,21 @@ module attributes {"triton_gpu.num-warps" = 1 : i32} {
 
 // -----
 
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [8, 4], warpsPerCTA = [1, 1], order = [1, 0]}>
+#shared0 = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: convert_layout_blocked_shared_unswizzled
+  func @convert_layout_blocked_shared_unswizzled(%arg0: tensor<32x32xf16, #blocked0>) {
+    // Rows are contiguous without swizzling: vec doesn't limit the stores
+    // CHECK-COUNT-4: llvm.store {{.*}} : !llvm.ptr<vector<8xf16>, 3>
+    // CHECK-NOT: llvm.store
+    %0 = triton_gpu.convert_layout %arg0 : (tensor<32x32xf16, #blocked0>) -> tensor<32x32xf16, #shared0>
+    return
+  }
+}
+
+// -----
+
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [1], order = [0]}>
 #blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [1, 1], order = [1, 0]}>
 module attributes {"triton_gpu.num-warps" = 1 : i32} {
@@ -946,6 +1135,38 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
 
 // -----
 
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [4, 1], order = [1, 0]}>
+#shared = #triton_gpu.shared<{vec = 8, perPhase = 1, maxPhase = 8, order = [1, 0]}>
+#mma = #triton_gpu.mma<{versionMajor = 3, warpsPerCTA = [4, 1]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#mma}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#mma}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: matmul_wgmma
+  func @matmul_wgmma(%ptr:!tt.ptr<f32> {tt.divisibility = 16 : i32},
+    %a:tensor<128x64xf16, #shared>, %b:tensor<64x64xf16, #shared>) {
+    %cst = arith.constant dense<0.000000e+00> : tensor<128x64xf32, #mma>
+    // PTX: ldmatrix.sync.aligned.m8n8.x4.shared.b16
+    // PTX-NOT: ldmatrix
+    %a_mat = triton_gpu.convert_layout %a : (tensor<128x64xf16, #shared>) -> tensor<128x64xf16, #dot_operand_a>
+    %b_mat = triton_gpu.convert_layout %b : (tensor<64x64xf16, #shared>) -> tensor<64x64xf16, #dot_operand_b>
+
+    // PTX: fence.proxy.async.shared::cta
+    // PTX: wgmma.fence.sync.aligned
+    // PTX-COUNT-8: wgmma.mma_async.sync.aligned.m64n64k16.f32.f16.f16
+    // PTX: wgmma.commit_group.sync.aligned
+    // PTX: wgmma.wait_group.sync.aligned 0
+    %28 = tt.dot %a_mat, %b_mat, %cst {allowTF32 = true, transA = false, transB = false} : tensor<128x64xf16, #dot_operand_a> * tensor<64x64xf16, #dot_operand_b> -> tensor<128x64xf32, #mma>
+    %38 = triton_gpu.convert_layout %28 : (tensor<128x64xf32, #mma>) -> tensor<128x64xf32, #blocked>
+
+    %30 = tt.splat %ptr : (!tt.ptr<f32>) -> tensor<128x1x!tt.ptr<f32>, #blocked>
+    %36 = tt.broadcast %30 : (tensor<128x1x!tt.ptr<f32>, #blocked>) -> tensor<128x64x!tt.ptr<f32>, #blocked>
+    tt.store %36, %38 : tensor<128x64xf32, #blocked>
+    return
+  }
+}
+
+// -----
+
 #blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [1, 4], order = [1, 0]}>
 #shared0 = #triton_gpu.shared<{vec = 4, perPhase = 1, maxPhase = 8, order = [1, 0]}>
 #shared1 = #triton_gpu.shared<{vec = 8, perPhase = 1, maxPhase = 4, order = [1, 0]}>
@@ -994,6 +1215,71 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
 
 // -----
 
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [1, 4], order = [1, 0]}>
+#shared = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#blocked}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#blocked}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // Groups of 4 int8 along k are packed into i32 and reduced by dp4a
+  // CHECK-LABEL: matmul_fmadot_int8
+  func @matmul_fmadot_int8(%a:tensor<32x16xi8, #shared>, %b:tensor<16x32xi8, #shared>) {
+    %cst = arith.constant dense<0> : tensor<32x32xi32, #blocked>
+    %a_mat = triton_gpu.convert_layout %a : (tensor<32x16xi8, #shared>) -> tensor<32x16xi8, #dot_operand_a>
+    %b_mat = triton_gpu.convert_layout %b : (tensor<16x32xi8, #shared>) -> tensor<16x32xi8, #dot_operand_b>
+    // CHECK: llvm.bitcast %{{.*}} : vector<4xi8> to i32
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: dp4a.s32.s32
+    // CHECK-NOT: llvm.mul
+    %28 = tt.dot %a_mat, %b_mat, %cst {allowTF32 = false, transA = false, transB = false} : tensor<32x16xi8, #dot_operand_a> * tensor<16x32xi8, #dot_operand_b> -> tensor<32x32xi32, #blocked>
+    return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [1, 4], order = [1, 0]}>
+#shared = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#blocked}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#blocked}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // f16 operands keep their element type and are widened to f32 by the dot
+  // CHECK-LABEL: matmul_fmadot_f16
+  func @matmul_fmadot_f16(%a:tensor<32x16xf16, #shared>, %b:tensor<16x32xf16, #shared>) {
+    %cst = arith.constant dense<0.000000e+00> : tensor<32x32xf32, #blocked>
+    %a_mat = triton_gpu.convert_layout %a : (tensor<32x16xf16, #shared>) -> tensor<32x16xf16, #dot_operand_a>
+    %b_mat = triton_gpu.convert_layout %b : (tensor<16x32xf16, #shared>) -> tensor<16x32xf16, #dot_operand_b>
+    // CHECK: llvm.fpext %{{.*}} : f16 to f32
+    // CHECK: llvm.intr.fmuladd
+    // CHECK-SAME: (f32, f32, f32) -> f32
+    %28 = tt.dot %a_mat, %b_mat, %cst {allowTF32 = false, transA = false, transB = false} : tensor<32x16xf16, #dot_operand_a> * tensor<16x32xf16, #dot_operand_b> -> tensor<32x32xf32, #blocked>
+    return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [1, 4], order = [1, 0]}>
+#shared = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#blocked}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#blocked}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // bf16 operands are held as i16 and bitcast back before being widened
+  // CHECK-LABEL: matmul_fmadot_bf16
+  func @matmul_fmadot_bf16(%a:tensor<32x16xbf16, #shared>, %b:tensor<16x32xbf16, #shared>) {
+    %cst = arith.constant dense<0.000000e+00> : tensor<32x32xf32, #blocked>
+    %a_mat = triton_gpu.convert_layout %a : (tensor<32x16xbf16, #shared>) -> tensor<32x16xbf16, #dot_operand_a>
+    %b_mat = triton_gpu.convert_layout %b : (tensor<16x32xbf16, #shared>) -> tensor<16x32xbf16, #dot_operand_b>
+    // CHECK: llvm.bitcast %{{.*}} : i16 to bf16
+    // CHECK-NEXT: llvm.fpext %{{.*}} : bf16 to f32
+    // CHECK: llvm.intr.fmuladd
+    // CHECK-SAME: (f32, f32, f32) -> f32
+    %28 = tt.dot %a_mat, %b_mat, %cst {allowTF32 = false, transA = false, transB = false} : tensor<32x16xbf16, #dot_operand_a> * tensor<16x32xbf16, #dot_operand_b> -> tensor<32x32xf32, #blocked>
+    return
+  }
+}
+
+// -----
+
 #mma = #triton_gpu.mma<{versionMajor=2, warpsPerCTA=[2, 2]}>
 #shared = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
 #blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [1, 4], order = [1, 0]}>
@@ -1033,6 +1319,29 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
 
 // -----
 
+#mma = #triton_gpu.mma<{versionMajor=2, warpsPerCTA=[2, 2]}>
+#shared = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#mma}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#mma}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // The operands are split into tf32 values and their remainders, and each of
+  // the 4 tiles takes 3 mma
+  // CHECK-LABEL: matmul_tf32x3dot
+  func @matmul_tf32x3dot(%a:tensor<32x16xf32, #shared>, %b:tensor<16x32xf32, #shared>) {
+    %cst = arith.constant dense<0.000000e+00> : tensor<32x32xf32, #mma>
+    %a_mat = triton_gpu.convert_layout %a : (tensor<32x16xf32, #shared>) -> tensor<32x16xf32, #dot_operand_a>
+    %b_mat = triton_gpu.convert_layout %b : (tensor<16x32xf32, #shared>) -> tensor<16x32xf32, #dot_operand_b>
+    // CHECK: llvm.and %{{.*}}, %{{.*}} : i32
+    // CHECK: llvm.fsub %{{.*}}, %{{.*}} : f32
+    // CHECK-COUNT-12: mma.sync.aligned.m16n8k8.row.col.f32.tf32.tf32.f32
+    // CHECK-NOT: mma.sync
+    %28 = tt.dot %a_mat, %b_mat, %cst {allowTF32 = true, precision = 2 : i32, transA = false, transB = false} : tensor<32x16xf32, #dot_operand_a> * tensor<16x32xf32, #dot_operand_b> -> tensor<32x32xf32, #mma>
+    return
+  }
+}
+
+// -----
+
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
 module attributes {"triton_gpu.num-warps" = 4 : i32} {
   // CHECK-LABEL: atomic_add_f32
@@ -1044,6 +1353,84 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
   }
 }
 
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: atomic_add_f32_aggregate
+  func @atomic_add_f32_aggregate(%arg0 : tensor<256x!tt.ptr<f32>, #blocked0>, %arg1 : tensor<256xi1, #blocked0>, %arg2 : tensor<256xf32, #blocked0>) {
+    // CHECK: match.any.sync.b64
+    // CHECK: vote.sync.ballot.b32
+    // CHECK: llvm.intr.ctpop
+    // CHECK-COUNT-5: shfl.sync.idx.b32
+    // CHECK: atom.global.gpu.add.f32
+    %0 = "tt.atomic_rmw" (%arg0, %arg2, %arg1) {atomic_rmw_op = 5 : i32, tt.aggregate = true} : (tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xf32, #blocked0>, tensor<256xi1, #blocked0>) -> tensor<256xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: atomic_sem
+  func @atomic_sem(%arg0 : tensor<256x!tt.ptr<i64>, #blocked0>, %arg1 : tensor<256xi1, #blocked0>, %arg2 : tensor<256xi64, #blocked0>) {
+    // CHECK: atom.global.gpu.release.exch.b64
+    %0 = "tt.atomic_rmw" (%arg0, %arg2, %arg1) {atomic_rmw_op = 10 : i32, sem = 3 : i32} : (tensor<256x!tt.ptr<i64>, #blocked0>, tensor<256xi64, #blocked0>, tensor<256xi1, #blocked0>) -> tensor<256xi64, #blocked0>
+    // CHECK: atom.global.gpu.acquire.or.b64
+    %1 = "tt.atomic_rmw" (%arg0, %arg2, %arg1) {atomic_rmw_op = 2 : i32, sem = 2 : i32} : (tensor<256x!tt.ptr<i64>, #blocked0>, tensor<256xi64, #blocked0>, tensor<256xi1, #blocked0>) -> tensor<256xi64, #blocked0>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: atomic_scope
+  func @atomic_scope(%arg0 : tensor<256x!tt.ptr<i32>, #blocked0>, %arg1 : tensor<256xi1, #blocked0>, %arg2 : tensor<256xi32, #blocked0>, %arg3 : !tt.ptr<i32>, %arg4 : i32) {
+    // CHECK: atom.global.sys.release.exch.b32
+    %0 = "tt.atomic_rmw" (%arg0, %arg2, %arg1) {atomic_rmw_op = 10 : i32, sem = 3 : i32, scope = 3 : i32} : (tensor<256x!tt.ptr<i32>, #blocked0>, tensor<256xi32, #blocked0>, tensor<256xi1, #blocked0>) -> tensor<256xi32, #blocked0>
+    // CHECK: membar.sys
+    // CHECK: atom.global.sys.acquire.cas.b32
+    %1 = "tt.atomic_cas" (%arg3, %arg4, %arg4) {sem = 2 : i32, scope = 3 : i32} : (!tt.ptr<i32>, i32, i32) -> i32
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: atomic_add_scratch
+  func @atomic_add_scratch(%arg0 : tensor<256xi32, #blocked0>, %arg1 : tensor<256xi1, #blocked0>, %arg2 : tensor<256xf32, #blocked0>) {
+    // CHECK: llvm.mlir.addressof @global_smem
+    %0 = tt.scratch {size = 64 : i32} : !tt.ptr<f32, 3>
+    %1 = tt.splat %0 : (!tt.ptr<f32, 3>) -> tensor<256x!tt.ptr<f32, 3>, #blocked0>
+    %2 = tt.addptr %1, %arg0 : tensor<256x!tt.ptr<f32, 3>, #blocked0>, tensor<256xi32, #blocked0>
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: atom.shared.cta.add.f32
+    // Shared addresses are 32-bit
+    // CHECK-SAME: "=r,r,r,b"
+    %3 = "tt.atomic_rmw" (%2, %arg2, %arg1) {atomic_rmw_op = 5 : i32} : (tensor<256x!tt.ptr<f32, 3>, #blocked0>, tensor<256xf32, #blocked0>, tensor<256xi1, #blocked0>) -> tensor<256xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [2], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: philox
+  func @philox(%c0 : tensor<256xi32, #blocked0>, %zero : tensor<256xi32, #blocked0>, %k0 : tensor<256xi32, #blocked0>, %k1 : tensor<256xi32, #blocked0>) {
+    // 2 rounds of 2 products for each of the 2 elements of the thread
+    // CHECK-COUNT-8: mul.wide.u32 $0, $1, 0x
+    // CHECK-NOT: mul.wide.u32
+    %0:4 = tt.philox %c0, %zero, %zero, %zero, %k0, %k1 {n_rounds = 2 : i32} : tensor<256xi32, #blocked0>
+    return
+  }
+}
+
 // -----
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
 module attributes {"triton_gpu.num-warps" = 4 : i32} {
@@ -1084,6 +1471,76 @@ module attributes {"triton_gpu.num-warps" = 4 : i32} {
   }
 }
 
+// -----
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK: llvm.mlir.global internal @grid_barrier_counter(0 : i32) {addr_space = 1 : i32} : i32
+  // CHECK-LABEL: test_grid_barrier
+  func @test_grid_barrier() {
+    // CHECK: nvvm.barrier0
+    // CHECK: llvm.fence release
+    // CHECK: llvm.atomicrmw add
+    // CHECK: llvm.load volatile
+    // CHECK: llvm.xor
+    // CHECK: llvm.fence acquire
+    // CHECK: nvvm.barrier0
+    tt.grid_barrier
+    return
+  }
+}
+
+// -----
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK: llvm.mlir.global external @triton_profile_buffer(0 : i64) {addr_space = 1 : i32} : i64
+  // CHECK-LABEL: test_profile_region
+  func @test_profile_region() {
+    // The entry starts the prologue
+    // CHECK: nvvm.read.ptx.sreg.tid.x
+    // CHECK: llvm.cond_br
+    // CHECK: llvm.inline_asm has_side_effects {{.*}}%clock64
+    // CHECK-NOT: llvm.sub
+    // CHECK: llvm.store
+    // CHECK: llvm.br
+    // Entering the region adds the cycles of the prologue
+    // CHECK: llvm.inline_asm has_side_effects {{.*}}%clock64
+    // CHECK: llvm.sub
+    // CHECK: llvm.store
+    // CHECK: llvm.mlir.constant(1 : i64)
+    tt.profile_region "main_loop"
+    // And the return those of the region
+    // CHECK: llvm.inline_asm has_side_effects {{.*}}%clock64
+    // CHECK: llvm.sub
+    // CHECK: llvm.return
+    return
+  }
+}
+
+// -----
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [2], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK: llvm.mlir.global external @triton_trace_buffer(0 : i64) {addr_space = 1 : i32} : i64
+  // CHECK-LABEL: test_trace
+  func @test_trace(%x: tensor<256xf32, #blocked0>, %n: i64) {
+    // With scalars only, the first thread writes the header and the two
+    // words of %n
+    // CHECK: llvm.cond_br
+    // CHECK: llvm.atomicrmw add
+    // CHECK: llvm.urem
+    // CHECK-COUNT-5: llvm.store
+    // CHECK: llvm.br
+    tt.trace "n" %n : i64
+    // With tensors, every thread writes the header and its 2 elements with
+    // their indices
+    // CHECK-NOT: llvm.cond_br
+    // CHECK: llvm.atomicrmw add
+    // CHECK: llvm.urem
+    // CHECK-COUNT-7: llvm.store
+    // CHECK-NOT: llvm.store
+    // CHECK: llvm.return
+    tt.trace "x" %x : tensor<256xf32, #blocked0>
+    return
+  }
+}
+
 // -----
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [2], threadsPerWarp = [32], warpsPerCTA = [1], order = [0]}>
 module attributes {"triton_gpu.num-warps" = 4 : i32} {
@@ -1126,3 +1583,168 @@ module attributes {"triton_gpu.num-warps" = 1 : i32} {
     return
   }
 }
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: reduce_intra_warp
+  func @reduce_intra_warp(%arg0: tensor<16x32xf32, #blocked0>) {
+    // A single warp covers the axis: butterfly shuffles, no shared memory
+    // CHECK-NOT: llvm.store
+    // GCN-COUNT-3: ds_swizzle_b32
+    // CHECK-NOT: ds_swizzle_b32
+    // CHECK-NOT: nvvm.barrier0
+    // CHECK: llvm.return
+    %0 = tt.reduce %arg0 {redOp = 2 : i32, axis = 1 : i32} : tensor<16x32xf32, #blocked0> -> tensor<16xf32, #triton_gpu.slice<{dim = 1, parent = #blocked0}>>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: reduce_inter_warp
+  func @reduce_inter_warp(%arg0: tensor<64x32xf32, #blocked0>) {
+    // Shuffles across the 4 lanes along the axis for each of the 4 columns,
+    // a single exchange through shared memory, then shuffles across the 4
+    // warps
+    // GCN-COUNT-8: ds_swizzle_b32
+    // CHECK: nvvm.barrier0
+    // GCN-COUNT-2: ds_swizzle_b32
+    // CHECK: nvvm.barrier0
+    // CHECK-NOT: nvvm.barrier0
+    // CHECK: llvm.return
+    %0 = tt.reduce %arg0 {redOp = 2 : i32, axis = 0 : i32} : tensor<64x32xf32, #blocked0> -> tensor<32xf32, #triton_gpu.slice<{dim = 0, parent = #blocked0}>>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: generic_reduce_intra_warp
+  func @generic_reduce_intra_warp(%arg0: tensor<16x32xf32, #blocked0>, %arg1: tensor<16x32xf32, #blocked0>) {
+    // Both operands go through the butterfly, and the combine function is
+    // inlined at every step
+    // CHECK-NOT: llvm.store
+    // CHECK-COUNT-3: llvm.fadd
+    // GCN-COUNT-6: ds_swizzle_b32
+    // CHECK-NOT: nvvm.barrier0
+    // CHECK: llvm.fmul
+    // CHECK: llvm.return
+    %0:2 = "tt.generic_reduce"(%arg0, %arg1) ({
+    ^bb0(%acc0: f32, %acc1: f32, %cur0: f32, %cur1: f32):
+      %1 = arith.addf %acc0, %cur0 : f32
+      %2 = arith.mulf %acc1, %cur1 : f32
+      tt.generic_reduce.return %1, %2 : f32, f32
+    }) {axis = 1 : i32} : (tensor<16x32xf32, #blocked0>, tensor<16x32xf32, #blocked0>) -> (tensor<16xf32, #triton_gpu.slice<{dim = 1, parent = #blocked0}>>, tensor<16xf32, #triton_gpu.slice<{dim = 1, parent = #blocked0}>>)
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [1, 4], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: scan_inter_warp
+  func @scan_inter_warp(%arg0: tensor<16x128xf32, #blocked0>) {
+    // Sequential scan of the 4 elements of each of the 4 rows of a thread,
+    // carries of the 8 lanes along the axis, then a single exchange of the
+    // totals of the 4 warps
+    // CHECK-COUNT-12: llvm.fadd
+    // GCN-COUNT-16: ds_bpermute_b32
+    // CHECK: nvvm.barrier0
+    // GCN-NOT: ds_bpermute_b32
+    // CHECK-NOT: nvvm.barrier0
+    // CHECK: llvm.return
+    %0 = "tt.scan"(%arg0) ({
+    ^bb0(%acc: f32, %cur: f32):
+      %1 = arith.addf %acc, %cur : f32
+      tt.scan.return %1 : f32
+    }) {axis = 1 : i32, reverse = false} : (tensor<16x128xf32, #blocked0>) -> tensor<16x128xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [1, 4], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: sort_inter_warp
+  func @sort_inter_warp(%arg0: tensor<16x128xf32, #blocked0>) {
+    // Only the 3 stages pairing elements of different warps go through shared
+    // memory, each between 2 barriers
+    // CHECK-COUNT-6: nvvm.barrier0
+    // CHECK-NOT: nvvm.barrier0
+    // CHECK: llvm.return
+    %0 = "tt.sort"(%arg0) {axis = 1 : i32, descending = false} : (tensor<16x128xf32, #blocked0>) -> tensor<16x128xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: topk_intra_warp
+  func @topk_intra_warp(%arg0: tensor<16x32xf32, #blocked0>, %arg1: tensor<16x32xi32, #blocked0>) {
+    // The network stays within warps, the first 8 elements are gathered
+    // through shared memory once
+    // CHECK-COUNT-2: nvvm.barrier0
+    // CHECK-NOT: nvvm.barrier0
+    // CHECK: llvm.return
+    %0:2 = "tt.sort"(%arg0, %arg1) {axis = 1 : i32, descending = true, k = 8 : i32} : (tensor<16x32xf32, #blocked0>, tensor<16x32xi32, #blocked0>) -> (tensor<16x8xf32, #blocked0>, tensor<16x8xi32, #blocked0>)
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: dequant_int4
+  func @dequant_int4(%arg0: tensor<512xi8, #blocked0>) {
+    %c4 = arith.constant dense<4> : tensor<512xi32, #blocked0>
+    %c28 = arith.constant dense<28> : tensor<512xi32, #blocked0>
+    %0 = arith.extsi %arg0 : tensor<512xi8, #blocked0> to tensor<512xi32, #blocked0>
+    // The 4 bytes of a thread are converted by a single packed sequence
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: lop3.b32 a0, a0, 0x000f000f, 0x64006400, 0xea
+    // CHECK-NOT: llvm.sitofp
+    %1 = arith.shli %0, %c28 : tensor<512xi32, #blocked0>
+    %2 = arith.shrsi %1, %c28 : tensor<512xi32, #blocked0>
+    %lo = arith.sitofp %2 : tensor<512xi32, #blocked0> to tensor<512xf16, #blocked0>
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: fma.rn.f16x2
+    %3 = arith.shrsi %0, %c4 : tensor<512xi32, #blocked0>
+    %hi = arith.sitofp %3 : tensor<512xi32, #blocked0> to tensor<512xf16, #blocked0>
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: sub.f16x2
+    %bytes = arith.sitofp %arg0 : tensor<512xi8, #blocked0> to tensor<512xf16, #blocked0>
+    // CHECK: llvm.return
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: packed_f16_arith
+  func @packed_f16_arith(%arg0: tensor<512xf16, #blocked0>, %arg1: tensor<512xf16, #blocked0>, %arg2: tensor<512xbf16, #blocked0>) {
+    // The 4 elements of a thread are computed in pairs
+    // CHECK-COUNT-2: llvm.fadd {{.*}} : vector<2xf16>
+    // CHECK-NOT: llvm.fadd {{.*}} : f16
+    %0 = arith.addf %arg0, %arg1 : tensor<512xf16, #blocked0>
+    // CHECK-COUNT-2: llvm.fmul {{.*}} : vector<2xf16>
+    %1 = arith.mulf %0, %arg1 : tensor<512xf16, #blocked0>
+    // CHECK-COUNT-2: llvm.fsub {{.*}} : vector<2xf16>
+    %2 = arith.subf %1, %arg0 : tensor<512xf16, #blocked0>
+    // CHECK-COUNT-2: fma.rn.bf16x2
+    %3 = arith.addf %arg2, %arg2 : tensor<512xbf16, #blocked0>
+    return
+  }
+}
@@ -0,0 +1,39 @@
+// RUN: triton-opt %s -split-input-file --convert-triton-gpu-to-llvm="fast-math=true" | FileCheck %s
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: fast_math_ops
+  func @fast_math_ops(%arg0: tensor<128xf32, #blocked0>) {
+    // CHECK: lg2.approx.f32
+    %0 = math.log %arg0 : tensor<128xf32, #blocked0>
+    // CHECK: sin.approx.f32
+    %1 = math.sin %arg0 : tensor<128xf32, #blocked0>
+    // CHECK: cos.approx.f32
+    %2 = math.cos %arg0 : tensor<128xf32, #blocked0>
+    // CHECK: tanh.approx.f32
+    // CHECK-NOT: llvm.call @__nv_tanhf
+    %3 = tt.ext_elemwise %arg0 {libname = "libdevice", libpath = "", symbol = "__nv_tanhf"} : tensor<128xf32, #blocked0> -> tensor<128xf32, #blocked0>
+    // CHECK: rsqrt.approx.f32
+    %4 = tt.ext_elemwise %arg0 {libname = "libdevice", libpath = "", symbol = "__nv_rsqrtf"} : tensor<128xf32, #blocked0> -> tensor<128xf32, #blocked0>
+    return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: fast_sigmoid
+  func @fast_sigmoid(%arg0: tensor<128xf32, #blocked0>) -> tensor<128xf32, #blocked0> {
+    %zero = arith.constant dense<0.000000e+00> : tensor<128xf32, #blocked0>
+    %one = arith.constant dense<1.000000e+00> : tensor<128xf32, #blocked0>
+    %0 = arith.subf %zero, %arg0 : tensor<128xf32, #blocked0>
+    %1 = math.exp %0 : tensor<128xf32, #blocked0>
+    %2 = arith.addf %one, %1 : tensor<128xf32, #blocked0>
+    // The default compute capability has tanh.approx
+    // CHECK: tanh.approx.f32
+    // CHECK-NOT: div.full.f32
+    %3 = arith.divf %one, %2 : tensor<128xf32, #blocked0>
+    return %3 : tensor<128xf32, #blocked0>
+  }
+}
@@ -0,0 +1,20 @@
+// RUN: rm -rf %t && mkdir -p %t/in
+// RUN: cp %s %t/in/first.ttgir && cp %s %t/in/second.mlir && touch %t/in/ignored.txt
+// RUN: triton-translate --target=llvmir --sm=80 -j 2 --pass-pipeline="canonicalize" %t/in -o %t/out
+// RUN: FileCheck %s < %t/out/first.ll
+// RUN: FileCheck %s < %t/out/second.ll
+// RUN: not ls %t/out/ignored.ll
+
+// Batch mode translates the .ttgir and .mlir files of a directory
+
+// CHECK-LABEL: ; ModuleID = 'LLVMDialectModule'
+// CHECK: define {{.*}}void @batch_kernel
+
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+
+func @batch_kernel(%lb : index, %A : !tt.ptr<f16>) {
+
+  return
+}
+
+}
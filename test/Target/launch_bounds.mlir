@@ -0,0 +1,14 @@
+// RUN: triton-translate --target=llvmir --sm=80 %s | FileCheck %s
+
+// The launch bounds of the kernel are attributes of the function on AMD GPUs
+// CHECK: define amdgpu_kernel void @test_launch_bounds{{.*}} #[[ATTRS:[0-9]+]]
+// CHECK: attributes #[[ATTRS]] = {{.*}}"amdgpu-flat-work-group-size"="1, 128"{{.*}}"amdgpu-num-vgpr"="128"{{.*}}"amdgpu-waves-per-eu"="2"
+
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.min-blocks-per-sm" = 2 : i32, "triton_gpu.max-registers" = 128 : i32} {
+
+func @test_launch_bounds(%lb : index) {
+
+  return
+}
+
+}
@@ -0,0 +1,21 @@
+// RUN: triton-translate --target=llvmir --sm=80 %s | FileCheck %s
+
+// Libdevice functions equivalent to an intrinsic are lowered inline, and
+// libdevice is not linked
+// CHECK: @llvm.fabs.
+// CHECK-NOT: __nv_fabsf
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+
+func @fabs(%arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
+  %0 = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32, #blocked0>
+  %1 = tt.splat %arg0 : (!tt.ptr<f32>) -> tensor<128x!tt.ptr<f32>, #blocked0>
+  %2 = tt.addptr %1, %0 : tensor<128x!tt.ptr<f32>, #blocked0>, tensor<128xi32, #blocked0>
+  %3 = tt.load %2 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked0>
+  %4 = tt.ext_elemwise %3 {libname = "libdevice", libpath = "", symbol = "__nv_fabsf"} : tensor<128xf32, #blocked0> -> tensor<128xf32, #blocked0>
+  tt.store %2, %4 : tensor<128xf32, #blocked0>
+  return
+}
+
+}
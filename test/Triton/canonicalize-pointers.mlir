@@ -0,0 +1,62 @@
+// RUN: triton-opt %s -split-input-file -triton-canonicalize-pointers | FileCheck %s
+// RUN: triton-opt %s -split-input-file -triton-canonicalize-pointers=int32-indexing=true | FileCheck %s --check-prefix=INT32
+
+// A loop advancing its pointers by a uniform increment only carries the
+// scalar base, advanced as a scalar, and the offsets
+
+// CHECK-LABEL: @uniform_advance
+// INT32-LABEL: @uniform_advance
+func @uniform_advance(%base: !tt.ptr<f16>, %out: !tt.ptr<f16>, %stride: i32) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %zero = arith.constant dense<0.000000e+00> : tensor<128xf16>
+  %range = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32>
+  %splat = tt.splat %base : (!tt.ptr<f16>) -> tensor<128x!tt.ptr<f16>>
+  %ptrs = tt.addptr %splat, %range : tensor<128x!tt.ptr<f16>>, tensor<128xi32>
+  %inc = tt.splat %stride : (i32) -> tensor<128xi32>
+  // CHECK: %[[loop:.*]]:3 = scf.for {{.*}} iter_args(%{{arg[0-9]+}} = %{{.*}}, %[[b:arg[0-9]+]] = %arg0, %[[o:arg[0-9]+]] = %{{.*}}) -> (tensor<128xf16>, !tt.ptr<f16>, tensor<128xi32>)
+  // CHECK: %[[bs:.*]] = tt.splat %[[b]] : (!tt.ptr<f16>) -> tensor<128x!tt.ptr<f16>>
+  // CHECK: %[[p:.*]] = tt.addptr %[[bs]], %[[o]] : tensor<128x!tt.ptr<f16>>, tensor<128xi32>
+  // CHECK: tt.load %[[p]]
+  // CHECK: %[[next:.*]] = tt.addptr %[[b]], %arg2 : !tt.ptr<f16>, i32
+  // CHECK: scf.yield %{{.*}}, %[[next]], %[[o]] : tensor<128xf16>, !tt.ptr<f16>, tensor<128xi32>
+  %res:2 = scf.for %iv = %c0 to %c4 step %c1 iter_args(%acc = %zero, %p = %ptrs) -> (tensor<128xf16>, tensor<128x!tt.ptr<f16>>) {
+    %x = tt.load %p {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf16>
+    %sum = arith.addf %acc, %x : tensor<128xf16>
+    %next = tt.addptr %p, %inc : tensor<128x!tt.ptr<f16>>, tensor<128xi32>
+    scf.yield %sum, %next : tensor<128xf16>, tensor<128x!tt.ptr<f16>>
+  }
+  // CHECK: %[[rs:.*]] = tt.splat %[[loop]]#1 : (!tt.ptr<f16>) -> tensor<128x!tt.ptr<f16>>
+  // CHECK: %[[r:.*]] = tt.addptr %[[rs]], %[[loop]]#2
+  // CHECK: tt.store %[[r]], %[[loop]]#0
+  tt.store %res#1, %res#0 : tensor<128xf16>
+  return
+}
+
+// -----
+
+// Non-uniform increments are only added to the offsets with int32 indexing
+
+// CHECK-LABEL: @non_uniform_advance
+// INT32-LABEL: @non_uniform_advance
+func @non_uniform_advance(%base: !tt.ptr<f32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %range = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32>
+  %splat = tt.splat %base : (!tt.ptr<f32>) -> tensor<64x!tt.ptr<f32>>
+  %ptrs = tt.addptr %splat, %range : tensor<64x!tt.ptr<f32>>, tensor<64xi32>
+  // CHECK: scf.for {{.*}} -> (tensor<64x!tt.ptr<f32>>)
+  // CHECK: tt.addptr %{{.*}}, %{{.*}} : tensor<64x!tt.ptr<f32>>, tensor<64xi32>
+  // INT32: scf.for {{.*}} iter_args(%[[b:arg[0-9]+]] = %arg0, %[[o:arg[0-9]+]] = %{{.*}}) -> (!tt.ptr<f32>, tensor<64xi32>)
+  // INT32: %[[next:.*]] = arith.addi %[[o]], %{{.*}} : tensor<64xi32>
+  // INT32: scf.yield %[[b]], %[[next]] : !tt.ptr<f32>, tensor<64xi32>
+  %res = scf.for %iv = %c0 to %c4 step %c1 iter_args(%p = %ptrs) -> (tensor<64x!tt.ptr<f32>>) {
+    %x = tt.load %p {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<64xf32>
+    tt.store %p, %x : tensor<64xf32>
+    %next = tt.addptr %p, %range : tensor<64x!tt.ptr<f32>>, tensor<64xi32>
+    scf.yield %next : tensor<64x!tt.ptr<f32>>
+  }
+  return
+}
@@ -23,28 +23,47 @@ func @test_combine_dot_add_pattern() -> (tensor<128x128xf32>, tensor<128x128xf32
 }
 
 
-// COM: CHECK-LABEL: @test_combine_addptr_pattern
+// CHECK-LABEL: @test_combine_addptr_pattern
 func @test_combine_addptr_pattern(%base: !tt.ptr<f32>) -> tensor<8x!tt.ptr<f32>> {
     %off0 = arith.constant 10 : i32
     %off1 = arith.constant 15 : i32
 
     // 10 + 15 = 25
-    // COM: CHECK-NEXT: %[[cst:.*]] = arith.constant dense<25> : tensor<8xi32>
+    // CHECK-DAG: %[[cst:.*]] = arith.constant dense<25> : tensor<8xi32>
 
     %base_ = tt.broadcast %base : (!tt.ptr<f32>) -> tensor<8x!tt.ptr<f32>>
 
-    // COM: CHECK-NEXT: %[[tmp0:.*]] = tt.broadcast %{{.*}} : (!tt.ptr<f32>) -> tensor<8x!tt.ptr<f32>>
+    // CHECK-DAG: %[[tmp0:.*]] = tt.broadcast %{{.*}} : (!tt.ptr<f32>) -> tensor<8x!tt.ptr<f32>>
 
     %idx0 = tt.broadcast %off0 : (i32) -> tensor<8xi32>
     %idx1 = tt.broadcast %off1 : (i32) -> tensor<8xi32>
- 
-    // COM: CHECK-NEXT: %1 = tt.addptr %[[tmp0]], %[[cst]] : tensor<8x!tt.ptr<f32>>, tensor<8xi32>
+
+    // CHECK: %{{.*}} = tt.addptr %[[tmp0]], %[[cst]] : tensor<8x!tt.ptr<f32>>, tensor<8xi32>
+    // CHECK-NOT: tt.addptr
     %ptr0 = tt.addptr %base_, %idx0 : tensor<8x!tt.ptr<f32>>, tensor<8xi32>
     %ptr1 = tt.addptr %ptr0, %idx1 : tensor<8x!tt.ptr<f32>>, tensor<8xi32>
 
     return %ptr1 : tensor<8x!tt.ptr<f32>>
 }
 
+// CHECK-LABEL: @test_combine_addptr_widening_pattern
+func @test_combine_addptr_widening_pattern(%ptrs: tensor<8x!tt.ptr<f32>>, %idx0: tensor<8xi32>, %idx1: tensor<8xi64>, %idx2: tensor<8xi32>) -> (tensor<8x!tt.ptr<f32>>, tensor<8x!tt.ptr<f32>>) {
+    // i32 offsets are extended to add them to i64 ones
+    // CHECK: %[[ext:.*]] = arith.extsi %{{.*}} : tensor<8xi32> to tensor<8xi64>
+    // CHECK-NEXT: %[[sum:.*]] = arith.addi %[[ext]], %{{.*}} : tensor<8xi64>
+    // CHECK-NEXT: %{{.*}} = tt.addptr %{{.*}}, %[[sum]] : tensor<8x!tt.ptr<f32>>, tensor<8xi64>
+    %ptr0 = tt.addptr %ptrs, %idx0 : tensor<8x!tt.ptr<f32>>, tensor<8xi32>
+    %ptr1 = tt.addptr %ptr0, %idx1 : tensor<8x!tt.ptr<f32>>, tensor<8xi64>
+
+    // The sum of two i32 offsets could overflow
+    // CHECK: %[[ptr2:.*]] = tt.addptr %{{.*}}, %{{.*}} : tensor<8x!tt.ptr<f32>>, tensor<8xi32>
+    // CHECK-NEXT: %{{.*}} = tt.addptr %[[ptr2]], %{{.*}} : tensor<8x!tt.ptr<f32>>, tensor<8xi32>
+    %ptr2 = tt.addptr %ptrs, %idx0 : tensor<8x!tt.ptr<f32>>, tensor<8xi32>
+    %ptr3 = tt.addptr %ptr2, %idx2 : tensor<8x!tt.ptr<f32>>, tensor<8xi32>
+
+    return %ptr1, %ptr3 : tensor<8x!tt.ptr<f32>>, tensor<8x!tt.ptr<f32>>
+}
+
 
 // CHECK-LABEL: @test_combine_select_masked_load_pattern
 func @test_combine_select_masked_load_pattern(%ptr: tensor<8x!tt.ptr<f32>>, %cond: i1) -> (tensor<8xf32>, tensor<8xf32>) {
@@ -64,7 +83,7 @@ func @test_combine_select_masked_load_pattern(%ptr: tensor<8x!tt.ptr<f32>>, %con
 }
 
 // CHECK-LABEL: @test_combine_select_masked_load_fail_pattern
-func @test_combine_select_masked_load_fail_pattern(%ptr: tensor<8x!tt.ptr<f32>>, %dummy_load: tensor<8xf32>, %dummy_broadcast: tensor<8xi1>, %cond: i1) -> (tensor<8xf32>, tensor<8xf32>) {
+func @test_combine_select_masked_load_fail_pattern(%ptr: tensor<8x!tt.ptr<f32>>, %dummy_load: tensor<8xf32>, %dummy_broadcast: tensor<8xi1>, %cond: i1, %other_cond: i1) -> (tensor<8xf32>, tensor<8xf32>, tensor<8xf32>) {
     %false_val = arith.constant dense<0.0> : tensor<8xf32>
 
     // Case 1: value at the "load" position is not an "op".  Select should not be canonicalized.
@@ -76,7 +95,13 @@ func @test_combine_select_masked_load_fail_pattern(%ptr: tensor<8x!tt.ptr<f32>>,
     // CHECK: %{{.*}} = select %{{.*}}, %{{.*}}, %{{.*}} : tensor<8xf32>
     %1 = select %cond, %real_load, %false_val : tensor<8xf32>
 
-    return %0, %1 : tensor<8xf32>, tensor<8xf32>
+    // Case 3: the load is masked by another condition.  Select should not be canonicalized.
+    %other_mask = tt.broadcast %other_cond : (i1) -> tensor<8xi1>
+    %other_load = tt.load %ptr, %other_mask, %false_val {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<8xf32>
+    // CHECK: %{{.*}} = select %{{.*}}, %{{.*}}, %{{.*}} : tensor<8xf32>
+    %2 = select %cond, %other_load, %false_val : tensor<8xf32>
+
+    return %0, %1, %2 : tensor<8xf32>, tensor<8xf32>, tensor<8xf32>
 }
 
 // CHECK-LABEL: @test_combine_broadcast_constant_pattern
@@ -137,6 +162,15 @@ func @test_canonicalize_masked_store_pattern(%ptr: tensor<8x!tt.ptr<f32>>, %val:
     return
 }
 
+// CHECK-LABEL: @test_canonicalize_masked_store_keeps_cache_hints
+func @test_canonicalize_masked_store_keeps_cache_hints(%ptr: tensor<8x!tt.ptr<f32>>, %val: tensor<8xf32>) {
+    %true_mask = arith.constant dense<true> : tensor<8xi1>
+
+    // CHECK: tt.store %{{.*}}, %{{.*}} {cache = 5 : i32, evict = 2 : i32} : tensor<8xf32>
+    tt.store %ptr, %val, %true_mask {cache = 5 : i32, evict = 2 : i32} : tensor<8xf32>
+    return
+}
+
 // CHECK-LABEL: @test_canonicalize_masked_store_fail_pattern
 func @test_canonicalize_masked_store_fail_pattern(%ptr: tensor<8x!tt.ptr<f32>>, %val: tensor<8xf32>, %mask: tensor<8xi1>) {
     // Case: value at the "mask" position is not an "op".  Store should not be canonicalized.
@@ -144,3 +178,59 @@ func @test_canonicalize_masked_store_fail_pattern(%ptr: tensor<8x!tt.ptr<f32>>,
     tt.store %ptr, %val, %mask : tensor<8xf32>
     return
 }
+
+// CHECK-LABEL: @test_fold_decided_mask_pattern
+func @test_fold_decided_mask_pattern(%ptr: tensor<8x!tt.ptr<f32>>) -> (tensor<8xf32>, tensor<8xf32>) {
+    %range = tt.make_range {end = 8 : i32, start = 0 : i32} : tensor<8xi32>
+    %c4 = arith.constant dense<4> : tensor<8xi32>
+    %c8 = arith.constant dense<8> : tensor<8xi32>
+
+    // [0, 8) < 8 always holds, the mask is dropped
+    // CHECK: %[[res1:.*]] = tt.load %{{.*}} {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<8xf32>
+    %mask0 = arith.cmpi slt, %range, %c8 : tensor<8xi32>
+    %x = tt.load %ptr, %mask0 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<8xf32>
+
+    // [4, 12) < 8 depends on the element
+    // CHECK: %[[mask1:.*]] = arith.cmpi slt
+    // CHECK-NEXT: %[[res2:.*]] = tt.load %{{.*}}, %[[mask1]] {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<8xf32>
+    %offs = arith.addi %range, %c4 : tensor<8xi32>
+    %mask1 = arith.cmpi slt, %offs, %c8 : tensor<8xi32>
+    %y = tt.load %ptr, %mask1 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<8xf32>
+
+    // CHECK: return %[[res1]], %[[res2]] : tensor<8xf32>, tensor<8xf32>
+    return %x, %y : tensor<8xf32>, tensor<8xf32>
+}
+
+// CHECK-LABEL: @test_sink_elementwise_of_broadcast_pattern
+func @test_sink_elementwise_of_broadcast_pattern(%x: f32, %y: f32, %row: tensor<1x8xf32>) -> (tensor<8xf32>, tensor<4x8xf32>) {
+    // CHECK: %[[sum:.*]] = arith.addf %{{.*}}, %{{.*}} : f32
+    // CHECK-NEXT: %[[res1:.*]] = tt.splat %[[sum]] : (f32) -> tensor<8xf32>
+    %xs = tt.splat %x : (f32) -> tensor<8xf32>
+    %ys = tt.splat %y : (f32) -> tensor<8xf32>
+    %0 = arith.addf %xs, %ys : tensor<8xf32>
+
+    // The constant is rebuilt with the shape of the row
+    // CHECK: %[[prod:.*]] = arith.mulf %{{.*}}, %{{.*}} : tensor<1x8xf32>
+    // CHECK-NEXT: %[[res2:.*]] = tt.broadcast %[[prod]] : (tensor<1x8xf32>) -> tensor<4x8xf32>
+    %cst = arith.constant dense<2.0> : tensor<4x8xf32>
+    %rows = tt.broadcast %row : (tensor<1x8xf32>) -> tensor<4x8xf32>
+    %1 = arith.mulf %rows, %cst : tensor<4x8xf32>
+
+    // CHECK: return %[[res1]], %[[res2]] : tensor<8xf32>, tensor<4x8xf32>
+    return %0, %1 : tensor<8xf32>, tensor<4x8xf32>
+}
+
+// CHECK-LABEL: @test_hoist_splat_pattern
+func @test_hoist_splat_pattern(%x: i32, %row: tensor<1x8xi32>) -> (tensor<4x8xi32>, tensor<4x8xi32>) {
+    // CHECK: %[[res1:.*]] = tt.splat %{{.*}} : (i32) -> tensor<4x8xi32>
+    %xs = tt.splat %x : (i32) -> tensor<8xi32>
+    %col = tt.expand_dims %xs {axis = 0 : i32} : (tensor<8xi32>) -> tensor<1x8xi32>
+    %0 = tt.broadcast %col : (tensor<1x8xi32>) -> tensor<4x8xi32>
+
+    // CHECK-NEXT: %[[res2:.*]] = tt.broadcast %{{.*}} : (tensor<1x8xi32>) -> tensor<4x8xi32>
+    %rows = tt.broadcast %row : (tensor<1x8xi32>) -> tensor<1x8xi32>
+    %1 = tt.broadcast %rows : (tensor<1x8xi32>) -> tensor<4x8xi32>
+
+    // CHECK-NEXT: return %[[res1]], %[[res2]] : tensor<4x8xi32>, tensor<4x8xi32>
+    return %0, %1 : tensor<4x8xi32>, tensor<4x8xi32>
+}
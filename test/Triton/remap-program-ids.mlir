@@ -0,0 +1,48 @@
+// RUN: triton-opt %s -split-input-file -triton-remap-program-ids='group-size=4' | FileCheck %s
+// RUN: triton-opt %s -split-input-file -triton-remap-program-ids='order=hilbert' | FileCheck %s --check-prefix=HILBERT
+
+// CHECK-LABEL: @store_pid
+// HILBERT-LABEL: @store_pid
+func @store_pid(%ptr: !tt.ptr<i32>) {
+  // CHECK: %[[pid0:.*]] = tt.get_program_id {axis = 0 : i32} : i32
+  // CHECK: %[[pid1:.*]] = tt.get_program_id {axis = 1 : i32} : i32
+  // CHECK: %[[n0:.*]] = tt.get_num_programs {axis = 0 : i32} : i32
+  // CHECK: %[[n1:.*]] = tt.get_num_programs {axis = 1 : i32} : i32
+  // CHECK: %[[row:.*]] = arith.muli %[[pid1]], %[[n0]] : i32
+  // CHECK: %[[linear:.*]] = arith.addi %[[pid0]], %[[row]] : i32
+  // CHECK: %[[width:.*]] = arith.muli %c4_i32, %[[n1]] : i32
+  // CHECK: %[[group:.*]] = arith.divui %[[linear]], %[[width]] : i32
+  // CHECK: %[[first:.*]] = arith.muli %[[group]], %c4_i32 : i32
+  // CHECK: %[[left:.*]] = arith.subi %[[n0]], %[[first]] : i32
+  // CHECK: %[[size:.*]] = arith.minsi %[[left]], %c4_i32 : i32
+  // CHECK: %[[in_group:.*]] = arith.remui %[[linear]], %[[width]] : i32
+  // CHECK: %[[m:.*]] = arith.remui %[[in_group]], %[[size]] : i32
+  // CHECK: %[[new_pid0:.*]] = arith.addi %[[first]], %[[m]] : i32
+  // CHECK: %[[new_pid1:.*]] = arith.divui %[[in_group]], %[[size]] : i32
+  // CHECK-NOT: tt.get_program_id
+  // CHECK: %[[x:.*]] = tt.addptr %arg0, %[[new_pid0]]
+  // CHECK: tt.store %[[x]], %[[new_pid1]]
+  // HILBERT: %[[hilbert:.*]]:3 = scf.for
+  // HILBERT: scf.yield
+  // HILBERT: %[[new_pid0:.*]] = select %{{.*}}, %[[hilbert]]#0, %{{.*}} : i32
+  // HILBERT: %[[new_pid1:.*]] = select %{{.*}}, %[[hilbert]]#1, %{{.*}} : i32
+  // HILBERT: %[[x:.*]] = tt.addptr %arg0, %[[new_pid0]]
+  // HILBERT: tt.store %[[x]], %[[new_pid1]]
+  %pid0 = tt.get_program_id {axis = 0 : i32} : i32
+  %pid1 = tt.get_program_id {axis = 1 : i32} : i32
+  %x = tt.addptr %ptr, %pid0 : !tt.ptr<i32>, i32
+  tt.store %x, %pid1 : i32
+  return
+}
+
+// -----
+
+// The third axis and kernels without program ids are untouched
+// CHECK-LABEL: @axis_2
+func @axis_2(%ptr: !tt.ptr<i32>) {
+  // CHECK-NEXT: %[[pid2:.*]] = tt.get_program_id {axis = 2 : i32} : i32
+  // CHECK-NEXT: tt.store %arg0, %[[pid2]]
+  %pid2 = tt.get_program_id {axis = 2 : i32} : i32
+  tt.store %ptr, %pid2 : i32
+  return
+}
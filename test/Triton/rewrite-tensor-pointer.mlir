@@ -0,0 +1,67 @@
+// RUN: triton-opt %s -split-input-file -triton-rewrite-tensor-pointer | FileCheck %s
+
+// The block pointer is carried by the loop as its fields, the offsets being
+// advanced as i32 scalars, and the load checks the bounds of dimension 1 only
+
+// CHECK-LABEL: @advance_in_loop
+func @advance_in_loop(%base: !tt.ptr<f16>, %out: !tt.ptr<f16>, %M: i64, %K: i64, %stride: i64, %row: i32) {
+  %c0_i32 = arith.constant 0 : i32
+  %c32_i32 = arith.constant 32 : i32
+  %c1_i64 = arith.constant 1 : i64
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %zero = arith.constant dense<0.000000e+00> : tensor<16x32xf16>
+  // CHECK-NOT: tt.make_tensor_ptr
+  // CHECK: %[[loop:.*]]:8 = scf.for {{.*}} iter_args(%{{arg[0-9]+}} = %{{.*}}, %[[b:arg[0-9]+]] = %arg0, %[[m:arg[0-9]+]] = %arg2, %[[k:arg[0-9]+]] = %arg3, %{{arg[0-9]+}} = %arg4, %{{arg[0-9]+}} = %c1_i64, %{{arg[0-9]+}} = %arg5, %[[col:arg[0-9]+]] = %c0_i32)
+  // CHECK: %[[range:.*]] = tt.make_range {end = 32 : i32, start = 0 : i32} : tensor<32xi32>
+  // CHECK: arith.addi %{{.*}}, %[[range]] : tensor<32xi32>
+  // CHECK: arith.cmpi sge
+  // CHECK: arith.cmpi slt
+  // CHECK-NOT: arith.cmpi
+  // CHECK: %[[ptrs:.*]] = tt.addptr %{{.*}}, %{{.*}} : tensor<16x32x!tt.ptr<f16>>, tensor<16x32xi64>
+  // CHECK: tt.load %[[ptrs]], %{{.*}}, %{{.*}} {{.*}} : tensor<16x32xf16>
+  // CHECK: %[[next:.*]] = arith.addi %[[col]], %c32_i32 : i32
+  // CHECK: scf.yield %{{.*}}, %[[b]], %[[m]], %[[k]], %{{.*}}, %{{.*}}, %{{.*}}, %[[next]]
+  // CHECK-NOT: tt.advance
+  %ptr = tt.make_tensor_ptr %base, [%M, %K], [%stride, %c1_i64], [%row, %c0_i32] {order = [1 : i32, 0 : i32]} : !tt.ptr<f16> -> !tt.ptr<tensor<16x32xf16>>
+  %res:2 = scf.for %iv = %c0 to %c4 step %c1 iter_args(%acc = %zero, %p = %ptr) -> (tensor<16x32xf16>, !tt.ptr<tensor<16x32xf16>>) {
+    %x = tt.tensor_ptr_load %p {boundaryCheck = [1 : i32], padding = 1 : i32} : !tt.ptr<tensor<16x32xf16>> -> tensor<16x32xf16>
+    %sum = arith.addf %acc, %x : tensor<16x32xf16>
+    %next = tt.advance %p, [%c0_i32, %c32_i32] : !tt.ptr<tensor<16x32xf16>>
+    scf.yield %sum, %next : tensor<16x32xf16>, !tt.ptr<tensor<16x32xf16>>
+  }
+  // CHECK: tt.store %{{.*}}, %[[loop]]#0, %{{.*}} : tensor<16x32xf16>
+  %optr = tt.make_tensor_ptr %out, [%M, %K], [%stride, %c1_i64], [%row, %c0_i32] {order = [1 : i32, 0 : i32]} : !tt.ptr<f16> -> !tt.ptr<tensor<16x32xf16>>
+  tt.tensor_ptr_store %optr, %res#0 {boundaryCheck = [0 : i32, 1 : i32]} : !tt.ptr<tensor<16x32xf16>>, tensor<16x32xf16>
+  return
+}
+
+// -----
+
+// A block pointer selected by a branch is carried as its fields, and stores
+// without boundary check are not masked
+
+// CHECK-LABEL: @select_in_if
+func @select_in_if(%base: !tt.ptr<f32>, %M: i64, %cond: i1) {
+  %c0_i32 = arith.constant 0 : i32
+  %c64_i32 = arith.constant 64 : i32
+  %c1_i64 = arith.constant 1 : i64
+  %cst = arith.constant dense<1.000000e+00> : tensor<64xf32>
+  %ptr = tt.make_tensor_ptr %base, [%M], [%c1_i64], [%c0_i32] {order = [0 : i32]} : !tt.ptr<f32> -> !tt.ptr<tensor<64xf32>>
+  // CHECK: %[[if:.*]]:4 = scf.if %arg2 -> (!tt.ptr<f32>, i64, i64, i32)
+  // CHECK: %[[off:.*]] = arith.addi %c0_i32, %c64_i32 : i32
+  // CHECK: scf.yield %arg0, %arg1, %c1_i64, %[[off]]
+  // CHECK: } else {
+  // CHECK: scf.yield %arg0, %arg1, %c1_i64, %c0_i32
+  %sel = scf.if %cond -> (!tt.ptr<tensor<64xf32>>) {
+    %next = tt.advance %ptr, [%c64_i32] : !tt.ptr<tensor<64xf32>>
+    scf.yield %next : !tt.ptr<tensor<64xf32>>
+  } else {
+    scf.yield %ptr : !tt.ptr<tensor<64xf32>>
+  }
+  // CHECK: %[[ptrs:.*]] = tt.addptr %{{.*}}, %{{.*}} : tensor<64x!tt.ptr<f32>>, tensor<64xi64>
+  // CHECK: tt.store %[[ptrs]], %{{.*}} : tensor<64xf32>
+  tt.tensor_ptr_store %sel, %cst {boundaryCheck = []} : !tt.ptr<tensor<64xf32>>, tensor<64xf32>
+  return
+}
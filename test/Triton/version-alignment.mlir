@@ -0,0 +1,31 @@
+// RUN: triton-opt %s -split-input-file -triton-version-alignment | FileCheck %s
+
+// CHECK-LABEL: @copy
+func @copy(%dst: !tt.ptr<f32> {tt.version_divisibility = 16 : i32}, %src: !tt.ptr<f32>) {
+  // CHECK: %[[addr:.*]] = tt.ptr_to_int %arg0 : !tt.ptr<f32> -> i64
+  // CHECK: %[[rem:.*]] = arith.remui %[[addr]], %c16_i64 : i64
+  // CHECK: %[[cond:.*]] = arith.cmpi eq, %[[rem]], %c0_i64 : i64
+  // CHECK: scf.if %[[cond]] {
+  // CHECK:   %[[aligned:.*]] = tt.addptr %arg0, %c0_i32 {tt.divisibility = 16 : i32} : !tt.ptr<f32>, i32
+  // CHECK:   %[[x:.*]] = tt.load %arg1
+  // CHECK:   tt.store %[[aligned]], %[[x]]
+  // CHECK: } else {
+  // CHECK:   %[[y:.*]] = tt.load %arg1
+  // CHECK:   tt.store %arg0, %[[y]]
+  // CHECK: }
+  // CHECK-NEXT: return
+  %x = tt.load %src {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : f32
+  tt.store %dst, %x : f32
+  return
+}
+
+// -----
+
+// Functions without version hints are untouched
+// CHECK-LABEL: @no_hint
+func @no_hint(%dst: !tt.ptr<f32>, %src: !tt.ptr<f32>) {
+  // CHECK-NOT: scf.if
+  %x = tt.load %src {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : f32
+  tt.store %dst, %x : f32
+  return
+}
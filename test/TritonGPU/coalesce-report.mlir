@@ -0,0 +1,57 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-coalesce=report-sector-efficiency=true -verify-diagnostics | FileCheck %s
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+
+// Aligned vectors fill their sectors, misaligned runs straddle one more sector
+// CHECK: [[layout:#.*]] = #triton_gpu.blocked<{sizePerThread = [2], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+// CHECK-LABEL: copy
+// CHECK: tt.load {{.*}} : tensor<256xf32, [[layout]]>
+func @copy(%arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg1: !tt.ptr<f32>) {
+  %0 = tt.make_range {end = 256 : i32, start = 0 : i32} : tensor<256xi32, #blocked0>
+  %1 = tt.splat %arg0 : (!tt.ptr<f32>) -> tensor<256x!tt.ptr<f32>, #blocked0>
+  %2 = tt.addptr %1, %0 : tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xi32, #blocked0>
+  // expected-remark @below {{2x32-bit accesses per thread along axis 0, 100% sector efficiency}}
+  %3 = tt.load %2 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<256xf32, #blocked0>
+  %4 = tt.splat %arg1 : (!tt.ptr<f32>) -> tensor<256x!tt.ptr<f32>, #blocked0>
+  %5 = tt.addptr %4, %0 : tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xi32, #blocked0>
+  // expected-remark @below {{1x32-bit accesses per thread along axis 0, 80% sector efficiency}}
+  tt.store %5, %3 : tensor<256xf32, #blocked0>
+  return
+}
+
+}
+
+// -----
+
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [32, 1], warpsPerCTA = [4, 1], order = [0, 1]}>
+#blocked2 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [1, 32], warpsPerCTA = [1, 4], order = [0, 1]}>
+#slice1dim1 = #triton_gpu.slice<{dim = 1, parent = #blocked1}>
+#slice2dim0 = #triton_gpu.slice<{dim = 0, parent = #blocked2}>
+
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+
+// Rows of 4 contiguous halves use a quarter of their sectors
+// CHECK: [[narrow:#.*]] = #triton_gpu.blocked<{sizePerThread = [1, 2], threadsPerWarp = [16, 2], warpsPerCTA = [4, 1], order = [1, 0]}>
+// CHECK-LABEL: narrow_rows
+// CHECK: tt.load {{.*}} : tensor<64x4xf16, [[narrow]]>
+func @narrow_rows(%arg0: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg1: i32 {tt.divisibility = 16 : i32}) {
+  %0 = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32, #slice1dim1>
+  %1 = tt.make_range {end = 4 : i32, start = 0 : i32} : tensor<4xi32, #slice2dim0>
+  %2 = tt.expand_dims %0 {axis = 1 : i32} : (tensor<64xi32, #slice1dim1>) -> tensor<64x1xi32, #blocked1>
+  %3 = tt.splat %arg1 : (i32) -> tensor<64x1xi32, #blocked1>
+  %4 = arith.muli %2, %3 : tensor<64x1xi32, #blocked1>
+  %5 = tt.splat %arg0 : (!tt.ptr<f16>) -> tensor<64x1x!tt.ptr<f16>, #blocked1>
+  %6 = tt.addptr %5, %4 : tensor<64x1x!tt.ptr<f16>, #blocked1>, tensor<64x1xi32, #blocked1>
+  %7 = tt.broadcast %6 : (tensor<64x1x!tt.ptr<f16>, #blocked1>) -> tensor<64x4x!tt.ptr<f16>, #blocked1>
+  %8 = tt.expand_dims %1 {axis = 0 : i32} : (tensor<4xi32, #slice2dim0>) -> tensor<1x4xi32, #blocked2>
+  %9 = tt.broadcast %8 : (tensor<1x4xi32, #blocked2>) -> tensor<64x4xi32, #blocked2>
+  %10 = triton_gpu.convert_layout %9 : (tensor<64x4xi32, #blocked2>) -> tensor<64x4xi32, #blocked1>
+  %11 = tt.addptr %7, %10 : tensor<64x4x!tt.ptr<f16>, #blocked1>, tensor<64x4xi32, #blocked1>
+  // expected-remark @below {{2x16-bit accesses per thread along axis 1, 25% sector efficiency}}
+  %12 = tt.load %11 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<64x4xf16, #blocked1>
+  return
+}
+
+}
@@ -110,6 +110,16 @@ func @remat_single_value(%arg: !tt.ptr<i32> {tt.divisibility = 16 : i32}) {
   return
 }
 
+// Don't move a conversion onto a wider value
+// CHECK-LABEL: remat_narrow
+func @remat_narrow(%arg0: tensor<1024xf32, #layout0>) -> tensor<1024xf16, #layout1> {
+  // CHECK: %0 = arith.truncf %arg0 : tensor<1024xf32, #{{.*}}> to tensor<1024xf16, #{{.*}}>
+  // CHECK-NEXT: %1 = triton_gpu.convert_layout %0 : (tensor<1024xf16, #{{.*}}>) -> tensor<1024xf16, [[target_layout]]>
+  %0 = arith.truncf %arg0 : tensor<1024xf32, #layout0> to tensor<1024xf16, #layout0>
+  %1 = triton_gpu.convert_layout %0 : (tensor<1024xf16, #layout0>) -> tensor<1024xf16, #layout1>
+  return %1 : tensor<1024xf16, #layout1>
+}
+
 // CHECK-LABEL: if
 func @if(%arg0: i32, %arg1: !tt.ptr<i32> {tt.divisibility = 16 : i32}) {
   // CHECK-NOT: triton_gpu.convert_layout
@@ -851,3 +861,66 @@ func public @mnist(%arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg1: !tt.
   tt.store %61, %62, %63 : tensor<16x16xf32, #blocked4>
   return
 }
+
+// Elementwise epilogues of dots are stored from the mma layout
+// CHECK-LABEL: mma_epilogue_f32
+func @mma_epilogue_f32(%acc: tensor<64x64xf32, #layout2>, %arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %stride: i32) {
+  // CHECK-NOT: triton_gpu.convert_layout
+  // CHECK: %[[bias:.*]] = arith.addf %arg0, %{{.*}} : tensor<64x64xf32, #mma>
+  // CHECK: tt.store %{{.*}}, %[[bias]] : tensor<64x64xf32, #mma>
+  %cst = arith.constant dense<1.000000e+00> : tensor<64x64xf32, #blocked3>
+  %0 = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32, #triton_gpu.slice<{dim = 1, parent = #blocked3}>>
+  %1 = tt.expand_dims %0 {axis = 1 : i32} : (tensor<64xi32, #triton_gpu.slice<{dim = 1, parent = #blocked3}>>) -> tensor<64x1xi32, #blocked3>
+  %2 = tt.splat %stride : (i32) -> tensor<64x1xi32, #blocked3>
+  %3 = arith.muli %1, %2 : tensor<64x1xi32, #blocked3>
+  %4 = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32, #triton_gpu.slice<{dim = 0, parent = #blocked3}>>
+  %5 = tt.expand_dims %4 {axis = 0 : i32} : (tensor<64xi32, #triton_gpu.slice<{dim = 0, parent = #blocked3}>>) -> tensor<1x64xi32, #blocked3>
+  %6 = tt.broadcast %3 : (tensor<64x1xi32, #blocked3>) -> tensor<64x64xi32, #blocked3>
+  %7 = tt.broadcast %5 : (tensor<1x64xi32, #blocked3>) -> tensor<64x64xi32, #blocked3>
+  %8 = arith.addi %6, %7 : tensor<64x64xi32, #blocked3>
+  %9 = tt.splat %arg0 : (!tt.ptr<f32>) -> tensor<64x64x!tt.ptr<f32>, #blocked3>
+  %10 = tt.addptr %9, %8 : tensor<64x64x!tt.ptr<f32>, #blocked3>, tensor<64x64xi32, #blocked3>
+  %11 = triton_gpu.convert_layout %acc : (tensor<64x64xf32, #layout2>) -> tensor<64x64xf32, #blocked3>
+  %12 = arith.addf %11, %cst : tensor<64x64xf32, #blocked3>
+  tt.store %10, %12 : tensor<64x64xf32, #blocked3>
+  return
+}
+
+// 16-bit results go through shared memory again to be stored in wider vectors
+// CHECK-LABEL: mma_epilogue_f16
+func @mma_epilogue_f16(%acc: tensor<64x64xf32, #layout2>, %arg0: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %stride: i32) {
+  // CHECK: %[[ptr:.*]] = tt.addptr {{.*}} : tensor<64x64x!tt.ptr<f16>, [[row_layout]]>
+  // CHECK-NOT: triton_gpu.convert_layout
+  // CHECK: %[[bias:.*]] = arith.addf %arg0, %{{.*}} : tensor<64x64xf32, #mma>
+  // CHECK: %[[out:.*]] = arith.truncf %[[bias]] : tensor<64x64xf32, #mma> to tensor<64x64xf16, #mma>
+  // CHECK: %[[staged:.*]] = triton_gpu.convert_layout %[[out]] : (tensor<64x64xf16, #mma>) -> tensor<64x64xf16, [[row_layout]]>
+  // CHECK: tt.store %[[ptr]], %[[staged]] : tensor<64x64xf16, [[row_layout]]>
+  %cst = arith.constant dense<1.000000e+00> : tensor<64x64xf32, #blocked3>
+  %0 = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32, #triton_gpu.slice<{dim = 1, parent = #blocked3}>>
+  %1 = tt.expand_dims %0 {axis = 1 : i32} : (tensor<64xi32, #triton_gpu.slice<{dim = 1, parent = #blocked3}>>) -> tensor<64x1xi32, #blocked3>
+  %2 = tt.splat %stride : (i32) -> tensor<64x1xi32, #blocked3>
+  %3 = arith.muli %1, %2 : tensor<64x1xi32, #blocked3>
+  %4 = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32, #triton_gpu.slice<{dim = 0, parent = #blocked3}>>
+  %5 = tt.expand_dims %4 {axis = 0 : i32} : (tensor<64xi32, #triton_gpu.slice<{dim = 0, parent = #blocked3}>>) -> tensor<1x64xi32, #blocked3>
+  %6 = tt.broadcast %3 : (tensor<64x1xi32, #blocked3>) -> tensor<64x64xi32, #blocked3>
+  %7 = tt.broadcast %5 : (tensor<1x64xi32, #blocked3>) -> tensor<64x64xi32, #blocked3>
+  %8 = arith.addi %6, %7 : tensor<64x64xi32, #blocked3>
+  %9 = tt.splat %arg0 : (!tt.ptr<f16>) -> tensor<64x64x!tt.ptr<f16>, #blocked3>
+  %10 = tt.addptr %9, %8 : tensor<64x64x!tt.ptr<f16>, #blocked3>, tensor<64x64xi32, #blocked3>
+  %11 = triton_gpu.convert_layout %acc : (tensor<64x64xf32, #layout2>) -> tensor<64x64xf32, #blocked3>
+  %12 = arith.addf %11, %cst : tensor<64x64xf32, #blocked3>
+  %13 = arith.truncf %12 : tensor<64x64xf32, #blocked3> to tensor<64x64xf16, #blocked3>
+  tt.store %10, %13 : tensor<64x64xf16, #blocked3>
+  return
+}
+
+// The accumulator is still converted when it has other users
+// CHECK-LABEL: mma_epilogue_reduce
+func @mma_epilogue_reduce(%acc: tensor<64x64xf32, #layout2>, %arg0: tensor<64x64x!tt.ptr<f32>, #blocked3>) -> tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked3}>> {
+  // CHECK: triton_gpu.convert_layout %arg0 : (tensor<64x64xf32, #mma>) -> tensor<64x64xf32, [[row_layout]]>
+  // CHECK: tt.store %arg1, %{{.*}} : tensor<64x64xf32, [[row_layout]]>
+  %0 = triton_gpu.convert_layout %acc : (tensor<64x64xf32, #layout2>) -> tensor<64x64xf32, #blocked3>
+  tt.store %arg0, %0 : tensor<64x64xf32, #blocked3>
+  %1 = tt.reduce %0 {axis = 1 : i32, redOp = 2 : i32} : tensor<64x64xf32, #blocked3> -> tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked3}>>
+  return %1 : tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked3}>>
+}
@@ -0,0 +1,22 @@
+// RUN: triton-opt %s -tritongpu-combine 2>&1 | FileCheck %s
+
+// K is smaller than that of the 8-bit mma (32) and mfma (8) instructions:
+// the dot stays on FMA
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#dot_a = #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>
+#dot_b = #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>
+
+// CHECK-NOT: #triton_gpu.mma
+// CHECK-NOT: #triton_gpu.mfma
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: dot_small_k
+  func @dot_small_k(%A: tensor<32x4xi8, #blocked>, %B: tensor<4x32xi8, #blocked>) -> tensor<32x32xi32, #blocked> {
+    %C = arith.constant dense<0> : tensor<32x32xi32, #blocked>
+    %a = triton_gpu.convert_layout %A : (tensor<32x4xi8, #blocked>) -> tensor<32x4xi8, #dot_a>
+    %b = triton_gpu.convert_layout %B : (tensor<4x32xi8, #blocked>) -> tensor<4x32xi8, #dot_b>
+    // CHECK: tt.dot {{.*}} -> tensor<32x32xi32, #blocked>
+    %D = tt.dot %a, %b, %C {allowTF32 = true} : tensor<32x4xi8, #dot_a> * tensor<4x32xi8, #dot_b> -> tensor<32x32xi32, #blocked>
+    return %D : tensor<32x32xi32, #blocked>
+  }
+}
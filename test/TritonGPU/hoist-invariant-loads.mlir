@@ -0,0 +1,74 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-hoist-invariant-loads | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// The bias is loaded once, with its layout conversion, under the condition
+// that the loop runs
+// CHECK-LABEL: @hoist_bias
+func @hoist_bias(%X: !tt.ptr<f32>, %B: !tt.ptr<f32>, %N: i32) -> tensor<512xf32, #blocked1> {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %cst = arith.constant dense<0.000000e+00> : tensor<512xf32, #blocked1>
+  %range = tt.make_range {end = 512 : i32, start = 0 : i32} : tensor<512xi32, #blocked>
+  %b_ptrs = tt.splat %B : (!tt.ptr<f32>) -> tensor<512x!tt.ptr<f32>, #blocked>
+  %b_addrs = tt.addptr %b_ptrs, %range : tensor<512x!tt.ptr<f32>, #blocked>, tensor<512xi32, #blocked>
+  %x_ptrs = tt.splat %X : (!tt.ptr<f32>) -> tensor<512x!tt.ptr<f32>, #blocked>
+  // CHECK: %[[runs:.*]] = arith.cmpi slt, %c0{{.*}}, %arg2
+  // CHECK: %[[mask:.*]] = tt.splat %[[runs]] : (i1) -> tensor<512xi1, #blocked>
+  // CHECK: %[[bias:.*]] = tt.load %{{.*}}, %[[mask]] {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+  // CHECK: %[[cvt:.*]] = triton_gpu.convert_layout %[[bias]]
+  // CHECK: scf.for
+  // CHECK:   tt.load %{{.*}} {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+  // CHECK-NOT: tt.load
+  // CHECK:   arith.addf %{{.*}}, %[[cvt]]
+  %acc = scf.for %iv = %c0 to %N step %c1 iter_args(%acc = %cst) -> (tensor<512xf32, #blocked1>) : i32 {
+    %off = tt.splat %iv : (i32) -> tensor<512xi32, #blocked>
+    %x_addrs = tt.addptr %x_ptrs, %off : tensor<512x!tt.ptr<f32>, #blocked>, tensor<512xi32, #blocked>
+    %x = tt.load %x_addrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+    %bias = tt.load %b_addrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+    %x1 = triton_gpu.convert_layout %x : (tensor<512xf32, #blocked>) -> tensor<512xf32, #blocked1>
+    %bias1 = triton_gpu.convert_layout %bias : (tensor<512xf32, #blocked>) -> tensor<512xf32, #blocked1>
+    %sum = arith.addf %x1, %bias1 : tensor<512xf32, #blocked1>
+    %next = arith.addf %acc, %sum : tensor<512xf32, #blocked1>
+    scf.yield %next : tensor<512xf32, #blocked1>
+  }
+  return %acc : tensor<512xf32, #blocked1>
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// A store of the loop through another argument may overwrite the scale,
+// unless one of them aliases no other argument
+// CHECK-LABEL: @store_may_alias
+func @store_may_alias(%S: !tt.ptr<f32>, %Y: !tt.ptr<f32>, %Z: !tt.ptr<f32> {tt.noalias = 1 : i32}) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %range = tt.make_range {end = 512 : i32, start = 0 : i32} : tensor<512xi32, #blocked>
+  %s_ptrs = tt.splat %S : (!tt.ptr<f32>) -> tensor<512x!tt.ptr<f32>, #blocked>
+  %s_addrs = tt.addptr %s_ptrs, %range : tensor<512x!tt.ptr<f32>, #blocked>, tensor<512xi32, #blocked>
+  %y_ptrs = tt.splat %Y : (!tt.ptr<f32>) -> tensor<512x!tt.ptr<f32>, #blocked>
+  %y_addrs = tt.addptr %y_ptrs, %range : tensor<512x!tt.ptr<f32>, #blocked>, tensor<512xi32, #blocked>
+  %z_ptrs = tt.splat %Z : (!tt.ptr<f32>) -> tensor<512x!tt.ptr<f32>, #blocked>
+  %z_addrs = tt.addptr %z_ptrs, %range : tensor<512x!tt.ptr<f32>, #blocked>, tensor<512xi32, #blocked>
+  // CHECK: scf.for
+  // CHECK:   tt.load
+  // CHECK:   tt.store
+  scf.for %iv = %c0 to %c4 step %c1 {
+    %scale = tt.load %s_addrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+    tt.store %y_addrs, %scale : tensor<512xf32, #blocked>
+  }
+  // The loop runs, so that the load needs no guard
+  // CHECK: %[[scale:.*]] = tt.load %{{.*}} {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+  // CHECK-NEXT: scf.for
+  // CHECK-NOT:   tt.load
+  // CHECK:   tt.store %{{.*}}, %[[scale]]
+  scf.for %iv = %c0 to %c4 step %c1 {
+    %scale = tt.load %s_addrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+    tt.store %z_addrs, %scale : tensor<512xf32, #blocked>
+  }
+  return
+}
@@ -0,0 +1,34 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-list-schedule=register-budget=30 | FileCheck %s
+// RUN: triton-opt %s -split-input-file -tritongpu-list-schedule=register-budget=255 | FileCheck %s --check-prefix=KEEP
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// The pointers take 16 registers and each f32 tile 8: the original order
+// peaks at 40 registers, interleaving the loads and their uses at 32
+// CHECK: module attributes {{.*}}"triton_gpu.live-registers" = 32 : i32{{.*}}"triton_gpu.predicted-spills" = 2 : i32
+// KEEP: module attributes {{.*}}"triton_gpu.live-registers" = 40 : i32{{.*}}"triton_gpu.predicted-spills" = 0 : i32
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+// CHECK-LABEL: @interleave
+// KEEP-LABEL: @interleave
+func @interleave(%ptr: tensor<1024x!tt.ptr<f32>, #blocked>) {
+  // CHECK: %[[a:.*]] = tt.load %arg0
+  // CHECK-NEXT: %[[ea:.*]] = math.exp %[[a]]
+  // CHECK-NEXT: %[[b:.*]] = tt.load %arg0
+  // CHECK-NEXT: tt.store %arg0, %[[ea]]
+  // CHECK-NEXT: %[[eb:.*]] = math.exp %[[b]]
+  // CHECK-NEXT: tt.store %arg0, %[[eb]]
+  // KEEP: %[[a:.*]] = tt.load %arg0
+  // KEEP-NEXT: %[[b:.*]] = tt.load %arg0
+  // KEEP-NEXT: %[[ea:.*]] = math.exp %[[a]]
+  // KEEP-NEXT: %[[eb:.*]] = math.exp %[[b]]
+  // KEEP-NEXT: tt.store %arg0, %[[ea]]
+  // KEEP-NEXT: tt.store %arg0, %[[eb]]
+  %a = tt.load %ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32, #blocked>
+  %b = tt.load %ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32, #blocked>
+  %ea = math.exp %a : tensor<1024xf32, #blocked>
+  %eb = math.exp %b : tensor<1024xf32, #blocked>
+  tt.store %ptr, %ea : tensor<1024xf32, #blocked>
+  tt.store %ptr, %eb : tensor<1024xf32, #blocked>
+  return
+}
+}
@@ -220,3 +220,127 @@ func @matmul_loop_single_pipeline(%lb : index, %ub : index, %step : index,
   }
   return
 }
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// Loads that don't feed a dot are pipelined through registers
+// CHECK: func @reduce_loop
+// CHECK:   %[[LOAD_0:.*]] = tt.load
+// CHECK:   %[[IV_1:.*]] = arith.addi %[[LB:.*]], %[[STEP:.*]]
+// CHECK:   %[[LOOP_COND_1:.*]] = arith.cmpi slt, %[[IV_1]], %[[UB:.*]]
+// CHECK:   %[[LOOP_COND_1_SPLAT:.*]] = tt.splat %[[LOOP_COND_1]]
+// CHECK:   %[[LOAD_1:.*]] = tt.load %{{.*}}, %[[LOOP_COND_1_SPLAT]]
+// CHECK: scf.for %[[IV:.*]] = {{.*}} iter_args(%{{.*}} = %{{.*}}, %[[X_0:.*]] = %[[LOAD_0]], %[[X_1:.*]] = %[[LOAD_1]])
+// CHECK:   %[[NEXT_IV:.*]] = arith.addi %[[IV]]
+// CHECK:   %[[NEXT_COND:.*]] = arith.cmpi slt, %[[NEXT_IV]], %[[UB]]
+// CHECK:   %[[NEXT_X:.*]] = tt.load
+// CHECK:   %[[SUM:.*]] = arith.addf %{{.*}}, %[[X_0]]
+// CHECK:   scf.yield %[[SUM]], %[[X_1]], %[[NEXT_X]]
+func @reduce_loop(%lb : index, %ub : index, %step : index,
+                  %X : !tt.ptr<f32> {tt.divisibility = 16 : i32}) -> tensor<1024xf32, #blocked> {
+  %cst = arith.constant dense<0.000000e+00> : tensor<1024xf32, #blocked>
+  %range = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32, #blocked>
+  %ptrs = tt.splat %X : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>, #blocked>
+  %sum = scf.for %iv = %lb to %ub step %step iter_args(%acc = %cst) -> (tensor<1024xf32, #blocked>) {
+    %off = arith.index_cast %iv : index to i32
+    %off_splat = tt.splat %off : (i32) -> tensor<1024xi32, #blocked>
+    %cols = arith.addi %off_splat, %range : tensor<1024xi32, #blocked>
+    %x_ptrs = tt.addptr %ptrs, %cols : tensor<1024x!tt.ptr<f32>, #blocked>, tensor<1024xi32, #blocked>
+    %x = tt.load %x_ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32, #blocked>
+    %next = arith.addf %acc, %x : tensor<1024xf32, #blocked>
+    scf.yield %next : tensor<1024xf32, #blocked>
+  }
+  return %sum : tensor<1024xf32, #blocked>
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// Loads of what the loop writes are not issued before the stores of earlier
+// iterations, while those of noalias arguments are still pipelined
+// CHECK: func @store_loop
+// CHECK-NOT: tt.load {{.*}} : tensor<1024xf32, #blocked>
+// CHECK: tt.load {{.*}} : tensor<1024xf16, #blocked>
+// CHECK-NOT: tt.load {{.*}} : tensor<1024xf32, #blocked>
+// CHECK: scf.for
+// CHECK:   tt.load {{.*}} : tensor<1024xf32, #blocked>
+// CHECK:   tt.store
+func @store_loop(%lb : index, %ub : index, %step : index,
+                 %X : !tt.ptr<f32> {tt.divisibility = 16 : i32},
+                 %Y : !tt.ptr<f16> {tt.divisibility = 16 : i32, tt.noalias = 1 : i32}) {
+  %range = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32, #blocked>
+  %shift = arith.constant dense<1024> : tensor<1024xi32, #blocked>
+  %x_base = tt.splat %X : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>, #blocked>
+  %y_base = tt.splat %Y : (!tt.ptr<f16>) -> tensor<1024x!tt.ptr<f16>, #blocked>
+  scf.for %iv = %lb to %ub step %step {
+    %off = arith.index_cast %iv : index to i32
+    %off_splat = tt.splat %off : (i32) -> tensor<1024xi32, #blocked>
+    %cols = arith.addi %off_splat, %range : tensor<1024xi32, #blocked>
+    %x_ptrs = tt.addptr %x_base, %cols : tensor<1024x!tt.ptr<f32>, #blocked>, tensor<1024xi32, #blocked>
+    %y_ptrs = tt.addptr %y_base, %cols : tensor<1024x!tt.ptr<f16>, #blocked>, tensor<1024xi32, #blocked>
+    %x = tt.load %x_ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32, #blocked>
+    %y = tt.load %y_ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf16, #blocked>
+    %y_f32 = arith.extf %y : tensor<1024xf16, #blocked> to tensor<1024xf32, #blocked>
+    %sum = arith.addf %x, %y_f32 : tensor<1024xf32, #blocked>
+    // the next iterations read what this one writes
+    %out_cols = arith.addi %cols, %shift : tensor<1024xi32, #blocked>
+    %out_ptrs = tt.addptr %x_base, %out_cols : tensor<1024x!tt.ptr<f32>, #blocked>, tensor<1024xi32, #blocked>
+    tt.store %out_ptrs, %sum : tensor<1024xf32, #blocked>
+  }
+  return
+}
+
+// -----
+
+#BL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0]}>
+#BLs0 = #triton_gpu.slice<{parent=#BL, dim=0}>
+#C = #triton_gpu.mma<{versionMajor = 2, warpsPerCTA = [4, 1]}>
+#A = #triton_gpu.dot_op<{opIdx = 0, parent = #C}>
+#B = #triton_gpu.dot_op<{opIdx = 1, parent = #C}>
+
+// The pages of B are gathered through a block table: the loads of their
+// indices are masked by the condition of their iteration, and issued one
+// iteration ahead of the loads of the pages
+// CHECK: func @paged_loop
+// CHECK: %[[LOOP_COND_0:.*]] = arith.cmpi slt, %[[LB:.*]], %[[UB:.*]]
+// CHECK: tt.load %{{.*}}, %[[LOOP_COND_0]] {{.*}} : i32
+// CHECK: triton_gpu.insert_slice_async
+// CHECK: %[[LOOP_COND_1:.*]] = arith.cmpi slt
+// CHECK: tt.load %{{.*}}, %[[LOOP_COND_1]] {{.*}} : i32
+// CHECK: triton_gpu.insert_slice_async
+// CHECK: %[[AHEAD_COND:.*]] = arith.cmpi slt
+// CHECK: %[[AHEAD_PAGE:.*]] = tt.load %{{.*}}, %[[AHEAD_COND]] {{.*}} : i32
+// CHECK: scf.for {{.*}} iter_args({{.*}}%[[PAGE:arg[0-9]+]] = %[[AHEAD_PAGE]]
+// CHECK:   tt.dot
+// CHECK:   arith.muli %[[PAGE]]
+// CHECK:   %[[NEXT_AHEAD_COND:.*]] = arith.cmpi slt
+// CHECK:   %[[NEXT_AHEAD_PAGE:.*]] = tt.load %{{.*}}, %[[NEXT_AHEAD_COND]] {{.*}} : i32
+// CHECK:   triton_gpu.insert_slice_async
+// CHECK:   scf.yield {{.*}}, %[[NEXT_AHEAD_PAGE]], {{.*}}
+func @paged_loop(%lb : index, %ub : index, %step : index,
+                 %A : tensor<128x32xf16, #A>, %Table : !tt.ptr<i32>,
+                 %B : !tt.ptr<f16> {tt.divisibility = 16 : i32}) -> tensor<128x128xf32, #C> {
+  %b_ptr_splat = tt.splat %B : (!tt.ptr<f16>) -> tensor<32x128x!tt.ptr<f16>, #BL>
+  %b_tmp0 = tt.make_range {end = 128: i32, start = 0: i32} : tensor<128xi32, #BLs0>
+  %b_tmp1 = tt.expand_dims %b_tmp0 {axis = 0 : i32} : (tensor<128xi32, #BLs0>) -> tensor<1x128xi32, #BL>
+  %b_offs = tt.broadcast %b_tmp1 : (tensor<1x128xi32, #BL>) -> tensor<32x128xi32, #BL>
+  %b_ptr_init = tt.addptr %b_ptr_splat, %b_offs : tensor<32x128x!tt.ptr<f16>, #BL>, tensor<32x128xi32, #BL>
+  %page_size = arith.constant 4096 : i32
+  %c_init = arith.constant dense<0.00e+00> : tensor<128x128xf32, #C>
+  %res = scf.for %iv = %lb to %ub step %step iter_args(%prev_c = %c_init) -> (tensor<128x128xf32, #C>) {
+    %idx = arith.index_cast %iv : index to i32
+    %slot = tt.addptr %Table, %idx : !tt.ptr<i32>, i32
+    %page = tt.load %slot {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : i32
+    %page_off = arith.muli %page, %page_size : i32
+    %page_off_splat = tt.splat %page_off : (i32) -> tensor<32x128xi32, #BL>
+    %b_ptr = tt.addptr %b_ptr_init, %page_off_splat : tensor<32x128x!tt.ptr<f16>, #BL>, tensor<32x128xi32, #BL>
+    %b_ = tt.load %b_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x128xf16, #BL>
+    %b = triton_gpu.convert_layout %b_ : (tensor<32x128xf16, #BL>) -> tensor<32x128xf16, #B>
+    %c = tt.dot %A, %b, %prev_c {allowTF32 = true, transA = false, transB = false} : tensor<128x32xf16, #A> * tensor<32x128xf16, #B> -> tensor<128x128xf32, #C>
+    scf.yield %c : tensor<128x128xf32, #C>
+  }
+  return %res : tensor<128x128xf32, #C>
+}
@@ -0,0 +1,94 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-loop-unroll | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// CHECK-LABEL: @unroll_by_factor
+func @unroll_by_factor(%X: tensor<128x!tt.ptr<f32>, #blocked>) -> tensor<128xf32, #blocked> {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %cst = arith.constant dense<0.000000e+00> : tensor<128xf32, #blocked>
+  // CHECK: %[[c2:.*]] = arith.constant 2 : index
+  // CHECK: scf.for %[[iv:.*]] = %c0 to %c8 step %[[c2]] iter_args(%[[acc:.*]] = %{{.*}})
+  // CHECK:   %[[x0:.*]] = tt.load
+  // CHECK:   %[[acc0:.*]] = arith.addf %[[acc]], %[[x0]]
+  // CHECK:   %[[iv1:.*]] = arith.addi %[[iv]], %c1
+  // CHECK:   arith.index_cast %[[iv1]]
+  // CHECK:   %[[x1:.*]] = tt.load
+  // CHECK:   %[[acc1:.*]] = arith.addf %[[acc0]], %[[x1]]
+  // CHECK:   scf.yield %[[acc1]]
+  // CHECK-NOT: tt.unroll_factor
+  %acc = scf.for %iv = %c0 to %c8 step %c1 iter_args(%acc = %cst) -> (tensor<128xf32, #blocked>) {
+    %off = arith.index_cast %iv : index to i32
+    %offs = tt.splat %off : (i32) -> tensor<128xi32, #blocked>
+    %ptrs = tt.addptr %X, %offs : tensor<128x!tt.ptr<f32>, #blocked>, tensor<128xi32, #blocked>
+    %x = tt.load %ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+    %next = arith.addf %acc, %x : tensor<128xf32, #blocked>
+    scf.yield %next : tensor<128xf32, #blocked>
+  } {tt.unroll_factor = 2 : i32}
+  return %acc : tensor<128xf32, #blocked>
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// The last of the 7 iterations runs in a copy of the original loop
+// CHECK-LABEL: @unroll_with_remainder
+func @unroll_with_remainder(%X: tensor<128x!tt.ptr<f32>, #blocked>) -> tensor<128xf32, #blocked> {
+  %c0 = arith.constant 0 : index
+  %c2 = arith.constant 2 : index
+  %c14 = arith.constant 14 : index
+  %cst = arith.constant dense<0.000000e+00> : tensor<128xf32, #blocked>
+  // CHECK: %[[main_ub:.*]] = arith.constant 12 : index
+  // CHECK: %[[c6:.*]] = arith.constant 6 : index
+  // CHECK: %[[main:.*]] = scf.for %{{.*}} = %c0 to %[[main_ub]] step %[[c6]]
+  // CHECK-COUNT-3: tt.load
+  // CHECK: scf.for %{{.*}} = %[[main_ub]] to %c14 step %c2 iter_args(%{{.*}} = %[[main]])
+  // CHECK:   tt.load
+  %acc = scf.for %iv = %c0 to %c14 step %c2 iter_args(%acc = %cst) -> (tensor<128xf32, #blocked>) {
+    %off = arith.index_cast %iv : index to i32
+    %offs = tt.splat %off : (i32) -> tensor<128xi32, #blocked>
+    %ptrs = tt.addptr %X, %offs : tensor<128x!tt.ptr<f32>, #blocked>, tensor<128xi32, #blocked>
+    %x = tt.load %ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+    %next = arith.addf %acc, %x : tensor<128xf32, #blocked>
+    scf.yield %next : tensor<128xf32, #blocked>
+  } {tt.unroll_factor = 3 : i32}
+  return %acc : tensor<128xf32, #blocked>
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// Loops of at most factor iterations are replaced by their bodies, and loops
+// with dynamic bounds are left alone
+// CHECK-LABEL: @full_unroll
+func @full_unroll(%X: tensor<128x!tt.ptr<f32>, #blocked>, %ub: index) -> (tensor<128xf32, #blocked>, tensor<128xf32, #blocked>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c3 = arith.constant 3 : index
+  %cst = arith.constant dense<0.000000e+00> : tensor<128xf32, #blocked>
+  // CHECK-NOT: scf.for
+  // CHECK-COUNT-3: tt.load
+  // CHECK: scf.for %{{.*}} = %c0 to %{{.*}} step %c1
+  // CHECK:   tt.load
+  // CHECK-NOT: tt.unroll_factor
+  %acc = scf.for %iv = %c0 to %c3 step %c1 iter_args(%acc = %cst) -> (tensor<128xf32, #blocked>) {
+    %off = arith.index_cast %iv : index to i32
+    %offs = tt.splat %off : (i32) -> tensor<128xi32, #blocked>
+    %ptrs = tt.addptr %X, %offs : tensor<128x!tt.ptr<f32>, #blocked>, tensor<128xi32, #blocked>
+    %x = tt.load %ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+    %next = arith.addf %acc, %x : tensor<128xf32, #blocked>
+    scf.yield %next : tensor<128xf32, #blocked>
+  } {tt.unroll_factor = 4 : i32}
+  %acc2 = scf.for %iv = %c0 to %ub step %c1 iter_args(%acc2 = %cst) -> (tensor<128xf32, #blocked>) {
+    %off = arith.index_cast %iv : index to i32
+    %offs = tt.splat %off : (i32) -> tensor<128xi32, #blocked>
+    %ptrs = tt.addptr %X, %offs : tensor<128x!tt.ptr<f32>, #blocked>, tensor<128xi32, #blocked>
+    %x = tt.load %ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+    %next = arith.addf %acc2, %x : tensor<128xf32, #blocked>
+    scf.yield %next : tensor<128xf32, #blocked>
+  } {tt.unroll_factor = 4 : i32}
+  return %acc, %acc2 : tensor<128xf32, #blocked>, tensor<128xf32, #blocked>
+}
@@ -0,0 +1,61 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-peel-loops | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// for off in range(0, N, 128): x = tl.load(X + off + tl.arange(0, 128), mask=cols < N)
+// CHECK-LABEL: @peel_last_iteration
+func @peel_last_iteration(%X: !tt.ptr<f32>, %N: i32) -> tensor<128xf32, #blocked> {
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %cst = arith.constant dense<0.000000e+00> : tensor<128xf32, #blocked>
+  %ub = arith.index_cast %N : i32 to index
+  %range = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32, #blocked>
+  %ptrs = tt.splat %X : (!tt.ptr<f32>) -> tensor<128x!tt.ptr<f32>, #blocked>
+  %n = tt.splat %N : (i32) -> tensor<128xi32, #blocked>
+  // CHECK: %[[span:.*]] = arith.subi %[[ub:.*]], %c0
+  // CHECK: %[[rem:.*]] = arith.remsi %[[span]], %c128
+  // CHECK: %[[main_ub:.*]] = arith.subi %[[ub]], %[[rem]]
+  // CHECK: %[[main:.*]] = scf.for %{{.*}} = %c0 to %[[main_ub]] step %c128
+  // CHECK:   tt.load %{{.*}} {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+  // CHECK: scf.for %{{.*}} = %[[main_ub]] to %[[ub]] step %c128 iter_args(%{{.*}} = %[[main]])
+  // CHECK:   tt.load %{{.*}}, %{{.*}}, %{{.*}} {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+  // CHECK: } {triton_gpu.peeled_tail}
+  %acc = scf.for %iv = %c0 to %ub step %c128 iter_args(%acc = %cst) -> (tensor<128xf32, #blocked>) {
+    %off = arith.index_cast %iv : index to i32
+    %off_splat = tt.splat %off : (i32) -> tensor<128xi32, #blocked>
+    %cols = arith.addi %off_splat, %range : tensor<128xi32, #blocked>
+    %mask = arith.cmpi slt, %cols, %n : tensor<128xi32, #blocked>
+    %x_ptrs = tt.addptr %ptrs, %cols : tensor<128x!tt.ptr<f32>, #blocked>, tensor<128xi32, #blocked>
+    %x = tt.load %x_ptrs, %mask, %cst {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+    %next = arith.addf %acc, %x : tensor<128xf32, #blocked>
+    scf.yield %next : tensor<128xf32, #blocked>
+  }
+  return %acc : tensor<128xf32, #blocked>
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+
+// A block of 256 elements per step of 128 may be partial in any iteration
+// CHECK-LABEL: @mask_wider_than_step
+func @mask_wider_than_step(%X: !tt.ptr<f32>, %N: i32) {
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %cst = arith.constant dense<0.000000e+00> : tensor<256xf32, #blocked>
+  %ub = arith.index_cast %N : i32 to index
+  %range = tt.make_range {end = 256 : i32, start = 0 : i32} : tensor<256xi32, #blocked>
+  %ptrs = tt.splat %X : (!tt.ptr<f32>) -> tensor<256x!tt.ptr<f32>, #blocked>
+  %n = tt.splat %N : (i32) -> tensor<256xi32, #blocked>
+  // CHECK: scf.for
+  // CHECK-NOT: scf.for
+  scf.for %iv = %c0 to %ub step %c128 {
+    %off = arith.index_cast %iv : index to i32
+    %off_splat = tt.splat %off : (i32) -> tensor<256xi32, #blocked>
+    %cols = arith.addi %off_splat, %range : tensor<256xi32, #blocked>
+    %mask = arith.cmpi slt, %cols, %n : tensor<256xi32, #blocked>
+    %x_ptrs = tt.addptr %ptrs, %cols : tensor<256x!tt.ptr<f32>, #blocked>, tensor<256xi32, #blocked>
+    tt.store %x_ptrs, %cst, %mask : tensor<256xf32, #blocked>
+  }
+  return
+}
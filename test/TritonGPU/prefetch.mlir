@@ -1,4 +1,5 @@
 // RUN: triton-opt %s -split-input-file -tritongpu-prefetch | FileCheck %s
+// RUN: triton-opt %s -split-input-file -tritongpu-prefetch=prefetch-width=64 | FileCheck %s --check-prefix=WIDTH
 
 // 4 warps
 // matmul: 128x32 @ 32x128 -> 128x128
@@ -63,3 +64,39 @@ func @matmul_loop(%lb : index, %ub : index, %step : index, %A : !tt.ptr<f16>, %B
   return
 }
 
+
+// -----
+
+#A = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0]}>
+#B = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0]}>
+#C = #triton_gpu.mma<{versionMajor = 2, warpsPerCTA = [4, 1]}>
+#A_OP = #triton_gpu.dot_op<{opIdx = 0, parent = #C}>
+#B_OP = #triton_gpu.dot_op<{opIdx = 1, parent = #C}>
+
+// K = 128 is split into 4 slices of 32, unless a width is requested. The
+// loop-invariant operand a is prefetched once, before the loop.
+// CHECK: func @matmul_loop_invariant_a
+// CHECK-DAG: %[[A0_PREFETCH_SMEM:.*]] = tensor.extract_slice %[[A0:.*]][0, 0] [128, 32]
+// CHECK-DAG: %[[A0_PREFETCH:.*]] = triton_gpu.convert_layout %[[A0_PREFETCH_SMEM]]
+// CHECK:     scf.for {{.*}} iter_args({{.*}}, {{.*}}, %[[a0_prefetch:.*]] = %[[A0_PREFETCH]], %{{.*}} = %{{.*}})
+// CHECK-DAG:   tensor.extract_slice %[[A0]][0, 32] [128, 32]
+// CHECK-DAG:   tensor.extract_slice %[[A0]][0, 64] [128, 32]
+// CHECK-DAG:   tensor.extract_slice %[[A0]][0, 96] [128, 32]
+// CHECK:       tt.dot %[[a0_prefetch]]
+// CHECK:     scf.yield {{.*}}, {{.*}}, %[[a0_prefetch]], %{{.*}}
+// WIDTH: func @matmul_loop_invariant_a
+// WIDTH-DAG: tensor.extract_slice %{{.*}}[0, 0] [128, 64]
+// WIDTH:     scf.for
+// WIDTH-DAG:   tensor.extract_slice %{{.*}}[0, 64] [128, 64]
+// WIDTH-NOT:   tensor.extract_slice %{{.*}}[0, 32]
+// WIDTH:     scf.yield
+func @matmul_loop_invariant_a(%lb : index, %ub : index, %step : index, %a : tensor<128x128xf16, #A>, %b_init : tensor<128x128xf16, #B>) {
+  %c_init = arith.constant dense<0.00e+00> : tensor<128x128xf32, #C>
+  scf.for %iv = %lb to %ub step %step iter_args(%b = %b_init, %prev_c = %c_init) -> (tensor<128x128xf16, #B>, tensor<128x128xf32, #C>) {
+    %a_op = triton_gpu.convert_layout %a : (tensor<128x128xf16, #A>) -> tensor<128x128xf16, #A_OP>
+    %b_op = triton_gpu.convert_layout %b : (tensor<128x128xf16, #B>) -> tensor<128x128xf16, #B_OP>
+    %c = tt.dot %a_op, %b_op, %prev_c {allowTF32 = true, transA = false, transB = false} : tensor<128x128xf16, #A_OP> * tensor<128x128xf16, #B_OP> -> tensor<128x128xf32, #C>
+    scf.yield %b, %c : tensor<128x128xf16, #B>, tensor<128x128xf32, #C>
+  }
+  return
+}
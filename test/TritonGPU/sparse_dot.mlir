@@ -0,0 +1,22 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-combine=compute-capability=80 2>&1 | FileCheck %s
+
+// The compressed $a and $b of a 2:4 sparse dot are given to mma.sp, and its
+// metadata is converted to the layout of the registers of mma.sp
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#dot_a = #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>
+#dot_b = #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>
+
+// CHECK: #[[MMA:.*]] = #triton_gpu.mma<{versionMajor = 2
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: sparse_dot
+  func @sparse_dot(%A: tensor<64x32xf16, #blocked>, %E: tensor<64x4xi16, #blocked>, %B: tensor<64x64xf16, #blocked>) -> tensor<64x64xf32, #blocked> {
+    %C = arith.constant dense<0.000000e+00> : tensor<64x64xf32, #blocked>
+    %a = triton_gpu.convert_layout %A : (tensor<64x32xf16, #blocked>) -> tensor<64x32xf16, #dot_a>
+    %b = triton_gpu.convert_layout %B : (tensor<64x64xf16, #blocked>) -> tensor<64x64xf16, #dot_b>
+    // CHECK: triton_gpu.convert_layout {{.*}} -> tensor<64x4xi16, #triton_gpu.sparse_dot_meta<{parent = #[[MMA]]}>>
+    // CHECK: tt.sparse_dot {{.*}} -> tensor<64x64xf32, #[[MMA]]>
+    %D = tt.sparse_dot %a, %E, %b, %C : tensor<64x32xf16, #dot_a>, tensor<64x4xi16, #blocked> * tensor<64x64xf16, #dot_b> -> tensor<64x64xf32, #blocked>
+    return %D : tensor<64x64xf32, #blocked>
+  }
+}
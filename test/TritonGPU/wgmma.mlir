@@ -0,0 +1,60 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-combine=compute-capability=90 2>&1 | FileCheck %s
+
+// The dot is given to warpgroups when the rows of $b are 32, 64 or 128 bytes
+// long and every warp has its own 16 rows
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#dot_a = #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>
+#dot_b = #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>
+
+// CHECK: #triton_gpu.mma<{versionMajor = 3, {{.*}}warpsPerCTA = [4, 1]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: wgmma
+  func @wgmma(%A: tensor<128x64xf16, #blocked>, %B: tensor<64x64xf16, #blocked>) -> tensor<128x64xf32, #blocked> {
+    %C = arith.constant dense<0.000000e+00> : tensor<128x64xf32, #blocked>
+    %a = triton_gpu.convert_layout %A : (tensor<128x64xf16, #blocked>) -> tensor<128x64xf16, #dot_a>
+    %b = triton_gpu.convert_layout %B : (tensor<64x64xf16, #blocked>) -> tensor<64x64xf16, #dot_b>
+    %D = tt.dot %a, %b, %C {allowTF32 = true} : tensor<128x64xf16, #dot_a> * tensor<64x64xf16, #dot_b> -> tensor<128x64xf32, #blocked>
+    return %D : tensor<128x64xf32, #blocked>
+  }
+}
+
+// -----
+
+// Rows of $b of 256 bytes are not a layout of wgmma: mma.sync is used
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#dot_a = #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>
+#dot_b = #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>
+
+// CHECK: #triton_gpu.mma<{versionMajor = 2
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: mma_long_rows
+  func @mma_long_rows(%A: tensor<128x64xf16, #blocked>, %B: tensor<64x128xf16, #blocked>) -> tensor<128x128xf32, #blocked> {
+    %C = arith.constant dense<0.000000e+00> : tensor<128x128xf32, #blocked>
+    %a = triton_gpu.convert_layout %A : (tensor<128x64xf16, #blocked>) -> tensor<128x64xf16, #dot_a>
+    %b = triton_gpu.convert_layout %B : (tensor<64x128xf16, #blocked>) -> tensor<64x128xf16, #dot_b>
+    %D = tt.dot %a, %b, %C {allowTF32 = true} : tensor<128x64xf16, #dot_a> * tensor<64x128xf16, #dot_b> -> tensor<128x128xf32, #blocked>
+    return %D : tensor<128x128xf32, #blocked>
+  }
+}
+
+// -----
+
+// The warps of a warpgroup hold 64 rows of the result together
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#dot_a = #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>
+#dot_b = #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>
+
+// CHECK: #triton_gpu.mma<{versionMajor = 2
+module attributes {"triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: mma_short_m
+  func @mma_short_m(%A: tensor<32x64xf16, #blocked>, %B: tensor<64x64xf16, #blocked>) -> tensor<32x64xf32, #blocked> {
+    %C = arith.constant dense<0.000000e+00> : tensor<32x64xf32, #blocked>
+    %a = triton_gpu.convert_layout %A : (tensor<32x64xf16, #blocked>) -> tensor<32x64xf16, #dot_a>
+    %b = triton_gpu.convert_layout %B : (tensor<64x64xf16, #blocked>) -> tensor<64x64xf16, #dot_b>
+    %D = tt.dot %a, %b, %C {allowTF32 = true} : tensor<32x64xf16, #dot_a> * tensor<64x64xf16, #dot_b> -> tensor<32x64xf32, #blocked>
+    return %D : tensor<32x64xf32, #blocked>
+  }
+}
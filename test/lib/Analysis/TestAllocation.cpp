@@ -22,7 +22,8 @@ struct TestAllocationPass
     // Convert to std::string can remove quotes from opName
     auto opName = SymbolTable::getSymbolName(operation).getValue().str();
     os << opName << "\n";
-    Allocation allocation(operation);
+    Allocation &allocation = getAnalysis<Allocation>();
+    markAllAnalysesPreserved();
     operation->walk([&](Operation *op) {
       auto scratchBufferId = allocation.getBufferId(op);
       if (scratchBufferId != Allocation::InvalidBufferId) {
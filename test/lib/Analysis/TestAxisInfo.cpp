@@ -31,8 +31,8 @@ struct TestAxisInfoPass
     auto &os = llvm::errs();
     auto opName = SymbolTable::getSymbolName(operation).getValue().str();
     os << opName << "\n";
-    AxisInfoAnalysis analysis(&getContext());
-    analysis.run(operation);
+    AxisInfoAnalysis &analysis = getAnalysis<CachedAxisInfoAnalysis>();
+    markAllAnalysesPreserved();
     operation->walk([&](Operation *op) {
       if (op->getNumResults() < 1)
         return;
@@ -0,0 +1,60 @@
+#include "mlir/Pass/Pass.h"
+#include "triton/Analysis/Utility.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+
+using namespace mlir;
+
+namespace {
+
+struct TestBankConflictsPass
+    : public PassWrapper<TestBankConflictsPass, OperationPass<FuncOp>> {
+
+  // LLVM15+
+  // MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TestBankConflictsPass);
+
+  StringRef getArgument() const final { return "test-print-bank-conflicts"; }
+  StringRef getDescription() const final {
+    return "print the estimated bank conflicts of the shared memory accesses";
+  }
+
+  void runOnOperation() override {
+    Operation *operation = getOperation();
+    auto &os = llvm::errs();
+    auto opName = SymbolTable::getSymbolName(operation).getValue().str();
+    os << opName << "\n";
+    unsigned numBanks = triton::gpu::TritonGPUDialect::getSharedBanks(
+        operation->getParentOfType<ModuleOp>());
+    auto print = [&](StringRef access, RankedTensorType sharedTy,
+                     Attribute layout) {
+      if (unsigned ways = getBankConflictWays(sharedTy, layout, numBanks))
+        os << access << " ways = " << ways << "\n";
+    };
+    operation->walk([&](Operation *op) {
+      if (auto insertOp = dyn_cast<triton::gpu::InsertSliceAsyncOp>(op)) {
+        auto srcTy = insertOp.src().getType().cast<RankedTensorType>();
+        print("store", insertOp.getType().cast<RankedTensorType>(),
+              srcTy.getEncoding());
+        return;
+      }
+      auto cvtOp = dyn_cast<triton::gpu::ConvertLayoutOp>(op);
+      if (!cvtOp)
+        return;
+      auto srcTy = cvtOp.src().getType().cast<RankedTensorType>();
+      auto dstTy = cvtOp.getType().cast<RankedTensorType>();
+      if (isSharedEncoding(cvtOp.result()))
+        print("store", dstTy, srcTy.getEncoding());
+      else if (isSharedEncoding(cvtOp.src()))
+        print("load", srcTy, dstTy.getEncoding());
+    });
+  }
+};
+
+} // namespace
+
+namespace mlir {
+namespace test {
+void registerTestBankConflictsPass() {
+  PassRegistration<TestBankConflictsPass>();
+}
+} // namespace test
+} // namespace mlir
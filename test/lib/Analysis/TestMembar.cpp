@@ -3,6 +3,7 @@
 #include "mlir/Pass/Pass.h"
 #include "triton/Analysis/Allocation.h"
 #include "triton/Analysis/Membar.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
 
 using namespace mlir;
 
@@ -34,6 +35,12 @@ struct TestMembarPass
       if (isa<gpu::BarrierOp>(op)) {
         os << "Membar " << operationId << "\n";
       }
+      if (isa<triton::gpu::WarpBarrierOp>(op)) {
+        os << "Warp barrier " << operationId << "\n";
+      }
+      if (isa<triton::gpu::ClusterBarrierOp>(op)) {
+        os << "Cluster barrier " << operationId << "\n";
+      }
       if (op->getNumRegions() == 0) {
         // Don't count parent Operation to simplify the test.
         operationId++;
@@ -0,0 +1,233 @@
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Transforms/Passes.h"
+#include "triton/Analysis/Allocation.h"
+#include "triton/Analysis/AxisInfo.h"
+#include "triton/Analysis/Membar.h"
+#include "triton/Conversion/TritonToTritonGPU/TritonToTritonGPUPass.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include <benchmark/benchmark.h>
+
+#include <functional>
+
+//===----------------------------------------------------------------------===//
+//
+// Compile-time benchmarks of the analyses and passes of the compiler.
+//
+// Each kernel of the corpus (TTIR files, by default those of the corpus/
+// directory) is lowered by the passes of `ttir_to_ttgir` in compiler.py, and
+// each pass is timed in isolation on the module produced by the previous
+// ones. The analyses are timed on the fully lowered module. The results are
+// machine readable with the options of Google Benchmark, e.g.
+//
+//   TritonPassBenchmark --corpus=<dir> --benchmark_out=passes.json \
+//                       --benchmark_out_format=json
+//
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+namespace {
+
+constexpr int kNumWarps = 4;
+constexpr int kNumStages = 3;
+constexpr int kComputeCapability = 80;
+
+struct Stage {
+  const char *name;
+  std::function<void(PassManager &)> addPasses;
+};
+
+// The passes of `ttir_to_ttgir`, without the optional ones
+const std::vector<Stage> &getStages() {
+  static const std::vector<Stage> stages = {
+      {"ConvertTritonToTritonGPU",
+       [](PassManager &pm) {
+         pm.addPass(triton::createConvertTritonToTritonGPUPass(kNumWarps));
+       }},
+      {"TritonGPUCoalesce",
+       [](PassManager &pm) { pm.addPass(createTritonGPUCoalescePass()); }},
+      {"TritonGPUCombineOps",
+       [](PassManager &pm) {
+         pm.addPass(createTritonGPUCombineOpsPass(kComputeCapability));
+       }},
+      {"TritonGPUPeelLoops",
+       [](PassManager &pm) { pm.addPass(createTritonGPUPeelLoopsPass()); }},
+      {"TritonGPUPipeline",
+       [](PassManager &pm) {
+         pm.addPass(createTritonGPUPipelinePass(kNumStages));
+       }},
+      {"TritonGPUPrefetch",
+       [](PassManager &pm) { pm.addPass(createTritonGPUPrefetchPass()); }},
+      {"Canonicalizer",
+       [](PassManager &pm) { pm.addPass(createCanonicalizerPass()); }},
+      {"TritonGPUCombineOps.2",
+       [](PassManager &pm) {
+         pm.addPass(createTritonGPUCombineOpsPass(kComputeCapability));
+       }},
+      {"TritonGPUDecomposeConversions",
+       [](PassManager &pm) {
+         pm.addPass(createTritonGPUDecomposeConversionsPass());
+       }},
+      {"TritonGPUReorderInstructions",
+       [](PassManager &pm) {
+         pm.addPass(createTritonGPUReorderInstructionsPass());
+       }},
+      {"TritonGPUListSchedule",
+       [](PassManager &pm) { pm.addPass(createTritonGPUListSchedulePass()); }},
+  };
+  return stages;
+}
+
+DialectRegistry getRegistry() {
+  DialectRegistry registry;
+  registry.insert<triton::TritonDialect, triton::gpu::TritonGPUDialect,
+                  math::MathDialect, arith::ArithmeticDialect,
+                  StandardOpsDialect, scf::SCFDialect, gpu::GPUDialect>();
+  return registry;
+}
+
+MLIRContext &getContext() {
+  static MLIRContext context(getRegistry());
+  context.loadAllAvailableDialects();
+  return context;
+}
+
+size_t countOps(ModuleOp module) {
+  size_t numOps = 0;
+  module.walk([&](Operation *) { ++numOps; });
+  return numOps;
+}
+
+// Times `run` on a fresh copy of `input` at each iteration
+void benchmarkOnClone(benchmark::State &state, ModuleOp input,
+                      const std::function<void(ModuleOp)> &run) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    OwningOpRef<ModuleOp> module(input.clone());
+    state.ResumeTiming();
+    run(*module);
+    state.PauseTiming();
+    module = nullptr;
+    state.ResumeTiming();
+  }
+  state.counters["ops"] = countOps(input);
+}
+
+void registerKernel(StringRef path) {
+  MLIRContext &context = getContext();
+  OwningOpRef<ModuleOp> parsed = parseSourceFile(path, &context);
+  if (!parsed) {
+    llvm::errs() << "failed to parse " << path << "\n";
+    return;
+  }
+  std::string kernel = llvm::sys::path::stem(path).str();
+
+  // The inputs of the stages, kept alive until the benchmarks have run
+  static std::vector<OwningOpRef<ModuleOp>> modules;
+  modules.push_back(std::move(parsed));
+  for (const Stage &stage : getStages()) {
+    ModuleOp input = *modules.back();
+    benchmark::RegisterBenchmark(
+        (kernel + "/" + stage.name).c_str(),
+        [input, &stage](benchmark::State &state) {
+          PassManager pm(input.getContext());
+          pm.enableVerifier(false);
+          stage.addPasses(pm);
+          benchmarkOnClone(state, input, [&](ModuleOp module) {
+            if (failed(pm.run(module)))
+              state.SkipWithError("pass failed");
+          });
+        })
+        ->Unit(benchmark::kMicrosecond);
+
+    OwningOpRef<ModuleOp> output(input.clone());
+    PassManager pm(&context);
+    stage.addPasses(pm);
+    if (failed(pm.run(*output))) {
+      llvm::errs() << kernel << ": " << stage.name << " failed\n";
+      return;
+    }
+    modules.push_back(std::move(output));
+  }
+
+  ModuleOp lowered = *modules.back();
+  benchmark::RegisterBenchmark(
+      (kernel + "/AxisInfoAnalysis").c_str(),
+      [lowered](benchmark::State &state) {
+        benchmarkOnClone(state, lowered, [](ModuleOp module) {
+          module.walk([](FuncOp funcOp) {
+            AxisInfoAnalysis analysis(funcOp.getContext());
+            analysis.run(funcOp);
+          });
+        });
+      })
+      ->Unit(benchmark::kMicrosecond);
+  benchmark::RegisterBenchmark(
+      (kernel + "/Allocation").c_str(),
+      [lowered](benchmark::State &state) {
+        benchmarkOnClone(state, lowered, [](ModuleOp module) {
+          Allocation allocation(module);
+          benchmark::DoNotOptimize(allocation.getSharedMemorySize());
+        });
+      })
+      ->Unit(benchmark::kMicrosecond);
+  // The analysis inserts barriers, hence runs on copies as well, and the
+  // allocation it depends on is not timed
+  benchmark::RegisterBenchmark(
+      (kernel + "/MembarAnalysis").c_str(),
+      [lowered](benchmark::State &state) {
+        benchmarkOnClone(state, lowered, [&](ModuleOp module) {
+          state.PauseTiming();
+          Allocation allocation(module);
+          state.ResumeTiming();
+          MembarAnalysis analysis(&allocation);
+          analysis.run();
+        });
+      })
+      ->Unit(benchmark::kMicrosecond);
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  std::string corpus = TRITON_BENCHMARK_CORPUS_DIR;
+  for (int i = 1; i < argc; ++i) {
+    StringRef arg(argv[i]);
+    if (arg.consume_front("--corpus=")) {
+      corpus = arg.str();
+      argv[i--] = argv[--argc];
+    }
+  }
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  std::error_code ec;
+  std::vector<std::string> paths;
+  for (llvm::sys::fs::directory_iterator it(corpus, ec), end;
+       it != end && !ec; it.increment(ec))
+    if (llvm::sys::path::extension(it->path()) == ".mlir")
+      paths.push_back(it->path());
+  if (ec || paths.empty()) {
+    llvm::errs() << "no kernel found in " << corpus << "\n";
+    return 1;
+  }
+  llvm::sort(paths);
+  for (const std::string &path : paths)
+    registerKernel(path);
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Flash-attention forward of 128 queries per program over blocks of 64 keys,
+// with a head dimension of 64 in fp16
+module {
+func @attention_fwd(%arg0: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg1: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg2: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg3: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg4: f32, %arg5: i32 {tt.divisibility = 16 : i32}, %arg6: i32) {
+  %c0 = arith.constant 0 : index
+  %c64 = arith.constant 64 : index
+  %c64_i32 = arith.constant 64 : i32
+  %c128_i32 = arith.constant 128 : i32
+  %cst = arith.constant dense<0.000000e+00> : tensor<128x64xf32>
+  %cst_0 = arith.constant dense<0xFF800000> : tensor<128xf32>
+  %cst_1 = arith.constant dense<0.000000e+00> : tensor<128xf32>
+  %0 = tt.get_program_id {axis = 0 : i32} : i32
+  %1 = arith.muli %0, %c128_i32 : i32
+  %2 = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32>
+  %3 = tt.splat %1 : (i32) -> tensor<128xi32>
+  %4 = arith.addi %3, %2 : tensor<128xi32>
+  %5 = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32>
+  %6 = tt.expand_dims %4 {axis = 1 : i32} : (tensor<128xi32>) -> tensor<128x1xi32>
+  %7 = tt.splat %arg5 : (i32) -> tensor<128x1xi32>
+  %8 = arith.muli %6, %7 : tensor<128x1xi32>
+  %9 = tt.expand_dims %5 {axis = 0 : i32} : (tensor<64xi32>) -> tensor<1x64xi32>
+  %10 = tt.broadcast %8 : (tensor<128x1xi32>) -> tensor<128x64xi32>
+  %11 = tt.broadcast %9 : (tensor<1x64xi32>) -> tensor<128x64xi32>
+  %12 = arith.addi %10, %11 : tensor<128x64xi32>
+  %13 = tt.splat %arg0 : (!tt.ptr<f16>) -> tensor<128x64x!tt.ptr<f16>>
+  %14 = tt.addptr %13, %12 : tensor<128x64x!tt.ptr<f16>>, tensor<128x64xi32>
+  %15 = tt.load %14 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x64xf16>
+  %16 = tt.expand_dims %5 {axis = 1 : i32} : (tensor<64xi32>) -> tensor<64x1xi32>
+  %17 = tt.splat %arg5 : (i32) -> tensor<1x64xi32>
+  %18 = arith.muli %9, %17 : tensor<1x64xi32>
+  %19 = tt.broadcast %16 : (tensor<64x1xi32>) -> tensor<64x64xi32>
+  %20 = tt.broadcast %18 : (tensor<1x64xi32>) -> tensor<64x64xi32>
+  %21 = arith.addi %19, %20 : tensor<64x64xi32>
+  %22 = tt.splat %arg1 : (!tt.ptr<f16>) -> tensor<64x64x!tt.ptr<f16>>
+  %23 = tt.addptr %22, %21 : tensor<64x64x!tt.ptr<f16>>, tensor<64x64xi32>
+  %24 = tt.splat %arg5 : (i32) -> tensor<64x1xi32>
+  %25 = arith.muli %16, %24 : tensor<64x1xi32>
+  %26 = tt.broadcast %25 : (tensor<64x1xi32>) -> tensor<64x64xi32>
+  %27 = tt.broadcast %9 : (tensor<1x64xi32>) -> tensor<64x64xi32>
+  %28 = arith.addi %26, %27 : tensor<64x64xi32>
+  %29 = tt.splat %arg2 : (!tt.ptr<f16>) -> tensor<64x64x!tt.ptr<f16>>
+  %30 = tt.addptr %29, %28 : tensor<64x64x!tt.ptr<f16>>, tensor<64x64xi32>
+  %31 = arith.muli %arg5, %c64_i32 : i32
+  %32 = tt.splat %31 : (i32) -> tensor<64x64xi32>
+  %33 = tt.splat %arg4 : (f32) -> tensor<128x64xf32>
+  %34 = arith.index_cast %arg6 : i32 to index
+  %35:5 = scf.for %arg7 = %c0 to %34 step %c64 iter_args(%arg8 = %cst, %arg9 = %cst_0, %arg10 = %cst_1, %arg11 = %23, %arg12 = %30) -> (tensor<128x64xf32>, tensor<128xf32>, tensor<128xf32>, tensor<64x64x!tt.ptr<f16>>, tensor<64x64x!tt.ptr<f16>>) {
+    %44 = tt.load %arg11 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<64x64xf16>
+    %45 = tt.dot %15, %44, %cst {allowTF32 = true, transA = false, transB = false} : tensor<128x64xf16> * tensor<64x64xf16> -> tensor<128x64xf32>
+    %46 = arith.mulf %45, %33 : tensor<128x64xf32>
+    %47 = tt.reduce %46 {axis = 1 : i32, redOp = 12 : i32} : tensor<128x64xf32> -> tensor<128xf32>
+    %48 = arith.maxf %arg9, %47 : tensor<128xf32>
+    %49 = tt.expand_dims %48 {axis = 1 : i32} : (tensor<128xf32>) -> tensor<128x1xf32>
+    %50 = tt.broadcast %49 : (tensor<128x1xf32>) -> tensor<128x64xf32>
+    %51 = arith.subf %46, %50 : tensor<128x64xf32>
+    %52 = math.exp %51 : tensor<128x64xf32>
+    %53 = tt.reduce %52 {axis = 1 : i32, redOp = 2 : i32} : tensor<128x64xf32> -> tensor<128xf32>
+    %54 = arith.subf %arg9, %48 : tensor<128xf32>
+    %55 = math.exp %54 : tensor<128xf32>
+    %56 = arith.mulf %arg10, %55 : tensor<128xf32>
+    %57 = arith.addf %56, %53 : tensor<128xf32>
+    %58 = tt.expand_dims %55 {axis = 1 : i32} : (tensor<128xf32>) -> tensor<128x1xf32>
+    %59 = tt.broadcast %58 : (tensor<128x1xf32>) -> tensor<128x64xf32>
+    %60 = arith.mulf %arg8, %59 : tensor<128x64xf32>
+    %61 = arith.truncf %52 : tensor<128x64xf32> to tensor<128x64xf16>
+    %62 = tt.load %arg12 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<64x64xf16>
+    %63 = tt.dot %61, %62, %60 {allowTF32 = true, transA = false, transB = false} : tensor<128x64xf16> * tensor<64x64xf16> -> tensor<128x64xf32>
+    %64 = tt.addptr %arg11, %32 : tensor<64x64x!tt.ptr<f16>>, tensor<64x64xi32>
+    %65 = tt.addptr %arg12, %32 : tensor<64x64x!tt.ptr<f16>>, tensor<64x64xi32>
+    scf.yield %63, %48, %57, %64, %65 : tensor<128x64xf32>, tensor<128xf32>, tensor<128xf32>, tensor<64x64x!tt.ptr<f16>>, tensor<64x64x!tt.ptr<f16>>
+  }
+  %36 = tt.expand_dims %35#2 {axis = 1 : i32} : (tensor<128xf32>) -> tensor<128x1xf32>
+  %37 = tt.broadcast %36 : (tensor<128x1xf32>) -> tensor<128x64xf32>
+  %38 = arith.divf %35#0, %37 : tensor<128x64xf32>
+  %39 = arith.truncf %38 : tensor<128x64xf32> to tensor<128x64xf16>
+  %40 = tt.splat %arg3 : (!tt.ptr<f16>) -> tensor<128x64x!tt.ptr<f16>>
+  %41 = tt.addptr %40, %12 : tensor<128x64x!tt.ptr<f16>>, tensor<128x64xi32>
+  tt.store %41, %39 : tensor<128x64xf16>
+  return
+}
+}
@@ -0,0 +1,73 @@
+// Block-sparse times dense matmul of 32x32 fp16 blocks: each program reads
+// the (block, row) pairs of its output row of blocks from a look-up table
+module {
+func @blocksparse_dsd(%arg0: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg1: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg2: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %arg3: !tt.ptr<i32> {tt.divisibility = 16 : i32}, %arg4: i32 {tt.divisibility = 16 : i32}, %arg5: i32 {tt.divisibility = 16 : i32}) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c1_i32 = arith.constant 1 : i32
+  %c2_i32 = arith.constant 2 : i32
+  %c32_i32 = arith.constant 32 : i32
+  %c1024_i32 = arith.constant 1024 : i32
+  %cst = arith.constant dense<0.000000e+00> : tensor<32x64xf32>
+  %0 = tt.get_program_id {axis = 0 : i32} : i32
+  %1 = tt.get_program_id {axis = 1 : i32} : i32
+  %2 = arith.muli %0, %c2_i32 : i32
+  %3 = tt.addptr %arg3, %2 : !tt.ptr<i32>, i32
+  %4 = tt.load %3 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : i32
+  %5 = tt.addptr %3, %c1_i32 : !tt.ptr<i32>, i32
+  %6 = tt.load %5 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : i32
+  %7 = tt.addptr %arg3, %4 : !tt.ptr<i32>, i32
+  %8 = tt.make_range {end = 32 : i32, start = 0 : i32} : tensor<32xi32>
+  %9 = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32>
+  %10 = arith.muli %1, %c32_i32 : i32
+  %11 = arith.muli %10, %c2_i32 : i32
+  %12 = tt.splat %11 : (i32) -> tensor<64xi32>
+  %13 = arith.addi %12, %9 : tensor<64xi32>
+  %14 = tt.expand_dims %8 {axis = 1 : i32} : (tensor<32xi32>) -> tensor<32x1xi32>
+  %15 = tt.splat %c32_i32 : (i32) -> tensor<32x1xi32>
+  %16 = arith.muli %14, %15 : tensor<32x1xi32>
+  %17 = tt.expand_dims %8 {axis = 0 : i32} : (tensor<32xi32>) -> tensor<1x32xi32>
+  %18 = tt.broadcast %16 : (tensor<32x1xi32>) -> tensor<32x32xi32>
+  %19 = tt.broadcast %17 : (tensor<1x32xi32>) -> tensor<32x32xi32>
+  %20 = arith.addi %18, %19 : tensor<32x32xi32>
+  %21 = tt.splat %arg4 : (i32) -> tensor<32x1xi32>
+  %22 = arith.muli %14, %21 : tensor<32x1xi32>
+  %23 = tt.expand_dims %13 {axis = 0 : i32} : (tensor<64xi32>) -> tensor<1x64xi32>
+  %24 = tt.broadcast %22 : (tensor<32x1xi32>) -> tensor<32x64xi32>
+  %25 = tt.broadcast %23 : (tensor<1x64xi32>) -> tensor<32x64xi32>
+  %26 = arith.addi %24, %25 : tensor<32x64xi32>
+  %27 = arith.index_cast %6 : i32 to index
+  %28:2 = scf.for %arg6 = %c0 to %27 step %c1 iter_args(%arg7 = %cst, %arg8 = %7) -> (tensor<32x64xf32>, !tt.ptr<i32>) {
+    %40 = tt.load %arg8 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : i32
+    %41 = tt.addptr %arg8, %c1_i32 : !tt.ptr<i32>, i32
+    %42 = tt.load %41 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : i32
+    %43 = arith.muli %40, %c1024_i32 : i32
+    %44 = tt.addptr %arg0, %43 : !tt.ptr<f16>, i32
+    %45 = tt.splat %44 : (!tt.ptr<f16>) -> tensor<32x32x!tt.ptr<f16>>
+    %46 = tt.addptr %45, %20 : tensor<32x32x!tt.ptr<f16>>, tensor<32x32xi32>
+    %47 = tt.load %46 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x32xf16>
+    %48 = arith.muli %42, %c32_i32 : i32
+    %49 = arith.muli %48, %arg4 : i32
+    %50 = tt.addptr %arg1, %49 : !tt.ptr<f16>, i32
+    %51 = tt.splat %50 : (!tt.ptr<f16>) -> tensor<32x64x!tt.ptr<f16>>
+    %52 = tt.addptr %51, %26 : tensor<32x64x!tt.ptr<f16>>, tensor<32x64xi32>
+    %53 = tt.load %52 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x64xf16>
+    %54 = tt.dot %47, %53, %arg7 {allowTF32 = true, transA = false, transB = false} : tensor<32x32xf16> * tensor<32x64xf16> -> tensor<32x64xf32>
+    %55 = tt.addptr %arg8, %c2_i32 : !tt.ptr<i32>, i32
+    scf.yield %54, %55 : tensor<32x64xf32>, !tt.ptr<i32>
+  }
+  %29 = arith.muli %0, %c32_i32 : i32
+  %30 = tt.splat %29 : (i32) -> tensor<32xi32>
+  %31 = arith.addi %30, %8 : tensor<32xi32>
+  %32 = tt.expand_dims %31 {axis = 1 : i32} : (tensor<32xi32>) -> tensor<32x1xi32>
+  %33 = tt.splat %arg5 : (i32) -> tensor<32x1xi32>
+  %34 = arith.muli %32, %33 : tensor<32x1xi32>
+  %35 = tt.broadcast %34 : (tensor<32x1xi32>) -> tensor<32x64xi32>
+  %36 = arith.addi %35, %25 : tensor<32x64xi32>
+  %37 = arith.truncf %28#0 : tensor<32x64xf32> to tensor<32x64xf16>
+  %38 = tt.splat %arg2 : (!tt.ptr<f16>) -> tensor<32x64x!tt.ptr<f16>>
+  %39 = tt.addptr %38, %36 : tensor<32x64x!tt.ptr<f16>>, tensor<32x64xi32>
+  tt.store %39, %37 : tensor<32x64xf16>
+  return
+}
+}
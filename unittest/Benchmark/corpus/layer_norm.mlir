@@ -0,0 +1,47 @@
+// Layer-norm forward of rows of up to 1024 fp32 elements, one row per program
+module {
+func @layer_norm_fwd(%arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg1: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg2: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg3: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg4: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg5: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg6: i32 {tt.divisibility = 16 : i32}, %arg7: i32, %arg8: f32) {
+  %cst = arith.constant dense<0.000000e+00> : tensor<1024xf32>
+  %cst_0 = arith.constant 1.000000e+00 : f32
+  %0 = tt.get_program_id {axis = 0 : i32} : i32
+  %1 = arith.muli %0, %arg6 : i32
+  %2 = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32>
+  %3 = tt.splat %arg7 : (i32) -> tensor<1024xi32>
+  %4 = arith.cmpi slt, %2, %3 : tensor<1024xi32>
+  %5 = tt.addptr %arg0, %1 : !tt.ptr<f32>, i32
+  %6 = tt.splat %5 : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>>
+  %7 = tt.addptr %6, %2 : tensor<1024x!tt.ptr<f32>>, tensor<1024xi32>
+  %8 = tt.load %7, %4, %cst {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32>
+  %9 = tt.reduce %8 {axis = 0 : i32, redOp = 2 : i32} : tensor<1024xf32> -> f32
+  %10 = arith.sitofp %arg7 : i32 to f32
+  %11 = arith.divf %9, %10 : f32
+  %12 = tt.splat %11 : (f32) -> tensor<1024xf32>
+  %13 = arith.subf %8, %12 : tensor<1024xf32>
+  %14 = select %4, %13, %cst : tensor<1024xi1>, tensor<1024xf32>
+  %15 = arith.mulf %14, %14 : tensor<1024xf32>
+  %16 = tt.reduce %15 {axis = 0 : i32, redOp = 2 : i32} : tensor<1024xf32> -> f32
+  %17 = arith.divf %16, %10 : f32
+  %18 = arith.addf %17, %arg8 : f32
+  %19 = math.sqrt %18 : f32
+  %20 = arith.divf %cst_0, %19 : f32
+  %21 = tt.splat %arg2 : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>>
+  %22 = tt.addptr %21, %2 : tensor<1024x!tt.ptr<f32>>, tensor<1024xi32>
+  %23 = tt.load %22, %4, %cst {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32>
+  %24 = tt.splat %arg3 : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>>
+  %25 = tt.addptr %24, %2 : tensor<1024x!tt.ptr<f32>>, tensor<1024xi32>
+  %26 = tt.load %25, %4, %cst {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32>
+  %27 = tt.splat %20 : (f32) -> tensor<1024xf32>
+  %28 = arith.mulf %14, %27 : tensor<1024xf32>
+  %29 = arith.mulf %28, %23 : tensor<1024xf32>
+  %30 = arith.addf %29, %26 : tensor<1024xf32>
+  %31 = tt.addptr %arg1, %1 : !tt.ptr<f32>, i32
+  %32 = tt.splat %31 : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>>
+  %33 = tt.addptr %32, %2 : tensor<1024x!tt.ptr<f32>>, tensor<1024xi32>
+  tt.store %33, %30, %4 : tensor<1024xf32>
+  %34 = tt.addptr %arg4, %0 : !tt.ptr<f32>, i32
+  tt.store %34, %11 : f32
+  %35 = tt.addptr %arg5, %0 : !tt.ptr<f32>, i32
+  tt.store %35, %20 : f32
+  return
+}
+}